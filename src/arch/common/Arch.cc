@@ -17,6 +17,9 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <limits>
+
 #include <lib/cpp/Misc.h>
 #include <lib/cpp/Terminal.h>
 
@@ -182,6 +185,79 @@ void ArchPool::Run(int &num_active_emulators, int &num_active_timing_simulators)
 }
 
 
+long long ArchPool::SkipIdleCycles()
+{
+	// Current time and duration of an iteration of the main loop
+	esim::Engine *esim_engine = esim::Engine::getInstance();
+	long long cycle_time = esim_engine->getCycleTime();
+	long long time = esim_engine->getTime();
+
+	// Events are processed in the first iteration with a time equal or
+	// greater than the event time, so that is the first iteration that
+	// cannot be skipped.
+	long long target = std::numeric_limits<long long>::max();
+	long long next_event_time = esim_engine->getNextEventTime();
+	if (next_event_time >= 0)
+		target = (next_event_time + cycle_time - 1) / cycle_time
+				* cycle_time;
+
+	// All active timing simulators must be quiescent. The first cycle
+	// when each of them must run again also bounds the skipped time.
+	for (auto &arch : arch_list)
+	{
+		// Only active timing simulators run in upcoming iterations
+		if (arch->getSimKind() != Arch::SimDetailed || !arch->isActive())
+			continue;
+
+		// Check quiescence
+		Timing *timing = arch->getTiming();
+		long long until = timing->getQuiescentUntil();
+		if (!until)
+			return 0;
+		if (until == std::numeric_limits<long long>::max())
+			continue;
+
+		// First iteration falling in cycle 'until' of the timing
+		// simulator's frequency domain
+		long long until_time = (until - 1) *
+				timing->getFrequencyDomain()->getCycleTime();
+		until_time = (until_time + cycle_time - 1) / cycle_time
+				* cycle_time;
+		target = std::min(target, until_time);
+	}
+
+	// Nothing to skip. If there is no pending event nor a deadline,
+	// simulation is stuck, which is left to the regular loop to detect.
+	if (target <= time || target == std::numeric_limits<long long>::max())
+		return 0;
+
+	// Skip cycles in all active timing simulators. An architecture would
+	// have run once for each of its cycles started in the skipped
+	// iterations.
+	for (auto &arch : arch_list)
+	{
+		// Only active timing simulators
+		if (arch->getSimKind() != Arch::SimDetailed || !arch->isActive())
+			continue;
+
+		// Number of skipped cycles
+		Timing *timing = arch->getTiming();
+		long long last_cycle = (target - cycle_time) /
+				timing->getFrequencyDomain()->getCycleTime() + 1;
+		long long num_cycles = last_cycle -
+				timing->getLastSimulationCycle();
+		if (num_cycles > 0)
+		{
+			timing->SkipCycles(num_cycles);
+			timing->setLastSimulationCycle(last_cycle);
+		}
+	}
+
+	// Advance simulation time
+	esim_engine->SkipTime(target);
+	return (target - time) / cycle_time;
+}
+
 void ArchPool::DumpSummary(std::ostream &os) const
 {
 	// Print in blue
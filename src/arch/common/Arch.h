@@ -222,6 +222,15 @@ public:
 	///	decide whether the main simulation loop should stop.
 	void Run(int &num_emu_active, int &num_timing_active);
 
+	/// Fast-forward the event-driven simulation when all active timing
+	/// simulators are quiescent, skipping the cycles until the next
+	/// pending event or until some timing simulator must run again. This
+	/// function should be invoked by the main simulation loop after
+	/// processing events, and only when no architecture is running an
+	/// emulation. The function returns the number of skipped cycles of
+	/// the fastest frequency domain.
+	long long SkipIdleCycles();
+
 	/// Dump a summary for all architectures in the pool.
 	void DumpSummary(std::ostream &os = std::cerr) const;
 
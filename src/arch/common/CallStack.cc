@@ -28,6 +28,8 @@ namespace comm
 
 misc::Debug CallStack::debug;
 
+std::atomic<long long> CallStack::version_counter(0);
+
 
 ELFReader::File *CallStack::getELFFile(const std::string &path)
 {
@@ -60,37 +62,62 @@ ELFReader::File *CallStack::getELFFile(const std::string &path)
 }
 
 
-std::string CallStack::getSymbolName(unsigned address)
+CallStackMap *CallStack::getMap(unsigned address)
 {
-	// Identify map
-	CallStackMap *map = nullptr;
+	// Most recent maps first
 	for (auto it = maps.rbegin(); it != maps.rend(); ++it)
-	{
 		if (address >= it->getAddress() &&
 				address < it->getAddress()
 				+ it->getSize())
+			return &(*it);
+	return nullptr;
+}
+
+
+ELFReader::Symbol *CallStack::getELFSymbol(CallStackMap *map,
+		unsigned address, unsigned &offset)
+{
+	// Get ELF file
+	ELFReader::File *elf_file = getELFFile(map->getPath());
+	if (!elf_file)
+		return nullptr;
+
+	// Position of the address in the file, translated into the virtual
+	// address given by the loadable segment containing it, which is the
+	// one that symbols refer to.
+	unsigned elf_address = address - map->getAddress() + map->getOffset();
+	for (auto &program_header : elf_file->getProgramHeaders())
+	{
+		if (program_header->getType() == PT_LOAD &&
+				elf_address >= program_header->getOffset() &&
+				elf_address < program_header->getOffset() +
+				program_header->getFilesz())
 		{
-			map = &(*it);
+			elf_address += program_header->getVaddr() -
+					program_header->getOffset();
 			break;
 		}
 	}
 
+	// Get symbol
+	return elf_file->getSymbolByAddress(elf_address, offset);
+}
+
+
+std::string CallStack::getSymbolName(unsigned address)
+{
+	// Identify map
+	CallStackMap *map = getMap(address);
+
 	// No map found
 	std::string address_str = misc::fmt("<0x%x>", address);
 	if (!map)
 		return address_str;
 
-	// Get ELF file
-	ELFReader::File *elf_file = getELFFile(map->getPath());
-	address_str = misc::fmt("<0x%x> @%s", address, map->getPath().c_str());
-	if (!elf_file)
-		return address_str;
-
 	// Get symbol
 	unsigned offset;
-	ELFReader::Symbol *elf_symbol = elf_file->getSymbolByAddress(
-			address - map->getAddress() + map->getOffset(),
-			offset);
+	ELFReader::Symbol *elf_symbol = getELFSymbol(map, address, offset);
+	address_str = misc::fmt("<0x%x> @%s", address, map->getPath().c_str());
 	if (!elf_symbol)
 		return address_str;
 
@@ -142,6 +169,7 @@ CallStack::CallStack(const std::string &path, size_t max_size)
 
 	// Initialize fields
 	level = 0;
+	version = ++version_counter;
 
 	// Debug
 	debug << misc::fmt("[%s] Call stack object created\n", path.c_str());
@@ -182,6 +210,7 @@ void CallStack::Call(unsigned ip, unsigned sp)
 	
 	// Increase call level
 	level++;
+	version = ++version_counter;
 	
 	// Debug
 	if (debug)
@@ -198,6 +227,7 @@ void CallStack::Return(unsigned ip, unsigned sp)
 	// Decrease call level
 	if (level > 0)
 		level--;
+	version = ++version_counter;
 	
 	// Debug
 	if (debug)
@@ -205,6 +235,21 @@ void CallStack::Return(unsigned ip, unsigned sp)
 }
 
 
+bool CallStack::getSymbol(unsigned address, std::string &name,
+		unsigned &offset)
+{
+	// Get map and symbol
+	CallStackMap *map = getMap(address);
+	if (!map)
+		return false;
+	ELFReader::Symbol *elf_symbol = getELFSymbol(map, address, offset);
+	if (!elf_symbol)
+		return false;
+	name = elf_symbol->getName();
+	return true;
+}
+
+
 void CallStack::BackTrace(unsigned address, std::ostream &os)
 {
 	// Header
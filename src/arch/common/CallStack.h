@@ -20,6 +20,7 @@
 #ifndef ARCH_COMMON_CALL_STACK_H
 #define ARCH_COMMON_CALL_STACK_H
 
+#include <atomic>
 #include <deque>
 #include <list>
 #include <memory>
@@ -112,6 +113,14 @@ class CallStack
 	// Debugger
 	static misc::Debug debug;
 
+	// Counter used to assign versions to call stacks. It is atomic since
+	// contexts can be emulated by several host threads.
+	static std::atomic<long long> version_counter;
+
+	// Version of the content of the call stack, changed every time a
+	// function is called or returns
+	long long version;
+
 	// Path of main executable
 	std::string path;
 
@@ -136,6 +145,15 @@ class CallStack
 	// Parse ELF file and return it, or return a previously parsed one.
 	ELFReader::File *getELFFile(const std::string &path);
 
+	// Return the map containing a virtual address, or null if none
+	CallStackMap *getMap(unsigned address);
+
+	// Return the ELF symbol containing a virtual address within a map,
+	// or null if none. The offset of the address within the symbol is
+	// returned in \a offset.
+	ELFReader::Symbol *getELFSymbol(CallStackMap *map, unsigned address,
+			unsigned &offset);
+
 	// Return a symbol name for a virtual address.
 	std::string getSymbolName(unsigned address);
 
@@ -183,6 +201,23 @@ public:
 
 	/// Record a function return
 	void Return(unsigned ip, unsigned sp);
+
+	/// Return the frames of the stack, starting at the outermost call.
+	/// The instruction pointer of each frame is the address of the
+	/// function that was called.
+	const std::deque<CallStackFrame> &getFrames() const { return stack; }
+
+	/// Return a version number that changes every time the frames of
+	/// the stack change. Versions are unique across all call stacks, so
+	/// they can be used to detect that a cached view of the stack is
+	/// still valid.
+	long long getVersion() const { return version; }
+
+	/// Find the ELF symbol containing virtual address \a address. If
+	/// found, the function returns true, and the symbol name and the
+	/// offset of the address within the symbol are returned in \a name
+	/// and \a offset.
+	bool getSymbol(unsigned address, std::string &name, unsigned &offset);
 	
 	/// Dump stack back trace
 	///
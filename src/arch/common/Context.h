@@ -47,6 +47,13 @@ class Context
 	// Associated emulator, initialized in constructor
 	Emulator *emulator;
 
+protected:
+
+	/// Change the identifier of the context, used when the context is
+	/// restored from a checkpoint. Contexts created later will receive
+	/// higher identifiers.
+	void setId(int id);
+
 public:
 
 	/// Constructor
@@ -18,6 +18,7 @@
  */
 
 #include <cctype>
+#include <cstring>
 
 #include <lib/cpp/Misc.h>
 #include <lib/cpp/String.h>
@@ -56,5 +57,23 @@ bool Disassembler::isToken(const std::string &fmt, const std::string &token,
 }
 
 
+bool Disassembler::isToken(const char *fmt, const char *token, int &length)
+{
+	// Token is not prefix
+	length = 0;
+	int token_length = strlen(token);
+	if (strncmp(fmt, token, token_length))
+		return false;
+
+	// Token is not end of word
+	if (isalnum(fmt[token_length]))
+		return false;
+
+	// Token found
+	length = token_length;
+	return true;
+}
+
+
 }  // namespace comm
 
@@ -58,6 +58,20 @@ public:
 		return isToken(fmt, token, length);
 	}
 
+	/// Version of function isToken() for C strings, used by the
+	/// disassemblers when dumping instructions. It avoids creating string
+	/// objects for every token checked, which is costly when instructions
+	/// are dumped frequently, such as in pipeline traces.
+	static bool isToken(const char *fmt, const char *token, int &length);
+
+	/// Version of function isToken() for C strings where the length of the
+	/// obtained token is not returned.
+	static bool isToken(const char *fmt, const char *token)
+	{
+		int length;
+		return isToken(fmt, token, length);
+	}
+
 };
 
 
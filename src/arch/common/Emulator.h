@@ -71,7 +71,10 @@ public:
 	mem::Mmu *getMmu() { return &mmu; }
 
 	/// Increment the number of emulated instructions
-	void incNumInstructions() { ++num_instructions; }
+	void incNumInstructions(long long count = 1)
+	{
+		num_instructions += count;
+	}
 
 	/// Return the number of emulated instructions
 	long long getNumInstructions() const { return num_instructions; }
@@ -17,8 +17,13 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */ 
  
+#include <algorithm>
+#include <fcntl.h>
+#include <map>
 #include <unistd.h>
 
+#include <lib/cpp/Checkpoint.h>
+
 #include "FileTable.h"
 
 namespace comm
@@ -174,5 +179,92 @@ void FileTable::freeFileDescriptor(int index)
 }
 
 
+void FileTable::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	// Check that all file descriptors can be restored
+	for (auto &desc : descriptors)
+		if (desc.get() && desc->getType() != FileDescriptor::TypeRegular
+				&& desc->getType() != FileDescriptor::TypeStandard)
+			throw misc::Error(misc::fmt("Guest file descriptor %d "
+					"of type '%s' cannot be saved in a "
+					"checkpoint",
+					desc->getGuestIndex(),
+					FileDescriptor::TypeTypeMap[
+					desc->getType()]));
+
+	// Save file descriptors
+	writer.WriteSection("FileTable");
+	writer.WriteValue<unsigned>(descriptors.size());
+	for (auto &desc : descriptors)
+	{
+		writer.WriteValue<bool>(desc.get());
+		if (!desc.get())
+			continue;
+
+		// Offset in the host file. Standard input and output that
+		// were not redirected keep no offset.
+		long long offset = 0;
+		if (!desc->getPath().empty())
+			offset = lseek(desc->getHostIndex(), 0, SEEK_CUR);
+		writer.WriteValue<int>(desc->getType());
+		writer.WriteValue(desc->getHostIndex());
+		writer.WriteValue(desc->getFlags());
+		writer.WriteString(desc->getPath());
+		writer.WriteValue(std::max(offset, 0LL));
+	}
+}
+
+
+void FileTable::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	// Host file descriptors opened so far, indexed by the host file
+	// descriptor they replace. Guest descriptors that shared a host file
+	// keep sharing it.
+	std::map<int, int> host_indices;
+
+	// Load file descriptors
+	descriptors.clear();
+	reader.ReadSection("FileTable");
+	unsigned num_descriptors = reader.ReadValue<unsigned>();
+	for (unsigned index = 0; index < num_descriptors; index++)
+	{
+		// Empty entry
+		descriptors.emplace_back(nullptr);
+		if (!reader.ReadValue<bool>())
+			continue;
+
+		// Read file descriptor
+		auto type = (FileDescriptor::Type) reader.ReadValue<int>();
+		int host_index = reader.ReadValue<int>();
+		int flags = reader.ReadValue<int>();
+		std::string path = reader.ReadString();
+		long long offset = reader.ReadValue<long long>();
+
+		// Reopen host file
+		auto it = host_indices.find(host_index);
+		if (it != host_indices.end())
+		{
+			host_index = it->second;
+		}
+		else if (!path.empty())
+		{
+			int new_host_index = open(path.c_str(),
+					flags & ~(O_CREAT | O_EXCL | O_TRUNC));
+			if (new_host_index < 0)
+				throw misc::Error(misc::fmt("%s: cannot reopen "
+						"file from checkpoint",
+						path.c_str()));
+			lseek(new_host_index, offset, SEEK_SET);
+			host_indices[host_index] = new_host_index;
+			host_index = new_host_index;
+		}
+
+		// Create file descriptor
+		descriptors[index].reset(new FileDescriptor(type, index,
+				host_index, flags, path));
+	}
+}
+
+
 }  // namespace comm
 
@@ -28,6 +28,14 @@
 #include <lib/cpp/String.h>
 
 
+// Forward declarations
+namespace misc
+{
+class CheckpointReader;
+class CheckpointWriter;
+}
+
+
 namespace comm
 {
 
@@ -200,6 +208,21 @@ public:
 	/// Return the guest file descriptor associated with a host file
 	/// descriptor given in \a host_index, or -1 if invalid.
 	int getGuestIndex(int host_index) const;
+
+	/// Save the file descriptors into a checkpoint, together with the
+	/// current offset of their host files.
+	///
+	/// \throw
+	///	A misc::Error is thrown if a file descriptor is a pipe, socket,
+	///	device, or virtual file, whose state cannot be restored.
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Replace the file descriptors with those saved in a checkpoint,
+	/// reopening their host files at the saved offsets.
+	///
+	/// \throw
+	///	A misc::Error is thrown if a host file cannot be reopened.
+	void LoadCheckpoint(misc::CheckpointReader &reader);
 };
 
 
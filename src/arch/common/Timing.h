@@ -49,9 +49,18 @@ class Timing
 	// variable is used by ArchPool::Run() to determine whether the current
 	// cycle should run or skip an iteration of this architecture.
 	long long last_simulation_cycle = 0;
+
+	// Number of cycles skipped while the timing simulator was quiescent
+	long long num_skipped_cycles = 0;
 	
 public:
 
+	/// Maximum number of cycles that a timing simulator can go through
+	/// without making progress while it still has work to do. Simulation
+	/// is stopped with a stall error past this limit, and
+	/// getQuiescentUntil() must not report quiescence beyond it.
+	static const long long MaxStallCycles = 1000000;
+
 	/// Constructor
 	Timing(const std::string &name);
 
@@ -60,6 +69,31 @@ public:
 	/// function must be implemented by every derived class.
 	virtual bool Run() = 0;
 
+	/// Return whether the timing simulator is quiescent, meaning that
+	/// running it in upcoming cycles would have no effect other than
+	/// the one modeled by SkipCycles(), as long as no event is triggered
+	/// in the event-driven simulator. If it is, the function returns the
+	/// first cycle in the frequency domain of the timing simulator when
+	/// it must run again regardless of events (for example, when a
+	/// pipeline latency expires), or the maximum value for a \c long
+	/// \c long if there is no such cycle. If the timing simulator is not
+	/// quiescent, the function returns 0, which is also the default
+	/// behavior for architectures that do not support idle-cycle
+	/// fast-forwarding.
+	virtual long long getQuiescentUntil() { return 0; }
+
+	/// Account for \a num_cycles cycles in which the timing simulator was
+	/// not run because it was quiescent, as reported by a previous call
+	/// to getQuiescentUntil(). Derived classes overriding this function
+	/// should update per-cycle statistics, and invoke the base class.
+	virtual void SkipCycles(long long num_cycles)
+	{
+		num_skipped_cycles += num_cycles;
+	}
+
+	/// Return the number of cycles skipped with calls to SkipCycles()
+	long long getNumSkippedCycles() const { return num_skipped_cycles; }
+
 	/// Configure the frequency domain with the given frequency. After this
 	/// call, the frequency domain can be retrieved with a call to
 	/// getFrequencyDomain().
@@ -123,6 +157,13 @@ public:
 	{
 		last_simulation_cycle = frequency_domain->getCycle();
 	}
+
+	/// Set the last simulation cycle explicitly. This is used when cycles
+	/// are skipped with SkipCycles() instead of running an iteration.
+	void setLastSimulationCycle(long long cycle)
+	{
+		last_simulation_cycle = cycle;
+	}
 };
 
 }
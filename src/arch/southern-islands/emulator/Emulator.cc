@@ -21,6 +21,7 @@
 #include <arch/southern-islands/emulator/WorkGroup.h>
 #include <arch/southern-islands/emulator/Wavefront.h>
 #include <arch/southern-islands/emulator/WorkItem.h>
+#include <lib/cpp/Checkpoint.h>
 #include <lib/cpp/CommandLine.h>
 #include <lib/cpp/ELFReader.h>
 #include <lib/cpp/Misc.h>
@@ -88,6 +89,27 @@ void Emulator::DumpSummary(std::ostream &os) const
 }
 
 
+void Emulator::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	if (ndranges_running)
+		throw Error("Cannot save a checkpoint while an ND-range is "
+				"running");
+	writer.WriteSection("SI::Emulator");
+	writer.WriteValue(video_memory_top);
+	video_memory->SaveCheckpoint(writer);
+	shared_memory->SaveCheckpoint(writer);
+}
+
+
+void Emulator::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	reader.ReadSection("SI::Emulator");
+	reader.ReadValue(video_memory_top);
+	video_memory->LoadCheckpoint(reader);
+	shared_memory->LoadCheckpoint(reader);
+}
+
+
 bool Emulator::Run()
 {
 	// For efficiency when no Southern Islands emulation is selected, 
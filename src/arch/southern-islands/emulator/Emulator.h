@@ -339,6 +339,15 @@ public:
 	/// Increase video memory top
 	void incVideoMemoryTop(unsigned inc) { video_memory_top += inc; }
 
+	/// Save the video memory and the memory shared with the CPU into a
+	/// checkpoint. The state of ND-ranges is not saved, so checkpoints
+	/// must be taken while no ND-range is running.
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Load the video memory and the memory shared with the CPU from a
+	/// checkpoint created with SaveCheckpoint().
+	void LoadCheckpoint(misc::CheckpointReader &reader);
+
 	};
 
 
@@ -49,6 +49,14 @@ void BranchUnit::Run()
 }
 
 
+bool BranchUnit::isQuiescent() const
+{
+	return issue_buffer.empty() && decode_buffer.empty() &&
+			read_buffer.empty() && exec_buffer.empty() &&
+			write_buffer.empty();
+}
+
+
 bool BranchUnit::isValidUop(Uop *uop) const
 {
 	// Get instruction
@@ -703,6 +703,76 @@ void ComputeUnit::Run()
 }
 
 
+bool ComputeUnit::isQuiescent()
+{
+	// Compute units without work groups do nothing
+	if (!work_groups.size())
+		return true;
+
+	// Issue stage
+	for (auto &fetch_buffer : fetch_buffers)
+		if (fetch_buffer->getSize())
+			return false;
+
+	// Execution units
+	for (auto &simd_unit : simd_units)
+		if (!simd_unit->isQuiescent())
+			return false;
+	if (!vector_memory_unit.isQuiescent() ||
+			!lds_unit.isQuiescent() ||
+			!scalar_unit.isQuiescent() ||
+			!branch_unit.isQuiescent())
+		return false;
+
+	// Fetch stage. See Fetch() for the conditions under which a wavefront
+	// pool entry is left untouched.
+	for (auto &wavefront_pool : wavefront_pools)
+	{
+		for (auto it = wavefront_pool->begin(),
+				e = wavefront_pool->end();
+				it != e;
+				++it)
+		{
+			// Skip entries without wavefront
+			WavefrontPoolEntry *wavefront_pool_entry = it->get();
+			Wavefront *wavefront = wavefront_pool_entry->getWavefront();
+			if (!wavefront)
+				continue;
+
+			// Entry becomes ready in the next cycle
+			if (wavefront_pool_entry->ready_next_cycle)
+				return false;
+
+			// Waiting for previous instruction or finished
+			if (!wavefront_pool_entry->ready ||
+					wavefront_pool_entry->wavefront_finished ||
+					wavefront->getFinished())
+				continue;
+
+			// Waiting for outstanding memory accesses
+			if (wavefront_pool_entry->mem_wait)
+			{
+				if (!wavefront_pool_entry->lgkm_cnt &&
+						!wavefront_pool_entry->exp_cnt &&
+						!wavefront_pool_entry->vm_cnt)
+					return false;
+				continue;
+			}
+
+			// Waiting at barrier
+			if (wavefront_pool_entry->wait_for_barrier)
+				continue;
+
+			// Wavefront can fetch
+			return false;
+		}
+	}
+
+	// Quiescent
+	return true;
+}
+
+
 void ComputeUnit::Dump(std::ostream &os) const
 {
 	// Title
@@ -164,6 +164,12 @@ public:
 	/// Advance compute unit state by one cycle
 	void Run();
 
+	/// Return whether advancing the compute unit state by one cycle would
+	/// have no effect, as long as no memory access in flight completes.
+	/// This is the case when all wavefronts are waiting for memory or
+	/// at a barrier, and all execution unit pipelines are drained.
+	bool isQuiescent();
+
 	/// Return the index of this compute unit in the GPU
 	int getIndex() const { return index; }
 
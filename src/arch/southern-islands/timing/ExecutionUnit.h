@@ -59,6 +59,12 @@ public:
 	/// function that every execution unit must implement.
 	virtual void Run() = 0;
 
+	/// Return whether running the execution unit in the current cycle
+	/// would have no effect, as long as no memory access in flight
+	/// completes. This is a pure virtual function that every execution
+	/// unit must implement.
+	virtual bool isQuiescent() const = 0;
+
 	/// Return whether the given uop is accepted by the execution unit,
 	/// based on the type of instruction that it contains. This is a pure
 	/// virtual function that every execution unit must implement.
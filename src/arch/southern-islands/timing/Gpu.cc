@@ -218,5 +218,15 @@ void Gpu::Run()
 		compute_unit->Run();
 }
 
+
+bool Gpu::isQuiescent()
+{
+	// All compute units must be quiescent
+	for (auto &compute_unit : compute_units)
+		if (!compute_unit->isQuiescent())
+			return false;
+	return true;
+}
+
 }
 
@@ -190,6 +190,10 @@ public:
 
 	/// Advance one cycle in the GPU state
 	void Run();
+
+	/// Return whether advancing one cycle in the GPU state would have no
+	/// effect, as long as no memory access in flight completes.
+	bool isQuiescent();
 	
 	/// Add a compute unit to the list of available compute units
 	ComputeUnit *AddComputeUnit(ComputeUnit *compute_unit);
@@ -50,6 +50,18 @@ void LdsUnit::Run()
 }
 
 
+bool LdsUnit::isQuiescent() const
+{
+	// Only accesses waiting for the local memory can be in flight
+	if (mem_buffer.size() && !mem_buffer.front()->lds_witness)
+		return false;
+
+	// All other buffers empty
+	return issue_buffer.empty() && decode_buffer.empty() &&
+			read_buffer.empty() && write_buffer.empty();
+}
+
+
 bool LdsUnit::isValidUop(Uop *uop) const
 {
 	// Get instruction
@@ -92,6 +92,10 @@ public:
 	/// Run the actions occurring in one cycle
 	void Run();
 
+	/// Return whether running the unit in the current cycle would have
+	/// no effect as long as no memory access completes
+	bool isQuiescent() const override;
+
 	/// Return whether there is room in the issue buffer of the LDS
 	/// unit to absorb a new instruction.
 	bool canIssue() const override
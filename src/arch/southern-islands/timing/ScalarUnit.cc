@@ -55,6 +55,20 @@ void ScalarUnit::Run()
 }
 
 
+bool ScalarUnit::isQuiescent() const
+{
+	// Only scalar memory reads waiting for their access can be in flight
+	if (exec_buffer.size() && (!exec_buffer.front()->scalar_memory_read ||
+			!exec_buffer.front()->global_memory_witness))
+		return false;
+
+	// All other buffers empty
+	return issue_buffer.empty() && decode_buffer.empty() &&
+			read_buffer.empty() && write_buffer.empty() &&
+			inflight_buffer.empty();
+}
+
+
 bool ScalarUnit::isValidUop(Uop *uop) const
 {
 	Instruction *instruction = uop->getInstruction();
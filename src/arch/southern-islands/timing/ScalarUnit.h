@@ -98,6 +98,10 @@ public:
 
 	/// Run the actions occurring in one cycle
 	void Run();
+
+	/// Return whether running the unit in the current cycle would have
+	/// no effect as long as no memory access completes
+	bool isQuiescent() const override;
 	
 	/// Return whether there is room in the issue buffer of the scalar
 	/// unit to absorb a new instruction.
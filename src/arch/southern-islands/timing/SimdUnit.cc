@@ -46,6 +46,13 @@ void SimdUnit::Run()
 	SimdUnit::Decode();
 }
 
+
+bool SimdUnit::isQuiescent() const
+{
+	return issue_buffer.empty() && decode_buffer.empty() &&
+			exec_buffer.empty();
+}
+
 bool SimdUnit::isValidUop(Uop *uop) const
 {
 	// Get instruction
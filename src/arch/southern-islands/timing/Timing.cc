@@ -17,6 +17,8 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+
 #include <arch/common/Arch.h>
 #include <lib/cpp/CommandLine.h>
 #include <memory/System.h>
@@ -1051,6 +1053,7 @@ void Timing::DumpReport() const
 	report << misc::fmt("VectorMemInstructions = %lld\n",                             
 			emulator->num_vector_memory_instructions);                                  
 	report << misc::fmt("Cycles = %lld\n", getCycle());                  
+	report << misc::fmt("SkippedCycles = %lld\n", getNumSkippedCycles());
 	report << misc::fmt("InstructionsPerCycle = %.4g\n", instructions_per_cycle);             
 	report << misc::fmt("\n\n");                                                      
 
@@ -1212,7 +1215,7 @@ bool Timing::Run()
 		esim_engine->Finish("SIMaxInstructions");
 
 	// Stop if there was a simulation stall
-	if (getCycle() - gpu->last_complete_cycle > 1000000)
+	if (getCycle() - gpu->last_complete_cycle > MaxStallCycles)
 	{
 		std::cout<<"\n\n************TOO LONG******************\n\n";
 		//warning("Southern Islands GPU simulation stalled.\n%s",
@@ -1231,5 +1234,41 @@ bool Timing::Run()
 	return true;
 }
 
+
+long long Timing::getQuiescentUntil()
+{
+	// Stalls dumped cycle by cycle in trace and debug output
+	if (trace || pipeline_debug)
+		return 0;
+
+	// Nothing to do for ND-ranges. See Run() for the actions taken on
+	// them in every cycle.
+	Emulator *emulator = Emulator::getInstance();
+	for (auto it = emulator->getNDRangesBegin();
+			it != emulator->getNDRangesEnd();
+			++it)
+	{
+		NDRange *ndrange = it->get();
+		if (ndrange->address_space == nullptr)
+			return 0;
+		if (!ndrange->isWaitingWorkGroupsEmpty() &&
+				gpu->getAvailableComputeUnit())
+			return 0;
+		if (ndrange->isRunningWorkGroupsEmpty() &&
+				ndrange->LastWorkGroupSent())
+			return 0;
+	}
+
+	// Compute units
+	if (!gpu->isQuiescent())
+		return 0;
+
+	// Stall check and maximum number of cycles
+	long long until = gpu->last_complete_cycle + MaxStallCycles + 1;
+	if (Gpu::max_cycles)
+		until = std::min(until, Gpu::max_cycles);
+	return until;
+}
+
 }
 
@@ -144,6 +144,10 @@ public:
 	/// comm::Timing::Run() for details.
 	bool Run() override;
 
+	/// Return the cycle until which the GPU is quiescent, or 0 if it is
+	/// not. See comm::Timing::getQuiescentUntil() for details.
+	long long getQuiescentUntil() override;
+
 	/// Dump a default memory configuration for the architecture. See
 	/// comm::Timing::WriteMemoryConfiguration() for details.
 	void WriteMemoryConfiguration(misc::IniFile *ini_file) override;
@@ -51,6 +51,18 @@ void VectorMemoryUnit::Run()
 	Decode();
 }
 
+
+bool VectorMemoryUnit::isQuiescent() const
+{
+	// Only accesses waiting for the global memory can be in flight
+	if (mem_buffer.size() && !mem_buffer.front()->global_memory_witness)
+		return false;
+
+	// All other buffers empty
+	return issue_buffer.empty() && decode_buffer.empty() &&
+			read_buffer.empty() && write_buffer.empty();
+}
+
 bool VectorMemoryUnit::isValidUop(Uop *uop) const
 {
 	// Get instruction
@@ -0,0 +1,335 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <lib/cpp/Error.h>
+#include <lib/cpp/String.h>
+
+#include "Bbv.h"
+
+
+namespace x86
+{
+
+
+// Return the element of the random projection matrix for a block identifier
+// and a dimension, uniformly distributed in [-1, 1]. The matrix is computed
+// from a hash instead of being stored.
+static double getProjection(int block_id, int dimension)
+{
+	unsigned long long x = (unsigned long long) block_id * 31 + dimension;
+	x += 0x9e3779b97f4a7c15ull;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return (double) (x >> 11) / (double) (1ull << 52) - 1.0;
+}
+
+
+// Return the squared Euclidean distance between two points
+static double getDistance(const std::vector<double> &a,
+		const std::vector<double> &b)
+{
+	double distance = 0.0;
+	for (unsigned i = 0; i < a.size(); i++)
+		distance += (a[i] - b[i]) * (a[i] - b[i]);
+	return distance;
+}
+
+
+Bbv::Bbv(const std::string &prefix, long long interval) :
+		prefix(prefix),
+		interval(interval)
+{
+	std::string path = prefix + ".bb";
+	bb_file.open(path);
+	if (!bb_file)
+		throw misc::Error(misc::fmt("%s: cannot create basic block "
+				"vector file", path.c_str()));
+}
+
+
+Bbv::~Bbv()
+{
+	// Dump last basic block and partial interval
+	if (block_size)
+		EndBlock();
+	if (interval_size)
+		EndInterval();
+	bb_file.close();
+
+	// Simulation points
+	DumpSimulationPoints();
+}
+
+
+void Bbv::EndBlock()
+{
+	// Get block identifier, assigning a new one if needed
+	auto result = block_ids.emplace(block_address, block_ids.size() + 1);
+	int id = result.first->second;
+	if ((int) counts.size() <= id)
+		counts.resize(id + 1);
+
+	// Count instructions
+	if (!counts[id])
+		touched_blocks.push_back(id);
+	counts[id] += block_size;
+	interval_size += block_size;
+	block_size = 0;
+
+	// End interval
+	if (interval_size >= interval)
+		EndInterval();
+}
+
+
+void Bbv::EndInterval()
+{
+	// Blocks in order of identifier
+	std::sort(touched_blocks.begin(), touched_blocks.end());
+
+	// Dump vector and save it
+	Vector vector;
+	bb_file << 'T';
+	for (int id : touched_blocks)
+	{
+		bb_file << ':' << id << ':' << counts[id] << ' ';
+		vector.emplace_back(id, counts[id]);
+		counts[id] = 0;
+	}
+	bb_file << '\n';
+	intervals.push_back(std::move(vector));
+
+	// Start new interval
+	touched_blocks.clear();
+	interval_size = 0;
+}
+
+
+std::vector<std::vector<double>> Bbv::Project() const
+{
+	std::vector<std::vector<double>> points;
+	for (const Vector &vector : intervals)
+	{
+		// Total instructions in interval
+		long long total = 0;
+		for (auto &entry : vector)
+			total += entry.second;
+
+		// Project normalized vector
+		std::vector<double> point(num_dimensions);
+		for (auto &entry : vector)
+		{
+			double value = (double) entry.second / total;
+			for (int i = 0; i < num_dimensions; i++)
+				point[i] += value * getProjection(entry.first, i);
+		}
+		points.push_back(std::move(point));
+	}
+	return points;
+}
+
+
+double Bbv::KMeans(const std::vector<std::vector<double>> &points,
+		int k,
+		unsigned seed,
+		std::vector<int> &assignment,
+		std::vector<std::vector<double>> &centers)
+{
+	// Initial centers chosen with k-means++
+	std::mt19937 generator(seed);
+	int num_points = points.size();
+	centers.clear();
+	centers.push_back(points[generator() % num_points]);
+	std::vector<double> distances(num_points);
+	while ((int) centers.size() < k)
+	{
+		double total = 0.0;
+		for (int i = 0; i < num_points; i++)
+		{
+			distances[i] = std::numeric_limits<double>::max();
+			for (auto &center : centers)
+				distances[i] = std::min(distances[i],
+						getDistance(points[i], center));
+			total += distances[i];
+		}
+		double target = std::uniform_real_distribution<double>(
+				0.0, total)(generator);
+		int index = 0;
+		while (index < num_points - 1 && target >= distances[index])
+			target -= distances[index++];
+		centers.push_back(points[index]);
+	}
+
+	// Iterate until assignments do not change
+	assignment.assign(num_points, -1);
+	double distortion = 0.0;
+	for (int iteration = 0; iteration < max_iterations; iteration++)
+	{
+		// Assign points to their closest center
+		bool changed = false;
+		distortion = 0.0;
+		for (int i = 0; i < num_points; i++)
+		{
+			int best = 0;
+			double best_distance = getDistance(points[i], centers[0]);
+			for (int j = 1; j < k; j++)
+			{
+				double distance = getDistance(points[i], centers[j]);
+				if (distance < best_distance)
+				{
+					best = j;
+					best_distance = distance;
+				}
+			}
+			changed |= assignment[i] != best;
+			assignment[i] = best;
+			distortion += best_distance;
+		}
+		if (!changed)
+			break;
+
+		// Move centers to the mean of their points. Centers without
+		// points are left unchanged.
+		std::vector<std::vector<double>> sums(k,
+				std::vector<double>(num_dimensions));
+		std::vector<int> sizes(k);
+		for (int i = 0; i < num_points; i++)
+		{
+			sizes[assignment[i]]++;
+			for (int j = 0; j < num_dimensions; j++)
+				sums[assignment[i]][j] += points[i][j];
+		}
+		for (int j = 0; j < k; j++)
+			for (int d = 0; sizes[j] && d < num_dimensions; d++)
+				centers[j][d] = sums[j][d] / sizes[j];
+	}
+	return distortion;
+}
+
+
+double Bbv::getBic(const std::vector<std::vector<double>> &points,
+		int k,
+		const std::vector<int> &assignment,
+		double distortion)
+{
+	// Variance of the spherical Gaussian model
+	int num_points = points.size();
+	double variance = num_points > k ?
+			distortion / num_dimensions / (num_points - k) : 0.0;
+	variance = std::max(variance, 1e-12);
+
+	// Log-likelihood of the points
+	std::vector<int> sizes(k);
+	for (int cluster : assignment)
+		sizes[cluster]++;
+	double likelihood = -0.5 * num_points * num_dimensions *
+			log(2.0 * M_PI * variance) -
+			0.5 * num_dimensions * (num_points - k);
+	for (int size : sizes)
+		if (size)
+			likelihood += size * log((double) size / num_points);
+
+	// Penalty for the number of parameters
+	int num_parameters = k - 1 + k * num_dimensions + 1;
+	return likelihood - 0.5 * num_parameters * log((double) num_points);
+}
+
+
+void Bbv::DumpSimulationPoints()
+{
+	// Nothing to cluster
+	if (intervals.empty())
+		return;
+
+	// Run k-means for each number of clusters, keeping the best of several
+	// initializations.
+	std::vector<std::vector<double>> points = Project();
+	int num_points = points.size();
+	int num_clusters = std::min(max_clusters, num_points);
+	std::vector<std::vector<int>> assignments(num_clusters + 1);
+	std::vector<std::vector<std::vector<double>>> centers(num_clusters + 1);
+	std::vector<double> bics(num_clusters + 1);
+	for (int k = 1; k <= num_clusters; k++)
+	{
+		double best_distortion = std::numeric_limits<double>::max();
+		for (int seed = 0; seed < num_initializations; seed++)
+		{
+			std::vector<int> assignment;
+			std::vector<std::vector<double>> k_centers;
+			double distortion = KMeans(points, k, k * 1000 + seed,
+					assignment, k_centers);
+			if (distortion < best_distortion)
+			{
+				best_distortion = distortion;
+				assignments[k] = assignment;
+				centers[k] = k_centers;
+			}
+		}
+		bics[k] = getBic(points, k, assignments[k], best_distortion);
+	}
+
+	// Choose the smallest number of clusters whose score reaches 90% of the
+	// range of scores, as SimPoint does.
+	double min_bic = *std::min_element(bics.begin() + 1, bics.end());
+	double max_bic = *std::max_element(bics.begin() + 1, bics.end());
+	int k = 1;
+	while (k < num_clusters && bics[k] < min_bic + 0.9 * (max_bic - min_bic))
+		k++;
+
+	// Choose the interval closest to the center of each cluster
+	std::vector<int> representatives(k, -1);
+	std::vector<double> distances(k);
+	std::vector<int> sizes(k);
+	for (int i = 0; i < num_points; i++)
+	{
+		int cluster = assignments[k][i];
+		double distance = getDistance(points[i], centers[k][cluster]);
+		if (representatives[cluster] < 0 || distance < distances[cluster])
+		{
+			representatives[cluster] = i;
+			distances[cluster] = distance;
+		}
+		sizes[cluster]++;
+	}
+
+	// Dump simulation points and weights, numbering non-empty clusters
+	// consecutively.
+	std::ofstream simpoints_file(prefix + ".simpoints");
+	std::ofstream weights_file(prefix + ".weights");
+	int id = 0;
+	for (int cluster = 0; cluster < k; cluster++)
+	{
+		if (!sizes[cluster])
+			continue;
+		simpoints_file << representatives[cluster] << ' ' << id << '\n';
+		weights_file << misc::fmt("%.6f %d\n",
+				(double) sizes[cluster] / num_points, id);
+		id++;
+	}
+}
+
+
+}  // namespace x86
+
@@ -0,0 +1,159 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_EMULATOR_BBV_H
+#define ARCH_X86_EMULATOR_BBV_H
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace x86
+{
+
+/// Basic block vector profile of one context. The profile counts the number
+/// of instructions executed in each basic block, and dumps the counts every
+/// fixed number of instructions (an interval) in the format of SimPoint '.bb'
+/// files. When the profile is destroyed, the intervals are clustered with
+/// k-means, and one simulation point is chosen for each cluster.
+///
+/// For a file prefix 'prefix', the following files are created:
+///
+///	prefix.bb		Basic block vectors, one line per interval
+///	prefix.simpoints	Simulation points, as lines with the index of
+///				an interval and the cluster it represents
+///	prefix.weights		Weights of clusters, as lines with the
+///				fraction of intervals in the cluster and the
+///				cluster identifier
+///
+class Bbv
+{
+	// Number of dimensions of the vectors after random projection
+	static const int num_dimensions = 15;
+
+	// Maximum number of clusters tried when choosing simulation points
+	static const int max_clusters = 10;
+
+	// Number of random initializations for each number of clusters
+	static const int num_initializations = 3;
+
+	// Maximum number of k-means iterations
+	static const int max_iterations = 100;
+
+	// Sparse basic block vector, as pairs of block identifiers and number
+	// of instructions executed in the block
+	typedef std::vector<std::pair<int, long long>> Vector;
+
+	// File prefix
+	std::string prefix;
+
+	// Number of instructions in each interval
+	long long interval;
+
+	// Output stream for the basic block vectors
+	std::ofstream bb_file;
+
+	// Identifiers assigned to basic blocks, indexed by their first
+	// address. Identifiers start at 1.
+	std::unordered_map<unsigned, int> block_ids;
+
+	// Address of the first instruction of the current basic block
+	unsigned block_address = 0;
+
+	// Number of instructions executed in the current basic block
+	int block_size = 0;
+
+	// Number of instructions executed in the current interval for each
+	// block identifier
+	std::vector<long long> counts;
+
+	// Block identifiers with a non-zero count in the current interval
+	std::vector<int> touched_blocks;
+
+	// Number of instructions executed in the current interval
+	long long interval_size = 0;
+
+	// Vectors of all completed intervals
+	std::vector<Vector> intervals;
+
+	// Add the current basic block to the current interval, and finish
+	// the interval if it reached its size.
+	void EndBlock();
+
+	// Dump the current interval and start a new one
+	void EndInterval();
+
+	// Return the vectors of all intervals, normalized and projected to
+	// 'num_dimensions' dimensions.
+	std::vector<std::vector<double>> Project() const;
+
+	// Run k-means with 'k' clusters on the given points, initialized with
+	// the given seed. Return the cluster of each point in 'assignment',
+	// the centers in 'centers', and the distortion as the return value.
+	static double KMeans(const std::vector<std::vector<double>> &points,
+			int k,
+			unsigned seed,
+			std::vector<int> &assignment,
+			std::vector<std::vector<double>> &centers);
+
+	// Return the Bayesian information criterion of a clustering
+	static double getBic(const std::vector<std::vector<double>> &points,
+			int k,
+			const std::vector<int> &assignment,
+			double distortion);
+
+	// Cluster all intervals and dump the simulation points
+	void DumpSimulationPoints();
+
+public:
+
+	/// Create a profile dumping intervals of \a interval instructions
+	/// into files with prefix \a prefix. If the file of basic block
+	/// vectors cannot be created, a misc::Error is thrown.
+	Bbv(const std::string &prefix, long long interval);
+
+	/// Dump the last interval and the simulation points
+	~Bbv();
+
+	/// Record the execution of one instruction at \a address. Argument
+	/// \a block_end is true if the instruction is a control-flow
+	/// instruction, which ends the current basic block.
+	void Execute(unsigned address, bool block_end)
+	{
+		if (!block_size)
+			block_address = address;
+		block_size++;
+		if (block_end)
+			EndBlock();
+	}
+
+	/// Return the number of completed intervals
+	int getNumIntervals() const { return intervals.size(); }
+
+	/// Return the number of different basic blocks executed
+	int getNumBlocks() const { return block_ids.size(); }
+};
+
+
+}  // namespace x86
+
+#endif
@@ -17,6 +17,7 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
 #include <cstring>
 #include <fcntl.h>
 #include <poll.h>
@@ -59,8 +60,8 @@ const misc::StringMap Context::StateMap =
 };
 
 
-long Context::host_flags;
-unsigned char Context::host_fpenv[28];
+thread_local long Context::host_flags;
+thread_local unsigned char Context::host_fpenv[28];
 
 
 Context::Context() :
@@ -366,6 +367,9 @@ void Context::Initialize()
 	// Create speculative memory, and link it with the real memory
 	spec_mem = misc::new_unique<mem::SpecMem>(memory.get());
 
+	// Create decode cache
+	decode_cache = misc::new_shared<DecodeCache>(memory.get());
+
 	// Create file descriptor table
 	file_table = misc::new_shared<comm::FileTable>();
 }
@@ -402,6 +406,9 @@ void Context::Load(const std::vector<std::string> &args,
 	// Create speculative memory, and link it with the real memory
 	spec_mem = misc::new_unique<mem::SpecMem>(memory.get());
 
+	// Create decode cache
+	decode_cache = misc::new_shared<DecodeCache>(memory.get());
+
 	// Create file descriptor table
 	file_table = misc::new_shared<comm::FileTable>();
 	
@@ -447,6 +454,9 @@ void Context::Clone(Context *parent)
 	// Create speculative memory, linked with the real memory
 	spec_mem = misc::new_unique<mem::SpecMem>(memory.get());
 
+	// Decoded instructions are shared with the parent
+	decode_cache = parent->decode_cache;
+
 	// Reference to parent's loader
 	loader = parent->loader;
 
@@ -480,6 +490,9 @@ void Context::Fork(Context *parent)
 	// Create speculative memory, linked with the real memory
 	spec_mem = misc::new_unique<mem::SpecMem>(memory.get());
 
+	// Create decode cache for the new memory image
+	decode_cache = misc::new_shared<DecodeCache>(memory.get());
+
 	// Reference to parent's loader
 	loader = parent->loader;
 
@@ -545,119 +558,22 @@ void Context::DebugCallInst()
 }
 
 
-void Context::HostThreadSuspend()
+void Context::WaitHostEvent(int host_fd, unsigned events, long long time)
 {
-	// Get current time
-	esim::Engine *esim = esim::Engine::getInstance();
-	long long now = esim->getRealTime();
-
-	// Detach this thread - we don't want the parent to have to join it to
-	// release its resources. The thread termination can be observed by
-	// atomically checking the 'host_thread_suspend_active' field of the
-	// context.
-	pthread_detach(pthread_self());
-
-	// Suspended in system call 'nanosleep'
-	if (getState(StateNanosleep))
-	{
-		// Calculate remaining sleep time in microseconds
-		long long timeout = syscall_nanosleep_wakeup_time > now ?
-				syscall_nanosleep_wakeup_time - now : 0;
-		usleep(timeout);
-
-	}
-
-	// Suspended in system call 'read'
-	if (getState(StateRead))
-	{
-		// Get file descriptor
-		comm::FileDescriptor *desc = file_table->getFileDescriptor(syscall_read_fd);
-		if (!desc)
-			throw misc::Panic(misc::fmt("Invalid file descriptor "
-					"(%d)", syscall_read_fd));
-
-		// Perform blocking host 'poll'
-		struct pollfd host_fds;
-		host_fds.fd = desc->getHostIndex();
-		host_fds.events = POLLIN;
-		int err = poll(&host_fds, 1, -1);
-		if (err < 0)
-			throw misc::Panic("Unexpected error in host 'poll'");
-	}
-
-	// Suspended in system call 'write'
-	if (getState(StateWrite))
-	{
-		// Get file descriptor
-		comm::FileDescriptor *desc = file_table->getFileDescriptor(syscall_write_fd);
-		if (!desc)
-			throw misc::Panic(misc::fmt("Invalid file descriptor "
-					"(%d)", syscall_write_fd));
-
-		// Perform blocking host 'poll'
-		struct pollfd host_fds;
-		host_fds.fd = desc->getHostIndex();
-		host_fds.events = POLLOUT;
-		int err = poll(&host_fds, 1, -1);
-		if (err < 0)
-			throw misc::Panic("Unexpected error in host 'poll'");
-	}
-
-	// Suspended in system call 'poll'
-	if (getState(StatePoll))
-	{
-		// Get file descriptor
-		comm::FileDescriptor *desc = file_table->getFileDescriptor(syscall_poll_fd);
-		if (!desc)
-			throw misc::Panic(misc::fmt("Invalid file descriptor "
-					"(%d)", syscall_poll_fd));
-
-		// Calculate timeout for host call in milliseconds from now
-		int timeout;
-		if (!syscall_poll_time)
-			timeout = -1;
-		else if (syscall_poll_time < now)
-			timeout = 0;
-		else
-			timeout = (syscall_poll_time - now) / 1000;
-
-		// Perform blocking host 'poll'
-		struct pollfd host_fds;
-		host_fds.fd = desc->getHostIndex();
-		host_fds.events = ((syscall_poll_events & 4) ? POLLOUT : 0) |
-				((syscall_poll_events & 1) ? POLLIN : 0);
-		int err = poll(&host_fds, 1, timeout);
-		if (err < 0)
-			throw misc::Panic("Unexpected error in host 'poll'");
-	}
-
-	// Event occurred - thread finishes
-	emulator->LockMutex();
-	emulator->ProcessEventsScheduleUnsafe();
-	host_thread_suspend_active = false;
-	emulator->UnlockMutex();
+	emulator->getReactor()->Wait(this, host_fd, events, time);
 }
 
 
-void Context::HostThreadSuspendCancelUnsafe()
+void Context::CancelHostWait()
 {
-	if (host_thread_suspend_active)
-	{
-		if (pthread_cancel(host_thread_suspend))
-			throw misc::Panic(misc::fmt("[%s] Error "
-					"canceling host thread",
-					getName().c_str()));
-		host_thread_suspend_active = false;
-	}
-	emulator->ProcessEventsScheduleUnsafe();
+	emulator->getReactor()->CancelWait(this);
+	emulator->ProcessEventsSchedule();
 }
-	
 
-void Context::HostThreadSuspendCancel()
+
+bool Context::isWaitingHostEvent() const
 {
-	emulator->LockMutex();
-	HostThreadSuspendCancelUnsafe();
-	emulator->UnlockMutex();
+	return emulator->getReactor()->isWaiting(const_cast<Context *>(this));
 }
 
 
@@ -729,32 +645,70 @@ void Context::Wakeup()
 }
 
 
-void Context::HostThreadTimerCancelUnsafe()
+void Context::ClearTimers()
 {
-	if (!host_thread_timer_active)
-		return;
-	if (pthread_cancel(host_thread_timer))
-		throw misc::Panic(misc::fmt("[%s] Error canceling "
-				"host thread",
-				getName().c_str()));
-	host_thread_timer_active = false;
-	emulator->ProcessEventsScheduleUnsafe();
+	for (int which = 0; which < 3; which++)
+	{
+		itimer_value[which] = 0;
+		itimer_interval[which] = 0;
+		emulator->getReactor()->setTimer(this, which, 0);
+	}
 }
 
 
-void Context::HostThreadTimerCancel()
+void Context::ExpireTimer(int which)
 {
-	emulator->LockMutex();
-	HostThreadTimerCancelUnsafe();
-	emulator->UnlockMutex();
+	// Send SIGALRM, SIGVTALRM, or SIGPROF
+	static const int signals[3] = { 14, 26, 27 };
+	assert(which >= 0 && which < 3);
+	signal_mask_table.getPending().Add(signals[which]);
+
+	// Calculate next expiration
+	esim::Engine *esim = esim::Engine::getInstance();
+	long long now = esim->getRealTime();
+	itimer_value[which] = itimer_interval[which] ?
+			std::max(itimer_value[which] + itimer_interval[which],
+			now) : 0;
+	emulator->getReactor()->setTimer(this, which, itimer_value[which]);
+
+	// Check the wakeup condition of the context, if suspended, and its
+	// signal handlers
+	CancelHostWait();
 }
 
 
-void Context::Execute()
+void Context::Decode(bool spec_mode)
 {
+	// Discard the current block if the cache was flushed
+	unsigned eip = regs.getEip();
+	decode_cache->Validate();
+	if (decode_block && decode_generation != decode_cache->getGeneration())
+		decode_block = nullptr;
+
+	// Next instruction in the current block
+	if (decode_block && decode_index < decode_block->instructions.size() &&
+			decode_block->instructions[decode_index].getEip() == eip)
+	{
+		inst = decode_block->instructions[decode_index++];
+		return;
+	}
+
+	// Block starting at the instruction pointer
+	if (!decode_block || decode_index < decode_block->instructions.size() ||
+			decode_block->end != eip)
+	{
+		decode_block = decode_cache->getBlock(eip);
+		decode_index = 0;
+		decode_generation = decode_cache->getGeneration();
+		if (decode_block && decode_block->instructions.size())
+		{
+			inst = decode_block->instructions[decode_index++];
+			return;
+		}
+	}
+
 	// Memory permissions should not be checked if the context is executing in
 	// speculative mode. This will prevent guest segmentation faults to occur.
-	bool spec_mode = getState(StateSpecMode);
 	if (spec_mode)
 		memory->setSafe(false);
 	else
@@ -764,7 +718,7 @@ void Context::Execute()
 	// (i.e., allowing segmentation faults) if executing speculatively.
 	char buffer[20];
 	unsigned char *buffer_ptr = (unsigned char *)memory->getBuffer(
-			regs.getEip(), 20, mem::Memory::AccessExec);
+			eip, 20, mem::Memory::AccessExec);
 	if (!buffer_ptr)
 	{
 		// Disable safe mode. If a part of the 20 read bytes does not
@@ -773,7 +727,7 @@ void Context::Execute()
 		// fault.
 		memory->setSafe(false);
 		buffer_ptr = (unsigned char *)buffer;
-		memory->Access(regs.getEip(), 20, (char *)buffer_ptr,
+		memory->Access(eip, 20, (char *)buffer_ptr,
 				mem::Memory::AccessExec);
 	}
 
@@ -781,7 +735,7 @@ void Context::Execute()
 	memory->setSafeDefault();
 
 	// Disassemble
-	inst.Decode((char *)buffer_ptr, regs.getEip());
+	inst.Decode((char *)buffer_ptr, eip);
 	if (inst.getOpcode() == Instruction::OpcodeInvalid && !spec_mode)
 	{
 		inst.Dump(std::cout);
@@ -791,6 +745,65 @@ void Context::Execute()
 				buffer_ptr[2], buffer_ptr[3]));
 	}
 
+	// Instructions fetched in speculative mode are not cached, since they
+	// can come from invalid addresses. Instructions are appended to the
+	// current block when executed sequentially after its last
+	// instruction.
+	if (spec_mode || inst.getOpcode() == Instruction::OpcodeInvalid)
+	{
+		decode_block = nullptr;
+		return;
+	}
+	if (!decode_block)
+		decode_block = decode_cache->newBlock(eip);
+	if (!decode_cache->AddInstruction(decode_block, inst))
+	{
+		decode_block = nullptr;
+		return;
+	}
+	decode_index = decode_block->instructions.size();
+}
+
+
+void Context::Execute()
+{
+	// Fetch and decode instruction, unless a previous call to
+	// ExecuteParallel() decoded it already
+	bool spec_mode = getState(StateSpecMode);
+	if (!predecoded || inst.getEip() != regs.getEip())
+		Decode(spec_mode);
+	predecoded = false;
+
+	// Execute
+	ExecuteInst(spec_mode);
+
+	// Stats
+	emulator->incNumInstructions();
+}
+
+
+bool Context::ExecuteParallel()
+{
+	// Fetch and decode instruction, unless a previous call decoded it
+	// already
+	assert(!getState(StateSpecMode));
+	if (!predecoded || inst.getEip() != regs.getEip())
+		Decode(false);
+
+	// Software interrupts (system calls) are left decoded for the next
+	// call to Execute() on the main thread
+	predecoded = inst.getOpcode() == Instruction::Opcode_int_imm8;
+	if (predecoded)
+		return false;
+
+	// Execute
+	ExecuteInst(false);
+	return true;
+}
+
+
+void Context::ExecuteInst(bool spec_mode)
+{
 	// Clear existing list of microinstructions, though the architectural
 	// simulator might have cleared it already. A new list will be generated
 	// for the next executed x86 instruction.
@@ -858,8 +871,17 @@ void Context::Execute()
 	if (emulator->call_debug)
 		DebugCallInst();
 
-	// Stats
-	emulator->incNumInstructions();
+	// Basic block vector profile. Instructions executed speculatively
+	// are not counted.
+	if (Emulator::getBbvInterval() && !spec_mode)
+	{
+		if (!bbv)
+			bbv = misc::new_unique<Bbv>(misc::fmt("%s.%d",
+					Emulator::getBbvFile().c_str(), getId()),
+					Emulator::getBbvInterval());
+		bbv->Execute(current_eip, target_eip ||
+				regs.getEip() != current_eip + inst.getSize());
+	}
 }
 
 
@@ -891,8 +913,8 @@ void Context::FinishGroup(int exit_code)
 			context->setState(StateFinished);
 		if (context->getState(StateHandler))
 			context->ReturnFromSignalHandler();
-		context->HostThreadSuspendCancel();
-		context->HostThreadTimerCancel();
+		context->CancelHostWait();
+		context->ClearTimers();
 
 		// Child context of 'context' goes to state 'finished'.
 		// Context 'context' goes to state 'zombie' or 'finished' if it has a parent
@@ -914,9 +936,9 @@ void Context::Finish(int exit_code)
 	if (getState(StateFinished) || getState(StateZombie))
 		return;
 
-	// If context is waiting for host events, cancel spawned host threads
-	HostThreadSuspendCancel();
-	HostThreadTimerCancel();
+	// If context is waiting for host events, stop waiting
+	CancelHostWait();
+	ClearTimers();
 
 	// From now on, all children have lost their parent. If a child is
 	// already zombie, finish it, since its parent won't be able to waitpid it
@@ -20,8 +20,9 @@
 #ifndef ARCH_X86_EMULATOR_CONTEXT_H
 #define ARCH_X86_EMULATOR_CONTEXT_H
 
-#include <deque>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <arch/common/CallStack.h>
 #include <arch/common/Context.h>
@@ -29,11 +30,14 @@
 #include <lib/cpp/Bitmap.h>
 #include <lib/cpp/Debug.h>
 #include <lib/cpp/ELFReader.h>
+#include <lib/cpp/Error.h>
 #include <lib/cpp/String.h>
 #include <memory/Memory.h>
 #include <memory/Mmu.h>
 #include <memory/SpecMem.h>
 
+#include "Bbv.h"
+#include "DecodeCache.h"
 #include "Regs.h"
 #include "Signal.h"
 #include "Uinst.h"
@@ -136,11 +140,13 @@ public:
 
 private:
 
-	// Saved host flags during instruction emulation
-	static long host_flags;
+	// Saved host flags during instruction emulation. Contexts run on
+	// several host threads with option --x86-threads, so each thread
+	// has its own copy.
+	static thread_local long host_flags;
 
 	// Saved host floating-point environment during instruction emulation
-	static unsigned char host_fpenv[28];
+	static thread_local unsigned char host_fpenv[28];
 
 	// Emulator that it belongs to
 	Emulator *emulator;
@@ -168,6 +174,29 @@ private:
 	// it with the actual memory, known only at context creation.
 	std::unique_ptr<mem::SpecMem> spec_mem;
 
+	// Cache of decoded instructions, shared by all contexts sharing the
+	// memory image
+	std::shared_ptr<DecodeCache> decode_cache;
+
+	// Block of the decode cache containing the last executed instruction,
+	// index of the instruction following it, and generation of the cache
+	// when the block was obtained
+	DecodeCache::Block *decode_block = nullptr;
+	unsigned decode_index = 0;
+	long long decode_generation = 0;
+
+	// Set 'inst' to the decoded instruction at the current instruction
+	// pointer, using the decode cache when possible
+	void Decode(bool spec_mode);
+
+	// Set when 'inst' holds the instruction at the current instruction
+	// pointer, decoded by ExecuteParallel() but not executed yet
+	bool predecoded = false;
+
+	// Execute the instruction in 'inst', without updating the number of
+	// instructions of the emulator
+	void ExecuteInst(bool spec_mode);
+
 	// Register file. Each context has its own copy always.
 	Regs regs;
 
@@ -180,6 +209,10 @@ private:
 	// Call stack
 	std::unique_ptr<comm::CallStack> call_stack;
 
+	// Basic block vector profile, created on the first instruction
+	// executed if option '--x86-bbv' is given
+	std::unique_ptr<Bbv> bbv;
+
 	// Address of last emulated instruction
 	unsigned last_eip = 0;
 
@@ -232,19 +265,12 @@ private:
 	// Segment size for glibc
 	unsigned glibc_segment_limit = 0;
 
-	// Host thread that suspends and then schedules call to ProcessEvents()
-	// The 'host_thread_suspend_active' flag is set when a 'host_thread_suspend' thread
-	// is launched for this context (by caller).
-	// It is clear when the context finished (by the host thread).
-	// It should be accessed safely by locking the emulator mutex
-	pthread_t host_thread_suspend;  // Thread
-	bool host_thread_suspend_active = false;  // Thread-spawned flag
-
-	// Host thread that lets time elapse and schedules call to
-	// ProcessEvents()
-	pthread_t host_thread_timer;
-	int host_thread_timer_active = false;
-	long long host_thread_timer_wakeup;
+	// Interval timers set with system call 'setitimer', indexed by the
+	// timer type (real, virtual, profiling). Each timer has the real time
+	// of its next expiration, or 0 if disarmed, and its interval, in
+	// microseconds.
+	long long itimer_value[3] = { };
+	long long itimer_interval[3] = { };
 
 	// Address of futex where context is suspended
 	unsigned wakeup_futex;
@@ -273,21 +299,19 @@ private:
 	// Dump debug information about a call instruction
 	void DebugCallInst();
 
-	// Host thread function
-	void HostThreadSuspend();
-	static void *HostThreadSuspend(void *data)
-	{
-		((Context *) data)->HostThreadSuspend();
-		return nullptr;
-	}
-	
-	// Cancel host thread
-	void HostThreadSuspendCancel();
-	void HostThreadSuspendCancelUnsafe();
+	// Wait in the emulator reactor until host file descriptor 'host_fd'
+	// has any of the 'epoll' events in 'events', or until real time
+	// 'time', whichever happens first. A negative 'host_fd' or a zero
+	// 'time' are ignored. The wakeup condition of the context is checked
+	// again when the wait ends.
+	void WaitHostEvent(int host_fd, unsigned events, long long time);
 
-	// Cancel timer thread
-	void HostThreadTimerCancel();
-	void HostThreadTimerCancelUnsafe();
+	// Stop waiting for host events, if the context was waiting, and
+	// schedule a check of the wakeup condition of suspended contexts.
+	void CancelHostWait();
+
+	// Disarm all interval timers
+	void ClearTimers();
 
 	// Callbacks for suspended contexts
 	typedef bool (Context::*CanWakeupFn)();
@@ -428,17 +452,39 @@ private:
 	// load, operate, and store.
 	bool uinst_effaddr_emitted = false;
 
-	// List of micro-instructions produced during the emulation of the last
-	// x86 macro-instruction.
-	std::deque<std::shared_ptr<Uinst>> uinsts;
+	// Maximum number of micro-instructions produced by one x86
+	// macro-instruction
+	static const int MaxUinsts = 64;
+
+	// Micro-instructions produced during the emulation of the last x86
+	// macro-instruction. They are stored in a fixed array that is reused
+	// for every macro-instruction, so that producing them involves no
+	// heap allocation.
+	Uinst uinsts[MaxUinsts];
+
+	// Number of micro-instructions in 'uinsts'
+	int num_uinsts = 0;
+
+	// Index in 'uinsts' of the next micro-instruction to be extracted
+	int uinst_head = 0;
 
 	// Clear the list of micro-instructions
 	void ClearUinsts()
 	{
-		uinsts.clear();
+		num_uinsts = 0;
+		uinst_head = 0;
 		uinst_effaddr_emitted = false;
 	}
 
+	// Append a micro-instruction to the list, and return it
+	Uinst *AddUinst(const Uinst &uinst)
+	{
+		if (num_uinsts == MaxUinsts)
+			throw misc::Panic("Too many micro-instructions");
+		uinsts[num_uinsts] = uinst;
+		return &uinsts[num_uinsts++];
+	}
+
 	// If dependence at position \a index is a memory operand, return its
 	// associated standard dependence in \a std_dep and its size as the
 	// return value of the function. The function returns 0 if the
@@ -682,6 +728,24 @@ private:
 	comm::FileDescriptor *SyscallOpenVirtualDevice(const std::string &path,
 			int flags, int mode);
 
+	// Transfer data between a host file and the guest memory regions
+	// given in \a buffers as pairs of address and size. The guest memory
+	// is written if \a access is AccessWrite, or read if it is
+	// AccessRead. The host calls operate directly on the guest pages
+	// when possible, or on an intermediate buffer otherwise. If \a
+	// offset is -1, the transfer starts at the current file position.
+	// The function returns the number of bytes transferred, or a
+	// negative error code.
+	int SyscallTransfer(int host_fd, mem::Memory::AccessType access,
+			const std::vector<std::pair<unsigned, unsigned>> &buffers,
+			long long offset = -1);
+
+	// Read the guest iovec array of readv() and writev() into a list of
+	// regions for SyscallTransfer(). Return false if the array is
+	// invalid.
+	bool SyscallReadIovecs(unsigned iovec_ptr, unsigned vlen,
+			std::vector<std::pair<unsigned, unsigned>> &buffers);
+
 	// System call 'nanosleep'
 	long long syscall_nanosleep_wakeup_time;
 	void SyscallNanosleepWakeup();
@@ -752,6 +816,9 @@ public:
 	/// Initialize the context by forking a parent context.
 	void Fork(Context *parent);
 
+	/// Return the call stack of the context, or null if none
+	comm::CallStack *getCallStack() const { return call_stack.get(); }
+
 	/// Return the MMU used by the context.
 	mem::Mmu *getMmu() const { return mmu; }
 
@@ -807,6 +874,16 @@ public:
 	/// to wake up, by invoking the 'can_wakeup' callback.
 	bool CanWakeup();
 
+	/// Return whether the context is waiting for a host event, in which
+	/// case its wakeup condition does not need to be checked until the
+	/// event occurs.
+	bool isWaitingHostEvent() const;
+
+	/// Expire the interval timer of type \a which (real, virtual, or
+	/// profiling), sending the corresponding signal to the context and
+	/// rearming the timer with its interval.
+	void ExpireTimer(int which);
+
 	/// Wake up the context. This is a virtual function mandated by the
 	/// parent class comm::Context. The 'wakeup_fn' callback function is
 	/// invoked, and the wakeup data is internally freed by reseting the
@@ -836,6 +913,15 @@ public:
 	/// register \c eip.
 	void Execute();
 
+	/// Run one instruction for the context on a host worker thread of the
+	/// parallel emulator, as Execute() does, unless the instruction is a
+	/// system call, which must run on the main thread. The number of
+	/// instructions of the emulator is not updated.
+	///
+	/// \return Whether the instruction was executed. If it was not, the
+	/// next call to Execute() runs it.
+	bool ExecuteParallel();
+
 	/// Return a reference of the register file
 	Regs &getRegs() { return regs; }
 
@@ -904,6 +990,50 @@ public:
 
 
 
+	//
+	// Checkpoints (ContextCheckpoint.cc)
+	//
+
+	/// Objects shared among contexts (memory, file table, signal handler
+	/// table, and loader information). A shared object is written into a
+	/// checkpoint only by the first context that references it, while
+	/// the following contexts only write its index. The same instance of
+	/// this structure must be used for all contexts saved into or loaded
+	/// from one checkpoint.
+	struct CheckpointObjects
+	{
+		// Index of each object saved so far
+		std::unordered_map<const void *, int> indices;
+
+		// Objects loaded so far, in the order they were saved
+		std::vector<std::shared_ptr<void>> objects;
+
+		// Virtual memory space created for each loaded memory
+		std::unordered_map<mem::Memory *, mem::Mmu::Space *> mmu_spaces;
+
+		// Decode cache created for each loaded memory
+		std::unordered_map<mem::Memory *, std::shared_ptr<DecodeCache>>
+				decode_caches;
+	};
+
+	/// Return whether the context can be saved in a checkpoint now. This
+	/// is not possible while the context runs in speculative mode, or
+	/// while it is suspended in a system call that depends on host
+	/// resources, such as a timer or a host file descriptor.
+	bool canSaveCheckpoint() const;
+
+	/// Save the architected state of the context into a checkpoint
+	void SaveCheckpoint(misc::CheckpointWriter &writer,
+			CheckpointObjects &objects) const;
+
+	/// Load the state of a newly created context from a checkpoint. The
+	/// parent contexts must have been loaded before.
+	void LoadCheckpoint(misc::CheckpointReader &reader,
+			CheckpointObjects &objects);
+
+
+
+
 	//
 	// Micro-instructions
 	//
@@ -952,18 +1082,16 @@ public:
 
 	/// Return the number of micro-instructions produced by the emulation of
 	/// the last x86 instruction with an invocation to Context::Execute().
-	int getNumUinsts() const { return uinsts.size(); }
+	int getNumUinsts() const { return num_uinsts - uinst_head; }
 
 	/// Extract the micro-instruction at the head of the micro-instruction
-	/// list, and return an ownership reference to it. If the result is not
-	/// immediately captured by a shared pointer, the micro-instruction will
-	/// be freed.
-	std::shared_ptr<Uinst> ExtractUinst()
+	/// list. The returned micro-instruction is owned by the context, and
+	/// is only valid until the next x86 instruction is emulated, so it
+	/// must be copied to be kept.
+	const Uinst *ExtractUinst()
 	{
-		assert(uinsts.size() > 0);
-		std::shared_ptr<Uinst> uinst = uinsts.front();
-		uinsts.pop_front();
-		return uinst;
+		assert(uinst_head < num_uinsts);
+		return &uinsts[uinst_head++];
 	}
 
 
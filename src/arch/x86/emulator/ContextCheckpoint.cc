@@ -0,0 +1,278 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <lib/cpp/Checkpoint.h>
+#include <lib/cpp/Misc.h>
+
+#include "Context.h"
+#include "Emulator.h"
+
+
+namespace x86
+{
+
+
+// Write the index of an object shared among contexts. The function returns
+// true if the object is written for the first time, in which case the caller
+// must write its content right after.
+static bool SaveObjectIndex(misc::CheckpointWriter &writer,
+		Context::CheckpointObjects &objects,
+		const void *object)
+{
+	// Object saved before
+	auto it = objects.indices.find(object);
+	if (it != objects.indices.end())
+	{
+		writer.WriteValue(it->second);
+		return false;
+	}
+
+	// New object
+	int index = objects.indices.size();
+	objects.indices[object] = index;
+	writer.WriteValue(index);
+	return true;
+}
+
+
+// Read the index of an object shared among contexts. The function returns the
+// object if it was loaded before, or nullptr if its content follows in the
+// checkpoint. In the latter case, the caller must load it and add it to the
+// list of loaded objects.
+static std::shared_ptr<void> LoadObjectIndex(misc::CheckpointReader &reader,
+		Context::CheckpointObjects &objects)
+{
+	int index = reader.ReadValue<int>();
+	if (index == (int) objects.objects.size())
+		return nullptr;
+	if (!misc::inRange(index, 0, (int) objects.objects.size() - 1))
+		throw misc::Error("Corrupt checkpoint: invalid shared object");
+	return objects.objects[index];
+}
+
+
+// Write a vector of strings
+static void SaveStrings(misc::CheckpointWriter &writer,
+		const std::vector<std::string> &strings)
+{
+	writer.WriteValue<unsigned>(strings.size());
+	for (const std::string &s : strings)
+		writer.WriteString(s);
+}
+
+
+// Read a vector of strings
+static void LoadStrings(misc::CheckpointReader &reader,
+		std::vector<std::string> &strings)
+{
+	strings.resize(reader.ReadValue<unsigned>());
+	for (std::string &s : strings)
+		s = reader.ReadString();
+}
+
+
+bool Context::canSaveCheckpoint() const
+{
+	return !getState(StateSpecMode) &&
+			!getState(StateCallback) &&
+			!itimer_value[0] && !itimer_value[1] &&
+			!itimer_value[2];
+}
+
+
+void Context::SaveCheckpoint(misc::CheckpointWriter &writer,
+		CheckpointObjects &objects) const
+{
+	// Identifiers and state. The mapping to hardware threads is not saved,
+	// since the timing simulator maps contexts again after restoring.
+	assert(canSaveCheckpoint());
+	writer.WriteSection("x86::Context");
+	writer.WriteValue(getId());
+	writer.WriteValue<unsigned>(state & ~(StateAlloc | StateMapped));
+	writer.WriteValue(parent ? parent->getId() : 0);
+	writer.WriteValue(group_parent ? group_parent->getId() : 0);
+
+	// Registers
+	writer.WriteValue(regs);
+	writer.WriteValue(last_eip);
+	writer.WriteValue(current_eip);
+	writer.WriteValue(target_eip);
+
+	// Process information
+	writer.WriteValue(exit_signal);
+	writer.WriteValue(exit_code);
+	writer.WriteValue(clear_child_tid);
+	writer.WriteValue(robust_list_head);
+	writer.WriteValue(glibc_segment_base);
+	writer.WriteValue(glibc_segment_limit);
+	writer.WriteValue(wakeup_futex);
+	writer.WriteValue(wakeup_futex_bitset);
+	writer.WriteValue(wakeup_futex_sleep);
+	writer.WriteValue(sched_policy);
+	writer.WriteValue(sched_priority);
+	signal_mask_table.SaveCheckpoint(writer);
+
+	// Shared objects
+	if (SaveObjectIndex(writer, objects, memory.get()))
+		memory->SaveCheckpoint(writer);
+	if (SaveObjectIndex(writer, objects, file_table.get()))
+		file_table->SaveCheckpoint(writer);
+	if (SaveObjectIndex(writer, objects, signal_handler_table.get()))
+		signal_handler_table->SaveCheckpoint(writer);
+	if (SaveObjectIndex(writer, objects, loader.get()))
+	{
+		// The program binary is not saved, since it is only needed
+		// while the program is loaded.
+		SaveStrings(writer, loader->args);
+		SaveStrings(writer, loader->env);
+		writer.WriteString(loader->interpreter);
+		writer.WriteString(loader->exe);
+		writer.WriteString(loader->cwd);
+		writer.WriteString(loader->stdin_file_name);
+		writer.WriteString(loader->stdout_file_name);
+		writer.WriteValue(loader->stack_base);
+		writer.WriteValue(loader->stack_top);
+		writer.WriteValue(loader->stack_size);
+		writer.WriteValue(loader->environ_base);
+		writer.WriteValue(loader->prog_entry);
+		writer.WriteValue(loader->interp_prog_entry);
+		writer.WriteValue(loader->at_random_addr);
+		writer.WriteValue(loader->at_random_addr_holder);
+		writer.WriteValue(loader->at_platform_ptr);
+	}
+}
+
+
+void Context::LoadCheckpoint(misc::CheckpointReader &reader,
+		CheckpointObjects &objects)
+{
+	// Identifiers and state
+	reader.ReadSection("x86::Context");
+	setId(reader.ReadValue<int>());
+	unsigned state = reader.ReadValue<unsigned>();
+	int parent_id = reader.ReadValue<int>();
+	int group_parent_id = reader.ReadValue<int>();
+	parent = parent_id ? emulator->getContext(parent_id) : nullptr;
+	group_parent = group_parent_id ?
+			emulator->getContext(group_parent_id) : nullptr;
+	if ((parent_id && !parent) || (group_parent_id && !group_parent))
+		throw misc::Error("Corrupt checkpoint: parent context missing");
+
+	// Registers
+	reader.ReadValue(regs);
+	reader.ReadValue(last_eip);
+	reader.ReadValue(current_eip);
+	reader.ReadValue(target_eip);
+
+	// Process information
+	reader.ReadValue(exit_signal);
+	reader.ReadValue(exit_code);
+	reader.ReadValue(clear_child_tid);
+	reader.ReadValue(robust_list_head);
+	reader.ReadValue(glibc_segment_base);
+	reader.ReadValue(glibc_segment_limit);
+	reader.ReadValue(wakeup_futex);
+	reader.ReadValue(wakeup_futex_bitset);
+	reader.ReadValue(wakeup_futex_sleep);
+	reader.ReadValue(sched_policy);
+	reader.ReadValue(sched_priority);
+	signal_mask_table.LoadCheckpoint(reader);
+
+	// Memory, with a new virtual memory space for each memory image
+	std::shared_ptr<void> object = LoadObjectIndex(reader, objects);
+	if (object)
+	{
+		memory = std::static_pointer_cast<mem::Memory>(object);
+	}
+	else
+	{
+		memory = misc::new_shared<mem::Memory>();
+		memory->LoadCheckpoint(reader);
+		objects.objects.push_back(memory);
+		objects.mmu_spaces[memory.get()] = mmu->newSpace();
+		objects.decode_caches[memory.get()] =
+				misc::new_shared<DecodeCache>(memory.get());
+	}
+	mmu_space = objects.mmu_spaces[memory.get()];
+	decode_cache = objects.decode_caches[memory.get()];
+	spec_mem = misc::new_unique<mem::SpecMem>(memory.get());
+
+	// File table
+	object = LoadObjectIndex(reader, objects);
+	if (object)
+	{
+		file_table = std::static_pointer_cast<comm::FileTable>(object);
+	}
+	else
+	{
+		file_table = misc::new_shared<comm::FileTable>();
+		file_table->LoadCheckpoint(reader);
+		objects.objects.push_back(file_table);
+	}
+
+	// Signal handler table
+	object = LoadObjectIndex(reader, objects);
+	if (object)
+	{
+		signal_handler_table = std::static_pointer_cast<
+				SignalHandlerTable>(object);
+	}
+	else
+	{
+		signal_handler_table = misc::new_shared<SignalHandlerTable>();
+		signal_handler_table->LoadCheckpoint(reader);
+		objects.objects.push_back(signal_handler_table);
+	}
+
+	// Loader information
+	object = LoadObjectIndex(reader, objects);
+	if (object)
+	{
+		loader = std::static_pointer_cast<Loader>(object);
+	}
+	else
+	{
+		loader = misc::new_shared<Loader>();
+		LoadStrings(reader, loader->args);
+		LoadStrings(reader, loader->env);
+		loader->interpreter = reader.ReadString();
+		loader->exe = reader.ReadString();
+		loader->cwd = reader.ReadString();
+		loader->stdin_file_name = reader.ReadString();
+		loader->stdout_file_name = reader.ReadString();
+		reader.ReadValue(loader->stack_base);
+		reader.ReadValue(loader->stack_top);
+		reader.ReadValue(loader->stack_size);
+		reader.ReadValue(loader->environ_base);
+		reader.ReadValue(loader->prog_entry);
+		reader.ReadValue(loader->interp_prog_entry);
+		reader.ReadValue(loader->at_random_addr);
+		reader.ReadValue(loader->at_random_addr_holder);
+		reader.ReadValue(loader->at_platform_ptr);
+		objects.objects.push_back(loader);
+	}
+	call_stack = misc::new_unique<comm::CallStack>(loader->exe);
+
+	// Set the state last, placing the context in the emulator lists
+	UpdateState(state);
+}
+
+
+}  // namespace x86
+
@@ -293,8 +293,8 @@ void Context::ExecuteInst_call_rel32()
 	target_eip = regs.getEip() + inst.getImmDWord();
 	regs.setEip(target_eip);
 
-	// Call stack
-	if (call_stack != nullptr)
+	// Call stack, not updated in speculative mode
+	if (call_stack != nullptr && !getState(StateSpecMode))
 		call_stack->Call(target_eip, regs.getEsp());
 
 	// Micro-instructions
@@ -344,8 +344,8 @@ void Context::ExecuteInst_call_rm32()
 	MemoryWrite(regs.getEsp(), 4, &eip);
 	regs.setEip(target_eip);
 
-	// Call stack
-	if (call_stack != nullptr)
+	// Call stack, not updated in speculative mode
+	if (call_stack != nullptr && !getState(StateSpecMode))
 		call_stack->Call(target_eip, regs.getEsp());
 
 	// Micro-instructions
@@ -717,25 +717,8 @@ void Context::ExecuteInst_cwde()
 void Context::ExecuteInst_dec_rm8()
 {
 	unsigned char rm8 = LoadRm8();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%al\n\t"
-		"dec %%al\n\t"
-		"mov %%al, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (rm8)
-		: "g" (rm8), "g" (flags)
-		: "al"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreRm8(rm8);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyDec, sizeof rm8, rm8, 1, rm8 - 1);
+	StoreRm8(rm8 - 1);
 
 	newUinst(Uinst::OpcodeSub,
 			Uinst::DepRm8,
@@ -751,25 +734,8 @@ void Context::ExecuteInst_dec_rm8()
 void Context::ExecuteInst_dec_rm16()
 {
 	unsigned short rm16 = LoadRm16();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%ax\n\t"
-		"dec %%ax\n\t"
-		"mov %%ax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (rm16)
-		: "g" (rm16), "g" (flags)
-		: "ax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreRm16(rm16);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyDec, sizeof rm16, rm16, 1, rm16 - 1);
+	StoreRm16(rm16 - 1);
 
 	newUinst(Uinst::OpcodeSub,
 			Uinst::DepRm16,
@@ -785,25 +751,8 @@ void Context::ExecuteInst_dec_rm16()
 void Context::ExecuteInst_dec_rm32()
 {
 	unsigned int rm32 = LoadRm32();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%eax\n\t"
-		"dec %%eax\n\t"
-		"mov %%eax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (rm32)
-		: "g" (rm32), "g" (flags)
-		: "eax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreRm32(rm32);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyDec, sizeof rm32, rm32, 1, rm32 - 1);
+	StoreRm32(rm32 - 1);
 
 	newUinst(Uinst::OpcodeSub,
 			Uinst::DepRm32,
@@ -819,25 +768,8 @@ void Context::ExecuteInst_dec_rm32()
 void Context::ExecuteInst_dec_ir16()
 {
 	unsigned short ir16 = LoadIR16();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%ax\n\t"
-		"dec %%ax\n\t"
-		"mov %%ax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (ir16)
-		: "g" (ir16), "g" (flags)
-		: "eax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreIR16(ir16);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyDec, sizeof ir16, ir16, 1, ir16 - 1);
+	StoreIR16(ir16 - 1);
 
 	newUinst(Uinst::OpcodeSub,
 			Uinst::DepIr16,
@@ -853,25 +785,8 @@ void Context::ExecuteInst_dec_ir16()
 void Context::ExecuteInst_dec_ir32()
 {
 	unsigned int ir32 = LoadIR32();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%eax\n\t"
-		"dec %%eax\n\t"
-		"mov %%eax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (ir32)
-		: "g" (ir32), "g" (flags)
-		: "eax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreIR32(ir32);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyDec, sizeof ir32, ir32, 1, ir32 - 1);
+	StoreIR32(ir32 - 1);
 
 	newUinst(Uinst::OpcodeSub,
 			Uinst::DepIr32,
@@ -1226,25 +1141,8 @@ void Context::ExecuteInst_imul_r32_rm32_imm32()
 void Context::ExecuteInst_inc_rm8()
 {
 	unsigned char rm8 = LoadRm8();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%al\n\t"
-		"inc %%al\n\t"
-		"mov %%al, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (rm8)
-		: "g" (rm8), "g" (flags)
-		: "al"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreRm8(rm8);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyInc, sizeof rm8, rm8, 1, rm8 + 1);
+	StoreRm8(rm8 + 1);
 
 	newUinst(Uinst::OpcodeAdd,
 			Uinst::DepRm8,
@@ -1260,25 +1158,8 @@ void Context::ExecuteInst_inc_rm8()
 void Context::ExecuteInst_inc_rm16()
 {
 	unsigned short rm16 = LoadRm16();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%ax\n\t"
-		"inc %%ax\n\t"
-		"mov %%ax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (rm16)
-		: "g" (rm16), "g" (flags)
-		: "ax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreRm16(rm16);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyInc, sizeof rm16, rm16, 1, rm16 + 1);
+	StoreRm16(rm16 + 1);
 
 	newUinst(Uinst::OpcodeAdd,
 			Uinst::DepRm16,
@@ -1294,25 +1175,8 @@ void Context::ExecuteInst_inc_rm16()
 void Context::ExecuteInst_inc_rm32()
 {
 	unsigned int rm32 = LoadRm32();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%eax\n\t"
-		"inc %%eax\n\t"
-		"mov %%eax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (rm32)
-		: "g" (rm32), "g" (flags)
-		: "eax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreRm32(rm32);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyInc, sizeof rm32, rm32, 1, rm32 + 1);
+	StoreRm32(rm32 + 1);
 
 	newUinst(Uinst::OpcodeAdd,
 			Uinst::DepRm32,
@@ -1328,25 +1192,8 @@ void Context::ExecuteInst_inc_rm32()
 void Context::ExecuteInst_inc_ir16()
 {
 	unsigned short ir16 = LoadIR16();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%ax\n\t"
-		"inc %%ax\n\t"
-		"mov %%ax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (ir16)
-		: "g" (ir16), "g" (flags)
-		: "ax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreIR16(ir16);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyInc, sizeof ir16, ir16, 1, ir16 + 1);
+	StoreIR16(ir16 + 1);
 
 	newUinst(Uinst::OpcodeAdd,
 			Uinst::DepIr16,
@@ -1362,25 +1209,8 @@ void Context::ExecuteInst_inc_ir16()
 void Context::ExecuteInst_inc_ir32()
 {
 	unsigned int ir32 = LoadIR32();
-	unsigned long flags = regs.getEflags();
-
-	__X86_CONTEXT_SAVE_FLAGS__
-	asm volatile (
-		"push %3\n\t"
-		"popf\n\t"
-		"mov %2, %%eax\n\t"
-		"inc %%eax\n\t"
-		"mov %%eax, %1\n\t"
-		"pushf\n\t"
-		"pop %0\n\t"
-		: "=g" (flags), "=g" (ir32)
-		: "g" (ir32), "g" (flags)
-		: "eax"
-	);
-	__X86_CONTEXT_RESTORE_FLAGS__
-
-	StoreIR32(ir32);
-	regs.setEflags(flags);
+	regs.setLazyFlags(Regs::LazyInc, sizeof ir32, ir32, 1, ir32 + 1);
+	StoreIR32(ir32 + 1);
 
 	newUinst(Uinst::OpcodeAdd,
 			Uinst::DepIr32,
@@ -2660,8 +2490,8 @@ void Context::ExecuteInst_ret()
 	regs.incEsp(4);
 	regs.setEip(target_eip);
 
-	// Call stack
-	if (call_stack != nullptr)
+	// Call stack, not updated in speculative mode
+	if (call_stack != nullptr && !getState(StateSpecMode))
 		call_stack->Return(regs.getEip(), regs.getEsp());
 
 	// Micro-instrutcions
@@ -2719,8 +2549,8 @@ void Context::ExecuteInst_ret_imm16()
 	regs.incEsp(4 + pop);
 	regs.setEip(target_eip);
 
-	// Call stack
-	if (call_stack != nullptr)
+	// Call stack, not updated in speculative mode
+	if (call_stack != nullptr && !getState(StateSpecMode))
 		call_stack->Return(regs.getEip(), regs.getEsp());
 
 	// Micro-instructions
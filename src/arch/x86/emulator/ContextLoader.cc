@@ -185,9 +185,18 @@ unsigned Context::LoadSegments(ELFReader::File *binary)
 		if (program_header->getFlags() & PF_W)
 			perm |= mem::Memory::AccessWrite;
 
-		// Check if segment has execution permission
+		// Check if segment has execution permission. Code segments are
+		// added to the call stack to find symbols.
 		if (program_header->getFlags() & PF_X)
+		{
 			perm |= mem::Memory::AccessExec;
+			if (call_stack != nullptr)
+				call_stack->Map(binary->getPath(),
+						program_header->getOffset(),
+						program_header->getVaddr(),
+						program_header->getFilesz(),
+						false);
+		}
 
 		// Map segment in memory
 		memory->Map(program_header->getVaddr(),
@@ -19,6 +19,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <poll.h>
 #include <sched.h>
 #include <string.h>
@@ -26,6 +27,7 @@
 #include <unistd.h>
 #include <utime.h>
 #include <algorithm>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
@@ -34,6 +36,7 @@
 #include <sys/statfs.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include <sys/uio.h>
 
 #include <lib/cpp/Misc.h>
 #include <arch/common/Driver.h>
@@ -334,6 +337,145 @@ int Context::ExecuteSyscall_fork()
 
 
 
+//
+// Transfer of data between host files and guest memory
+//
+
+int Context::SyscallTransfer(int host_fd, mem::Memory::AccessType access,
+		const std::vector<std::pair<unsigned, unsigned>> &buffers,
+		long long offset)
+{
+	// Obtain host buffers over the guest pages
+	std::vector<struct iovec> iovecs;
+	bool direct = true;
+	for (auto &buffer : buffers)
+	{
+		if (!memory->getIovecs(buffer.first, buffer.second, access,
+				iovecs))
+		{
+			direct = false;
+			break;
+		}
+	}
+
+	// Host calls on guest pages, in groups of up to IOV_MAX buffers
+	if (direct)
+	{
+		long long total = 0;
+		for (unsigned i = 0; i < iovecs.size(); i += IOV_MAX)
+		{
+			int count = std::min((int) iovecs.size() - (int) i,
+					IOV_MAX);
+			size_t size = 0;
+			for (int j = 0; j < count; j++)
+				size += iovecs[i + j].iov_len;
+
+			// Host call
+			ssize_t err;
+			if (access == mem::Memory::AccessWrite)
+				err = offset < 0 ?
+						readv(host_fd, &iovecs[i], count) :
+						preadv(host_fd, &iovecs[i], count,
+						offset + total);
+			else
+				err = offset < 0 ?
+						writev(host_fd, &iovecs[i], count) :
+						pwritev(host_fd, &iovecs[i], count,
+						offset + total);
+			if (err < 0)
+				return total ? total : -errno;
+
+			// Stop on partial transfer
+			total += err;
+			if ((size_t) err < size)
+				break;
+		}
+		return total;
+	}
+
+	// Some page is not accessible. Use an intermediate buffer, so that
+	// the fault is reported by the memory accesses below.
+	size_t size = 0;
+	for (auto &buffer : buffers)
+		size += buffer.second;
+	auto buf = misc::new_unique_array<char>(size);
+	if (access == mem::Memory::AccessWrite)
+	{
+		ssize_t err = offset < 0 ? read(host_fd, buf.get(), size) :
+				pread(host_fd, buf.get(), size, offset);
+		if (err < 0)
+			return -errno;
+		size_t pos = 0;
+		for (auto &buffer : buffers)
+		{
+			unsigned count = std::min((size_t) buffer.second,
+					err - pos);
+			memory->Write(buffer.first, count, buf.get() + pos);
+			pos += count;
+		}
+		return err;
+	}
+	else
+	{
+		size_t pos = 0;
+		for (auto &buffer : buffers)
+		{
+			memory->Read(buffer.first, buffer.second, buf.get() + pos);
+			pos += buffer.second;
+		}
+		ssize_t err = offset < 0 ? write(host_fd, buf.get(), size) :
+				pwrite(host_fd, buf.get(), size, offset);
+		return err < 0 ? -errno : err;
+	}
+}
+
+
+bool Context::SyscallReadIovecs(unsigned iovec_ptr, unsigned vlen,
+		std::vector<std::pair<unsigned, unsigned>> &buffers)
+{
+	// Check number of elements
+	if (vlen > IOV_MAX)
+		return false;
+
+	// Read elements
+	size_t total = 0;
+	for (unsigned v = 0; v < vlen; v++)
+	{
+		unsigned iov_base;
+		unsigned iov_len;
+		memory->Read(iovec_ptr, 4, (char *) &iov_base);
+		memory->Read(iovec_ptr + 4, 4, (char *) &iov_len);
+		iovec_ptr += 8;
+		emulator->syscall_debug << misc::fmt("  iovec[%d]: "
+				"base=0x%x, len=0x%x\n", v, iov_base, iov_len);
+
+		// The total size must fit in the return value
+		total += iov_len;
+		if (total > INT_MAX)
+			return false;
+		if (iov_len)
+			buffers.emplace_back(iov_base, iov_len);
+	}
+	return true;
+}
+
+
+// Dump the first bytes of a guest buffer into the system call debug output
+static void DumpBuffer(misc::Debug &debug, mem::Memory *memory,
+		unsigned address, unsigned size)
+{
+	if (!debug)
+		return;
+	char buf[40];
+	size = std::min(size, (unsigned) sizeof buf);
+	memory->Read(address, size, buf);
+	debug << "  buf=\"" << misc::StringBinaryBuffer(buf, size, 40)
+			<< "\"\n";
+}
+
+
+
+
 //
 // System call 'read'
 //
@@ -344,10 +486,6 @@ void Context::SyscallReadWakeup()
 
 bool Context::SyscallReadCanWakeup()
 {
-	// If the host thread is still running for this context, do nothing.
-	if (host_thread_suspend_active)
-		return false;
-
 	// Context received a signal
 	SignalSet pending_unblocked = signal_mask_table.getPending() &
 			~signal_mask_table.getBlocked();
@@ -377,15 +515,13 @@ bool Context::SyscallReadCanWakeup()
 	if (host_fds.revents)
 	{
 		unsigned pbuf = regs.getEcx();
-		int count = regs.getEdx();
-		auto buf = misc::new_unique_array<char>(count);
-
-		count = read(desc->getHostIndex(), buf.get(), count);
-		if (count < 0)
+		unsigned count = regs.getEdx();
+		int err = SyscallTransfer(desc->getHostIndex(),
+				mem::Memory::AccessWrite, { { pbuf, count } });
+		if (err < 0)
 			throw misc::Panic("Unexpected error in host 'read'");
 
-		regs.setEax(count);
-		memory->Write(pbuf, count, buf.get());
+		regs.setEax(err);
 
 		emulator->syscall_debug << misc::fmt("[%s] Syscall 'read' - "
 				"continue\n",
@@ -394,11 +530,8 @@ bool Context::SyscallReadCanWakeup()
 		return true;
 	}
 
-	// Data is not ready. Launch host thread again
-	host_thread_suspend_active = true;
-	if (pthread_create(&host_thread_suspend, nullptr,
-			&Context::HostThreadSuspend, this))
-		throw misc::Panic("Could not launch host thread");
+	// Data is not ready. Wait for it.
+	WaitHostEvent(desc->getHostIndex(), EPOLLIN, 0);
 	return false;
 }
 
@@ -420,7 +553,6 @@ int Context::ExecuteSyscall_read()
 	emulator->syscall_debug << misc::fmt("  host_fd=%d\n", host_fd);
 
 	// Poll the file descriptor to check if read is blocking
-	auto buf = misc::new_unique_array<char>(count);
 	struct pollfd fds;
 	fds.fd = host_fd;
 	fds.events = POLLIN;
@@ -431,18 +563,12 @@ int Context::ExecuteSyscall_read()
 	// Non-blocking read
 	if (fds.revents || (desc->getFlags() & O_NONBLOCK))
 	{
-		// Host system call
-		err = read(host_fd, buf.get(), count);
-		if (err == -1)
-			return -errno;
-
-		// Write in guest memory
+		// Host system call, writing directly in guest memory
+		err = SyscallTransfer(host_fd, mem::Memory::AccessWrite,
+				{ { buf_ptr, count } });
 		if (err > 0)
-		{
-			memory->Write(buf_ptr, err, buf.get());
-			emulator->syscall_debug << misc::StringBinaryBuffer(buf.get(),
-					count, 40);
-		}
+			DumpBuffer(emulator->syscall_debug, memory.get(),
+					buf_ptr, err);
 
 		// Return number of read bytes
 		return err;
@@ -455,8 +581,8 @@ int Context::ExecuteSyscall_read()
 			StateRead);
 	emulator->ProcessEventsSchedule();
 
-	// Free allocated buffer. Return value doesn't matter,
-	// it will be overwritten when context wakes up from blocking call.
+	// Return value doesn't matter, it will be overwritten when context
+	// wakes up from blocking call.
 	return 0;
 }
 
@@ -473,10 +599,6 @@ void Context::SyscallWriteWakeup()
 
 bool Context::SyscallWriteCanWakeup()
 {
-	// If host thread is still running for this context, do nothing.
-	if (host_thread_suspend_active)
-		return false;
-
 	// Context received a signal
 	SignalSet pending_unblocked = signal_mask_table.getPending() &
 			~signal_mask_table.getBlocked();
@@ -506,15 +628,13 @@ bool Context::SyscallWriteCanWakeup()
 	if (host_fds.revents)
 	{
 		unsigned pbuf = regs.getEcx();
-		int count = regs.getEdx();
-		auto buf = misc::new_unique_array<char>(count);
-		
-		memory->Read(pbuf, count, buf.get());
-		count = write(desc->getHostIndex(), buf.get(), count);
-		if (count < 0)
+		unsigned count = regs.getEdx();
+		int err = SyscallTransfer(desc->getHostIndex(),
+				mem::Memory::AccessRead, { { pbuf, count } });
+		if (err < 0)
 			throw misc::Panic("Unexpected error in host 'write'");
 
-		regs.setEax(count);
+		regs.setEax(err);
 		emulator->syscall_debug << misc::fmt("[%s] Syscall write - "
 				"continue\n",
 				getName().c_str());
@@ -522,13 +642,8 @@ bool Context::SyscallWriteCanWakeup()
 		return true;
 	}
 
-	// Data is not ready to be written - launch host thread again
-	host_thread_suspend_active = true;
-	if (pthread_create(&host_thread_suspend, nullptr,
-			&Context::HostThreadSuspend, this))
-		throw misc::Panic("Could not create child thread");
-	
-	// Done
+	// Data is not ready to be written. Wait until it can be.
+	WaitHostEvent(desc->getHostIndex(), EPOLLOUT, 0);
 	return false;
 }
 
@@ -548,12 +663,8 @@ int Context::ExecuteSyscall_write()
 	int host_fd = desc->getHostIndex();
 	emulator->syscall_debug << misc::fmt("  host_fd=%d\n", host_fd);
 
-	// Read buffer from memory
-	auto buf = misc::new_unique_array<char>(count);
-	memory->Read(buf_ptr, count, buf.get());
-	emulator->syscall_debug << "  buf=\""
-			<< misc::StringBinaryBuffer(buf.get(), count, 40)
-			<< "\"\n";
+	// Dump buffer
+	DumpBuffer(emulator->syscall_debug, memory.get(), buf_ptr, count);
 
 	// Poll the file descriptor to check if write is blocking
 	struct pollfd fds;
@@ -564,13 +675,10 @@ int Context::ExecuteSyscall_write()
 	// Non-blocking write
 	if (fds.revents)
 	{
-		// Host write
-		int err = write(host_fd, buf.get(), count);
-		if (err == -1)
-			err = -errno;
-
-		// Return written bytes
-		return err;
+		// Host write, reading directly from guest memory. Return
+		// written bytes.
+		return SyscallTransfer(host_fd, mem::Memory::AccessRead,
+				{ { buf_ptr, count } });
 	}
 
 	// Blocking write - suspend thread
@@ -675,6 +783,19 @@ comm::FileDescriptor *Context::SyscallOpenVirtualDevice(const std::string &path,
 	return desc;		
 }
 
+
+// Make the guest pages mapped from the file at the given path stop using
+// the file, before it is truncated
+static void DetachMappedFile(const std::string &path)
+{
+	int fd = open(path.c_str(), O_PATH);
+	if (fd < 0)
+		return;
+	mem::Memory::DetachFile(fd);
+	close(fd);
+}
+
+
 int Context::ExecuteSyscall_open()
 {
 	// Arguments
@@ -721,7 +842,10 @@ int Context::ExecuteSyscall_open()
 		emulator->syscall_debug << "    warning: unhandled virtual file\n";
 	}
 
-	// Regular file.
+	// Regular file. Pages mapped from a file that is truncated must stop
+	// using the file first.
+	if (flags & O_TRUNC)
+		DetachMappedFile(full_path);
 	int host_fd = open(full_path.c_str(), flags, mode);
 	if (host_fd == -1)
 		return -errno;
@@ -1487,8 +1611,7 @@ int Context::ExecuteSyscall_kill()
 
 	// Send signal
 	context->signal_mask_table.getPending().Add(sig);
-	context->HostThreadSuspendCancel();
-	emulator->ProcessEventsSchedule();
+	context->CancelHostWait();
 	emulator->ProcessEvents();
 
 	// Success
@@ -2595,11 +2718,34 @@ int Context::SyscallMmapAux(unsigned addr, unsigned len,
 		unsigned last_pos = lseek(host_fd, 0, SEEK_CUR);
 		lseek(host_fd, offset, SEEK_SET);
 
-		// Read pages
+		// If enabled by the user, use a host mapping of the file as
+		// the content of the pages within the file size, instead of
+		// copying them. Pages past the end of the file, or all of them
+		// if the host cannot map the file, are read below.
 		assert(len_aligned % mem::Memory::PageSize == 0);
 		assert(addr % mem::Memory::PageSize == 0);
 		unsigned curr_addr = addr;
-		for (int size = len_aligned; size > 0; size -= mem::Memory::PageSize)
+		int size = len_aligned;
+		struct stat file_stat;
+		if (Emulator::getMapFiles() && !fstat(host_fd, &file_stat) &&
+				S_ISREG(file_stat.st_mode) &&
+				file_stat.st_size > offset)
+		{
+			long long file_size = file_stat.st_size - offset;
+			unsigned map_size = file_size < len_aligned ?
+					misc::RoundUp(file_size,
+					mem::Memory::PageSize) :
+					len_aligned;
+			if (memory->MapFile(addr, map_size, host_fd, offset))
+			{
+				curr_addr += map_size;
+				size -= map_size;
+				lseek(host_fd, offset + map_size, SEEK_SET);
+			}
+		}
+
+		// Read remaining pages
+		for (; size > 0; size -= mem::Memory::PageSize)
 		{
 			char buf[mem::Memory::PageSize];
 			memset(buf, 0, mem::Memory::PageSize);
@@ -2863,9 +3009,69 @@ int Context::ExecuteSyscall_syslog()
 // System call 'setitimer'
 //
 
+static const misc::StringMap itimer_which_map =
+{
+	{ "ITIMER_REAL",     0 },
+	{ "ITIMER_VIRTUAL",  1 },
+	{ "ITIMER_PROF",     2 }
+};
+
+// Write a guest 'struct itimerval' with the interval and remaining time of
+// an interval timer, given in microseconds.
+static void WriteItimerval(mem::Memory *memory, unsigned address,
+		long long interval, long long value)
+{
+	unsigned fields[4] =
+	{
+		(unsigned) (interval / 1000000),
+		(unsigned) (interval % 1000000),
+		(unsigned) (value / 1000000),
+		(unsigned) (value % 1000000)
+	};
+	memory->Write(address, sizeof fields, (char *) fields);
+}
+
 int Context::ExecuteSyscall_setitimer()
 {
-	__UNIMPLEMENTED__
+	// Arguments
+	int which = regs.getEbx();
+	unsigned value_ptr = regs.getEcx();
+	unsigned old_value_ptr = regs.getEdx();
+	emulator->syscall_debug << misc::fmt("  which=%d (%s), value_ptr=0x%x, "
+			"old_value_ptr=0x%x\n", which,
+			itimer_which_map.MapValue(which), value_ptr,
+			old_value_ptr);
+
+	// Check timer type
+	if (which < 0 || which > 2)
+		return -EINVAL;
+
+	// Get current time
+	esim::Engine *esim = esim::Engine::getInstance();
+	long long now = esim->getRealTime();
+
+	// Return old value
+	if (old_value_ptr)
+		WriteItimerval(memory.get(), old_value_ptr,
+				itimer_interval[which], itimer_value[which] ?
+				std::max(itimer_value[which] - now, 1LL) : 0);
+
+	// Read new value
+	unsigned fields[4];
+	memory->Read(value_ptr, sizeof fields, (char *) fields);
+	if (fields[1] >= 1000000 || fields[3] >= 1000000)
+		return -EINVAL;
+	long long interval = (long long) fields[0] * 1000000 + fields[1];
+	long long value = (long long) fields[2] * 1000000 + fields[3];
+	emulator->syscall_debug << misc::fmt("  interval=%lld us, "
+			"value=%lld us\n", interval, value);
+
+	// Arm or disarm timer. Virtual and profiling timers count real time
+	// as well.
+	itimer_interval[which] = value ? interval : 0;
+	itimer_value[which] = value ? now + value : 0;
+	emulator->getReactor()->setTimer(this, which, itimer_value[which]);
+	return 0;
 }
 
 
@@ -2877,7 +3083,23 @@ int Context::ExecuteSyscall_setitimer()
 
 int Context::ExecuteSyscall_getitimer()
 {
-	__UNIMPLEMENTED__
+	// Arguments
+	int which = regs.getEbx();
+	unsigned value_ptr = regs.getEcx();
+	emulator->syscall_debug << misc::fmt("  which=%d (%s), value_ptr=0x%x\n",
+			which, itimer_which_map.MapValue(which), value_ptr);
+
+	// Check timer type
+	if (which < 0 || which > 2)
+		return -EINVAL;
+
+	// Return remaining time
+	esim::Engine *esim = esim::Engine::getInstance();
+	long long now = esim->getRealTime();
+	WriteItimerval(memory.get(), value_ptr, itimer_interval[which],
+			itimer_value[which] ?
+			std::max(itimer_value[which] - now, 1LL) : 0);
+	return 0;
 }
 
 
@@ -3581,7 +3803,32 @@ int Context::ExecuteSyscall_msync()
 
 int Context::ExecuteSyscall_readv()
 {
-	__UNIMPLEMENTED__
+	// Arguments
+	int guest_fd = regs.getEbx();
+	unsigned iovec_ptr = regs.getEcx();
+	unsigned vlen = regs.getEdx();
+	emulator->syscall_debug << misc::fmt("  guest_fd=%d, iovec_ptr = 0x%x, vlen=0x%x\n",
+		guest_fd, iovec_ptr, vlen);
+
+	// Check file descriptor
+	comm::FileDescriptor *desc = file_table->getFileDescriptor(guest_fd);
+	if (!desc)
+		return -EBADF;
+	int host_fd = desc->getHostIndex();
+	emulator->syscall_debug << misc::fmt("  host_fd=%d\n", host_fd);
+
+	// No pipes allowed
+	if (desc->getType() == comm::FileDescriptor::TypePipe)
+		throw misc::Panic("readv: Unsupported for pipes");
+
+	// Read io vector
+	std::vector<std::pair<unsigned, unsigned>> buffers;
+	if (!SyscallReadIovecs(iovec_ptr, vlen, buffers))
+		return -EINVAL;
+
+	// Read all buffers from the file with one host call, writing directly
+	// in guest memory. Return total number of bytes read.
+	return SyscallTransfer(host_fd, mem::Memory::AccessWrite, buffers);
 }
 
 
@@ -3593,55 +3840,32 @@ int Context::ExecuteSyscall_readv()
 
 int Context::ExecuteSyscall_writev()
 {
-	int len;
-	unsigned iov_base;
-	unsigned iov_len;
-
-	// Arguments 
+	// Arguments
 	int guest_fd = regs.getEbx();
 	unsigned iovec_ptr = regs.getEcx();
 	unsigned vlen = regs.getEdx();
 	emulator->syscall_debug << misc::fmt("  guest_fd=%d, iovec_ptr = 0x%x, vlen=0x%x\n",
 		guest_fd, iovec_ptr, vlen);
 
-	// Check file descriptor 
+	// Check file descriptor
 	comm::FileDescriptor *desc = file_table->getFileDescriptor(guest_fd);
 	if (!desc)
 		return -EBADF;
 	int host_fd = desc->getHostIndex();
 	emulator->syscall_debug << misc::fmt("  host_fd=%d\n", host_fd);
 
-	// No pipes allowed 
+	// No pipes allowed
 	if (desc->getType() == comm::FileDescriptor::TypePipe)
 		throw misc::Panic("writev: Unsupported for pipes");
 
-	// Proceed 
-	int total_len = 0;
-	for (unsigned v = 0; v < vlen; v++)
-	{
-		// Read io vector element 
-		memory->Read(iovec_ptr, 4, (char *)&iov_base);
-		memory->Read(iovec_ptr + 4, 4, (char *)&iov_len);
-		iovec_ptr += 8;
-
-		// Read buffer from memory and write it to file 
-		char *buf = (char *)malloc(iov_len);
-		memory->Read(iov_base, iov_len, buf);
-		len = write(host_fd, buf, iov_len);
-		if (len == -1)
-		{
-			free(buf);
-			return -errno;
-		}
-
-		// Accumulate written bytes 
-		total_len += len;
-		free(buf);
-	}
-
-	// Return total number of bytes written 
-	return total_len;
+	// Read io vector
+	std::vector<std::pair<unsigned, unsigned>> buffers;
+	if (!SyscallReadIovecs(iovec_ptr, vlen, buffers))
+		return -EINVAL;
 
+	// Write all buffers to the file with one host call, reading directly
+	// from guest memory. Return total number of bytes written.
+	return SyscallTransfer(host_fd, mem::Memory::AccessRead, buffers);
 }
 
 
@@ -4044,10 +4268,6 @@ int Context::ExecuteSyscall_sched_rr_get_interval()
 
 bool Context::SyscallNanosleepCanWakeup()
 {
-	// If suspension thread is still running for this context, do nothing.
-	if (host_thread_suspend_active)
-		return false;
-
 	// Get current time
 	esim::Engine *esim = esim::Engine::getInstance();
 	long long now = esim->getRealTime();
@@ -4088,13 +4308,8 @@ bool Context::SyscallNanosleepCanWakeup()
 		return true;
 	}
 
-	// No event available, launch host thread again
-	host_thread_suspend_active = true;
-	if (pthread_create(&host_thread_suspend, nullptr,
-			&Context::HostThreadSuspend, this))
-		throw misc::Panic("Could not create child thread");
-	
-	// Done
+	// Sleep until the wakeup time
+	WaitHostEvent(-1, 0, syscall_nanosleep_wakeup_time);
 	return false;
 }
 
@@ -4275,10 +4490,6 @@ void Context::SyscallPollWakeup()
 
 bool Context::SyscallPollCanWakeup()
 {
-	// If host thread is still running for this context, do nothing.
-	if (host_thread_suspend_active)
-		return false;
-
 	// Current time
 	esim::Engine *esim = esim::Engine::getInstance();
 	long long now = esim->getRealTime();
@@ -4355,13 +4566,11 @@ bool Context::SyscallPollCanWakeup()
 		return true;
 	}
 
-	// No event available, launch host thread again
-	host_thread_suspend_active = true;
-	if (pthread_create(&host_thread_suspend, nullptr,
-			&Context::HostThreadSuspend, this))
-		throw misc::Panic("Could not launch host thread");
-	
-	// Done
+	// No event available. Wait for an event or the timeout.
+	WaitHostEvent(desc->getHostIndex(),
+			((syscall_poll_events & 4) ? (unsigned) EPOLLOUT : 0u) |
+			((syscall_poll_events & 1) ? (unsigned) EPOLLIN : 0u),
+			syscall_poll_time);
 	return false;
 }
 
@@ -4769,7 +4978,35 @@ int Context::ExecuteSyscall_rt_sigsuspend()
 
 int Context::ExecuteSyscall_pread64()
 {
-	__UNIMPLEMENTED__
+	// Arguments
+	int guest_fd = regs.getEbx();
+	unsigned buf_ptr = regs.getEcx();
+	unsigned count = regs.getEdx();
+	long long offset = (unsigned long long) regs.getEdi() << 32 |
+			regs.getEsi();
+	emulator->syscall_debug << misc::fmt("  guest_fd=%d, "
+			"buf_ptr=0x%x, count=0x%x, offset=0x%llx\n",
+			guest_fd, buf_ptr, count, offset);
+
+	// Get file descriptor
+	comm::FileDescriptor *desc = file_table->getFileDescriptor(guest_fd);
+	if (!desc)
+		return -EBADF;
+	int host_fd = desc->getHostIndex();
+	emulator->syscall_debug << misc::fmt("  host_fd=%d\n", host_fd);
+
+	// Check offset
+	if (offset < 0)
+		return -EINVAL;
+
+	// Host call at the given offset, writing directly in guest memory.
+	// Return number of read bytes.
+	int err = SyscallTransfer(host_fd, mem::Memory::AccessWrite,
+			{ { buf_ptr, count } }, offset);
+	if (err > 0)
+		DumpBuffer(emulator->syscall_debug, memory.get(),
+				buf_ptr, err);
+	return err;
 }
 
 
@@ -4781,7 +5018,32 @@ int Context::ExecuteSyscall_pread64()
 
 int Context::ExecuteSyscall_pwrite64()
 {
-	__UNIMPLEMENTED__
+	// Arguments
+	int guest_fd = regs.getEbx();
+	unsigned buf_ptr = regs.getEcx();
+	unsigned count = regs.getEdx();
+	long long offset = (unsigned long long) regs.getEdi() << 32 |
+			regs.getEsi();
+	emulator->syscall_debug << misc::fmt("  guest_fd=%d, "
+			"buf_ptr=0x%x, count=0x%x, offset=0x%llx\n",
+			guest_fd, buf_ptr, count, offset);
+
+	// Get file descriptor
+	comm::FileDescriptor *desc = file_table->getFileDescriptor(guest_fd);
+	if (!desc)
+		return -EBADF;
+	int host_fd = desc->getHostIndex();
+	emulator->syscall_debug << misc::fmt("  host_fd=%d\n", host_fd);
+
+	// Check offset
+	if (offset < 0)
+		return -EINVAL;
+
+	// Host call at the given offset, reading directly from guest memory.
+	// Return number of written bytes.
+	DumpBuffer(emulator->syscall_debug, memory.get(), buf_ptr, count);
+	return SyscallTransfer(host_fd, mem::Memory::AccessRead,
+			{ { buf_ptr, count } }, offset);
 }
 
 
@@ -5022,7 +5284,8 @@ int Context::ExecuteSyscall_ftruncate64()
 	int host_fd = file_table->getHostIndex(fd);
 	emulator->syscall_debug << misc::fmt("  host_fd=%d\n", host_fd);
 
-	// Host call
+	// Host call. Pages mapped from the file must stop using it first.
+	mem::Memory::DetachFile(host_fd);
 	int err = ftruncate(host_fd, length);
 	if (err == -1)
 		return -errno;
@@ -6719,8 +6982,7 @@ int Context::ExecuteSyscall_tgkill()
 
 	// Send signal
 	context->signal_mask_table.getPending().Add(sig);
-	context->HostThreadSuspendCancel();
-	emulator->ProcessEventsSchedule();
+	context->CancelHostWait();
 	emulator->ProcessEvents();
 	return 0;
 }
@@ -7076,7 +7338,10 @@ int Context::ExecuteSyscall_openat()
 	if (misc::StringPrefix(full_path, "/proc/"))
 		throw misc::Panic("Virtual files are not supported");
 
-	// Regular file.
+	// Regular file. Pages mapped from a file that is truncated must stop
+	// using the file first.
+	if (flags & O_TRUNC)
+		DetachMappedFile(full_path);
 	int host_fd = open(full_path.c_str(), flags, mode);
 	if (host_fd == -1)
 		return -errno;
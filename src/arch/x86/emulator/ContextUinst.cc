@@ -92,8 +92,7 @@ void Context::EmitUinstEffectiveAddress(Uinst *uinst, int index)
 	uinst_effaddr_emitted = true;
 
 	// Create micro-instruction
-	uinsts.emplace_back(misc::new_unique<Uinst>(Uinst::OpcodeEffaddr));
-	Uinst *new_uinst = uinsts.back().get();
+	Uinst *new_uinst = AddUinst(Uinst(Uinst::OpcodeEffaddr));
 	
 	// Emit micro-instruction
 	new_uinst->setIDep(0, inst.getSegment() ?
@@ -246,8 +245,7 @@ void Context::ParseUinstIDep(Uinst *uinst, int index)
 		}
 
 		// Load
-		uinsts.emplace_back(misc::new_unique<Uinst>(Uinst::OpcodeLoad));
-		Uinst *new_uinst = uinsts.back().get();
+		Uinst *new_uinst = AddUinst(Uinst(Uinst::OpcodeLoad));
 		new_uinst->setIDep(0, Uinst::DepEa);
 		new_uinst->setODep(0, mem_std_dep);
 		new_uinst->setMemoryAccess(last_effective_address, mem_dep_size);
@@ -292,8 +290,7 @@ void Context::ParseUinstODep(Uinst *uinst, int index)
 		}
 
 		// Store
-		uinsts.emplace_back(misc::new_unique<Uinst>(Uinst::OpcodeStore));
-		Uinst *new_uinst = uinsts.back().get();
+		Uinst *new_uinst = AddUinst(Uinst(Uinst::OpcodeStore));
 		new_uinst->setIDep(0, Uinst::DepEa);
 		new_uinst->setIDep(1, mem_std_dep);
 		new_uinst->setMemoryAccess(last_effective_address, mem_dep_size);
@@ -325,33 +322,34 @@ void Context::newMemoryUinst(
 	if (!uinst_active)
 		return;
 
-	// Create micro-instruction
-	auto uinst = misc::new_shared<Uinst>(opcode);
+	// Create micro-instruction. It is added to the list after the
+	// micro-instructions that compute its inputs.
+	Uinst uinst(opcode);
 
 	// Initialize
-	uinst->setMemoryAccess(address, size);
-	uinst->setIDep(0, idep0);
-	uinst->setIDep(1, idep1);
-	uinst->setIDep(2, idep2);
-	uinst->setODep(0, odep0);
-	uinst->setODep(1, odep1);
-	uinst->setODep(2, odep2);
-	uinst->setODep(3, odep3);
+	uinst.setMemoryAccess(address, size);
+	uinst.setIDep(0, idep0);
+	uinst.setIDep(1, idep1);
+	uinst.setIDep(2, idep2);
+	uinst.setODep(0, odep0);
+	uinst.setODep(1, odep1);
+	uinst.setODep(2, odep2);
+	uinst.setODep(3, odep3);
 
 	// Emit effective address computation if needed.
 	for (int i = 0; !uinst_effaddr_emitted && i < Uinst::MaxDeps; i++)
-		EmitUinstEffectiveAddress(uinst.get(), i);
+		EmitUinstEffectiveAddress(&uinst, i);
 	
 	// Parse input dependences
 	for (int i = 0; i < Uinst::MaxIDeps; i++)
-		ParseUinstIDep(uinst.get(), i);
+		ParseUinstIDep(&uinst, i);
 	
 	// Add micro-instruction to list
-	uinsts.emplace_back(uinst);
+	Uinst *new_uinst = AddUinst(uinst);
 	
 	// Parse output dependences
 	for (int i = 0; i < Uinst::MaxODeps; i++)
-		ParseUinstODep(uinst.get(), i);
+		ParseUinstODep(new_uinst, i);
 }
 
 }
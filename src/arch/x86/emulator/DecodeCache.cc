@@ -0,0 +1,65 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <lib/cpp/Misc.h>
+
+#include "DecodeCache.h"
+
+
+namespace x86
+{
+
+
+void DecodeCache::Flush()
+{
+	blocks.clear();
+	code_version = memory->getCodeVersion();
+	generation++;
+	num_flushes++;
+}
+
+
+DecodeCache::Block *DecodeCache::newBlock(unsigned address)
+{
+	auto result = blocks.emplace(address,
+			misc::new_unique<Block>(address));
+	assert(result.second);
+	num_blocks++;
+	return result.first->second.get();
+}
+
+
+bool DecodeCache::AddInstruction(Block *block, const Instruction &instruction)
+{
+	// Watch the instruction bytes. Watching pages does not change the
+	// code version, so the cache remains valid.
+	assert(instruction.getEip() == block->end);
+	if (!memory->WatchCode(instruction.getEip(), instruction.getSize()))
+		return false;
+
+	// Add instruction
+	block->instructions.push_back(instruction);
+	block->end += instruction.getSize();
+	num_instructions++;
+	return true;
+}
+
+
+}  // namespace x86
+
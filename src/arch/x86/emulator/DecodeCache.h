@@ -0,0 +1,135 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_EMULATOR_DECODE_CACHE_H
+#define ARCH_X86_EMULATOR_DECODE_CACHE_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <arch/x86/disassembler/Instruction.h>
+#include <memory/Memory.h>
+
+
+namespace x86
+{
+
+/// Cache of decoded instructions for one memory image, shared by all contexts
+/// running on it. Instructions are grouped in basic blocks, each formed by the
+/// instructions executed sequentially starting at a given address. The pages
+/// containing cached instructions are watched for changes in the memory
+/// object, and the whole cache is flushed when any of them is written,
+/// unmapped, or has its permissions changed.
+class DecodeCache
+{
+public:
+
+	/// Sequence of consecutive decoded instructions
+	struct Block
+	{
+		/// Address of the first instruction
+		unsigned address;
+
+		/// Address following the last instruction
+		unsigned end;
+
+		/// Decoded instructions
+		std::vector<Instruction> instructions;
+
+		/// Constructor
+		Block(unsigned address) : address(address), end(address) { }
+	};
+
+private:
+
+	// Memory image containing the instructions
+	mem::Memory *memory;
+
+	// Code version of the memory image when the cache was last flushed
+	long long code_version;
+
+	// Number of times the cache was flushed
+	long long generation = 0;
+
+	// Blocks indexed by the address of their first instruction
+	std::unordered_map<unsigned, std::unique_ptr<Block>> blocks;
+
+	// Statistics
+	long long num_blocks = 0;
+	long long num_instructions = 0;
+	long long num_flushes = 0;
+
+public:
+
+	/// Create an empty cache for instructions in \a memory
+	DecodeCache(mem::Memory *memory) :
+			memory(memory),
+			code_version(memory->getCodeVersion())
+	{
+	}
+
+	/// Flush the cache if any watched page of the memory image changed
+	/// since the last call. This function must be invoked before looking
+	/// up instructions, and block pointers obtained before a change in
+	/// the value returned by getGeneration() must be discarded.
+	void Validate()
+	{
+		if (memory->getCodeVersion() != code_version)
+			Flush();
+	}
+
+	/// Discard all blocks
+	void Flush();
+
+	/// Return a number incremented every time the cache is flushed
+	long long getGeneration() const { return generation; }
+
+	/// Return the block starting at \a address, or null if none
+	Block *getBlock(unsigned address)
+	{
+		auto it = blocks.find(address);
+		return it == blocks.end() ? nullptr : it->second.get();
+	}
+
+	/// Create an empty block starting at \a address. No block must exist
+	/// for that address.
+	Block *newBlock(unsigned address);
+
+	/// Append a decoded instruction at the end of a block. The
+	/// instruction must start at the address returned by \a block->end.
+	/// Pages containing the instruction are watched for changes. If any
+	/// of them is not allocated, the instruction is not added, and the
+	/// function returns false.
+	bool AddInstruction(Block *block, const Instruction &instruction);
+
+	/// Return the number of blocks created
+	long long getNumBlocks() const { return num_blocks; }
+
+	/// Return the number of instructions decoded into the cache
+	long long getNumInstructions() const { return num_instructions; }
+
+	/// Return the number of flushes
+	long long getNumFlushes() const { return num_flushes; }
+};
+
+
+}  // namespace x86
+
+#endif
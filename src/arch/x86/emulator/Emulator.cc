@@ -17,8 +17,12 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+
 #include <arch/x86/disassembler/Disassembler.h>
+#include <lib/cpp/Checkpoint.h>
 #include <lib/esim/Engine.h>
+#include <memory/PageArena.h>
 
 #include "Context.h"
 #include "Emulator.h"
@@ -35,6 +39,21 @@ std::string Emulator::syscall_debug_file;
 
 long long Emulator::max_instructions;
 
+long long Emulator::bbv_interval;
+std::string Emulator::bbv_file;
+
+int Emulator::num_threads = 1;
+long long Emulator::quantum = 10000;
+bool Emulator::map_files = false;
+
+const char *Emulator::single_group_error =
+	"Contexts sharing a memory image, such as the threads of one process, "
+	"always run on the same host thread, since guest atomic instructions, "
+	"the software TLB, and the decode cache are not thread-safe. Only "
+	"contexts of different processes run in parallel, so a guest made of "
+	"a single multi-threaded process is not accelerated by option "
+	"--x86-threads.\n";
+
 std::unique_ptr<Emulator> Emulator::instance;
 
 misc::Debug Emulator::call_debug;
@@ -91,6 +110,58 @@ void Emulator::RegisterOptions()
 			"instructions. On x86 detailed simulation, it is given as "
 			"the number of committed (non-speculative) instructions. "
 			"A value of 0 means no limit.");
+
+	// Option --x86-bbv <interval> <file>
+	command_line->RegisterInt64String("--x86-bbv <interval> <file>",
+			bbv_interval,
+			bbv_file,
+			"Profile the basic blocks executed by each x86 context "
+			"for SimPoint. For a context with identifier <pid>, the "
+			"number of instructions executed in each basic block is "
+			"dumped every <interval> instructions into file "
+			"'<file>.<pid>.bb'. When the context finishes, its "
+			"intervals are clustered, and the chosen simulation "
+			"points and their weights are dumped into files "
+			"'<file>.<pid>.simpoints' and '<file>.<pid>.weights'.");
+
+	// Option --x86-threads <num>
+	command_line->RegisterInt32("--x86-threads <num> (default = 1)",
+			num_threads,
+			"Number of host threads used for x86 functional "
+			"simulation. With more than one thread, contexts with "
+			"different memory images (i.e., processes created with "
+			"fork) run in parallel for a quantum of instructions "
+			"(see --x86-quantum), and synchronize at every system "
+			"call. Only guests made of several processes benefit "
+			"from this option: the threads of one process share a "
+			"memory image, and always run on the same host thread, "
+			"since guest atomic instructions, the software TLB, "
+			"and the decode cache are not thread-safe. The result "
+			"of the simulation only depends on the quantum, and "
+			"not on the number of threads.");
+
+	// Option --x86-quantum <num>
+	command_line->RegisterInt64("--x86-quantum <num> (default = 10000)",
+			quantum,
+			"Maximum number of instructions that each context runs "
+			"in parallel with other contexts before synchronizing, "
+			"when more than one host thread is used for x86 "
+			"functional simulation (see --x86-threads). Signals are "
+			"delivered at the end of a quantum.");
+
+	// Option --x86-map-files
+	command_line->RegisterBool("--x86-map-files",
+			map_files,
+			"Use private host mappings of the files mapped by the "
+			"guest program with 'mmap', instead of copying their "
+			"content into guest memory when they are mapped. This "
+			"saves time and host memory for large files, but pages "
+			"not written by the guest keep reading the file. Guest "
+			"memory then reflects later changes made to the file "
+			"by other host processes, and the simulator crashes "
+			"with SIGBUS if another host process truncates it. "
+			"Only use this option for files that do not change "
+			"while the simulation runs.");
 }
 
 
@@ -102,6 +173,33 @@ void Emulator::ProcessOptions()
 	isa_debug.setPath(isa_debug_file);
 	loader_debug.setPath(loader_debug_file);
 	syscall_debug.setPath(syscall_debug_file);
+
+	// Basic block vector profiling
+	if (!bbv_file.empty() && bbv_interval < 1)
+		throw Error("Option '--x86-bbv': the interval must be a "
+				"positive number of instructions");
+
+	// Parallel emulation
+	if (num_threads < 1)
+		throw Error("Option '--x86-threads': the number of threads "
+				"must be at least 1");
+	if (quantum < 1)
+		throw Error("Option '--x86-quantum': the quantum must be a "
+				"positive number of instructions");
+}
+
+
+Emulator::~Emulator()
+{
+	// Stop worker threads
+	worker_mutex.lock();
+	stop_workers = true;
+	worker_mutex.unlock();
+	quantum_start.notify_all();
+	for (auto &worker : workers)
+		worker.join();
+	if (workers.size())
+		mem::PageArena::setConcurrent(false);
 }
 
 
@@ -287,6 +385,11 @@ void Emulator::FreeContext(Context *context)
 	UpdateSuspendedContexts(context, false);
 	UpdateFinishedContexts(context, false);
 	UpdateZombieContexts(context, false);
+
+	// Remove from host event waits
+	reactor.Remove(context);
+	woken_contexts.erase(std::remove(woken_contexts.begin(),
+			woken_contexts.end(), context), woken_contexts.end());
 	
 	// Remove from main context list. This will invoke the context
 	// destructor and free it.
@@ -301,126 +404,172 @@ void Emulator::ProcessEventsSchedule()
 	UnlockMutex();
 }
 
+bool Emulator::isProcessEventsScheduled()
+{
+	LockMutex();
+	bool scheduled = process_events_force;
+	UnlockMutex();
+	return scheduled;
+}
+
+void Emulator::PollHostEvents(bool block)
+{
+	// Poll reactor
+	std::vector<std::pair<Context *, int>> expired_timers;
+	reactor.Poll(block, woken_contexts, expired_timers);
+
+	// Expired interval timers send signals
+	for (auto &timer : expired_timers)
+		timer.first->ExpireTimer(timer.second);
+}
+
+
+bool Emulator::WaitForHostEvents()
+{
+	// Contexts can make progress without host events
+	if (!running_contexts.empty() || isProcessEventsScheduled())
+		return false;
+
+	// Contexts suspended without a wakeup call-back are woken up by other
+	// architectures
+	for (Context *context : suspended_contexts)
+		if (!context->getState(Context::StateCallback) &&
+				!reactor.isWaiting(context))
+			return false;
+
+	// Block until a host event occurs
+	PollHostEvents(true);
+	return true;
+}
+
+
 void Emulator::ProcessEvents()
 {
+	// Collect host events
+	PollHostEvents(false);
+
 	// Check if events need actually be checked.
 	LockMutex();
-	if (!process_events_force)
+	if (!process_events_force && woken_contexts.empty())
 	{
 		UnlockMutex();
 		return;
 	}
 	
 	// By default, no subsequent call to ProcessEvents() is assumed
+	bool force = process_events_force;
 	process_events_force = false;
 	
 	
 	//
 	// LOOP 1
-	// Look at the list of suspended contexts and try to find
-	// one that needs to be waken up.
+	// Check the contexts whose host events occurred. If events were
+	// scheduled, look at the whole list of suspended contexts instead
+	// and try to find one that needs to be waken up.
 	//
-	auto iterator_next = suspended_contexts.end();
-	for (auto iterator = suspended_contexts.begin();
-			iterator != suspended_contexts.end();
-			iterator = iterator_next)
+	std::vector<Context *> contexts;
+	contexts.swap(woken_contexts);
+	if (force)
 	{
-		// Save iterator to next element here, since the context can be
-		// removed from the suspended list if waken up.
-		iterator_next = iterator;
-		++iterator_next;
-		Context *context = *iterator;
-		assert(context->getState(Context::StateSuspended));
-		assert(context->suspended_contexts_iterator == iterator);
-		assert(context->in_suspended_contexts);
-
-		// Context suspended in a system call using a custom wake up
-		// check call-back function. NOTE: this is a new mechanism. It'd
-		// be nice if all other system calls started using it. It is
-		// nicer, since it allows for a check of wake up conditions
-		// together with the system call itself, without having
-		// distributed code for the implementation of a system call
-		// (e.g. 'read').
-		if (context->getState(Context::StateCallback) &&
-				context->CanWakeup())
+		for (Context *context : suspended_contexts)
 		{
-			context->Wakeup();
-			continue;
+			assert(context->getState(Context::StateSuspended));
+			assert(context->in_suspended_contexts);
+			contexts.push_back(context);
 		}
 	}
-
-
-#if 0
-	/*
-	 * LOOP 2
-	 * Check list of all contexts for expired timers.
-	 */
-	for (context = self->context_list_head; context; context = context->context_list_next)
+	for (Context *context : contexts)
 	{
-		int sig[3] = { 14, 26, 27 };  // SIGALRM, SIGVTALRM, SIGPROF
-		int i;
-
-		// If there is already a 'ke_host_thread_timer' running, do nothing.
-		if (context->host_thread_timer_active)
-			continue;
-
-		/* Check for any expired 'itimer': itimer_value < now
-		 * In this case, send corresponding signal to process.
-		 * Then calculate next 'itimer' occurrence: itimer_value = now + itimer_interval */
-		for (i = 0; i < 3; i++ )
-		{
-			// Timer inactive or not expired yet
-			if (!context->itimer_value[i] || context->itimer_value[i] > now)
-				continue;
-
-			/* Timer expired - send a signal.
-			 * The target process might be suspended, so the host thread is canceled, and a new
-			 * call to 'X86EmuProcessEvents' is scheduled. Since 'ke_process_events_mutex' is
-			 * already locked, the thread-unsafe version of 'x86_ctx_host_thread_suspend_cancel' is used. */
-			X86ContextHostThreadSuspendCancelUnsafe(context);
-			self->process_events_force = 1;
-			x86_sigset_add(&context->signal_mask_table->pending, sig[i]);
-
-			// Calculate next occurrence
-			context->itimer_value[i] = 0;
-			if (context->itimer_interval[i])
-				context->itimer_value[i] = now + context->itimer_interval[i];
-		}
-
-		// Calculate the time when next wakeup occurs.
-		context->host_thread_timer_wakeup = 0;
-		for (i = 0; i < 3; i++)
-		{
-			if (!context->itimer_value[i])
-				continue;
-			assert(context->itimer_value[i] >= now);
-			if (!context->host_thread_timer_wakeup || context->itimer_value[i] < context->host_thread_timer_wakeup)
-				context->host_thread_timer_wakeup = context->itimer_value[i];
-		}
-
-		// If a new timer was set, launch ke_host_thread_timer' again
-		if (context->host_thread_timer_wakeup)
+		// Context suspended in a system call using a custom wake up
+		// check call-back function. Contexts waiting for host events
+		// are not checked until the events occur. NOTE: this is a new
+		// mechanism. It'd be nice if all other system calls started
+		// using it. It is nicer, since it allows for a check of wake up
+		// conditions together with the system call itself, without
+		// having distributed code for the implementation of a system
+		// call (e.g. 'read').
+		if (context->getState(Context::StateSuspended) &&
+				context->getState(Context::StateCallback) &&
+				!context->isWaitingHostEvent() &&
+				context->CanWakeup())
 		{
-			context->host_thread_timer_active = 1;
-			if (pthread_create(&context->host_thread_timer, NULL, X86ContextHostThreadTimer, context))
-				fatal("%s: could not create child thread", __FUNCTION__);
+			context->Wakeup();
+			if (!force)
+				context->CheckSignalHandler();
 		}
 	}
 
 
-#endif
 	//
-	// LOOP 3
+	// LOOP 2
 	// Process pending signals in running contexts to launch signal handlers
 	//
-	for (Context *context : running_contexts)
-		context->CheckSignalHandler();
+	if (force)
+		for (Context *context : running_contexts)
+			context->CheckSignalHandler();
 	
 	// Unlock
 	UnlockMutex();
 }
 
 
+bool Emulator::canSaveCheckpoint() const
+{
+	for (auto &context : contexts)
+		if (!context->canSaveCheckpoint())
+			return false;
+	return true;
+}
+
+
+void Emulator::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	// Contexts are saved in creation order, so that parents are restored
+	// before their children.
+	writer.WriteSection("x86::Emulator");
+	writer.WriteValue(futex_sleep_count);
+	writer.WriteValue<unsigned>(contexts.size());
+	Context::CheckpointObjects objects;
+	for (auto &context : contexts)
+		context->SaveCheckpoint(writer, objects);
+}
+
+
+void Emulator::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	// Check no contexts
+	if (contexts.size())
+		throw misc::Panic("Checkpoint loaded after creating contexts");
+
+	// Load contexts
+	reader.ReadSection("x86::Emulator");
+	reader.ReadValue(futex_sleep_count);
+	unsigned num_contexts = reader.ReadValue<unsigned>();
+	Context::CheckpointObjects objects;
+	for (unsigned i = 0; i < num_contexts; i++)
+	{
+		Context *context = newContext();
+		context->LoadCheckpoint(reader, objects);
+	}
+}
+
+
+void Emulator::DumpSummary(std::ostream &os) const
+{
+	// Common statistics
+	comm::Emulator::DumpSummary(os);
+
+	// Copy-on-write memory pages
+	if (mem::Memory::getNumSharedPages())
+	{
+		os << misc::fmt("SharedPages = %lld\n",
+				mem::Memory::getNumSharedPages());
+		os << misc::fmt("CopiedPages = %lld\n",
+				mem::Memory::getNumCopiedPages());
+	}
+}
+
+
 bool Emulator::Run()
 {
 	// Stop if there is no more contexts
@@ -435,9 +584,14 @@ bool Emulator::Run()
 	if (esim->hasFinished())
 		return true;
 
+	// Run a quantum of instructions of all contexts in parallel
+	if (num_threads > 1)
+		RunParallel();
+
 	// Run an instruction from every running context. During execution, a
 	// context can remove itself from the running list, so traversing the
-	// running list is not an option.
+	// running list is not an option. After a parallel quantum, this runs
+	// the system calls that stopped contexts.
 	for (auto &context : contexts)
 	{
 		// Skip if not running
@@ -459,5 +613,167 @@ bool Emulator::Run()
 	return true;
 }
 
-} // namespace x86
 
+bool Emulator::RunParallel()
+{
+	// Debug information is dumped in the order in which instructions run
+	if (isa_debug || call_debug)
+		return false;
+
+	// Group running contexts by memory image
+	groups.clear();
+	int num_running_contexts = 0;
+	for (auto &context : contexts)
+	{
+		// Skip if not running
+		if (!context->getState(Context::StateRunning))
+			continue;
+
+		// Find group
+		mem::Memory *memory = context->getMemory();
+		auto it = std::find_if(groups.begin(), groups.end(),
+				[memory](const Group &group)
+				{
+					return group.memory == memory;
+				});
+		if (it == groups.end())
+			it = groups.emplace(groups.end(), memory);
+		it->contexts.push_back(context.get());
+		num_running_contexts++;
+	}
+	if (groups.empty())
+		return false;
+
+	// Threads of one process share a memory image, and run on the same
+	// host thread
+	if (groups.size() == 1 && num_running_contexts > 1 &&
+			!single_group_warning)
+	{
+		misc::Warning("%d host threads requested for x86 emulation, "
+				"but all %d running contexts share one memory "
+				"image\n\n%s",
+				num_threads, num_running_contexts,
+				single_group_error);
+		single_group_warning = true;
+	}
+
+	// Do not exceed the maximum number of instructions
+	group_quantum = quantum;
+	if (max_instructions)
+		group_quantum = std::min(group_quantum, std::max(1LL,
+				(max_instructions - num_instructions) /
+				num_running_contexts));
+
+	// Start worker threads
+	if (workers.empty())
+	{
+		mem::PageArena::setConcurrent(true);
+		for (int i = 1; i < num_threads; i++)
+			workers.emplace_back(&Emulator::WorkerLoop, this);
+	}
+
+	// Run groups. The main thread takes part in the quantum, and waits
+	// for all worker threads to finish it.
+	if (groups.size() == 1)
+	{
+		RunGroup(&groups[0]);
+	}
+	else
+	{
+		next_group.store(0, std::memory_order_relaxed);
+		worker_mutex.lock();
+		num_finished_workers = 0;
+		quantum_generation++;
+		worker_mutex.unlock();
+		quantum_start.notify_all();
+		RunGroups();
+		std::unique_lock<std::mutex> lock(worker_mutex);
+		quantum_end.wait(lock, [this]
+				{
+					return num_finished_workers ==
+							(int) workers.size();
+				});
+	}
+
+	// Propagate exceptions thrown by contexts, and count instructions
+	for (Group &group : groups)
+	{
+		if (group.exception)
+			std::rethrow_exception(group.exception);
+		incNumInstructions(group.num_instructions);
+	}
+	return true;
+}
+
+
+void Emulator::RunGroups()
+{
+	while (true)
+	{
+		int index = next_group.fetch_add(1, std::memory_order_relaxed);
+		if (index >= (int) groups.size())
+			break;
+		RunGroup(&groups[index]);
+	}
+}
+
+
+void Emulator::WorkerLoop()
+{
+	long long generation = 0;
+	while (true)
+	{
+		// Sleep until a new quantum starts. Worker threads do not use
+		// host cores while the main thread runs system calls and other
+		// sequential work.
+		std::unique_lock<std::mutex> lock(worker_mutex);
+		quantum_start.wait(lock, [this, generation]
+				{
+					return stop_workers ||
+							quantum_generation !=
+							generation;
+				});
+		if (stop_workers)
+			return;
+		generation = quantum_generation;
+		lock.unlock();
+
+		// Run groups
+		RunGroups();
+
+		// Wake up the main thread after the last worker
+		lock.lock();
+		if (++num_finished_workers == (int) workers.size())
+			quantum_end.notify_one();
+	}
+}
+
+
+void Emulator::RunGroup(Group *group)
+{
+	try
+	{
+		for (long long i = 0; i < group_quantum; i++)
+		{
+			// Run one instruction of every context, and stop when
+			// all contexts reached a system call
+			bool executed = false;
+			for (Context *context : group->contexts)
+			{
+				if (context->ExecuteParallel())
+				{
+					group->num_instructions++;
+					executed = true;
+				}
+			}
+			if (!executed)
+				break;
+		}
+	}
+	catch (...)
+	{
+		group->exception = std::current_exception();
+	}
+}
+
+} // namespace x86
@@ -20,7 +20,13 @@
 #ifndef ARCH_X86_EMULATOR_EMULATOR_H
 #define ARCH_X86_EMULATOR_EMULATOR_H
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <pthread.h>
+#include <thread>
+#include <vector>
 
 #include <arch/common/Arch.h>
 #include <arch/common/Emulator.h>
@@ -29,6 +35,7 @@
 #include <lib/cpp/Error.h>
 
 #include "Context.h"
+#include "Reactor.h"
 
 
 namespace x86
@@ -68,6 +75,25 @@ class Emulator : public comm::Emulator
 	// Maximum number of instructions
 	static long long max_instructions;
 
+	// Basic block vector profiling
+	static long long bbv_interval;
+	static std::string bbv_file;
+
+	// Number of host threads used for functional emulation
+	static int num_threads;
+
+	// Number of instructions run by each context between synchronization
+	// points of the parallel emulator
+	static long long quantum;
+
+	// Use host mappings of the files mapped by guest programs, instead of
+	// copying their content
+	static bool map_files;
+
+	// Message shown when all running contexts share one memory image in
+	// the parallel emulator
+	static const char *single_group_error;
+
 	// Unique instance of singleton
 	static std::unique_ptr<Emulator> instance;
 
@@ -110,6 +136,90 @@ class Emulator : public comm::Emulator
 	// for FIFO wakeups.
 	long long futex_sleep_count = 0;
 
+	// Host events that suspended contexts wait for
+	Reactor reactor;
+
+	// Contexts whose wait for host events ended, and whose wakeup
+	// condition must be checked in the next call to ProcessEvents()
+	std::vector<Context *> woken_contexts;
+
+	// Collect host events from the reactor, expiring interval timers and
+	// adding contexts to 'woken_contexts'. If 'block' is true, wait until
+	// an event occurs.
+	void PollHostEvents(bool block);
+
+	// Running contexts sharing one memory image, which are run by the
+	// same host thread in the parallel emulator
+	struct Group
+	{
+		// Memory image of the contexts
+		mem::Memory *memory;
+
+		// Contexts in the group, in the order of the context list
+		std::vector<Context *> contexts;
+
+		// Number of instructions run in the current quantum
+		long long num_instructions = 0;
+
+		// Exception thrown by a context of the group
+		std::exception_ptr exception;
+
+		// Constructor
+		Group(mem::Memory *memory) : memory(memory) { }
+	};
+
+	// Groups of the current quantum, in the order in which their first
+	// context appears in the context list
+	std::vector<Group> groups;
+
+	// Maximum number of instructions run by each context of a group in
+	// the current quantum
+	long long group_quantum = 0;
+
+	// Worker threads of the parallel emulator
+	std::vector<std::thread> workers;
+
+	// Mutex protecting 'quantum_generation', 'num_finished_workers', and
+	// 'stop_workers'. Worker threads sleep on 'quantum_start' between
+	// quanta, and the main thread sleeps on 'quantum_end' until all
+	// worker threads finished the current quantum.
+	std::mutex worker_mutex;
+	std::condition_variable quantum_start;
+	std::condition_variable quantum_end;
+
+	// Incremented by the main thread to start a new quantum
+	long long quantum_generation = 0;
+
+	// Number of worker threads that finished the current quantum
+	int num_finished_workers = 0;
+
+	// Set to make worker threads exit
+	bool stop_workers = false;
+
+	// Index in 'groups' of the next group to run in the quantum
+	std::atomic<int> next_group{0};
+
+	// Whether the parallel emulator already warned that all running
+	// contexts share one memory image
+	bool single_group_warning = false;
+
+	// Run a quantum of instructions of all running contexts on host
+	// worker threads, one group of contexts at a time per thread. Return
+	// false if the quantum cannot run in parallel, e.g., because
+	// instructions are being traced.
+	bool RunParallel();
+
+	// Run groups of the current quantum until none is left
+	void RunGroups();
+
+	// Main function of worker threads
+	void WorkerLoop();
+
+	// Run a quantum of instructions of the contexts of a group,
+	// interleaving one instruction of each context at a time. A context
+	// stops when it reaches a system call.
+	void RunGroup(Group *group);
+
 
 public:
 
@@ -132,6 +242,29 @@ public:
 	/// Return the maximum number of instructions, as set up by the user
 	static long long getMaxInstructions() { return max_instructions; }
 
+	/// Return the number of instructions in each interval of the basic
+	/// block vector profiles, or 0 if profiling is disabled.
+	static long long getBbvInterval() { return bbv_interval; }
+
+	/// Return the prefix of the basic block vector profile files
+	static const std::string &getBbvFile() { return bbv_file; }
+
+	/// Return the number of host threads used for functional emulation
+	static int getNumThreads() { return num_threads; }
+
+	/// Return whether the files mapped by guest programs use host
+	/// mappings instead of copies of their content, as enabled by option
+	/// '--x86-map-files'.
+	static bool getMapFiles() { return map_files; }
+
+	/// Set the number of host threads used for functional emulation, as
+	/// done by option '--x86-threads'. This function must be called
+	/// before the emulator singleton is created.
+	static void setNumThreads(int num_threads)
+	{
+		Emulator::num_threads = num_threads;
+	}
+
 	/// Debugger for function calls
 	static misc::Debug call_debug;
 
@@ -157,6 +290,9 @@ public:
 	/// Constructor
 	Emulator() : comm::Emulator("x86") { }
 
+	/// Destructor
+	~Emulator();
+
 	/// Create a new context associated with the emulator. The context is
 	/// inserted in the main emulator context list. Its state is set to
 	/// ContextRunning, and it is inserted into the emulator list of running
@@ -188,12 +324,29 @@ public:
 	/// Unlock the emulator mutex
 	void UnlockMutex() { pthread_mutex_unlock(&mutex); }
 
-	// Check for events detected in spawned host threads, such as waking up
-	// contexts or sending signals. The list is only effectively processed
-	// if events have been scheduled to get processed with a previous call
-	// to ProcessEventsSchedule().
+	// Check for pending events, such as waking up contexts or sending
+	// signals. Contexts whose host events occurred are checked for wakeup.
+	// The rest of suspended contexts, except those waiting for host
+	// events, are only checked if events have been scheduled with a
+	// previous call to ProcessEventsSchedule().
 	void ProcessEvents();
 
+	/// Return the reactor with the host events that suspended contexts
+	/// wait for
+	Reactor *getReactor() { return &reactor; }
+
+	/// Block until a host event that suspended contexts wait for occurs,
+	/// such as input in a file descriptor or an expired time, if no
+	/// context can make progress otherwise. Nothing is done if a context
+	/// is running, if a call to ProcessEvents() was scheduled, or if a
+	/// context is suspended without a wakeup call-back or host event,
+	/// since such contexts are woken up by other architectures (e.g., a
+	/// driver call waiting for a GPU kernel). The function returns
+	/// whether it blocked. It must only be invoked when no other
+	/// architecture and no timing simulator is active, since they would
+	/// not run while it blocks.
+	bool WaitForHostEvents();
+
 	/// Increment an internal counter for futex identifiers, and return its
 	/// new value. This function is used to assign futex identifiers used as
 	/// event timestamps.
@@ -207,11 +360,35 @@ public:
 	/// locked before invoking this function.
 	void ProcessEventsScheduleUnsafe() { process_events_force = true; }
 
-	/// Run one iteration of the emulation loop.
+	/// Return whether a call to ProcessEvents() has been scheduled. This
+	/// function internally locks the emulator mutex.
+	bool isProcessEventsScheduled();
+
+	/// Run one iteration of the emulation loop. When more than one host
+	/// thread is used (option '--x86-threads'), contexts with different
+	/// memory images first run a quantum of instructions in parallel,
+	/// each stopping early at its next system call. Contexts sharing a
+	/// memory image run in the same host thread.
+	///
 	/// \return This function \c true if the iteration had a useful
 	/// emulation, and \c false if all contexts finished execution.
 	bool Run();
 
+	/// Dump emulator statistics for the summary, including the number of
+	/// guest pages shared and copied after fork().
+	void DumpSummary(std::ostream &os) const override;
+
+	/// Return whether all contexts are in a state that can be saved in a
+	/// checkpoint. See Context::canSaveCheckpoint().
+	bool canSaveCheckpoint() const;
+
+	/// Save the architected state of all contexts into a checkpoint
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Create the contexts saved in a checkpoint. No context must have
+	/// been created before.
+	void LoadCheckpoint(misc::CheckpointReader &reader);
+
 
 
 
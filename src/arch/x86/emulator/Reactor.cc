@@ -0,0 +1,293 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <lib/cpp/Error.h>
+#include <lib/esim/Engine.h>
+
+#include "Reactor.h"
+
+
+namespace x86
+{
+
+
+Reactor::Reactor()
+{
+	// Create 'epoll' instance and timer
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (epoll_fd < 0 || timer_fd < 0)
+		throw misc::Panic("Cannot create host event reactor");
+
+	// Watch the timer
+	struct epoll_event event = { };
+	event.events = EPOLLIN;
+	event.data.fd = timer_fd;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event))
+		throw misc::Panic("Cannot watch host timer");
+}
+
+
+Reactor::~Reactor()
+{
+	close(timer_fd);
+	close(epoll_fd);
+}
+
+
+void Reactor::UpdateTimerFd()
+{
+	// Nothing to do if the earliest time did not change
+	long long time = timers.empty() ? 0 : timers.begin()->time;
+	if (time == timer_fd_time)
+		return;
+	timer_fd_time = time;
+
+	// Arm timer relative to the current time. A zero value disarms it, so
+	// times already reached expire after one nanosecond.
+	struct itimerspec spec = { };
+	if (time)
+	{
+		esim::Engine *esim = esim::Engine::getInstance();
+		long long delay = std::max(time - esim->getRealTime(), 0LL);
+		spec.it_value.tv_sec = delay / 1000000;
+		spec.it_value.tv_nsec = delay % 1000000 * 1000 + 1;
+	}
+	if (timerfd_settime(timer_fd, 0, &spec, nullptr))
+		throw misc::Panic("Cannot arm host timer");
+}
+
+
+void Reactor::RemoveWatch(Context *context, int host_fd)
+{
+	// Remove context from watch
+	auto it = watches.find(host_fd);
+	assert(it != watches.end());
+	std::vector<Context *> &contexts = it->second.contexts;
+	contexts.erase(std::find(contexts.begin(), contexts.end(), context));
+
+	// Stop watching file descriptor if no context waits for it. Errors
+	// are ignored, since the file descriptor may have been closed.
+	if (contexts.empty())
+	{
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, host_fd, nullptr);
+		watches.erase(it);
+	}
+}
+
+
+void Reactor::Wait(Context *context, int host_fd, unsigned events,
+		long long time)
+{
+	// Record wait
+	assert(!waits.count(context));
+	ContextWait &wait = waits[context];
+	wait.host_fd = -1;
+	wait.time = time;
+
+	// Time limit
+	if (time)
+	{
+		timers.insert({ time, context, -1 });
+		UpdateTimerFd();
+	}
+
+	// File descriptor
+	if (host_fd < 0)
+		return;
+	Watch &watch = watches[host_fd];
+	bool added = watch.contexts.empty();
+	if (!added && (watch.events & events) == events)
+	{
+		watch.contexts.push_back(context);
+		wait.host_fd = host_fd;
+		return;
+	}
+
+	// Register new events in the 'epoll' instance
+	struct epoll_event event = { };
+	event.events = watch.events | events;
+	event.data.fd = host_fd;
+	if (epoll_ctl(epoll_fd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+			host_fd, &event))
+	{
+		// Files that do not support 'epoll' are always ready
+		if (added)
+			watches.erase(host_fd);
+		if (errno != EPERM)
+			throw misc::Panic("Cannot watch host file descriptor");
+		ready_contexts.push_back(context);
+		return;
+	}
+	watch.events |= events;
+	watch.contexts.push_back(context);
+	wait.host_fd = host_fd;
+}
+
+
+bool Reactor::CancelWait(Context *context)
+{
+	// Find wait
+	auto it = waits.find(context);
+	if (it == waits.end())
+		return false;
+
+	// Remove time limit and watch
+	ContextWait &wait = it->second;
+	if (wait.time)
+	{
+		timers.erase({ wait.time, context, -1 });
+		UpdateTimerFd();
+	}
+	if (wait.host_fd >= 0)
+		RemoveWatch(context, wait.host_fd);
+	waits.erase(it);
+
+	// Remove from ready contexts
+	auto ready_it = std::find(ready_contexts.begin(),
+			ready_contexts.end(), context);
+	if (ready_it != ready_contexts.end())
+		ready_contexts.erase(ready_it);
+	return true;
+}
+
+
+void Reactor::setTimer(Context *context, int id, long long time)
+{
+	// Remove previous time
+	assert(id >= 0);
+	auto it = timer_times.find({ context, id });
+	if (it != timer_times.end())
+	{
+		timers.erase({ it->second, context, id });
+		timer_times.erase(it);
+	}
+
+	// Add new time
+	if (time)
+	{
+		timers.insert({ time, context, id });
+		timer_times[{ context, id }] = time;
+	}
+	UpdateTimerFd();
+}
+
+
+void Reactor::Remove(Context *context)
+{
+	// Wait
+	CancelWait(context);
+
+	// Timers
+	auto it = timer_times.lower_bound({ context, 0 });
+	while (it != timer_times.end() && it->first.first == context)
+	{
+		timers.erase({ it->second, context, it->first.second });
+		it = timer_times.erase(it);
+	}
+	UpdateTimerFd();
+}
+
+
+void Reactor::Poll(bool block, std::vector<Context *> &woken_contexts,
+		std::vector<std::pair<Context *, int>> &expired_timers)
+{
+	// Contexts waiting for files that are always ready
+	std::vector<Context *> contexts;
+	contexts.swap(ready_contexts);
+	for (Context *context : contexts)
+	{
+		CancelWait(context);
+		woken_contexts.push_back(context);
+		block = false;
+	}
+
+	// Nothing to wait for. Without watched file descriptors, a non-blocking
+	// poll only needs to look at the earliest timer.
+	esim::Engine *esim = esim::Engine::getInstance();
+	if (isEmpty() || (!block && watches.empty() &&
+			(timers.empty() ||
+			timers.begin()->time > esim->getRealTime())))
+		return;
+
+	// Wait for host events. Signals received by the simulator interrupt
+	// the wait.
+	const int max_events = 64;
+	struct epoll_event events[max_events];
+	int num_events = epoll_wait(epoll_fd, events, max_events,
+			block ? -1 : 0);
+	if (num_events < 0 && errno != EINTR)
+		throw misc::Panic("Unexpected error in host 'epoll_wait'");
+
+	// Ready file descriptors
+	for (int i = 0; i < num_events; i++)
+	{
+		// Consume timer expirations
+		int host_fd = events[i].data.fd;
+		if (host_fd == timer_fd)
+		{
+			unsigned long long count;
+			if (read(timer_fd, &count, sizeof count) < 0 &&
+					errno != EAGAIN)
+				throw misc::Panic("Cannot read host timer");
+			timer_fd_time = 0;
+			continue;
+		}
+
+		// Wake up all contexts waiting for the file descriptor
+		auto it = watches.find(host_fd);
+		if (it == watches.end())
+			continue;
+		contexts = it->second.contexts;
+		for (Context *context : contexts)
+		{
+			CancelWait(context);
+			woken_contexts.push_back(context);
+		}
+	}
+
+	// Expired timers
+	long long now = esim->getRealTime();
+	while (!timers.empty() && timers.begin()->time <= now)
+	{
+		Timer timer = *timers.begin();
+		if (timer.id < 0)
+		{
+			CancelWait(timer.context);
+			woken_contexts.push_back(timer.context);
+		}
+		else
+		{
+			timers.erase(timers.begin());
+			timer_times.erase({ timer.context, timer.id });
+			expired_timers.emplace_back(timer.context, timer.id);
+		}
+	}
+	UpdateTimerFd();
+}
+
+
+}  // namespace x86
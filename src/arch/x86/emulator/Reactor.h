@@ -0,0 +1,169 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_EMULATOR_REACTOR_H
+#define ARCH_X86_EMULATOR_REACTOR_H
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace x86
+{
+
+// Forward declarations
+class Context;
+
+
+/// Host events that suspended contexts wait for. Contexts blocked in system
+/// calls wait for a host file descriptor to become ready, for a time to be
+/// reached, or for both. Contexts can also have timers (interval timers set
+/// with 'setitimer') that expire independently of their waits.
+///
+/// All host file descriptors are watched with one 'epoll' instance, and all
+/// times are kept in one ordered set, whose earliest time arms a 'timerfd'
+/// registered in the same instance. A call to Poll() returns only the
+/// contexts whose events occurred, so that the emulator does not need to
+/// check the rest of the suspended contexts.
+///
+/// Times are given in microseconds of real time, as returned by
+/// esim::Engine::getRealTime().
+class Reactor
+{
+	// Host 'epoll' instance
+	int epoll_fd;
+
+	// Host timer armed with the earliest time in 'timers'
+	int timer_fd;
+
+	// Earliest time that 'timer_fd' is armed with, or 0 if disarmed
+	long long timer_fd_time = 0;
+
+	// Timer of a context. Identifier -1 is used for the time limit of a
+	// wait, other identifiers are given by the caller of setTimer().
+	struct Timer
+	{
+		long long time;
+		Context *context;
+		int id;
+
+		bool operator<(const Timer &other) const
+		{
+			if (time != other.time)
+				return time < other.time;
+			if (context != other.context)
+				return context < other.context;
+			return id < other.id;
+		}
+	};
+
+	// Timers ordered by time
+	std::set<Timer> timers;
+
+	// Time of the timers set with setTimer(), indexed by context and
+	// timer identifier
+	std::map<std::pair<Context *, int>, long long> timer_times;
+
+	// Contexts waiting for a host file descriptor, and union of the
+	// 'epoll' events they wait for
+	struct Watch
+	{
+		unsigned events = 0;
+		std::vector<Context *> contexts;
+	};
+
+	// Watched host file descriptors
+	std::unordered_map<int, Watch> watches;
+
+	// Wait of a context
+	struct ContextWait
+	{
+		// Host file descriptor, or -1 if none
+		int host_fd;
+
+		// Time limit, or 0 if none
+		long long time;
+	};
+
+	// Waits of suspended contexts
+	std::unordered_map<Context *, ContextWait> waits;
+
+	// Contexts waiting for file descriptors that cannot be watched with
+	// 'epoll', such as regular files, which are always ready
+	std::vector<Context *> ready_contexts;
+
+	// Arm the host timer with the earliest time, if it changed
+	void UpdateTimerFd();
+
+	// Stop watching a file descriptor for a context
+	void RemoveWatch(Context *context, int host_fd);
+
+public:
+
+	/// Constructor
+	Reactor();
+
+	/// Destructor
+	~Reactor();
+
+	/// Make \a context wait until host file descriptor \a host_fd has
+	/// any of the 'epoll' events in \a events, or until time \a time,
+	/// whichever happens first. A negative \a host_fd or a zero \a time
+	/// are ignored. The context must not be waiting already.
+	void Wait(Context *context, int host_fd, unsigned events,
+			long long time);
+
+	/// Return whether \a context is waiting for a host event
+	bool isWaiting(Context *context) const
+	{
+		return waits.count(context);
+	}
+
+	/// Stop the wait of \a context, if any. The function returns whether
+	/// the context was waiting.
+	bool CancelWait(Context *context);
+
+	/// Set timer \a id of \a context to expire at \a time, replacing its
+	/// previous time, if any. A zero \a time removes the timer. The
+	/// identifier must not be negative.
+	void setTimer(Context *context, int id, long long time);
+
+	/// Remove all waits and timers of a context
+	void Remove(Context *context);
+
+	/// Return whether no context is waiting and no timer is set
+	bool isEmpty() const { return waits.empty() && timers.empty(); }
+
+	/// Collect the host events that occurred. Contexts whose wait ended
+	/// are added to \a woken_contexts, and stop waiting. Expired timers
+	/// are removed and added to \a expired_timers as pairs of context and
+	/// timer identifier. If \a block is true and no event occurred yet,
+	/// the function blocks until one occurs, unless there is nothing to
+	/// wait for.
+	void Poll(bool block, std::vector<Context *> &woken_contexts,
+			std::vector<std::pair<Context *, int>> &expired_timers);
+};
+
+
+}  // namespace x86
+
+#endif
@@ -106,6 +106,13 @@ Regs::Regs()
 	eip = 0;
 	eflags = 0;
 
+	// Lazy flags
+	lazy_op = LazyNone;
+	lazy_src1 = 0;
+	lazy_src2 = 0;
+	lazy_result = 0;
+	lazy_sign = 0;
+
 	// Initialize floating-point stack
 	for (int i = 0; i < 8; i++)
 		fpu_stack[i].valid = false;
@@ -117,6 +124,19 @@ Regs::Regs()
 }
 
 
+unsigned Regs::getLazyEflags() const
+{
+	unsigned value = eflags & ~lazy_flags_mask;
+	for (Instruction::Flag flag : { Instruction::FlagCF,
+			Instruction::FlagPF, Instruction::FlagAF,
+			Instruction::FlagZF, Instruction::FlagSF,
+			Instruction::FlagOF })
+		if (getLazyFlag(flag))
+			value |= 1 << flag;
+	return value;
+}
+
+
 unsigned Regs::Read(int reg) const
 {
 	assert(misc::inRange(reg, Instruction::RegNone, Instruction::RegCount - 1));
@@ -203,6 +223,8 @@ void Regs::DumpFpuStack(std::ostream &os) const
 
 void Regs::Dump(std::ostream &os) const
 {
+	unsigned flags = getEflags();
+
 	// Integer registers
 	os << misc::fmt("  eax=%08x  ecx=%08x  edx=%08x  ebx=%08x\n",
 		eax, ecx, edx, ebx);
@@ -212,14 +234,14 @@ void Regs::Dump(std::ostream &os) const
 		es, cs, ss, ds, fs, gs);
 	os << misc::fmt("  eip=%08x\n", eip);
 	os << misc::fmt("  flags=%04x (cf=%d  pf=%d  af=%d  zf=%d  sf=%d  df=%d  of=%d)\n",
-		eflags,
-		(eflags & (1 << Instruction::FlagCF)) > 0,
-		(eflags & (1 << Instruction::FlagPF)) > 0,
-		(eflags & (1 << Instruction::FlagAF)) > 0,
-		(eflags & (1 << Instruction::FlagZF)) > 0,
-		(eflags & (1 << Instruction::FlagSF)) > 0,
-		(eflags & (1 << Instruction::FlagDF)) > 0,
-		(eflags & (1 << Instruction::FlagOF)) > 0);
+		flags,
+		(flags & (1 << Instruction::FlagCF)) > 0,
+		(flags & (1 << Instruction::FlagPF)) > 0,
+		(flags & (1 << Instruction::FlagAF)) > 0,
+		(flags & (1 << Instruction::FlagZF)) > 0,
+		(flags & (1 << Instruction::FlagSF)) > 0,
+		(flags & (1 << Instruction::FlagDF)) > 0,
+		(flags & (1 << Instruction::FlagOF)) > 0);
 	
 	// Floating-point stack
 	os << "  fpu_stack (last=top): ";
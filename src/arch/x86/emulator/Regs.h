@@ -34,8 +34,40 @@ namespace x86
 
 
 /// Class representing the state of the x86 architected register file.
+///
+/// The arithmetic flags (CF, PF, AF, ZF, SF, and OF) produced by the most
+/// common integer instructions are evaluated lazily. Those instructions
+/// only record their operation, operands, and result with setLazyFlags(),
+/// and each flag is computed when it is read. Most flags are overwritten
+/// before being read by a conditional instruction.
 class Regs
 {
+public:
+
+	/// Operations whose arithmetic flags can be evaluated lazily
+	enum LazyOp
+	{
+		LazyNone = 0,
+
+		/// Addition, with a carry-in of 0 or 1, respectively
+		LazyAdd,
+		LazyAdc,
+
+		/// Subtraction, with a borrow-in of 0 or 1, respectively
+		LazySub,
+		LazySbb,
+
+		/// Bitwise operations (and, or, xor, test), which clear CF,
+		/// AF, and OF
+		LazyLogic,
+
+		/// Increment and decrement by 1, which preserve CF
+		LazyInc,
+		LazyDec
+	};
+
+private:
+
 	union
 	{
 		// View of the main set of registers as defined in the register
@@ -70,10 +102,105 @@ class Regs
 		char bytes[44];
 	};
 
-	// Program counter and flags
+	// Program counter and flags. While a lazy operation is recorded, the
+	// arithmetic flags in 'eflags' are not valid, except for CF after an
+	// increment or decrement.
 	unsigned eip;
 	unsigned eflags;
 
+	// Last operation producing arithmetic flags, its operands, and its
+	// result, truncated to the operation size
+	LazyOp lazy_op;
+	unsigned lazy_src1;
+	unsigned lazy_src2;
+	unsigned lazy_result;
+
+	// Mask for the sign bit of the operation size of 'lazy_op'
+	unsigned lazy_sign;
+
+	// Bitmap of the flags evaluated lazily
+	static const unsigned lazy_flags_mask =
+			1 << Instruction::FlagCF |
+			1 << Instruction::FlagPF |
+			1 << Instruction::FlagAF |
+			1 << Instruction::FlagZF |
+			1 << Instruction::FlagSF |
+			1 << Instruction::FlagOF;
+
+	// Compute an arithmetic flag from the recorded lazy operation
+	bool getLazyFlag(Instruction::Flag flag) const
+	{
+		switch (flag)
+		{
+
+		case Instruction::FlagZF:
+
+			return !lazy_result;
+
+		case Instruction::FlagSF:
+
+			return lazy_result & lazy_sign;
+
+		case Instruction::FlagPF:
+
+			return !__builtin_parity(lazy_result & 0xff);
+
+		case Instruction::FlagAF:
+
+			return lazy_op != LazyLogic &&
+					((lazy_src1 ^ lazy_src2 ^ lazy_result)
+					& 0x10);
+
+		case Instruction::FlagCF:
+
+			switch (lazy_op)
+			{
+			case LazyAdd: return lazy_result < lazy_src1;
+			case LazyAdc: return lazy_result <= lazy_src1;
+			case LazySub: return lazy_src1 < lazy_src2;
+			case LazySbb: return lazy_src1 <= lazy_src2;
+			case LazyLogic: return false;
+			default: return misc::getBit32(eflags, flag);
+			}
+
+		case Instruction::FlagOF:
+
+			switch (lazy_op)
+			{
+			case LazyAdd:
+			case LazyAdc:
+			case LazyInc:
+				return (lazy_src1 ^ lazy_result) &
+						(lazy_src2 ^ lazy_result) &
+						lazy_sign;
+			case LazySub:
+			case LazySbb:
+			case LazyDec:
+				return (lazy_src1 ^ lazy_src2) &
+						(lazy_src1 ^ lazy_result) &
+						lazy_sign;
+			default:
+				return false;
+			}
+
+		default:
+
+			return misc::getBit32(eflags, flag);
+		}
+	}
+
+	// Compute the value of register 'eflags' from the recorded lazy
+	// operation
+	unsigned getLazyEflags() const;
+
+	// Write the lazily evaluated flags into 'eflags', and stop evaluating
+	// them lazily
+	void MaterializeFlags()
+	{
+		eflags = getLazyEflags();
+		lazy_op = LazyNone;
+	}
+
 	// Floating-point stack
 	struct
 	{
@@ -125,19 +252,45 @@ public:
 
 	/// Set the value of a flag, given as an \c Inst::FlagXXX identifier.
 	void setFlag(Instruction::Flag flag) {
+		if (lazy_op != LazyNone)
+			MaterializeFlags();
 		eflags = misc::setBit32(eflags, flag);
 	}
 
 	/// Clear the value of a flag, given as an \c Inst::FlagXXX identifier.
 	void clearFlag(Instruction::Flag flag) {
+		if (lazy_op != LazyNone)
+			MaterializeFlags();
 		eflags = misc::clearBit32(eflags, flag);
 	}
 
 	/// Get the value of a flag, given as an \c Inst::FlagXXX constant.
-	bool getFlag(Instruction::Flag flag) {
+	bool getFlag(Instruction::Flag flag) const {
+		if (lazy_op != LazyNone)
+			return getLazyFlag(flag);
 		return misc::getBit32(eflags, flag);
 	}
 
+	/// Record an operation of \a size bytes producing the arithmetic
+	/// flags, which are computed from its operands and result when read.
+	/// For increments and decrements, \a src2 must be 1.
+	void setLazyFlags(LazyOp op, int size, unsigned src1, unsigned src2,
+			unsigned result)
+	{
+		// Increments and decrements keep the previous CF
+		if ((op == LazyInc || op == LazyDec) &&
+				getFlag(Instruction::FlagCF) !=
+				misc::getBit32(eflags, Instruction::FlagCF))
+			eflags ^= 1 << Instruction::FlagCF;
+
+		// Record operation
+		lazy_op = op;
+		lazy_src1 = src1 & mask[size];
+		lazy_src2 = src2 & mask[size];
+		lazy_result = result & mask[size];
+		lazy_sign = 1u << (size * 8 - 1);
+	}
+
 	/// Read a 10-byte extended value from the FPU stack at \a index, given
 	/// as a relative position to the top of the stack.
 	Extended ReadFpu(int index) const;
@@ -242,7 +395,9 @@ public:
 	unsigned getEip() const { return eip; }
 
 	/// Get value of register \c eflags
-	unsigned getEflags() const { return eflags; }
+	unsigned getEflags() const {
+		return lazy_op == LazyNone ? eflags : getLazyEflags();
+	}
 
 	/// Get value of register \c es
 	unsigned short getEs() const { return es; }
@@ -386,7 +541,10 @@ public:
 	void decEip(int value) { eip -= value; }
 
 	/// Set value of register \c eflags
-	void setEflags(unsigned value) { eflags = value; }
+	void setEflags(unsigned value) {
+		eflags = value;
+		lazy_op = LazyNone;
+	}
 
 	/// Get the top of the FP stack
 	int getFpuTop() const { return fpu_top; }
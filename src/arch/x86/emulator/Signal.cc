@@ -17,6 +17,8 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <lib/cpp/Checkpoint.h>
+
 #include "Signal.h"
 
 
@@ -131,5 +133,73 @@ void SignalHandler::Dump(std::ostream &os) const
 }
 
 
+void SignalSet::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	writer.Write(bitmap.getBuffer(), bitmap.getSizeInBytes());
+}
+
+
+void SignalSet::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	reader.Read(bitmap.getBuffer(), bitmap.getSizeInBytes());
+}
+
+
+void SignalMaskTable::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	pending.SaveCheckpoint(writer);
+	blocked.SaveCheckpoint(writer);
+	backup.SaveCheckpoint(writer);
+	writer.WriteValue(ret_code_ptr);
+	writer.WriteValue<bool>(regs.get());
+	if (regs.get())
+		writer.WriteValue(*regs);
+}
+
+
+void SignalMaskTable::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	pending.LoadCheckpoint(reader);
+	blocked.LoadCheckpoint(reader);
+	backup.LoadCheckpoint(reader);
+	reader.ReadValue(ret_code_ptr);
+	regs.reset();
+	if (reader.ReadValue<bool>())
+		setRegs(reader.ReadValue<Regs>());
+}
+
+
+void SignalHandler::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	writer.WriteValue(handler);
+	writer.WriteValue(flags);
+	writer.WriteValue(restorer);
+	mask.SaveCheckpoint(writer);
+}
+
+
+void SignalHandler::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	reader.ReadValue(handler);
+	reader.ReadValue(flags);
+	reader.ReadValue(restorer);
+	mask.LoadCheckpoint(reader);
+}
+
+
+void SignalHandlerTable::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	for (const SignalHandler &handler : signal_handler)
+		handler.SaveCheckpoint(writer);
+}
+
+
+void SignalHandlerTable::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	for (SignalHandler &handler : signal_handler)
+		handler.LoadCheckpoint(reader);
+}
+
+
 }  // namespace x86
 
@@ -29,6 +29,14 @@
 #include "Regs.h"
 
 
+// Forward declarations
+namespace misc
+{
+class CheckpointReader;
+class CheckpointWriter;
+}
+
+
 namespace x86
 {
 
@@ -201,6 +209,12 @@ public:
 		assert(bitmap.getSizeInBytes() == 8);
 		memory->Write(address, 8, bitmap.getBuffer());
 	}
+
+	/// Save the signal set into a checkpoint
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Load the signal set from a checkpoint
+	void LoadCheckpoint(misc::CheckpointReader &reader);
 };
 
 
@@ -266,6 +280,12 @@ public:
 
 	/// Return address where the return code can be found.
 	unsigned getRetCodePtr() const { return ret_code_ptr; }
+
+	/// Save the signal masks and the register backup into a checkpoint
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Load the signal masks and the register backup from a checkpoint
+	void LoadCheckpoint(misc::CheckpointReader &reader);
 };
 
 
@@ -308,6 +328,12 @@ public:
 
 	/// Write the content of the signal handler to memory
 	void WriteToMemory(mem::Memory *memory, unsigned address);
+
+	/// Save the signal handler into a checkpoint
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Load the signal handler from a checkpoint
+	void LoadCheckpoint(misc::CheckpointReader &reader);
 };
 
 
@@ -326,6 +352,12 @@ public:
 		assert(misc::inRange(sig, 1, 64));
 		return &signal_handler[sig - 1];
 	}
+
+	/// Save all signal handlers into a checkpoint
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Load all signal handlers from a checkpoint
+	void LoadCheckpoint(misc::CheckpointReader &reader);
 };
 
 
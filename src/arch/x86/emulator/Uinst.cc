@@ -201,7 +201,7 @@ bool Uinst::addIDep(Dep dep)
 	// Find free index
 	int index;
 	for (index = 0; index < MaxIDeps; index++)
-		if (!idep[index])
+		if (!getIDep(index))
 			break;
 	
 	// Return false if no room for new dependency
@@ -209,7 +209,7 @@ bool Uinst::addIDep(Dep dep)
 		return false;
 	
 	// Set new dependence
-	idep[index] = dep;
+	setIDep(index, dep);
 	return true;
 }
 
@@ -219,7 +219,7 @@ bool Uinst::addODep(Dep dep)
 	// Find free index
 	int index;
 	for (index = 0; index < MaxODeps; index++)
-		if (!odep[index])
+		if (!getODep(index))
 			break;
 	
 	// Return false if no room for new dependency
@@ -227,7 +227,7 @@ bool Uinst::addODep(Dep dep)
 		return false;
 	
 	// Set new dependence
-	odep[index] = dep;
+	setODep(index, dep);
 	return true;
 }
 
@@ -242,7 +242,7 @@ void Uinst::Dump(std::ostream &os) const
 	int dep_count = 0;
 	for (int i = 0; i < MaxODeps; i++)
 	{
-		Dep dep = odep[i];
+		Dep dep = getODep(i);
 		if (!dep)
 			continue;
 		dep_count++;
@@ -260,7 +260,7 @@ void Uinst::Dump(std::ostream &os) const
 	dep_count = 0;
 	for (int i = 0; i < MaxIDeps; i++)
 	{
-		Dep dep = idep[i];
+		Dep dep = getIDep(i);
 		if (!dep)
 			continue;
 		dep_count++;
@@ -289,14 +289,11 @@ private:
 	// Unique identifier for micro-instruction, initialized in constructor
 	Opcode opcode;
 
-	// All dependences
+	// All dependences. Input dependences come first, followed by output
+	// dependences. No pointers to internal positions are kept, so that
+	// micro-instructions can be copied.
 	Dep dep[MaxDeps] = {};
 
-	// Pointers to input and output dependences, pointing to internal
-	// positions of 'dep', and initialized in constructor
-	Dep *idep = dep;
-	Dep *odep = dep + MaxIDeps;
-
 	// Address of the last memory access for this instruction, if it is
 	// a memory micro-instruction
 	unsigned address = 0;
@@ -367,8 +364,9 @@ public:
 	// Member functions
 	//
 
-	/// Create a micro-instruction with a given \a opcode
-	Uinst(Opcode opcode) : opcode(opcode)
+	/// Create a micro-instruction with a given \a opcode, or a 'nop'
+	/// micro-instruction if none is given
+	Uinst(Opcode opcode = OpcodeNop) : opcode(opcode)
 	{
 	}
 	
@@ -398,7 +396,7 @@ public:
 	Dep getIDep(int index) const
 	{
 		assert(misc::inRange(index, 0, MaxIDeps - 1));
-		return idep[index];
+		return dep[index];
 	}
 
 	/// Return an output dependence. Argument \a index must be a value
@@ -406,7 +404,7 @@ public:
 	Dep getODep(int index) const
 	{
 		assert(misc::inRange(index, 0, MaxODeps - 1));
-		return odep[index];
+		return dep[MaxIDeps + index];
 	}
 
 	/// Get the address of a memory access micro-instruction
@@ -421,7 +419,7 @@ public:
 	void setIDep(int index, int dep)
 	{
 		assert(misc::inRange(index, 0, MaxIDeps - 1));
-		idep[index] = (Dep) dep;
+		this->dep[index] = (Dep) dep;
 	}
 
 	/// Set an output dependence. Argument \a index must be a value between
@@ -429,7 +427,7 @@ public:
 	void setODep(int index, int dep)
 	{
 		assert(misc::inRange(index, 0, MaxODeps - 1));
-		odep[index] = (Dep) dep;
+		this->dep[MaxIDeps + index] = (Dep) dep;
 	}
 
 	/// Set a dependence using a global index. Argument \a index must be a
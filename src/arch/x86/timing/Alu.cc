@@ -17,6 +17,8 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+
 #include "Alu.h"
 #include "Timing.h"
 
@@ -147,6 +149,15 @@ void Alu::DumpConfiguration(std::ostream &os)
 }
 
 
+int Alu::getMaxOperationLatency()
+{
+	int max_latency = 0;
+	for (int i = 1; i < FunctionalUnit::TypeCount; i++)
+		max_latency = std::max(max_latency, configuration[i][1]);
+	return max_latency;
+}
+
+
 Alu::Alu()
 {
 	// Reserve functional unit vector entries
@@ -111,6 +111,9 @@ public:
 	// Get the issue latency based on given type count
 	static int getAluIssueLatency(int type_count) { return configuration[type_count][2]; }
 
+	// Get the longest operation latency of all functional units
+	static int getMaxOperationLatency();
+
 };
 
 }
@@ -0,0 +1,58 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cassert>
+
+#include "BranchHistory.h"
+
+
+namespace x86
+{
+
+BranchHistory::BranchHistory(int max_length)
+{
+	// The bit leaving the longest history must still be available
+	int size = 1;
+	while (size <= max_length)
+		size *= 2;
+	bits.resize(size);
+}
+
+
+FoldedHistory::FoldedHistory(int original_length, int compressed_length) :
+		original_length(original_length),
+		compressed_length(compressed_length),
+		outpoint(original_length % compressed_length)
+{
+	assert(compressed_length > 0 && compressed_length < 32);
+}
+
+
+void FoldedHistory::Update(const BranchHistory &history)
+{
+	// Insert the new bit, and remove the bit leaving the history from the
+	// position where it was folded
+	value = (value << 1) | history[0];
+	value ^= (unsigned) history[original_length] << outpoint;
+	value ^= value >> compressed_length;
+	value &= (1u << compressed_length) - 1;
+}
+
+
+}  // namespace x86
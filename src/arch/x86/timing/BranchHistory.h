@@ -0,0 +1,98 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_BRANCH_HISTORY_H
+#define ARCH_X86_TIMING_BRANCH_HISTORY_H
+
+#include <vector>
+
+
+namespace x86
+{
+
+/// Global branch history, keeping the most recent bits inserted up to a
+/// maximum length.
+class BranchHistory
+{
+	// Circular buffer of bits, with a power-of-two size
+	std::vector<bool> bits;
+
+	// Number of bits inserted so far
+	unsigned long long count = 0;
+
+public:
+
+	/// Constructor of a history holding at least \a max_length bits
+	explicit BranchHistory(int max_length);
+
+	/// Insert a bit as the most recent one
+	void Push(bool bit)
+	{
+		bits[count & (bits.size() - 1)] = bit;
+		count++;
+	}
+
+	/// Return the bit inserted \a index insertions ago, where 0 is the
+	/// most recent bit. Bits never inserted are 0.
+	bool operator[](int index) const
+	{
+		if ((unsigned long long) index >= count)
+			return false;
+		return bits[(count - 1 - index) & (bits.size() - 1)];
+	}
+};
+
+
+/// History of a given length folded by XOR into fewer bits, updated
+/// incrementally as bits are inserted in the global history. Used to index
+/// predictor tables with long histories in constant time.
+class FoldedHistory
+{
+	// Folded value
+	unsigned value = 0;
+
+	// Length of the history folded
+	int original_length = 0;
+
+	// Number of bits of the folded value
+	int compressed_length = 0;
+
+	// Position where the bit leaving the history is removed
+	int outpoint = 0;
+
+public:
+
+	/// Default constructor, creating an empty history
+	FoldedHistory() = default;
+
+	/// Constructor of the fold of the last \a original_length bits of the
+	/// global history into \a compressed_length bits
+	FoldedHistory(int original_length, int compressed_length);
+
+	/// Return the folded value
+	unsigned getValue() const { return value; }
+
+	/// Update the folded value after a bit was inserted in \a history
+	void Update(const BranchHistory &history);
+};
+
+
+}  // namespace x86
+
+#endif
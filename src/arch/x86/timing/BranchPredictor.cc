@@ -35,6 +35,24 @@ int BranchPredictor::two_level_l1_size;
 int BranchPredictor::two_level_l2_size;
 int BranchPredictor::two_level_history_size;
 int BranchPredictor::two_level_l2_height;
+int BranchPredictor::tage_num_tables;
+int BranchPredictor::tage_base_size;
+int BranchPredictor::tage_table_size;
+int BranchPredictor::tage_tag_bits;
+int BranchPredictor::tage_min_history;
+int BranchPredictor::tage_max_history;
+int BranchPredictor::tage_loop_size;
+bool BranchPredictor::tage_statistical_corrector;
+int BranchPredictor::perceptron_num_tables;
+int BranchPredictor::perceptron_table_size;
+int BranchPredictor::perceptron_history_size;
+BranchPredictor::IndirectKind BranchPredictor::indirect_kind;
+int BranchPredictor::ittage_num_tables;
+int BranchPredictor::ittage_base_size;
+int BranchPredictor::ittage_table_size;
+int BranchPredictor::ittage_tag_bits;
+int BranchPredictor::ittage_min_history;
+int BranchPredictor::ittage_max_history;
 
 misc::StringMap BranchPredictor::KindMap =
 {
@@ -43,9 +61,29 @@ misc::StringMap BranchPredictor::KindMap =
 	{"NotTaken", KindNottaken},
 	{"Bimodal", KindBimod},
 	{"TwoLevel", KindTwoLevel},
-	{"Combined", KindCombined}
+	{"Combined", KindCombined},
+	{"Tage", KindTage},
+	{"Perceptron", KindPerceptron}
 };
 
+misc::StringMap BranchPredictor::IndirectKindMap =
+{
+	{ "Btb", IndirectKindBtb },
+	{ "Ittage", IndirectKindIttage }
+};
+
+
+// Return whether a branch is an indirect jump or call, taking its target from
+// a register or memory operand
+static bool isIndirect(Uop *uop)
+{
+	const Uinst *uinst = uop->getUinst();
+	return (uinst->getOpcode() == Uinst::OpcodeJump ||
+			uinst->getOpcode() == Uinst::OpcodeCall) &&
+			uinst->getIDep(0) != Uinst::DepNone;
+}
+
+
 BranchPredictor::BranchPredictor(const std::string &name)
 	:
 	name(name)
@@ -78,6 +116,33 @@ BranchPredictor::BranchPredictor(const std::string &name)
 			choice[i] = 2;
 	}
 
+	// TAGE predictor
+	if (kind == KindTage)
+		tage = misc::new_unique<TagePredictor>(tage_num_tables,
+				misc::LogBase2(tage_base_size),
+				misc::LogBase2(tage_table_size),
+				tage_tag_bits,
+				tage_min_history,
+				tage_max_history,
+				tage_loop_size ? misc::LogBase2(tage_loop_size) : 0,
+				tage_statistical_corrector);
+
+	// Hashed perceptron predictor
+	if (kind == KindPerceptron)
+		perceptron = misc::new_unique<PerceptronPredictor>(
+				perceptron_num_tables,
+				misc::LogBase2(perceptron_table_size),
+				perceptron_history_size);
+
+	// ITTAGE predictor
+	if (indirect_kind == IndirectKindIttage && kind != KindPerfect)
+		ittage = misc::new_unique<IttagePredictor>(ittage_num_tables,
+				misc::LogBase2(ittage_base_size),
+				misc::LogBase2(ittage_table_size),
+				ittage_tag_bits,
+				ittage_min_history,
+				ittage_max_history);
+
 	// Allocate BTB and assign LRU counters
 	btb = misc::new_unique_array<BtbEntry>(btb_num_sets * btb_num_ways);
 	for (int i = 0; i < btb_num_sets; i++)
@@ -104,6 +169,26 @@ void BranchPredictor::ParseConfiguration(misc::IniFile *ini_file)
 	two_level_l1_size = ini_file->ReadInt(section, "TwoLevel.L1Size", 1);
 	two_level_l2_size = ini_file->ReadInt(section, "TwoLevel.L2Size", 1024);
 	two_level_history_size = ini_file->ReadInt(section, "TwoLevel.HistorySize", 8);
+	tage_num_tables = ini_file->ReadInt(section, "Tage.NumTables", 7);
+	tage_base_size = ini_file->ReadInt(section, "Tage.BaseSize", 4096);
+	tage_table_size = ini_file->ReadInt(section, "Tage.TableSize", 1024);
+	tage_tag_bits = ini_file->ReadInt(section, "Tage.TagBits", 10);
+	tage_min_history = ini_file->ReadInt(section, "Tage.MinHistory", 4);
+	tage_max_history = ini_file->ReadInt(section, "Tage.MaxHistory", 128);
+	tage_loop_size = ini_file->ReadInt(section, "Tage.LoopSize", 64);
+	tage_statistical_corrector = ini_file->ReadBool(section,
+			"Tage.StatisticalCorrector", true);
+	perceptron_num_tables = ini_file->ReadInt(section, "Perceptron.NumTables", 8);
+	perceptron_table_size = ini_file->ReadInt(section, "Perceptron.TableSize", 1024);
+	perceptron_history_size = ini_file->ReadInt(section, "Perceptron.HistorySize", 64);
+	indirect_kind = (IndirectKind) ini_file->ReadEnum(section, "Indirect",
+			IndirectKindMap, IndirectKindBtb);
+	ittage_num_tables = ini_file->ReadInt(section, "Ittage.NumTables", 5);
+	ittage_base_size = ini_file->ReadInt(section, "Ittage.BaseSize", 256);
+	ittage_table_size = ini_file->ReadInt(section, "Ittage.TableSize", 256);
+	ittage_tag_bits = ini_file->ReadInt(section, "Ittage.TagBits", 10);
+	ittage_min_history = ini_file->ReadInt(section, "Ittage.MinHistory", 4);
+	ittage_max_history = ini_file->ReadInt(section, "Ittage.MaxHistory", 64);
 
 	// Two-level branch predictor parameter
 	two_level_l2_height = 1 << two_level_history_size;
@@ -123,6 +208,43 @@ void BranchPredictor::ParseConfiguration(misc::IniFile *ini_file)
 		throw Error("two-level predictor sizes must be power of 2");
 	if (two_level_l2_size & (two_level_l2_size - 1))
 		throw Error("two-level predictor sizes must be power of 2");
+	if (tage_num_tables < 1 || tage_num_tables > TagePredictor::MaxTables)
+		throw Error(misc::fmt("number of TAGE tables must be "
+				"between 1 and %d", TagePredictor::MaxTables));
+	if (tage_base_size < 1 || (tage_base_size & (tage_base_size - 1)))
+		throw Error("TAGE base table size must be a power of 2");
+	if (tage_table_size < 1 || tage_table_size > 65536 ||
+			(tage_table_size & (tage_table_size - 1)))
+		throw Error("TAGE table size must be a power of 2 up to 65536");
+	if (tage_tag_bits < 2 || tage_tag_bits > 16)
+		throw Error("TAGE tag bits must be between 2 and 16");
+	if (tage_min_history < 1 || tage_max_history < tage_min_history)
+		throw Error("invalid TAGE history lengths");
+	if (tage_loop_size < 0 || tage_loop_size == 1 || tage_loop_size > 65536 ||
+			(tage_loop_size & (tage_loop_size - 1)))
+		throw Error("TAGE loop predictor size must be 0 or a power of 2 "
+				"between 2 and 65536");
+	if (perceptron_num_tables < 2 || perceptron_num_tables >
+			PerceptronPredictor::MaxTables)
+		throw Error(misc::fmt("number of perceptron tables must be "
+				"between 2 and %d", PerceptronPredictor::MaxTables));
+	if (perceptron_table_size < 1 || perceptron_table_size > 65536 ||
+			(perceptron_table_size & (perceptron_table_size - 1)))
+		throw Error("perceptron table size must be a power of 2 up to 65536");
+	if (perceptron_history_size < 2)
+		throw Error("perceptron history size must be at least 2");
+	if (ittage_num_tables < 1 || ittage_num_tables > IttagePredictor::MaxTables)
+		throw Error(misc::fmt("number of ITTAGE tables must be "
+				"between 1 and %d", IttagePredictor::MaxTables));
+	if (ittage_base_size < 1 || (ittage_base_size & (ittage_base_size - 1)))
+		throw Error("ITTAGE base table size must be a power of 2");
+	if (ittage_table_size < 1 || ittage_table_size > 65536 ||
+			(ittage_table_size & (ittage_table_size - 1)))
+		throw Error("ITTAGE table size must be a power of 2 up to 65536");
+	if (ittage_tag_bits < 2 || ittage_tag_bits > 16)
+		throw Error("ITTAGE tag bits must be between 2 and 16");
+	if (ittage_min_history < 1 || ittage_max_history < ittage_min_history)
+		throw Error("invalid ITTAGE history lengths");
 }
 
 
@@ -138,6 +260,25 @@ void BranchPredictor::DumpConfiguration(std::ostream &os)
 	os << misc::fmt("\tTwoLevel.L1Size: %d\n", two_level_l1_size);
 	os << misc::fmt("\tTwoLevel.L2Size: %d\n", two_level_l2_size);
 	os << misc::fmt("\tTwoLevel.HistorySize: %d\n", two_level_history_size);
+	os << misc::fmt("\tTage.NumTables: %d\n", tage_num_tables);
+	os << misc::fmt("\tTage.BaseSize: %d\n", tage_base_size);
+	os << misc::fmt("\tTage.TableSize: %d\n", tage_table_size);
+	os << misc::fmt("\tTage.TagBits: %d\n", tage_tag_bits);
+	os << misc::fmt("\tTage.MinHistory: %d\n", tage_min_history);
+	os << misc::fmt("\tTage.MaxHistory: %d\n", tage_max_history);
+	os << misc::fmt("\tTage.LoopSize: %d\n", tage_loop_size);
+	os << misc::fmt("\tTage.StatisticalCorrector: %s\n",
+			tage_statistical_corrector ? "True" : "False");
+	os << misc::fmt("\tPerceptron.NumTables: %d\n", perceptron_num_tables);
+	os << misc::fmt("\tPerceptron.TableSize: %d\n", perceptron_table_size);
+	os << misc::fmt("\tPerceptron.HistorySize: %d\n", perceptron_history_size);
+	os << misc::fmt("\tIndirect: %s\n", IndirectKindMap[indirect_kind]);
+	os << misc::fmt("\tIttage.NumTables: %d\n", ittage_num_tables);
+	os << misc::fmt("\tIttage.BaseSize: %d\n", ittage_base_size);
+	os << misc::fmt("\tIttage.TableSize: %d\n", ittage_table_size);
+	os << misc::fmt("\tIttage.TagBits: %d\n", ittage_tag_bits);
+	os << misc::fmt("\tIttage.MinHistory: %d\n", ittage_min_history);
+	os << misc::fmt("\tIttage.MaxHistory: %d\n", ittage_max_history);
 }
 
 
@@ -154,6 +295,7 @@ BranchPredictor::Prediction BranchPredictor::Lookup(Uop *uop)
 	if (uop->getFlags() & Uinst::FlagUncond)
 	{
 		uop->prediction = PredictionTaken;
+		UpdateHistory(uop);
 		return PredictionTaken;
 	}
 
@@ -222,6 +364,20 @@ BranchPredictor::Prediction BranchPredictor::Lookup(Uop *uop)
 		uop->prediction = choice_prediction;
 	}
 
+	// TAGE
+	if (kind == KindTage)
+		uop->prediction = tage->Lookup(uop->eip, uop->tage) ?
+				PredictionTaken : PredictionNotTaken;
+
+	// Hashed perceptron
+	if (kind == KindPerceptron)
+		uop->prediction = perceptron->Lookup(uop->eip,
+				uop->perceptron) ?
+				PredictionTaken : PredictionNotTaken;
+
+	// Global histories
+	UpdateHistory(uop);
+
 	// Return prediction
 	assert(uop->prediction == PredictionTaken || uop->prediction == PredictionNotTaken);
 	return uop->prediction;
@@ -258,6 +414,36 @@ int BranchPredictor::LookupMultiple(unsigned int eip, int count)
 }
 
 
+void BranchPredictor::UpdateHistory(Uop *uop)
+{
+	// Only global-history predictors other than the two-level predictor
+	// keep a history here. It is updated with the actual direction of
+	// the branches in the correct path as they are fetched. This matches a
+	// history updated with predictions and repaired on mispredictions,
+	// since the correct path is only fetched once the older branches were
+	// resolved.
+	if (uop->speculative_mode)
+		return;
+	bool taken = uop->neip != uop->eip + uop->mop_size;
+	if (uop->getFlags() & Uinst::FlagCond)
+	{
+		if (tage)
+			tage->UpdateHistory(taken, uop->tage);
+		if (perceptron)
+			perceptron->UpdateHistory(taken);
+		if (ittage)
+			ittage->UpdateHistory(taken);
+	}
+	else if (ittage && isIndirect(uop))
+	{
+		// Indirect branches insert some bits of their target
+		unsigned hash = uop->neip ^ (uop->neip >> 3);
+		for (int i = 0; i < 3; i++)
+			ittage->UpdateHistory((hash >> i) & 1);
+	}
+}
+
+
 void BranchPredictor::Update(Uop *uop)
 {
 	// Taken/NotTaken flag
@@ -292,6 +478,13 @@ void BranchPredictor::Update(Uop *uop)
 	if (uop->getFlags() & Uinst::FlagUncond)
 		return;
 
+	// TAGE and perceptron predictors, not looked up for internal branches
+	bool internal = uop->getUinst()->getOpcode() == Uinst::OpcodeIbranch;
+	if (kind == KindTage && !internal)
+		tage->Update(uop->eip, taken, uop->tage);
+	if (kind == KindPerceptron && !internal)
+		perceptron->Update(taken, uop->perceptron);
+
 	// Bimodal predictor was used
 	if (kind == KindBimod ||
 			(kind == KindCombined && uop->choice_prediction == PredictionNotTaken))
@@ -363,6 +556,15 @@ unsigned int BranchPredictor::LookupBtb(Uop *uop)
 		break;
 	}
 
+	// Indirect jumps and calls found in the BTB take their target from
+	// the ITTAGE predictor, if it has one
+	if (hit && ittage && isIndirect(uop))
+	{
+		unsigned ittage_target = ittage->Lookup(uop->eip, uop->ittage);
+		if (ittage_target)
+			target = ittage_target;
+	}
+
 	// If there was a hit, we know whether branch is a call.
 	// In this case, push return address into RAS. To avoid
 	// updates at recovery, do it only for non-spec instructions.
@@ -398,6 +600,10 @@ void BranchPredictor::UpdateBtb(Uop *uop)
 	if (kind == KindPerfect)
 		return;
 
+	// ITTAGE predictor, if it was looked up
+	if (uop->ittage.valid)
+		ittage->Update(uop->neip, uop->ittage);
+
 	// Search address in BTB
 	int set = uop->eip & (btb_num_sets - 1);
 	for (int way = 0; way < btb_num_ways; way++)
@@ -441,6 +647,27 @@ void BranchPredictor::UpdateBtb(Uop *uop)
 }
 
 
+void BranchPredictor::WarmUp(Uop *uop)
+{
+	// Save statistics
+	long long accesses = this->accesses;
+	long long hits = this->hits;
+
+	// Look up as done in the fetch stage
+	unsigned target = LookupBtb(uop);
+	bool taken = Lookup(uop) == PredictionTaken && target;
+	uop->predicted_neip = taken ? target : uop->eip + uop->mop_size;
+
+	// Update as done in the commit stage
+	Update(uop);
+	UpdateBtb(uop);
+
+	// Restore statistics
+	this->accesses = accesses;
+	this->hits = hits;
+}
+
+
 unsigned int BranchPredictor::getNextBranch(unsigned int eip,
 		unsigned int block_size)
 {
@@ -26,6 +26,9 @@
 #include <lib/cpp/Error.h>
 #include <lib/cpp/IniFile.h>
 
+#include "PerceptronPredictor.h"
+#include "TagePredictor.h"
+
 
 namespace x86
 {
@@ -54,12 +57,25 @@ public:
 		KindNottaken,
 		KindBimod,
 		KindTwoLevel,
-		KindCombined
+		KindCombined,
+		KindTage,
+		KindPerceptron
 	};
 
 	/// string map of branch predictor kind
 	static misc::StringMap KindMap;
 
+	/// Predictor of the targets of indirect jumps and calls
+	enum IndirectKind
+	{
+		IndirectKindInvalid = 0,
+		IndirectKindBtb,
+		IndirectKindIttage
+	};
+
+	/// String map of indirect predictor kind
+	static misc::StringMap IndirectKindMap;
+
 private:
 
 	//
@@ -96,6 +112,56 @@ private:
 	// Height of the level 2 table of the two-level predictor
 	static int two_level_l2_height;
 
+	// Number of tagged tables of the TAGE predictor
+	static int tage_num_tables;
+
+	// Size of the base table of the TAGE predictor
+	static int tage_base_size;
+
+	// Size of each tagged table of the TAGE predictor
+	static int tage_table_size;
+
+	// Bits of the tags of the TAGE predictor
+	static int tage_tag_bits;
+
+	// Shortest and longest histories of the TAGE predictor
+	static int tage_min_history;
+	static int tage_max_history;
+
+	// Size of the loop predictor of the TAGE predictor, or 0 for none
+	static int tage_loop_size;
+
+	// Statistical corrector in the TAGE predictor
+	static bool tage_statistical_corrector;
+
+	// Number of tables of the perceptron predictor
+	static int perceptron_num_tables;
+
+	// Size of each table of the perceptron predictor
+	static int perceptron_table_size;
+
+	// Longest history of the perceptron predictor
+	static int perceptron_history_size;
+
+	// Indirect branch target predictor kind
+	static IndirectKind indirect_kind;
+
+	// Number of tagged tables of the ITTAGE predictor
+	static int ittage_num_tables;
+
+	// Size of the base table of the ITTAGE predictor
+	static int ittage_base_size;
+
+	// Size of each tagged table of the ITTAGE predictor
+	static int ittage_table_size;
+
+	// Bits of the tags of the ITTAGE predictor
+	static int ittage_tag_bits;
+
+	// Shortest and longest histories of the ITTAGE predictor
+	static int ittage_min_history;
+	static int ittage_max_history;
+
 
 
 
@@ -138,6 +204,18 @@ private:
 	//   2,3 - Use two-level adaptive predictor
 	std::unique_ptr<char[]> choice;
 
+	// TAGE predictor
+	std::unique_ptr<TagePredictor> tage;
+
+	// Hashed perceptron predictor
+	std::unique_ptr<PerceptronPredictor> perceptron;
+
+	// ITTAGE indirect branch target predictor
+	std::unique_ptr<IttagePredictor> ittage;
+
+	// Insert a branch fetched in the correct path in the global histories
+	void UpdateHistory(Uop *uop);
+
 	// Stats 
 	long long accesses = 0;
 	long long hits = 0;
@@ -185,6 +263,42 @@ public:
 
 	static int getTwoLevelL2Height() { return two_level_l2_height; }
 
+	static int getTageNumTables() { return tage_num_tables; }
+
+	static int getTageBaseSize() { return tage_base_size; }
+
+	static int getTageTableSize() { return tage_table_size; }
+
+	static int getTageTagBits() { return tage_tag_bits; }
+
+	static int getTageMinHistory() { return tage_min_history; }
+
+	static int getTageMaxHistory() { return tage_max_history; }
+
+	static int getTageLoopSize() { return tage_loop_size; }
+
+	static bool getTageStatisticalCorrector() { return tage_statistical_corrector; }
+
+	static int getPerceptronNumTables() { return perceptron_num_tables; }
+
+	static int getPerceptronTableSize() { return perceptron_table_size; }
+
+	static int getPerceptronHistorySize() { return perceptron_history_size; }
+
+	static IndirectKind getIndirectKind() { return indirect_kind; }
+
+	static int getIttageNumTables() { return ittage_num_tables; }
+
+	static int getIttageBaseSize() { return ittage_base_size; }
+
+	static int getIttageTableSize() { return ittage_table_size; }
+
+	static int getIttageTagBits() { return ittage_tag_bits; }
+
+	static int getIttageMinHistory() { return ittage_min_history; }
+
+	static int getIttageMaxHistory() { return ittage_max_history; }
+
 
 
 
@@ -250,7 +364,8 @@ public:
 	/// Lookup BTB. If it contains the uop address, return target. The BTB
 	/// also contains information about the type of branch, i.e., jump,
 	/// call, ret, or conditional. If instruction is call or ret, access RAS
-	/// instead of BTB.
+	/// instead of BTB. If an ITTAGE predictor is present, it provides the
+	/// target of indirect jumps and calls found in the BTB.
 	///
 	/// \param uop
 	/// 	Micro-instruction capturing all the information related with the
@@ -269,6 +384,17 @@ public:
 	///
 	void UpdateBtb(Uop *uop);
 
+	/// Update the branch predictor, BTB, and return address stack for a
+	/// branch executed functionally, as if it had been fetched and
+	/// committed. Statistics are not affected. This is used to warm up
+	/// the predictor in sampled simulation.
+	///
+	/// \param uop
+	/// 	Non-speculative micro-instruction with fields \c eip, \c neip,
+	/// 	and \c mop_size initialized.
+	///
+	void WarmUp(Uop *uop);
+
 	/// Find address of next branch after eip within current block.
 	/// This is useful for accessing the trace cache. At that point, the
 	/// uop is not ready to call \c LookupBtb(), since functional simulation
@@ -17,6 +17,9 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "Core.h"
 #include "Cpu.h"
 #include "Timing.h"
@@ -28,7 +31,8 @@ namespace x86
 Core::Core(Cpu *cpu,
 		int id) :
 		cpu(cpu),
-		id(id)
+		id(id),
+		event_queue(Alu::getMaxOperationLatency())
 {
 	// Assign name
 	name = misc::fmt("Core %d", id);
@@ -57,22 +61,9 @@ void Core::InsertInEventQueue(std::shared_ptr<Uop> uop, int latency)
 	assert(!uop->completed);
 	uop->complete_when = cpu->getCycle() + latency;
 
-	// Find position in event queue
-	auto it = event_queue.begin();
-	auto e = event_queue.end();
-	while (it != e)
-	{
-		// Check if position found
-		if (uop->Compare(it->get()) < 0)
-			break;
-
-		// Next
-		++it;
-	}
-
 	// Insert
-	uop->event_queue_iterator = event_queue.insert(it, uop);
 	uop->in_event_queue = true;
+	event_queue.Insert(uop);
 }
 
 
@@ -81,15 +72,11 @@ void Core::ExtractFromEventQueue(Uop *uop)
 	// Uop must be in the queue
 	assert(uop->in_event_queue);
 
-	// Save iterator
-	auto it = uop->event_queue_iterator;
-
 	// Indicate that the uop is not in the queue anymore
 	uop->in_event_queue = false;
-	uop->event_queue_iterator = event_queue.end();
 
 	// Remove it as the last step, as this may free the uop
-	event_queue.erase(it);
+	event_queue.Remove(uop);
 }
 
 
@@ -345,12 +332,10 @@ void Core::Writeback()
 		// loads that were squashed, or stores that committed before
 		// being issued.
 		if (uop->in_reorder_buffer)
-			Timing::trace << misc::fmt("x86.inst "
-					"id=%lld "
-					"core=%d "
-					"stg=\"wb\"\n",
-					uop->getIdInCore(),
-					id);
+			Timing::trace.Line("x86.inst")
+					.Number("id", uop->getIdInCore())
+					.Number("core", id)
+					.String("stg", "wb");
 
 		// Instruction has completed
 		uop->completed = true;
@@ -373,7 +358,14 @@ void Core::Writeback()
 		// Recover from mispeculation
 		if (recover)
 			thread->Recover();
+
+		// Replay a load found to violate a memory dependence when an
+		// older store was woken up by this uop
+		thread->RecoverMemoryViolation();
 	}
+
+	// All uops completing up to this cycle were extracted
+	event_queue.Advance(cpu->getCycle());
 }
 
 
@@ -461,5 +453,63 @@ void Core::Run()
 	Fetch();
 }
 
+
+long long Core::getQuiescentUntil()
+{
+	// Writeback stage must run when the uop at the head of the event queue
+	// completes.
+	long long until = std::numeric_limits<long long>::max();
+	if (event_queue.size())
+	{
+		until = event_queue.front()->complete_when;
+		if (until <= cpu->getCycle())
+			return 0;
+	}
+
+	// All threads must be quiescent. In an idle cycle, round-robin
+	// pointers of all stages go around all threads and return to their
+	// original value, so they need no update.
+	for (auto &thread : threads)
+	{
+		long long thread_until = thread->getQuiescentUntil();
+		if (!thread_until)
+			return 0;
+		until = std::min(until, thread_until);
+	}
+
+	// Quiescent
+	return until;
+}
+
+
+void Core::SkipCycles(long long num_cycles)
+{
+	// Dispatch stalls. See Dispatch() for the slots accounted in a cycle
+	// in which no thread can dispatch.
+	switch (Cpu::getDispatchKind())
+	{
+
+	case Cpu::DispatchKindShared:
+
+		// One slot lost by each thread
+		for (auto &thread : threads)
+			incDispatchStall(thread->canDispatch(), num_cycles);
+		break;
+
+	case Cpu::DispatchKindTimeslice:
+	{
+		// Whole dispatch width lost by the current thread
+		Thread *thread = getThread(current_dispatch_thread);
+		incDispatchStall(thread->canDispatch(),
+				num_cycles * Cpu::getDispatchWidth());
+		break;
+	}
+
+	default:
+
+		throw misc::Panic("Invalid dispatch kind");
+	}
+}
+
 }
 
@@ -21,12 +21,12 @@
 #define ARCH_X86_TIMING_CORE_H
 
 #include <vector>
-#include <list>
 #include <string>
 
 #include <arch/x86/emulator/Uinst.h>
 
 #include "Alu.h"
+#include "EventQueue.h"
 #include "Thread.h"
 
 
@@ -58,7 +58,7 @@ private:
 	Alu alu;
 
 	// Event queue
-	std::list<std::shared_ptr<Uop>> event_queue;
+	EventQueue event_queue;
 
 
 
@@ -290,18 +290,19 @@ public:
 	/// set to the current cycle plus \a latency in the function.
 	void InsertInEventQueue(std::shared_ptr<Uop> uop, int latency);
 
-	/// Extract uop from event queue. The given uop must be placed at the
-	/// head of the event queue.
+	/// Extract uop from event queue. The given uop can be placed in any
+	/// position of the event queue.
 	void ExtractFromEventQueue(Uop *uop);
 
-	/// Return an iterator to the first element of the event queue
-	std::list<std::shared_ptr<Uop>>::iterator getEventQueueBegin()
+	/// Return an iterator to the first element of the event queue. Uops
+	/// are not traversed in order of completion.
+	EventQueue::Iterator getEventQueueBegin() const
 	{
 		return event_queue.begin();
 	}
 
 	/// Return a past-the-end iterator to the event queue
-	std::list<std::shared_ptr<Uop>>::iterator getEventQueueEnd()
+	EventQueue::Iterator getEventQueueEnd() const
 	{
 		return event_queue.end();
 	}
@@ -401,6 +402,18 @@ public:
 	void Commit();
 
 
+	/// Return 0 if running the pipeline stages of the core in the current
+	/// cycle could have any effect. Otherwise, return the first cycle when
+	/// they must run regardless of events in the memory hierarchy, or the
+	/// maximum \c long \c long value if there is no such cycle.
+	long long getQuiescentUntil();
+
+	/// Account for \a num_cycles skipped cycles in which the core was
+	/// quiescent, updating the statistics that the pipeline stages
+	/// would have updated in each of them.
+	void SkipCycles(long long num_cycles);
+
+
 
 
 	//
@@ -409,7 +422,7 @@ public:
 
 	/// Increment the counter for reasons of dispatch stalls by the given
 	/// quantum.
-	void incDispatchStall(Thread::DispatchStall stall, int quantum)
+	void incDispatchStall(Thread::DispatchStall stall, long long quantum)
 	{
 		assert(stall > Thread::DispatchStallInvalid && stall < Thread::DispatchStallMax);
 		dispatch_stall[stall] += quantum;
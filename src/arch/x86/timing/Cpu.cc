@@ -17,6 +17,8 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+
 #include "Cpu.h"
 #include "Timing.h"
 
@@ -72,6 +74,13 @@ misc::StringMap Cpu::load_store_queue_kind_map =
 	{"Private", LoadStoreQueueKindPrivate},
 };
 
+misc::StringMap Cpu::memory_dependence_kind_map =
+{
+	{"None", MemoryDependenceKindNone},
+	{"Conservative", MemoryDependenceKindConservative},
+	{"StoreSet", MemoryDependenceKindStoreSet},
+};
+
 int Cpu::num_cores = 1;
 int Cpu::num_threads = 1;
 int Cpu::context_quantum;
@@ -97,6 +106,10 @@ Cpu::InstructionQueueKind Cpu::instruction_queue_kind;
 int Cpu::instruction_queue_size;
 Cpu::LoadStoreQueueKind Cpu::load_store_queue_kind;
 int Cpu::load_store_queue_size;
+Cpu::MemoryDependenceKind Cpu::memory_dependence_kind;
+int Cpu::ssit_size;
+int Cpu::lfst_size;
+int Cpu::ssit_clear_interval;
 int Cpu::uop_queue_size;
 
 esim::Event *Cpu::event_memory_access_start;
@@ -173,6 +186,24 @@ void Cpu::ParseConfiguration(misc::IniFile *ini_file)
 			load_store_queue_kind_map, LoadStoreQueueKindPrivate);
 	load_store_queue_size = ini_file->ReadInt(section, "LsqSize", 20);
 	uop_queue_size = ini_file->ReadInt(section, "UopQueueSize", 32);
+	memory_dependence_kind = (MemoryDependenceKind) ini_file->ReadEnum(section,
+			"MemDepKind", memory_dependence_kind_map,
+			MemoryDependenceKindNone);
+	ssit_size = ini_file->ReadInt(section, "SsitSize", 1024);
+	lfst_size = ini_file->ReadInt(section, "LfstSize", 128);
+	ssit_clear_interval = ini_file->ReadInt(section, "SsitClearInterval",
+			1000000);
+
+	// Integrity
+	if (ssit_size < 1 || (ssit_size & (ssit_size - 1)))
+		throw Timing::Error(misc::fmt("%s: 'SsitSize' must be a power "
+				"of 2 greater than 0", section.c_str()));
+	if (lfst_size < 1)
+		throw Timing::Error(misc::fmt("%s: 'LfstSize' must be greater "
+				"than 0", section.c_str()));
+	if (ssit_clear_interval < 0)
+		throw Timing::Error(misc::fmt("%s: Invalid value for "
+				"'SsitClearInterval'", section.c_str()));
 }
 
 
@@ -187,17 +218,63 @@ void Cpu::Run()
 }
 
 
+long long Cpu::getQuiescentUntil()
+{
+	// The emulator must not have pending actions on contexts. Suspended
+	// contexts may be woken up at any time by host threads or system
+	// call callbacks, so they prevent quiescence as well.
+	Emulator *emulator = Emulator::getInstance();
+	if (emulator->schedule_signal ||
+			emulator->getNumSuspendedContexts() ||
+			emulator->isProcessEventsScheduled())
+		return 0;
+
+	// Uop trace is dumped cycle by cycle
+	if (Timing::trace)
+		return 0;
+
+	// The scheduler must run when the quantum of a context expires
+	long long until = min_context_allocate_cycle + context_quantum;
+	if (until <= getCycle())
+		return 0;
+
+	// Maximum number of cycles
+	if (max_cycles)
+		until = std::min(until, max_cycles);
+
+	// All cores must be quiescent
+	for (auto &core : cores)
+	{
+		long long core_until = core->getQuiescentUntil();
+		if (!core_until)
+			return 0;
+		until = std::min(until, core_until);
+	}
+
+	// Quiescent
+	return until;
+}
+
+
+void Cpu::SkipCycles(long long num_cycles)
+{
+	for (auto &core : cores)
+		core->SkipCycles(num_cycles);
+}
+
+
 void Cpu::MemoryAccess(mem::Module *module,
 			mem::Module::AccessType access_type,
 			unsigned address,
 			std::shared_ptr<Uop> uop)
 {
 	// New frame
-	auto frame = misc::new_shared<MemoryAccessFrame>();
+	auto frame = esim::new_frame<MemoryAccessFrame>();
 	frame->module = module;
 	frame->access_type = access_type;
 	frame->address = address;
 	frame->uop = uop;
+	frame->num_replays = uop->num_replays;
 
 	// Schedule event
 	esim::Engine *esim_engine = esim::Engine::getInstance();
@@ -219,10 +296,17 @@ void Cpu::MemoryAccessHandler(esim::Event *event, esim::Frame *esim_frame)
 				frame->access_type,
 				frame->address,
 				nullptr,
-				event_memory_access_end);
+				event_memory_access_end,
+				&frame->uop->memory_miss,
+				frame->uop->eip);
 	}
 	else if (event == event_memory_access_end)
 	{
+		// Ignore the access if the uop was replayed after a memory
+		// dependence violation while the access was in flight
+		if (frame->uop->num_replays != frame->num_replays)
+			return;
+
 		// Insert uop into the core's event queue
 		Core *core = frame->uop->getCore();
 		core->InsertInEventQueue(frame->uop, 0);
@@ -264,11 +348,9 @@ void Cpu::EmptyTraceList()
 		uop->trace_list_iterator = trace_list.end();
 
 		// Trace
-		Timing::trace << misc::fmt("x86.end_inst "
-				"id=%lld "
-				"core=%d\n",
-				uop->getIdInCore(),
-				uop->getCore()->getId());
+		Timing::trace.Line("x86.end_inst")
+				.Number("id", uop->getIdInCore())
+				.Number("core", uop->getCore()->getId());
 	}
 }
 
@@ -38,6 +38,7 @@ namespace x86
 {
 
 // Forward declaration
+class Profiler;
 class Timing;
 
 // Class Cpu
@@ -133,6 +134,18 @@ public:
 	/// Load/Store queue kind string map
 	static misc::StringMap load_store_queue_kind_map;
 
+	/// Policy for loads following stores with unknown addresses
+	enum MemoryDependenceKind
+	{
+		MemoryDependenceKindInvalid = 0,
+		MemoryDependenceKindNone,
+		MemoryDependenceKindConservative,
+		MemoryDependenceKindStoreSet
+	};
+
+	/// Memory dependence kind string map
+	static misc::StringMap memory_dependence_kind_map;
+
 	// Maximum number of cycles to simulate
 	static long long max_cycles;
 
@@ -179,6 +192,9 @@ private:
 	// MMU used by this CPU
 	std::shared_ptr<mem::Mmu> mmu;
 
+	// Profiler of the guest programs, or null if profiling is inactive
+	Profiler *profiler = nullptr;
+
 	// Name of currently simulated stage 
 	std::string stage;
 
@@ -260,6 +276,9 @@ private:
 
 		// Uop associated with the memory access
 		std::shared_ptr<Uop> uop;
+
+		// Number of replays of the uop when the access was issued
+		int num_replays = 0;
 	};
 
 	// Event scheduled to start a memory access
@@ -339,6 +358,18 @@ private:
 	// Load/Store queue size
 	static int load_store_queue_size;
 
+	// Memory dependence policy
+	static MemoryDependenceKind memory_dependence_kind;
+
+	// Number of entries of the store set identifier table (SSIT)
+	static int ssit_size;
+
+	// Number of entries of the last fetched store table (LFST)
+	static int lfst_size;
+
+	// Cycles between two invalidations of the SSIT, or 0 for none
+	static int ssit_clear_interval;
+
 	// Uop queue size
 	static int uop_queue_size;
 
@@ -356,6 +387,10 @@ private:
 	// UpdateContextAllocationCycle().
 	long long min_context_allocate_cycle = 0;
 
+	// If true, contexts are being evicted from all hardware threads, and
+	// the scheduler does not allocate new ones until Resume() is called.
+	bool draining = false;
+
 public:
 
 	//
@@ -398,6 +433,19 @@ public:
 	/// Get load/store queue size
 	static int getLoadStoreQueueSize() { return load_store_queue_size; }
 
+	/// Get memory dependence policy
+	static MemoryDependenceKind getMemoryDependenceKind() { return memory_dependence_kind; }
+
+	/// Get number of entries of the store set identifier table
+	static int getSsitSize() { return ssit_size; }
+
+	/// Get number of entries of the last fetched store table
+	static int getLfstSize() { return lfst_size; }
+
+	/// Get number of cycles between invalidations of the store set
+	/// identifier table
+	static int getSsitClearInterval() { return ssit_clear_interval; }
+
 	/// Return the size of the uop queue, as configured by the user
 	static int getUopQueueSize() { return uop_queue_size; }
 
@@ -472,6 +520,14 @@ public:
 	/// Get the MMU
 	mem::Mmu *getMmu() { return mmu.get(); }
 
+	/// Set the profiler of the guest programs, or null to deactivate
+	/// profiling. The profiler is owned by the caller.
+	void setProfiler(Profiler *profiler) { this->profiler = profiler; }
+
+	/// Return the profiler of the guest programs, or null if profiling is
+	/// inactive
+	Profiler *getProfiler() const { return profiler; }
+
 	/// Return the current cycle in the CPU's frequency domain. We cannot
 	/// make this function inline to avoid the cross-dependency between
 	/// classes Cpu and Timing.
@@ -489,6 +545,16 @@ public:
 	/// Simulate one cycle of the CPU for all its cores and threads.
 	void Run();
 
+	/// Return 0 if simulating the current cycle of the CPU could have any
+	/// effect. Otherwise, return the first cycle that must be simulated
+	/// regardless of events in the memory hierarchy, or the maximum
+	/// \c long \c long value if there is no such cycle.
+	long long getQuiescentUntil();
+
+	/// Account for \a num_cycles cycles that were not simulated because
+	/// the CPU was quiescent.
+	void SkipCycles(long long num_cycles);
+
 	/// Update structure occupancy statistics
 	void UpdateOccupancyStats();
 
@@ -531,6 +597,19 @@ public:
 	/// exit with practically no cost.
 	void Schedule();
 
+	/// Signal the eviction of the contexts allocated to all hardware
+	/// threads, and stop allocating contexts until Resume() is invoked.
+	/// Threads stop fetching, and each context is evicted when its
+	/// pipeline becomes empty.
+	void Drain();
+
+	/// Return true if no context is allocated to any hardware thread
+	bool isDrained() const;
+
+	/// Allow the scheduler to allocate contexts again after a call to
+	/// Drain().
+	void Resume();
+
 
 
 
@@ -54,15 +54,11 @@ void Cpu::AllocateContext(Context *context)
 			thread->getIdInCore());
 
 	// Trace
-	Timing::trace << misc::fmt("x86.map_ctx "
-			"ctx=%d "
-			"core=%d "
-			"thread=%d "
-			"ppid=%d\n",
-			context->getId(),
-			core->getId(),
-			thread->getIdInCore(),
-			context->getParentId());
+	Timing::trace.Line("x86.map_ctx")
+			.Number("ctx", context->getId())
+			.Number("core", core->getId())
+			.Number("thread", thread->getIdInCore())
+			.Number("ppid", context->getParentId());
 }
 
 
@@ -144,9 +140,10 @@ void Cpu::Schedule()
 
 	// Check for quick scheduler end. The only way to effectively execute
 	// the scheduler is that either a quantum expired or a signal to
-	// reschedule has been flagged.
+	// reschedule has been flagged. The scheduler does not run while the
+	// pipelines are drained.
 	Emulator *emulator = Emulator::getInstance();
-	if (!quantum_expired && !emulator->schedule_signal)
+	if ((!quantum_expired && !emulator->schedule_signal) || draining)
 		return;
 
 	// Debug
@@ -199,5 +196,38 @@ void Cpu::Schedule()
 	UpdateContextAllocationCycle();
 }
 
+
+void Cpu::Drain()
+{
+	// Signal eviction of all allocated contexts
+	draining = true;
+	for (auto &core : cores)
+	{
+		for (int i = 0; i < core->getNumThreads(); i++)
+		{
+			Thread *thread = core->getThread(i);
+			if (thread->context && !thread->context->evict_signal)
+				thread->EvictContextSignal();
+		}
+	}
 }
 
+
+bool Cpu::isDrained() const
+{
+	for (auto &core : cores)
+		for (int i = 0; i < core->getNumThreads(); i++)
+			if (core->getThread(i)->context)
+				return false;
+	return true;
+}
+
+
+void Cpu::Resume()
+{
+	// Force the scheduler to allocate contexts in the next cycle
+	draining = false;
+	emulator->schedule_signal = true;
+}
+
+}
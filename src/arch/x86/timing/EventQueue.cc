@@ -0,0 +1,194 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "EventQueue.h"
+#include "Uop.h"
+
+
+namespace x86
+{
+
+
+static int getNumBuckets(int max_latency)
+{
+	// Power of two covering the current cycle and the longest latency
+	int num_buckets = 16;
+	while (num_buckets <= max_latency)
+		num_buckets *= 2;
+	return num_buckets;
+}
+
+
+EventQueue::Iterator::Iterator(const EventQueue *queue, int bucket,
+		int index) :
+		queue(queue),
+		bucket(bucket),
+		index(index)
+{
+	Normalize();
+}
+
+
+void EventQueue::Iterator::Normalize()
+{
+	int num_buckets = queue->buckets.size();
+	while (bucket < num_buckets &&
+			index >= (int) queue->buckets[bucket].size())
+	{
+		bucket++;
+		index = 0;
+	}
+}
+
+
+const std::shared_ptr<Uop> &EventQueue::Iterator::operator*() const
+{
+	if (bucket < (int) queue->buckets.size())
+		return queue->buckets[bucket][index];
+	return queue->overflow[index];
+}
+
+
+EventQueue::Iterator &EventQueue::Iterator::operator++()
+{
+	index++;
+	Normalize();
+	return *this;
+}
+
+
+EventQueue::EventQueue(int max_latency) :
+		buckets(getNumBuckets(max_latency)),
+		busy_buckets(buckets.size()),
+		mask(buckets.size() - 1)
+{
+}
+
+
+bool EventQueue::CompareUops(const std::shared_ptr<Uop> &a,
+		const std::shared_ptr<Uop> &b)
+{
+	return a->Compare(b.get()) > 0;
+}
+
+
+void EventQueue::InsertInBucket(std::shared_ptr<Uop> uop)
+{
+	// Uops are usually inserted in order of identifier, so look for the
+	// position starting at the end of the bucket.
+	int index = uop->complete_when & mask;
+	std::vector<std::shared_ptr<Uop>> &bucket = buckets[index];
+	auto it = bucket.end();
+	while (it != bucket.begin() && (*(it - 1))->getId() > uop->getId())
+		--it;
+	bucket.insert(it, std::move(uop));
+	busy_buckets.Set(index);
+	num_uops_in_buckets++;
+}
+
+
+void EventQueue::Insert(std::shared_ptr<Uop> uop)
+{
+	// Insert in the wheel if its cycle is covered
+	assert(uop->complete_when >= base);
+	if (uop->complete_when < getHorizon())
+	{
+		InsertInBucket(std::move(uop));
+		return;
+	}
+
+	// Insert in overflow heap
+	overflow.push_back(std::move(uop));
+	std::push_heap(overflow.begin(), overflow.end(), CompareUops);
+}
+
+
+void EventQueue::Remove(Uop *uop)
+{
+	// Uop in the wheel
+	if (uop->complete_when < getHorizon())
+	{
+		int index = uop->complete_when & mask;
+		std::vector<std::shared_ptr<Uop>> &bucket = buckets[index];
+		auto it = std::find_if(bucket.begin(), bucket.end(),
+				[uop](const std::shared_ptr<Uop> &entry)
+				{
+					return entry.get() == uop;
+				});
+		assert(it != bucket.end());
+
+		// Remove it as the last step, as this may free the uop
+		std::shared_ptr<Uop> entry = std::move(*it);
+		bucket.erase(it);
+		if (bucket.empty())
+			busy_buckets.Reset(index);
+		num_uops_in_buckets--;
+		return;
+	}
+
+	// Uop in the overflow heap
+	auto it = std::find_if(overflow.begin(), overflow.end(),
+			[uop](const std::shared_ptr<Uop> &entry)
+			{
+				return entry.get() == uop;
+			});
+	assert(it != overflow.end());
+	std::shared_ptr<Uop> entry = std::move(*it);
+	overflow.erase(it);
+	std::make_heap(overflow.begin(), overflow.end(), CompareUops);
+}
+
+
+const std::shared_ptr<Uop> &EventQueue::front() const
+{
+	// Uops in the overflow heap complete after those in the wheel
+	assert(!empty());
+	if (!num_uops_in_buckets)
+		return overflow.front();
+
+	// First busy bucket starting at the base cycle
+	size_t index = busy_buckets.FindNext(base & mask);
+	if (index == buckets.size())
+		index = busy_buckets.FindNext(0);
+	return buckets[index].front();
+}
+
+
+void EventQueue::Advance(long long cycle)
+{
+	// Move base cycle
+	assert(cycle >= base);
+	assert(empty() || front()->complete_when >= cycle);
+	base = cycle;
+
+	// Move uops now covered by the wheel out of the overflow heap
+	while (!overflow.empty() && overflow.front()->complete_when <
+			getHorizon())
+	{
+		std::pop_heap(overflow.begin(), overflow.end(), CompareUops);
+		InsertInBucket(std::move(overflow.back()));
+		overflow.pop_back();
+	}
+}
+
+
+}  // namespace x86
@@ -0,0 +1,153 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_EVENT_QUEUE_H
+#define ARCH_X86_TIMING_EVENT_QUEUE_H
+
+#include <memory>
+#include <vector>
+
+#include <lib/cpp/Bitmap.h>
+
+
+namespace x86
+{
+
+// Forward declarations
+class Uop;
+
+
+/// Queue of uops waiting for their results to be written back, ordered by
+/// completion cycle (field Uop::complete_when), and by uop identifier among
+/// uops completing in the same cycle.
+///
+/// Uops are kept in a timing wheel with one bucket per cycle, covering as
+/// many cycles as the longest latency of a functional unit. Memory accesses
+/// insert their uops when they complete, so they do not extend the wheel.
+/// Uops completing beyond the cycles covered by the wheel are kept in an
+/// overflow heap, and moved into the wheel as the writeback stage advances.
+class EventQueue
+{
+	// Buckets of uops completing in the same cycle, indexed by the cycle
+	// modulo the number of buckets. Uops in a bucket are sorted by
+	// identifier.
+	std::vector<std::vector<std::shared_ptr<Uop>>> buckets;
+
+	// Buckets that contain uops
+	misc::Bitmap busy_buckets;
+
+	// Mask applied to a cycle to obtain its bucket
+	long long mask;
+
+	// First cycle covered by the wheel. Every uop in the buckets completes
+	// between this cycle and the horizon.
+	long long base = 0;
+
+	// Number of uops in the buckets
+	int num_uops_in_buckets = 0;
+
+	// Uops completing at the horizon or later, as a heap with the earliest
+	// uop on top
+	std::vector<std::shared_ptr<Uop>> overflow;
+
+	// Comparison of uops for the overflow heap, true if \a a completes
+	// after \a b
+	static bool CompareUops(const std::shared_ptr<Uop> &a,
+			const std::shared_ptr<Uop> &b);
+
+	// Return the first cycle not covered by the wheel
+	long long getHorizon() const { return base + buckets.size(); }
+
+	// Insert a uop in the bucket of its completion cycle, keeping the
+	// bucket sorted
+	void InsertInBucket(std::shared_ptr<Uop> uop);
+
+public:
+
+	/// Iterator over the uops of the queue, in no particular order
+	class Iterator
+	{
+		const EventQueue *queue;
+
+		// Bucket, or number of buckets for the overflow heap
+		int bucket;
+
+		// Index in the bucket or in the overflow heap
+		int index;
+
+		// Skip empty buckets
+		void Normalize();
+
+	public:
+
+		/// Constructor
+		Iterator(const EventQueue *queue, int bucket, int index);
+
+		/// Return the uop
+		const std::shared_ptr<Uop> &operator*() const;
+
+		/// Move to the next uop
+		Iterator &operator++();
+
+		/// Compare iterators
+		bool operator!=(const Iterator &other) const
+		{
+			return bucket != other.bucket || index != other.index;
+		}
+	};
+
+	/// Constructor of a queue for uops completing at most \a max_latency
+	/// cycles after they are inserted
+	explicit EventQueue(int max_latency);
+
+	/// Insert a uop. Its completion cycle must be set, and must not be
+	/// earlier than the last cycle passed to Advance().
+	void Insert(std::shared_ptr<Uop> uop);
+
+	/// Extract a uop in any position of the queue
+	void Remove(Uop *uop);
+
+	/// Return the uop completing first. The queue must not be empty.
+	const std::shared_ptr<Uop> &front() const;
+
+	/// Move the wheel forward to cycle \a cycle, once all uops completing
+	/// earlier have been extracted. No uop can be inserted with an earlier
+	/// completion cycle afterwards.
+	void Advance(long long cycle);
+
+	/// Return the number of uops in the queue
+	int size() const { return num_uops_in_buckets + overflow.size(); }
+
+	/// Return true if the queue is empty
+	bool empty() const { return !size(); }
+
+	/// Iterator to the first uop
+	Iterator begin() const { return Iterator(this, 0, 0); }
+
+	/// Iterator past the last uop
+	Iterator end() const
+	{
+		return Iterator(this, buckets.size(), overflow.size());
+	}
+};
+
+
+}  // namespace x86
+
+#endif
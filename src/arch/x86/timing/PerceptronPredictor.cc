@@ -0,0 +1,113 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#include "PerceptronPredictor.h"
+
+
+namespace x86
+{
+
+PerceptronPredictor::PerceptronPredictor(int num_tables,
+		int log_table_size,
+		int history_size) :
+		num_tables(num_tables),
+		log_table_size(log_table_size),
+		weights(num_tables << log_table_size),
+		history(history_size),
+		threshold(2 * num_tables + 14)
+{
+	// Tables other than the first use geometric history lengths, from 2
+	// bits up to the history size
+	assert(num_tables > 1 && num_tables <= MaxTables);
+	for (int i = 1; i < num_tables; i++)
+	{
+		double ratio = history_size / 2.0;
+		int length = num_tables == 2 ? history_size :
+				(int) (2 * std::pow(ratio, (double) (i - 1) /
+				(num_tables - 2)) + 0.5);
+		folded_history[i] = FoldedHistory(length, log_table_size);
+	}
+}
+
+
+bool PerceptronPredictor::Lookup(unsigned eip, Info &info)
+{
+	// Add weights
+	int mask = (1 << log_table_size) - 1;
+	info.sum = 0;
+	for (int i = 0; i < num_tables; i++)
+	{
+		info.index[i] = (eip ^ (eip >> log_table_size) ^ (i << 2) ^
+				folded_history[i].getValue()) & mask;
+		info.sum += weights[(i << log_table_size) + info.index[i]];
+	}
+
+	// Return prediction
+	return info.sum >= 0;
+}
+
+
+void PerceptronPredictor::UpdateHistory(bool taken)
+{
+	history.Push(taken);
+	for (int i = 1; i < num_tables; i++)
+		folded_history[i].Update(history);
+}
+
+
+void PerceptronPredictor::Update(bool taken, const Info &info)
+{
+	// Adapt threshold, so that mispredictions and low-confidence
+	// predictions are trained with a similar frequency
+	bool prediction = info.sum >= 0;
+	if (prediction != taken)
+		threshold_counter++;
+	else if (std::abs(info.sum) <= threshold)
+		threshold_counter--;
+	if (threshold_counter >= 64)
+	{
+		threshold++;
+		threshold_counter = 0;
+	}
+	else if (threshold_counter <= -64 && threshold > 1)
+	{
+		threshold--;
+		threshold_counter = 0;
+	}
+
+	// Train weights
+	if (prediction == taken && std::abs(info.sum) > threshold)
+		return;
+	for (int i = 0; i < num_tables; i++)
+	{
+		signed char &weight = weights[(i << log_table_size) +
+				info.index[i]];
+		if (taken && weight < 127)
+			weight++;
+		else if (!taken && weight > -128)
+			weight--;
+	}
+}
+
+
+}  // namespace x86
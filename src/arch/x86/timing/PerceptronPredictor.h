@@ -0,0 +1,108 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_PERCEPTRON_PREDICTOR_H
+#define ARCH_X86_TIMING_PERCEPTRON_PREDICTOR_H
+
+#include <vector>
+
+#include "BranchHistory.h"
+
+
+namespace x86
+{
+
+/// Hashed perceptron conditional branch predictor. Each table holds signed
+/// weights indexed by a hash of the branch address and a segment of the
+/// global history, of geometrically increasing lengths. The first table is
+/// indexed by the address only. The branch is predicted taken if the sum of
+/// the selected weights is not negative, and the weights are trained on a
+/// misprediction or when the sum is below an adaptive threshold.
+class PerceptronPredictor
+{
+public:
+
+	/// Maximum number of tables
+	static const int MaxTables = 16;
+
+	/// Information obtained on a lookup, needed to update the predictor
+	struct Info
+	{
+		// Index of the branch in each table
+		unsigned short index[MaxTables];
+
+		// Sum of the weights
+		int sum;
+	};
+
+private:
+
+	// Number of tables
+	int num_tables;
+
+	// Log base 2 of the number of weights in each table
+	int log_table_size;
+
+	// Tables of 8-bit weights, 'num_tables' tables of 2^log_table_size
+	// weights
+	std::vector<signed char> weights;
+
+	// Global history
+	BranchHistory history;
+
+	// Global history folded for each table
+	FoldedHistory folded_history[MaxTables];
+
+	// Training threshold, and counter adapting it
+	int threshold;
+	int threshold_counter = 0;
+
+public:
+
+	/// Constructor
+	///
+	/// \param num_tables
+	///	Number of tables, between 2 and MaxTables.
+	///
+	/// \param log_table_size
+	///	Log base 2 of the number of weights of each table.
+	///
+	/// \param history_size
+	///	Global history length of the last table.
+	///
+	PerceptronPredictor(int num_tables, int log_table_size,
+			int history_size);
+
+	/// Return the prediction for the conditional branch at \a eip, and
+	/// save in \a info the information needed to update the predictor.
+	bool Lookup(unsigned eip, Info &info);
+
+	/// Insert the direction of a branch in the global history. This is
+	/// done after the lookup of every branch in the correct path.
+	void UpdateHistory(bool taken);
+
+	/// Train the predictor with the direction of a committed branch,
+	/// given the information saved on its lookup.
+	void Update(bool taken, const Info &info);
+};
+
+
+}  // namespace x86
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <fstream>
+
+#include <arch/common/CallStack.h>
+#include <lib/cpp/String.h>
+
+#include "Profiler.h"
+#include "Timing.h"
+#include "Uop.h"
+
+
+namespace x86
+{
+
+
+Profiler::Counters &Profiler::Counters::operator+=(const Counters &other)
+{
+	instructions += other.instructions;
+	uops += other.uops;
+	cycles += other.cycles;
+	cache_misses += other.cache_misses;
+	mispredictions += other.mispredictions;
+	return *this;
+}
+
+
+Profiler::Profiler(const std::string &path) : path(path)
+{
+	// Root of the tree of call stacks
+	nodes.push_back({ -1, -1 });
+}
+
+
+int Profiler::getFunction(Context *context, unsigned address,
+		unsigned &offset)
+{
+	// Symbol name, or address if not found
+	std::string name;
+	comm::CallStack *call_stack = context->getCallStack();
+	if (!call_stack || !call_stack->getSymbol(address, name, offset))
+	{
+		name = misc::fmt("0x%x", address);
+		offset = 0;
+	}
+
+	// Identifier
+	auto it = function_ids.find(name);
+	if (it != function_ids.end())
+		return it->second;
+	function_names.push_back(name);
+	function_ids[name] = function_names.size() - 1;
+	return function_names.size() - 1;
+}
+
+
+int Profiler::getChild(int node, Context *context, unsigned address)
+{
+	// Existing child
+	unsigned long long key = (unsigned long long) node << 32 | address;
+	auto it = node_children.find(key);
+	if (it != node_children.end())
+		return it->second;
+
+	// New child
+	unsigned offset;
+	int function = getFunction(context, address, offset);
+	nodes.push_back({ node, function });
+	node_children[key] = nodes.size() - 1;
+	return nodes.size() - 1;
+}
+
+
+int Profiler::getNode(Context *context)
+{
+	// No call stack
+	comm::CallStack *call_stack = context->getCallStack();
+	if (!call_stack)
+		return 0;
+
+	// Call stack did not change since last time
+	ContextNode &context_node = context_nodes[context];
+	if (context_node.version == call_stack->getVersion())
+		return context_node.node;
+
+	// Find node, starting at the outermost call
+	int node = 0;
+	for (const comm::CallStackFrame &frame : call_stack->getFrames())
+		node = getChild(node, context, frame.getIp());
+	context_node.version = call_stack->getVersion();
+	context_node.node = node;
+	return node;
+}
+
+
+void Profiler::Commit(Uop *uop, long long cycles)
+{
+	// Counters
+	Counters counters;
+	counters.instructions = !uop->mop_index;
+	counters.uops = 1;
+	counters.cycles = cycles;
+	counters.cache_misses = uop->memory_miss;
+	counters.mispredictions = (uop->getFlags() & Uinst::FlagCtrl) &&
+			uop->neip != uop->predicted_neip;
+
+	// Instruction, found on first use
+	auto it = instructions.find(uop->eip);
+	if (it == instructions.end())
+	{
+		Instruction instruction;
+		instruction.function = getFunction(uop->getContext(),
+				uop->eip, instruction.offset);
+		it = instructions.emplace(uop->eip, instruction).first;
+	}
+	Instruction &instruction = it->second;
+	instruction.counters += counters;
+
+	// Call stack
+	unsigned long long key = (unsigned long long) uop->profile_node << 32 |
+			instruction.function;
+	stack_counters[key] += counters;
+}
+
+
+std::string Profiler::getStackName(int node) const
+{
+	// Root
+	if (!node)
+		return "";
+
+	// Parent functions first
+	std::string name = getStackName(nodes[node].parent);
+	if (!name.empty())
+		name += ';';
+	return name + function_names[nodes[node].function];
+}
+
+
+void Profiler::DumpFlat(std::ostream &os) const
+{
+	// Add counters of each function
+	std::vector<Counters> functions(function_names.size());
+	Counters total;
+	for (auto &it : instructions)
+	{
+		functions[it.second.function] += it.second.counters;
+		total += it.second.counters;
+	}
+
+	// Sort functions by cycles
+	std::vector<int> function_order;
+	for (int i = 0; i < (int) functions.size(); i++)
+		if (functions[i].uops)
+			function_order.push_back(i);
+	std::sort(function_order.begin(), function_order.end(),
+			[&](int a, int b)
+			{
+				if (functions[a].cycles != functions[b].cycles)
+					return functions[a].cycles >
+							functions[b].cycles;
+				return function_names[a] < function_names[b];
+			});
+
+	// Sort instructions by cycles
+	std::vector<std::pair<unsigned, const Instruction *>> instruction_order;
+	for (auto &it : instructions)
+		instruction_order.emplace_back(it.first, &it.second);
+	std::sort(instruction_order.begin(), instruction_order.end(),
+			[](const std::pair<unsigned, const Instruction *> &a,
+			const std::pair<unsigned, const Instruction *> &b)
+			{
+				if (a.second->counters.cycles !=
+						b.second->counters.cycles)
+					return a.second->counters.cycles >
+							b.second->counters.cycles;
+				return a.first < b.first;
+			});
+
+	// Header
+	os << "; x86 guest profile\n";
+	os << ";    Cycles - Cycles elapsed since the previous commit in the same hardware thread\n";
+	os << ";    Insts - Committed x86 instructions\n";
+	os << ";    Uops - Committed micro-instructions\n";
+	os << ";    CacheMisses - Loads and stores missing in the first level data cache\n";
+	os << ";    Mispred - Mispredicted branches\n";
+	os << '\n';
+	os << misc::fmt("; Total: Cycles = %lld, Insts = %lld, Uops = %lld, "
+			"CacheMisses = %lld, Mispred = %lld\n\n",
+			total.cycles, total.instructions, total.uops,
+			total.cache_misses, total.mispredictions);
+
+	// Functions
+	os << "; Functions\n";
+	os << misc::fmt("%7s %12s %12s %12s %12s %10s  %s\n",
+			"%Cycles", "Cycles", "Insts", "Uops",
+			"CacheMisses", "Mispred", "Function");
+	for (int function : function_order)
+	{
+		const Counters &counters = functions[function];
+		os << misc::fmt("%7.2f %12lld %12lld %12lld %12lld %10lld  %s\n",
+				total.cycles ? 100.0 * counters.cycles /
+				total.cycles : 0.0,
+				counters.cycles,
+				counters.instructions,
+				counters.uops,
+				counters.cache_misses,
+				counters.mispredictions,
+				function_names[function].c_str());
+	}
+	os << '\n';
+
+	// Instructions
+	os << "; Instructions\n";
+	os << misc::fmt("%7s %12s %12s %12s %12s %10s  %-10s %s\n",
+			"%Cycles", "Cycles", "Insts", "Uops",
+			"CacheMisses", "Mispred", "Address", "Location");
+	for (auto &it : instruction_order)
+	{
+		const Instruction *instruction = it.second;
+		const Counters &counters = instruction->counters;
+		os << misc::fmt("%7.2f %12lld %12lld %12lld %12lld %10lld  "
+				"0x%08x %s+0x%x\n",
+				total.cycles ? 100.0 * counters.cycles /
+				total.cycles : 0.0,
+				counters.cycles,
+				counters.instructions,
+				counters.uops,
+				counters.cache_misses,
+				counters.mispredictions,
+				it.first,
+				function_names[instruction->function].c_str(),
+				instruction->offset);
+	}
+}
+
+
+void Profiler::DumpFolded(std::ostream &os) const
+{
+	// One line per call stack and function. The function is omitted when
+	// it is the one called last in the stack.
+	std::vector<std::pair<std::string, long long>> lines;
+	for (auto &it : stack_counters)
+	{
+		if (!it.second.cycles)
+			continue;
+		int node = it.first >> 32;
+		int function = it.first & 0xffffffff;
+		std::string name = getStackName(node);
+		if (!node || nodes[node].function != function)
+			name += (name.empty() ? "" : ";") +
+					function_names[function];
+		lines.emplace_back(name, it.second.cycles);
+	}
+
+	// Merge equal stacks and dump them in order
+	std::sort(lines.begin(), lines.end());
+	for (int i = 0; i < (int) lines.size(); i++)
+	{
+		long long cycles = lines[i].second;
+		while (i + 1 < (int) lines.size() &&
+				lines[i + 1].first == lines[i].first)
+			cycles += lines[++i].second;
+		os << lines[i].first << ' ' << cycles << '\n';
+	}
+}
+
+
+void Profiler::Dump() const
+{
+	// Flat profile
+	std::ofstream os(path);
+	if (!os.good())
+		throw Timing::Error(misc::fmt("%s: Cannot open profile",
+				path.c_str()));
+	DumpFlat(os);
+
+	// Call stacks
+	std::string folded_path = path + ".folded";
+	std::ofstream folded_os(folded_path);
+	if (!folded_os.good())
+		throw Timing::Error(misc::fmt("%s: Cannot open profile",
+				folded_path.c_str()));
+	DumpFolded(folded_os);
+}
+
+
+}  // namespace x86
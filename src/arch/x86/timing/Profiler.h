@@ -0,0 +1,179 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_PROFILER_H
+#define ARCH_X86_TIMING_PROFILER_H
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace x86
+{
+
+// Forward declarations
+class Context;
+class Uop;
+
+
+/// Profile of the guest programs run in a detailed simulation, activated
+/// with option '--x86-profile'. Committed instructions, cycles, data cache
+/// misses, and branch mispredictions are attributed to the guest instruction
+/// that caused them, and to the call stack of the guest program when the
+/// instruction was fetched. Function names are taken from the ELF symbols
+/// found by the call stack of each context (see comm::CallStack).
+///
+/// Cycles are attributed to committed uops: each uop is charged with the
+/// cycles elapsed since the previous commit in its hardware thread, so that
+/// the instructions that stall the head of the reorder buffer take the time.
+///
+/// The profile is dumped into two files: a flat profile of functions and
+/// instructions sorted by cycles, and a file with suffix '.folded' with one
+/// line per call stack followed by its cycles, in the format taken by
+/// flame graph tools.
+class Profiler
+{
+public:
+
+	/// Counters attributed to an instruction or a call stack
+	struct Counters
+	{
+		/// Committed x86 instructions
+		long long instructions = 0;
+
+		/// Committed uops
+		long long uops = 0;
+
+		/// Cycles
+		long long cycles = 0;
+
+		/// Loads and stores missing in the first level data cache
+		long long cache_misses = 0;
+
+		/// Mispredicted branches
+		long long mispredictions = 0;
+
+		/// Add the counters in \a other
+		Counters &operator+=(const Counters &other);
+	};
+
+private:
+
+	// File where the flat profile is dumped
+	std::string path;
+
+	// Names of functions, indexed by function identifier
+	std::vector<std::string> function_names;
+
+	// Function identifiers, indexed by name
+	std::unordered_map<std::string, int> function_ids;
+
+	// Node in the tree of call stacks. The root node, with index 0,
+	// stands for an empty call stack.
+	struct Node
+	{
+		// Parent node, or -1 for the root
+		int parent;
+
+		// Function called, or -1 for the root
+		int function;
+	};
+
+	// Nodes of the tree of call stacks
+	std::vector<Node> nodes;
+
+	// Children of nodes, indexed by a key combining the parent node and
+	// the address of the function called
+	std::unordered_map<unsigned long long, int> node_children;
+
+	// Node of the last call stack seen for a context, and version of the
+	// call stack when it was seen
+	struct ContextNode
+	{
+		long long version = 0;
+		int node = 0;
+	};
+
+	// Last call stack seen for each context
+	std::unordered_map<Context *, ContextNode> context_nodes;
+
+	// Guest instruction
+	struct Instruction
+	{
+		// Function containing the instruction
+		int function;
+
+		// Offset of the instruction within its function
+		unsigned offset;
+
+		// Counters
+		Counters counters;
+	};
+
+	// Guest instructions, indexed by address
+	std::unordered_map<unsigned, Instruction> instructions;
+
+	// Counters of each function within each call stack, indexed by a key
+	// combining the node of the call stack and the function
+	std::unordered_map<unsigned long long, Counters> stack_counters;
+
+	// Return the identifier of the function containing \a address in
+	// the memory map of \a context. In \a offset, the offset of the
+	// address within the function is returned.
+	int getFunction(Context *context, unsigned address, unsigned &offset);
+
+	// Return the child of \a node for a call to \a address
+	int getChild(int node, Context *context, unsigned address);
+
+	// Return the names of the functions in the call stack of \a node,
+	// separated by semicolons
+	std::string getStackName(int node) const;
+
+	// Dump the flat profile
+	void DumpFlat(std::ostream &os) const;
+
+	// Dump the counters of each call stack
+	void DumpFolded(std::ostream &os) const;
+
+public:
+
+	/// Constructor. The flat profile will be dumped into \a path, and the
+	/// call stacks into the same path with suffix '.folded'.
+	Profiler(const std::string &path);
+
+	/// Return the node of the current call stack of \a context. The
+	/// result is assigned to field Uop::profile_node of the uops of an
+	/// instruction before the instruction is emulated.
+	int getNode(Context *context);
+
+	/// Attribute a committed uop to its instruction and call stack.
+	/// Argument \a cycles is the number of cycles elapsed since the
+	/// previous commit in the uop's hardware thread.
+	void Commit(Uop *uop, long long cycles);
+
+	/// Dump the profile into its files
+	void Dump() const;
+};
+
+
+}  // namespace x86
+
+#endif
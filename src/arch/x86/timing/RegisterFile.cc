@@ -17,6 +17,8 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+
 #include "RegisterFile.h"
 #include "Core.h"
 #include "Thread.h"
@@ -362,6 +364,21 @@ bool RegisterFile::canRename(Uop *uop)
 }
 
 
+RegisterFile::PhysicalRegister *RegisterFile::getInputRegister(Uop *uop,
+		int dep)
+{
+	int logical_register = uop->getUinst()->getIDep(dep);
+	int physical_register = uop->getInput(dep);
+	if (Uinst::isIntegerDependency(logical_register))
+		return &integer_registers[physical_register];
+	if (Uinst::isFloatingPointDependency(logical_register))
+		return &floating_point_registers[physical_register];
+	if (Uinst::isXmmDependency(logical_register))
+		return &xmm_registers[physical_register];
+	return nullptr;
+}
+
+
 void RegisterFile::Rename(Uop *uop)
 {
 
@@ -447,6 +464,19 @@ void RegisterFile::Rename(Uop *uop)
 		}
 	}
 
+	// Wait for the inputs still being computed
+	uop->num_pending_inputs = 0;
+	for (int dep = 0; dep < Uinst::MaxIDeps; dep++)
+	{
+		PhysicalRegister *physical_register = getInputRegister(uop, dep);
+		if (physical_register && physical_register->pending)
+		{
+			physical_register->consumers.push_back(uop);
+			uop->num_pending_inputs++;
+		}
+	}
+	uop->ready = !uop->num_pending_inputs;
+
 	// Rename output int/FP/XMM registers (not flags)
 	int flag_physical_register = -1;
 	int flag_count = 0;
@@ -615,14 +645,32 @@ void RegisterFile::WriteUop(Uop *uop)
 
 	for (int dep = 0; dep < Uinst::MaxODeps; dep++)
 	{
+		// Get physical register
 		int logical_register = uop->getUinst()->getODep(dep);
-		int physical_register = uop->getOutput(dep);
+		int index = uop->getOutput(dep);
+		PhysicalRegister *physical_register;
 		if (Uinst::isIntegerDependency(logical_register))
-			integer_registers[physical_register].pending = false;
+			physical_register = &integer_registers[index];
 		else if (Uinst::isFloatingPointDependency(logical_register))
-			floating_point_registers[physical_register].pending = false;
+			physical_register = &floating_point_registers[index];
 		else if (Uinst::isXmmDependency(logical_register))
-			xmm_registers[physical_register].pending = false;
+			physical_register = &xmm_registers[index];
+		else
+			continue;
+
+		// Result is available
+		physical_register->pending = false;
+
+		// Wake up consumers with no other pending input
+		for (Uop *consumer : physical_register->consumers)
+		{
+			assert(consumer->num_pending_inputs > 0);
+			if (--consumer->num_pending_inputs)
+				continue;
+			consumer->ready = true;
+			thread->WakeUp(consumer);
+		}
+		physical_register->consumers.clear();
 	}
 }
 
@@ -633,9 +681,22 @@ void RegisterFile::UndoUop(Uop *uop)
 	// Debug
 	debug << "Undo uop " << *uop << '\n';
 
+	// Stop waiting for pending inputs. Consumers are squashed from the
+	// youngest, so the uop is found at the end of the lists.
+	for (int dep = 0; dep < Uinst::MaxIDeps; dep++)
+	{
+		PhysicalRegister *physical_register = getInputRegister(uop, dep);
+		if (!physical_register || !physical_register->pending)
+			continue;
+		std::vector<Uop *> &consumers = physical_register->consumers;
+		auto it = std::find(consumers.rbegin(), consumers.rend(), uop);
+		assert(it != consumers.rend());
+		consumers.erase(std::next(it).base());
+		uop->num_pending_inputs--;
+	}
+
 	// Undo mappings in reverse order, in case an instruction has a
 	// duplicated output dependence.
-	assert(uop->speculative_mode);
 	for (int dep = Uinst::MaxODeps - 1; dep >= 0; dep--)
 	{
 		int logical_register = uop->getUinst()->getODep(dep);
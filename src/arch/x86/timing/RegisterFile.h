@@ -20,6 +20,8 @@
 #ifndef ARCH_X86_TIMING_REGISTER_FILE_H
 #define ARCH_X86_TIMING_REGISTER_FILE_H
 
+#include <vector>
+
 #include <lib/cpp/Debug.h>
 #include <lib/cpp/IniFile.h>
 #include <arch/x86/emulator/Uinst.h>
@@ -80,8 +82,16 @@ private:
 
 		// Number of logical registers mapped to this physical register
 		int busy = 0;
+
+		// Uops renamed while the register was pending, woken up when
+		// the register is written
+		std::vector<Uop *> consumers;
 	};
 
+	// Return the physical register of input dependence \a dep of \a uop,
+	// or null if the dependence is not a register
+	PhysicalRegister *getInputRegister(Uop *uop, int dep);
+
 
 
 
@@ -287,11 +297,14 @@ public:
 	bool isUopReady(Uop *uop);
 
 	/// Update the state of the register file when an uop completes, that
-	/// is, when its results are written back.
+	/// is, when its results are written back. Uops waiting for the
+	/// results are woken up in their thread (see Thread::WakeUp()) when
+	/// their last pending input is written.
 	void WriteUop(Uop *uop);
 
 	/// Update the state of the register file when an uop is recovered from
-	/// speculative execution
+	/// speculative execution, or squashed to be replayed after a memory
+	/// dependence violation
 	void UndoUop(Uop *uop);
 
 	/// Update the state of the register file when an uop commits
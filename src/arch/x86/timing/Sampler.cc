@@ -0,0 +1,274 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+
+#include <lib/esim/Engine.h>
+
+#include "Cpu.h"
+#include "Sampler.h"
+#include "Thread.h"
+#include "Timing.h"
+
+
+namespace x86
+{
+
+long long Sampler::functional_interval = 0;
+long long Sampler::warm_up_interval = 0;
+long long Sampler::detailed_warm_up_interval = 0;
+long long Sampler::detailed_interval = 0;
+
+
+void Sampler::ParseConfiguration(misc::IniFile *ini_file)
+{
+	// Section '[ Sampling ]'
+	std::string section = "Sampling";
+	functional_interval = ini_file->ReadInt64(section,
+			"FunctionalInterval", 0);
+	warm_up_interval = ini_file->ReadInt64(section,
+			"WarmUpInterval", 0);
+	detailed_warm_up_interval = ini_file->ReadInt64(section,
+			"DetailedWarmUpInterval", 2000);
+	detailed_interval = ini_file->ReadInt64(section,
+			"DetailedInterval", 10000);
+
+	// Check values
+	if (functional_interval < 0 || warm_up_interval < 0 ||
+			detailed_warm_up_interval < 0)
+		throw Timing::Error(misc::fmt("%s: section [%s]: number of "
+				"instructions cannot be negative",
+				ini_file->getPath().c_str(),
+				section.c_str()));
+	if (detailed_interval < 1)
+		throw Timing::Error(misc::fmt("%s: section [%s]: invalid "
+				"value for 'DetailedInterval'",
+				ini_file->getPath().c_str(),
+				section.c_str()));
+}
+
+
+Sampler::Sampler(Cpu *cpu) :
+		cpu(cpu)
+{
+	emulator = Emulator::getInstance();
+}
+
+
+void Sampler::RunFunctional(long long num_instructions, bool warm_up)
+{
+	esim::Engine *esim_engine = esim::Engine::getInstance();
+	long long start = emulator->getNumInstructions();
+	long long max_instructions = Emulator::getMaxInstructions();
+	while (emulator->getNumInstructions() - start < num_instructions)
+	{
+		// Stop if no context can make progress anymore
+		if (!emulator->getNumRunningContexts() &&
+				!emulator->getNumSuspendedContexts())
+			break;
+
+		// Stop if maximum number of instructions exceeded
+		if (max_instructions && getNumFunctionalInstructions() +
+				emulator->getNumInstructions() - start +
+				cpu->getNumCommittedInstructions() >=
+				max_instructions)
+			esim_engine->Finish("X86MaxInstructions");
+		if (esim_engine->hasFinished())
+			break;
+
+		// Run an instruction from every running context. A context
+		// can remove itself from the running list during execution,
+		// so the list of all contexts is traversed instead.
+		for (auto it = emulator->getContextsBegin(),
+				e = emulator->getContextsEnd();
+				it != e;
+				++it)
+		{
+			// Get context
+			Context *context = it->get();
+
+			// Skip if not running
+			if (!context->getState(Context::StateRunning))
+				continue;
+
+			// Run one instruction
+			context->Execute();
+
+			// Warm up the hardware thread where the context is
+			// mapped, mapping it first if needed
+			if (warm_up)
+			{
+				if (!context->getState(Context::StateMapped))
+					cpu->MapContext(context);
+				context->thread->WarmUp(context);
+			}
+		}
+
+		// Free finished contexts. Contexts mapped to hardware threads
+		// are freed by the scheduler when they are unmapped.
+		for (auto it = emulator->getFinishedContextsBegin();
+				it != emulator->getFinishedContextsEnd(); )
+		{
+			Context *context = *it;
+			++it;
+			if (!context->getState(Context::StateMapped))
+				emulator->FreeContext(context);
+		}
+
+		// Process list of suspended contexts
+		emulator->ProcessEvents();
+	}
+
+	// Statistics
+	if (warm_up)
+		num_warm_up_instructions += emulator->getNumInstructions() - start;
+	else
+		num_functional_instructions += emulator->getNumInstructions() - start;
+}
+
+
+void Sampler::AddSample(long long num_cycles, long long num_instructions)
+{
+	// Totals
+	num_measured_cycles += num_cycles;
+	num_measured_instructions += num_instructions;
+
+	// Running mean and variance
+	double cpi = (double) num_cycles / num_instructions;
+	num_samples++;
+	double delta = cpi - cpi_mean;
+	cpi_mean += delta / num_samples;
+	cpi_m2 += delta * (cpi - cpi_mean);
+}
+
+
+void Sampler::Run()
+{
+	// Detailed interval
+	if (phase == PhaseDetailed)
+	{
+		// Start measuring once the pipeline is filled
+		long long num_committed = cpu->getNumCommittedInstructions();
+		if (!measuring && num_committed - detailed_start_instructions
+				>= detailed_warm_up_interval)
+		{
+			measuring = true;
+			measure_start_cycle = cpu->getCycle();
+			measure_start_instructions = num_committed;
+		}
+
+		// Continue until the interval is complete
+		if (!measuring || num_committed - measure_start_instructions
+				< detailed_interval)
+			return;
+
+		// Take sample and drain pipelines
+		AddSample(cpu->getCycle() - measure_start_cycle,
+				num_committed - measure_start_instructions);
+		cpu->Drain();
+		phase = PhaseDrain;
+	}
+
+	// Wait until all contexts have been evicted and no access is in
+	// flight in the memory hierarchy.
+	if (phase == PhaseDrain)
+	{
+		esim::Engine *esim_engine = esim::Engine::getInstance();
+		if (!cpu->isDrained() || esim_engine->getNextEventTime() >= 0)
+			return;
+		phase = PhaseFunctional;
+	}
+
+	// Functional fast-forward and warm-up intervals
+	phase = PhaseFunctional;
+	RunFunctional(functional_interval, false);
+	phase = PhaseWarmUp;
+	RunFunctional(warm_up_interval, true);
+
+	// Start detailed interval
+	phase = PhaseDetailed;
+	measuring = false;
+	detailed_start_instructions = cpu->getNumCommittedInstructions();
+	cpu->Resume();
+}
+
+
+double Sampler::getCpiConfidence() const
+{
+	// Normal approximation, with the sample standard deviation
+	if (num_samples < 2)
+		return 0.0;
+	double stddev = sqrt(cpi_m2 / (num_samples - 1));
+	return 1.96 * stddev / sqrt((double) num_samples);
+}
+
+
+void Sampler::DumpSummary(std::ostream &os) const
+{
+	// IPC confidence interval, from the CPI confidence interval
+	double cpi_confidence = getCpiConfidence();
+	double ipc = cpi_mean > 0.0 ? 1.0 / cpi_mean : 0.0;
+	double ipc_low = cpi_mean + cpi_confidence > 0.0 ?
+			1.0 / (cpi_mean + cpi_confidence) : 0.0;
+	double ipc_high = cpi_mean - cpi_confidence > 0.0 ?
+			1.0 / (cpi_mean - cpi_confidence) : 0.0;
+
+	// Estimated cycles for all instructions
+	long long num_instructions = getNumFunctionalInstructions() +
+			cpu->getNumCommittedInstructions();
+
+	// Dump
+	os << misc::fmt("SampledInstructions = %lld\n", num_instructions);
+	os << misc::fmt("Samples = %lld\n", num_samples);
+	os << misc::fmt("SampledIPC = %.4g\n", ipc);
+	os << misc::fmt("SampledIPCLow = %.4g\n", ipc_low);
+	os << misc::fmt("SampledIPCHigh = %.4g\n", ipc_high);
+	os << misc::fmt("EstimatedCycles = %.0f\n",
+			cpi_mean * num_instructions);
+}
+
+
+void Sampler::DumpReport(std::ostream &os) const
+{
+	os << "; Sampled simulation\n";
+	os << ";    CPI - Mean cycles per instruction of all samples\n";
+	os << ";    CPIConfidence - Half-width of the 95% confidence interval\n";
+	os << "[ Sampling ]\n";
+	os << misc::fmt("FunctionalInterval = %lld\n", functional_interval);
+	os << misc::fmt("WarmUpInterval = %lld\n", warm_up_interval);
+	os << misc::fmt("DetailedWarmUpInterval = %lld\n",
+			detailed_warm_up_interval);
+	os << misc::fmt("DetailedInterval = %lld\n", detailed_interval);
+	os << misc::fmt("FunctionalInstructions = %lld\n",
+			num_functional_instructions);
+	os << misc::fmt("WarmUpInstructions = %lld\n",
+			num_warm_up_instructions);
+	os << misc::fmt("MeasuredInstructions = %lld\n",
+			num_measured_instructions);
+	os << misc::fmt("MeasuredCycles = %lld\n", num_measured_cycles);
+	os << misc::fmt("Samples = %lld\n", num_samples);
+	os << misc::fmt("CPI = %.4g\n", cpi_mean);
+	os << misc::fmt("CPIConfidence = %.4g\n", getCpiConfidence());
+	os << misc::fmt("CPIRelativeError = %.4g\n", cpi_mean > 0.0 ?
+			getCpiConfidence() / cpi_mean : 0.0);
+	os << '\n';
+}
+
+}  // namespace x86
+
@@ -0,0 +1,191 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_SAMPLER_H
+#define ARCH_X86_TIMING_SAMPLER_H
+
+#include <iostream>
+
+#include <lib/cpp/IniFile.h>
+
+
+namespace x86
+{
+
+// Forward declarations
+class Cpu;
+class Emulator;
+
+/// Controller for sampled simulation. The sampler makes the x86 timing
+/// simulator alternate between a functional fast-forward interval, a
+/// functional warm-up interval where caches and branch predictors are
+/// updated with the emulated instructions, and a detailed interval. Each
+/// detailed interval starts with a number of instructions used to fill the
+/// pipeline, followed by the instructions whose CPI is measured as one
+/// sample. The performance of the full execution is estimated from the
+/// samples, together with its confidence interval.
+///
+/// Before switching to a functional interval, contexts are evicted from
+/// all hardware threads, and the sampler waits until the memory hierarchy
+/// has no pending events. Functional intervals do not advance the
+/// simulation time.
+class Sampler
+{
+public:
+
+	/// Simulation phases
+	enum Phase
+	{
+		PhaseInvalid = 0,
+		PhaseFunctional,
+		PhaseWarmUp,
+		PhaseDetailed,
+		PhaseDrain
+	};
+
+private:
+
+	//
+	// Configuration
+	//
+
+	// Number of instructions in each functional fast-forward interval
+	static long long functional_interval;
+
+	// Number of instructions in each functional warm-up interval
+	static long long warm_up_interval;
+
+	// Number of instructions committed in detailed simulation before the
+	// measurement starts
+	static long long detailed_warm_up_interval;
+
+	// Number of instructions measured in each detailed interval
+	static long long detailed_interval;
+
+
+
+
+	//
+	// Class members
+	//
+
+	// CPU simulated in detailed intervals
+	Cpu *cpu;
+
+	// Associated emulator
+	Emulator *emulator;
+
+	// Current phase
+	Phase phase = PhaseFunctional;
+
+	// Committed instructions when the current detailed interval started
+	long long detailed_start_instructions = 0;
+
+	// True when the instructions committed in the current detailed
+	// interval are being measured
+	bool measuring = false;
+
+	// Cycle and number of committed instructions when the measurement of
+	// the current detailed interval started
+	long long measure_start_cycle = 0;
+	long long measure_start_instructions = 0;
+
+	// Execute up to the given number of instructions functionally in all
+	// running contexts, warming up caches and branch predictors if \a
+	// warm_up is true. The function returns earlier if the simulation
+	// finishes or no context is left to run.
+	void RunFunctional(long long num_instructions, bool warm_up);
+
+
+
+
+	//
+	// Statistics
+	//
+
+	// Number of instructions emulated in functional and warm-up intervals
+	long long num_functional_instructions = 0;
+	long long num_warm_up_instructions = 0;
+
+	// Number of cycles and instructions in measured detailed intervals
+	long long num_measured_cycles = 0;
+	long long num_measured_instructions = 0;
+
+	// Number of samples
+	long long num_samples = 0;
+
+	// Running mean of the CPI of all samples and sum of squared
+	// differences from the mean, updated with Welford's method
+	double cpi_mean = 0.0;
+	double cpi_m2 = 0.0;
+
+public:
+
+	/// Read the sampling configuration from section [Sampling] of the
+	/// x86 configuration file.
+	static void ParseConfiguration(misc::IniFile *ini_file);
+
+	/// Return whether sampled simulation was enabled by the user
+	static bool isEnabled() { return functional_interval > 0; }
+
+	/// Constructor
+	Sampler(Cpu *cpu);
+
+	/// Run the sampling state machine. This function must be invoked by
+	/// the timing simulator before simulating each cycle. It switches
+	/// between phases when needed, and runs functional and warm-up
+	/// intervals entirely within the call.
+	void Run();
+
+	/// Return the current phase
+	Phase getPhase() const { return phase; }
+
+	/// Return the number of instructions emulated outside of detailed
+	/// intervals, including warm-up intervals.
+	long long getNumFunctionalInstructions() const
+	{
+		return num_functional_instructions + num_warm_up_instructions;
+	}
+
+	/// Add the CPI measured in a detailed interval of \a num_instructions
+	/// committed instructions and \a num_cycles cycles to the statistics.
+	/// This function is invoked internally by Run() at the end of each
+	/// detailed interval.
+	void AddSample(long long num_cycles, long long num_instructions);
+
+	/// Return the number of samples taken
+	long long getNumSamples() const { return num_samples; }
+
+	/// Return the mean CPI of all samples
+	double getCpi() const { return cpi_mean; }
+
+	/// Return the half-width of the 95% confidence interval of the CPI
+	double getCpiConfidence() const;
+
+	/// Dump the sampling statistics for the simulation summary
+	void DumpSummary(std::ostream &os = std::cout) const;
+
+	/// Dump the sampling configuration and statistics in INI format
+	void DumpReport(std::ostream &os = std::cout) const;
+};
+
+}  // namespace x86
+
+#endif
+
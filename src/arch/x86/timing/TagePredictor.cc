@@ -0,0 +1,600 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#include "TagePredictor.h"
+
+
+namespace x86
+{
+
+// Saturated increment or decrement of a counter
+template<typename T> static void UpdateCounter(T &counter, bool increment,
+		int min, int max)
+{
+	if (increment && counter < max)
+		counter++;
+	else if (!increment && counter > min)
+		counter--;
+}
+
+
+// History length of tagged table 'table' out of 'num_tables', forming a
+// geometric series between 'min_history' and 'max_history'
+static int getHistoryLength(int table, int num_tables, int min_history,
+		int max_history)
+{
+	if (num_tables == 1)
+		return min_history;
+	double ratio = (double) max_history / min_history;
+	return (int) (min_history * std::pow(ratio,
+			(double) table / (num_tables - 1)) + 0.5);
+}
+
+
+// Index of a branch in a tagged table
+static unsigned short getTableIndex(unsigned eip, int table,
+		const FoldedHistory &history, int log_size)
+{
+	return (eip ^ (eip >> (table + 1)) ^ history.getValue()) &
+			((1 << log_size) - 1);
+}
+
+
+// Partial tag of a branch in a tagged table
+static unsigned short getTableTag(unsigned eip,
+		const FoldedHistory *history, int tag_bits)
+{
+	return (eip ^ history[0].getValue() ^ (history[1].getValue() << 1)) &
+			((1 << tag_bits) - 1);
+}
+
+
+
+
+//
+// Class 'TagePredictor'
+//
+
+// Log base 2 of the number of entries of the statistical corrector tables
+static const int log_sc_table_size = 10;
+
+// History lengths of the statistical corrector tables
+static const int sc_history_length[TagePredictor::NumScTables] =
+		{ 0, 4, 10, 16 };
+
+// Maximum confidence and age of a loop predictor entry
+static const int loop_max_confidence = 3;
+static const int loop_max_age = 31;
+
+// Number of updates between agings of the usefulness counters
+static const long long useful_aging_period = 1 << 18;
+
+
+TagePredictor::TagePredictor(int num_tables,
+		int log_base_size,
+		int log_table_size,
+		int tag_bits,
+		int min_history,
+		int max_history,
+		int log_loop_size,
+		bool statistical_corrector) :
+		num_tables(num_tables),
+		log_base_size(log_base_size),
+		log_table_size(log_table_size),
+		tag_bits(tag_bits),
+		log_loop_size(log_loop_size),
+		statistical_corrector(statistical_corrector),
+		base(1 << log_base_size, 2),
+		tables(num_tables << log_table_size),
+		history(std::max(max_history, sc_history_length[NumScTables - 1]))
+{
+	// Folded histories
+	assert(num_tables > 0 && num_tables <= MaxTables);
+	for (int i = 0; i < num_tables; i++)
+	{
+		int length = getHistoryLength(i, num_tables, min_history,
+				max_history);
+		index_history[i] = FoldedHistory(length, log_table_size);
+		tag_history[i][0] = FoldedHistory(length, tag_bits);
+		tag_history[i][1] = FoldedHistory(length, tag_bits - 1);
+	}
+
+	// Loop predictor
+	if (log_loop_size)
+		loop_table.resize(1 << log_loop_size);
+
+	// Statistical corrector
+	if (statistical_corrector)
+	{
+		for (int i = 0; i < NumScTables; i++)
+		{
+			sc_tables[i].resize(1 << log_sc_table_size);
+			if (sc_history_length[i])
+				sc_history[i] = FoldedHistory(
+						sc_history_length[i],
+						log_sc_table_size);
+		}
+	}
+}
+
+
+void TagePredictor::LookupLoop(unsigned eip, Info &info)
+{
+	// Find entry
+	info.loop_index = eip & ((1 << log_loop_size) - 1);
+	LoopEntry &entry = loop_table[info.loop_index];
+	unsigned short tag = eip >> log_loop_size;
+	info.loop_hit = entry.valid && entry.tag == tag;
+	info.loop_iter = entry.iter;
+
+	// The loop predicts once the same trip count repeated. The branch
+	// leaves the loop in its last iteration.
+	info.loop_valid = info.loop_hit && entry.trip &&
+			entry.confidence == loop_max_confidence;
+	info.loop_prediction = entry.iter + 1 == entry.trip ?
+			!entry.direction : entry.direction;
+}
+
+
+void TagePredictor::LookupStatisticalCorrector(unsigned eip, Info &info)
+{
+	// The bias table is indexed by the address and the TAGE prediction,
+	// and the other tables by the address and the global history.
+	int mask = (1 << log_sc_table_size) - 1;
+	info.sc_sum = 0;
+	for (int i = 0; i < NumScTables; i++)
+	{
+		if (i == 0)
+			info.sc_index[i] = ((eip << 1) | info.tage_prediction) &
+					mask;
+		else
+			info.sc_index[i] = (eip ^ (eip >> log_sc_table_size) ^
+					sc_history[i].getValue()) & mask;
+		info.sc_sum += 2 * sc_tables[i][info.sc_index[i]] + 1;
+	}
+}
+
+
+bool TagePredictor::Lookup(unsigned eip, Info &info)
+{
+	// Base table
+	info.base_index = eip & ((1 << log_base_size) - 1);
+	bool base_prediction = base[info.base_index] >= 2;
+
+	// Find provider and alternate tables, the matching tables with the
+	// longest histories
+	info.provider = -1;
+	info.alt_provider = -1;
+	for (int i = num_tables - 1; i >= 0; i--)
+	{
+		info.index[i] = getTableIndex(eip, i, index_history[i],
+				log_table_size);
+		info.tag[i] = getTableTag(eip, tag_history[i], tag_bits);
+		if (getEntry(i, info.index[i]).tag != info.tag[i])
+			continue;
+		if (info.provider < 0)
+			info.provider = i;
+		else if (info.alt_provider < 0)
+			info.alt_provider = i;
+	}
+
+	// Predictions of the provider and alternate tables
+	info.alt_prediction = info.alt_provider >= 0 ?
+			getEntry(info.alt_provider,
+			info.index[info.alt_provider]).counter >= 0 :
+			base_prediction;
+	bool confident;
+	if (info.provider >= 0)
+	{
+		// A recently allocated entry is not trusted if the alternate
+		// prediction proved better for new entries.
+		int counter = getEntry(info.provider,
+				info.index[info.provider]).counter;
+		info.provider_prediction = counter >= 0;
+		info.weak = counter == 0 || counter == -1;
+		info.tage_prediction = info.weak && use_alt_on_new >= 0 ?
+				info.alt_prediction :
+				info.provider_prediction;
+		confident = counter == 3 || counter == -4;
+	}
+	else
+	{
+		info.provider_prediction = base_prediction;
+		info.weak = false;
+		info.tage_prediction = base_prediction;
+		confident = base[info.base_index] == 0 ||
+				base[info.base_index] == 3;
+	}
+	info.prediction = info.tage_prediction;
+
+	// Statistical corrector, reverting predictions with low confidence
+	if (statistical_corrector)
+	{
+		LookupStatisticalCorrector(eip, info);
+		bool sc_prediction = info.sc_sum >= 0;
+		if (!confident && sc_prediction != info.prediction &&
+				std::abs(info.sc_sum) >= sc_threshold)
+			info.prediction = sc_prediction;
+	}
+
+	// Loop predictor, overriding the others when confident
+	info.loop_hit = false;
+	info.loop_valid = false;
+	if (log_loop_size)
+		LookupLoop(eip, info);
+	if (info.loop_valid && use_loop >= 0)
+		info.prediction = info.loop_prediction;
+
+	// Return prediction
+	return info.prediction;
+}
+
+
+void TagePredictor::UpdateHistory(bool taken, const Info &info)
+{
+	// Advance the iteration count of the loop
+	if (info.loop_hit)
+	{
+		LoopEntry &entry = loop_table[info.loop_index];
+		if (taken != entry.direction)
+			entry.iter = 0;
+		else if (entry.iter < 0xffff)
+			entry.iter++;
+	}
+
+	// Global history
+	history.Push(taken);
+	for (int i = 0; i < num_tables; i++)
+	{
+		index_history[i].Update(history);
+		tag_history[i][0].Update(history);
+		tag_history[i][1].Update(history);
+	}
+	if (statistical_corrector)
+		for (int i = 1; i < NumScTables; i++)
+			sc_history[i].Update(history);
+}
+
+
+void TagePredictor::UpdateLoop(unsigned eip, bool taken, const Info &info)
+{
+	LoopEntry &entry = loop_table[info.loop_index];
+	unsigned short tag = eip >> log_loop_size;
+	if (info.loop_hit && entry.valid && entry.tag == tag)
+	{
+		// Choose between the loop predictor and TAGE when they differ
+		if (info.loop_valid && info.loop_prediction != info.tage_prediction)
+			UpdateCounter(use_loop, info.loop_prediction == taken,
+					-8, 7);
+
+		// Free entries that mispredict with confidence
+		if (info.loop_valid && info.loop_prediction != taken)
+		{
+			entry.valid = false;
+			return;
+		}
+
+		// Loop exit. Gain confidence if the trip count repeated.
+		int trip = info.loop_iter + 1;
+		if (taken != entry.direction)
+		{
+			if (trip == entry.trip)
+			{
+				if (entry.confidence < loop_max_confidence)
+					entry.confidence++;
+				if (entry.age < loop_max_age)
+					entry.age++;
+			}
+			else
+			{
+				entry.trip = trip;
+				entry.confidence = 0;
+			}
+		}
+		else if (entry.trip && trip >= entry.trip)
+		{
+			// Loop ran longer than its trip count
+			entry.trip = 0;
+			entry.confidence = 0;
+		}
+		return;
+	}
+
+	// Allocate an entry when TAGE mispredicts, assuming that the branch
+	// is leaving a loop
+	if (info.tage_prediction == taken)
+		return;
+	if (entry.valid && entry.age)
+	{
+		entry.age--;
+		return;
+	}
+	entry = LoopEntry();
+	entry.tag = tag;
+	entry.direction = !taken;
+	entry.age = loop_max_age;
+	entry.valid = true;
+}
+
+
+void TagePredictor::UpdateStatisticalCorrector(bool taken, const Info &info)
+{
+	// Adapt threshold when the corrector disagrees with TAGE
+	bool sc_prediction = info.sc_sum >= 0;
+	if (sc_prediction != info.tage_prediction)
+	{
+		if (sc_prediction != taken)
+			sc_threshold_counter++;
+		else if (std::abs(info.sc_sum) < sc_threshold)
+			sc_threshold_counter--;
+		if (sc_threshold_counter >= 32)
+		{
+			sc_threshold++;
+			sc_threshold_counter = 0;
+		}
+		else if (sc_threshold_counter <= -32 && sc_threshold > 1)
+		{
+			sc_threshold--;
+			sc_threshold_counter = 0;
+		}
+	}
+
+	// Train counters on a misprediction or a low-confidence sum
+	if (sc_prediction == taken && std::abs(info.sc_sum) >= sc_threshold)
+		return;
+	for (int i = 0; i < NumScTables; i++)
+		UpdateCounter(sc_tables[i][info.sc_index[i]], taken, -32, 31);
+}
+
+
+void TagePredictor::UpdateTables(bool taken, const Info &info)
+{
+	// Choose between the provider and alternate predictions for
+	// recently allocated entries
+	int provider = info.provider;
+	if (provider >= 0 && info.weak &&
+			info.provider_prediction != info.alt_prediction)
+		UpdateCounter(use_alt_on_new, info.alt_prediction == taken,
+				-8, 7);
+
+	// On a misprediction, allocate an entry in a table with a longer
+	// history. If none is free, make them more likely to be replaced.
+	if (info.tage_prediction != taken && provider < num_tables - 1)
+	{
+		int table;
+		for (table = provider + 1; table < num_tables; table++)
+			if (!getEntry(table, info.index[table]).useful)
+				break;
+		if (table < num_tables)
+		{
+			Entry &entry = getEntry(table, info.index[table]);
+			entry.counter = taken ? 0 : -1;
+			entry.tag = info.tag[table];
+			entry.useful = 0;
+		}
+		else
+		{
+			for (table = provider + 1; table < num_tables; table++)
+			{
+				Entry &entry = getEntry(table, info.index[table]);
+				if (entry.useful)
+					entry.useful--;
+			}
+		}
+	}
+
+	// Train base table
+	if (provider < 0)
+		UpdateCounter(base[info.base_index], taken, 0, 3);
+
+	// Train provider, unless it was replaced since the lookup
+	if (provider >= 0)
+	{
+		Entry &entry = getEntry(provider, info.index[provider]);
+		if (entry.tag == info.tag[provider])
+		{
+			// The alternate prediction is also trained while the
+			// provider entry has not proven useful
+			int alt = info.alt_provider;
+			if (!entry.useful && alt >= 0)
+				UpdateCounter(getEntry(alt, info.index[alt]).counter,
+						taken, -4, 3);
+			else if (!entry.useful)
+				UpdateCounter(base[info.base_index], taken, 0, 3);
+
+			// Direction and usefulness
+			UpdateCounter(entry.counter, taken, -4, 3);
+			if (info.provider_prediction != info.alt_prediction)
+				UpdateCounter(entry.useful,
+						info.provider_prediction == taken,
+						0, 3);
+		}
+	}
+
+	// Periodically age usefulness counters, so that entries not useful
+	// anymore can be replaced
+	if (!(num_updates % useful_aging_period))
+		for (Entry &entry : tables)
+			entry.useful >>= 1;
+}
+
+
+void TagePredictor::Update(unsigned eip, bool taken, const Info &info)
+{
+	num_updates++;
+	if (log_loop_size)
+		UpdateLoop(eip, taken, info);
+	if (statistical_corrector)
+		UpdateStatisticalCorrector(taken, info);
+	UpdateTables(taken, info);
+}
+
+
+
+
+//
+// Class 'IttagePredictor'
+//
+
+IttagePredictor::IttagePredictor(int num_tables,
+		int log_base_size,
+		int log_table_size,
+		int tag_bits,
+		int min_history,
+		int max_history) :
+		num_tables(num_tables),
+		log_base_size(log_base_size),
+		log_table_size(log_table_size),
+		tag_bits(tag_bits),
+		base(1 << log_base_size),
+		tables(num_tables << log_table_size),
+		history(max_history)
+{
+	// Folded histories
+	assert(num_tables > 0 && num_tables <= MaxTables);
+	for (int i = 0; i < num_tables; i++)
+	{
+		int length = getHistoryLength(i, num_tables, min_history,
+				max_history);
+		index_history[i] = FoldedHistory(length, log_table_size);
+		tag_history[i][0] = FoldedHistory(length, tag_bits);
+		tag_history[i][1] = FoldedHistory(length, tag_bits - 1);
+	}
+}
+
+
+unsigned IttagePredictor::Lookup(unsigned eip, Info &info)
+{
+	// Find provider and alternate tables
+	info.valid = true;
+	info.base_index = eip & ((1 << log_base_size) - 1);
+	info.provider = -1;
+	info.alt_provider = -1;
+	for (int i = num_tables - 1; i >= 0; i--)
+	{
+		info.index[i] = getTableIndex(eip, i, index_history[i],
+				log_table_size);
+		info.tag[i] = getTableTag(eip, tag_history[i], tag_bits);
+		if (getEntry(i, info.index[i]).tag != info.tag[i])
+			continue;
+		if (info.provider < 0)
+			info.provider = i;
+		else if (info.alt_provider < 0)
+			info.alt_provider = i;
+	}
+
+	// Targets of the provider and alternate tables
+	Entry &base_entry = base[info.base_index];
+	Entry &provider_entry = info.provider >= 0 ?
+			getEntry(info.provider, info.index[info.provider]) :
+			base_entry;
+	info.provider_target = provider_entry.target;
+	info.alt_target = info.alt_provider >= 0 ?
+			getEntry(info.alt_provider,
+			info.index[info.alt_provider]).target :
+			base_entry.target;
+
+	// A provider with no confidence defers to the alternate target
+	info.target = !provider_entry.confidence && info.alt_target ?
+			info.alt_target :
+			info.provider_target;
+	return info.target;
+}
+
+
+void IttagePredictor::UpdateHistory(bool bit)
+{
+	history.Push(bit);
+	for (int i = 0; i < num_tables; i++)
+	{
+		index_history[i].Update(history);
+		tag_history[i][0].Update(history);
+		tag_history[i][1].Update(history);
+	}
+}
+
+
+void IttagePredictor::Update(unsigned target, const Info &info)
+{
+	// On a misprediction, allocate an entry in a table with a longer
+	// history. If none is free, make them replaceable.
+	num_updates++;
+	int provider = info.provider;
+	if (info.target != target && provider < num_tables - 1)
+	{
+		int table;
+		for (table = provider + 1; table < num_tables; table++)
+			if (!getEntry(table, info.index[table]).useful)
+				break;
+		if (table < num_tables)
+		{
+			Entry &entry = getEntry(table, info.index[table]);
+			entry.target = target;
+			entry.tag = info.tag[table];
+			entry.confidence = 0;
+			entry.useful = false;
+		}
+		else
+		{
+			for (table = provider + 1; table < num_tables; table++)
+				getEntry(table, info.index[table]).useful = false;
+		}
+	}
+
+	// Train provider, unless it was replaced since the lookup. The target
+	// is replaced once the confidence drops to zero.
+	Entry *entry = &base[info.base_index];
+	if (provider >= 0)
+	{
+		entry = &getEntry(provider, info.index[provider]);
+		if (entry->tag != info.tag[provider])
+			entry = nullptr;
+		else if (info.provider_target != info.alt_target)
+			entry->useful = info.provider_target == target;
+	}
+	if (entry)
+	{
+		if (entry->target == target)
+		{
+			if (entry->confidence < 3)
+				entry->confidence++;
+		}
+		else if (entry->confidence)
+		{
+			entry->confidence--;
+		}
+		else
+		{
+			entry->target = target;
+		}
+	}
+
+	// Periodically clear usefulness bits
+	if (!(num_updates % useful_aging_period))
+		for (Entry &entry : tables)
+			entry.useful = false;
+}
+
+
+}  // namespace x86
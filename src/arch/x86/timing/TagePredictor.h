@@ -0,0 +1,375 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_TAGE_PREDICTOR_H
+#define ARCH_X86_TIMING_TAGE_PREDICTOR_H
+
+#include <vector>
+
+#include "BranchHistory.h"
+
+
+namespace x86
+{
+
+/// TAGE conditional branch predictor (tagged geometric history length), with
+/// an optional loop predictor and statistical corrector (TAGE-SC-L).
+///
+/// A bimodal base table is backed by tagged tables indexed with global
+/// histories of geometrically increasing lengths. The prediction comes from
+/// the matching table with the longest history. The loop predictor
+/// overrides it for loops with a constant trip count, and the statistical
+/// corrector reverts low-confidence predictions that disagree with the sum
+/// of a set of counters indexed with short histories.
+///
+/// Predictions are read with Lookup(), which saves the table positions in an
+/// Info structure. Update() trains the tables with those positions once the
+/// branch commits.
+class TagePredictor
+{
+public:
+
+	/// Maximum number of tagged tables
+	static const int MaxTables = 12;
+
+	/// Number of tables of the statistical corrector, including the bias
+	/// table indexed by address only
+	static const int NumScTables = 4;
+
+	/// Information obtained on a lookup, needed to update the predictor
+	struct Info
+	{
+		// Position of the branch in the tagged tables
+		unsigned short index[MaxTables];
+		unsigned short tag[MaxTables];
+
+		// Index in the base table
+		int base_index;
+
+		// Table providing the prediction, and alternate table, or -1
+		// for the base table
+		int provider;
+		int alt_provider;
+
+		// Prediction of the provider and alternate tables
+		bool provider_prediction;
+		bool alt_prediction;
+
+		// Provider entry was recently allocated
+		bool weak;
+
+		// Prediction of the tagged tables
+		bool tage_prediction;
+
+		// Loop predictor entry found, confident, and its prediction
+		int loop_index;
+		bool loop_hit;
+		bool loop_valid;
+		bool loop_prediction;
+
+		// Iterations of the current loop execution before the branch
+		int loop_iter;
+
+		// Statistical corrector positions and sum
+		unsigned short sc_index[NumScTables];
+		int sc_sum;
+
+		/// Final prediction
+		bool prediction;
+	};
+
+private:
+
+	// Entry of a tagged table
+	struct Entry
+	{
+		// 3-bit signed counter, taken if >= 0
+		signed char counter = 0;
+
+		// Partial tag
+		unsigned short tag = 0;
+
+		// 2-bit usefulness counter
+		unsigned char useful = 0;
+	};
+
+	// Entry of the loop predictor
+	struct LoopEntry
+	{
+		// Partial tag
+		unsigned short tag = 0;
+
+		// Iterations of the loop, or 0 if not known yet
+		unsigned short trip = 0;
+
+		// Iterations of the current execution of the loop
+		unsigned short iter = 0;
+
+		// Number of consecutive executions with the same trip count
+		unsigned char confidence = 0;
+
+		// Protection against replacement
+		unsigned char age = 0;
+
+		// Direction of the branch while iterating
+		bool direction = false;
+
+		// Entry in use
+		bool valid = false;
+	};
+
+	// Number of tagged tables
+	int num_tables;
+
+	// Log base 2 of the number of entries in the base table
+	int log_base_size;
+
+	// Log base 2 of the number of entries in each tagged table
+	int log_table_size;
+
+	// Bits of the partial tags
+	int tag_bits;
+
+	// Log base 2 of the number of entries in the loop predictor, or 0
+	int log_loop_size;
+
+	// Statistical corrector present
+	bool statistical_corrector;
+
+	// Base table of 2-bit counters
+	std::vector<unsigned char> base;
+
+	// Tagged tables, 'num_tables' tables of 2^log_table_size entries
+	std::vector<Entry> tables;
+
+	// Loop predictor
+	std::vector<LoopEntry> loop_table;
+
+	// Statistical corrector tables of 6-bit signed counters
+	std::vector<signed char> sc_tables[NumScTables];
+
+	// Global history
+	BranchHistory history;
+
+	// Global history folded for the index and the tag of each table
+	FoldedHistory index_history[MaxTables];
+	FoldedHistory tag_history[MaxTables][2];
+
+	// Global history folded for the statistical corrector tables
+	FoldedHistory sc_history[NumScTables];
+
+	// Counter selecting the alternate prediction when the provider entry
+	// was recently allocated, used if >= 0
+	int use_alt_on_new = 0;
+
+	// Counter selecting the loop predictor when confident, used if >= 0
+	int use_loop = 0;
+
+	// Threshold of the statistical corrector, and counter adapting it
+	int sc_threshold = 6;
+	int sc_threshold_counter = 0;
+
+	// Number of updates, used to age the usefulness counters
+	long long num_updates = 0;
+
+	// Return entry of a tagged table
+	Entry &getEntry(int table, int index)
+	{
+		return tables[(table << log_table_size) + index];
+	}
+
+	// Look up and train the loop predictor
+	void LookupLoop(unsigned eip, Info &info);
+	void UpdateLoop(unsigned eip, bool taken, const Info &info);
+
+	// Look up and train the statistical corrector
+	void LookupStatisticalCorrector(unsigned eip, Info &info);
+	void UpdateStatisticalCorrector(bool taken, const Info &info);
+
+	// Train the tagged tables
+	void UpdateTables(bool taken, const Info &info);
+
+public:
+
+	/// Constructor
+	///
+	/// \param num_tables
+	///	Number of tagged tables, up to MaxTables.
+	///
+	/// \param log_base_size
+	///	Log base 2 of the number of entries of the base table.
+	///
+	/// \param log_table_size
+	///	Log base 2 of the number of entries of each tagged table.
+	///
+	/// \param tag_bits
+	///	Number of bits of the partial tags.
+	///
+	/// \param min_history
+	/// \param max_history
+	///	Global history lengths of the first and last tagged tables.
+	///
+	/// \param log_loop_size
+	///	Log base 2 of the number of entries of the loop predictor, or 0
+	///	for no loop predictor.
+	///
+	/// \param statistical_corrector
+	///	Whether to use a statistical corrector.
+	///
+	TagePredictor(int num_tables,
+			int log_base_size,
+			int log_table_size,
+			int tag_bits,
+			int min_history,
+			int max_history,
+			int log_loop_size,
+			bool statistical_corrector);
+
+	/// Return the prediction for the conditional branch at \a eip, and
+	/// save in \a info the information needed to update the predictor.
+	/// The predictor state is not modified.
+	bool Lookup(unsigned eip, Info &info);
+
+	/// Insert the direction of a branch in the global history, and advance
+	/// the iteration count of its loop. This is done after the lookup of
+	/// every branch in the correct path.
+	void UpdateHistory(bool taken, const Info &info);
+
+	/// Train the predictor with the direction of a committed branch,
+	/// given the information saved on its lookup.
+	void Update(unsigned eip, bool taken, const Info &info);
+};
+
+
+/// ITTAGE indirect branch target predictor. Tagged tables indexed with
+/// global histories of geometrically increasing lengths keep targets of
+/// indirect jumps and calls, with a table indexed by address only as a base.
+class IttagePredictor
+{
+public:
+
+	/// Maximum number of tagged tables
+	static const int MaxTables = 8;
+
+	/// Information obtained on a lookup, needed to update the predictor
+	struct Info
+	{
+		/// The branch was looked up in the predictor
+		bool valid = false;
+
+		// Position of the branch in the tagged tables
+		unsigned short index[MaxTables];
+		unsigned short tag[MaxTables];
+
+		// Index in the base table
+		int base_index;
+
+		// Table providing the prediction, and alternate table, or -1
+		// for the base table
+		int provider;
+		int alt_provider;
+
+		// Target predicted by the provider and alternate tables
+		unsigned provider_target;
+		unsigned alt_target;
+
+		// Predicted target, or 0 if none
+		unsigned target;
+	};
+
+private:
+
+	// Entry of a table
+	struct Entry
+	{
+		// Target, or 0 if none
+		unsigned target = 0;
+
+		// Partial tag, unused in the base table
+		unsigned short tag = 0;
+
+		// 2-bit confidence counter
+		unsigned char confidence = 0;
+
+		// Usefulness bit, unused in the base table
+		bool useful = false;
+	};
+
+	// Number of tagged tables
+	int num_tables;
+
+	// Log base 2 of the number of entries in the base table
+	int log_base_size;
+
+	// Log base 2 of the number of entries in each tagged table
+	int log_table_size;
+
+	// Bits of the partial tags
+	int tag_bits;
+
+	// Base table
+	std::vector<Entry> base;
+
+	// Tagged tables
+	std::vector<Entry> tables;
+
+	// Global history
+	BranchHistory history;
+
+	// Global history folded for the index and the tag of each table
+	FoldedHistory index_history[MaxTables];
+	FoldedHistory tag_history[MaxTables][2];
+
+	// Number of updates, used to age the usefulness bits
+	long long num_updates = 0;
+
+	// Return entry of a tagged table
+	Entry &getEntry(int table, int index)
+	{
+		return tables[(table << log_table_size) + index];
+	}
+
+public:
+
+	/// Constructor, with arguments as in TagePredictor
+	IttagePredictor(int num_tables,
+			int log_base_size,
+			int log_table_size,
+			int tag_bits,
+			int min_history,
+			int max_history);
+
+	/// Return the predicted target of the indirect branch at \a eip, or
+	/// 0 if none, and save in \a info the information needed to update
+	/// the predictor.
+	unsigned Lookup(unsigned eip, Info &info);
+
+	/// Insert a bit in the global history. Conditional branches insert
+	/// their direction, and indirect branches bits of their target.
+	void UpdateHistory(bool bit);
+
+	/// Train the predictor with the target of a committed indirect
+	/// branch, given the information saved on its lookup.
+	void Update(unsigned target, const Info &info);
+};
+
+
+}  // namespace x86
+
+#endif
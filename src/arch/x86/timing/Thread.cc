@@ -17,6 +17,9 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "Cpu.h"
 #include "Timing.h"
 #include "Thread.h"
@@ -54,7 +57,12 @@ const misc::StringMap Thread::dispatch_stall_map =
 Thread::Thread(Core *core,
 		int id_in_core) :
 		core(core),
-		id_in_core(id_in_core)
+		id_in_core(id_in_core),
+		reorder_buffer(Cpu::getReorderBufferSize()),
+		instruction_queue(Cpu::getReorderBufferSize()),
+		ready_instruction_queue(Cpu::getReorderBufferSize()),
+		load_queue(Cpu::getReorderBufferSize()),
+		ready_load_queue(Cpu::getReorderBufferSize())
 {
 	// Assign name
 	name = misc::fmt("Core %d Thread %d", core->getId(), id_in_core);
@@ -76,6 +84,14 @@ Thread::Thread(Core *core,
 
 	// Initialize register file
 	register_file = misc::new_unique<RegisterFile>(this);
+
+	// Initialize store set tables
+	if (Cpu::getMemoryDependenceKind() ==
+			Cpu::MemoryDependenceKindStoreSet)
+	{
+		store_set_table.resize(Cpu::getSsitSize(), -1);
+		last_store_table.resize(Cpu::getLfstSize());
+	}
 }
 
 
@@ -110,7 +126,7 @@ void Thread::InsertInFetchQueue(std::shared_ptr<Uop> uop)
 
 	// Insert in queue
 	uop->in_fetch_queue = true;
-	uop->fetch_queue_iterator = fetch_queue.insert(fetch_queue.end(), uop);
+	fetch_queue.push_back(uop);
 
 	// Increase occupancy of fetch queue or trace queue
 	if (uop->from_trace_cache)
@@ -135,17 +151,12 @@ void Thread::ExtractFromFetchQueue(Uop *uop)
 	// Sanity: uop must be in the fetch queue, and must be either the first
 	// or the last element in it.
 	assert(uop->in_fetch_queue);
-	assert(uop->fetch_queue_iterator != fetch_queue.end());
 	assert(fetch_queue.size() > 0);
 	assert(uop == fetch_queue.front().get() ||
 			uop == fetch_queue.back().get());
-	
-	// Save iterator
-	auto it = uop->fetch_queue_iterator;
 
 	// Mark uop as extracted
 	uop->in_fetch_queue = false;
-	uop->fetch_queue_iterator = fetch_queue.end();
 
 	// Decrease occupancy of fetch queue or trace queue
 	if (uop->from_trace_cache)
@@ -168,7 +179,10 @@ void Thread::ExtractFromFetchQueue(Uop *uop)
 	}
 
 	// Extract uop as last step, since uop may be freed here
-	fetch_queue.erase(it);
+	if (uop == fetch_queue.front().get())
+		fetch_queue.pop_front();
+	else
+		fetch_queue.pop_back();
 }
 
 
@@ -201,7 +215,7 @@ void Thread::InsertInUopQueue(std::shared_ptr<Uop> uop)
 {
 	assert(!uop->in_uop_queue);
 	uop->in_uop_queue = true;
-	uop->uop_queue_iterator = uop_queue.insert(uop_queue.end(), uop);
+	uop_queue.push_back(uop);
 }
 
 
@@ -211,17 +225,17 @@ void Thread::ExtractFromUopQueue(Uop *uop)
 	// or the last element in it.
 	assert(uop->in_uop_queue);
 	assert(uop_queue.size() > 0);
-	assert(uop == uop_queue.front().get() || uop_queue.back().get());
-
-	// Save iterator
-	auto it = uop->uop_queue_iterator;
+	assert(uop == uop_queue.front().get() ||
+			uop == uop_queue.back().get());
 
 	// Mark uop as extracted
 	uop->in_uop_queue = false;
-	uop->uop_queue_iterator = uop_queue.end();
 
 	// Extract uop as last step, since this may free it
-	uop_queue.erase(it);
+	if (uop == uop_queue.front().get())
+		uop_queue.pop_front();
+	else
+		uop_queue.pop_back();
 }
 
 
@@ -283,9 +297,13 @@ void Thread::InsertInReorderBuffer(std::shared_ptr<Uop> uop)
 	// Sanity
 	assert(!uop->in_reorder_buffer);
 
+	// The reorder buffer must not grow, since the position of its uops
+	// index the instruction and load queues
+	assert(reorder_buffer.size() < reorder_buffer.getCapacity());
+
 	// Insert into reorder buffer
 	uop->in_reorder_buffer = true;
-	uop->reorder_buffer_iterator = reorder_buffer.insert(reorder_buffer.end(), uop);
+	uop->reorder_buffer_slot = reorder_buffer.push_back(uop);
 
 	// Increase per-core counter
 	core->incReorderBufferOccupancy();
@@ -298,17 +316,17 @@ void Thread::ExtractFromReorderBuffer(Uop *uop)
 	// first or the last instruction in that queue.
 	assert(uop->in_reorder_buffer);
 	assert(reorder_buffer.size() > 0);
-	assert(uop == reorder_buffer.front().get() || reorder_buffer.back().get());
-
-	// Save iterator
-	auto it = uop->reorder_buffer_iterator;
+	assert(uop == reorder_buffer.front().get() ||
+			uop == reorder_buffer.back().get());
 
 	// Mark uop as extracted
 	uop->in_reorder_buffer = false;
-	uop->reorder_buffer_iterator = reorder_buffer.end();
 
 	// Extract uop as last step, since this may free it
-	reorder_buffer.erase(it);
+	if (uop == reorder_buffer.front().get())
+		reorder_buffer.pop_front();
+	else
+		reorder_buffer.pop_back();
 
 	// Decrease per-core counter
 	core->decReorderBufferOccupancy();
@@ -368,6 +386,34 @@ void Thread::DumpReorderBuffer(std::ostream &os) const
 }
 
 
+int Thread::getNextReadySlot(const misc::Bitmap &ready, int slot) const
+{
+	// Empty reorder buffer
+	if (reorder_buffer.empty())
+		return -1;
+
+	// Position in the reorder buffer where the search starts, relative
+	// to the head
+	int size = ready.getSize();
+	int head = reorder_buffer.getHead();
+	int position = slot < 0 ? 0 : (slot - head + size) % size + 1;
+
+	// Search from the starting slot up to the last slot
+	int from = head + position;
+	if (from < size)
+	{
+		int next = ready.FindNext(from);
+		if (next < size)
+			return next;
+		from = size;
+	}
+
+	// Search from the first slot up to the head
+	int next = ready.FindNext(from - size);
+	return next < head ? next : -1;
+}
+
+
 bool Thread::canInsertInInstructionQueue()
 {
 	switch (Cpu::getInstructionQueueKind())
@@ -378,7 +424,7 @@ bool Thread::canInsertInInstructionQueue()
 		// Return whether the number of instructions in this thread's IQ
 		// is smaller than the IQ size configured by the user, which is
 		// specified as a per-thread IQ size.
-		return (int) instruction_queue.size() <
+		return uop_count_in_instruction_queue <
 				Cpu::getInstructionQueueSize();
 
 	case Cpu::InstructionQueueKindShared:
@@ -404,9 +450,12 @@ void Thread::InsertInInstructionQueue(std::shared_ptr<Uop> uop)
 	assert(!uop->in_store_queue);
 
 	// Insert into instruction queue
+	assert(uop->in_reorder_buffer);
 	uop->in_instruction_queue = true;
-	uop->instruction_queue_iterator = instruction_queue.insert(
-			instruction_queue.end(), uop);
+	instruction_queue.Set(uop->reorder_buffer_slot);
+	if (uop->ready)
+		ready_instruction_queue.Set(uop->reorder_buffer_slot);
+	uop_count_in_instruction_queue++;
 
 	// Increase per-core counter
 	core->incInstructionQueueOccupancy();
@@ -420,15 +469,11 @@ void Thread::ExtractFromInstructionQueue(Uop *uop)
 	assert(!uop->in_store_queue);
 	assert(uop->in_instruction_queue);
 
-	// Save iterator
-	auto it = uop->instruction_queue_iterator;
-
-	// Mark uop as not present
+	// Remove from queue
 	uop->in_instruction_queue = false;
-	uop->instruction_queue_iterator = instruction_queue.end();
-	
-	// Remove from queue as the last step, as this may free the uop
-	instruction_queue.erase(it);
+	instruction_queue.Reset(uop->reorder_buffer_slot);
+	ready_instruction_queue.Reset(uop->reorder_buffer_slot);
+	uop_count_in_instruction_queue--;
 
 	// Decrease per-core counter
 	core->decInstructionQueueOccupancy();
@@ -442,17 +487,19 @@ void Thread::DumpInstructionQueue(std::ostream &os) const
 	os << title << '\n';
 	os << std::string(title.size(), '-') << "\n\n";
 
-	// Dump content
+	// Dump content, in the order of the reorder buffer
 	int index = 0;
-	for (auto &uop : instruction_queue)
+	for (auto &uop : reorder_buffer)
 	{
+		if (!uop->in_instruction_queue)
+			continue;
 		os << misc::fmt("%3d. ", index);
 		os << *uop << '\n';
 		index++;
 	}
 
 	// Empty list
-	if (instruction_queue.empty())
+	if (!index)
 		os << "-Empty-\n";
 
 	// End
@@ -470,7 +517,7 @@ bool Thread::canInsertInLoadStoreQueue()
 		// Return whether the number of instructions in this thread's
 		// LSQ is smaller than the IQ size configured by the user, which
 		// is specified as a per-thread LSQ size
-		return (int) (load_queue.size() + store_queue.size()) <
+		return uop_count_in_load_store_queue <
 				Cpu::getLoadStoreQueueSize();
 
 	case Cpu::LoadStoreQueueKindShared:
@@ -500,14 +547,17 @@ void Thread::InsertInLoadStoreQueue(std::shared_ptr<Uop> uop)
 
 	case Uinst::OpcodeLoad:
 
-		uop->load_queue_iterator = load_queue.insert(load_queue.end(), uop);
+		assert(uop->in_reorder_buffer);
 		uop->in_load_queue = true;
+		load_queue.Set(uop->reorder_buffer_slot);
+		if (uop->ready)
+			ready_load_queue.Set(uop->reorder_buffer_slot);
 		break;
 
 	case Uinst::OpcodeStore:
 
-		uop->store_queue_iterator = store_queue.insert(store_queue.end(), uop);
 		uop->in_store_queue = true;
+		store_queue.push_back(uop);
 		break;
 	
 	default:
@@ -515,8 +565,12 @@ void Thread::InsertInLoadStoreQueue(std::shared_ptr<Uop> uop)
 		throw misc::Panic("Invalid micro-instruction opcode");
 	}
 
-	// Increase per-core counter
+	// Increase counters
+	uop_count_in_load_store_queue++;
 	core->incLoadStoreQueueOccupancy();
+
+	// Memory dependences
+	PredictMemoryDependence(uop);
 }
 
 
@@ -527,17 +581,13 @@ void Thread::ExtractFromLoadQueue(Uop *uop)
 	assert(!uop->in_store_queue);
 	assert(!uop->in_instruction_queue);
 
-	// Save iterator
-	auto it = uop->load_queue_iterator;
-
-	// Mark as not present in the queue
+	// Remove from queue
 	uop->in_load_queue = false;
-	uop->load_queue_iterator = load_queue.end();
-	
-	// Remove from queue as last step, as this may free uop
-	load_queue.erase(it);
+	load_queue.Reset(uop->reorder_buffer_slot);
+	ready_load_queue.Reset(uop->reorder_buffer_slot);
 
-	// Decrease per-core counter
+	// Decrease counters
+	uop_count_in_load_store_queue--;
 	core->decLoadStoreQueueOccupancy();
 }
 
@@ -548,19 +598,177 @@ void Thread::ExtractFromStoreQueue(Uop *uop)
 	assert(!uop->in_instruction_queue);
 	assert(!uop->in_load_queue);
 	assert(uop->in_store_queue);
-
-	// Save iterator
-	auto it = uop->store_queue_iterator;
+	assert(uop == store_queue.front().get() ||
+			uop == store_queue.back().get());
 
 	// Mark as not present in the queue
 	uop->in_store_queue = false;
-	uop->store_queue_iterator = store_queue.end();
+
+	// Decrease counters
+	uop_count_in_load_store_queue--;
+	core->decLoadStoreQueueOccupancy();
 
 	// Remove from queue as last step, as this may free uop
-	store_queue.erase(it);
+	if (uop == store_queue.front().get())
+		store_queue.pop_front();
+	else
+		store_queue.pop_back();
+}
 
-	// Decrease per-core counter
-	core->decLoadStoreQueueOccupancy();
+
+void Thread::WakeUp(Uop *uop)
+{
+	// Mark as ready in its queue
+	assert(uop->ready);
+	if (uop->in_instruction_queue)
+		ready_instruction_queue.Set(uop->reorder_buffer_slot);
+	else if (uop->in_load_queue)
+		ready_load_queue.Set(uop->reorder_buffer_slot);
+	else if (uop->in_store_queue)
+		ResolveStore(uop);
+}
+
+
+void Thread::PredictMemoryDependence(const std::shared_ptr<Uop> &uop)
+{
+	// Only for store sets
+	if (Cpu::getMemoryDependenceKind() !=
+			Cpu::MemoryDependenceKindStoreSet)
+		return;
+
+	// Clear the SSIT periodically, so that stores that stopped aliasing
+	// with loads no longer hold them back
+	long long cycle = cpu->getCycle();
+	int clear_interval = Cpu::getSsitClearInterval();
+	if (clear_interval && cycle - store_set_clear_cycle >= clear_interval)
+	{
+		std::fill(store_set_table.begin(), store_set_table.end(), -1);
+		store_set_clear_cycle = cycle;
+	}
+
+	// Store set of the instruction
+	int index = uop->eip & (Cpu::getSsitSize() - 1);
+	uop->store_set = store_set_table[index];
+	if (uop->store_set < 0)
+		return;
+
+	// A load depends on the last store of its set, if its address is not
+	// resolved yet. A store becomes the last store of its set.
+	std::shared_ptr<Uop> &last_store = last_store_table[uop->store_set];
+	if (uop->getOpcode() == Uinst::OpcodeLoad)
+	{
+		if (last_store && !last_store->ready &&
+				last_store->in_reorder_buffer)
+			uop->store_dependence = last_store;
+	}
+	else if (!uop->ready)
+	{
+		last_store = uop;
+	}
+}
+
+
+bool Thread::canIssueLoad(Uop *uop)
+{
+	switch (Cpu::getMemoryDependenceKind())
+	{
+
+	case Cpu::MemoryDependenceKindNone:
+
+		// Loads ignore older stores
+		return true;
+
+	case Cpu::MemoryDependenceKindConservative:
+
+		// Wait for the address of all older stores
+		for (auto &store : store_queue)
+		{
+			if (store->getIdInCore() > uop->getIdInCore())
+				break;
+			if (!store->ready)
+				return false;
+		}
+		return true;
+
+	case Cpu::MemoryDependenceKindStoreSet:
+	{
+		// Wait for the address of the store predicted at dispatch, if
+		// it was not squashed
+		Uop *store = uop->store_dependence.get();
+		return !store || store->ready || !store->in_reorder_buffer;
+	}
+
+	default:
+
+		throw misc::Panic("Invalid memory dependence kind");
+	}
+}
+
+
+void Thread::ResolveStore(Uop *uop)
+{
+	// Only for store sets. In the other cases, loads never issue before
+	// an older store that may write the same address.
+	if (Cpu::getMemoryDependenceKind() !=
+			Cpu::MemoryDependenceKindStoreSet)
+		return;
+
+	// The store no longer holds back the loads of its set
+	assert(uop->in_reorder_buffer);
+	if (uop->store_set >= 0 && last_store_table[uop->store_set].get() == uop)
+		last_store_table[uop->store_set] = nullptr;
+
+	// Find the oldest younger load that already issued to an address
+	// overlapping with the store
+	unsigned address = uop->physical_address;
+	unsigned size = uop->getUinst()->getSize();
+	std::shared_ptr<Uop> load;
+	for (int index = reorder_buffer.size() - 1; index >= 0; index--)
+	{
+		const std::shared_ptr<Uop> &younger = reorder_buffer[index];
+		if (younger.get() == uop)
+			break;
+		if (younger->getOpcode() == Uinst::OpcodeLoad &&
+				younger->issued &&
+				younger->physical_address < address + size &&
+				address < younger->physical_address +
+				younger->getUinst()->getSize())
+			load = younger;
+	}
+
+	// No violation
+	if (!load)
+		return;
+
+	// Place the load and the store in the same store set. A new set is
+	// allocated if none of them has one, and the set with the lowest
+	// identifier is kept if both have one.
+	int mask = Cpu::getSsitSize() - 1;
+	int &load_set = store_set_table[load->eip & mask];
+	int &store_set = store_set_table[uop->eip & mask];
+	if (load_set < 0 && store_set < 0)
+	{
+		load_set = next_store_set;
+		store_set = next_store_set;
+		next_store_set = (next_store_set + 1) % Cpu::getLfstSize();
+	}
+	else if (load_set < 0)
+	{
+		load_set = store_set;
+	}
+	else if (store_set < 0 || load_set < store_set)
+	{
+		store_set = load_set;
+	}
+	else
+	{
+		load_set = store_set;
+	}
+
+	// Replay from the oldest violating load
+	if (!violating_load || load->getIdInCore() <
+			violating_load->getIdInCore())
+		violating_load = load;
 }
 
 
@@ -571,17 +779,19 @@ void Thread::DumpLoadStoreQueue(std::ostream &os) const
 	os << title << '\n';
 	os << std::string(title.size(), '-') << "\n\n";
 
-	// Dump content
+	// Dump content, in the order of the reorder buffer
 	int index = 0;
-	for (auto &uop : load_queue)
+	for (auto &uop : reorder_buffer)
 	{
+		if (!uop->in_load_queue)
+			continue;
 		os << misc::fmt("%3d. ", index);
 		os << *uop << '\n';
 		index++;
 	}
 
 	// Empty list
-	if (load_queue.empty())
+	if (!index)
 		os << "-Empty-\n";
 
 	// End
@@ -610,5 +820,99 @@ void Thread::DumpLoadStoreQueue(std::ostream &os) const
 }
 
 
+long long Thread::getQuiescentUntil()
+{
+	// A context being evicted is removed from the thread as soon as its
+	// pipeline drains.
+	if (context && context->evict_signal)
+		return 0;
+
+	// Fetch stage
+	if (canFetch() == FetchStallUsed)
+		return 0;
+
+	// Decode stage
+	if (fetch_queue.size() &&
+			(int) uop_queue.size() < Cpu::getUopQueueSize())
+	{
+		Uop *uop = fetch_queue.front().get();
+		if (uop->from_trace_cache || !instruction_module->
+				isInFlightAccess(uop->fetch_access))
+			return 0;
+	}
+
+	// Dispatch stage
+	if (canDispatch() == DispatchStallUsed)
+		return 0;
+
+	// Issue stage. Uops waiting for a busy functional unit or a busy data
+	// cache update statistics in every cycle, so any ready uop prevents
+	// quiescence.
+	if (ready_instruction_queue.Any() || ready_load_queue.Any())
+		return 0;
+	if (store_queue.size() && !store_queue.front()->in_reorder_buffer)
+		return 0;
+
+	// Commit stage
+	if (reorder_buffer.size())
+	{
+		Uop *uop = reorder_buffer.front().get();
+		if (uop->getOpcode() == Uinst::OpcodeStore ?
+				register_file->isUopReady(uop) :
+				uop->completed)
+			return 0;
+	}
+
+	// A running context must commit before the commit stall check fires
+	if (context && context->getState(Context::StateRunning))
+		return last_commit_cycle + Timing::MaxStallCycles + 1;
+
+	// Quiescent until some event occurs
+	return std::numeric_limits<long long>::max();
+}
+
+
+void Thread::WarmUp(Context *context)
+{
+	// Instruction cache, accessed once per fetched block
+	assert(context->thread == this);
+	mem::Mmu *mmu = context->getMmu();
+	mem::Mmu::Space *mmu_space = context->getMmuSpace();
+	Instruction *instruction = context->getInstruction();
+	unsigned eip = instruction->getEip();
+	unsigned block_address = eip & ~(instruction_module->getBlockSize() - 1);
+	if (block_address != fetch_block_address)
+	{
+		fetch_block_address = block_address;
+		instruction_module->WarmUp(mem::Module::AccessLoad,
+				mmu->TranslateVirtualAddress(mmu_space, eip));
+	}
+
+	// Micro-instructions
+	while (context->getNumUinsts())
+	{
+		const Uinst *uinst = context->ExtractUinst();
+
+		// Data cache
+		if (uinst->getFlags() & Uinst::FlagMem)
+			data_module->WarmUp(uinst->getOpcode() ==
+					Uinst::OpcodeStore ?
+					mem::Module::AccessStore :
+					mem::Module::AccessLoad,
+					mmu->TranslateVirtualAddress(mmu_space,
+					uinst->getAddress()));
+
+		// Branch predictor
+		if (uinst->getFlags() & Uinst::FlagCtrl)
+		{
+			Uop uop(this, context, *uinst);
+			uop.eip = eip;
+			uop.mop_size = instruction->getSize();
+			uop.neip = context->getRegs().getEip();
+			uop.target_neip = context->getTargetEip();
+			branch_predictor->WarmUp(&uop);
+		}
+	}
 }
 
+}
@@ -21,8 +21,11 @@
 #define ARCH_X86_TIMING_THREAD_H
 
 #include <deque>
+#include <sstream>
 #include <string>
+#include <vector>
 
+#include <lib/cpp/Bitmap.h>
 #include <memory/Module.h>
 #include <arch/x86/emulator/Uinst.h>
 #include <arch/x86/emulator/Context.h>
@@ -31,6 +34,7 @@
 #include "BranchPredictor.h"
 #include "RegisterFile.h"
 #include "TraceCache.h"
+#include "UopRing.h"
 
 
 namespace x86
@@ -82,7 +86,7 @@ private:
 	//
 
 	// Fetch queue
-	std::list<std::shared_ptr<Uop>> fetch_queue;
+	UopRing fetch_queue;
 
 	// Insert a uop into the tail of the fetch queue
 	void InsertInFetchQueue(std::shared_ptr<Uop> uop);
@@ -102,10 +106,7 @@ private:
 	//
 
 	// Uop queue
-	std::list<std::shared_ptr<Uop>> uop_queue;
-
-	// Insert a uop into the tail of the uop queue
-	void InsertInUopQueue(std::shared_ptr<Uop> uop);
+	UopRing uop_queue;
 
 	// Extract a uop from the uop queue. The uop must be located either at
 	// the head or at the tail of the uop queue.
@@ -121,8 +122,10 @@ private:
 	// Reorder buffer
 	//
 
-	// Reorder buffer
-	std::list<std::shared_ptr<Uop>> reorder_buffer;
+	// Reorder buffer, with a capacity equal to the reorder buffer size.
+	// The uops of the instruction and load queues are indexed by their
+	// position in the reorder buffer (see Uop::reorder_buffer_slot).
+	UopRing reorder_buffer;
 
 	// Insert a uop into the tail of the reorder buffer
 	void InsertInReorderBuffer(std::shared_ptr<Uop> uop);
@@ -142,19 +145,25 @@ private:
 
 
 
-
 	//
 	// Instruction Queue
 	//
 
-	// Instruction queue
-	std::list<std::shared_ptr<Uop>> instruction_queue;
+	// Uops in the instruction queue, indexed by their reorder buffer
+	// slot. Since uops enter the queue in the order of the reorder buffer,
+	// the queue is traversed in age order starting at the head of the
+	// reorder buffer.
+	misc::Bitmap instruction_queue;
+
+	// Uops in the instruction queue whose inputs are ready, indexed by
+	// their reorder buffer slot
+	misc::Bitmap ready_instruction_queue;
 
 	// Insert a uop into the tail of the instruction queue
 	void InsertInInstructionQueue(std::shared_ptr<Uop> uop);
 
 	// Remove a uop from the instruction queue. The uop must be currently
-	// present in said queue.
+	// present in said queue, in any position.
 	void ExtractFromInstructionQueue(Uop *uop);
 	
 	// Determine whether a new uop can be inserted into this thread's
@@ -172,11 +181,16 @@ private:
 	// Load-store queue
 	//
 	
-	// Load queue
-	std::list<std::shared_ptr<Uop>> load_queue;
+	// Uops in the load queue, indexed by their reorder buffer slot
+	misc::Bitmap load_queue;
+
+	// Uops in the load queue whose inputs are ready, indexed by their
+	// reorder buffer slot
+	misc::Bitmap ready_load_queue;
 
-	// Store queue
-	std::list<std::shared_ptr<Uop>> store_queue;
+	// Store queue. Stores stay in the queue after they commit, until they
+	// are issued to the memory system.
+	UopRing store_queue;
 
 	// Determine whether a new uop can be inserted into this thread's
 	// load-store queue, based on whether the queue was configured as
@@ -189,11 +203,11 @@ private:
 	void InsertInLoadStoreQueue(std::shared_ptr<Uop> uop);
 
 	// Remove a uop from the load queue. The uop must be currently present
-	// in said queue.
+	// in said queue, in any position.
 	void ExtractFromLoadQueue(Uop *uop);
 
-	// Remove a uop from the store queue. The uop must be currently present
-	// in said queue.
+	// Remove a uop from the store queue. The uop must be located either
+	// at the head or at the tail of the store queue.
 	void ExtractFromStoreQueue(Uop *uop);
 
 	// Dump content of load_store queue
@@ -202,6 +216,39 @@ private:
 
 
 
+	//
+	// Memory dependences
+	//
+
+	// Store set identifier table (SSIT), giving the store set of the
+	// loads and stores at each instruction address, or -1 if none
+	std::vector<int> store_set_table;
+
+	// Last fetched store table (LFST), with the last store of each store
+	// set inserted in the store queue whose address is not resolved yet
+	std::vector<std::shared_ptr<Uop>> last_store_table;
+
+	// Next store set to allocate
+	int next_store_set = 0;
+
+	// Cycle when the SSIT was last cleared
+	long long store_set_clear_cycle = 0;
+
+	// Oldest load found to have issued before an older store to the same
+	// address, pending recovery
+	std::shared_ptr<Uop> violating_load;
+
+	// Predict the memory dependences of a load or store inserted in the
+	// load-store queue, based on the store set of its address
+	void PredictMemoryDependence(const std::shared_ptr<Uop> &uop);
+
+	// Resolve the address of a store in the store queue, checking whether
+	// a younger load already issued to the same address
+	void ResolveStore(Uop *uop);
+
+
+
+
 	//
 	// Hardware structures
 	//
@@ -250,6 +297,10 @@ private:
 	// Access identifier for of last instruction fetch
 	long long fetch_access = 0;
 
+	// Stream used to disassemble fetched instructions into the trace,
+	// reused to avoid creating a stream for every instruction
+	std::ostringstream fetch_trace_stream;
+
 	// Cycle in which last micro-instruction committed
 	long long last_commit_cycle = 0;
 
@@ -300,6 +351,14 @@ private:
 	// Number of mis-predicted branch micro-instructions
 	long long num_mispredicted_branches = 0;
 
+	// Number of loads that issued before an older store to the same
+	// address
+	long long num_memory_violations = 0;
+
+	// Number of micro-instructions replayed after memory dependence
+	// violations
+	long long num_replayed_uinsts = 0;
+
 
 
 
@@ -379,6 +438,12 @@ public:
 	/// Return the thread's register file
 	RegisterFile *getRegisterFile() const { return register_file.get(); }
 
+	/// Let a uop in the instruction or load queue be issued, or resolve
+	/// the address of a store in the store queue. This function is invoked
+	/// by the register file when the last pending input of the uop is
+	/// written.
+	void WakeUp(Uop *uop);
+
 	/// Increment the number of writes to integer registers
 	void incNumIntegerRegisterWrites(int count = 1)
 	{
@@ -468,6 +533,11 @@ public:
 	/// Run decode stage
 	void Decode();
 
+	/// Insert a uop into the tail of the uop queue, from where the
+	/// dispatch stage takes it. This function is invoked internally by
+	/// the decode stage.
+	void InsertInUopQueue(std::shared_ptr<Uop> uop);
+
 
 
 
@@ -515,6 +585,12 @@ public:
 	/// the remaining qunatum.
 	int IssueLoadQueue(int quantum);
 
+	/// Return whether the older stores that a load may depend on allow it
+	/// to issue, based on the memory dependence kind selected in the
+	/// configuration. This function is invoked internally by
+	/// IssueLoadQueue().
+	bool canIssueLoad(Uop *uop);
+
 	/// Issue \a quantum instructions for the thread's store queue,
 	/// returning the remaining quantum.
 	int IssueStoreQueue(int quantum);
@@ -528,6 +604,14 @@ public:
 	/// The function returns the remaining quantum.
 	int IssueInstructionQueue(int quantum);
 
+	/// Return the slot of the first uop set in bitmap \a ready whose
+	/// position in the reorder buffer follows the uop in \a slot, or the
+	/// first one if \a slot is -1. Return -1 if there is no such uop.
+	/// This function is invoked internally by IssueLoadQueue() and
+	/// IssueInstructionQueue() to visit the ready uops of their queues
+	/// in the order of the reorder buffer.
+	int getNextReadySlot(const misc::Bitmap &ready, int slot) const;
+
 
 
 
@@ -572,6 +656,12 @@ public:
 	/// Recover from mispeculation
 	void Recover();
 
+	/// Replay the load found to violate a memory dependence, if any, and
+	/// all uops following it. The uops are squashed from the reorder
+	/// buffer and inserted back at the head of the uop queue, since they
+	/// were already emulated when fetched.
+	void RecoverMemoryViolation();
+
 
 
 
@@ -608,6 +698,33 @@ public:
 
 
 
+	//
+	// Idle-cycle fast-forwarding (Thread.cc)
+	//
+
+	/// Return 0 if running the pipeline stages of the thread in the
+	/// current cycle could have any effect. Otherwise, return the first
+	/// cycle when they must run regardless of events in the memory
+	/// hierarchy, or the maximum \c long \c long value if there is no
+	/// such cycle. See comm::Timing::getQuiescentUntil().
+	long long getQuiescentUntil();
+
+
+
+
+	//
+	// Sampled simulation (Thread.cc)
+	//
+
+	/// Update the instruction and data caches and the branch predictor
+	/// of the thread with the x86 instruction just emulated functionally
+	/// by \a context, consuming the micro-instructions it produced. The
+	/// context must be mapped to this thread.
+	void WarmUp(Context *context);
+
+
+
+
 	//
 	// Statistics
 	//
@@ -681,6 +798,13 @@ public:
 	/// Return the number of mispredicted branches
 	long long getNumMispredictedBranches() const { return num_mispredicted_branches; }
 
+	/// Return the number of memory dependence violations
+	long long getNumMemoryViolations() const { return num_memory_violations; }
+
+	/// Return the number of micro-instructions replayed after memory
+	/// dependence violations
+	long long getNumReplayedUinsts() const { return num_replayed_uinsts; }
+
 	/// Return the number of reads in the reorder buffers
 	long long getNumReorderBufferReads() const { return num_reorder_buffer_reads; }
 
@@ -38,10 +38,11 @@ bool Thread::canCommit()
 	long long cycle = cpu->getCycle();
 
 	// Sanity check - If the context is running, we assume that something is
-	// going wrong if more than 1M cycles go by without committing a uop.
+	// going wrong if more than Timing::MaxStallCycles cycles go by without
+	// committing a uop.
 	if (!context || !context->getState(Context::StateRunning))
 		last_commit_cycle = cycle;
-	if (cycle - last_commit_cycle > 1000000)
+	if (cycle - last_commit_cycle > Timing::MaxStallCycles)
 	{
 		// Show warning
 		misc::Warning("[x86] %s: simulation ended due to a commit "
@@ -122,6 +123,12 @@ void Thread::Commit(int quantum)
 		if (TraceCache::isPresent())
 			trace_cache->RecordUop(uop.get());
 
+		// Profile, charging the cycles since the last commit
+		Profiler *profiler = cpu->getProfiler();
+		if (profiler)
+			profiler->Commit(uop.get(),
+					cpu->getCycle() - last_commit_cycle);
+
 		// Save last commit cycle
 		last_commit_cycle = cpu->getCycle();
 
@@ -157,12 +164,10 @@ void Thread::Commit(int quantum)
 		if (Timing::trace)
 		{
 			// Output
-			Timing::trace << misc::fmt("x86.inst "
-					"id=%lld "
-					"core=%d "
-					"stg=\"co\"\n",
-					uop->getIdInCore(),
-					core->getId());
+			Timing::trace.Line("x86.inst")
+					.Number("id", uop->getIdInCore())
+					.Number("core", core->getId())
+					.String("stg", "co");
 
 			// Keep uop for later
 			cpu->InsertInTraceList(uop);
@@ -83,12 +83,10 @@ void Thread::Decode()
 				InsertInUopQueue(uop);
 
 				// Trace
-				Timing::trace << misc::fmt("x86.inst "
-						"id=%lld "
-						"core=%d "
-						"stg=\"dec\"\n",
-						uop->getIdInCore(),
-						core->getId());
+				Timing::trace.Line("x86.inst")
+						.Number("id", uop->getIdInCore())
+						.Number("core", core->getId())
+						.String("stg", "dec");
 
 				// Done if no more instructions in fetch queue
 				if (fetch_queue.empty())
@@ -124,12 +124,10 @@ int Thread::Dispatch(int quantum)
 		quantum--;
 
 		// Trace
-		Timing::trace << misc::fmt("x86.inst "
-				"id=%lld "
-				"core=%d "
-				"stg=\"di\"\n",
-				uop->getIdInCore(),
-				core->getId());
+		Timing::trace.Line("x86.inst")
+				.Number("id", uop->getIdInCore())
+				.Number("core", core->getId())
+				.String("stg", "di");
 	}
 
 	// Return remaining unused quantum
@@ -18,9 +18,11 @@
  */
 
 #include "Cpu.h"
+#include "Profiler.h"
 #include "Timing.h"
 #include "Thread.h"
 #include "TraceCache.h"
+#include "UopPool.h"
 
 
 namespace x86
@@ -81,6 +83,10 @@ Uop *Thread::FetchInstruction(bool fetch_from_trace_cache)
 	// Record new speculative mode
 	bool speculative_mode = context->getState(Context::StateSpecMode);
 
+	// Call stack of the instruction, before emulating it
+	Profiler *profiler = cpu->getProfiler();
+	int profile_node = profiler ? profiler->getNode(context) : 0;
+
 	// Run emulation
 	context->Execute();
 
@@ -102,12 +108,12 @@ Uop *Thread::FetchInstruction(bool fetch_from_trace_cache)
 	while (context->getNumUinsts())
 	{
 		// Get micro-instruction from head of list
-		std::shared_ptr<Uinst> uinst = context->ExtractUinst();
+		const Uinst *uinst = context->ExtractUinst();
 
 		// Create uop
-		auto uop = misc::new_shared<Uop>(this,
+		std::shared_ptr<Uop> uop = UopPool::getInstance()->newUop(this,
 				context,
-				uinst);
+				*uinst);
 
 		// Populate macro-instruction information
 		uop->mop_count = num_uinsts;
@@ -121,6 +127,7 @@ Uop *Thread::FetchInstruction(bool fetch_from_trace_cache)
 		uop->speculative_mode = speculative_mode;
 		uop->fetch_address = fetch_address;
 		uop->fetch_access = fetch_access;
+		uop->profile_node = profile_node;
 		uop->neip = context->getRegs().getEip();
 		uop->predicted_neip = fetch_neip;
 		uop->target_neip = context->getTargetEip();
@@ -144,34 +151,33 @@ Uop *Thread::FetchInstruction(bool fetch_from_trace_cache)
 		if (Timing::trace)
 		{
 			// New instruction
-			Timing::trace << misc::fmt("x86.new_inst "
-					"id=%lld "
-					"core=%d",
-					uop->getIdInCore(),
-					core->getId());
+			esim::TraceLine line = Timing::trace.Line("x86.new_inst");
+			line.Number("id", uop->getIdInCore())
+					.Number("core", core->getId());
 
 			// Speculative mode
 			if (uop->speculative_mode)
-				Timing::trace << " spec=\"t\"";
+				line.String("spec", "t");
 
 			// First instruction in speculative mode
 			if (uop->first_speculative_mode)
-				Timing::trace << " first_spec=\"t\"";
+				line.String("first_spec", "t");
 
 			// Macro-instruction disassembly
 			if (!uinst_index)
-				Timing::trace << " asm=\""
-						<< *context->getInstruction()
-						<< "\"";
+			{
+				fetch_trace_stream.str("");
+				fetch_trace_stream << *context->getInstruction();
+				line.String("asm", fetch_trace_stream.str());
+			}
 
 			// Micro-instruction disassembly
-			Timing::trace << " uasm=\""
-					<< *uinst
-					<< "\"";
+			fetch_trace_stream.str("");
+			fetch_trace_stream << *uinst;
+			line.String("uasm", fetch_trace_stream.str());
 
 			// Stage
-			Timing::trace << " stg=\"fe\""
-					<< '\n';
+			line.String("stg", "fe");
 		}
 
 		// Select as returned uop
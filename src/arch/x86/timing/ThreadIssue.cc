@@ -29,19 +29,17 @@ namespace x86
 
 int Thread::IssueLoadQueue(int quantum)
 {
-	// List iterators
-	auto it = load_queue.begin();
-	auto e = load_queue.end();
-
-	// Traverse list
-	while (it != e && quantum > 0)
+	// Traverse ready uops in queue order
+	for (int slot = getNextReadySlot(ready_load_queue, -1);
+			slot >= 0 && quantum > 0;
+			slot = getNextReadySlot(ready_load_queue, slot))
 	{
-		// Get the uop and forward iterator
-		std::shared_ptr<Uop> uop = *it;
-		++it;
+		// Get the uop
+		std::shared_ptr<Uop> uop = reorder_buffer.getEntry(slot);
+		assert(register_file->isUopReady(uop.get()));
 
-		// If the uop is not ready, skip it
-		if (!register_file->isUopReady(uop.get()))
+		// Check that older stores let the load issue
+		if (!canIssueLoad(uop.get()))
 			continue;
 
 		// Check that memory system is accessible
@@ -89,12 +87,10 @@ int Thread::IssueLoadQueue(int quantum)
 		quantum--;
 
 		// Trace
-		Timing::trace << misc::fmt("x86.inst "
-				"id=%lld "
-				"core=%d "
-				"stg=\"i\"\n",
-				uop->getIdInCore(),
-				core->getId());
+		Timing::trace.Line("x86.inst")
+				.Number("id", uop->getIdInCore())
+				.Number("core", core->getId())
+				.String("stg", "i");
 	}
 
 	// Return remaining quantum
@@ -104,16 +100,11 @@ int Thread::IssueLoadQueue(int quantum)
 
 int Thread::IssueStoreQueue(int quantum)
 {
-	// List iterators
-	auto it = store_queue.begin();
-	auto e = store_queue.end();
-
-	// Traverse list
-	while (it != e && quantum > 0)
+	// Traverse queue from the head, where stores are extracted from
+	while (store_queue.size() && quantum > 0)
 	{
-		// Get the uop and forward iterator
-		std::shared_ptr<Uop> uop = *it;
-		++it;
+		// Get the uop
+		std::shared_ptr<Uop> uop = store_queue.front();
 
 		// Sanity
 		assert(uop->getOpcode() == Uinst::OpcodeStore);
@@ -185,23 +176,17 @@ int Thread::IssueLoadStoreQueue(int quantum)
 
 int Thread::IssueInstructionQueue(int quantum)
 {
-	// List iterators
-	auto it = instruction_queue.begin();
-	auto e = instruction_queue.end();
-
-	// Traverse list
-	while (it != e && quantum > 0)
+	// Traverse ready uops in queue order
+	for (int slot = getNextReadySlot(ready_instruction_queue, -1);
+			slot >= 0 && quantum > 0;
+			slot = getNextReadySlot(ready_instruction_queue, slot))
 	{
-		// Get the uop and forward iterator
-		std::shared_ptr<Uop> uop = *it;
-		++it;
+		// Get the uop
+		std::shared_ptr<Uop> uop = reorder_buffer.getEntry(slot);
 
 		// Sanity
 		assert(!(uop->getFlags() & Uinst::FlagMem));
-
-		// If the uop is not ready, skip it
-		if (!register_file->isUopReady(uop.get()))
-			continue;
+		assert(register_file->isUopReady(uop.get()));
 
 		// Run the instruction in its corresponding functional unit in
 		// the ALU. If the instruction does not require a functional
@@ -252,12 +237,10 @@ int Thread::IssueInstructionQueue(int quantum)
 		quantum--;
 		
 		// Trace
-		Timing::trace << misc::fmt("x86.inst "
-				"id=%lld "
-				"core=%d "
-				"stg=\"i\"\n",
-				uop->getIdInCore(),
-				core->getId());
+		Timing::trace.Line("x86.inst")
+				.Number("id", uop->getIdInCore())
+				.Number("core", core->getId())
+				.String("stg", "i");
 	}
 	
 	// Return remaining unused quantum
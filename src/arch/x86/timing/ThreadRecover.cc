@@ -44,12 +44,10 @@ void Thread::RecoverFetchQueue()
 		if (Timing::trace)
 		{
 			// Output
-			Timing::trace << misc::fmt("x86.inst "
-					"id=%lld "
-					"core=%d "
-					"stg=\"sq\"\n",
-					uop->getIdInCore(),
-					core->getId());
+			Timing::trace.Line("x86.inst")
+					.Number("id", uop->getIdInCore())
+					.Number("core", core->getId())
+					.String("stg", "sq");
 
 			// Keep uop for later
 			cpu->InsertInTraceList(uop);
@@ -82,12 +80,10 @@ void Thread::RecoverUopQueue()
 		if (Timing::trace)
 		{
 			// Output
-			Timing::trace << misc::fmt("x86.inst "
-					"id=%lld "
-					"core=%d "
-					"stg=\"sq\"\n",
-					uop->getIdInCore(),
-					core->getId());
+			Timing::trace.Line("x86.inst")
+					.Number("id", uop->getIdInCore())
+					.Number("core", core->getId())
+					.String("stg", "sq");
 
 			// Keep uop for later
 			cpu->InsertInTraceList(uop);
@@ -98,17 +94,17 @@ void Thread::RecoverUopQueue()
 
 void Thread::RecoverInstructionQueue()
 {
-	// Traverse instruction queue
-	auto it = instruction_queue.begin();
-	auto e = instruction_queue.end();
-	while (it != e)
+	// Speculative uops are the youngest in the reorder buffer, so they
+	// are found from its tail
+	for (int index = reorder_buffer.size() - 1; index >= 0; index--)
 	{
-		// Get instruction
-		Uop *uop = it->get();
-		++it;
+		// Stop if this uop is not in speculative mode
+		Uop *uop = reorder_buffer[index].get();
+		if (!uop->speculative_mode)
+			break;
 
-		// Remove if it is a speculative uop
-		if (uop->speculative_mode)
+		// Remove from instruction queue
+		if (uop->in_instruction_queue)
 			ExtractFromInstructionQueue(uop);
 	}
 }
@@ -116,17 +112,17 @@ void Thread::RecoverInstructionQueue()
 
 void Thread::RecoverLoadQueue()
 {
-	// Traverse load queue
-	auto it = load_queue.begin();
-	auto e = load_queue.end();
-	while (it != e)
+	// Speculative uops are the youngest in the reorder buffer, so they
+	// are found from its tail
+	for (int index = reorder_buffer.size() - 1; index >= 0; index--)
 	{
-		// Get instruction
-		Uop *uop = it->get();
-		++it;
+		// Stop if this uop is not in speculative mode
+		Uop *uop = reorder_buffer[index].get();
+		if (!uop->speculative_mode)
+			break;
 
-		// Remove if it is a speculative uop
-		if (uop->speculative_mode)
+		// Remove from load queue
+		if (uop->in_load_queue)
 			ExtractFromLoadQueue(uop);
 	}
 }
@@ -134,37 +130,35 @@ void Thread::RecoverLoadQueue()
 
 void Thread::RecoverStoreQueue()
 {
-	// Traverse store queue
-	auto it = store_queue.begin();
-	auto e = store_queue.end();
-	while (it != e)
+	// Keep squashing stores from the tail
+	while (store_queue.size())
 	{
-		// Get instruction
-		Uop *uop = it->get();
-		++it;
+		// Stop if this uop is not in speculative mode
+		Uop *uop = store_queue.back().get();
+		if (!uop->speculative_mode)
+			break;
 
-		// Remove if it is a speculative uop
-		if (uop->speculative_mode)
-			ExtractFromStoreQueue(uop);
+		// Remove from store queue
+		ExtractFromStoreQueue(uop);
 	}
 }
 
 
 void Thread::RecoverEventQueue()
 {
-	// Traverse event queue
-	auto it = core->getEventQueueBegin();
-	auto e = core->getEventQueueEnd();
-	while (it != e)
+	// Find speculative uops in the current thread
+	std::vector<std::shared_ptr<Uop>> uops;
+	for (auto it = core->getEventQueueBegin(), e = core->getEventQueueEnd();
+			it != e; ++it)
 	{
-		// Get instruction
-		Uop *uop = it->get();
-		++it;
-
-		// Remove if it is a speculative uop in the current thread
+		const std::shared_ptr<Uop> &uop = *it;
 		if (uop->getThread() == this && uop->speculative_mode)
-			core->ExtractFromEventQueue(uop);
+			uops.push_back(uop);
 	}
+
+	// Remove them
+	for (auto &uop : uops)
+		core->ExtractFromEventQueue(uop.get());
 }
 
 
@@ -209,12 +203,10 @@ void Thread::Recover()
 		if (Timing::trace)
 		{
 			// Output
-			Timing::trace << misc::fmt("x86.inst "
-					"id=%lld "
-					"core=%d "
-					"stg=\"sq\"\n",
-					uop->getIdInCore(),
-					core->getId());
+			Timing::trace.Line("x86.inst")
+					.Number("id", uop->getIdInCore())
+					.Number("core", core->getId())
+					.String("stg", "sq");
 
 			// Save uop for later
 			cpu->InsertInTraceList(uop);
@@ -236,5 +228,85 @@ void Thread::Recover()
 	}
 }
 
+
+void Thread::RecoverMemoryViolation()
+{
+	// No violation found
+	if (!violating_load)
+		return;
+	std::shared_ptr<Uop> load = std::move(violating_load);
+	violating_load = nullptr;
+
+	// The load may have been squashed by a recovery from mispeculation
+	if (!load->in_reorder_buffer)
+		return;
+
+	// Statistics
+	num_memory_violations++;
+
+	// Remove the load and all uops following it from the reorder buffer
+	// and the queues, from the tail, restoring the state of the physical
+	// register file.
+	std::vector<std::shared_ptr<Uop>> uops;
+	for (;;)
+	{
+		// Get instruction at the reorder buffer tail
+		std::shared_ptr<Uop> uop = reorder_buffer.back();
+		assert(uop->getThread() == this);
+
+		// Remove from queues
+		if (uop->in_instruction_queue)
+			ExtractFromInstructionQueue(uop.get());
+		if (uop->in_load_queue)
+			ExtractFromLoadQueue(uop.get());
+		if (uop->in_store_queue)
+			ExtractFromStoreQueue(uop.get());
+		if (uop->in_event_queue)
+			core->ExtractFromEventQueue(uop.get());
+
+		// Statistics
+		num_replayed_uinsts++;
+
+		// Finish register renaming if uop didn't complete yet, and
+		// undo it
+		if (!uop->completed)
+			register_file->WriteUop(uop.get());
+		register_file->UndoUop(uop.get());
+
+		// Remove reorder buffer entry
+		ExtractFromReorderBuffer(uop.get());
+		uops.push_back(uop);
+		if (uop == load)
+			break;
+	}
+
+	// Insert the uops back at the head of the uop queue, from the
+	// youngest, to be dispatched again. Memory accesses still in flight
+	// are ignored when they finish (see Cpu::MemoryAccessHandler()).
+	for (auto &uop : uops)
+	{
+		// Reset state
+		uop->dispatched = false;
+		uop->dispatch_when = 0;
+		uop->ready = false;
+		uop->num_pending_inputs = 0;
+		uop->ready_when = 0;
+		uop->issued = false;
+		uop->issue_when = 0;
+		uop->completed = false;
+		uop->complete_when = 0;
+		uop->first_alu_cycle = 0;
+		uop->memory_miss = false;
+		uop->store_set = -1;
+		uop->store_dependence = nullptr;
+		uop->num_replays++;
+
+		// Insert in uop queue
+		assert(!uop->in_uop_queue);
+		uop->in_uop_queue = true;
+		uop_queue.push_front(uop);
+	}
+}
+
 }
 
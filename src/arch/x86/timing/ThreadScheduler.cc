@@ -142,9 +142,8 @@ void Thread::UnmapContext(Context *context)
 	if (context->getState(Context::StateFinished))
 	{
 		// Trace
-		Timing::trace << misc::fmt("x86.end_ctx "
-				"ctx=%d\n",
-				context->getId());
+		Timing::trace.Line("x86.end_ctx")
+				.Number("ctx", context->getId());
 
 		// Free context
 		Emulator *emulator = Emulator::getInstance();
@@ -204,13 +203,10 @@ void Thread::EvictContext()
 			getIdInCore());
 
 	// Trace
-	Timing::trace << misc::fmt("x86.unmap_ctx "
-			"ctx=%d "
-			"core=%d "
-			"thread=%d\n",
-			context->getId(),
-			core->getId(),
-			id_in_core);
+	Timing::trace.Line("x86.unmap_ctx")
+			.Number("ctx", context->getId())
+			.Number("core", core->getId())
+			.Number("thread", id_in_core);
 	
 	// Update thread state
 	context = nullptr;
@@ -22,6 +22,7 @@
 
 #include "Alu.h"
 #include "Timing.h"
+#include "UopPool.h"
 
 
 namespace x86
@@ -47,6 +48,8 @@ comm::Arch::SimKind Timing::sim_kind = comm::Arch::SimFunctional;
 // Report file name
 std::string Timing::report_file;
 
+std::string Timing::profile_file;
+
 // Message to display with '--x86-help'
 const std::string Timing::help_message =
 		"The x86 Cpu configuration file is a plain text INI file, defining\n"
@@ -144,6 +147,20 @@ const std::string Timing::help_message =
 		"      Load-store queue sharing among threads.\n"
 		"  LsqSize = <num_uops> (Default = 20)\n"
 		"      Load-store queue size in number of uops (if private, per-thread LSQ size).\n"
+		"  MemDepKind = {None|Conservative|StoreSet} (Default = None)\n"
+		"      Issue policy for loads following stores whose address is not resolved\n"
+		"      yet. With 'None', loads ignore older stores. With 'Conservative',\n"
+		"      loads wait for the addresses of all older stores. With 'StoreSet',\n"
+		"      loads wait only for the stores predicted to write the same address\n"
+		"      by a store set predictor. A load that issued before an older store\n"
+		"      to the same address is replayed with all uops following it.\n"
+		"  SsitSize = <entries> (Default = 1024)\n"
+		"      Number of entries of the store set identifier table (SSIT).\n"
+		"  LfstSize = <entries> (Default = 128)\n"
+		"      Number of entries of the last fetched store table (LFST), that is,\n"
+		"      maximum number of store sets.\n"
+		"  SsitClearInterval = <cycles> (Default = 1000000)\n"
+		"      Number of cycles between invalidations of the SSIT, or 0 for none.\n"
 		"  RfKind = {Private|Shared} (Default = Private)\n"
 		"      Register file sharing among threads.\n"
 		"  RfIntSize = <entries> (Default = 80)\n"
@@ -170,6 +187,20 @@ const std::string Timing::help_message =
 		"  QueueSize = <num_uops> (Default = 32)\n"
 		"      Size of the trace queue size in uops.\n"
 		"\n"
+		"Section '[ Sampling ]':\n"
+		"\n"
+		"  FunctionalInterval = <num_inst> (Default = 0)\n"
+		"      Number of instructions emulated functionally between two detailed\n"
+		"      intervals. A value of 0 disables sampled simulation.\n"
+		"  WarmUpInterval = <num_inst> (Default = 0)\n"
+		"      Number of instructions emulated functionally after each functional\n"
+		"      interval, updating caches and branch predictors.\n"
+		"  DetailedWarmUpInterval = <num_inst> (Default = 2000)\n"
+		"      Number of instructions committed at the beginning of each detailed\n"
+		"      interval before its performance is measured.\n"
+		"  DetailedInterval = <num_inst> (Default = 10000)\n"
+		"      Number of committed instructions measured in each detailed interval.\n"
+		"\n"
 		"Section '[ FunctionalUnits ]':\n"
 		"\n"
 		"  The possible variables in this section follow the format\n"
@@ -213,7 +244,8 @@ const std::string Timing::help_message =
 		"\n"
 		"Section '[ BranchPredictor ]':\n"
 		"\n"
-		"  Kind = {Perfect|Taken|NotTaken|Bimodal|TwoLevel|Combined} (Default = TwoLevel)\n"
+		"  Kind = {Perfect|Taken|NotTaken|Bimodal|TwoLevel|Combined|Tage|Perceptron}\n"
+		"      (Default = TwoLevel)\n"
 		"      Branch predictor type.\n"
 		"  BTB.Sets = <num_sets> (Default = 256)\n"
 		"      Number of sets in the BTB.\n"
@@ -231,6 +263,44 @@ const std::string Timing::help_message =
 		"      For the two-level adaptive predictor, level 2 size.\n"
 		"  TwoLevel.HistorySize = <size> (Default = 8)\n"
 		"      For the two-level adaptive predictor, level 2 history size.\n"
+		"  Tage.NumTables = <num> (Default = 7)\n"
+		"      For the TAGE predictor, number of tagged tables, up to 12.\n"
+		"  Tage.BaseSize = <entries> (Default = 4096)\n"
+		"      For the TAGE predictor, entries of the bimodal base table.\n"
+		"  Tage.TableSize = <entries> (Default = 1024)\n"
+		"      For the TAGE predictor, entries of each tagged table.\n"
+		"  Tage.TagBits = <bits> (Default = 10)\n"
+		"      For the TAGE predictor, bits of the partial tags.\n"
+		"  Tage.MinHistory = <length> (Default = 4)\n"
+		"  Tage.MaxHistory = <length> (Default = 128)\n"
+		"      For the TAGE predictor, global history lengths of the first and\n"
+		"      last tagged tables. Intermediate tables use a geometric series.\n"
+		"  Tage.LoopSize = <entries> (Default = 64)\n"
+		"      For the TAGE predictor, entries of the loop predictor, or 0 to\n"
+		"      disable it.\n"
+		"  Tage.StatisticalCorrector = {True|False} (Default = True)\n"
+		"      For the TAGE predictor, use a statistical corrector to revert\n"
+		"      low-confidence predictions.\n"
+		"  Perceptron.NumTables = <num> (Default = 8)\n"
+		"      For the hashed perceptron predictor, number of weight tables,\n"
+		"      between 2 and 16.\n"
+		"  Perceptron.TableSize = <entries> (Default = 1024)\n"
+		"      For the hashed perceptron predictor, weights in each table.\n"
+		"  Perceptron.HistorySize = <length> (Default = 64)\n"
+		"      For the hashed perceptron predictor, global history length of\n"
+		"      the last table.\n"
+		"  Indirect = {Btb|Ittage} (Default = Btb)\n"
+		"      Target predictor for indirect jumps and calls. With 'Ittage',\n"
+		"      the target of an indirect branch found in the BTB is taken from\n"
+		"      an ITTAGE predictor.\n"
+		"  Ittage.NumTables = <num> (Default = 5)\n"
+		"  Ittage.BaseSize = <entries> (Default = 256)\n"
+		"  Ittage.TableSize = <entries> (Default = 256)\n"
+		"  Ittage.TagBits = <bits> (Default = 10)\n"
+		"  Ittage.MinHistory = <length> (Default = 4)\n"
+		"  Ittage.MaxHistory = <length> (Default = 64)\n"
+		"      Geometry of the ITTAGE predictor, as for the TAGE predictor.\n"
+		"      Up to 8 tagged tables are allowed.\n"
 		"\n";
 
 const char *Timing::error_fast_forward =
@@ -252,6 +322,17 @@ Timing::Timing() : comm::Timing("x86")
 	// Create CPU
 	cpu = misc::new_unique<Cpu>(this);
 
+	// Create sampler
+	if (Sampler::isEnabled())
+		sampler = misc::new_unique<Sampler>(cpu.get());
+
+	// Create profiler
+	if (!profile_file.empty())
+	{
+		profiler = misc::new_unique<Profiler>(profile_file);
+		cpu->setProfiler(profiler.get());
+	}
+
 	// Create the trace header related to CPU
 	trace.Header(misc::fmt("x86.init version=\"%d.%d\" "
 			"num_cores=%d num_threads=%d\n",
@@ -286,10 +367,23 @@ bool Timing::Run()
 			< Cpu::getNumFastForwardInstructions())
 		FastForward();
 
-	// Stop if maximum number of CPU instructions exceeded
+	// Sampled simulation. Functional intervals run entirely within this
+	// call, and contexts can finish during them.
 	esim::Engine *esim_engine = esim::Engine::getInstance();
+	long long num_functional_instructions = 0;
+	if (sampler)
+	{
+		sampler->Run();
+		num_functional_instructions =
+				sampler->getNumFunctionalInstructions();
+		if (emulator->getNumContexts() == 0)
+			return false;
+	}
+
+	// Stop if maximum number of CPU instructions exceeded
 	if (Emulator::getMaxInstructions()
 			&& cpu->getNumCommittedInstructions()
+			+ num_functional_instructions
 			>= Emulator::getMaxInstructions()
 			- Cpu::getNumFastForwardInstructions())
 		esim_engine->Finish("X86MaxInstructions");
@@ -317,6 +411,32 @@ bool Timing::Run()
 }
 
 
+long long Timing::getQuiescentUntil()
+{
+	// Instructions to fast-forward are emulated in the next iteration
+	Emulator *emulator = Emulator::getInstance();
+	if (Cpu::getNumFastForwardInstructions()
+			&& emulator->getNumInstructions()
+			< Cpu::getNumFastForwardInstructions())
+		return 0;
+
+	// The sampler switches phases when the pipelines are drained
+	if (sampler && sampler->getPhase() != Sampler::PhaseDetailed)
+		return 0;
+
+	// Check pipelines
+	return cpu->getQuiescentUntil();
+}
+
+
+void Timing::SkipCycles(long long num_cycles)
+{
+	// Update statistics
+	comm::Timing::SkipCycles(num_cycles);
+	cpu->SkipCycles(num_cycles);
+}
+
+
 void Timing::FastForward()
 {
 	// Fast-forward simulation
@@ -589,6 +709,15 @@ void Timing::RegisterOptions()
 			"accesses performed on pipeline queues, etc. This option is only valid for "
 			"detailed x86 simulation (option '--x86-sim detailed').");
 
+	// Option --x86-profile <file>
+	command_line->RegisterString("--x86-profile <file>", profile_file,
+			"File to dump a profile of the guest programs, attributing committed "
+			"instructions, cycles, data cache misses, and branch mispredictions to "
+			"guest functions and instructions. Call stacks and their cycles are "
+			"dumped in the same file with suffix '.folded', in the format taken by "
+			"flame graph tools. This option is only valid for detailed x86 "
+			"simulation (option '--x86-sim detailed').");
+
 	// Option --x86-help
 	command_line->RegisterBool("--x86-help", help,
 			"Display a help message describing the format of the x86 Cpu context "
@@ -639,6 +768,15 @@ void Timing::ProcessOptions()
 					report_file.c_str()));
 	}
 
+	// Check valid file in '--x86-profile'
+	if (!profile_file.empty())
+	{
+		std::ofstream os(profile_file);
+		if (!os.good())
+			throw Error(misc::fmt("%s: Cannot open profile file",
+					profile_file.c_str()));
+	}
+
 	// Print x86 configuration INI format
 	if (help)
 	{
@@ -677,6 +815,9 @@ void Timing::ParseConfiguration(misc::IniFile *ini_file)
 	// Parse ALU configuration by their sections
 	Alu::ParseConfiguration(ini_file);
 
+	// Parse sampling configuration
+	Sampler::ParseConfiguration(ini_file);
+
 	// Check the configuration for forbidden variables
 	ini_file->Check();
 }
@@ -730,6 +871,10 @@ void Timing::DumpSummary(std::ostream &os) const
 			/ cpu->getNumBranches()
 			: 0.0;
 	os << misc::fmt("BranchPredictionAccuracy = %.4g\n", branch_accuracy);
+
+	// Sampled simulation
+	if (sampler)
+		sampler->DumpSummary(os);
 }
 
 
@@ -789,6 +934,10 @@ void Timing::DumpUopReport(std::ostream &os, const long long *uop_stats,
 
 void Timing::DumpReport() const
 {
+	// Guest profile
+	if (profiler)
+		profiler->Dump();
+
 	// Ignore if no report file was specified
 	if (report_file.empty())
 		return;
@@ -815,10 +964,28 @@ void Timing::DumpReport() const
 	os << "; Global statistics\n";
 	os << "[ Global ]\n";
 	os << misc::fmt("Cycles = %lld\n", getCycle());
+	os << misc::fmt("SkippedCycles = %lld\n", getNumSkippedCycles());
 	os << misc::fmt("Time = %.2f\n", (double) now / 1e6);
 	os << misc::fmt("CyclesPerSecond = %.0f\n", now ?
 			(double) getCycle() / now * 1e6 : 0.0);
 	os << '\n';
+
+	// Uop allocation
+	UopPool *uop_pool = UopPool::getInstance();
+	os << "; Uop allocation\n";
+	os << ";    Uops - Number of uops allocated\n";
+	os << ";    HeapAllocations - Number of chunks of uops allocated from the heap\n";
+	os << ";    MaxInUse - Maximum number of uops allocated at any time\n";
+	os << "[ Allocation ]\n";
+	os << misc::fmt("Uops = %lld\n", uop_pool->getNumAllocations());
+	os << misc::fmt("HeapAllocations = %lld\n",
+			uop_pool->getNumHeapAllocations());
+	os << misc::fmt("MaxInUse = %lld\n", uop_pool->getMaxInUse());
+	os << '\n';
+
+	// Sampled simulation
+	if (sampler)
+		sampler->DumpReport(os);
 	
 	// Dispatch stage
 	os << "; Dispatch stage\n";
@@ -996,6 +1163,14 @@ void Timing::DumpReport() const
 					/ thread->getNumBranches() : 0.0);
 			os << '\n';
 
+			// Memory dependences
+			os << "; Memory dependences\n";
+			os << ";    Violations - Loads issued before an older store to the same address\n";
+			os << ";    Replayed - Uops dispatched again after a violation\n";
+			os << misc::fmt("MemDep.Violations = %lld\n", thread->getNumMemoryViolations());
+			os << misc::fmt("MemDep.Replayed = %lld\n", thread->getNumReplayedUinsts());
+			os << '\n';
+
 			// Occupancy statistics
 			os << "; Structure statistics (reorder buffer, instruction queue,\n";
 			os << "; load-store queue, integer/floating-point/XMM register file,\n";
@@ -1107,6 +1282,10 @@ void Timing::DumpConfiguration(std::ofstream &os) const
 	os << misc::fmt("IqSize = %d\n", cpu->getInstructionQueueSize());
 	os << misc::fmt("LsqKind = %s\n", cpu->load_store_queue_kind_map[cpu->getLoadStoreQueueKind()]);
 	os << misc::fmt("LsqSize = %d\n", cpu->getLoadStoreQueueSize());
+	os << misc::fmt("MemDepKind = %s\n", cpu->memory_dependence_kind_map[cpu->getMemoryDependenceKind()]);
+	os << misc::fmt("SsitSize = %d\n", cpu->getSsitSize());
+	os << misc::fmt("LfstSize = %d\n", cpu->getLfstSize());
+	os << misc::fmt("SsitClearInterval = %d\n", cpu->getSsitClearInterval());
 	os << misc::fmt("RfKind = %s\n", RegisterFile::KindMap[RegisterFile::getKind()]);
 	os << misc::fmt("RfIntSize = %d\n", RegisterFile::getIntegerSize());
 	os << misc::fmt("RfFpSize = %d\n", RegisterFile::getFloatingPointSize());
@@ -1138,6 +1317,24 @@ void Timing::DumpConfiguration(std::ofstream &os) const
 	os << misc::fmt("TwoLevel.L2Size = %d\n", BranchPredictor::getTwoLevelL2Size());
 	os << misc::fmt("TwoLevel.L2Height = %d\n", BranchPredictor::getTwoLevelL2Height());
 	os << misc::fmt("TwoLevel.HistorySize = %d\n", BranchPredictor::getTwoLevelHistorySize());
+	os << misc::fmt("Tage.NumTables = %d\n", BranchPredictor::getTageNumTables());
+	os << misc::fmt("Tage.BaseSize = %d\n", BranchPredictor::getTageBaseSize());
+	os << misc::fmt("Tage.TableSize = %d\n", BranchPredictor::getTageTableSize());
+	os << misc::fmt("Tage.TagBits = %d\n", BranchPredictor::getTageTagBits());
+	os << misc::fmt("Tage.MinHistory = %d\n", BranchPredictor::getTageMinHistory());
+	os << misc::fmt("Tage.MaxHistory = %d\n", BranchPredictor::getTageMaxHistory());
+	os << misc::fmt("Tage.LoopSize = %d\n", BranchPredictor::getTageLoopSize());
+	os << misc::fmt("Tage.StatisticalCorrector = %s\n", BranchPredictor::getTageStatisticalCorrector() ? "True" : "False");
+	os << misc::fmt("Perceptron.NumTables = %d\n", BranchPredictor::getPerceptronNumTables());
+	os << misc::fmt("Perceptron.TableSize = %d\n", BranchPredictor::getPerceptronTableSize());
+	os << misc::fmt("Perceptron.HistorySize = %d\n", BranchPredictor::getPerceptronHistorySize());
+	os << misc::fmt("Indirect = %s\n", BranchPredictor::IndirectKindMap[BranchPredictor::getIndirectKind()]);
+	os << misc::fmt("Ittage.NumTables = %d\n", BranchPredictor::getIttageNumTables());
+	os << misc::fmt("Ittage.BaseSize = %d\n", BranchPredictor::getIttageBaseSize());
+	os << misc::fmt("Ittage.TableSize = %d\n", BranchPredictor::getIttageTableSize());
+	os << misc::fmt("Ittage.TagBits = %d\n", BranchPredictor::getIttageTagBits());
+	os << misc::fmt("Ittage.MinHistory = %d\n", BranchPredictor::getIttageMinHistory());
+	os << misc::fmt("Ittage.MaxHistory = %d\n", BranchPredictor::getIttageMaxHistory());
 	os << misc::fmt("\n");
 
 	// End of configuration
@@ -30,6 +30,8 @@
 
 #include "BranchPredictor.h"
 #include "Cpu.h"
+#include "Profiler.h"
+#include "Sampler.h"
 #include "TraceCache.h"
 
 
@@ -61,6 +63,9 @@ class Timing : public comm::Timing
 	// Report file name
 	static std::string report_file;
 
+	// Guest profile file name
+	static std::string profile_file;
+
 	// If true, show a message describing the format for the x86
 	// configuration file. Passed with option --x86-help.
 	static bool help;
@@ -80,6 +85,12 @@ class Timing : public comm::Timing
 	// CPU object
 	std::unique_ptr<Cpu> cpu;
 
+	// Controller for sampled simulation, or null if sampling is disabled
+	std::unique_ptr<Sampler> sampler;
+
+	// Profiler of the guest programs, or null if profiling is disabled
+	std::unique_ptr<Profiler> profiler;
+
 	// List of entry modules to the memory hierarchy
 	std::vector<mem::Module *> entry_modules;
 
@@ -149,6 +160,13 @@ public:
 	/// execution.
 	bool Run() override;
 
+	/// Return the cycle until which the CPU is quiescent, or 0 if it is
+	/// not quiescent. See comm::Timing::getQuiescentUntil().
+	long long getQuiescentUntil() override;
+
+	/// Account for cycles skipped while the CPU was quiescent
+	void SkipCycles(long long num_cycles) override;
+
 	/// Dump a default memory configuration for the architecture. This
 	/// function is invoked by the memory system configuration parser when
 	/// no specific memory configuration is given by the user for the
@@ -30,7 +30,7 @@ long long Uop::id_counter = 0;
 
 Uop::Uop(Thread *thread,
 		Context *context,
-		std::shared_ptr<Uinst> uinst) :
+		const Uinst &uinst) :
 		thread(thread),
 		context(context),
 		uinst(uinst)
@@ -41,7 +41,7 @@ Uop::Uop(Thread *thread,
 	id_in_core = core->getUopId();
 
 	// Assign flags from associated micro-instruction
-	flags = uinst->getFlags();
+	flags = uinst.getFlags();
 
 	// Populate dependency fields
 	CountDependencies();
@@ -57,7 +57,7 @@ void Uop::CountDependencies()
 	int xmm_count = 0;
 	for (int dep = 0; dep < Uinst::MaxODeps; dep++)
 	{
-		Uinst::Dep loreg = uinst->getODep(dep);
+		Uinst::Dep loreg = uinst.getODep(dep);
 		if (Uinst::isFlagDependency(loreg))
 			flag_count++;
 		else if (Uinst::isIntegerDependency(loreg))
@@ -79,7 +79,7 @@ void Uop::CountDependencies()
 	xmm_count = 0;
 	for (int dep = 0; dep < Uinst::MaxIDeps; dep++)
 	{
-		Uinst::Dep loreg = uinst->getIDep(dep);
+		Uinst::Dep loreg = uinst.getIDep(dep);
 		if (Uinst::isFlagDependency(loreg))
 			flag_count++;
 		else if (Uinst::isIntegerDependency(loreg))
@@ -110,7 +110,7 @@ void Uop::Dump(std::ostream &os) const
 		os << misc::fmt("memory_access = %lld, ", memory_access);
 
 	// Micro-instruction
-	os << "uinst = '" << *uinst << "'";
+	os << "uinst = '" << uinst << "'";
 }
 
 
@@ -74,8 +74,8 @@ class Uop
 	// in the constructor.
 	Context *context;
 
-	// Emulator micro-instruction associated with this uop
-	std::shared_ptr<Uinst> uinst;
+	// Copy of the emulator micro-instruction associated with this uop
+	Uinst uinst;
 
 	// Uop flags, taken from the associated micro-instruction. This field
 	// is assigned in the constructor.
@@ -133,10 +133,11 @@ public:
 	///
 	/// \param uinst
 	///	Emulator micro-instruction that this uop is associated with.
+	///	The uop keeps a copy of it.
 	///
 	Uop(Thread *thread,
 			Context *context,
-			std::shared_ptr<Uinst> uinst);
+			const Uinst &uinst);
 
 	/// Dump uop information
 	void Dump(std::ostream &os = std::cout) const;
@@ -154,11 +155,14 @@ public:
 	/// Get core that the uop belongs to
 	Core *getCore() const { return core; }
 
+	/// Get the emulator context that the uop belongs to
+	Context *getContext() const { return context; }
+
 	/// Return the micro-instruction associated with this uop.
-	Uinst *getUinst() const { return uinst.get(); }
+	const Uinst *getUinst() const { return &uinst; }
 
 	/// Return the opcode of the associated micro-instruction
-	Uinst::Opcode getOpcode() const { return uinst->getOpcode(); }
+	Uinst::Opcode getOpcode() const { return uinst.getOpcode(); }
 
 	/// Return a globally unique identifier for the uop
 	long long getId() const { return id; }
@@ -265,53 +269,32 @@ public:
 	/// True if the instruction is currently in the fetch queue
 	bool in_fetch_queue = false;
 
-	/// Position of the uop in the thread's fetch queue
-	std::list<std::shared_ptr<Uop>>::iterator fetch_queue_iterator;
-
 	/// True if the instruction is currently in the uop queue
 	bool in_uop_queue = false;
 
-	/// Position of the uop in the thread's uop queue
-	std::list<std::shared_ptr<Uop>>::iterator uop_queue_iterator;
-
 	/// True if the instruction is currently in the core's event queue
 	bool in_event_queue = false;
 
-	/// Position of the uop in the core's event queue, or past-the-end
-	/// iterator to this queue if not present.
-	std::list<std::shared_ptr<Uop>>::iterator event_queue_iterator;
-
 	/// True if the instruction is currently present in the thread's
 	/// reorder buffer
 	bool in_reorder_buffer = false;
 
-	/// Position of the uop in the reorder buffer, if present
-	std::list<std::shared_ptr<Uop>>::iterator reorder_buffer_iterator;
+	/// Position of the uop in the reorder buffer, if present. The uops of
+	/// the instruction and load queues are indexed by this position.
+	int reorder_buffer_slot = 0;
 
 	/// True if the instruction is currently present in the thread's
 	/// instruction queue
 	bool in_instruction_queue = false;
 
-	/// Position of the uop in the thread's instruction queue, or past-the-
-	/// end iterator to this queue if not present.
-	std::list<std::shared_ptr<Uop>>::iterator instruction_queue_iterator;
-
 	/// True if the instruction is currently present in the thread's
 	/// load queue
 	bool in_load_queue = false;
 
-	/// Position of the uop in the thread's load queue, or past-the-end
-	/// iterator to this queue if not present.
-	std::list<std::shared_ptr<Uop>>::iterator load_queue_iterator;
-
 	/// True if the instruction is currently present in the thread's
 	/// store queue
 	bool in_store_queue = false;
 
-	/// Position of the uop in the thread's store queue, or past-the-end
-	/// iterator to this queue if not present.
-	std::list<std::shared_ptr<Uop>>::iterator store_queue_iterator;
-
 	/// True if the instruction is currently present in the uop trace list
 	/// of the CPU
 	bool in_trace_list = false;
@@ -370,6 +353,14 @@ public:
 	// For memory uops, unique identifier of memory access
 	long long memory_access = 0;
 
+	/// For memory uops, flag set when the access misses in the first
+	/// level of the data cache
+	bool memory_miss = false;
+
+	/// Node of the call stack of the guest program when the uop was
+	/// fetched, if profiling is active (see class Profiler)
+	int profile_node = 0;
+
 	/// Access identifier for instruction fetch
 	long long fetch_access = 0;
 
@@ -413,10 +404,38 @@ public:
 
 	/// Prediction in the combined branch predictor
 	BranchPredictor::Prediction choice_prediction = BranchPredictor::PredictionNotTaken;
+
+	/// TAGE predictor lookup information
+	TagePredictor::Info tage;
+
+	/// Perceptron predictor lookup information
+	PerceptronPredictor::Info perceptron;
+
+	/// ITTAGE predictor lookup information (for indirect branches)
+	IttagePredictor::Info ittage;
 	
 	
 	
 	
+	//
+	// Memory dependences
+	//
+
+	/// For loads and stores, store set found in the store set identifier
+	/// table at dispatch, or -1 if none
+	int store_set = -1;
+
+	/// For loads, older store predicted to write the same address. The
+	/// load does not issue before the address of the store is resolved.
+	std::shared_ptr<Uop> store_dependence;
+
+	/// Number of times the uop was replayed after a load in front of it
+	/// violated a memory dependence
+	int num_replays = 0;
+
+
+
+
 	//
 	// State
 	//
@@ -430,6 +449,10 @@ public:
 	/// True if uop is ready to be issued
 	bool ready = false;
 
+	/// Number of input physical registers that were still being computed
+	/// when the uop was renamed, and have not been written yet
+	int num_pending_inputs = 0;
+
 	/// Cycle when uop was made ready, or 0 if not ready yet
 	long long ready_when = 0;
 
@@ -0,0 +1,107 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include <lib/cpp/Error.h>
+
+#include "Uop.h"
+#include "UopPool.h"
+
+
+namespace x86
+{
+
+
+UopPool *UopPool::getInstance()
+{
+	// The pool is never destroyed
+	static UopPool *instance = new UopPool();
+	return instance;
+}
+
+
+void UopPool::AllocateChunk()
+{
+	// Allocate chunk
+	chunks.emplace_back(new char[block_size * blocks_per_chunk]);
+	char *chunk = chunks.back().get();
+
+	// Add its blocks to the free list
+	for (int i = blocks_per_chunk - 1; i >= 0; i--)
+	{
+		FreeBlock *block = (FreeBlock *) (chunk + i * block_size);
+		block->next = free_list;
+		free_list = block;
+	}
+}
+
+
+void *UopPool::Allocate(size_t size)
+{
+	// The block size is given by the first allocation, rounded up to the
+	// maximum alignment of the host. All blocks are allocated for the
+	// same type, so later allocations cannot be larger.
+	if (!block_size)
+	{
+		const size_t align = alignof(std::max_align_t);
+		block_size = std::max(size, sizeof(FreeBlock));
+		block_size = (block_size + align - 1) / align * align;
+	}
+	if (size > block_size)
+		throw misc::Panic("Invalid uop allocation size");
+
+	// Take a block from the free list
+	if (!free_list)
+		AllocateChunk();
+	FreeBlock *block = free_list;
+	free_list = block->next;
+
+	// Statistics
+	num_allocations++;
+	num_in_use++;
+	max_in_use = std::max(max_in_use, num_in_use);
+	return block;
+}
+
+
+void UopPool::Free(void *block)
+{
+	// Return block to the free list
+	assert(num_in_use > 0);
+	FreeBlock *free_block = (FreeBlock *) block;
+	free_block->next = free_list;
+	free_list = free_block;
+	num_in_use--;
+}
+
+
+std::shared_ptr<Uop> UopPool::newUop(Thread *thread,
+		Context *context,
+		const Uinst &uinst)
+{
+	return std::allocate_shared<Uop>(Allocator<Uop>(this),
+			thread,
+			context,
+			uinst);
+}
+
+
+}  // namespace x86
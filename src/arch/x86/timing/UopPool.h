@@ -0,0 +1,162 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_UOP_POOL_H
+#define ARCH_X86_TIMING_UOP_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+namespace x86
+{
+
+// Forward declarations
+class Context;
+class Thread;
+class Uinst;
+class Uop;
+
+
+/// Allocator for the uops created by the fetch stage of the pipeline. Each
+/// uop is allocated together with the reference count of its shared pointer
+/// in one fixed-size block. Blocks of released uops are kept in a free list
+/// and recycled by the next allocation, so that the heap is only accessed
+/// while the number of uops in flight grows beyond its previous maximum.
+///
+/// The pool is shared by all threads of the CPU and never destroyed, since
+/// uops can still be released by static objects at the end of the program.
+class UopPool
+{
+	// Block in the free list. The memory of a free block is reused to
+	// store the pointer to the next free block.
+	struct FreeBlock
+	{
+		FreeBlock *next;
+	};
+
+	// Number of blocks allocated from the heap at once
+	static const int blocks_per_chunk = 256;
+
+	// Size of each block in bytes, set on the first allocation
+	size_t block_size = 0;
+
+	// Chunks of blocks allocated from the heap
+	std::vector<std::unique_ptr<char[]>> chunks;
+
+	// Head of the list of free blocks
+	FreeBlock *free_list = nullptr;
+
+	// Number of blocks allocated so far
+	long long num_allocations = 0;
+
+	// Number of blocks currently allocated, and maximum number of blocks
+	// allocated at any time
+	long long num_in_use = 0;
+	long long max_in_use = 0;
+
+	// Allocate a new chunk from the heap and add its blocks to the free
+	// list
+	void AllocateChunk();
+
+	// Return a block of at least \a size bytes
+	void *Allocate(size_t size);
+
+	// Return a block to the free list
+	void Free(void *block);
+
+public:
+
+	/// Allocator of type \a T used by std::allocate_shared() to place
+	/// uops and their reference counts in the blocks of a pool
+	template<typename T> class Allocator
+	{
+		template<typename U> friend class Allocator;
+
+		UopPool *pool;
+
+	public:
+
+		typedef T value_type;
+
+		/// Constructor
+		Allocator(UopPool *pool) : pool(pool)
+		{
+		}
+
+		/// Conversion from an allocator of another type
+		template<typename U> Allocator(const Allocator<U> &other) :
+				pool(other.pool)
+		{
+		}
+
+		/// Allocate \a n objects of type \a T, which must be 1
+		T *allocate(size_t n)
+		{
+			return static_cast<T *>(pool->Allocate(n * sizeof(T)));
+		}
+
+		/// Release objects allocated with allocate()
+		void deallocate(T *p, size_t)
+		{
+			pool->Free(p);
+		}
+
+		/// Allocators are equal if they use the same pool
+		template<typename U> bool operator==(
+				const Allocator<U> &other) const
+		{
+			return pool == other.pool;
+		}
+
+		/// Allocators are different if they use different pools
+		template<typename U> bool operator!=(
+				const Allocator<U> &other) const
+		{
+			return pool != other.pool;
+		}
+	};
+
+	/// Return the pool, created on first use
+	static UopPool *getInstance();
+
+	/// Create a uop in the pool. The arguments are those of the
+	/// constructor of class Uop.
+	std::shared_ptr<Uop> newUop(Thread *thread,
+			Context *context,
+			const Uinst &uinst);
+
+	/// Return the number of uops allocated so far
+	long long getNumAllocations() const { return num_allocations; }
+
+	/// Return the number of chunks of uops allocated from the heap
+	long long getNumHeapAllocations() const { return chunks.size(); }
+
+	/// Return the number of uops currently allocated
+	long long getNumInUse() const { return num_in_use; }
+
+	/// Return the maximum number of uops allocated at any time
+	long long getMaxInUse() const { return max_in_use; }
+};
+
+
+}  // namespace x86
+
+#endif
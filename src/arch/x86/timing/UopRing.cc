@@ -0,0 +1,97 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <lib/cpp/Misc.h>
+
+#include "UopRing.h"
+
+
+namespace x86
+{
+
+
+UopRing::UopRing(int capacity) :
+		capacity(capacity)
+{
+	assert(capacity > 0);
+	entries = misc::new_unique_array<std::shared_ptr<Uop>>(capacity);
+}
+
+
+void UopRing::Grow()
+{
+	// Move uops to the beginning of a new buffer
+	auto new_entries = misc::new_unique_array<std::shared_ptr<Uop>>(
+			capacity * 2);
+	for (int i = 0; i < count; i++)
+		new_entries[i] = std::move(entries[(head + i) % capacity]);
+	entries = std::move(new_entries);
+	capacity *= 2;
+	head = 0;
+}
+
+
+int UopRing::push_back(std::shared_ptr<Uop> uop)
+{
+	// Grow if full
+	if (count == capacity)
+		Grow();
+
+	// Insert at tail
+	int position = (head + count) % capacity;
+	entries[position] = std::move(uop);
+	count++;
+	return position;
+}
+
+
+int UopRing::push_front(std::shared_ptr<Uop> uop)
+{
+	// Grow if full
+	if (count == capacity)
+		Grow();
+
+	// Insert before head
+	head = (head + capacity - 1) % capacity;
+	entries[head] = std::move(uop);
+	count++;
+	return head;
+}
+
+
+void UopRing::pop_front()
+{
+	// Release uop as the last step, since this may free it
+	assert(count > 0);
+	std::shared_ptr<Uop> uop = std::move(entries[head]);
+	head = (head + 1) % capacity;
+	count--;
+}
+
+
+void UopRing::pop_back()
+{
+	// Release uop as the last step, since this may free it
+	assert(count > 0);
+	count--;
+	std::shared_ptr<Uop> uop = std::move(entries[(head + count) % capacity]);
+}
+
+
+}  // namespace x86
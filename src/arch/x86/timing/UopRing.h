@@ -0,0 +1,154 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ARCH_X86_TIMING_UOP_RING_H
+#define ARCH_X86_TIMING_UOP_RING_H
+
+#include <cassert>
+#include <memory>
+
+
+namespace x86
+{
+
+// Forward declarations
+class Uop;
+
+
+/// Age-ordered queue of uops in the pipeline, stored in a circular buffer.
+/// Uops are inserted at the tail, and extracted from the head as they move
+/// forward in the pipeline, or from the tail when they are squashed.
+///
+/// Each uop is stored at a fixed position of the buffer while it stays in
+/// it, which can be used to index other per-uop structures. When the buffer
+/// is full, its capacity is doubled, which moves the uops to new positions.
+/// Queues whose positions are used must be created with enough capacity.
+class UopRing
+{
+	// Circular buffer
+	std::unique_ptr<std::shared_ptr<Uop>[]> entries;
+
+	// Number of entries in the buffer
+	int capacity;
+
+	// Position of the uop at the head
+	int head = 0;
+
+	// Number of uops in the queue
+	int count = 0;
+
+	// Double the capacity of the buffer
+	void Grow();
+
+public:
+
+	/// Iterator over the uops of the queue, from the head to the tail
+	class Iterator
+	{
+		const UopRing *ring;
+		int index;
+
+	public:
+
+		/// Constructor
+		Iterator(const UopRing *ring, int index) :
+				ring(ring),
+				index(index)
+		{
+		}
+
+		/// Return the uop
+		const std::shared_ptr<Uop> &operator*() const
+		{
+			return (*ring)[index];
+		}
+
+		/// Move to the next uop
+		Iterator &operator++()
+		{
+			index++;
+			return *this;
+		}
+
+		/// Compare iterators
+		bool operator!=(const Iterator &other) const
+		{
+			return index != other.index;
+		}
+	};
+
+	/// Constructor of a queue with an initial capacity of \a capacity
+	/// uops
+	explicit UopRing(int capacity = 16);
+
+	/// Return the number of uops in the queue
+	int size() const { return count; }
+
+	/// Return true if the queue is empty
+	bool empty() const { return !count; }
+
+	/// Return the number of uops that fit in the queue before it grows
+	int getCapacity() const { return capacity; }
+
+	/// Return the position of the uop at the head
+	int getHead() const { return head; }
+
+	/// Return the uop stored in position \a position of the buffer
+	const std::shared_ptr<Uop> &getEntry(int position) const
+	{
+		assert(position >= 0 && position < capacity);
+		return entries[position];
+	}
+
+	/// Return the uop at index \a index, counting from the head
+	const std::shared_ptr<Uop> &operator[](int index) const
+	{
+		assert(index >= 0 && index < count);
+		return entries[(head + index) % capacity];
+	}
+
+	/// Return the uop at the head
+	const std::shared_ptr<Uop> &front() const { return (*this)[0]; }
+
+	/// Return the uop at the tail
+	const std::shared_ptr<Uop> &back() const { return (*this)[count - 1]; }
+
+	/// Insert a uop at the tail and return its position in the buffer
+	int push_back(std::shared_ptr<Uop> uop);
+
+	/// Insert a uop at the head and return its position in the buffer
+	int push_front(std::shared_ptr<Uop> uop);
+
+	/// Extract the uop at the head
+	void pop_front();
+
+	/// Extract the uop at the tail
+	void pop_back();
+
+	/// Iterator to the head
+	Iterator begin() const { return Iterator(this, 0); }
+
+	/// Iterator past the tail
+	Iterator end() const { return Iterator(this, count); }
+};
+
+
+}  // namespace x86
+
+#endif
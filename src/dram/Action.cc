@@ -121,7 +121,7 @@ void Actions::ParseActionRequest(const std::vector<std::string> &tokens)
 
 	// Schedule an event to insert it at the specified cycle.
 	esim::Engine *esim = esim::Engine::getInstance();
-	auto request_frame = std::make_shared<ActionRequestFrame>(request);
+	auto request_frame = esim::new_frame<ActionRequestFrame>(request);
 	esim->Call(System::ACTION_REQUEST, request_frame, nullptr, cycle);
 }
 
@@ -172,7 +172,7 @@ void Bank::RunFrontCommand()
 	esim::Engine *esim = esim::Engine::getInstance();
 
 	// Create return event
-	auto frame = std::make_shared<CommandReturnFrame>(command);
+	auto frame = esim::new_frame<CommandReturnFrame>(command);
 	esim->Call(System::event_command_return, frame, nullptr,
 			command->getDuration());
 
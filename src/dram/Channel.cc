@@ -85,7 +85,7 @@ void Channel::CallScheduler(int after)
 	}
 
 	// Create the frame to pass containing a reference to this controller.
-	auto frame = std::make_shared<SchedulerFrame>();
+	auto frame = esim::new_frame<SchedulerFrame>();
 	frame->channel = this;
 
 	// Call the event for the request processor.
@@ -261,7 +261,7 @@ void Controller::CallRequestProcessor()
 	}
 
 	// Create the frame to pass containing a reference to this controller.
-	auto frame = std::make_shared<RequestProcessorFrame>();
+	auto frame = esim::new_frame<RequestProcessorFrame>();
 	frame->controller = this;
 
 	// Call the event for the request processor.
@@ -149,6 +149,28 @@ bool Bitmap::Test(size_t at) const
 }
 
 
+size_t Bitmap::FindNext(size_t at) const
+{
+	// Past the end
+	if (at >= size)
+		return size;
+
+	// Discard bits before 'at' in its block, and skip empty blocks
+	size_t block, bit;
+	getBlockBit(at, block, bit);
+	size_t value = data.get()[block] & (~0ul << bit);
+	while (!value)
+	{
+		if (++block == size_in_blocks)
+			return size;
+		value = data.get()[block];
+	}
+
+	// First bit set in the block
+	return block * bits_per_block + __builtin_ctzl(value);
+}
+
+
 bool Bitmap::Any() const
 {
 	// Check complete blocks
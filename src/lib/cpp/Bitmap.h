@@ -78,6 +78,10 @@ public:
 	bool Any() const;
 	bool None() const { return !Any(); }
 
+	/// Return the position of the first bit set at or after position
+	/// \a at, or the size of the bitmap if there is none.
+	size_t FindNext(size_t at) const;
+
 	Bitmap operator~() const;
 
 	size_t CountZeros() const;
@@ -0,0 +1,144 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+
+#include "Checkpoint.h"
+#include "String.h"
+
+
+namespace misc
+{
+
+// Magic string at the beginning of a checkpoint file
+static const char checkpoint_magic[] = "m2s-checkpoint 1\n";
+
+// Size of the zlib buffers, large enough to stream memory pages efficiently
+static const unsigned checkpoint_buffer_size = 1 << 20;
+
+
+//
+// Class 'CheckpointWriter'
+//
+
+CheckpointWriter::CheckpointWriter(const std::string &path) :
+		path(path)
+{
+	gz_file = gzopen(path.c_str(), "wb1");
+	if (!gz_file)
+		throw Error(fmt("%s: cannot create checkpoint file",
+				path.c_str()));
+	gzbuffer(gz_file, checkpoint_buffer_size);
+	Write(checkpoint_magic, strlen(checkpoint_magic));
+}
+
+
+CheckpointWriter::~CheckpointWriter()
+{
+	gzclose(gz_file);
+}
+
+
+void CheckpointWriter::Write(const void *data, size_t size)
+{
+	// A zero-length write is reported as an error by zlib
+	if (!size)
+		return;
+	if (gzwrite(gz_file, data, size) != (int) size)
+		throw Error(fmt("%s: error writing checkpoint file",
+				path.c_str()));
+}
+
+
+void CheckpointWriter::WriteString(const std::string &s)
+{
+	WriteValue<unsigned>(s.size());
+	Write(s.data(), s.size());
+}
+
+
+
+
+//
+// Class 'CheckpointReader'
+//
+
+CheckpointReader::CheckpointReader(const std::string &path) :
+		path(path)
+{
+	// Open file
+	gz_file = gzopen(path.c_str(), "rb");
+	if (!gz_file)
+		throw Error(fmt("%s: cannot open checkpoint file",
+				path.c_str()));
+	gzbuffer(gz_file, checkpoint_buffer_size);
+
+	// Check magic string
+	char magic[sizeof checkpoint_magic] = { };
+	int length = strlen(checkpoint_magic);
+	if (gzread(gz_file, magic, length) != length ||
+			strcmp(magic, checkpoint_magic))
+	{
+		gzclose(gz_file);
+		throw Error(fmt("%s: not a Multi2Sim checkpoint file",
+				path.c_str()));
+	}
+}
+
+
+CheckpointReader::~CheckpointReader()
+{
+	gzclose(gz_file);
+}
+
+
+void CheckpointReader::Read(void *data, size_t size)
+{
+	if (!size)
+		return;
+	if (gzread(gz_file, data, size) != (int) size)
+		throw Error(fmt("%s: unexpected end of checkpoint file",
+				path.c_str()));
+}
+
+
+std::string CheckpointReader::ReadString()
+{
+	// Strings are short, so a huge size means that the file is corrupt
+	unsigned size = ReadValue<unsigned>();
+	if (size > (1u << 24))
+		throw Error(fmt("%s: corrupt checkpoint file", path.c_str()));
+	std::string s(size, '\0');
+	Read(&s[0], size);
+	return s;
+}
+
+
+void CheckpointReader::ReadSection(const std::string &tag)
+{
+	std::string s = ReadString();
+	if (s != tag)
+		throw Error(fmt("%s: corrupt checkpoint file, expected "
+				"section '%s', found '%s'", path.c_str(),
+				tag.c_str(), s.c_str()));
+}
+
+
+}  // namespace misc
+
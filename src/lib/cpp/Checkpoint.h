@@ -0,0 +1,135 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LIB_CPP_CHECKPOINT_H
+#define LIB_CPP_CHECKPOINT_H
+
+#include <string>
+#include <type_traits>
+#include <zlib.h>
+
+#include "Error.h"
+
+
+namespace misc
+{
+
+/// Output stream for a simulator checkpoint. A checkpoint is a gzip-compressed
+/// sequence of sections, each starting with a tag that is verified when the
+/// checkpoint is read back. Values are stored in the host byte order, so a
+/// checkpoint can only be restored on a host of the same architecture.
+///
+/// Compression uses the fastest zlib level, so that large memory images can
+/// be streamed to disk at close to the speed of the storage device.
+class CheckpointWriter
+{
+	// Output file
+	gzFile gz_file;
+
+	// Path of the output file
+	std::string path;
+
+public:
+
+	/// Create the checkpoint file
+	///
+	/// \throw
+	///	A misc::Error is thrown if the file cannot be created.
+	CheckpointWriter(const std::string &path);
+
+	/// Close the checkpoint file
+	~CheckpointWriter();
+
+	/// Write a raw buffer
+	void Write(const void *data, size_t size);
+
+	/// Write a value of a trivially copyable type
+	template<typename T> void WriteValue(const T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value,
+				"type cannot be written as raw bytes");
+		Write(&value, sizeof(T));
+	}
+
+	/// Write a string, preceded by its length
+	void WriteString(const std::string &s);
+
+	/// Start a new section identified by \a tag
+	void WriteSection(const std::string &tag) { WriteString(tag); }
+};
+
+
+/// Input stream for a checkpoint created with CheckpointWriter.
+class CheckpointReader
+{
+	// Input file
+	gzFile gz_file;
+
+	// Path of the input file
+	std::string path;
+
+public:
+
+	/// Open a checkpoint file
+	///
+	/// \throw
+	///	A misc::Error is thrown if the file cannot be opened or it is
+	///	not a checkpoint.
+	CheckpointReader(const std::string &path);
+
+	/// Close the checkpoint file
+	~CheckpointReader();
+
+	/// Read a raw buffer
+	///
+	/// \throw
+	///	A misc::Error is thrown if the end of the file is reached.
+	void Read(void *data, size_t size);
+
+	/// Read a value of a trivially copyable type
+	template<typename T> T ReadValue()
+	{
+		static_assert(std::is_trivially_copyable<T>::value,
+				"type cannot be read as raw bytes");
+		T value;
+		Read(&value, sizeof(T));
+		return value;
+	}
+
+	/// Read a value into an existing variable
+	template<typename T> void ReadValue(T &value)
+	{
+		value = ReadValue<T>();
+	}
+
+	/// Read a string written with CheckpointWriter::WriteString()
+	std::string ReadString();
+
+	/// Read the beginning of a section, checking that its tag is \a tag.
+	///
+	/// \throw
+	///	A misc::Error is thrown if the tag does not match.
+	void ReadSection(const std::string &tag);
+};
+
+
+}  // namespace misc
+
+#endif
+
@@ -112,6 +112,27 @@ void CommandLineOptionInt64::Read(std::deque<std::string> &arguments)
 }
 
 
+void CommandLineOptionInt64String::Read(std::deque<std::string> &arguments)
+{
+	// Read values
+	assert(arguments.size() > 1);
+	std::string argument = arguments.front();
+	arguments.pop_front();
+	*string_variable = arguments.front();
+	arguments.pop_front();
+
+	// Convert integer value
+	StringError error;
+	*int_variable = StringToInt64(argument, error);
+
+	// Check valid value
+	if (error)
+		throw CommandLine::Error(misc::fmt("Invalid value for option "
+				"'%s': %s", getName().c_str(),
+				StringErrorToString(error)));
+}
+
+
 void CommandLineOptionDouble::Read(std::deque<std::string> &arguments)
 {
 	// Read value
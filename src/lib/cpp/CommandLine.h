@@ -49,6 +49,7 @@ public:
 		TypeString,
 		TypeInt32,
 		TypeInt64,
+		TypeInt64String,
 		TypeDouble,
 		TypeEnum
 	};
@@ -200,6 +201,31 @@ public:
 };
 
 
+/// Command-line option taking a 64-bit integer and a string as arguments
+class CommandLineOptionInt64String : public CommandLineOption
+{
+	// Variables affected by this option
+	long long *int_variable;
+	std::string *string_variable;
+
+public:
+
+	/// Constructor
+	CommandLineOptionInt64String(const std::string &name,
+			long long *int_variable,
+			std::string *string_variable,
+			const std::string &help) :
+			CommandLineOption(TypeInt64String, name, 2, help),
+			int_variable(int_variable),
+			string_variable(string_variable)
+	{
+	}
+	
+	/// Read option from command line. See CommandLineOption::Read().
+	void Read(std::deque<std::string> &arguments);
+};
+
+
 /// Command-line option taking a double precision floating point as an argument
 class CommandLineOptionDouble : public CommandLineOption
 {
@@ -493,6 +519,17 @@ public:
 				(long long *) &variable, help));
 	}
 
+	/// Register a command-line option taking two arguments: a signed
+	/// 64-bit integer followed by a string.
+	void RegisterInt64String(const std::string &name,
+			long long &int_variable,
+			std::string &string_variable,
+			const std::string &help)
+	{
+		Register(misc::new_unique<CommandLineOptionInt64String>(name,
+				&int_variable, &string_variable, help));
+	}
+
 	/// Same as RegisterString(), but taking a double as the
 	/// type of the command-line option.
 	void RegisterDouble(const std::string &name,
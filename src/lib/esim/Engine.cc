@@ -17,6 +17,8 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <chrono>
 #include <csignal>
 
 #include <lib/cpp/IniFile.h>
@@ -32,6 +34,22 @@ misc::Debug Engine::debug;
 
 std::unique_ptr<Engine> Engine::instance;
 
+Engine::SchedulerKind Engine::default_scheduler_kind = SchedulerHeap;
+
+int Engine::num_threads = 1;
+
+bool Engine::profile = false;
+
+std::unique_ptr<misc::IniFile> Engine::partition_map;
+
+thread_local Engine::Partition *Engine::current_partition = nullptr;
+
+const misc::StringMap Engine::SchedulerKindMap =
+{
+	{ "heap", SchedulerHeap },
+	{ "wheel", SchedulerWheel }
+};
+
 const char *engine_err_finalization =
 	"The finalization process of the event-driven simulation is trying to "
 	"empty the event heap by scheduling all pending events. If the number of "
@@ -50,8 +68,31 @@ const char *engine_err_max_inflight_events =
 	"events, please increase the value of macro ESIM_OVERLOAD_EVENTS to "
 	"avoid this warning. ";
 
-
-Engine::Engine() : timer("esim::Timer")
+const char *engine_err_lookahead =
+	"With more than one simulation thread, events are divided in "
+	"partitions by frequency domain, and the events of one partition can "
+	"only schedule events of another partition for a future cycle. "
+	"Otherwise, event handlers of both partitions could have run "
+	"concurrently, and simulation results would differ from those of a "
+	"single thread. Please use a partition map (option "
+	"--esim-partition-map) that assigns both frequency domains to the "
+	"same partition.\n";
+
+const char *engine_err_single_partition =
+	"All frequency domains with events share one partition, so events run "
+	"sequentially. Frequency domains that interact within a cycle, such as "
+	"an architecture under detailed simulation, the memory hierarchy it "
+	"accesses, and its networks, always share a partition. Only independent "
+	"frequency domains run in parallel.\n";
+
+
+Engine::Engine() :
+		timer("esim::Timer"),
+		scheduler_kind(default_scheduler_kind),
+		window_generation(0),
+		next_task(0),
+		num_finished_workers(0),
+		stop_workers(false)
 {
 	// Initialize timer
 	timer.Start();
@@ -64,6 +105,110 @@ Engine::Engine() : timer("esim::Timer")
 }
 
 
+void Engine::setSchedulerKind(SchedulerKind scheduler_kind)
+{
+	// Save for future instances
+	assert(scheduler_kind == SchedulerHeap ||
+			scheduler_kind == SchedulerWheel);
+	default_scheduler_kind = scheduler_kind;
+
+	// Update current instance
+	if (!instance)
+		return;
+	if (instance->getNumPendingFrames())
+		throw misc::Panic("Cannot change the event scheduler while "
+				"events are pending");
+	instance->scheduler_kind = scheduler_kind;
+}
+
+
+Engine::~Engine()
+{
+	// Stop worker threads
+	stop_workers = true;
+	for (auto &worker : workers)
+		worker.join();
+	if (workers.size())
+		FrameArena::setConcurrent(false);
+}
+
+
+void Engine::setNumThreads(int num_threads)
+{
+	// Worker threads are created in the first cycle
+	assert(num_threads > 0);
+	if (instance && instance->workers.size())
+		throw misc::Panic("Cannot change the number of simulation "
+				"threads after the simulation started");
+	Engine::num_threads = num_threads;
+}
+
+
+void Engine::setPartitionMap(const std::string &path)
+{
+	// Load map
+	partition_map = misc::new_unique<misc::IniFile>(path);
+
+	// Reassign partitions of existing frequency domains
+	if (!instance)
+		return;
+	if (instance->getNumPendingFrames())
+		throw misc::Panic("Cannot change the partition map while "
+				"events are pending");
+	instance->partitions.clear();
+	instance->partition_indices.clear();
+	for (auto &frequency_domain : instance->frequency_domains)
+		instance->AssignPartition(&frequency_domain);
+}
+
+
+void Engine::AssignPartition(FrequencyDomain *frequency_domain)
+{
+	// Domains listed in the partition map share the partition with other
+	// domains with the same identifier.
+	const std::string section = "Partitions";
+	const std::string &name = frequency_domain->getName();
+	if (partition_map && partition_map->Exists(section, name))
+	{
+		int id = partition_map->ReadInt(section, name);
+		auto it = partition_indices.find(id);
+		if (it != partition_indices.end())
+		{
+			frequency_domain->setPartition(it->second);
+			return;
+		}
+		partition_indices[id] = partitions.size();
+	}
+
+	// New partition
+	frequency_domain->setPartition(partitions.size());
+	partitions.emplace_back(misc::new_unique<Partition>());
+	partitions.back()->index = partitions.size() - 1;
+	num_partitions++;
+}
+
+
+void Engine::CoupleFrequencyDomains(FrequencyDomain *frequency_domain,
+		FrequencyDomain *other_frequency_domain)
+{
+	// Already in the same partition
+	int partition = frequency_domain->getPartition();
+	int other_partition = other_frequency_domain->getPartition();
+	if (partition == other_partition)
+		return;
+
+	// Move all domains of the other partition, which is left empty
+	assert(current_partition == nullptr);
+	for (auto &domain : frequency_domains)
+		if (domain.getPartition() == other_partition)
+			domain.setPartition(partition);
+	for (auto &it : partition_indices)
+		if (it.second == other_partition)
+			it.second = partition;
+	num_partitions--;
+}
+
+
 void Engine::SignalHandler(int signum)
 {
 	// Get instance
@@ -94,16 +239,16 @@ bool Engine::Drain(int max_events)
 	while (1)
 	{
 		// No more elements in heap
-		if (heap.size() == 0)
+		if (getNumPendingFrames() == 0)
 			return false;
 
 		// Get frame from top of the heap
 		assert(current_frame == nullptr);
-		current_frame = heap.top();
+		current_frame = TopPendingFrame();
 		assert(current_frame->in_heap);
 
 		// Extract from heap
-		heap.pop();
+		PopPendingFrame();
 		current_frame->in_heap = false;
 
 		// Debug
@@ -119,10 +264,14 @@ bool Engine::Drain(int max_events)
 
 		// One more events
 		num_events++;
+		num_processed_events++;
 
 		// Run event handler
 		EventHandler event_handler = event->getEventHandler();
-		event_handler(event, current_frame.get());
+		if (profile)
+			RunProfiledHandler(event, current_frame.get());
+		else
+			event_handler(event, current_frame.get());
 
 		// Free frame
 		current_frame = nullptr;
@@ -204,25 +353,27 @@ void Engine::ProcessEvents()
 		Finish("Signal");
 	}
 	
-	// Process events scheduled for this cycle
-	while (1)
+	// Process events scheduled for this cycle with the parallel engine
+	// if enabled, or sequentially otherwise
+	bool parallel = num_threads > 1 && ProcessEventsParallel();
+	while (!parallel)
 	{
 		// No more elements in heap
-		if (heap.size() == 0)
+		if (getNumPendingFrames() == 0)
 			break;
 
 		// Stop when we find the first event that should run in the
 		// future.
-		if (heap.top()->time > current_time)
+		if (TopPendingFrame()->time > current_time)
 			break;
 		
 		// Get frame from top of heap
 		assert(current_frame == nullptr);
-		current_frame = heap.top();
+		current_frame = TopPendingFrame();
 		assert(current_frame->in_heap);
 
 		// Remove frame from the heap
-		heap.pop();
+		PopPendingFrame();
 		current_frame->in_heap = false;
 
 		// Debug
@@ -236,10 +387,14 @@ void Engine::ProcessEvents()
 		// The event is being run, so decrement the number of in-flight
 		// events of its type.
 		event->decInFlight();
+		num_processed_events++;
 
 		// Run event handler
 		EventHandler event_handler = event->getEventHandler();
-		event_handler(event, current_frame.get());
+		if (profile)
+			RunProfiledHandler(event, current_frame.get());
+		else
+			event_handler(event, current_frame.get());
 
 		// Reschedule if it is periodic
 		int period = current_frame->period;
@@ -255,11 +410,264 @@ void Engine::ProcessEvents()
 }
 
 
+bool Engine::ProcessEventsParallel()
+{
+	// Debug information is dumped in the order in which event handlers
+	// run, and the profiler measures the host time of each handler, which
+	// requires the sequential engine.
+	if (debug || profile)
+		return false;
+
+	// Nothing to run in parallel
+	if (num_partitions < 2)
+	{
+		if (!single_partition_warning)
+			misc::Warning("[esim] %d simulation threads requested, "
+					"but there is only one partition\n\n%s",
+					num_threads,
+					engine_err_single_partition);
+		single_partition_warning = true;
+		return false;
+	}
+
+	// Start worker threads
+	if (workers.empty())
+	{
+		FrameArena::setConcurrent(true);
+		for (int i = 1; i < num_threads; i++)
+			workers.emplace_back(&Engine::WorkerLoop, this);
+	}
+
+	// Distribute the events of this cycle among partitions
+	long long num_pending_frames = getNumPendingFrames();
+	tasks.clear();
+	while (getNumPendingFrames() &&
+			TopPendingFrame()->time <= current_time)
+	{
+		FramePtr<Frame> frame = TopPendingFrame();
+		PopPendingFrame();
+		FrequencyDomain *frequency_domain =
+				frame->event->getFrequencyDomain();
+		Partition *partition = partitions[
+				frequency_domain->getPartition()].get();
+		if (partition->heap.empty())
+		{
+			partition->schedule_sequence_base =
+					schedule_sequence_counter;
+			tasks.push_back(partition);
+		}
+		partition->heap.emplace(std::move(frame));
+	}
+
+	// Run partitions. The main thread takes part in the window, and waits
+	// for all worker threads to finish it.
+	if (tasks.size() == 1)
+	{
+		RunPartition(tasks[0]);
+	}
+	else if (tasks.size() > 1)
+	{
+		num_parallel_windows++;
+		next_task.store(0, std::memory_order_relaxed);
+		num_finished_workers.store(0, std::memory_order_relaxed);
+		window_generation.fetch_add(1, std::memory_order_release);
+		RunTasks();
+		while (num_finished_workers.load(std::memory_order_acquire) !=
+				(int) workers.size())
+			std::this_thread::yield();
+	}
+
+	// Propagate exceptions thrown by event handlers
+	for (Partition *partition : tasks)
+		if (partition->exception)
+			std::rethrow_exception(partition->exception);
+
+	// Merge partitions
+	MergePartitions(num_pending_frames);
+	return true;
+}
+
+
+void Engine::RunTasks()
+{
+	while (true)
+	{
+		int index = next_task.fetch_add(1, std::memory_order_relaxed);
+		if (index >= (int) tasks.size())
+			break;
+		RunPartition(tasks[index]);
+	}
+}
+
+
+void Engine::WorkerLoop()
+{
+	long long generation = 0;
+	while (true)
+	{
+		// Wait for a new window
+		int num_spins = 0;
+		while (window_generation.load(std::memory_order_acquire) ==
+				generation)
+		{
+			if (stop_workers)
+				return;
+			if (++num_spins > 1000)
+				std::this_thread::yield();
+		}
+		generation++;
+
+		// Run partitions
+		RunTasks();
+		num_finished_workers.fetch_add(1, std::memory_order_release);
+	}
+}
+
+
+void Engine::RunPartition(Partition *partition)
+{
+	current_partition = partition;
+	try
+	{
+		while (partition->heap.size())
+		{
+			// Get frame from top of the heap
+			FramePtr<Frame> &frame = partition->current_frame;
+			assert(frame == nullptr);
+			frame = partition->heap.top();
+			partition->heap.pop();
+			frame->in_heap = false;
+
+			// Identify the frame as taken from the engine scheduler,
+			// or as scheduled in this window
+			Partition::Execution execution;
+			execution.time = frame->time;
+			execution.schedule_sequence = -1;
+			execution.record = -1;
+			if (frame->schedule_sequence >
+					partition->schedule_sequence_base)
+				execution.record = frame->schedule_sequence -
+						partition->schedule_sequence_base
+						- 1;
+			else
+				execution.schedule_sequence =
+						frame->schedule_sequence;
+			execution.first_record = partition->records.size();
+
+			// Run event handler
+			Event *event = frame->event;
+			event->decInFlight();
+			EventHandler event_handler = event->getEventHandler();
+			event_handler(event, frame.get());
+
+			// Reschedule if it is periodic
+			int period = frame->period;
+			if (period > 0)
+				Schedule(event, frame, period, period);
+
+			// Free frame
+			frame = nullptr;
+			execution.end_record = partition->records.size();
+			partition->executions.push_back(execution);
+		}
+	}
+	catch (...)
+	{
+		partition->exception = std::current_exception();
+		partition->current_frame = nullptr;
+	}
+	current_partition = nullptr;
+}
+
+
+void Engine::MergePartitions(long long num_pending_frames)
+{
+	// Next execution of each partition
+	std::vector<unsigned> positions(tasks.size(), 0);
+	while (true)
+	{
+		// Choose the execution that the sequential engine would have
+		// run next. Frames scheduled in this window already got their
+		// final schedule sequence number when the handler that
+		// scheduled them was merged.
+		int index = -1;
+		long long time = 0;
+		long long schedule_sequence = 0;
+		for (unsigned i = 0; i < tasks.size(); i++)
+		{
+			Partition *partition = tasks[i];
+			if (positions[i] == partition->executions.size())
+				continue;
+			const Partition::Execution &execution =
+					partition->executions[positions[i]];
+			long long sequence = execution.record < 0 ?
+					execution.schedule_sequence :
+					partition->records[execution.record]
+					.schedule_sequence;
+			if (index < 0 || execution.time < time ||
+					(execution.time == time &&
+					sequence < schedule_sequence))
+			{
+				index = i;
+				time = execution.time;
+				schedule_sequence = sequence;
+			}
+		}
+		if (index < 0)
+			break;
+
+		// Frame extracted from the heap
+		Partition *partition = tasks[index];
+		const Partition::Execution &execution =
+				partition->executions[positions[index]++];
+		num_pending_frames--;
+		num_processed_events++;
+
+		// Frames scheduled by the event handler
+		for (int i = execution.first_record; i < execution.end_record;
+				i++)
+		{
+			Partition::Record &record = partition->records[i];
+			record.schedule_sequence = ++schedule_sequence_counter;
+			RecordPendingFrames(++num_pending_frames);
+			if (!record.deferred)
+				continue;
+			record.frame->schedule_sequence =
+					record.schedule_sequence;
+			PushPendingFrame(record.frame);
+			if (record.remote)
+				record.frame->event->incInFlight();
+		}
+	}
+
+	// Reset partitions for the next window
+	for (Partition *partition : tasks)
+	{
+		partition->records.clear();
+		partition->executions.clear();
+	}
+}
+
+
+void Engine::SkipTime(long long time)
+{
+	// Sanity
+	assert(time >= current_time);
+	assert(time % shortest_cycle_time == 0);
+	assert(getNumPendingFrames() == 0 || TopPendingFrame()->time >= time);
+
+	// Count skipped cycles and advance time
+	num_skipped_cycles += (time - current_time) / shortest_cycle_time;
+	current_time = time;
+}
+
+
 FrequencyDomain *Engine::RegisterFrequencyDomain(const std::string &name,
 		int frequency)
 {
 	// Create frequency domain
 	frequency_domains.emplace_back(name, frequency);
+	AssignPartition(&frequency_domains.back());
 
 	// Update fastest frequency domain
 	if (frequency > fastest_frequency)
@@ -298,7 +706,7 @@ Event *Engine::RegisterEvent(const std::string &name,
 	
 	
 void Engine::Schedule(Event *event,
-		std::shared_ptr<Frame> frame,
+		FramePtr<Frame> frame,
 		int after,
 		int period)
 {
@@ -350,12 +758,21 @@ void Engine::Schedule(Event *event,
 	frame->event = event;
 	frame->period = period;
 
+	// Event handler running in a partition of the parallel engine
+	if (current_partition)
+	{
+		SchedulePartition(event, frame);
+		return;
+	}
+
 	// Assign a schedule sequence number of the frame, use to disambiguate
 	// the order of those events scheduled for the same cycle
 	frame->schedule_sequence = ++schedule_sequence_counter;
 
 	// Insert frame into the heap
-	heap.emplace(frame);
+	PushPendingFrame(frame);
+	if (profile)
+		event->addSchedule(after);
 	frame->in_heap = true;
 
 	// Increment the number of in-flight events of this type.
@@ -368,8 +785,81 @@ void Engine::Schedule(Event *event,
 			event->getName().c_str(),
 			(double) frame->time / 1000);
 
+	// Record maximum heap size
+	RecordPendingFrames(getNumPendingFrames());
+}
+
+
+void Engine::SchedulePartition(Event *event, FramePtr<Frame> &frame)
+{
+	// Events of other partitions can only be scheduled for future cycles.
+	// Handlers of the other partition may already have run in this
+	// window, so the conflict cannot be recovered from.
+	Partition *partition = current_partition;
+	FrequencyDomain *frequency_domain = event->getFrequencyDomain();
+	bool remote = frequency_domain->getPartition() != partition->index;
+	if (remote && frame->time <= current_time)
+	{
+		Event *current_event = partition->current_frame->event;
+		throw Error(misc::fmt("Event '%s/%s' scheduled for the "
+				"current cycle by event '%s/%s', which runs "
+				"in a different partition\n\n%s",
+				frequency_domain->getName().c_str(),
+				event->getName().c_str(),
+				current_event->getFrequencyDomain()->
+				getName().c_str(),
+				current_event->getName().c_str(),
+				engine_err_lookahead));
+	}
+
+	// Assign a provisional schedule sequence number, identifying the
+	// record of this operation. The final number is assigned on merge.
+	frame->schedule_sequence = partition->schedule_sequence_base +
+			partition->records.size() + 1;
+	frame->in_heap = true;
+	bool deferred = remote || frame->time > current_time;
+	partition->records.push_back({frame, frame->time, 0,
+			deferred, remote});
+
+	// Frames of this partition run within the window if scheduled for
+	// the current cycle. In-flight events of other partitions are
+	// counted on merge.
+	if (!remote)
+		event->incInFlight();
+	if (!deferred)
+		partition->heap.emplace(frame);
+}
+
+
+void Engine::RunProfiledHandler(Event *event, Frame *frame)
+{
+	// Record heap occupancy
+	unsigned index = 0;
+	while (getNumPendingFrames() >> index)
+		index++;
+	if (occupancy_histogram.size() <= index)
+		occupancy_histogram.resize(index + 1);
+	occupancy_histogram[index]++;
+
+	// Run event handler and measure its host time. Handlers invoked
+	// synchronously with Execute() count as part of the caller.
+	auto start = std::chrono::steady_clock::now();
+	EventHandler event_handler = event->getEventHandler();
+	event_handler(event, frame);
+	auto end = std::chrono::steady_clock::now();
+	event->addInvocation(std::chrono::duration_cast<
+			std::chrono::nanoseconds>(end - start).count());
+}
+
+
+void Engine::RecordPendingFrames(long long num_pending_frames)
+{
+	// Record maximum heap size
+	if (num_pending_frames > max_pending_events)
+		max_pending_events = num_pending_frames;
+
 	// Warn when heap is overloaded
-	if (!max_inflight_events_warning && (int) heap.size() >=
+	if (!max_inflight_events_warning && num_pending_frames >=
 			max_inflight_events)
 	{
 		max_inflight_events_warning = true;
@@ -387,16 +877,16 @@ void Engine::Next(Event *event,
 {
 	// Use current event's frame if this function is invoked within an
 	// event handler, or create new frame otherwise.
-	std::shared_ptr<Frame> frame = current_frame;
+	FramePtr<Frame> frame = CurrentFrame();
 	if (!frame)
-		frame = misc::new_shared<Frame>();
+		frame = new_frame<Frame>();
 
 	// Schedule event
 	Schedule(event, frame, after, period);
 }
 
 
-void Engine::Execute(Event *event, std::shared_ptr<Frame> frame,
+void Engine::Execute(Event *event, FramePtr<Frame> frame,
 		Event *receive_event)
 {
 	// Null event
@@ -404,7 +894,8 @@ void Engine::Execute(Event *event, std::shared_ptr<Frame> frame,
 		return;
 
 	// Save old current frame
-	std::shared_ptr<Frame> old_current_frame = current_frame;
+	FramePtr<Frame> &current_frame = CurrentFrame();
+	FramePtr<Frame> old_current_frame = current_frame;
 
 	// Create new frame if none exists
 	frame->parent_frame = current_frame;
@@ -421,18 +912,18 @@ void Engine::Execute(Event *event, std::shared_ptr<Frame> frame,
 
 
 void Engine::Call(Event *event,
-		std::shared_ptr<Frame> frame,
+		FramePtr<Frame> frame,
 		Event *return_event,
 		int after,
 		int period)
 {
 	// Create new frame if none passed
 	if (frame == nullptr)
-		frame = misc::new_shared<Frame>();
+		frame = new_frame<Frame>();
 
 	// Set return event and frame
 	frame->return_event = return_event;
-	frame->parent_frame = current_frame;
+	frame->parent_frame = CurrentFrame();
 
 	// Schedule event
 	Schedule(event, frame, after, period);
@@ -442,6 +933,7 @@ void Engine::Call(Event *event,
 void Engine::Return(int after)
 {
 	// This function must be invoked within an event handler
+	const FramePtr<Frame> &current_frame = CurrentFrame();
 	if (!current_frame)
 		throw misc::Panic("Function cannot be invoked outside of "
 				"an event handler");
@@ -464,7 +956,7 @@ void Engine::EndEvent(Event *event)
 		return;
 	
 	// Create frame
-	auto frame = misc::new_shared<Frame>();
+	auto frame = new_frame<Frame>();
 	frame->event = event;
 
 	// Add event to queue of end events
@@ -493,6 +985,131 @@ void Engine::ProcessAllEvents()
 }
 
 
+void Engine::DumpReport(std::ostream &os) const
+{
+	// Introduction
+	os << "; Report for the event-driven simulation engine\n";
+	os << ";    Events - Number of event handlers executed\n";
+	os << ";    MaxPendingEvents - Maximum occupancy of the event heap\n";
+	os << ";    SkippedCycles - Idle cycles fast-forwarded by the main loop\n";
+	os << ";    Threads - Host threads running event handlers\n";
+	os << ";    Partitions - Groups of frequency domains run by one thread\n";
+	os << ";    ParallelWindows - Cycles with events in several partitions\n";
+	os << ";    FrameArena <type> - Allocator for event frames of a type\n";
+	os << ";        Allocations - Number of frames allocated\n";
+	os << ";        Hits - Allocations that recycled a released frame\n";
+	os << ";        HitRatio - Hits divided by allocations\n";
+	os << ";        InUse, MaxInUse - Current and maximum live frames\n";
+	os << "\n\n";
+
+	// General statistics
+	os << "[ General ]\n";
+	os << "Scheduler = " << SchedulerKindMap[scheduler_kind] << '\n';
+	os << misc::fmt("SimTime = %.2f [ns]\n", current_time / 1000.0);
+	os << misc::fmt("Events = %lld\n", num_processed_events);
+	os << misc::fmt("PendingEvents = %d\n", (int) getNumPendingFrames());
+	os << misc::fmt("MaxPendingEvents = %lld\n", max_pending_events);
+	os << misc::fmt("SkippedCycles = %lld\n", num_skipped_cycles);
+	os << misc::fmt("Threads = %d\n", num_threads);
+	os << misc::fmt("Partitions = %d\n", num_partitions);
+	os << misc::fmt("ParallelWindows = %lld\n", num_parallel_windows);
+	os << '\n';
+
+	// Frame allocators
+	FrameArena::DumpReports(os);
+}
+
+
+// Dump a histogram with power-of-two ranges, as recorded by the profiler
+static void DumpHistogram(std::ostream &os, const std::string &name,
+		const std::vector<long long> &histogram)
+{
+	for (unsigned i = 0; i < histogram.size(); i++)
+	{
+		if (!histogram[i])
+			continue;
+		if (i < 2)
+			os << misc::fmt("%s[%d] = %lld\n", name.c_str(),
+					i, histogram[i]);
+		else
+			os << misc::fmt("%s[%lld-%lld] = %lld\n",
+					name.c_str(), 1ll << (i - 1),
+					(1ll << i) - 1, histogram[i]);
+	}
+}
+
+
+void Engine::DumpProfile(std::ostream &os) const
+{
+	// Introduction
+	os << "; Profile of the event-driven simulation engine\n";
+	os << ";    Invocations - Number of times the event handler ran\n";
+	os << ";    HostTime - Host time spent in the handler, including "
+			"handlers run\n";
+	os << ";        synchronously with Execute()\n";
+	os << ";    HostTimeFraction - Fraction of the host time of all "
+			"handlers\n";
+	os << ";    Schedules - Number of times the event was scheduled\n";
+	os << ";    Distance[a-b] - Events scheduled between a and b cycles "
+			"ahead\n";
+	os << ";    Occupancy[a-b] - Handlers run with a to b pending "
+			"events\n";
+	os << "\n\n";
+
+	// Sort event types by decreasing host time
+	std::vector<const Event *> sorted_events;
+	long long num_invocations = 0;
+	long long host_time = 0;
+	for (const Event &event : events)
+	{
+		if (!event.getNumInvocations() && !event.getNumSchedules())
+			continue;
+		sorted_events.push_back(&event);
+		num_invocations += event.getNumInvocations();
+		host_time += event.getHostTime();
+	}
+	std::stable_sort(sorted_events.begin(), sorted_events.end(),
+			[](const Event *a, const Event *b)
+			{
+				return a->getHostTime() > b->getHostTime();
+			});
+
+	// General statistics
+	os << "[ General ]\n";
+	os << misc::fmt("Invocations = %lld\n", num_invocations);
+	os << misc::fmt("HostTime = %.6f [s]\n", host_time / 1e9);
+	os << misc::fmt("HostTimePerInvocation = %.2f [ns]\n",
+			num_invocations ? (double) host_time /
+			num_invocations : 0.0);
+	DumpHistogram(os, "Occupancy", occupancy_histogram);
+	os << '\n';
+
+	// Event types
+	for (const Event *event : sorted_events)
+	{
+		FrequencyDomain *frequency_domain =
+				event->getFrequencyDomain();
+		os << misc::fmt("[ Event %s/%s ]\n", frequency_domain ?
+				frequency_domain->getName().c_str() : "",
+				event->getName().c_str());
+		os << misc::fmt("Invocations = %lld\n",
+				event->getNumInvocations());
+		os << misc::fmt("HostTime = %.6f [s]\n",
+				event->getHostTime() / 1e9);
+		os << misc::fmt("HostTimePerInvocation = %.2f [ns]\n",
+				event->getNumInvocations() ?
+				(double) event->getHostTime() /
+				event->getNumInvocations() : 0.0);
+		os << misc::fmt("HostTimeFraction = %.4f\n", host_time ?
+				(double) event->getHostTime() / host_time :
+				0.0);
+		os << misc::fmt("Schedules = %lld\n",
+				event->getNumSchedules());
+		DumpHistogram(os, "Distance", event->getDistanceHistogram());
+		os << '\n';
+	}
+}
+
 
 }  // namespace esim
 
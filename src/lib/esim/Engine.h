@@ -20,10 +20,14 @@
 #ifndef LIB_CPP_ESIM_ENGINE_H
 #define LIB_CPP_ESIM_ENGINE_H
 
+#include <atomic>
 #include <cassert>
+#include <exception>
 #include <memory>
 #include <list>
+#include <mutex>
 #include <queue>
+#include <thread>
 #include <vector>
 #include <map>
 
@@ -36,8 +40,14 @@
 #include "Event.h"
 #include "Frame.h"
 #include "FrequencyDomain.h"
+#include "TimingWheel.h"
 
 
+namespace misc
+{
+class IniFile;
+}
+
 namespace esim
 {
 
@@ -63,12 +73,124 @@ public:
 /// Event-driven simulator engine
 class Engine
 {
+public:
+
+	/// Data structure used to keep pending events sorted by time
+	enum SchedulerKind
+	{
+		SchedulerInvalid = 0,
+		SchedulerHeap,
+		SchedulerWheel
+	};
+
+	/// String map for SchedulerKind
+	static const misc::StringMap SchedulerKindMap;
+
+private:
+
 	// Unique instance of this class
 	static std::unique_ptr<Engine> instance;
 
 	/// Debugger
 	static misc::Debug debug;
 
+	// Scheduler used by new instances of the engine
+	static SchedulerKind default_scheduler_kind;
+
+	// Number of host threads running event handlers, including the main
+	// thread. A value of 1 selects the sequential engine.
+	static int num_threads;
+
+	// Whether the profiler is active
+	static bool profile;
+
+	// Partition map loaded with setPartitionMap(), associating frequency
+	// domain names with user-defined partition identifiers
+	static std::unique_ptr<misc::IniFile> partition_map;
+
+	// Set of events of one partition executed by one thread in a window
+	// of the parallel engine. A window runs all events scheduled for the
+	// current cycle. While a partition runs, its events can only schedule
+	// events of the same partition for the current cycle. Any other event
+	// scheduled by a handler is deferred until the end of the window, when
+	// all partitions are merged in the order that the sequential engine
+	// would have followed. An event of another partition scheduled for the
+	// current cycle is an error.
+	struct Partition
+	{
+		// Frame scheduled by an event handler of the partition
+		struct Record
+		{
+			// Scheduled frame
+			FramePtr<Frame> frame;
+
+			// Time assigned to the frame
+			long long time;
+
+			// Final schedule sequence number, assigned on merge
+			long long schedule_sequence;
+
+			// The frame runs after the window, or in another
+			// partition, and is inserted in the engine scheduler
+			// on merge.
+			bool deferred;
+
+			// The frame runs an event of another partition, whose
+			// number of in-flight events is updated on merge
+			bool remote;
+		};
+
+		// Event handler executed in the partition
+		struct Execution
+		{
+			// Time of the frame
+			long long time;
+
+			// Schedule sequence number of the frame, when it was
+			// taken from the engine scheduler, or -1 if it was
+			// scheduled within the window
+			long long schedule_sequence;
+
+			// Index in 'records' of the schedule operation that
+			// produced the frame, or -1
+			int record;
+
+			// Range of 'records' produced by the handler
+			int first_record;
+			int end_record;
+		};
+
+		// Index of the partition
+		int index;
+
+		// Frames to run in the current window
+		std::priority_queue<FramePtr<Frame>,
+				std::vector<FramePtr<Frame>>,
+				Frame::CompareSharedPointers> heap;
+
+		// Frame of the event handler currently running in the partition
+		FramePtr<Frame> current_frame;
+
+		// Value of the engine schedule sequence counter at the start of
+		// the window. Frames scheduled within the window are assigned
+		// provisional sequence numbers above it, in the order in
+		// which 'records' are created.
+		long long schedule_sequence_base = 0;
+
+		// Frames scheduled in the current window
+		std::vector<Record> records;
+
+		// Event handlers run in the current window
+		std::vector<Execution> executions;
+
+		// Exception thrown by an event handler in the current window
+		std::exception_ptr exception;
+	};
+
+	// Partition running in the current host thread, or null if the thread
+	// is not running a window of the parallel engine
+	static thread_local Partition *current_partition;
+
 	// Flag set when simulation should finish
 	bool finish = false;
 
@@ -88,12 +210,19 @@ class Engine
 	std::list<FrequencyDomain> frequency_domains;
 
 	// Heap of pending events
-	std::priority_queue<std::shared_ptr<Frame>,
-			std::vector<std::shared_ptr<Frame>>,
+	std::priority_queue<FramePtr<Frame>,
+			std::vector<FramePtr<Frame>>,
 			Frame::CompareSharedPointers> heap;
 
+	// Timing wheel of pending events, used instead of 'heap' when the
+	// scheduler kind is SchedulerWheel.
+	TimingWheel wheel;
+
+	// Scheduler in use, selecting between 'heap' and 'wheel'
+	SchedulerKind scheduler_kind;
+
 	// Queue of frames associated with the end events
-	std::queue<std::shared_ptr<Frame>> end_frames;
+	std::queue<FramePtr<Frame>> end_frames;
 
 	// Null event type used to schedule useless events
 	Event *null_event = nullptr;
@@ -110,14 +239,70 @@ class Engine
 	// Cycle time of the fastest frequency domain
 	long long shortest_cycle_time = 0;
 
-	// When an event handler is being executed, this is the current frame.
-	// Otherwise, it is null.
-	std::shared_ptr<Frame> current_frame;
+	// When an event handler is being executed by the sequential engine,
+	// this is the current frame. Otherwise, it is null.
+	FramePtr<Frame> current_frame;
+
+	// Partitions of the parallel engine, indexed by the partition number
+	// assigned to each frequency domain
+	std::vector<std::unique_ptr<Partition>> partitions;
+
+	// Partition identifiers from the partition map, and the partition
+	// index assigned to each of them
+	std::map<int, int> partition_indices;
+
+	// Number of partitions with at least one frequency domain. Entries of
+	// 'partitions' left without domains by CoupleFrequencyDomains() are
+	// not counted.
+	int num_partitions = 0;
+
+	// Partitions with events in the current window
+	std::vector<Partition *> tasks;
+
+	// Worker threads of the parallel engine
+	std::vector<std::thread> workers;
+
+	// Incremented by the main thread to start a new window
+	std::atomic<long long> window_generation;
+
+	// Index in 'tasks' of the next partition to run in the window
+	std::atomic<int> next_task;
+
+	// Number of worker threads that finished the current window
+	std::atomic<int> num_finished_workers;
+
+	// Set to make worker threads exit
+	std::atomic<bool> stop_workers;
+
+	// Protects 'finish' and 'finish_reason' from concurrent handlers
+	std::mutex finish_mutex;
+
+	// Number of windows in which more than one partition ran events
+	long long num_parallel_windows = 0;
+
+	// Whether the parallel engine already warned that all frequency
+	// domains share one partition
+	bool single_partition_warning = false;
+
+	// Histogram of the number of pending events observed by the profiler
+	// every time an event handler runs. Entry 0 counts an empty heap, and
+	// entry i > 0 counts occupancies between 2^(i-1) and 2^i - 1.
+	std::vector<long long> occupancy_histogram;
 
 	// Counter used to assign values to the 'schedule_sequence' field
 	// of Frame instances
 	long long schedule_sequence_counter = 0;
 
+	// Number of event handlers executed from the event heap
+	long long num_processed_events = 0;
+
+	// Maximum number of pending events observed in the event heap
+	long long max_pending_events = 0;
+
+	// Number of cycles of the fastest frequency domain skipped with calls
+	// to SkipTime() instead of running the main simulation loop
+	long long num_skipped_cycles = 0;
+
 	// Number of in-flight events before a warning is shown (10k events)
 	const int max_inflight_events = 10000;
 
@@ -135,6 +320,45 @@ class Engine
 	// Signals received from the user are captured by this function
 	static void SignalHandler(int sig);
 
+	// Return the number of pending events in the active scheduler
+	size_t getNumPendingFrames() const
+	{
+		return scheduler_kind == SchedulerWheel ? wheel.size() :
+				heap.size();
+	}
+
+	// Return the earliest pending event in the active scheduler. There
+	// must be at least one pending event.
+	const FramePtr<Frame> &TopPendingFrame()
+	{
+		return scheduler_kind == SchedulerWheel ? wheel.top() :
+				heap.top();
+	}
+
+	// Remove the earliest pending event from the active scheduler
+	void PopPendingFrame()
+	{
+		if (scheduler_kind == SchedulerWheel)
+			wheel.pop();
+		else
+			heap.pop();
+	}
+
+	// Insert a frame in the active scheduler. The timing wheel is sized
+	// after the fastest frequency domain whenever it is empty.
+	void PushPendingFrame(const FramePtr<Frame> &frame)
+	{
+		if (scheduler_kind != SchedulerWheel)
+		{
+			heap.emplace(frame);
+			return;
+		}
+		if (wheel.empty() && shortest_cycle_time &&
+				wheel.getBucketWidth() != shortest_cycle_time)
+			wheel.setBucketWidth(shortest_cycle_time);
+		wheel.push(frame);
+	}
+
 	// Drain the event heap, with a maximum number of events specified in
 	// the argument. If this number is exceeded, the function returns true.
 	// If the heap is drained successfully, the function returns false.
@@ -144,20 +368,127 @@ class Engine
 	// Process all events scheduled with a previous call to EndEvent()
 	void ProcessEndEvents();
 
+	// Return the frame of the event handler running in the current thread
+	FramePtr<Frame> &CurrentFrame()
+	{
+		return current_partition ? current_partition->current_frame :
+				current_frame;
+	}
+
+	// Return the frame of the event handler running in the current thread
+	const FramePtr<Frame> &CurrentFrame() const
+	{
+		return current_partition ? current_partition->current_frame :
+				current_frame;
+	}
+
+	// Run an event handler, recording profiling statistics
+	void RunProfiledHandler(Event *event, Frame *frame);
+
+	// Record the number of pending events after a new event is scheduled,
+	// and warn when the heap is overloaded
+	void RecordPendingFrames(long long num_pending_frames);
+
+	// Assign the partition of a frequency domain
+	void AssignPartition(FrequencyDomain *frequency_domain);
+
+	// Process the events of the current cycle with the parallel engine.
+	// Return false if the events must be processed sequentially instead.
+	bool ProcessEventsParallel();
+
+	// Run all events of a partition in the current window
+	void RunPartition(Partition *partition);
+
+	// Run partitions of the current window until none is left
+	void RunTasks();
+
+	// Main function of worker threads
+	void WorkerLoop();
+
+	// Combine the executions of all partitions of the current window,
+	// assigning schedule sequence numbers and updating statistics as
+	// the sequential engine would have. The argument is the number of
+	// pending events at the start of the window.
+	void MergePartitions(long long num_pending_frames);
+
+	// Schedule a frame from an event handler of a partition
+	void SchedulePartition(Event *event, FramePtr<Frame> &frame);
+
 public:
 
 	// Constructor
 	Engine();
 
+	/// Destructor, stopping worker threads
+	~Engine();
+
 	/// Obtain the instance of the event-driven simulator singleton.
 	static Engine *getInstance();
 
 	/// Destroy the singleton if allocated.
 	static void Destroy() { instance = nullptr; }
 
+	/// Select the data structure used to keep pending events. If the
+	/// engine singleton was already created, it switches to the new
+	/// scheduler as well, which is only allowed if no event is pending.
+	static void setSchedulerKind(SchedulerKind scheduler_kind);
+
+	/// Return the data structure used to keep pending events
+	SchedulerKind getSchedulerKind() const { return scheduler_kind; }
+
+	/// Set the number of host threads running event handlers. With more
+	/// than one thread, the events of each cycle are divided in partitions
+	/// by frequency domain, and different partitions run concurrently.
+	/// Frequency domains coupled with CoupleFrequencyDomains() share a
+	/// partition, and the events of a partition interact with other
+	/// partitions only by scheduling events for future cycles. Simulation
+	/// results are then identical to those of the sequential engine. An
+	/// event of another partition scheduled for the current cycle raises
+	/// an error.
+	static void setNumThreads(int num_threads);
+
+	/// Return the number of host threads running event handlers
+	static int getNumThreads() { return num_threads; }
+
+	/// Load a partition map for the parallel engine from an INI file. The
+	/// file contains section <tt>[ Partitions ]</tt>, with one variable
+	/// per frequency domain name, and a partition identifier as a value.
+	/// Frequency domains with the same identifier run in the same
+	/// partition. Domains missing in the map get their own partition.
+	static void setPartitionMap(const std::string &path);
+
+	/// Activate the profiler, which records the number of invocations and
+	/// host time of each event handler, the scheduling distance of each
+	/// event type, and the occupancy of the event heap. The profiler
+	/// requires the sequential engine.
+	static void setProfile(bool profile) { Engine::profile = profile; }
+
+	/// Return whether the profiler is active
+	static bool getProfile() { return profile; }
+
+	/// Return the number of partitions of the parallel engine
+	int getNumPartitions() const { return num_partitions; }
+
+	/// Declare that the event handlers of two frequency domains interact
+	/// within a cycle, either through direct function calls or through
+	/// events scheduled for the current cycle. Both domains, and all
+	/// domains sharing a partition with any of them, are placed in the
+	/// same partition of the parallel engine, regardless of the partition
+	/// map. Subsystems call this function when they connect to each other.
+	void CoupleFrequencyDomains(FrequencyDomain *frequency_domain,
+			FrequencyDomain *other_frequency_domain);
+
+	/// Return the number of cycles in which the parallel engine ran
+	/// events of more than one partition concurrently
+	long long getNumParallelWindows() const
+	{
+		return num_parallel_windows;
+	}
+
 	/// Force end of simulation with a specific reason.
 	void Finish(const std::string &reason)
 	{
+		std::lock_guard<std::mutex> lock(finish_mutex);
 		finish = true;
 		finish_reason = reason;
 	}
@@ -186,6 +517,24 @@ public:
 	/// and advances the event-driven simulation time.
 	void ProcessEvents();
 
+	/// Return the time in picoseconds of the earliest pending event, or -1
+	/// if no event is pending.
+	long long getNextEventTime()
+	{
+		return getNumPendingFrames() ? TopPendingFrame()->time : -1;
+	}
+
+	/// Advance the simulation time to \a time without processing the
+	/// cycles in between, which are counted as skipped cycles. The new
+	/// time must be a multiple of the shortest cycle time, and no event
+	/// can be pending before it. This is used by the main simulation loop
+	/// when all timing simulators are idle until some future time.
+	void SkipTime(long long time);
+
+	/// Return the number of cycles of the fastest frequency domain skipped
+	/// with calls to SkipTime().
+	long long getNumSkippedCycles() const { return num_skipped_cycles; }
+
 	/// Function invoked after the main simulation loop has finished. The
 	/// function processes all events remaining in the heap and then runs
 	/// all events that were scheduled for the end of the simulation with
@@ -228,15 +577,16 @@ public:
 	/// event. If no event handler is executing, return `nullptr`.
 	Event *getCurrentEvent() const
 	{
+		const FramePtr<Frame> &current_frame = CurrentFrame();
 		return current_frame == nullptr ? nullptr :
 				current_frame->event;
 	}
 
 	/// If an event handler is currently executing, return the current
 	/// frame. Otherwise, return `nullptr`.
-	const std::shared_ptr<Frame> &getCurrentFrame() const
+	const FramePtr<Frame> &getCurrentFrame() const
 	{
-		return current_frame;
+		return CurrentFrame();
 	}
 
 	/// Register a new frequency domain.
@@ -292,7 +642,7 @@ public:
 	/// not be invoked from outside of this library. Use Call() or Next()
 	/// instead. See Next() for the meaning of the arguments.
 	void Schedule(Event *event,
-			std::shared_ptr<Frame> event_frame,
+			FramePtr<Frame> event_frame,
 			int after = 0,
 			int period = 0);
 
@@ -330,7 +680,7 @@ public:
 	///	Type of event to execute
 	///
 	/// \param event_frame
-	///	Data associated with the event, given as a shared pointer. This
+	///	Data associated with the event, given as a frame pointer. This
 	///	object will be freed automatically when the last reference to
 	///	it disappears.
 	///
@@ -339,7 +689,7 @@ public:
 	///	invocation to Return() will cause \a return_event to be
 	///	scheduled, using the current frame as the event data.
 	///
-	void Execute(Event *event, std::shared_ptr<Frame> event_frame,
+	void Execute(Event *event, FramePtr<Frame> event_frame,
 			Event *return_event);
 
 	/// Schedule an event, creating a new event chain with its new event
@@ -355,7 +705,7 @@ public:
 	///	Type of event to schedule
 	///
 	/// \param frame
-	///	Data associated with the event, given as a shared pointer. This
+	///	Data associated with the event, given as a frame pointer. This
 	///	object will be freed automatically when the last reference to
 	///	it disappears.
 	///
@@ -374,7 +724,7 @@ public:
 	///	respect to the event's frequency domain.
 	///
 	void Call(Event *event,
-			std::shared_ptr<Frame> frame = nullptr,
+			FramePtr<Frame> frame = nullptr,
 			Event *return_event = nullptr,
 			int after = 0,
 			int period = 0);
@@ -399,10 +749,19 @@ public:
 	/// stack. This function should be invoked only within an event handler.
 	Frame *getParentFrame()
 	{
+		const FramePtr<Frame> &current_frame = CurrentFrame();
 		assert(current_frame);
 		return current_frame->parent_frame.get();
 	}
 
+	/// Dump a report of the event-driven simulation engine in INI format,
+	/// including statistics of the allocators for event frames.
+	void DumpReport(std::ostream &os = std::cout) const;
+
+	/// Dump the statistics recorded by the profiler in INI format, with
+	/// event types sorted by decreasing host time.
+	void DumpProfile(std::ostream &os = std::cout) const;
+
 	/// Activate debug information for the event-driven simulator.
 	///
 	/// \param path
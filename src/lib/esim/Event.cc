@@ -23,6 +23,18 @@
 namespace esim
 {
 
+void Event::addSchedule(int after)
+{
+	// Histogram entry: 0 for 0 cycles, or the number of significant bits
+	unsigned index = 0;
+	while (after >> index)
+		index++;
+	if (distance_histogram.size() <= index)
+		distance_histogram.resize(index + 1);
+	distance_histogram[index]++;
+	num_schedules++;
+}
+
 
 }  // namespace esim
 
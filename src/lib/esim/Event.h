@@ -22,6 +22,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 
 namespace esim
@@ -54,6 +55,22 @@ class Event
 	// Current number of scheduled events of this type
 	int num_in_flight = 0;
 
+	// Number of times the event handler ran, only counted when the engine
+	// profiler is active
+	long long num_invocations = 0;
+
+	// Host time in nanoseconds spent in the event handler, only counted
+	// when the engine profiler is active
+	long long host_time = 0;
+
+	// Number of times the event was scheduled, and histogram of the number
+	// of cycles between the scheduling and execution of the event, only
+	// counted when the engine profiler is active. Entry 0 counts events
+	// scheduled for the current cycle, and entry i > 0 counts distances
+	// between 2^(i-1) and 2^i - 1.
+	long long num_schedules = 0;
+	std::vector<long long> distance_histogram;
+
 public:
 
 	/// Constructor
@@ -89,6 +106,36 @@ public:
 
 	/// Decrease the number of in-flight events of this type by one.
 	void decInFlight() { num_in_flight--; }
+
+	/// Record an invocation of the event handler that took \a host_time
+	/// nanoseconds of host time. Used by the engine profiler.
+	void addInvocation(long long host_time)
+	{
+		num_invocations++;
+		this->host_time += host_time;
+	}
+
+	/// Record the scheduling of the event \a after cycles in the future.
+	/// Used by the engine profiler.
+	void addSchedule(int after);
+
+	/// Return the number of invocations recorded by the engine profiler
+	long long getNumInvocations() const { return num_invocations; }
+
+	/// Return the host time in nanoseconds spent in the event handler, as
+	/// recorded by the engine profiler
+	long long getHostTime() const { return host_time; }
+
+	/// Return the number of times the event was scheduled, as recorded by
+	/// the engine profiler
+	long long getNumSchedules() const { return num_schedules; }
+
+	/// Return the histogram of scheduling distances recorded by the engine
+	/// profiler (see addSchedule()).
+	const std::vector<long long> &getDistanceHistogram() const
+	{
+		return distance_histogram;
+	}
 };
 
 }  // namespace esim
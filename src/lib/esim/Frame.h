@@ -20,8 +20,13 @@
 #ifndef LIB_CPP_ESIM_FRAME_H
 #define LIB_CPP_ESIM_FRAME_H
 
-#include <memory>
+#include <cassert>
+#include <cstddef>
+#include <new>
 #include <string>
+#include <utility>
+
+#include "FrameArena.h"
 
 
 namespace esim
@@ -29,6 +34,128 @@ namespace esim
 
 // Forward declarations
 class Event;
+class Frame;
+
+// Reference counting functions for event frames, defined after class Frame.
+inline void RetainFrame(Frame *frame);
+inline void ReleaseFrame(Frame *frame);
+
+
+/// Smart pointer to an event frame of type \a T, which must be Frame or a
+/// class derived from it. The reference count is stored in the frame itself
+/// and is only updated atomically when the simulation engine runs event
+/// handlers on several threads (see FrameArena::setConcurrent()). The
+/// interface mimics the subset of std::shared_ptr used by the simulator.
+/// Frames are created with new_frame().
+template<typename T> class FramePtr
+{
+	// All instantiations access each other's pointer in conversions
+	template<typename U> friend class FramePtr;
+
+	// Frame pointed to, or null
+	T *pointer = nullptr;
+
+public:
+
+	/// Create a null pointer
+	FramePtr() = default;
+
+	/// Create a null pointer
+	FramePtr(std::nullptr_t) { }
+
+	/// Create a pointer to a frame, adding a reference to it
+	explicit FramePtr(T *pointer) : pointer(pointer)
+	{
+		if (pointer)
+			RetainFrame(pointer);
+	}
+
+	/// Copy constructor
+	FramePtr(const FramePtr &other) : pointer(other.pointer)
+	{
+		if (pointer)
+			RetainFrame(pointer);
+	}
+
+	/// Copy constructor from a pointer to a derived frame type
+	template<typename U> FramePtr(const FramePtr<U> &other) :
+			pointer(other.pointer)
+	{
+		if (pointer)
+			RetainFrame(pointer);
+	}
+
+	/// Move constructor
+	FramePtr(FramePtr &&other) : pointer(other.pointer)
+	{
+		other.pointer = nullptr;
+	}
+
+	/// Move constructor from a pointer to a derived frame type
+	template<typename U> FramePtr(FramePtr<U> &&other) :
+			pointer(other.pointer)
+	{
+		other.pointer = nullptr;
+	}
+
+	/// Destructor, releasing the reference to the frame
+	~FramePtr()
+	{
+		if (pointer)
+			ReleaseFrame(pointer);
+	}
+
+	/// Assignment operator, valid for copies and moves
+	FramePtr &operator=(FramePtr other)
+	{
+		std::swap(pointer, other.pointer);
+		return *this;
+	}
+
+	/// Release the reference to the frame, making this pointer null
+	void reset() { FramePtr().swap(*this); }
+
+	/// Exchange the frames pointed to by two pointers
+	void swap(FramePtr &other) { std::swap(pointer, other.pointer); }
+
+	/// Return the frame pointed to
+	T *get() const { return pointer; }
+
+	/// Dereference the pointer
+	T *operator->() const
+	{
+		assert(pointer);
+		return pointer;
+	}
+
+	/// Dereference the pointer
+	T &operator*() const
+	{
+		assert(pointer);
+		return *pointer;
+	}
+
+	/// Return whether the pointer is not null
+	explicit operator bool() const { return pointer != nullptr; }
+
+	/// Compare two pointers
+	template<typename U> bool operator==(const FramePtr<U> &other) const
+	{
+		return pointer == other.pointer;
+	}
+
+	/// Compare two pointers
+	template<typename U> bool operator!=(const FramePtr<U> &other) const
+	{
+		return pointer != other.pointer;
+	}
+
+	/// Compare with null
+	bool operator==(std::nullptr_t) const { return pointer == nullptr; }
+
+	/// Compare with null
+	bool operator!=(std::nullptr_t) const { return pointer != nullptr; }
+};
 
 
 /// This class represents data associated with an event.
@@ -40,6 +167,17 @@ class Frame
 	// this one should not have access to these values.
 	friend class Engine;
 	friend class Queue;
+	friend class TimingWheel;
+	friend void RetainFrame(Frame *frame);
+	friend void ReleaseFrame(Frame *frame);
+	template<typename T, typename... Args> friend FramePtr<T>
+			new_frame(Args&&... args);
+
+	// Number of FramePtr objects pointing to this frame
+	int num_references = 0;
+
+	// Arena where the frame was allocated
+	FrameArena *arena = nullptr;
 
 	// Event associated with this frame when the frame is enqueued in the
 	// event heap.
@@ -64,7 +202,7 @@ class Frame
 	bool in_heap = false;
 
 	// Parent frame is this event was invoked as a call
-	std::shared_ptr<Frame> parent_frame;
+	FramePtr<Frame> parent_frame;
 
 	// Event type to invoke upon return, or null if there is no parent
 	// event
@@ -75,7 +213,7 @@ class Frame
 
 	// Pointer to next frames in a waiting queue, or null if the event
 	// frame is not suspended in a queue.
-	std::shared_ptr<Frame> next;
+	FramePtr<Frame> next;
 
 	// Event type scheduled when the frame is woken up from a queue
 	Event *wakeup_event = nullptr;
@@ -86,8 +224,8 @@ public:
 	// min-heap of the simulation engine.
 	struct CompareSharedPointers
 	{
-		bool operator()(const std::shared_ptr<Frame> &lhs,
-				const std::shared_ptr<Frame> &rhs) const
+		bool operator()(const FramePtr<Frame> &lhs,
+				const FramePtr<Frame> &rhs) const
 		{
 			return lhs->time > rhs->time ||
 					(lhs->time == rhs->time &&
@@ -96,9 +234,18 @@ public:
 		}
 	};
 
+	/// Default constructor
+	Frame() = default;
+
+	/// Frames are shared through FramePtr objects, and cannot be copied
+	Frame(const Frame &) = delete;
+
 	/// Virtual destructor to make class polymorphic
 	virtual ~Frame() { }
 
+	/// Return the number of FramePtr objects pointing to this frame
+	int getNumReferences() const { return num_references; }
+
 	/// Return whether the frame is currently suspended in an event queue.
 	bool isInQueue() const { return in_queue; }
 	
@@ -108,6 +255,66 @@ public:
 };
 
 
+void RetainFrame(Frame *frame)
+{
+	if (FrameArena::isConcurrent())
+		__atomic_add_fetch(&frame->num_references, 1,
+				__ATOMIC_RELAXED);
+	else
+		frame->num_references++;
+}
+
+
+void ReleaseFrame(Frame *frame)
+{
+	// Still referenced
+	assert(frame->num_references > 0);
+	if (FrameArena::isConcurrent())
+	{
+		if (__atomic_sub_fetch(&frame->num_references, 1,
+				__ATOMIC_ACQ_REL))
+			return;
+	}
+	else if (--frame->num_references)
+	{
+		return;
+	}
+
+	// Destroy frame and return its memory to the arena. Frames that were
+	// not created with new_frame() are released with the global delete.
+	FrameArena *arena = frame->arena;
+	if (!arena)
+	{
+		delete frame;
+		return;
+	}
+	frame->~Frame();
+	arena->Free(frame);
+}
+
+
+/// Create a new event frame of type \a T, passing \a args to its
+/// constructor. The frame is allocated in the arena for type \a T and
+/// returned to it when the last FramePtr pointing to it is destroyed.
+template<typename T, typename... Args> FramePtr<T> new_frame(Args&&... args)
+{
+	FrameArena *arena = FrameArena::getInstance<T>();
+	void *memory = arena->Allocate();
+	T *frame;
+	try
+	{
+		frame = new (memory) T(std::forward<Args>(args)...);
+	}
+	catch (...)
+	{
+		arena->Free(memory);
+		throw;
+	}
+	static_cast<Frame *>(frame)->arena = arena;
+	return FramePtr<T>(frame);
+}
+
+
 }  // namespace esim
 
 #endif
@@ -0,0 +1,102 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <mutex>
+
+#include <lib/cpp/String.h>
+
+#include "FrameArena.h"
+
+
+namespace esim
+{
+
+bool FrameArena::concurrent = false;
+
+
+std::vector<FrameArena *> &FrameArena::getArenas()
+{
+	// Never destroyed, like the arenas themselves
+	static std::vector<FrameArena *> *arenas =
+			new std::vector<FrameArena *>();
+	return *arenas;
+}
+
+
+FrameArena::FrameArena(const std::string &name, size_t size)
+{
+	// Demangle type name
+	int status;
+	char *demangled = abi::__cxa_demangle(name.c_str(),
+			nullptr, nullptr, &status);
+	this->name = status == 0 ? demangled : name;
+	free(demangled);
+
+	// Round block size up to keep every block aligned
+	size_t alignment = alignof(std::max_align_t);
+	if (size < sizeof(FreeBlock))
+		size = sizeof(FreeBlock);
+	block_size = (size + alignment - 1) / alignment * alignment;
+
+	// Register arena. Arenas for different frame types can be created
+	// at the same time by event handlers running on different threads.
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> guard(mutex);
+	getArenas().push_back(this);
+}
+
+
+void FrameArena::AllocateSlab()
+{
+	// The global operator new returns memory aligned for any type
+	char *slab = static_cast<char *>(::operator new(
+			block_size * blocks_per_slab));
+	slabs.push_back(slab);
+	slab_next = slab;
+	slab_end = slab + block_size * blocks_per_slab;
+}
+
+
+void FrameArena::DumpReport(std::ostream &os) const
+{
+	os << misc::fmt("[ FrameArena %s ]\n", name.c_str());
+	os << misc::fmt("BlockSize = %d\n", (int) block_size);
+	os << misc::fmt("Slabs = %d\n", (int) slabs.size());
+	os << misc::fmt("Allocations = %lld\n", num_allocations);
+	os << misc::fmt("Hits = %lld\n", num_hits);
+	os << misc::fmt("HitRatio = %.4g\n", num_allocations ?
+			(double) num_hits / num_allocations : 0.0);
+	os << misc::fmt("InUse = %lld\n", getNumInUse());
+	os << misc::fmt("MaxInUse = %lld\n", max_in_use);
+	os << '\n';
+}
+
+
+void FrameArena::DumpReports(std::ostream &os)
+{
+	for (FrameArena *arena : getArenas())
+		arena->DumpReport(os);
+}
+
+
+}  // namespace esim
+
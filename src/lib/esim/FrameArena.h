@@ -0,0 +1,209 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LIB_CPP_ESIM_FRAME_ARENA_H
+#define LIB_CPP_ESIM_FRAME_ARENA_H
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+
+namespace esim
+{
+
+/// Slab allocator for event frames of one specific type. Memory is obtained
+/// from the host in large slabs, and blocks released by dead frames are
+/// kept in a free list to be recycled by the next allocation. Arenas are
+/// never destroyed, since frames may still be alive in the event heap
+/// when static objects are destroyed at the end of the program.
+///
+/// Arenas are only protected by a lock when the simulation engine runs
+/// event handlers on several host threads (see setConcurrent()).
+class FrameArena
+{
+	// Block in the free list. The memory of a free block is reused to
+	// store the pointer to the next free block.
+	struct FreeBlock
+	{
+		FreeBlock *next;
+	};
+
+	// Name of the frame type
+	std::string name;
+
+	// Size of each block in bytes
+	size_t block_size;
+
+	// Number of blocks allocated in each slab
+	static const int blocks_per_slab = 256;
+
+	// Slabs allocated so far
+	std::vector<char *> slabs;
+
+	// Next unused block in the last slab, and end of the last slab
+	char *slab_next = nullptr;
+	char *slab_end = nullptr;
+
+	// Head of the list of free blocks
+	FreeBlock *free_list = nullptr;
+
+	// Number of allocations
+	long long num_allocations = 0;
+
+	// Number of allocations served from the free list
+	long long num_hits = 0;
+
+	// Number of blocks released
+	long long num_frees = 0;
+
+	// Maximum number of blocks in use at the same time
+	long long max_in_use = 0;
+
+	// Lock taken by Allocate() and Free() in concurrent mode
+	std::atomic_flag lock = ATOMIC_FLAG_INIT;
+
+	// Whether frames are allocated and released by several threads
+	static bool concurrent;
+
+	// List of all arenas created
+	static std::vector<FrameArena *> &getArenas();
+
+	// Obtain a new slab from the host when the current one is full
+	void AllocateSlab();
+
+	// Constructor
+	FrameArena(const std::string &name, size_t size);
+
+	// Acquire and release the arena lock
+	void Lock()
+	{
+		while (lock.test_and_set(std::memory_order_acquire))
+			;
+	}
+	void Unlock() { lock.clear(std::memory_order_release); }
+
+	// Allocate a block, assuming exclusive access to the arena
+	void *AllocateUnlocked()
+	{
+		// Update statistics
+		num_allocations++;
+		if (getNumInUse() > max_in_use)
+			max_in_use = getNumInUse();
+
+		// Recycle a block from the free list
+		if (free_list)
+		{
+			num_hits++;
+			FreeBlock *block = free_list;
+			free_list = block->next;
+			return block;
+		}
+
+		// Take a new block from the current slab
+		if (slab_next == slab_end)
+			AllocateSlab();
+		void *block = slab_next;
+		slab_next += block_size;
+		return block;
+	}
+
+	// Release a block, assuming exclusive access to the arena
+	void FreeUnlocked(void *memory)
+	{
+		assert(memory);
+		FreeBlock *block = static_cast<FreeBlock *>(memory);
+		block->next = free_list;
+		free_list = block;
+		num_frees++;
+	}
+
+public:
+
+	/// Return the arena for frames of type \a T, created on first use.
+	template<typename T> static FrameArena *getInstance()
+	{
+		static FrameArena *arena = new FrameArena(
+				typeid(T).name(), sizeof(T));
+		return arena;
+	}
+
+	/// Return the name of the frame type
+	const std::string &getName() const { return name; }
+
+	/// Return the size in bytes of each block
+	size_t getBlockSize() const { return block_size; }
+
+	/// Return the number of allocations
+	long long getNumAllocations() const { return num_allocations; }
+
+	/// Return the number of allocations that recycled a released block
+	long long getNumHits() const { return num_hits; }
+
+	/// Return the number of blocks currently in use
+	long long getNumInUse() const { return num_allocations - num_frees; }
+
+	/// Allocate a block of memory for a frame
+	void *Allocate()
+	{
+		if (!concurrent)
+			return AllocateUnlocked();
+		Lock();
+		void *block = AllocateUnlocked();
+		Unlock();
+		return block;
+	}
+
+	/// Release a block of memory previously returned by Allocate()
+	void Free(void *memory)
+	{
+		if (!concurrent)
+			return FreeUnlocked(memory);
+		Lock();
+		FreeUnlocked(memory);
+		Unlock();
+	}
+
+	/// Select whether frames can be allocated, released, and referenced
+	/// from several host threads at the same time. This also makes the
+	/// reference counts of FramePtr objects atomic. It must only be
+	/// changed while no event handler is running.
+	static void setConcurrent(bool concurrent)
+	{
+		FrameArena::concurrent = concurrent;
+	}
+
+	/// Return whether concurrent mode is enabled
+	static bool isConcurrent() { return concurrent; }
+
+	/// Dump statistics of this arena in INI format
+	void DumpReport(std::ostream &os = std::cout) const;
+
+	/// Dump statistics of all arenas created so far
+	static void DumpReports(std::ostream &os = std::cout);
+};
+
+
+}  // namespace esim
+
+#endif
+
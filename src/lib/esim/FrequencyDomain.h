@@ -47,6 +47,10 @@ class FrequencyDomain
 	// Simulation engine, saved for efficiency
 	Engine *engine;
 
+	// Partition of the parallel simulation engine that runs the events
+	// of this domain
+	int partition = 0;
+
 public:
 
 	/// Constructor
@@ -67,6 +71,14 @@ public:
 	/// Return the cycle time in picoseconds
 	long long getCycleTime() const { return cycle_time; }
 
+	/// Return the partition of the parallel simulation engine that runs
+	/// the events of this domain.
+	int getPartition() const { return partition; }
+
+	/// Set the partition that runs the events of this domain. This
+	/// function is invoked by the engine when the domain is registered.
+	void setPartition(int partition) { this->partition = partition; }
+
 	/// Return the current cycle in this domain, calculated based on the
 	/// current cycle in the event-driven simulation engine and the
 	/// frequency in this domain.
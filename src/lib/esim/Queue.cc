@@ -26,7 +26,7 @@
 namespace esim
 {
 
-void Queue::PushBack(std::shared_ptr<Frame> frame)
+void Queue::PushBack(FramePtr<Frame> frame)
 {
 	// Mark frame as inserted
 	assert(!frame->in_queue);
@@ -49,7 +49,7 @@ void Queue::PushBack(std::shared_ptr<Frame> frame)
 }
 
 
-void Queue::PushFront(std::shared_ptr<Frame> frame)
+void Queue::PushFront(FramePtr<Frame> frame)
 {
 	// Mark frame as inserted
 	assert(!frame->in_queue);
@@ -72,7 +72,7 @@ void Queue::PushFront(std::shared_ptr<Frame> frame)
 }
 
 
-std::shared_ptr<Frame> Queue::PopFront()
+FramePtr<Frame> Queue::PopFront()
 {
 	// Check if queue is empty
 	if (head == nullptr)
@@ -82,7 +82,7 @@ std::shared_ptr<Frame> Queue::PopFront()
 	}
 
 	// Extract element from the head
-	std::shared_ptr<Frame> frame = head;
+	FramePtr<Frame> frame = head;
 	if (head == tail)
 	{
 		head = nullptr;
@@ -104,7 +104,7 @@ void Queue::Wait(Event *event, bool priority)
 {
 	// Get current event frame
 	Engine *engine = Engine::getInstance();
-	std::shared_ptr<Frame> current_frame = engine->getCurrentFrame();
+	FramePtr<Frame> current_frame = engine->getCurrentFrame();
 	
 	// This function must be invoked within an event handler
 	if (current_frame == nullptr)
@@ -139,7 +139,7 @@ void Queue::WakeupOne()
 		throw misc::Panic("Queue is empty");
 
 	// Get event frame from the head
-	std::shared_ptr<Frame> frame = PopFront();
+	FramePtr<Frame> frame = PopFront();
 
 	// Get event to schedule
 	Event *event = frame->wakeup_event;
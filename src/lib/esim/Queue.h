@@ -24,6 +24,7 @@
 #include <memory>
 
 #include "Event.h"
+#include "Frame.h"
 
 
 namespace esim
@@ -36,19 +37,19 @@ namespace esim
 class Queue
 {
 	// Head pointer
-	std::shared_ptr<Frame> head;
+	FramePtr<Frame> head;
 
 	// Tail pointer
-	std::shared_ptr<Frame> tail;
+	FramePtr<Frame> tail;
 
 	// Remove an event frame from the queue.
-	std::shared_ptr<Frame> PopFront();
+	FramePtr<Frame> PopFront();
 
 	// Add an event frame to the tail of the queue
-	void PushBack(std::shared_ptr<Frame> frame);
+	void PushBack(FramePtr<Frame> frame);
 
 	// Add an event frame to the front of the queue
-	void PushFront(std::shared_ptr<Frame> frame);
+	void PushFront(FramePtr<Frame> frame);
 
 public:
 
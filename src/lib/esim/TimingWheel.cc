@@ -0,0 +1,168 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+
+#include "TimingWheel.h"
+
+
+namespace esim
+{
+
+TimingWheel::TimingWheel(int num_buckets, long long bucket_width) :
+		bucket_width(bucket_width)
+{
+	// Round number of buckets up to a power of 2
+	assert(num_buckets > 0);
+	assert(bucket_width > 0);
+	int size = 1;
+	while (size < num_buckets)
+		size <<= 1;
+	buckets.resize(size);
+	mask = size - 1;
+}
+
+
+void TimingWheel::setBucketWidth(long long bucket_width)
+{
+	// Only allowed when empty
+	assert(bucket_width > 0);
+	assert(empty());
+
+	// Realign the cursor to the new bucket size
+	this->bucket_width = bucket_width;
+	base = base / bucket_width * bucket_width;
+	cursor = (base / bucket_width) & mask;
+}
+
+
+void TimingWheel::InsertInBucket(FramePtr<Frame> frame)
+{
+	// Frames scheduled before the start time of the cursor bucket (this
+	// happens with events of slow frequency domains scheduled for the
+	// current cycle) go to the cursor bucket, where they will be sorted
+	// before any later frame.
+	assert(frame->time < getHorizon());
+	long long index = frame->time < base ? cursor :
+			(frame->time / bucket_width) & mask;
+	Bucket &bucket = buckets[index];
+
+	// Common case: frame goes at the end of the bucket. Since schedule
+	// sequence numbers are always increasing, this is always the case
+	// when all frames in the bucket have the same time.
+	auto begin = bucket.frames.begin() + bucket.head;
+	if (bucket.isEmpty() || !Frame::CompareSharedPointers()(
+			bucket.frames.back(), frame))
+	{
+		bucket.frames.emplace_back(std::move(frame));
+	}
+	else
+	{
+		auto position = std::upper_bound(begin, bucket.frames.end(),
+				frame, [](const FramePtr<Frame> &lhs,
+				const FramePtr<Frame> &rhs)
+				{
+					return Frame::CompareSharedPointers()(
+							rhs, lhs);
+				});
+		bucket.frames.emplace(position, std::move(frame));
+	}
+
+	// One more frame
+	num_frames_in_wheel++;
+}
+
+
+void TimingWheel::Advance()
+{
+	// If there is nothing in the buckets, jump straight to the bucket
+	// containing the earliest frame in the overflow heap.
+	if (num_frames_in_wheel == 0)
+	{
+		assert(overflow.size());
+		long long time = overflow.top()->time;
+		base = time / bucket_width * bucket_width;
+		cursor = (time / bucket_width) & mask;
+	}
+
+	// Skip empty buckets, migrating overflow frames that fall into the
+	// horizon every time it moves forward.
+	while (true)
+	{
+		while (overflow.size() && overflow.top()->time < getHorizon())
+		{
+			InsertInBucket(overflow.top());
+			overflow.pop();
+		}
+
+		if (!buckets[cursor].isEmpty())
+			break;
+
+		cursor = (cursor + 1) & mask;
+		base += bucket_width;
+	}
+}
+
+
+void TimingWheel::push(FramePtr<Frame> frame)
+{
+	if (frame->time < getHorizon())
+		InsertInBucket(std::move(frame));
+	else
+		overflow.emplace(std::move(frame));
+}
+
+
+const FramePtr<Frame> &TimingWheel::top()
+{
+	assert(!empty());
+	Bucket &bucket = buckets[cursor];
+	if (bucket.isEmpty())
+	{
+		Advance();
+		return buckets[cursor].frames[buckets[cursor].head];
+	}
+	return bucket.frames[bucket.head];
+}
+
+
+void TimingWheel::pop()
+{
+	// Locate earliest frame
+	assert(!empty());
+	if (buckets[cursor].isEmpty())
+		Advance();
+
+	// Release it
+	Bucket &bucket = buckets[cursor];
+	bucket.frames[bucket.head] = nullptr;
+	bucket.head++;
+	num_frames_in_wheel--;
+
+	// Reuse bucket storage once it becomes empty
+	if (bucket.isEmpty())
+	{
+		bucket.frames.clear();
+		bucket.head = 0;
+	}
+}
+
+
+}  // namespace esim
+
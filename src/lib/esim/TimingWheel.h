@@ -0,0 +1,142 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LIB_CPP_ESIM_TIMING_WHEEL_H
+#define LIB_CPP_ESIM_TIMING_WHEEL_H
+
+#include <cassert>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "Frame.h"
+
+
+namespace esim
+{
+
+/// Bucketed event scheduler (calendar queue) used by the simulation engine as
+/// an alternative to its binary heap of pending events. Frames are hashed
+/// into a circular array of buckets based on their scheduled time. Frames
+/// scheduled beyond the time horizon covered by the wheel are kept in an
+/// overflow heap and migrated into the wheel as simulation time advances.
+///
+/// Frames are extracted in exactly the same order as the event heap would
+/// extract them: by increasing time, and by increasing schedule sequence
+/// number among frames scheduled for the same time.
+class TimingWheel
+{
+	// A bucket is a vector of frames sorted by time and schedule sequence
+	// number. Frames are extracted from position 'head', and the vector is
+	// only cleared when the bucket becomes empty, so that its storage is
+	// reused in steady state.
+	struct Bucket
+	{
+		// Frames in the bucket
+		std::vector<FramePtr<Frame>> frames;
+
+		// Index of the first valid frame in 'frames'
+		unsigned head = 0;
+
+		// Return whether the bucket has no frames
+		bool isEmpty() const { return head == frames.size(); }
+	};
+
+	// Circular array of buckets. Its size is always a power of 2.
+	std::vector<Bucket> buckets;
+
+	// Mask applied to a bucket index to wrap around the array
+	long long mask;
+
+	// Time in picoseconds covered by each bucket
+	long long bucket_width;
+
+	// Start time of the bucket pointed to by 'cursor'. Every frame stored
+	// in the wheel has a time smaller than 'base' + the number of buckets
+	// times 'bucket_width'.
+	long long base = 0;
+
+	// Index of the bucket that contains the earliest frames
+	long long cursor = 0;
+
+	// Number of frames currently stored in the buckets
+	int num_frames_in_wheel = 0;
+
+	// Frames scheduled beyond the time horizon of the wheel
+	std::priority_queue<FramePtr<Frame>,
+			std::vector<FramePtr<Frame>>,
+			Frame::CompareSharedPointers> overflow;
+
+	// Return the time after the last bucket of the wheel
+	long long getHorizon() const
+	{
+		return base + (long long) buckets.size() * bucket_width;
+	}
+
+	// Insert a frame in the bucket that covers its time, keeping the
+	// frames in the bucket sorted.
+	void InsertInBucket(FramePtr<Frame> frame);
+
+	// Move the cursor forward until it points to a non-empty bucket,
+	// migrating frames from the overflow heap as the horizon advances.
+	// The wheel must not be empty.
+	void Advance();
+
+public:
+
+	/// Constructor
+	///
+	/// \param num_buckets
+	///	Number of buckets in the wheel, rounded up to a power of 2.
+	///
+	/// \param bucket_width
+	///	Time interval in picoseconds covered by each bucket. A good
+	///	value is the cycle time of the fastest frequency domain.
+	///
+	TimingWheel(int num_buckets = 1024, long long bucket_width = 1000);
+
+	/// Change the time interval covered by each bucket. This is only
+	/// allowed while the wheel is empty.
+	void setBucketWidth(long long bucket_width);
+
+	/// Return the time interval covered by each bucket
+	long long getBucketWidth() const { return bucket_width; }
+
+	/// Insert a frame. Its time and schedule sequence number must already
+	/// be set.
+	void push(FramePtr<Frame> frame);
+
+	/// Return the earliest frame. The wheel must not be empty.
+	const FramePtr<Frame> &top();
+
+	/// Remove the earliest frame. The wheel must not be empty.
+	void pop();
+
+	/// Return the number of frames in the wheel
+	size_t size() const { return num_frames_in_wheel + overflow.size(); }
+
+	/// Return whether the wheel has no frames
+	bool empty() const { return size() == 0; }
+};
+
+
+}  // namespace esim
+
+#endif
+
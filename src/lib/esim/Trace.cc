@@ -17,6 +17,7 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <cstdio>
 #include <iostream>
 
 #include <lib/cpp/Error.h>
@@ -39,8 +40,11 @@ TraceSystem::~TraceSystem()
 	if (!active)
 		return;
 	
-	// Close ZIP file
-	gzclose(gz_file);
+	// Close ZIP file, or wait for the binary trace writer to finish
+	if (binary_writer)
+		binary_writer = nullptr;
+	else
+		gzclose(gz_file);
 }
 
 
@@ -56,7 +60,7 @@ TraceSystem *TraceSystem::getInstance()
 }
 
 	
-void TraceSystem::setPath(const std::string &path)
+void TraceSystem::setPath(const std::string &path, bool binary)
 {
 	// Trace must not have been activated yet
 	if (active)
@@ -66,6 +70,13 @@ void TraceSystem::setPath(const std::string &path)
 	this->path = path;
 	active = true;
 	
+	// Binary trace
+	if (binary)
+	{
+		binary_writer = misc::new_unique<BinaryTraceWriter>(path);
+		return;
+	}
+
 	// Open ZIP file
 	gz_file = gzopen(path.c_str(), "wt");
 	if (!gz_file)
@@ -74,6 +85,21 @@ void TraceSystem::setPath(const std::string &path)
 }
 
 
+void TraceSystem::WriteCycle()
+{
+	esim::Engine *engine = esim::Engine::getInstance();
+	long long cycle = engine->getCycle();
+	if (cycle > last_cycle)
+	{
+		if (binary_writer)
+			binary_writer->WriteCycle(cycle);
+		else
+			gzprintf(gz_file, "c clk=%lld\n", cycle);
+		last_cycle = cycle;
+	}
+}
+
+
 void TraceSystem::Write(const std::string &s, bool print_cycle)
 {
 	// Trace system must be active
@@ -81,18 +107,106 @@ void TraceSystem::Write(const std::string &s, bool print_cycle)
 	
 	// Print cycle
 	if (print_cycle)
+		WriteCycle();
+
+	// Dump string
+	if (binary_writer)
+		binary_writer->Write(s);
+	else
+		gzwrite(gz_file, s.c_str(), s.length());
+}
+
+
+void TraceSystem::BeginLine(const char *command)
+{
+	assert(active);
+	WriteCycle();
+	if (binary_writer)
 	{
-		esim::Engine *engine = esim::Engine::getInstance();
-		long long cycle = engine->getCycle();
-		if (cycle > last_cycle)
-		{
-			gzprintf(gz_file, "c clk=%lld\n", cycle);
-			last_cycle = cycle;
-		}
+		binary_writer->BeginLine(command);
+		return;
 	}
+	text_line = command;
+}
 
-	// Dump string
-	gzwrite(gz_file, s.c_str(), s.length());
+
+void TraceSystem::AddNumber(const char *key, long long value)
+{
+	if (binary_writer)
+	{
+		binary_writer->AddNumber(key, value);
+		return;
+	}
+	char buffer[24];
+	snprintf(buffer, sizeof buffer, "%lld", value);
+	text_line += ' ';
+	text_line += key;
+	text_line += '=';
+	text_line += buffer;
+}
+
+
+void TraceSystem::AddHex(const char *key, unsigned value)
+{
+	if (binary_writer)
+	{
+		binary_writer->AddHex(key, value);
+		return;
+	}
+	char buffer[16];
+	snprintf(buffer, sizeof buffer, "%x", value);
+	text_line += ' ';
+	text_line += key;
+	text_line += "=0x";
+	text_line += buffer;
+}
+
+
+void TraceSystem::AddQuoted(const char *key, const char *value,
+		size_t length, const char *suffix)
+{
+	if (binary_writer)
+	{
+		binary_writer->AddQuoted(key, value, length, suffix);
+		return;
+	}
+	text_line += ' ';
+	text_line += key;
+	text_line += "=\"";
+	text_line.append(value, length);
+	text_line += suffix;
+	text_line += '"';
+}
+
+
+void TraceSystem::AddName(const char *key, const char *prefix,
+		long long number)
+{
+	if (binary_writer)
+	{
+		binary_writer->AddName(key, prefix, number);
+		return;
+	}
+	char buffer[24];
+	snprintf(buffer, sizeof buffer, "%lld", number);
+	text_line += ' ';
+	text_line += key;
+	text_line += "=\"";
+	text_line += prefix;
+	text_line += buffer;
+	text_line += '"';
+}
+
+
+void TraceSystem::EndLine()
+{
+	if (binary_writer)
+	{
+		binary_writer->EndLine();
+		return;
+	}
+	text_line += '\n';
+	gzwrite(gz_file, text_line.data(), text_line.size());
 }
 
 
@@ -20,17 +20,22 @@
 #ifndef LIB_CPP_ESIM_TRACE_H
 #define LIB_CPP_ESIM_TRACE_H
 
+#include <cstring>
 #include <memory>
 #include <string>
 #include <sstream>
 #include <zlib.h>
 
+#include "TraceWriter.h"
+
 
 namespace esim
 {
 
 class TraceSystem
 {
+	friend class TraceLine;
+
 	// Unique trace system instance
 	static std::unique_ptr<TraceSystem> instance;
 
@@ -40,9 +45,12 @@ class TraceSystem
 	// Flag indicating whether trace is active
 	bool active = false;
 
-	// ZIP file object
+	// ZIP file object, used for text traces
 	gzFile gz_file;
 
+	// Writer of binary traces, or null for a text trace
+	std::unique_ptr<BinaryTraceWriter> binary_writer;
+
 	// Last cycle when a trace message was printed
 	long long last_cycle = -1;
 
@@ -51,6 +59,24 @@ class TraceSystem
 	// message for the cycle. The trace system must be active.
 	void Write(const std::string &s, bool print_cycle = true);
 
+	// Text of the line being built by a TraceLine object, for text traces
+	std::string text_line;
+
+	// Print a line with the current cycle if this is the first message
+	// for it
+	void WriteCycle();
+
+	// Functions used by class TraceLine to build a line, either encoding
+	// its values into the binary trace or formatting them as text. The
+	// trace system must be active.
+	void BeginLine(const char *command);
+	void AddNumber(const char *key, long long value);
+	void AddHex(const char *key, unsigned value);
+	void AddQuoted(const char *key, const char *value, size_t length,
+			const char *suffix);
+	void AddName(const char *key, const char *prefix, long long number);
+	void EndLine();
+
 public:
 
 	/// Return trace system singleton.
@@ -60,8 +86,11 @@ public:
 	~TraceSystem();
 
 	/// Activate the trace system and set the output ZIP trace file to the
-	/// given path.
-	void setPath(const std::string &path);
+	/// given path. If \a binary is true, the trace is written in the
+	/// compact binary format of class BinaryTraceWriter by a background
+	/// thread. Binary traces can be converted to text format with
+	/// BinaryTraceReader.
+	void setPath(const std::string &path, bool binary = false);
 
 	/// Return whether trace system has been activated by the user
 	bool isActive() const { return active; }
@@ -82,6 +111,15 @@ public:
 		// Return reference to this for chaining
 		return *this;
 	}
+
+	/// Dump a string to the trace system, avoiding the conversion done
+	/// for other types.
+	TraceSystem& operator<<(const std::string &s)
+	{
+		if (active)
+			Write(s);
+		return *this;
+	}
 	
 	/// Write a line of output in the beginning of the trace file. This
 	/// function must be invoked before dumping trace information with
@@ -89,6 +127,99 @@ public:
 	void Header(const std::string &s);
 };
 
+/// Line of a trace made of a command followed by key-value pairs, built
+/// from typed values instead of formatted text. Objects are returned by
+/// Trace::Line(), and the line is written when the object is destroyed, so
+/// it is normally used as a temporary:
+///
+/// \code
+///	trace.Line("mem.access")
+///			.Name("name", "A-", frame->getId())
+///			.String("state", module->getName(), ":load_lock");
+/// \endcode
+///
+/// Values are encoded directly into binary traces, without formatting and
+/// parsing them again. Nothing is done if the trace is not active.
+class TraceLine
+{
+	// Trace system where the line is written, or null if the trace is not
+	// active
+	TraceSystem *trace_system;
+
+public:
+
+	/// Constructor, starting a line with the given command if
+	/// \a trace_system is not null
+	TraceLine(TraceSystem *trace_system, const char *command) :
+			trace_system(trace_system)
+	{
+		if (trace_system)
+			trace_system->BeginLine(command);
+	}
+
+	/// Move constructor, transferring the line to the new object
+	TraceLine(TraceLine &&other) : trace_system(other.trace_system)
+	{
+		other.trace_system = nullptr;
+	}
+
+	TraceLine(const TraceLine &) = delete;
+
+	/// Destructor, writing the line
+	~TraceLine()
+	{
+		if (trace_system)
+			trace_system->EndLine();
+	}
+
+	/// Add pair <tt>key=value</tt> with a decimal value
+	TraceLine &Number(const char *key, long long value)
+	{
+		if (trace_system)
+			trace_system->AddNumber(key, value);
+		return *this;
+	}
+
+	/// Add pair <tt>key=0x<value></tt> with a hexadecimal value
+	TraceLine &Hex(const char *key, unsigned value)
+	{
+		if (trace_system)
+			trace_system->AddHex(key, value);
+		return *this;
+	}
+
+	/// Add pair <tt>key="<value><suffix>"</tt>. Neither the value nor the
+	/// suffix can contain quotes.
+	TraceLine &String(const char *key, const char *value,
+			const char *suffix = "")
+	{
+		if (trace_system)
+			trace_system->AddQuoted(key, value, strlen(value),
+					suffix);
+		return *this;
+	}
+
+	/// Add pair <tt>key="<value><suffix>"</tt> with a string object
+	TraceLine &String(const char *key, const std::string &value,
+			const char *suffix = "")
+	{
+		if (trace_system)
+			trace_system->AddQuoted(key, value.data(),
+					value.size(), suffix);
+		return *this;
+	}
+
+	/// Add pair <tt>key="<prefix><number>"</tt>, used for names of
+	/// objects such as <tt>name="A-12"</tt>
+	TraceLine &Name(const char *key, const char *prefix, long long number)
+	{
+		if (trace_system)
+			trace_system->AddName(key, prefix, number);
+		return *this;
+	}
+};
+
+
 class Trace
 {
 	// Flag indicating whether this trace object is active
@@ -136,6 +267,15 @@ public:
 	/// active or not in beforehand, multiple dump \c << calls can be
 	/// saved.
 	operator bool() const { return active && trace_system->isActive(); }
+
+	/// Start a line with the given command, returning an object where
+	/// key-value pairs are added with typed values. The line is written
+	/// when the returned object is destroyed. If the trace is not active,
+	/// the values are ignored without formatting them.
+	TraceLine Line(const char *command)
+	{
+		return TraceLine(*this ? trace_system : nullptr, command);
+	}
 };
 
 
@@ -0,0 +1,704 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <lib/cpp/Error.h>
+#include <lib/cpp/String.h>
+
+#include "TraceWriter.h"
+
+
+namespace esim
+{
+
+//
+// Class 'TraceRingBuffer'
+//
+
+TraceRingBuffer::TraceRingBuffer(size_t size) :
+		write_position(0),
+		read_position(0)
+{
+	size_t rounded_size = 1;
+	while (rounded_size < size)
+		rounded_size <<= 1;
+	buffer.reset(new char[rounded_size]);
+	mask = rounded_size - 1;
+}
+
+
+void TraceRingBuffer::Push(const char *data, size_t length)
+{
+	size_t size = mask + 1;
+	size_t position = write_position.load(std::memory_order_relaxed);
+	while (length)
+	{
+		// Wait for free space
+		size_t free_space;
+		while (!(free_space = size - (position -
+				read_position.load(std::memory_order_acquire))))
+			std::this_thread::yield();
+
+		// Copy up to the end of the buffer
+		size_t offset = position & mask;
+		size_t count = std::min(std::min(length, free_space),
+				size - offset);
+		memcpy(buffer.get() + offset, data, count);
+		data += count;
+		length -= count;
+		position += count;
+		write_position.store(position, std::memory_order_release);
+	}
+}
+
+
+size_t TraceRingBuffer::Peek(const char *&data) const
+{
+	size_t position = read_position.load(std::memory_order_relaxed);
+	size_t available = write_position.load(std::memory_order_acquire) -
+			position;
+	size_t offset = position & mask;
+	data = buffer.get() + offset;
+	return std::min(available, mask + 1 - offset);
+}
+
+
+void TraceRingBuffer::Pop(size_t length)
+{
+	read_position.fetch_add(length, std::memory_order_release);
+}
+
+
+
+
+//
+// Class 'BinaryTraceWriter'
+//
+
+const char BinaryTraceWriter::magic[] = "m2s-binary-trace 1\n";
+
+
+BinaryTraceWriter::BinaryTraceWriter(const std::string &path) :
+		ring_buffer(ring_buffer_size),
+		closing(false)
+{
+	// Open file
+	gz_file = gzopen(path.c_str(), "wb1");
+	if (!gz_file)
+		throw misc::Error(misc::fmt("%s: cannot open trace file",
+				path.c_str()));
+
+	// Start compressor thread
+	gzwrite(gz_file, magic, strlen(magic));
+	compressor = std::thread(&BinaryTraceWriter::CompressorLoop, this);
+}
+
+
+BinaryTraceWriter::~BinaryTraceWriter()
+{
+	// Wait for the compressor thread to write all data
+	Flush();
+	closing = true;
+	compressor.join();
+	gzclose(gz_file);
+}
+
+
+void BinaryTraceWriter::CompressorLoop()
+{
+	while (true)
+	{
+		// Compress all available data. The closing flag is read before
+		// the data, so that no data written before it was set is lost.
+		bool last = closing.load(std::memory_order_acquire);
+		const char *data;
+		size_t length;
+		while ((length = ring_buffer.Peek(data)))
+		{
+			gzwrite(gz_file, data, length);
+			ring_buffer.Pop(length);
+		}
+
+		// Finish, or wait for more data
+		if (last)
+			break;
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+
+void BinaryTraceWriter::AppendVarint(std::string &buffer,
+		unsigned long long value)
+{
+	while (value >= 0x80)
+	{
+		buffer += (char) (value | 0x80);
+		value >>= 7;
+	}
+	buffer += (char) value;
+}
+
+
+void BinaryTraceWriter::GrowStringTable()
+{
+	// Rehash all entries into a table twice as large
+	std::vector<StringEntry> old_table(std::max<size_t>(
+			string_table.size() * 2, 1024), {0, -1, 0, 0});
+	old_table.swap(string_table);
+	unsigned mask = string_table.size() - 1;
+	for (const StringEntry &entry : old_table)
+	{
+		if (entry.number < 0)
+			continue;
+		unsigned index = entry.hash & mask;
+		while (string_table[index].number >= 0)
+			index = (index + 1) & mask;
+		string_table[index] = entry;
+	}
+}
+
+
+int BinaryTraceWriter::Intern(const char *s, size_t length)
+{
+	// FNV-1a hash
+	unsigned hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char) s[i]) * 16777619u;
+
+	// Look up string
+	if (string_table.empty())
+		GrowStringTable();
+	unsigned mask = string_table.size() - 1;
+	unsigned index = hash & mask;
+	while (string_table[index].number >= 0)
+	{
+		const StringEntry &entry = string_table[index];
+		if (entry.hash == hash && entry.length == length &&
+				!memcmp(string_data.data() + entry.offset,
+				s, length))
+			return entry.number;
+		index = (index + 1) & mask;
+	}
+
+	// Table full
+	if (num_strings == max_strings)
+		return -1;
+
+	// New string
+	StringEntry &entry = string_table[index];
+	entry.hash = hash;
+	entry.number = num_strings++;
+	entry.offset = string_data.size();
+	entry.length = length;
+	string_data.append(s, length);
+	records += (char) RecordString;
+	AppendVarint(records, length);
+	records.append(s, length);
+
+	// Keep the table at most half full
+	if (num_strings * 2 > string_table.size())
+		GrowStringTable();
+	return num_strings - 1;
+}
+
+
+int BinaryTraceWriter::InternConstant(const char *s)
+{
+	// Look up address in the cache
+	unsigned index = ((uintptr_t) s >> 3) % constant_cache_size;
+	ConstantEntry &entry = constant_cache[index];
+	if (entry.s == s)
+		return entry.number;
+
+	// Intern the string, replacing the cache entry
+	int number = Intern(s, strlen(s));
+	if (number >= 0)
+	{
+		entry.s = s;
+		entry.number = number;
+	}
+	return number;
+}
+
+
+bool BinaryTraceWriter::EncodeLine(const char *line, size_t length)
+{
+	line_record.clear();
+	line_record += (char) RecordLine;
+	size_t position = 0;
+	while (true)
+	{
+		// Find the end of the token, which is the next space that is
+		// not between quotes.
+		size_t start = position;
+		size_t equal = 0;
+		bool quoted = false;
+		while (position < length && (quoted || line[position] != ' '))
+		{
+			if (line[position] == '"')
+				quoted = !quoted;
+			else if (line[position] == '=' && !equal && !quoted)
+				equal = position;
+			position++;
+		}
+
+		// Tokens are separated by exactly one space
+		if (position == start)
+			return false;
+
+		// Token without a value
+		if (!equal)
+		{
+			int number = Intern(line + start, position - start);
+			if (number < 0)
+				return false;
+			line_record += (char) TokenWord;
+			AppendVarint(line_record, number);
+		}
+		else
+		{
+			// Key
+			int key = Intern(line + start, equal - start);
+			if (key < 0)
+				return false;
+
+			// Decimal value without leading zeros that fits in
+			// 64 bits
+			const char *value = line + equal + 1;
+			size_t value_length = line + position - value;
+			size_t first_digit = value_length && value[0] == '-';
+			bool is_number = value_length > first_digit &&
+					value_length - first_digit <= 18 &&
+					(value[first_digit] != '0' ||
+					value_length == 1);
+			long long number = 0;
+			for (size_t i = first_digit; i < value_length &&
+					is_number; i++)
+			{
+				is_number = value[i] >= '0' && value[i] <= '9';
+				number = number * 10 + value[i] - '0';
+			}
+
+			if (is_number)
+			{
+				if (first_digit)
+					number = -number;
+				line_record += (char) TokenNumber;
+				AppendVarint(line_record, key);
+				AppendVarint(line_record, ((unsigned long long)
+						number << 1) ^ (number >> 63));
+			}
+			else
+			{
+				int number = Intern(value, value_length);
+				if (number < 0)
+				{
+					line_record += (char) TokenLiteral;
+					AppendVarint(line_record, key);
+					AppendVarint(line_record, value_length);
+					line_record.append(value, value_length);
+				}
+				else
+				{
+					line_record += (char) TokenString;
+					AppendVarint(line_record, key);
+					AppendVarint(line_record, number);
+				}
+			}
+		}
+
+		// End of line
+		if (position == length)
+			break;
+		position++;
+	}
+	line_record += (char) TokenEnd;
+	return true;
+}
+
+
+void BinaryTraceWriter::Flush()
+{
+	ring_buffer.Push(records.data(), records.size());
+	records.clear();
+}
+
+
+void BinaryTraceWriter::WriteCycle(long long cycle)
+{
+	assert(cycle >= last_cycle);
+	records += (char) RecordCycle;
+	AppendVarint(records, cycle - last_cycle);
+	last_cycle = cycle;
+}
+
+
+void BinaryTraceWriter::Write(const std::string &message)
+{
+	size_t position = 0;
+	while (position < message.size())
+	{
+		// Encode one line, or copy it verbatim if it does not follow
+		// the format of a line or is not terminated by a newline.
+		// String definitions created while encoding the line are
+		// already in 'records', ahead of the line itself.
+		size_t end = message.find('\n', position);
+		if (end != std::string::npos && EncodeLine(message.data() +
+				position, end - position))
+		{
+			records += line_record;
+		}
+		else
+		{
+			if (end == std::string::npos)
+				end = message.size() - 1;
+			records += (char) RecordRaw;
+			AppendVarint(records, end + 1 - position);
+			records.append(message, position, end + 1 - position);
+		}
+		position = end + 1;
+	}
+
+	// Hand over large enough chunks to the compressor thread
+	if (records.size() >= flush_size)
+		Flush();
+}
+
+
+void BinaryTraceWriter::AppendText(const std::string &token)
+{
+	line_record += (char) TokenText;
+	AppendVarint(line_record, token.size());
+	line_record += token;
+}
+
+
+void BinaryTraceWriter::BeginLine(const char *command)
+{
+	line_record.clear();
+	line_record += (char) RecordLine;
+	int number = InternConstant(command);
+	if (number < 0)
+	{
+		AppendText(command);
+		return;
+	}
+	line_record += (char) TokenWord;
+	AppendVarint(line_record, number);
+}
+
+
+void BinaryTraceWriter::AddNumber(const char *key, long long value)
+{
+	int key_number = InternConstant(key);
+	if (key_number < 0)
+	{
+		AppendText(misc::fmt("%s=%lld", key, value));
+		return;
+	}
+	line_record += (char) TokenNumber;
+	AppendVarint(line_record, key_number);
+	AppendVarint(line_record, ((unsigned long long) value << 1) ^
+			(value >> 63));
+}
+
+
+void BinaryTraceWriter::AddHex(const char *key, unsigned value)
+{
+	int key_number = InternConstant(key);
+	if (key_number < 0)
+	{
+		AppendText(misc::fmt("%s=0x%x", key, value));
+		return;
+	}
+	line_record += (char) TokenHex;
+	AppendVarint(line_record, key_number);
+	AppendVarint(line_record, value);
+}
+
+
+void BinaryTraceWriter::AddQuoted(const char *key, const char *value,
+		size_t length, const char *suffix)
+{
+	int key_number = InternConstant(key);
+	int value_number = Intern(value, length);
+	int suffix_number = InternConstant(suffix);
+	if (key_number < 0 || value_number < 0 || suffix_number < 0)
+	{
+		AppendText(misc::fmt("%s=\"%s%s\"", key,
+				std::string(value, length).c_str(), suffix));
+		return;
+	}
+	line_record += (char) TokenQuoted;
+	AppendVarint(line_record, key_number);
+	AppendVarint(line_record, value_number);
+	AppendVarint(line_record, suffix_number);
+}
+
+
+void BinaryTraceWriter::AddName(const char *key, const char *prefix,
+		long long number)
+{
+	int key_number = InternConstant(key);
+	int prefix_number = InternConstant(prefix);
+	if (key_number < 0 || prefix_number < 0)
+	{
+		AppendText(misc::fmt("%s=\"%s%lld\"", key, prefix, number));
+		return;
+	}
+	line_record += (char) TokenName;
+	AppendVarint(line_record, key_number);
+	AppendVarint(line_record, prefix_number);
+	AppendVarint(line_record, ((unsigned long long) number << 1) ^
+			(number >> 63));
+}
+
+
+void BinaryTraceWriter::EndLine()
+{
+	// String definitions created while encoding the line are already in
+	// 'records', ahead of the line itself.
+	line_record += (char) TokenEnd;
+	records += line_record;
+
+	// Hand over large enough chunks to the compressor thread
+	if (records.size() >= flush_size)
+		Flush();
+}
+
+
+
+
+//
+// Class 'BinaryTraceReader'
+//
+
+BinaryTraceReader::BinaryTraceReader(const std::string &path) :
+		buffer(1 << 16)
+{
+	// Open file
+	gz_file = gzopen(path.c_str(), "rb");
+	if (!gz_file)
+		throw misc::Error(misc::fmt("%s: cannot open trace file",
+				path.c_str()));
+
+	// Check magic string
+	for (const char *c = BinaryTraceWriter::magic; *c; c++)
+	{
+		if (ReadByte() != *c)
+		{
+			gzclose(gz_file);
+			throw misc::Error(misc::fmt("%s: not a binary trace",
+					path.c_str()));
+		}
+	}
+}
+
+
+BinaryTraceReader::~BinaryTraceReader()
+{
+	gzclose(gz_file);
+}
+
+
+bool BinaryTraceReader::isBinaryTrace(const std::string &path)
+{
+	gzFile gz_file = gzopen(path.c_str(), "rb");
+	if (!gz_file)
+		return false;
+	size_t length = strlen(BinaryTraceWriter::magic);
+	std::vector<char> data(length);
+	bool result = gzread(gz_file, data.data(), length) == (int) length &&
+			!memcmp(data.data(), BinaryTraceWriter::magic, length);
+	gzclose(gz_file);
+	return result;
+}
+
+
+bool BinaryTraceReader::FillBuffer()
+{
+	int length = gzread(gz_file, buffer.data(), buffer.size());
+	if (length <= 0)
+		return false;
+	buffer_position = 0;
+	buffer_length = length;
+	return true;
+}
+
+
+unsigned long long BinaryTraceReader::ReadVarint()
+{
+	unsigned long long value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int c = ReadByte();
+		if (c < 0)
+			throw misc::Error("Truncated binary trace");
+		value |= (unsigned long long) (c & 0x7f) << shift;
+		if (!(c & 0x80))
+			return value;
+	}
+	throw misc::Error("Corrupted binary trace");
+}
+
+
+std::string BinaryTraceReader::ReadString()
+{
+	unsigned long long length = ReadVarint();
+	std::string s;
+	s.reserve(length);
+	for (unsigned long long i = 0; i < length; i++)
+	{
+		int c = ReadByte();
+		if (c < 0)
+			throw misc::Error("Truncated binary trace");
+		s += (char) c;
+	}
+	return s;
+}
+
+
+const std::string &BinaryTraceReader::ReadStringNumber()
+{
+	unsigned long long number = ReadVarint();
+	if (number >= strings.size())
+		throw misc::Error("Corrupted binary trace");
+	return strings[number];
+}
+
+
+void BinaryTraceReader::Convert(std::ostream &os)
+{
+	long long cycle = 0;
+	int kind;
+	while ((kind = ReadByte()) >= 0)
+	{
+		switch (kind)
+		{
+
+		case BinaryTraceWriter::RecordCycle:
+
+			cycle += ReadVarint();
+			os << "c clk=" << cycle << '\n';
+			break;
+
+		case BinaryTraceWriter::RecordString:
+
+			strings.push_back(ReadString());
+			break;
+
+		case BinaryTraceWriter::RecordRaw:
+
+			os << ReadString();
+			break;
+
+		case BinaryTraceWriter::RecordLine:
+		{
+			bool first = true;
+			while ((kind = ReadByte()) != BinaryTraceWriter::TokenEnd)
+			{
+				// Separator
+				if (!first)
+					os << ' ';
+				first = false;
+
+				// Token
+				switch (kind)
+				{
+
+				case BinaryTraceWriter::TokenWord:
+
+					os << ReadStringNumber();
+					break;
+
+				case BinaryTraceWriter::TokenNumber:
+				{
+					os << ReadStringNumber() << '=';
+					unsigned long long value = ReadVarint();
+					os << (long long) ((value >> 1) ^
+							-(value & 1));
+					break;
+				}
+
+				case BinaryTraceWriter::TokenString:
+
+					os << ReadStringNumber() << '=';
+					os << ReadStringNumber();
+					break;
+
+				case BinaryTraceWriter::TokenLiteral:
+
+					os << ReadStringNumber() << '=';
+					os << ReadString();
+					break;
+
+				case BinaryTraceWriter::TokenHex:
+
+					os << ReadStringNumber() << "=0x";
+					os << std::hex << ReadVarint() << std::dec;
+					break;
+
+				case BinaryTraceWriter::TokenQuoted:
+
+					os << ReadStringNumber() << "=\"";
+					os << ReadStringNumber();
+					os << ReadStringNumber() << '"';
+					break;
+
+				case BinaryTraceWriter::TokenName:
+				{
+					os << ReadStringNumber() << "=\"";
+					os << ReadStringNumber();
+					unsigned long long value = ReadVarint();
+					os << (long long) ((value >> 1) ^
+							-(value & 1)) << '"';
+					break;
+				}
+
+				case BinaryTraceWriter::TokenText:
+
+					os << ReadString();
+					break;
+
+				default:
+
+					throw misc::Error("Corrupted binary "
+							"trace");
+				}
+			}
+			os << '\n';
+			break;
+		}
+
+		default:
+
+			throw misc::Error("Corrupted binary trace");
+		}
+	}
+}
+
+
+}  // namespace esim
+
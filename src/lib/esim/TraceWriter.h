@@ -0,0 +1,336 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LIB_CPP_ESIM_TRACE_WRITER_H
+#define LIB_CPP_ESIM_TRACE_WRITER_H
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+
+namespace esim
+{
+
+/// Ring buffer of bytes with one producer thread and one consumer thread,
+/// synchronized without locks. Each thread only modifies its own position.
+class TraceRingBuffer
+{
+	// Buffer storage
+	std::unique_ptr<char[]> buffer;
+
+	// Size of the buffer, always a power of 2, minus one
+	size_t mask;
+
+	// Total number of bytes written by the producer and read by the
+	// consumer. Positions in the buffer are taken modulo its size.
+	std::atomic<size_t> write_position;
+	std::atomic<size_t> read_position;
+
+public:
+
+	/// Constructor. The size is rounded up to a power of 2.
+	TraceRingBuffer(size_t size);
+
+	/// Copy \a length bytes into the buffer, waiting for the consumer to
+	/// release space while the buffer is full. Invoked by the producer.
+	void Push(const char *data, size_t length);
+
+	/// Return the number of bytes that can be read contiguously, and
+	/// set \a data to point to them. Invoked by the consumer.
+	size_t Peek(const char *&data) const;
+
+	/// Release \a length bytes returned by Peek(). Invoked by the
+	/// consumer.
+	void Pop(size_t length);
+};
+
+
+/// Writer of binary traces. Messages are encoded by the simulation thread,
+/// and the encoded records are passed through a ring buffer to a background
+/// thread, which compresses them into the trace file.
+///
+/// A binary trace is a gzip-compressed file that starts with a magic
+/// string, followed by records. Each record starts with a byte identifying
+/// its kind. Integers are encoded as variable-length integers (7 bits per
+/// byte, least significant first), and signed values are zigzag-encoded
+/// first.
+///
+/// - RecordCycle: the increase of the cycle number since the last cycle
+///   record, decoded as <tt>c clk=<cycle></tt>.
+///
+/// - RecordString: the length and characters of a string. Strings are
+///   numbered from 0 in the order in which they are defined.
+///
+/// - RecordLine: a line of text made of tokens separated by one space.
+///   Each token is TokenWord followed by a string number, TokenNumber
+///   followed by the string number of a key and a signed value (<tt>
+///   key=value</tt>), TokenString followed by the string numbers of a key
+///   and a value, or TokenLiteral followed by the string number of a key
+///   and the length and characters of a value that was not interned. Lines
+///   written with the typed functions (BeginLine(), AddNumber(), etc.) can
+///   also contain TokenHex followed by the string number of a key and an
+///   unsigned value (<tt>key=0x<hex></tt>), TokenQuoted followed by the
+///   string numbers of a key, a value, and a suffix (<tt>
+///   key="<value><suffix>"</tt>), TokenName followed by the string numbers
+///   of a key and a prefix, and a signed value (<tt>
+///   key="<prefix><value>"</tt>), or TokenText followed by the length and
+///   characters of a token copied verbatim. The line ends with TokenEnd.
+///
+/// - RecordRaw: the length and characters of text that does not follow
+///   the format of a line, copied verbatim.
+///
+class BinaryTraceWriter
+{
+public:
+
+	/// Kinds of records
+	enum RecordKind
+	{
+		RecordInvalid = 0,
+		RecordCycle,
+		RecordString,
+		RecordLine,
+		RecordRaw
+	};
+
+	/// Kinds of tokens in a line record
+	enum TokenKind
+	{
+		TokenWord = 0x10,
+		TokenNumber,
+		TokenString,
+		TokenLiteral,
+		TokenHex,
+		TokenQuoted,
+		TokenName,
+		TokenText,
+		TokenEnd = 0x1f
+	};
+
+	/// Magic string at the beginning of a binary trace
+	static const char magic[];
+
+private:
+
+	// Maximum number of interned strings. Once reached, new values are
+	// written as literals.
+	static const unsigned max_strings = 1 << 20;
+
+	// Size of the ring buffer
+	static const size_t ring_buffer_size = 8 << 20;
+
+	// Compressed output file
+	gzFile gz_file;
+
+	// Buffer between the simulation and the compressor thread
+	TraceRingBuffer ring_buffer;
+
+	// Compressor thread
+	std::thread compressor;
+
+	// Set when the compressor thread must write all remaining data and
+	// finish
+	std::atomic<bool> closing;
+
+	// Minimum amount of encoded data sent to the compressor thread at once
+	static const size_t flush_size = 1 << 16;
+
+	// Entry of the hash table of interned strings
+	struct StringEntry
+	{
+		// Hash of the string
+		unsigned hash;
+
+		// String number, or -1 for an empty entry
+		int number;
+
+		// Position and length of the characters in 'string_data'
+		size_t offset;
+		size_t length;
+	};
+
+	// Open-addressing hash table of interned strings. Its size is always
+	// a power of 2, and is kept at least twice the number of strings.
+	std::vector<StringEntry> string_table;
+
+	// Characters of all interned strings
+	std::string string_data;
+
+	// Number of interned strings
+	unsigned num_strings = 0;
+
+	// Last cycle written in a cycle record
+	long long last_cycle = 0;
+
+	// Encoded records not sent to the compressor thread yet. String
+	// definitions are appended here as soon as they are created.
+	std::string records;
+
+	// Encoded tokens of the line being encoded
+	std::string line_record;
+
+	// Append a variable-length integer to a buffer
+	static void AppendVarint(std::string &buffer, unsigned long long value);
+
+	// Double the size of the hash table of interned strings
+	void GrowStringTable();
+
+	// Return the number of an interned string, adding a string definition
+	// record if it is new, or -1 if the maximum number of interned strings
+	// was reached.
+	int Intern(const char *s, size_t length);
+
+	// Entry of the cache of interned constant strings
+	struct ConstantEntry
+	{
+		// Address of the string, or null for an empty entry
+		const char *s;
+
+		// String number
+		int number;
+	};
+
+	// Number of entries in the cache of interned constant strings
+	static const unsigned constant_cache_size = 256;
+
+	// Cache of interned constant strings, indexed by their address. Keys,
+	// commands, prefixes, and suffixes of lines written with the typed
+	// functions are string literals, so their numbers are found here
+	// without hashing their characters on every line.
+	ConstantEntry constant_cache[constant_cache_size] = {};
+
+	// Return the number of an interned constant string, as Intern()
+	int InternConstant(const char *s);
+
+	// Encode one line, not including the final newline character, into
+	// 'line_record'. Return false if it does not follow the format of a
+	// line.
+	bool EncodeLine(const char *line, size_t length);
+
+	// Append a token copied verbatim to 'line_record', used by the typed
+	// functions when the maximum number of interned strings was reached
+	void AppendText(const std::string &token);
+
+	// Send the encoded records to the compressor thread
+	void Flush();
+
+	// Main function of the compressor thread
+	void CompressorLoop();
+
+public:
+
+	/// Create the trace file
+	BinaryTraceWriter(const std::string &path);
+
+	/// Write remaining data and close the trace file
+	~BinaryTraceWriter();
+
+	/// Write a cycle record. Cycles must be increasing.
+	void WriteCycle(long long cycle);
+
+	/// Write a message made of zero or more lines
+	void Write(const std::string &message);
+
+	/// Start a line with the given command. The line is written by a call
+	/// to EndLine() after adding its key-value pairs with the following
+	/// functions, which encode values directly instead of parsing text
+	/// produced by Write(). Commands, keys, prefixes, and suffixes must be
+	/// string literals, since their numbers are cached by address.
+	void BeginLine(const char *command);
+
+	/// Add pair <tt>key=value</tt> with a decimal value
+	void AddNumber(const char *key, long long value);
+
+	/// Add pair <tt>key=0x<value></tt> with a hexadecimal value
+	void AddHex(const char *key, unsigned value);
+
+	/// Add pair <tt>key="<value><suffix>"</tt>. Neither the value nor the
+	/// suffix can contain quotes.
+	void AddQuoted(const char *key, const char *value, size_t length,
+			const char *suffix);
+
+	/// Add pair <tt>key="<prefix><number>"</tt>
+	void AddName(const char *key, const char *prefix, long long number);
+
+	/// Write the line started with BeginLine()
+	void EndLine();
+};
+
+
+/// Reader of binary traces, converting them to the text format consumed by
+/// the visualization tool.
+class BinaryTraceReader
+{
+	// Compressed input file
+	gzFile gz_file;
+
+	// Input buffer
+	std::vector<unsigned char> buffer;
+	int buffer_position = 0;
+	int buffer_length = 0;
+
+	// Interned strings
+	std::vector<std::string> strings;
+
+	// Return the next byte of the file, or -1 at the end of the file
+	int ReadByte()
+	{
+		if (buffer_position == buffer_length && !FillBuffer())
+			return -1;
+		return buffer[buffer_position++];
+	}
+
+	// Read more data into the buffer. Return false at the end of the file.
+	bool FillBuffer();
+
+	// Read a variable-length integer
+	unsigned long long ReadVarint();
+
+	// Read the length and characters of a string
+	std::string ReadString();
+
+	// Read a string number and return the interned string
+	const std::string &ReadStringNumber();
+
+public:
+
+	/// Open a binary trace. An exception is thrown if the file cannot be
+	/// opened or is not a binary trace.
+	BinaryTraceReader(const std::string &path);
+
+	/// Close the trace
+	~BinaryTraceReader();
+
+	/// Return whether a file is a binary trace
+	static bool isBinaryTrace(const std::string &path);
+
+	/// Convert the whole trace into the text format
+	void Convert(std::ostream &os);
+};
+
+
+}  // namespace esim
+
+#endif
+
@@ -18,8 +18,10 @@
  */
 
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <sys/time.h>
+#include <unistd.h>
 
 #include <arch/common/CallStack.h>
 #include <arch/common/Driver.h>
@@ -48,6 +50,7 @@
 #include <memory/Manager.h>
 #include <memory/System.h>
 #include <network/System.h>
+#include <lib/cpp/Checkpoint.h>
 #include <lib/cpp/CommandLine.h>
 #include <lib/cpp/Environment.h>
 #include <lib/cpp/IniFile.h>
@@ -73,12 +76,33 @@ std::string m2s_cuda_debug;
 // Event-driven simulator debugger
 std::string m2s_debug_esim;
 
+// Report for the event-driven simulator
+std::string m2s_esim_report;
+
+// Profile of the event-driven simulator
+std::string m2s_esim_profile;
+
+// Data structure for pending events in the event-driven simulator
+esim::Engine::SchedulerKind m2s_esim_scheduler = esim::Engine::SchedulerHeap;
+
+// Fast-forward idle cycles in the main simulation loop
+bool m2s_esim_skip_idle = false;
+
+// Number of host threads running event handlers
+int m2s_esim_threads = 1;
+
+// Partition map for the parallel event-driven simulator
+std::string m2s_esim_partition_map;
+
 // Inifile debugger
 std::string m2s_debug_inifile;
 
 // Call stack debugger
 std::string m2s_debug_callstack;
 
+// Checkpoint to restore guest programs from
+std::string m2s_load_checkpoint;
+
 // Maximum simulation time
 long long m2s_max_time = 0;
 
@@ -91,9 +115,27 @@ std::string m2s_opencl_debug;
 // List of OpenCL devices for runtime
 std::string m2s_opencl_devices;
 
+// Checkpoint file to save guest programs into
+std::string m2s_save_checkpoint;
+
+// Number of x86 instructions after which the checkpoint is saved
+long long m2s_save_checkpoint_inst = 0;
+
+// Checkpoint file to save guest programs into after a simulation cycle
+std::string m2s_save_checkpoint_cycle_file;
+
+// Cycle after which the checkpoint is saved
+long long m2s_save_checkpoint_cycle = 0;
+
 // Trace file
 std::string m2s_trace_file;
 
+// Write the trace file in binary format
+bool m2s_trace_binary = false;
+
+// Binary trace to convert into text format
+std::string m2s_trace_to_text;
+
 // Visualization tool input file
 std::string m2s_visual_file;
 
@@ -237,6 +279,48 @@ void LoadPrograms()
 }
 
 
+// Restore guest programs from a checkpoint
+void LoadCheckpoint()
+{
+	// Guest programs must only come from the checkpoint
+	misc::CommandLine *command_line = misc::CommandLine::getInstance();
+	if (command_line->getNumArguments() || !m2s_context_config.empty())
+		throw misc::Error("Option '--load-checkpoint' cannot be used "
+				"together with a program executable or a "
+				"context configuration file");
+
+	// Load architectures
+	misc::CheckpointReader reader(m2s_load_checkpoint);
+	x86::Emulator::getInstance()->LoadCheckpoint(reader);
+	if (reader.ReadValue<bool>())
+		SI::Emulator::getInstance()->LoadCheckpoint(reader);
+}
+
+
+// Save guest programs into a checkpoint
+void SaveCheckpoint()
+{
+	try
+	{
+		// The Southern Islands emulator is only saved if it was
+		// created by the guest program.
+		misc::CheckpointWriter writer(m2s_save_checkpoint);
+		x86::Emulator::getInstance()->SaveCheckpoint(writer);
+		comm::ArchPool *arch_pool = comm::ArchPool::getInstance();
+		comm::Arch *arch = arch_pool->getByName("SouthernIslands");
+		writer.WriteValue<bool>(arch && arch->getEmulator());
+		if (arch && arch->getEmulator())
+			SI::Emulator::getInstance()->SaveCheckpoint(writer);
+	}
+	catch (...)
+	{
+		// Do not leave an incomplete checkpoint behind
+		unlink(m2s_save_checkpoint.c_str());
+		throw;
+	}
+}
+
+
 void RegisterOptions()
 {
 	// Set error message
@@ -285,6 +369,86 @@ void RegisterOptions()
 			m2s_debug_esim,
 			"Dump debug information related with the event-driven "
 			"simulation engine.");
+
+	// Report for event-driven simulator
+	command_line->RegisterString("--esim-report <file>",
+			m2s_esim_report,
+			"File to dump a report of the event-driven simulation "
+			"engine at the end of the simulation, including the "
+			"number of processed events and statistics of the "
+			"allocators for event frames, such as their hit ratio "
+			"in recycling released frames.");
+
+	// Profile for event-driven simulator
+	command_line->RegisterString("--esim-profile <file>",
+			m2s_esim_profile,
+			"File to dump a profile of the event-driven simulation "
+			"engine at the end of the simulation. For each event "
+			"type, the profile shows the number of invocations, "
+			"the host time spent in its handler, and a histogram "
+			"of the number of cycles ahead it was scheduled. It "
+			"also includes a histogram of the number of pending "
+			"events. The profiler forces a single simulation "
+			"thread (see --esim-threads).");
+
+	// Event scheduler
+	command_line->RegisterEnum("--esim-scheduler {heap|wheel} "
+			"(default = heap)",
+			(int &) m2s_esim_scheduler,
+			esim::Engine::SchedulerKindMap,
+			"Data structure used by the event-driven simulation "
+			"engine to keep pending events sorted by time. Option "
+			"'heap' uses a binary heap, while 'wheel' uses a "
+			"bucketed timing wheel that schedules events in "
+			"constant time, which is faster when many events are "
+			"in flight. Both produce the same simulation results.");
+
+	// Idle-cycle fast-forwarding
+	command_line->RegisterBool("--esim-skip-idle",
+			m2s_esim_skip_idle,
+			"Skip the iterations of the main simulation loop in "
+			"which all timing simulators are stalled waiting for "
+			"an event, such as a long-latency memory access. "
+			"Simulation time jumps straight to the next pending "
+			"event without changing simulation results. The "
+			"number of skipped cycles is shown in the statistics "
+			"summary and the simulation reports.");
+
+	// Parallel event-driven simulation
+	command_line->RegisterInt32("--esim-threads <num> (default = 1)",
+			m2s_esim_threads,
+			"Number of host threads running the event handlers of "
+			"the event-driven simulation engine. With more than "
+			"one thread, events are divided in partitions by "
+			"frequency domain, and the events of different "
+			"partitions scheduled for the same cycle run "
+			"concurrently. Frequency domains that interact within "
+			"a cycle share a partition: an architecture under "
+			"detailed simulation, the memory hierarchy it accesses, "
+			"and its networks always run in one partition, so "
+			"only independent frequency domains run in parallel. "
+			"Simulation results are identical to those of a single "
+			"thread. An event of one partition scheduling an "
+			"event of another for the current cycle stops "
+			"simulation with an error; use --esim-partition-map "
+			"to place both frequency domains in one partition. "
+			"The option has no effect when a trace file or debug "
+			"information for the engine is dumped, and debug "
+			"information of other modules is not guaranteed to "
+			"follow simulation order.");
+
+	// Partition map
+	command_line->RegisterString("--esim-partition-map <file>",
+			m2s_esim_partition_map,
+			"INI file assigning frequency domains to partitions "
+			"of the parallel event-driven simulation engine (see "
+			"--esim-threads). Section [ Partitions ] contains one "
+			"variable per frequency domain name (e.g., 'x86', "
+			"'Memory', or 'network'), whose value is a partition "
+			"identifier. Domains with the same identifier run in "
+			"the same partition, and domains not listed get a "
+			"partition of their own. Domains that interact within "
+			"a cycle share a partition regardless of the map.");
 	
 	// Debugger for Inifile parser
 	command_line->RegisterString("--inifile-debug <file>",
@@ -292,6 +456,16 @@ void RegisterOptions()
 			"Dump debug information about all processed INI files "
 			"into the specified path.");
 	
+	// Restore from checkpoint
+	command_line->RegisterString("--load-checkpoint <file>",
+			m2s_load_checkpoint,
+			"Restore the guest programs from a checkpoint created "
+			"with option '--save-checkpoint', instead of loading a "
+			"program executable. The simulation resumes in the "
+			"simulation mode selected for each architecture, so "
+			"a checkpoint taken during functional simulation can "
+			"be used to start a detailed simulation.");
+	
 	// Maximum simulation time
 	command_line->RegisterInt64("--max-time <time> (default = 0)",
 			m2s_max_time,
@@ -299,6 +473,35 @@ void RegisterOptions()
 			"will stop once this time is exceeded. A value of 0 "
 			"(default) means no time limit.");
 	
+	// Save checkpoint
+	command_line->RegisterInt64String("--save-checkpoint <inst> <file>",
+			m2s_save_checkpoint_inst,
+			m2s_save_checkpoint,
+			"Save the state of the guest programs into a "
+			"checkpoint file once the x86 emulator has executed "
+			"<inst> instructions, and finish the simulation. The "
+			"checkpoint is taken at the first point after that in "
+			"which no context runs speculatively or waits for a "
+			"host resource. It contains the registers, memory "
+			"images, open files, and signal state of all x86 "
+			"contexts, as well as the Southern Islands video "
+			"memory. Use option '--load-checkpoint' to resume.");
+	
+	// Save checkpoint at a simulation cycle
+	command_line->RegisterInt64String("--save-checkpoint-cycle "
+			"<cycle> <file>",
+			m2s_save_checkpoint_cycle,
+			m2s_save_checkpoint_cycle_file,
+			"Same as option '--save-checkpoint', but saving the "
+			"checkpoint once the simulation reaches cycle <cycle> "
+			"instead of a number of x86 instructions. Cycles only "
+			"advance while an architecture runs a detailed "
+			"simulation, so this option is meant for warming up "
+			"the caches and pipelines in detailed mode before "
+			"saving. The checkpoint only contains the state of the "
+			"guest programs, so a restored simulation starts with "
+			"empty pipelines and caches.");
+	
 	// Trace file
 	command_line->RegisterString("--trace <file>",
 			m2s_trace_file,
@@ -309,6 +512,25 @@ void RegisterOptions()
 			"user should watch the size of the generated trace as "
 			"simulation runs, since the trace file can quickly "
 			"become extremely large.");
+
+	// Binary trace
+	command_line->RegisterBool("--trace-binary",
+			m2s_trace_binary,
+			"Write the trace file given in option '--trace' in a "
+			"compact binary format, encoded with interned strings "
+			"and variable-length integers, and compressed by a "
+			"background thread. This reduces the simulation "
+			"overhead of tracing. Binary traces can be passed "
+			"directly to option '--visual', or converted to the "
+			"plain-text format with option '--trace-to-text'.");
+
+	// Binary trace conversion
+	command_line->RegisterString("--trace-to-text <file>",
+			m2s_trace_to_text,
+			"Convert a binary trace generated with options "
+			"'--trace' and '--trace-binary' into the plain-text "
+			"trace format, dumped to the standard output, and "
+			"exit.");
 	
 	// Visualization tool input file
 	command_line->RegisterString("--visual <file>",
@@ -388,6 +610,34 @@ void ProcessOptions()
 	if (!m2s_debug_esim.empty())
 		esim::Engine::setDebugPath(m2s_debug_esim);
 
+	// Event scheduler
+	esim::Engine::setSchedulerKind(m2s_esim_scheduler);
+
+	// Event-driven simulator profiler
+	if (!m2s_esim_profile.empty())
+		esim::Engine::setProfile(true);
+
+	// Parallel event-driven simulation. Traces are dumped in the order in
+	// which event handlers run, which requires a single thread.
+	if (m2s_esim_threads < 1)
+		throw misc::Error(misc::fmt("Invalid number of threads for "
+				"option --esim-threads: %d",
+				m2s_esim_threads));
+	esim::Engine::setNumThreads(m2s_trace_file.empty() ?
+			m2s_esim_threads : 1);
+	if (!m2s_esim_partition_map.empty())
+		esim::Engine::setPartitionMap(m2s_esim_partition_map);
+
+	// Checkpoint saved at a simulation cycle
+	if (!m2s_save_checkpoint_cycle_file.empty())
+	{
+		if (!m2s_save_checkpoint.empty())
+			throw misc::Error("Options '--save-checkpoint' and "
+					"'--save-checkpoint-cycle' cannot be "
+					"used together");
+		m2s_save_checkpoint = m2s_save_checkpoint_cycle_file;
+	}
+
 	// Inifile debugger
 	if (!m2s_debug_inifile.empty())
 		misc::IniFile::setDebugPath(m2s_debug_inifile);
@@ -408,12 +658,39 @@ void ProcessOptions()
 	if (!m2s_trace_file.empty())
 	{
 		esim::TraceSystem *trace_system = esim::TraceSystem::getInstance();
-		trace_system->setPath(m2s_trace_file);
+		trace_system->setPath(m2s_trace_file, m2s_trace_binary);
+	}
+
+	// Binary trace conversion
+	if (!m2s_trace_to_text.empty())
+	{
+		esim::BinaryTraceReader reader(m2s_trace_to_text);
+		reader.Convert(std::cout);
+		exit(0);
 	}
 
-	// Visualization
-	if (!m2s_visual_file.empty())
+	// Visualization. Binary traces are converted to a temporary text
+	// trace first.
+	if (!m2s_visual_file.empty() &&
+			!esim::BinaryTraceReader::isBinaryTrace(m2s_visual_file))
+	{
 		visual_run(m2s_visual_file.c_str());
+	}
+	else if (!m2s_visual_file.empty())
+	{
+		char path[] = "/tmp/m2s.XXXXXX";
+		int fd = mkstemp(path);
+		if (fd == -1)
+			throw misc::Error("Cannot create temporary file");
+		close(fd);
+		{
+			esim::BinaryTraceReader reader(m2s_visual_file);
+			std::ofstream f(path);
+			reader.Convert(f);
+		}
+		visual_run(path);
+		unlink(path);
+	}
 		
 }
 
@@ -461,6 +738,7 @@ void MainLoop()
 
 	// Get singletons
 	comm::ArchPool *arch_pool = comm::ArchPool::getInstance();
+	comm::Arch *x86_arch = arch_pool->getByName("x86");
 
 	// Simulation loop
 	while (!esim->hasFinished())
@@ -474,12 +752,45 @@ void MainLoop()
 		arch_pool->Run(num_active_emulators,
 				num_active_timing_simulators);
 
+		// Save a checkpoint once enough x86 instructions or cycles have
+		// run, as soon as all contexts are in a state that can be
+		// saved.
+		if (!m2s_save_checkpoint.empty() && !esim->hasFinished())
+		{
+			x86::Emulator *x86_emulator = x86::Emulator::getInstance();
+			bool reached = m2s_save_checkpoint_cycle_file.empty() ?
+					x86_emulator->getNumInstructions() >=
+					m2s_save_checkpoint_inst :
+					esim->getCycle() >=
+					m2s_save_checkpoint_cycle;
+			if (reached && x86_emulator->canSaveCheckpoint())
+			{
+				SaveCheckpoint();
+				esim->Finish("Checkpoint");
+			}
+		}
+
 		// Event-driven simulation. Only process events and advance to
 		// next global simulation cycle if any architecture performed a
 		// useful timing simulation.
 		if (num_active_timing_simulators)
 			esim->ProcessEvents();
 
+		// Jump over cycles in which all timing simulators are idle
+		if (m2s_esim_skip_idle && num_active_timing_simulators
+				&& !num_active_emulators
+				&& !esim->hasFinished())
+			arch_pool->SkipIdleCycles();
+
+		// If x86 functional simulation is the only activity left, and
+		// its contexts wait for host events, block until one occurs
+		// instead of polling continuously. Other architectures and
+		// timing simulators would stall while blocking.
+		if (num_active_emulators == 1 && !num_active_timing_simulators
+				&& x86_arch && x86_arch->isActive()
+				&& !esim->hasFinished())
+			x86::Emulator::getInstance()->WaitForHostEvents();
+
 		// If neither functional nor timing simulation was performed for
 		// any architecture, it means that all guest contexts finished
 		// execution - simulation can end.
@@ -535,6 +846,9 @@ void DumpStatisticsSummary(std::ostream &os = std::cerr)
 		os << misc::fmt("SimTime = %.2f [ns]\n", esim_engine->getTime() / 1000.0);
 		os << misc::fmt("Frequency = %d [MHz]\n", esim_engine->getFrequency());
 		os << misc::fmt("Cycles = %lld\n", cycles);
+		if (esim_engine->getNumSkippedCycles())
+			os << misc::fmt("SkippedCycles = %lld\n",
+					esim_engine->getNumSkippedCycles());
 	}
 
 	// End
@@ -554,6 +868,26 @@ void DumpReports()
 	comm::ArchPool *arch_pool = comm::ArchPool::getInstance();
 	arch_pool->DumpReports();
 
+	// Event-driven simulation engine report
+	if (!m2s_esim_report.empty())
+	{
+		std::ofstream f(m2s_esim_report);
+		if (!f)
+			throw misc::Error(misc::fmt("%s: cannot open file for "
+					"write", m2s_esim_report.c_str()));
+		esim::Engine::getInstance()->DumpReport(f);
+	}
+
+	// Event-driven simulation engine profile
+	if (!m2s_esim_profile.empty())
+	{
+		std::ofstream f(m2s_esim_profile);
+		if (!f)
+			throw misc::Error(misc::fmt("%s: cannot open file for "
+					"write", m2s_esim_profile.c_str()));
+		esim::Engine::getInstance()->DumpProfile(f);
+	}
+
 	// Dumping memory report
 	if (mem::System::hasInstance())
 	{
@@ -592,6 +926,7 @@ int MainProgram(int argc, char **argv)
 	Kepler::Disassembler::RegisterOptions();
 	Kepler::Driver::RegisterOptions();
 	Kepler::Emulator::RegisterOptions();
+	mem::Memory::RegisterOptions();
 	mem::Mmu::RegisterOptions();
 	mem::Manager::RegisterOptions();
 	MIPS::Disassembler::RegisterOptions();
@@ -622,6 +957,7 @@ int MainProgram(int argc, char **argv)
 	Kepler::Disassembler::ProcessOptions();
 	Kepler::Driver::ProcessOptions();
 	Kepler::Emulator::ProcessOptions();
+	mem::Memory::ProcessOptions();
 	mem::Mmu::ProcessOptions();
 	mem::Manager::ProcessOptions();
 	MIPS::Disassembler::ProcessOptions();
@@ -698,8 +1034,11 @@ int MainProgram(int argc, char **argv)
 	RegisterDrivers();
 	RegisterRuntimes();
 
-	// Load programs
-	LoadPrograms();
+	// Load programs, or restore them from a checkpoint
+	if (m2s_load_checkpoint.empty())
+		LoadPrograms();
+	else
+		LoadCheckpoint();
 		
 	// Main simulation loop
 	MainLoop();
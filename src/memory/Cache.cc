@@ -134,13 +134,12 @@ void Cache::setBlock(unsigned set_id,
 		BlockState state)
 {
 	// Trace
-	System::trace << misc::fmt("mem.set_block cache=\"%s\" "
-			"set=%d way=%d tag=0x%x state=\"%s\"\n",
-			name.c_str(),
-			set_id,
-			way_id,
-			tag,
-			BlockStateMap[state]);
+	System::trace.Line("mem.set_block")
+			.String("cache", name)
+			.Number("set", set_id)
+			.Number("way", way_id)
+			.Hex("tag", tag)
+			.String("state", BlockStateMap[state]);
 	
 	// Get set and block
 	Set *set = getSet(set_id);
@@ -155,6 +154,14 @@ void Cache::setBlock(unsigned set_id,
 		set->lru_list.PushFront(block->lru_node);
 	}
 
+	// A prefetched block leaving the cache was never used
+	if (block->prefetched && (block->tag != tag ||
+			state == BlockInvalid))
+	{
+		block->prefetched = false;
+		num_useless_prefetches++;
+	}
+
 	// Set new values for block
 	block->tag = tag;
 	block->state = state;
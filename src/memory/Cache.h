@@ -90,6 +90,9 @@ public:
 		// Block state
 		BlockState state = BlockInvalid;
 
+		// Block brought by a prefetch and not accessed since
+		bool prefetched = false;
+
 		// The block belongs to an LRU list
 		misc::List<Block>::Node lru_node;
 	
@@ -112,6 +115,10 @@ public:
 		/// Get the block state
 		BlockState getState() const { return state; }
 
+		/// Return whether the block was brought by a prefetch and was
+		/// not accessed since
+		bool isPrefetched() const { return prefetched; }
+
 		/// Set new state and tag
 		void setStateTag(BlockState state, unsigned tag)
 		{
@@ -164,6 +171,10 @@ private:
 	// Array of blocks
 	std::unique_ptr<Block[]> blocks;
 
+	// Number of prefetched blocks replaced or invalidated before being
+	// accessed
+	long long num_useless_prefetches = 0;
+
 	/// Return a pointer to a cache set
 	Set *getSet(unsigned set_id)
 	{
@@ -235,7 +246,8 @@ public:
 
 	/// Set a new tag and state for a cache block. If a new tag is set to
 	/// the block, this function also updates the FIFO counters to indicate
-	/// that a new block was brought to the cache.
+	/// that a new block was brought to the cache. A prefetched block that
+	/// gets a new tag or is invalidated is counted as a useless prefetch.
 	///
 	/// \param set_id
 	///	Set of the block to modify.
@@ -288,6 +300,14 @@ public:
 		block->transient_tag = tag;
 	}
 
+	/// Mark a block as brought by a prefetch, or clear the mark once the
+	/// block is accessed.
+	void setPrefetched(unsigned set_id, unsigned way_id, bool prefetched)
+	{
+		Block *block = getBlock(set_id, way_id);
+		block->prefetched = prefetched;
+	}
+
 
 
 	//
@@ -318,6 +338,13 @@ public:
 
 	/// Return the log2 of the block size
 	int getLogBlockSize() const { return log_block_size; }
+
+	/// Return the number of prefetched blocks replaced or invalidated
+	/// before being accessed
+	long long getNumUselessPrefetches() const
+	{
+		return num_useless_prefetches;
+	}
 };
 
 
@@ -61,13 +61,12 @@ void Directory::setOwner(int set_id, int way_id, int sub_block_id, int owner)
 	entry->setOwner(owner);
 
 	// Trace
-	System::trace << misc::fmt("mem.set_owner dir=\"%s\" "
-			"x=%d y=%d z=%d owner=%d\n",
-			name.c_str(),
-			set_id,
-			way_id,
-			sub_block_id,
-			owner);
+	System::trace.Line("mem.set_owner")
+			.String("dir", name)
+			.Number("x", set_id)
+			.Number("y", way_id)
+			.Number("z", sub_block_id)
+			.Number("owner", owner);
 
 	// Debug
 	System::debug << misc::fmt("    dir=\"%s\" set=%d, way=%d, sub_block=%d: "
@@ -105,13 +104,12 @@ void Directory::setSharer(int set_id, int way_id, int sub_block_id, int node_id)
 	sharers.Set(bit_id);
 	
 	// Trace
-	System::trace << misc::fmt("mem.set_sharer dir=\"%s\" "
-			"x=%d y=%d z=%d sharer=%d\n",
-			name.c_str(),
-			set_id,
-			way_id,
-			sub_block_id,
-			node_id);
+	System::trace.Line("mem.set_sharer")
+			.String("dir", name)
+			.Number("x", set_id)
+			.Number("y", way_id)
+			.Number("z", sub_block_id)
+			.Number("sharer", node_id);
 
 	System::debug << misc::fmt("    dir=\"%s\" set=%d, way=%d, sub_block=%d: "
 			"set sharer=%d\n",
@@ -148,13 +146,12 @@ void Directory::clearSharer(int set_id, int way_id, int sub_block_id, int node_i
 	sharers.Set(bit_id, false);
 	
 	// Trace
-	System::trace << misc::fmt("mem.clear_sharer dir=\"%s\" "
-			"x=%d y=%d z=%d sharer=%d\n",
-			name.c_str(),
-			set_id,
-			way_id,
-			sub_block_id,
-			node_id);
+	System::trace.Line("mem.clear_sharer")
+			.String("dir", name)
+			.Number("x", set_id)
+			.Number("y", way_id)
+			.Number("z", sub_block_id)
+			.Number("sharer", node_id);
 
 	// Debug
 	System::debug << misc::fmt("    dir=\"%s\" set=%d, way=%d, sub_block=%d: "
@@ -185,12 +182,11 @@ void Directory::clearAllSharers(int set_id, int way_id, int sub_block_id)
 		sharers.Set(bit_id + i, false);
 	
 	// Trace
-	System::trace << misc::fmt("mem.clear_all_sharers dir=\"%s\" "
-			"x=%d y=%d z=%d\n",
-			name.c_str(),
-			set_id,
-			way_id,
-			sub_block_id);
+	System::trace.Line("mem.clear_all_sharers")
+			.String("dir", name)
+			.Number("x", set_id)
+			.Number("y", way_id)
+			.Number("z", sub_block_id);
 
 	// Debug
 	System::debug << misc::fmt("    clear all sharer "
@@ -274,15 +270,11 @@ bool Directory::LockEntry(
 	}
 
 	// Trace
-	System::trace << misc::fmt("mem.new_access_block "
-			"cache=\"%s\" "
-			"access=\"A-%lld\" "
-			"set=%d "
-			"way=%d\n",
-			name.c_str(),
-			access_id,
-			set_id,
-			way_id);
+	System::trace.Line("mem.new_access_block")
+			.String("cache", name)
+			.Name("access", "A-", access_id)
+			.Number("set", set_id)
+			.Number("way", way_id);
 	
 	// Debug
 	System::debug << misc::fmt("    "
@@ -346,15 +338,11 @@ void Directory::UnlockEntry(int set_id, int way_id, long long access_id)
 	}
 
 	// Trace
-	System::trace << misc::fmt("mem.end_access_block "
-			"cache=\"%s\" "
-			"access=\"A-%lld\" "
-			"set=%d "
-			"way=%d\n",
-			name.c_str(),
-			access_id,
-			set_id,
-			way_id);
+	System::trace.Line("mem.end_access_block")
+			.String("cache", name)
+			.Name("access", "A-", access_id)
+			.Number("set", set_id)
+			.Number("way", way_id);
 
 	// Unlock entry
 	lock->access_id = 0;
@@ -103,6 +103,10 @@ public:
 	/// over.
 	int *witness = nullptr;
 
+	/// Pointer to a boolean variable to be set to true if the access is a
+	/// load or store that misses in the module where it started.
+	bool *miss = nullptr;
+
 	/// Iterator to the current position of this frame in
 	/// Module::accesses.
 	std::list<Frame *>::iterator accesses_iterator;
@@ -153,6 +157,19 @@ public:
 	/// Flag indicating whether this access is a non-coherent write.
 	bool nc_write = false;
 
+	/// Flag indicating whether this access is a prefetch, or a request
+	/// caused by a prefetch in a higher-level module.
+	bool prefetch = false;
+
+	/// For a prefetch, flag set when a demand access to the same block
+	/// arrives before the prefetch completes.
+	bool prefetch_late = false;
+
+	/// Address of the instruction that caused the access, or 0 if
+	/// unknown. It is passed down to lower-level modules to train their
+	/// prefetchers.
+	unsigned pc = 0;
+
 	/// Flag indicating whether there is a block eviction in the current
 	/// access.
 	bool eviction = false;
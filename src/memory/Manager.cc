@@ -19,6 +19,7 @@
 
 #include <cmath>
 
+#include <lib/cpp/Checkpoint.h>
 #include <lib/cpp/String.h>
 
 #include "Manager.h"
@@ -449,6 +450,42 @@ void Manager::RemovePointer(Chunk *pointer)
 	chunks.erase(pointer->getChunksIterator());
 }
 
+void Manager::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	writer.WriteSection("Manager");
+	writer.WriteValue<unsigned>(chunks.size());
+	for (auto &it : chunks)
+	{
+		Chunk *chunk = it.second.get();
+		writer.WriteValue(chunk->getAddress());
+		writer.WriteValue(chunk->getSize());
+		writer.WriteValue(chunk->isAllocated());
+	}
+}
+
+
+void Manager::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	// Discard current chunks
+	holes.clear();
+	chunks.clear();
+
+	// Create saved chunks
+	reader.ReadSection("Manager");
+	unsigned num_chunks = reader.ReadValue<unsigned>();
+	for (unsigned i = 0; i < num_chunks; i++)
+	{
+		unsigned address = reader.ReadValue<unsigned>();
+		unsigned size = reader.ReadValue<unsigned>();
+		bool is_allocated = reader.ReadValue<bool>();
+		if (is_allocated)
+			CreatePointer(address, size);
+		else
+			CreateHole(address, size);
+	}
+}
+
+
 bool Manager::isValidAddress(unsigned address)
 {
 	// Find the possible chunk it can locate in
@@ -270,6 +270,14 @@ public:
 	/// Get occupied size, equals to the number of pages occupied
 	unsigned getOccupiedSize() const;
 
+	/// Save the list of allocated and free chunks into a checkpoint. The
+	/// content of the managed memory is saved separately.
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Replace the list of chunks with the one saved in a checkpoint with
+	/// SaveCheckpoint().
+	void LoadCheckpoint(misc::CheckpointReader &reader);
+
 	/// Dump how chunk is allocated in the managed memory
 	void DumpChunks(std::ostream &os) const;
 
@@ -21,7 +21,10 @@
 #include <cassert>
 #include <cstring>
 #include <fstream>
+#include <vector>
 
+#include <lib/cpp/Checkpoint.h>
+#include <lib/cpp/CommandLine.h>
 #include <lib/cpp/Misc.h>
 #include <lib/cpp/String.h>
 
@@ -37,63 +40,178 @@ const unsigned Memory::PageMask;
 
 bool Memory::safe_mode = true;
 
+bool Memory::huge_pages = false;
 
-Memory::Page *Memory::getPage(unsigned address)
+std::atomic<long long> Memory::num_shared_pages(0);
+
+std::atomic<long long> Memory::num_copied_pages(0);
+
+
+bool Memory::Page::MakeDataPrivate()
 {
-	unsigned tag = address & ~(PageSize - 1);
-	auto it = pages.find(tag);
-	return it == pages.end() ? nullptr : it->second.get();
+	// Allocate data
+	if (!data)
+	{
+		AllocateData();
+		return false;
+	}
+
+	// Private data
+	if (!isShared())
+		return false;
+
+	// Copy shared data, and release the reference to it
+	PageArena *arena = PageArena::getInstance(PageSize);
+	char *shared_data = data;
+	data = arena->Allocate();
+	memcpy(data, shared_data, PageSize);
+	arena->Free(shared_data);
+	return true;
+}
+
+
+void Memory::RegisterOptions()
+{
+	// Get command line object
+	misc::CommandLine *command_line = misc::CommandLine::getInstance();
+
+	// Category
+	command_line->setCategory("Memory");
+
+	// Option --mem-huge-pages
+	command_line->RegisterBool("--mem-huge-pages", huge_pages,
+			"Advise the host to back the memory of guest programs "
+			"with transparent huge pages. This reduces host TLB "
+			"misses for guests with large memory footprints, at "
+			"the cost of a higher resident memory.");
+}
+
+
+void Memory::ProcessOptions()
+{
+	PageArena::setHugePages(huge_pages);
+}
+
+
+Memory::Page *Memory::FindPage(unsigned tag) const
+{
+	// Scan directories starting at the one containing the tag
+	unsigned page_index = getPageIndex(tag);
+	for (unsigned directory_index = getDirectoryIndex(tag);
+			directory_index < DirectorySize;
+			directory_index++)
+	{
+		// Scan pages of the directory
+		PageDirectory *directory = directories[directory_index].get();
+		for (; directory && page_index < DirectorySize; page_index++)
+			if (directory->pages[page_index])
+				return directory->pages[page_index].get();
+
+		// Following directories are scanned from their first page
+		page_index = 0;
+	}
+
+	// No page found
+	return nullptr;
 }
 
 
-Memory::Page *Memory::getNextPage(unsigned address)
+Memory::Page *Memory::getNextPage(unsigned address) const
 {
 	// Get tag of the page just following address
 	unsigned tag = (address + PageSize) & ~(PageSize - 1);
 	if (!tag)
 		return nullptr;
 
-	// Look for a page exactly following the given address. If it is found,
-	// return it.
-	auto it = pages.find(tag);
-	if (it != pages.end())
-		return it->second.get();
-	
-	// Page following address is not found, so check all memory pages to
-	// find the one with the lowest tag following address.
-	unsigned min_tag = 0xffffffff;
-	Page *min_page = nullptr;
-	for (auto &pair : pages)
-	{
-		Page *page = pair.second.get();
-		if (page->getTag() > tag && page->getTag() < min_tag)
-		{
-			min_tag = page->getTag();
-			min_page = page;
-		}
-	}
+	// Return the page with the lowest tag following address
+	return FindPage(tag);
+}
 
-	// Return the found page (or nullptr)
-	return min_page;
+void Memory::FillTlb(Page *page, AccessType access)
+{
+	// Only pages with the requested permissions are cached, so that the
+	// same accesses are served in safe and unsafe mode.
+	TlbEntry *entries = getTlb(access);
+	if (!entries || (page->getPerm() & access) != access)
+		return;
+
+	// Reads of pages without data return zeros, and writes must set the
+	// 'modified' flag, invalidate watched code, and copy shared data, so
+	// these pages are not cached until they reach a steady state.
+	if (!page->getData())
+		return;
+	if (access == AccessWrite && (page->isCode() ||
+			!(page->getPerm() & AccessModified) ||
+			page->isShared()))
+		return;
+
+	// Fill entry
+	TlbEntry &entry = entries[(page->getTag() >> LogPageSize) &
+			(TlbSize - 1)];
+	entry.tag = page->getTag();
+	entry.data = page->getData();
+}
+
+
+void Memory::InvalidateTlb(unsigned tag)
+{
+	unsigned index = (tag >> LogPageSize) & (TlbSize - 1);
+	for (int kind = 0; kind < TlbNumKinds; kind++)
+		if (tlb[kind][index].tag == tag)
+			tlb[kind][index] = TlbEntry();
 }
 
+
+void Memory::FlushTlb() const
+{
+	for (int kind = 0; kind < TlbNumKinds; kind++)
+		for (unsigned index = 0; index < TlbSize; index++)
+			tlb[kind][index] = TlbEntry();
+}
+
+
 Memory::Page *Memory::newPage(unsigned address, unsigned perm)
 {
-	// Allocate new page
+	// Get directory, creating it if needed
 	unsigned tag = address & ~(PageSize - 1);
-	auto ret = pages.emplace(tag, misc::new_unique<Page>(tag, perm));
-
-	// Check tag page was inserted successfully
-	bool success = ret.second;
-	if (!success)
+	std::unique_ptr<PageDirectory> &directory =
+			directories[getDirectoryIndex(tag)];
+	if (!directory)
+		directory = misc::new_unique<PageDirectory>();
+
+	// Check that page does not exist
+	std::unique_ptr<Page> &page = directory->pages[getPageIndex(tag)];
+	if (page)
 		throw misc::Panic("Memory page already exists");
 
-	// Obtain inserted page
-	auto it = ret.first;
-	Page *page = it->second.get();
+	// Allocate new page
+	page = misc::new_unique<Page>(tag, perm);
+	directory->num_pages++;
+	return page.get();
+}
+
 
-	// Return it
-	return page;
+void Memory::DeletePage(unsigned tag)
+{
+	// Free page
+	std::unique_ptr<PageDirectory> &directory =
+			directories[getDirectoryIndex(tag)];
+	assert(directory && directory->pages[getPageIndex(tag)]);
+	directory->pages[getPageIndex(tag)].reset();
+
+	// Free directory when it becomes empty
+	assert(directory->num_pages > 0);
+	if (--directory->num_pages == 0)
+		directory.reset();
+}
+
+
+void Memory::Clear()
+{
+	for (unsigned index = 0; index < DirectorySize; index++)
+		directories[index].reset();
+	code_version++;
+	FlushTlb();
 }
 
 
@@ -114,19 +232,23 @@ void Memory::Copy(unsigned dest, unsigned src, unsigned size)
 		Page *page_dest = getPage(dest);
 		Page *page_src = getPage(src);
 		assert(page_src && page_dest);
+		InvalidateCode(page_dest);
 		
 		// Different actions depending on whether source and
 		// destination page data are allocated.
 		if (page_src->getData())
 		{
-			page_dest->AllocateData();
+			MakeDataPrivate(page_dest);
 			memcpy(page_dest->getData(), page_src->getData(),
 					PageSize);
 		}
 		else
 		{
 			if (page_dest->getData())
+			{
+				MakeDataPrivate(page_dest);
 				memset(page_dest->getData(), 0, PageSize);
+			}
 		}
 
 		// Advance pointers
@@ -143,6 +265,11 @@ char *Memory::getBuffer(unsigned address, unsigned size, AccessType access)
 	unsigned offset = address & (PageSize - 1);
 	if (offset + size > PageSize)
 		return nullptr;
+
+	// Page cached in the software TLB
+	char *data = LookupTlb(address, access);
+	if (data)
+		return data + offset;
 	
 	// Look for page
 	Page *page = getPage(address);
@@ -152,13 +279,110 @@ char *Memory::getBuffer(unsigned address, unsigned size, AccessType access)
 	// Check page permissions
 	if ((page->getPerm() & access) != access && safe)
 		throw Error(misc::fmt("[0x%x] Permission denied", address));
+
+	// The caller can modify the content through the buffer
+	if (access & (AccessWrite | AccessInit))
+	{
+		InvalidateCode(page);
+		MakeDataPrivate(page);
+	}
 	
 	// Return pointer to page data
 	page->AllocateData();
+	FillTlb(page, access);
 	return page->getData() + offset;
 }
 
 
+bool Memory::getIovecs(unsigned address, unsigned size, AccessType access,
+		std::vector<struct iovec> &iovecs)
+{
+	// Buffer representing pages without data
+	static const char zero_page[PageSize] = { };
+
+	// Check that all pages exist and have the permissions
+	assert(access == AccessRead || access == AccessWrite);
+	unsigned end = address + size;
+	if (end < address)
+		return false;
+	for (unsigned tag = address & ~(PageSize - 1); tag < end;
+			tag += PageSize)
+	{
+		Page *page = getPage(tag);
+		if (!page || (safe && (page->getPerm() & access) != access))
+			return false;
+		if (tag + PageSize < tag)
+			break;
+	}
+
+	// Add buffers
+	while (size)
+	{
+		unsigned offset = address & (PageSize - 1);
+		unsigned chunk_size = std::min(size, PageSize - offset);
+		Page *page = getPage(address);
+		char *data;
+		if (access == AccessWrite)
+		{
+			page->addPerm(AccessModified);
+			InvalidateCode(page);
+			MakeDataPrivate(page);
+			data = page->getData() + offset;
+		}
+		else
+		{
+			data = page->getData() ? page->getData() + offset :
+					const_cast<char *>(zero_page);
+		}
+
+		// Merge with the previous buffer if adjacent
+		if (!iovecs.empty() && data == (char *) iovecs.back().iov_base +
+				iovecs.back().iov_len && data != zero_page)
+			iovecs.back().iov_len += chunk_size;
+		else
+			iovecs.push_back({ data, chunk_size });
+
+		// Next page
+		address += chunk_size;
+		size -= chunk_size;
+	}
+	return true;
+}
+
+
+bool Memory::MapFile(unsigned address, unsigned size, int fd,
+		long long offset)
+{
+	// Check pages
+	assert(!(address & (PageSize - 1)));
+	assert(!(size & (PageSize - 1)));
+	unsigned num_pages = size / PageSize;
+	for (unsigned i = 0; i < num_pages; i++)
+	{
+		Page *page = getPage(address + i * PageSize);
+		if (!page || page->getData())
+			return false;
+	}
+
+	// Map file in the host
+	char *frames = PageArena::getInstance(PageSize)->MapFile(fd, offset,
+			num_pages);
+	if (!frames)
+		return false;
+
+	// Reference frames
+	for (unsigned i = 0; i < num_pages; i++)
+		getPage(address + i * PageSize)->setData(frames + i * PageSize);
+	return true;
+}
+
+
+void Memory::DetachFile(int fd)
+{
+	PageArena::getInstance(PageSize)->DetachFile(fd);
+}
+
+
 void Memory::AccessAtPageBoundary(unsigned address, unsigned size,
 		char *buffer, AccessType access)
 {
@@ -204,14 +428,17 @@ void Memory::AccessAtPageBoundary(unsigned address, unsigned size,
 			memcpy(buffer, page->getData() + offset, size);
 		else
 			memset(buffer, 0, size);
+		FillTlb(page, access);
 		return;
 	}
 
 	// Write/initialize access
 	if (access == AccessWrite || access == AccessInit)
 	{
-		page->AllocateData();
+		InvalidateCode(page);
+		MakeDataPrivate(page);
 		memcpy(page->getData() + offset, buffer, size);
+		FillTlb(page, access);
 		return;
 	}
 
@@ -220,7 +447,7 @@ void Memory::AccessAtPageBoundary(unsigned address, unsigned size,
 }
 
 
-void Memory::Access(unsigned address, unsigned size, char *buf,
+void Memory::AccessSlow(unsigned address, unsigned size, char *buf,
 			AccessType access)
 {
 	last_address = address;
@@ -246,26 +473,8 @@ Memory::Memory()
 
 Memory::Memory(const Memory &memory)
 {
-	// Copy pages
-	safe = false;
-	for (auto &it : memory.pages)
-	{
-		// Get source page
-		Page *src_page = it.second.get();
-
-		// Create destination page with same permissions
-		newPage(src_page->getTag(), src_page->getPerm());
-
-		// Copy data if any
-		if (src_page->getData())
-			Access(src_page->getTag(), PageSize,
-					src_page->getData(),
-					AccessInit);
-	}
-
-	// Copy other fields
-	safe = memory.safe;
-	heap_break = memory.heap_break;
+	// Share pages and copy attributes
+	Clone(memory);
 }
 
 
@@ -280,6 +489,17 @@ unsigned Memory::MapSpace(unsigned address, unsigned size)
 		// Address space overflow
 		if (!tag_end)
 			return -1;
+
+		// Skip a whole directory without pages if the region is still
+		// smaller than requested after it
+		unsigned directory_span = PageSize << LogDirectorySize;
+		if (!(tag_end & (directory_span - 1)) &&
+				!directories[getDirectoryIndex(tag_end)] &&
+				tag_end - tag_start + directory_span < size)
+		{
+			tag_end += directory_span;
+			continue;
+		}
 		
 		// Not enough free pages in current region
 		if (getPage(tag_end))
@@ -314,6 +534,18 @@ unsigned Memory::MapSpaceDown(unsigned address, unsigned size)
 		// Address space overflow
 		if (!tag_start)
 			return (unsigned) -1;
+
+		// Skip a whole directory without pages if the region is still
+		// smaller than requested after it
+		unsigned directory_span = PageSize << LogDirectorySize;
+		if (!((tag_start + PageSize) & (directory_span - 1)) &&
+				tag_start >= directory_span &&
+				!directories[getDirectoryIndex(tag_start)] &&
+				tag_end - tag_start + directory_span < size)
+		{
+			tag_start -= directory_span;
+			continue;
+		}
 		
 		// Not enough free pages in current region
 		if (getPage(tag_start))
@@ -364,7 +596,14 @@ void Memory::Unmap(unsigned address, unsigned size)
 
 	// Deallocate pages
 	for (unsigned tag = tag1; tag <= tag2; tag += PageSize)
-		pages.erase(tag);
+	{
+		Page *page = getPage(tag);
+		if (!page)
+			continue;
+		InvalidateCode(page);
+		InvalidateTlb(tag);
+		DeletePage(tag);
+	}
 }
 
 
@@ -384,6 +623,8 @@ void Memory::Protect(unsigned address, unsigned size, unsigned perm)
 			continue;
 
 		// Set page new protection flags
+		InvalidateCode(page);
+		InvalidateTlb(tag);
 		page->setPerm(perm);
 	}
 }
@@ -474,28 +715,57 @@ void Memory::Load(const std::string &path, unsigned start)
 }
 
 
+bool Memory::WatchCode(unsigned address, unsigned size)
+{
+	bool watched = true;
+	unsigned tag1 = address & PageMask;
+	unsigned tag2 = (address + size - 1) & PageMask;
+	for (unsigned tag = tag1; ; tag += PageSize)
+	{
+		// Writes to the page must now go through the page table
+		Page *page = getPage(tag);
+		if (page)
+		{
+			page->setCode(true);
+			TlbEntry &entry = tlb[TlbWrite][(tag >> LogPageSize) &
+					(TlbSize - 1)];
+			if (entry.tag == tag)
+				entry = TlbEntry();
+		}
+		else
+		{
+			watched = false;
+		}
+		if (tag == tag2)
+			break;
+	}
+	return watched;
+}
+
+
 void Memory::Clone(const Memory &memory)
 {
 	// Clear destination memory
 	Clear();
 
-	// Copy pages
-	safe = false;
-	for (auto &it : memory.pages)
+	// Share pages
+	for (Page *src_page = memory.FindPage(0); src_page;
+			src_page = memory.getNextPage(src_page->getTag()))
 	{
-		// Get source page
-		Page *src_page = it.second.get();
-
 		// Create destination page with same permissions
-		newPage(src_page->getTag(), src_page->getPerm());
+		Page *page = newPage(src_page->getTag(), src_page->getPerm());
 
-		// Copy data if any
+		// Share data if any
 		if (src_page->getData())
-			Access(src_page->getTag(), PageSize,
-					src_page->getData(),
-					AccessInit);
+		{
+			page->ShareData(src_page);
+			num_shared_pages++;
+		}
 	}
 
+	// Pages of the source memory can no longer be written through its
+	// TLB, since they are now shared
+	memory.FlushTlb();
 
 	// Copy other fields
 	safe = memory.safe;
@@ -503,5 +773,61 @@ void Memory::Clone(const Memory &memory)
 }
 
 
+void Memory::SaveCheckpoint(misc::CheckpointWriter &writer) const
+{
+	// Attributes
+	writer.WriteSection("Memory");
+	writer.WriteValue(safe);
+	writer.WriteValue(heap_break);
+
+	// Pages in increasing address order
+	std::vector<Page *> sorted_pages;
+	for (Page *page = FindPage(0); page;
+			page = getNextPage(page->getTag()))
+		sorted_pages.push_back(page);
+
+	// Pages
+	static const char zero[PageSize] = { };
+	writer.WriteValue<unsigned>(sorted_pages.size());
+	for (Page *page : sorted_pages)
+	{
+		char *data = page->getData();
+		bool has_data = data && memcmp(data, zero, PageSize);
+		writer.WriteValue(page->getTag());
+		writer.WriteValue(page->getPerm());
+		writer.WriteValue(has_data);
+		if (has_data)
+			writer.Write(data, PageSize);
+	}
+}
+
+
+void Memory::LoadCheckpoint(misc::CheckpointReader &reader)
+{
+	// Attributes
+	Clear();
+	reader.ReadSection("Memory");
+	reader.ReadValue(safe);
+	reader.ReadValue(heap_break);
+
+	// Pages
+	unsigned num_pages = reader.ReadValue<unsigned>();
+	for (unsigned i = 0; i < num_pages; i++)
+	{
+		unsigned tag = reader.ReadValue<unsigned>();
+		unsigned perm = reader.ReadValue<unsigned>();
+		bool has_data = reader.ReadValue<bool>();
+		if (tag & (PageSize - 1) || getPage(tag))
+			throw misc::Error("Corrupt memory pages in checkpoint");
+		Page *page = newPage(tag, perm);
+		if (has_data)
+		{
+			page->AllocateData();
+			reader.Read(page->getData(), PageSize);
+		}
+	}
+}
+
+
 } // namespace mem
 
@@ -20,14 +20,27 @@
 #ifndef MEMORY_MEMORY_H
 #define MEMORY_MEMORY_H
 
+#include <atomic>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <memory>
-#include <unordered_map>
+#include <sys/uio.h>
+#include <vector>
 
 #include <lib/cpp/Error.h>
 #include <lib/cpp/Misc.h>
 
+#include "PageArena.h"
+
+
+// Forward declarations
+namespace misc
+{
+class CheckpointReader;
+class CheckpointWriter;
+}
+
 
 namespace mem
 {
@@ -80,8 +93,12 @@ public:
 		// Page permissions
 		unsigned perm;
 
-		// The page data
-		std::unique_ptr<char[]> data;
+		// The page data, allocated from the page arena
+		char *data = nullptr;
+
+		// True if part of the page content was decoded as instructions
+		// by a client of the memory, as notified with WatchCode()
+		bool code = false;
 	
 	public:
 
@@ -93,6 +110,16 @@ public:
 			assert((tag & (PageSize - 1)) == 0);
 		}
 
+		/// Pages are not copied
+		Page(const Page &) = delete;
+
+		/// Destructor
+		~Page()
+		{
+			if (data)
+				PageArena::getInstance(PageSize)->Free(data);
+		}
+
 		/// Return the page tag, equal to the address of the first byte
 		/// contained in the page.
 		unsigned getTag() const { return tag; }
@@ -103,16 +130,48 @@ public:
 
 		/// Return a pointer to the page data, or `nullptr` if the data
 		/// was not allocated.
-		char *getData() { return data.get(); }
+		char *getData() { return data; }
 
-		/// Allocate the page data. If the data buffer was allocated
-		/// before, this call is ignored.
+		/// Allocate the page data, initialized to zero. If the data
+		/// buffer was allocated before, this call is ignored.
 		void AllocateData()
 		{
 			if (data == nullptr)
-				data = misc::new_unique_array<char>(PageSize);
+				data = PageArena::getInstance(PageSize)->Allocate();
+		}
+
+		/// Return whether the page data is shared with pages of other
+		/// memory objects, and must be copied before it is modified.
+		bool isShared() const
+		{
+			return data && PageArena::getInstance(PageSize)
+					->isShared(data);
+		}
+
+		/// Make the page reference the data of \a page, which is
+		/// shared until either page is modified. The page must not
+		/// have data.
+		void ShareData(Page *page)
+		{
+			assert(!data && page->data);
+			data = page->data;
+			PageArena::getInstance(PageSize)->Share(data);
+		}
+
+		/// Make the page reference \a frame, a frame of the page arena
+		/// not referenced by any other page. The page must not have
+		/// data.
+		void setData(char *frame)
+		{
+			assert(!data && frame);
+			data = frame;
 		}
 
+		/// Prepare the page data to be modified. The data is allocated
+		/// if needed, or copied if it is shared. The function returns
+		/// true if the data was copied.
+		bool MakeDataPrivate();
+
 		/// Set the page permissions, given as a bitmap of flags of
 		/// type AccessType.
 		void setPerm(unsigned perm) { this->perm = perm; }
@@ -120,6 +179,13 @@ public:
 		/// Add a flag to the page permissions, given as a bitmap of
 		/// flags of type AccessType.
 		void addPerm(unsigned perm) { this->perm |= perm; }
+
+		/// Return whether the page content is watched for changes
+		/// with Memory::WatchCode()
+		bool isCode() const { return code; }
+
+		/// Set or clear the flag returned by isCode()
+		void setCode(bool code) { this->code = code; }
 	};
 
 private:
@@ -128,8 +194,54 @@ private:
 	// safe mode.
 	static bool safe_mode;
 
-	/// Hash table of memory pages, indexed by the page tag.
-	std::unordered_map<unsigned, std::unique_ptr<Page>> pages;
+	// Configuration option indicating whether page data should be backed
+	// by transparent huge pages in the host
+	static bool huge_pages;
+
+	// Number of pages whose data was shared by Clone() in all memory
+	// objects
+	static std::atomic<long long> num_shared_pages;
+
+	// Number of shared pages copied on their first write in all memory
+	// objects. Pages can be copied from several host threads.
+	static std::atomic<long long> num_copied_pages;
+
+	// Log base 2 of the number of entries in each level of the page table
+	static const unsigned LogDirectorySize = 10;
+
+	// Number of entries in each level of the page table
+	static const unsigned DirectorySize = 1u << LogDirectorySize;
+
+	// Second level of the page table, covering DirectorySize consecutive
+	// pages
+	struct PageDirectory
+	{
+		// Pages indexed by their page number within the directory
+		std::unique_ptr<Page> pages[DirectorySize];
+
+		// Number of pages present
+		unsigned num_pages = 0;
+	};
+
+	// First level of the page table, indexed by the most significant bits
+	// of the page number
+	std::unique_ptr<PageDirectory> directories[DirectorySize];
+
+	// Return the index in the first level of the page table for an address
+	static unsigned getDirectoryIndex(unsigned address)
+	{
+		return address >> (LogPageSize + LogDirectorySize);
+	}
+
+	// Return the index within a directory for an address
+	static unsigned getPageIndex(unsigned address)
+	{
+		return (address >> LogPageSize) & (DirectorySize - 1);
+	}
+
+	// Return the page with the lowest tag greater than or equal to \a tag,
+	// or `nullptr` if there is none.
+	Page *FindPage(unsigned tag) const;
 
 	/// Safe mode
 	bool safe;
@@ -140,20 +252,122 @@ private:
 	/// Last accessed address
 	unsigned last_address = 0;
 
+	// Number of times that pages watched with WatchCode() were modified
+	long long code_version = 0;
+
+	// Increment the code version if the page is watched, and stop watching
+	// it. This function must be called before the content or permissions
+	// of a page are changed.
+	void InvalidateCode(Page *page)
+	{
+		if (page->isCode())
+		{
+			page->setCode(false);
+			code_version++;
+		}
+	}
+
+	// Software TLBs, one for each type of cached access
+	enum TlbKind
+	{
+		TlbRead = 0,
+		TlbWrite,
+		TlbExec,
+		TlbNumKinds
+	};
+
+	// Number of entries in each software TLB
+	static const unsigned TlbSize = 256;
+
+	// Entry of a software TLB. A valid entry caches the data of a page
+	// that already has the permissions for the type of access of its TLB,
+	// so that the access can be performed without looking up the page
+	// table or checking permissions.
+	struct TlbEntry
+	{
+		// Page tag. Invalid entries have an unaligned tag.
+		unsigned tag = 1;
+
+		// Page data
+		char *data = nullptr;
+	};
+
+	// Software TLBs, direct-mapped on the page number. The TLBs of a
+	// memory object are flushed when it is cloned, since its pages become
+	// copy-on-write.
+	mutable TlbEntry tlb[TlbNumKinds][TlbSize];
+
+	// Return the software TLB caching accesses of type \a access, or
+	// `nullptr` if this type of access is not cached.
+	TlbEntry *getTlb(AccessType access)
+	{
+		switch (access)
+		{
+		case AccessRead: return tlb[TlbRead];
+		case AccessWrite: return tlb[TlbWrite];
+		case AccessExec: return tlb[TlbExec];
+		default: return nullptr;
+		}
+	}
+
+	// Return the data of the page containing \a address if it is cached
+	// in the software TLB for accesses of type \a access, or `nullptr`
+	// otherwise.
+	char *LookupTlb(unsigned address, AccessType access)
+	{
+		TlbEntry *entries = getTlb(access);
+		if (!entries)
+			return nullptr;
+		TlbEntry &entry = entries[(address >> LogPageSize) &
+				(TlbSize - 1)];
+		return entry.tag == (address & PageMask) ? entry.data : nullptr;
+	}
+
+	// Add a page to the software TLB for accesses of type \a access, if
+	// the page has the permissions and state needed to serve them
+	// without further checks.
+	void FillTlb(Page *page, AccessType access);
+
+	// Remove the page with tag \a tag from all software TLBs
+	void InvalidateTlb(unsigned tag);
+
+	// Invalidate all entries of the software TLBs
+	void FlushTlb() const;
+
+	// Prepare the data of a page to be modified, copying it if it is
+	// shared with other memory objects
+	void MakeDataPrivate(Page *page)
+	{
+		if (page->MakeDataPrivate())
+		{
+			num_copied_pages++;
+			InvalidateTlb(page->getTag());
+		}
+	}
+
 	/// Create a new page and add it to the page table. The value given in
 	/// \a perm is an *or*'ed bitmap of AccessType flags.
 	Page *newPage(unsigned address, unsigned perm);
 
-	// Access memory without exceeding page boundaries
+	// Remove a page from the page table and free it
+	void DeletePage(unsigned tag);
+
+	// Access memory without exceeding page boundaries, without using the
+	// software TLB
 	void AccessAtPageBoundary(unsigned address, unsigned size, char *buffer,
 			AccessType access);
 
+	// Access memory at any address and size, without using the software
+	// TLB
+	void AccessSlow(unsigned address, unsigned size, char *buffer,
+			AccessType access);
+
 public:
 
 	/// Constructor
 	Memory();
 
-	/// Copy constructor
+	/// Copy constructor. Page data is shared as in Clone().
 	Memory(const Memory &memory);
 
 	/// Set the safe mode. A memory in safe mode will crash with a fatal
@@ -165,20 +379,33 @@ public:
 	/// Set safe mode to its original global default value
 	void setSafeDefault() { safe = safe_mode; }
 
+	/// Register command-line options
+	static void RegisterOptions();
+
+	/// Process command-line options
+	static void ProcessOptions();
+
 	/// Return whether the safe mode is on
 	bool getSafe() const { return safe; }
 
 	/// Clear content of memory
-	void Clear() { pages.clear(); }
+	void Clear();
 
 	/// Return the memory page corresponding to an address, or `nullptr` if
 	/// there is currently no page allocated for that address.
-	Page *getPage(unsigned address);
+	Page *getPage(unsigned address)
+	{
+		PageDirectory *directory =
+				directories[getDirectoryIndex(address)].get();
+		return directory ?
+				directory->pages[getPageIndex(address)].get() :
+				nullptr;
+	}
 
 	/// Return the memory page following \a address in the current memory
 	/// map. This function is useful to reconstruct consecutive ranges of
 	/// mapped pages.
-	Page *getNextPage(unsigned address);
+	Page *getNextPage(unsigned address) const;
 
  	/// Allocate, if not already allocated, all necessary memory pages to
 	/// access \a size bytes after base address \a address. These fields
@@ -220,6 +447,43 @@ public:
 	///	region, or (unsigned) -1 if no free region was found with the
 	///	requested size.
 	unsigned MapSpace(unsigned address, unsigned size);
+
+	/// Use the content of a host file as the data of the mapped pages
+	/// without data in a region, instead of copying it. The pages
+	/// reference a private copy-on-write mapping of the file in the host,
+	/// so writes to them are not visible in the file.
+	///
+	/// Pages not written yet keep reading the file. If the file is
+	/// truncated, accessing them past its new end raises SIGBUS in the
+	/// simulator. Guest truncations must call DetachFile() first, which
+	/// copies the pages. Truncations done by other host processes while
+	/// the simulation runs are not detected, so callers must only use
+	/// this function when the user requested it.
+	///
+	/// \param address
+	///	Address aligned to page boundary.
+	///
+	/// \param size
+	///	Number of bytes, multiple of page size. The region must not
+	///	extend past the page containing the end of the file.
+	///
+	/// \param fd
+	///	Host file descriptor
+	///
+	/// \param offset
+	///	Offset in the file, aligned to page boundary.
+	///
+	/// \return
+	///	The function returns false, leaving the pages unchanged, if any
+	///	page in the region is not mapped or already has data, or if the
+	///	host cannot map the file.
+	bool MapFile(unsigned address, unsigned size, int fd, long long offset);
+
+	/// Copy the content of all pages of any memory object mapped from the
+	/// host file with descriptor \a fd by MapFile(), so that they no
+	/// longer depend on the file. This function must be invoked before a
+	/// guest program truncates a file.
+	static void DetachFile(int fd);
 	
 	/// Allocate memory downward.
 	///
@@ -295,7 +559,23 @@ public:
 	///	are not allocated, or do not have the permissions requested in
 	///	argument \a access.
 	void Access(unsigned address, unsigned size, char *buffer,
-			AccessType access);
+			AccessType access)
+	{
+		// Accesses within a page cached in the software TLB
+		last_address = address;
+		unsigned offset = address & (PageSize - 1);
+		char *data = offset + size <= PageSize ?
+				LookupTlb(address, access) : nullptr;
+		if (!data)
+		{
+			AccessSlow(address, size, buffer, access);
+			return;
+		}
+		if (access == AccessWrite)
+			memcpy(data + offset, buffer, size);
+		else
+			memcpy(buffer, data + offset, size);
+	}
 
 	/// Read from memory, with no alignment or size restrictions.
 	///
@@ -412,6 +692,34 @@ public:
 	///	in argument \a access.
 	char *getBuffer(unsigned address, unsigned size, AccessType access);
 
+	/// Obtain the host buffers holding the memory content of a region, to
+	/// be used as the scatter/gather list of host system calls such as
+	/// readv() or writev(). Buffers adjacent in host memory are merged.
+	///
+	/// \param address
+	///	Memory address
+	///
+	/// \param size
+	///	Number of bytes requested
+	///
+	/// \param access
+	///	Type of access requested. For AccessWrite, pages are prepared to
+	///	be modified through the buffers as getBuffer() does. For
+	///	AccessRead, pages without data are represented by a buffer of
+	///	zeros, which must not be modified.
+	///
+	/// \param iovecs
+	///	Vector where buffers are appended
+	///
+	/// \return
+	///	The function returns false, without modifying \a iovecs, if a
+	///	page in the region is not mapped, or if the memory is on safe
+	///	mode and a page does not have the permissions requested in \a
+	///	access. The caller can then access the region with Read() or
+	///	Write() to report the fault.
+	bool getIovecs(unsigned address, unsigned size, AccessType access,
+			std::vector<struct iovec> &iovecs);
+
 	/// Save a subset of the memory space into a file
 	///
 	/// \param path
@@ -447,9 +755,44 @@ public:
 	/// Get current heap break.
 	unsigned getHeapBreak() { return heap_break; }
 
-	/// Copy the content and attributes from another memory object
+	/// Watch the pages containing \a size bytes starting at \a address
+	/// for changes. A client caching information derived from the content
+	/// of these pages, such as decoded instructions, can compare the value
+	/// returned by getCodeVersion() to detect that the information is no
+	/// longer valid. The function returns false if any of the pages is
+	/// not allocated, in which case it cannot be watched.
+	bool WatchCode(unsigned address, unsigned size);
+
+	/// Return a counter incremented every time that a page watched with
+	/// WatchCode() is written, unmapped, or has its permissions changed.
+	/// Pages stop being watched after a change.
+	long long getCodeVersion() const { return code_version; }
+
+	/// Copy the content and attributes from another memory object. Page
+	/// data is shared by both memory objects, and only copied when one of
+	/// them modifies it.
 	void Clone(const Memory &memory);
 
+	/// Return the number of pages whose data was shared by Clone() in all
+	/// memory objects
+	static long long getNumSharedPages() { return num_shared_pages; }
+
+	/// Return the number of pages copied when a memory object modified
+	/// data shared by Clone()
+	static long long getNumCopiedPages() { return num_copied_pages; }
+
+	/// Save all pages, their permissions, and the heap break into a
+	/// checkpoint. Pages are streamed in increasing address order, and
+	/// pages containing only zeros are saved without their data.
+	void SaveCheckpoint(misc::CheckpointWriter &writer) const;
+
+	/// Replace the content of the memory with the pages saved in a
+	/// checkpoint with SaveCheckpoint().
+	///
+	/// \throw
+	///	A misc::Error is thrown if the checkpoint is corrupt.
+	void LoadCheckpoint(misc::CheckpointReader &reader);
+
 };
 
 
@@ -23,6 +23,7 @@
 #include <iomanip>
 
 #include "Frame.h"
+#include "Mmu.h"
 #include "Module.h"
 #include "System.h"
 
@@ -162,14 +163,18 @@ bool Module::canAccess(int address) const
 long long Module::Access(AccessType access_type,
 		unsigned address,
 		int *witness,
-		esim::Event *return_event)
+		esim::Event *return_event,
+		bool *miss,
+		unsigned pc)
 {
 	// Create a new event frame
-	auto frame = misc::new_shared<Frame>(
+	auto frame = esim::new_frame<Frame>(
 			Frame::getNewId(),
 			this,
 			address);
 	frame->witness = witness;
+	frame->miss = miss;
+	frame->pc = pc;
 
 	// Select initial event type
 	esim::Event *event;
@@ -197,6 +202,12 @@ long long Module::Access(AccessType access_type,
 			event = System::event_nc_store;
 			break;
 
+		case AccessPrefetch:
+
+			event = System::event_prefetch;
+			frame->prefetch = true;
+			break;
+
 		default:
 
 			throw misc::Panic("Invalid access type");
@@ -238,6 +249,240 @@ long long Module::Access(AccessType access_type,
 }
 
 
+void Module::UpdatePrefetcher(unsigned pc, unsigned address)
+{
+	// Nothing to do without prefetcher
+	if (!prefetcher)
+		return;
+
+	// A demand access to a block that is still being prefetched makes
+	// the prefetch late
+	Frame *frame = getInFlightAddress(address);
+	if (frame && frame->access_type == AccessPrefetch &&
+			!frame->prefetch_late)
+	{
+		frame->prefetch_late = true;
+		num_late_prefetches++;
+	}
+
+	// Train prefetcher
+	int set_id;
+	int way_id;
+	int tag;
+	Cache::BlockState state;
+	bool hit = FindBlock(address, set_id, way_id, tag, state);
+	bool miss = !hit || cache->getBlock(set_id, way_id)->isPrefetched();
+	prefetch_addresses.clear();
+	prefetcher->Access(pc, address, miss, prefetch_addresses);
+
+	// Issue prefetches
+	for (unsigned prefetch_address : prefetch_addresses)
+	{
+		// Consecutive physical pages are unrelated, so prefetches do
+		// not cross the page of the access.
+		prefetch_address &= ~(block_size - 1);
+		if ((prefetch_address ^ address) & Mmu::PageMask)
+			continue;
+
+		// Skip blocks present, in flight, or served by other modules
+		if (!ServesAddress(prefetch_address) ||
+				isInFlightAddress(prefetch_address) ||
+				FindBlock(prefetch_address, set_id, way_id,
+				tag, state))
+			continue;
+
+		// Prefetches only use free MSHR entries
+		if (!canAccess(prefetch_address))
+			break;
+
+		// Prefetch
+		Access(AccessPrefetch, prefetch_address);
+		num_prefetches++;
+	}
+}
+
+
+void Module::WarmUpBlock(unsigned address, bool write, Module *requester)
+{
+	// Look for the block, evicting a victim on a miss. The set is not
+	// returned by FindBlock() on a miss.
+	unsigned set_id;
+	unsigned way_id;
+	unsigned tag;
+	unsigned block_offset;
+	Cache::BlockState state;
+	bool hit = cache->FindBlock(address, set_id, way_id, state);
+	cache->DecodeAddress(address, set_id, tag, block_offset);
+	if (!hit)
+	{
+		way_id = cache->ReplaceBlock(set_id);
+		WarmUpEvict(set_id, way_id, true);
+		state = Cache::BlockInvalid;
+	}
+
+	// Obtain exclusive permissions. A main memory module is the last
+	// level of the hierarchy, so it always owns the blocks it contains.
+	// A dirty block remains dirty after an upgrade.
+	Cache::BlockState new_state = state;
+	if (type != TypeCache)
+	{
+		new_state = Cache::BlockExclusive;
+	}
+	else if (state != Cache::BlockExclusive &&
+			state != Cache::BlockModified)
+	{
+		Module *low_module = getLowModuleServingAddress(address);
+		low_module->WarmUpBlock(address, false, this);
+		new_state = state == Cache::BlockOwned ||
+				state == Cache::BlockNonCoherent ?
+				Cache::BlockModified : Cache::BlockExclusive;
+	}
+	if (write && type == TypeCache)
+		new_state = Cache::BlockModified;
+
+	// Update block
+	cache->setBlock(set_id, way_id, tag, new_state);
+	cache->AccessBlock(set_id, way_id);
+
+	// Nothing else to do for accesses coming from the processor
+	if (!requester)
+		return;
+
+	// Make the requester the only sharer and owner of the sub-blocks that
+	// it covers, invalidating copies in other higher-level modules.
+	bool dirty = false;
+	unsigned requester_tag = address & ~(requester->block_size - 1);
+	for (int z = 0; z < directory->getNumSubBlocks(); z++)
+	{
+		// Skip sub-blocks not covered by the requester
+		unsigned sub_block_address = tag + z * sub_block_size;
+		if (sub_block_address + sub_block_size <= requester_tag ||
+				sub_block_address >= requester_tag +
+				requester->block_size)
+			continue;
+
+		// Invalidate other sharers
+		for (Module *high_module : high_modules)
+			if (high_module != requester && isSharer(set_id, way_id,
+					z, high_module))
+				dirty |= high_module->WarmUpInvalidate(
+						sub_block_address,
+						sub_block_size);
+
+		// Set requester as the only sharer and owner
+		directory->clearAllSharers(set_id, way_id, z);
+		setSharer(set_id, way_id, z, requester);
+		setOwner(set_id, way_id, z, requester);
+	}
+
+	// Data from invalidated dirty copies is written back here
+	if (dirty && type == TypeCache)
+		cache->setBlock(set_id, way_id, tag, Cache::BlockModified);
+}
+
+
+bool Module::WarmUpEvict(unsigned set_id, unsigned way_id, bool update_low)
+{
+	// Nothing to do for an invalid block
+	unsigned tag;
+	Cache::BlockState state;
+	cache->getBlock(set_id, way_id, tag, state);
+	if (state == Cache::BlockInvalid)
+		return false;
+	bool dirty = state == Cache::BlockModified ||
+			state == Cache::BlockOwned ||
+			state == Cache::BlockNonCoherent;
+
+	// Invalidate copies in higher-level modules, which is required for
+	// inclusion, and clear the directory entries.
+	for (int z = 0; z < directory->getNumSubBlocks(); z++)
+	{
+		unsigned sub_block_address = tag + z * sub_block_size;
+		for (Module *high_module : high_modules)
+			if (isSharer(set_id, way_id, z, high_module))
+				dirty |= high_module->WarmUpInvalidate(
+						sub_block_address,
+						sub_block_size);
+		directory->clearAllSharers(set_id, way_id, z);
+		directory->setOwner(set_id, way_id, z, Directory::NoOwner);
+	}
+
+	// Remove this module from the directory of the lower-level module,
+	// writing back dirty data.
+	if (update_low && type == TypeCache)
+	{
+		Module *low_module = getLowModuleServingAddress(tag);
+		unsigned low_set_id;
+		unsigned low_way_id;
+		Cache::BlockState low_state;
+		if (low_module->cache->FindBlock(tag, low_set_id, low_way_id,
+				low_state))
+		{
+			// Directory
+			unsigned low_tag = tag & ~(low_module->block_size - 1);
+			for (int z = 0; z < low_module->directory->
+					getNumSubBlocks(); z++)
+			{
+				unsigned sub_block_address = low_tag + z *
+						low_module->sub_block_size;
+				if (sub_block_address + low_module->
+						sub_block_size <= tag ||
+						sub_block_address >= tag +
+						block_size)
+					continue;
+				if (low_module->getOwner(low_set_id,
+						low_way_id, z) == this)
+					low_module->setOwner(low_set_id,
+							low_way_id, z,
+							nullptr);
+				low_module->directory->clearSharer(low_set_id,
+						low_way_id, z,
+						low_module->getSharerIndex(this));
+			}
+
+			// Write-back
+			if (dirty && low_module->type == TypeCache)
+			{
+				if (low_state == Cache::BlockExclusive)
+					low_state = Cache::BlockModified;
+				else if (low_state == Cache::BlockShared)
+					low_state = Cache::BlockOwned;
+				low_module->cache->setBlock(low_set_id,
+						low_way_id, low_tag,
+						low_state);
+			}
+		}
+	}
+
+	// Invalidate block
+	cache->setBlock(set_id, way_id, 0, Cache::BlockInvalid);
+	return dirty;
+}
+
+
+bool Module::WarmUpInvalidate(unsigned address, unsigned size)
+{
+	bool dirty = false;
+	for (unsigned block_address = address & ~(block_size - 1);
+			block_address < address + size;
+			block_address += block_size)
+	{
+		unsigned set_id;
+		unsigned way_id;
+		Cache::BlockState state;
+		if (cache->FindBlock(block_address, set_id, way_id, state))
+			dirty |= WarmUpEvict(set_id, way_id, false);
+	}
+	return dirty;
+}
+
+
+void Module::WarmUp(AccessType access_type, unsigned address)
+{
+	WarmUpBlock(address, access_type != AccessLoad, nullptr);
+}
+
+
 void Module::StartAccess(Frame *frame, AccessType access_type)
 {
 	// Record access type
@@ -851,6 +1096,23 @@ void Module::DumpReport(std::ostream &os) const
 	if (type == TypeCache)
 		os << misc::fmt("ConflictInvalidation = %lld\n",
 				num_conflict_invalidations);
+
+	// Statistics - Prefetches
+	if (prefetcher)
+	{
+		os << "\n";
+		os << "Prefetcher = " << Prefetcher::TypeMap[prefetcher_type]
+				<< "\n";
+		os << misc::fmt("Prefetches = %lld\n", num_prefetches);
+		os << misc::fmt("UsefulPrefetches = %lld\n",
+				num_useful_prefetches);
+		os << misc::fmt("LatePrefetches = %lld\n",
+				num_late_prefetches);
+		os << misc::fmt("UselessPrefetches = %lld\n",
+				cache->getNumUselessPrefetches());
+		os << misc::fmt("DroppedPrefetches = %lld\n",
+				num_dropped_prefetches);
+	}
 	
 	// Separating line between modules
 	os << "\n\n";
@@ -1174,7 +1436,7 @@ void Module::Flush(int *witness)
 	esim::Engine *esim_engine = esim::Engine::getInstance();
 
 	// Create a new event frame
-	auto new_frame = misc::new_shared<Frame>(
+	auto new_frame = esim::new_frame<Frame>(
 			Frame::getNewId(),
 			this,
 			0);
@@ -1227,7 +1489,7 @@ void Module::FlushCache()
 			esim::Engine *esim_engine = esim::Engine::getInstance();
 
 			// Create new frame
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					this,
 					frame->tag);
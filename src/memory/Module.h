@@ -32,6 +32,7 @@
 
 #include "Cache.h"
 #include "Directory.h"
+#include "Prefetcher.h"
 
 
 // Forward declarations
@@ -74,7 +75,8 @@ public:
 		AccessInvalid = 0,
 		AccessLoad,
 		AccessStore,
-		AccessNCStore
+		AccessNCStore,
+		AccessPrefetch
 	};
 
 	// Port in a memory module
@@ -251,6 +253,46 @@ private:
 	// List of next-level modules, closer to main memory
 	std::vector<Module *> low_modules;
 
+
+
+
+	//
+	// Prefetching
+	//
+
+	// Prefetcher type
+	Prefetcher::Type prefetcher_type = Prefetcher::TypeNone;
+
+	// Prefetcher, or nullptr if the module does not prefetch
+	std::unique_ptr<Prefetcher> prefetcher;
+
+	// Addresses returned by the prefetcher for the current access
+	std::vector<unsigned> prefetch_addresses;
+
+
+
+
+	//
+	// Functional warm-up (see WarmUp())
+	//
+
+	// Bring the block containing the given address into the module with
+	// exclusive permissions, on behalf of the higher-level module \a
+	// requester, or on behalf of the processor if \a requester is nullptr.
+	// All other copies of the block in higher-level modules are
+	// invalidated.
+	void WarmUpBlock(unsigned address, bool write, Module *requester);
+
+	// Evict the block in the given set and way, invalidating the copies of
+	// the block in higher-level modules. If \a update_low is true, the
+	// module is also removed from the directory of the lower-level module.
+	// The function returns true if any of the evicted copies was dirty.
+	bool WarmUpEvict(unsigned set_id, unsigned way_id, bool update_low);
+
+	// Invalidate all blocks in the module overlapping the given address
+	// range, returning true if any of them was dirty.
+	bool WarmUpInvalidate(unsigned address, unsigned size);
+
 	
 
 
@@ -268,6 +310,11 @@ private:
 
 	long long num_conflict_invalidations = 0;
 
+	long long num_prefetches = 0;
+	long long num_useful_prefetches = 0;
+	long long num_late_prefetches = 0;
+	long long num_dropped_prefetches = 0;
+
 public:
 	
 	// Statistics for up-down accesses
@@ -372,6 +419,31 @@ public:
 	/// Set the MSHR size in number of entries
 	void setMSHRSize(int mshr_size) { this->mshr_size = mshr_size; }
 
+	/// Attach a prefetcher of the given type to the module, returning at
+	/// most \a degree blocks to prefetch for each access.
+	void setPrefetcher(Prefetcher::Type type, int degree)
+	{
+		prefetcher_type = type;
+		prefetcher = Prefetcher::Create(type, block_size, degree);
+	}
+
+	/// Return the prefetcher attached to the module, or nullptr if none.
+	Prefetcher *getPrefetcher() const { return prefetcher.get(); }
+
+	/// Return the number of prefetches issued
+	long long getNumPrefetches() const { return num_prefetches; }
+
+	/// Return the number of prefetched blocks later used by a demand
+	/// access
+	long long getNumUsefulPrefetches() const { return num_useful_prefetches; }
+
+	/// Return the number of prefetches reached by a demand access while
+	/// still in flight
+	long long getNumLatePrefetches() const { return num_late_prefetches; }
+
+	/// Return the number of prefetches cancelled
+	long long getNumDroppedPrefetches() const { return num_dropped_prefetches; }
+
 	/// Return whether the module can be accessed. A module can be accessed
 	/// if there are available ports and enough room in the MSHR register.
 	bool canAccess(int address) const;
@@ -641,6 +713,16 @@ public:
 	///	current frame will be available within the event handler of
 	///	\a return_event. Use \c nullptr (default) for no return event.
 	///
+	/// \param miss
+	///	Pointer to a boolean variable that will be set to true if the
+	///	access is a load or a store that misses in this module. This
+	///	argument is optional, and can be set to \c nullptr.
+	///
+	/// \param pc
+	///	Address of the instruction causing the access, used to train
+	///	the prefetchers of the modules that it reaches. This argument
+	///	is optional, and can be set to 0 if unknown.
+	///
 	/// \return frame_id
 	///	The function returns a unique identifier of the new memory
 	///	access.
@@ -648,8 +730,31 @@ public:
 	long long Access(AccessType access_type,
 			unsigned address,
 			int *witness = nullptr,
-			esim::Event *return_event = nullptr);
+			esim::Event *return_event = nullptr,
+			bool *miss = nullptr,
+			unsigned pc = 0);
+
+	/// Notify the prefetcher of the module of a demand access to \a
+	/// address by the instruction at \a pc, and issue accesses of type
+	/// AccessPrefetch for the blocks that it returns. Blocks already
+	/// present or in flight in the module, blocks in a different page,
+	/// and blocks that find no free MSHR entry are not prefetched. This
+	/// function is invoked internally by the event handlers of the first
+	/// NMOESI event for a demand access received by the module.
+	void UpdatePrefetcher(unsigned pc, unsigned address);
 	
+	/// Update the state of the caches and directories in the memory
+	/// hierarchy starting at this module as if an access of type \a
+	/// access_type to \a address had completed, but without simulating
+	/// its timing or generating any event. This is used to warm up caches
+	/// in functional phases of a sampled simulation, and must only be
+	/// invoked while there is no access in flight in the hierarchy.
+	///
+	/// Blocks are always brought with exclusive permissions, invalidating
+	/// copies in other modules, so warm-up does not reproduce read
+	/// sharing among caches.
+	void WarmUp(AccessType access_type, unsigned address);
+
 	/// Add the given frame to the list of in-flight accesses, and record
 	/// its access type. This function is invoked internally by the event
 	/// handlers of the first NMOESI event for an access.
@@ -827,6 +932,13 @@ public:
 	/// Increment the number of accesses to the data.
 	void incDataAccesses() { num_data_accesses++; }
 
+	/// Increment the number of demand accesses to prefetched blocks.
+	void incUsefulPrefetches() { num_useful_prefetches++; }
+
+	/// Increment the number of prefetches cancelled because the block
+	/// was found in the module or could not be brought.
+	void incDroppedPrefetches() { num_dropped_prefetches++; }
+
 	/// Update the following statistics based on the information collected
 	/// from the given frame:
 	///
@@ -0,0 +1,227 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lib/cpp/Error.h>
+#include <lib/cpp/String.h>
+
+#include "PageArena.h"
+
+
+namespace mem
+{
+
+bool PageArena::huge_pages = false;
+
+bool PageArena::concurrent = false;
+
+
+PageArena::PageArena(size_t frame_size) :
+		frame_size(frame_size)
+{
+	assert(frame_size >= sizeof(FreeFrame));
+	assert(chunk_size % frame_size == 0);
+}
+
+
+PageArena *PageArena::getInstance(size_t frame_size)
+{
+	static PageArena *arena = new PageArena(frame_size);
+	assert(arena->frame_size == frame_size);
+	return arena;
+}
+
+
+void PageArena::AllocateChunk()
+{
+	// Map chunk. Memory returned by the host is initialized to zero.
+	void *chunk = mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (chunk == MAP_FAILED)
+		throw misc::Panic(misc::fmt("Cannot map %d bytes for guest "
+				"memory pages", (int) chunk_size));
+
+	// Transparent huge pages are only a hint, ignore failures
+#ifdef MADV_HUGEPAGE
+	if (huge_pages)
+		madvise(chunk, chunk_size, MADV_HUGEPAGE);
+#endif
+
+	// Start allocating from the new chunk
+	chunks.push_back(static_cast<char *>(chunk));
+	chunk_next = static_cast<char *>(chunk);
+	chunk_end = chunk_next + chunk_size;
+}
+
+
+char *PageArena::Allocate()
+{
+	// Update statistics
+	Lock();
+	num_in_use++;
+
+	// Recycle a frame from the free list. It is cleared after releasing
+	// the lock.
+	if (free_list)
+	{
+		char *frame = reinterpret_cast<char *>(free_list);
+		free_list = free_list->next;
+		Unlock();
+		memset(frame, 0, frame_size);
+		return frame;
+	}
+
+	// Take a new frame from the current chunk
+	if (chunk_next == chunk_end)
+		AllocateChunk();
+	char *frame = chunk_next;
+	chunk_next += frame_size;
+	Unlock();
+	return frame;
+}
+
+
+void PageArena::Free(char *frame)
+{
+	// Release a reference to a shared frame
+	assert(frame);
+	Lock();
+	auto it = shared_frames.find(frame);
+	if (it != shared_frames.end())
+	{
+		if (--it->second == 1)
+			shared_frames.erase(it);
+		Unlock();
+		return;
+	}
+
+	// Release a frame mapped from a file
+	if (!file_mappings.empty() && FreeFileFrame(frame))
+	{
+		Unlock();
+		return;
+	}
+
+	// Recycle frame
+	FreeFrame *free_frame = reinterpret_cast<FreeFrame *>(frame);
+	free_frame->next = free_list;
+	free_list = free_frame;
+	num_in_use--;
+	Unlock();
+}
+
+
+char *PageArena::MapFile(int fd, off_t offset, int num_frames)
+{
+	// Frames must match host pages
+	assert(num_frames > 0);
+	if ((size_t) sysconf(_SC_PAGESIZE) != frame_size ||
+			offset % frame_size)
+		return nullptr;
+
+	// Map file
+	size_t size = num_frames * frame_size;
+	void *region = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fd, offset);
+	if (region == MAP_FAILED)
+		return nullptr;
+
+	// Record region
+	struct stat file_stat;
+	if (fstat(fd, &file_stat))
+	{
+		munmap(region, size);
+		return nullptr;
+	}
+	Lock();
+	FileMapping &mapping = file_mappings[static_cast<char *>(region)];
+	mapping.size = size;
+	mapping.num_frames = num_frames;
+	mapping.device = file_stat.st_dev;
+	mapping.inode = file_stat.st_ino;
+	mapping.detached = false;
+	Unlock();
+	return static_cast<char *>(region);
+}
+
+
+void PageArena::DetachFile(int fd)
+{
+	// Nothing to do if no file is mapped
+	struct stat file_stat;
+	if (file_mappings.empty() || fstat(fd, &file_stat))
+		return;
+
+	// Replace the regions of the file
+	Lock();
+	for (auto &it : file_mappings)
+	{
+		// Skip other files
+		FileMapping &mapping = it.second;
+		if (mapping.detached || mapping.device != file_stat.st_dev ||
+				mapping.inode != file_stat.st_ino)
+			continue;
+
+		// Copy the region, including frames already written, into
+		// anonymous memory mapped at the same address
+		std::unique_ptr<char[]> copy(new char[mapping.size]);
+		memcpy(copy.get(), it.first, mapping.size);
+		void *region = mmap(it.first, mapping.size,
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+				-1, 0);
+		if (region == MAP_FAILED)
+			throw misc::Panic(misc::fmt("Cannot map %d bytes for "
+					"guest memory pages",
+					(int) mapping.size));
+		memcpy(it.first, copy.get(), mapping.size);
+		mapping.detached = true;
+	}
+	Unlock();
+}
+
+
+bool PageArena::FreeFileFrame(char *frame)
+{
+	// Find the region with the highest start not above the frame
+	auto it = file_mappings.upper_bound(frame);
+	if (it == file_mappings.begin())
+		return false;
+	--it;
+	FileMapping &mapping = it->second;
+	if (frame >= it->first + mapping.size)
+		return false;
+
+	// Unmap region after its last frame is released
+	if (!--mapping.num_frames)
+	{
+		munmap(it->first, mapping.size);
+		file_mappings.erase(it);
+	}
+	return true;
+}
+
+
+}  // namespace mem
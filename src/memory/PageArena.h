@@ -0,0 +1,211 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MEMORY_PAGE_ARENA_H
+#define MEMORY_PAGE_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+
+namespace mem
+{
+
+/// Allocator for the data of guest memory pages. Host memory is mapped in
+/// large chunks with MAP_NORESERVE, so that it only takes physical memory
+/// once touched, and frames released by unmapped pages are recycled by the
+/// next allocation. The arena is shared by all memory objects, and never
+/// destroyed, since pages of static memory objects can still be released
+/// at the end of the program.
+///
+/// A frame can be shared by pages of several memory objects to implement
+/// copy-on-write. Only shared frames have a reference count, kept in a hash
+/// table, since most frames are only referenced by one page.
+///
+/// Frames can also be mapped privately from a host file with MapFile(),
+/// which avoids copying the content of files mapped by guest programs.
+/// Frames that were not written yet read the file, so reading them past
+/// the end of the file after it is truncated raises SIGBUS. Truncations
+/// done by guest programs must be preceded by a call to DetachFile().
+///
+/// The arena is only protected by a lock when guest memories are accessed
+/// from several host threads at the same time (see setConcurrent()).
+class PageArena
+{
+	// Frame in the free list. The memory of a free frame is reused to
+	// store the pointer to the next free frame.
+	struct FreeFrame
+	{
+		FreeFrame *next;
+	};
+
+	// Size of each frame in bytes
+	size_t frame_size;
+
+	// Size of each chunk mapped from the host in bytes
+	static const size_t chunk_size = 4 << 20;
+
+	// Whether chunks are advised to be backed by transparent huge pages
+	static bool huge_pages;
+
+	// Whether frames are allocated, released, and shared by several
+	// threads
+	static bool concurrent;
+
+	// Chunks mapped so far
+	std::vector<char *> chunks;
+
+	// Next unused frame in the last chunk, and end of the last chunk
+	char *chunk_next = nullptr;
+	char *chunk_end = nullptr;
+
+	// Head of the list of free frames
+	FreeFrame *free_list = nullptr;
+
+	// Number of frames currently allocated
+	long long num_in_use = 0;
+
+	// Number of references to frames referenced more than once
+	std::unordered_map<char *, int> shared_frames;
+
+	// Region of frames mapped from a host file
+	struct FileMapping
+	{
+		// Size of the region in bytes
+		size_t size;
+
+		// Number of frames of the region not released yet
+		int num_frames;
+
+		// Device and inode of the file, used to find the regions
+		// mapped from a file in DetachFile()
+		dev_t device;
+		ino_t inode;
+
+		// Whether the region was replaced by a copy in anonymous
+		// memory, and no longer depends on the file
+		bool detached;
+	};
+
+	// Regions mapped from host files, indexed by their first frame
+	std::map<char *, FileMapping> file_mappings;
+
+	// Release a frame of a region mapped from a host file, unmapping the
+	// region when it was its last frame. Return false if the frame does
+	// not belong to any region.
+	bool FreeFileFrame(char *frame);
+
+	// Lock taken by all operations on frames in concurrent mode
+	std::atomic_flag lock = ATOMIC_FLAG_INIT;
+
+	// Acquire and release the arena lock, if in concurrent mode
+	void Lock()
+	{
+		if (concurrent)
+			while (lock.test_and_set(std::memory_order_acquire))
+				;
+	}
+	void Unlock()
+	{
+		if (concurrent)
+			lock.clear(std::memory_order_release);
+	}
+
+	// Map a new chunk from the host when the current one is full
+	void AllocateChunk();
+
+	// Constructor
+	PageArena(size_t frame_size);
+
+public:
+
+	/// Return the arena for frames of \a frame_size bytes, created on
+	/// first use. Only one frame size is supported during the execution
+	/// of the program.
+	static PageArena *getInstance(size_t frame_size);
+
+	/// Advise the host kernel to back chunks mapped from now on with
+	/// transparent huge pages
+	static void setHugePages(bool huge_pages)
+	{
+		PageArena::huge_pages = huge_pages;
+	}
+
+	/// Select whether frames can be allocated, released, and shared from
+	/// several host threads at the same time. It must only be changed
+	/// while no other thread accesses guest memory.
+	static void setConcurrent(bool concurrent)
+	{
+		PageArena::concurrent = concurrent;
+	}
+
+	/// Return a frame with all bytes set to zero
+	char *Allocate();
+
+	/// Release a reference to a frame returned by Allocate(). The frame
+	/// is recycled when its last reference is released.
+	void Free(char *frame);
+
+	/// Return \a num_frames consecutive frames with the content of the
+	/// host file \a fd starting at \a offset, which must be aligned to
+	/// the frame size. The frames are a private copy-on-write mapping of
+	/// the file, so they can be modified without changing the file. Each
+	/// frame is released with Free(). The function returns null if the
+	/// host cannot map the file.
+	char *MapFile(int fd, off_t offset, int num_frames);
+
+	/// Replace the frames mapped from the host file with descriptor \a fd
+	/// by a copy in anonymous memory at the same addresses, so that they
+	/// stay valid if the file is truncated. This function must be invoked
+	/// before truncating a file that could be mapped.
+	void DetachFile(int fd);
+
+	/// Add a reference to a frame, which becomes shared
+	void Share(char *frame)
+	{
+		Lock();
+		shared_frames.emplace(frame, 1).first->second++;
+		Unlock();
+	}
+
+	/// Return whether a frame has more than one reference
+	bool isShared(char *frame)
+	{
+		Lock();
+		bool shared = !shared_frames.empty() &&
+				shared_frames.count(frame);
+		Unlock();
+		return shared;
+	}
+
+	/// Return the number of frames currently allocated
+	long long getNumInUse() const { return num_in_use; }
+
+	/// Return the number of chunks mapped from the host
+	int getNumChunks() const { return chunks.size(); }
+};
+
+
+}  // namespace mem
+
+#endif
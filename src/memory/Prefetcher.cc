@@ -0,0 +1,320 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdlib>
+
+#include <lib/cpp/Error.h>
+#include <lib/cpp/Misc.h>
+
+#include "Prefetcher.h"
+
+
+namespace mem
+{
+
+const misc::StringMap Prefetcher::TypeMap =
+{
+	{ "None", TypeNone },
+	{ "NextLine", TypeNextLine },
+	{ "IpStride", TypeIpStride },
+	{ "Stream", TypeStream },
+	{ "Ghb", TypeGhb }
+};
+
+
+std::unique_ptr<Prefetcher> Prefetcher::Create(Type type,
+		int block_size,
+		int degree)
+{
+	int log_block_size = misc::LogBase2(block_size);
+	switch (type)
+	{
+
+	case TypeNone:
+
+		return nullptr;
+
+	case TypeNextLine:
+
+		return misc::new_unique<NextLinePrefetcher>(log_block_size,
+				degree);
+
+	case TypeIpStride:
+
+		return misc::new_unique<IpStridePrefetcher>(log_block_size,
+				degree);
+
+	case TypeStream:
+
+		return misc::new_unique<StreamPrefetcher>(log_block_size,
+				degree);
+
+	case TypeGhb:
+
+		return misc::new_unique<GhbPrefetcher>(log_block_size,
+				degree);
+	}
+
+	throw misc::Panic("Invalid prefetcher type");
+}
+
+
+
+
+//
+// Class 'NextLinePrefetcher'
+//
+
+void NextLinePrefetcher::Access(unsigned pc,
+		unsigned address,
+		bool miss,
+		std::vector<unsigned> &addresses)
+{
+	// Only misses trigger prefetches
+	if (!miss)
+		return;
+
+	// Following blocks
+	unsigned block = address >> log_block_size;
+	for (int i = 1; i <= degree; i++)
+		addresses.push_back((block + i) << log_block_size);
+}
+
+
+
+
+//
+// Class 'IpStridePrefetcher'
+//
+
+void IpStridePrefetcher::Access(unsigned pc,
+		unsigned address,
+		bool miss,
+		std::vector<unsigned> &addresses)
+{
+	// Allocate entry for a new instruction
+	Entry &entry = entries[(pc ^ pc >> 8) % NumEntries];
+	if (!entry.valid || entry.pc != pc)
+	{
+		entry.pc = pc;
+		entry.address = address;
+		entry.stride = 0;
+		entry.confidence = 0;
+		entry.valid = true;
+		return;
+	}
+
+	// Nothing learned from the same address
+	int stride = address - entry.address;
+	if (!stride)
+		return;
+	entry.address = address;
+
+	// Update confidence. A stride is replaced only after it stops
+	// repeating long enough.
+	if (stride == entry.stride)
+	{
+		if (entry.confidence < MaxConfidence)
+			entry.confidence++;
+	}
+	else if (entry.confidence)
+	{
+		entry.confidence--;
+	}
+	else
+	{
+		entry.stride = stride;
+	}
+	if (entry.confidence < ConfidenceThreshold)
+		return;
+
+	// Blocks accessed by the next strides, skipping those that fall in
+	// the block accessed last
+	unsigned last_block = address >> log_block_size;
+	int count = 0;
+	for (int i = 1; i <= MaxSteps && count < degree; i++)
+	{
+		unsigned block = (address + entry.stride * i) >> log_block_size;
+		if (block == last_block)
+			continue;
+		addresses.push_back(block << log_block_size);
+		last_block = block;
+		count++;
+	}
+}
+
+
+
+
+//
+// Class 'StreamPrefetcher'
+//
+
+void StreamPrefetcher::Access(unsigned pc,
+		unsigned address,
+		bool miss,
+		std::vector<unsigned> &addresses)
+{
+	// Only misses train the streams
+	if (!miss)
+		return;
+	time++;
+
+	// Find stream close to the block
+	unsigned block = address >> log_block_size;
+	Stream *stream = nullptr;
+	for (Stream &candidate : streams)
+	{
+		if (candidate.valid && std::abs((int) (block -
+				candidate.block)) <= Window)
+		{
+			stream = &candidate;
+			break;
+		}
+	}
+
+	// Allocate a new stream, replacing the least recently used one
+	if (!stream)
+	{
+		stream = &streams[0];
+		for (Stream &candidate : streams)
+			if (!candidate.valid || (stream->valid &&
+					candidate.time < stream->time))
+				stream = &candidate;
+		stream->block = block;
+		stream->direction = 0;
+		stream->confidence = 0;
+		stream->time = time;
+		stream->valid = true;
+		return;
+	}
+
+	// Nothing learned from the same block
+	stream->time = time;
+	int delta = block - stream->block;
+	if (!delta)
+		return;
+
+	// Update direction
+	int direction = delta > 0 ? 1 : -1;
+	if (direction == stream->direction)
+	{
+		if (stream->confidence < ConfidenceThreshold)
+			stream->confidence++;
+	}
+	else
+	{
+		stream->direction = direction;
+		stream->confidence = 1;
+	}
+	stream->block = block;
+	if (stream->confidence < ConfidenceThreshold)
+		return;
+
+	// Blocks ahead in the stream
+	for (int i = 1; i <= degree; i++)
+		addresses.push_back((block + direction * i) << log_block_size);
+}
+
+
+
+
+//
+// Class 'GhbPrefetcher'
+//
+
+GhbPrefetcher::HistoryEntry *GhbPrefetcher::getHistoryEntry(long long sequence)
+{
+	// Not recorded or already overwritten
+	if (sequence < 0 || sequence < num_misses - HistorySize)
+		return nullptr;
+	return &history[sequence % HistorySize];
+}
+
+
+void GhbPrefetcher::Access(unsigned pc,
+		unsigned address,
+		bool miss,
+		std::vector<unsigned> &addresses)
+{
+	// Only misses are recorded
+	if (!miss)
+		return;
+
+	// Allocate index table entry for a new instruction
+	IndexEntry &index = index_table[(pc ^ pc >> 8) % IndexTableSize];
+	if (!index.valid || index.pc != pc)
+	{
+		index.pc = pc;
+		index.head = -1;
+		index.valid = true;
+	}
+
+	// Ignore repeated misses to the same block
+	unsigned block = address >> log_block_size;
+	HistoryEntry *last = getHistoryEntry(index.head);
+	if (last && last->block == block)
+		return;
+
+	// Record miss
+	long long sequence = num_misses++;
+	HistoryEntry &entry = history[sequence % HistorySize];
+	entry.block = block;
+	entry.link = index.head;
+	entry.sequence = sequence;
+	index.head = sequence;
+
+	// Deltas between the misses of the instruction, from the most recent
+	deltas.clear();
+	unsigned next_block = block;
+	for (HistoryEntry *previous = getHistoryEntry(entry.link);
+			previous && (int) deltas.size() < MaxHistory - 1;
+			previous = getHistoryEntry(previous->link))
+	{
+		deltas.push_back(next_block - previous->block);
+		next_block = previous->block;
+	}
+	if (deltas.size() < 3)
+		return;
+
+	// Find the last two deltas earlier in the history
+	int position = 0;
+	for (int i = 1; i + 1 < (int) deltas.size(); i++)
+	{
+		if (deltas[i] == deltas[0] && deltas[i + 1] == deltas[1])
+		{
+			position = i;
+			break;
+		}
+	}
+	if (!position)
+		return;
+
+	// Replay the deltas that followed them, which repeat with a period of
+	// 'position' deltas
+	unsigned prefetch_block = block;
+	for (int i = 0; i < degree; i++)
+	{
+		prefetch_block += deltas[position - 1 - i % position];
+		addresses.push_back(prefetch_block << log_block_size);
+	}
+}
+
+
+}  // namespace mem
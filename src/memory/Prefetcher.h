@@ -0,0 +1,329 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MEMORY_PREFETCHER_H
+#define MEMORY_PREFETCHER_H
+
+#include <memory>
+#include <vector>
+
+#include <lib/cpp/String.h>
+
+
+namespace mem
+{
+
+/// Hardware prefetcher attached to a cache module. The prefetcher observes
+/// the demand accesses received by the module, and returns the addresses of
+/// the blocks that should be brought into the module ahead of time. The
+/// module is in charge of filtering out blocks that are already present or
+/// in flight, and of issuing the prefetch accesses.
+class Prefetcher
+{
+public:
+
+	/// Prefetcher types
+	enum Type
+	{
+		TypeNone = 0,
+		TypeNextLine,
+		TypeIpStride,
+		TypeStream,
+		TypeGhb
+	};
+
+	/// String map for Type
+	static const misc::StringMap TypeMap;
+
+protected:
+
+	// Log base 2 of the block size of the module
+	int log_block_size;
+
+	// Maximum number of blocks returned for each access
+	int degree;
+
+public:
+
+	/// Constructor
+	Prefetcher(int log_block_size, int degree) :
+			log_block_size(log_block_size),
+			degree(degree)
+	{
+	}
+
+	/// Destructor
+	virtual ~Prefetcher() {}
+
+	/// Create a prefetcher of the given type for a module with blocks of
+	/// \a block_size bytes, returning at most \a degree blocks for each
+	/// access.
+	static std::unique_ptr<Prefetcher> Create(Type type,
+			int block_size,
+			int degree);
+
+	/// Observe a demand access.
+	///
+	/// \param pc
+	///	Address of the instruction that caused the access, or 0 if
+	///	unknown.
+	///
+	/// \param address
+	///	Physical address accessed.
+	///
+	/// \param miss
+	///	True if the access misses in the module, or if it is the first
+	///	access to a block brought by a prefetch. Prefetchers trained
+	///	with misses also use the latter, so that they keep running
+	///	ahead of the accesses that they already cover.
+	///
+	/// \param addresses
+	///	Addresses of the blocks to prefetch are added here.
+	///
+	virtual void Access(unsigned pc,
+			unsigned address,
+			bool miss,
+			std::vector<unsigned> &addresses) = 0;
+};
+
+
+/// Prefetcher bringing the blocks that follow a missing block
+class NextLinePrefetcher : public Prefetcher
+{
+public:
+
+	/// Constructor
+	NextLinePrefetcher(int log_block_size, int degree) :
+			Prefetcher(log_block_size, degree)
+	{
+	}
+
+	/// Observe an access
+	void Access(unsigned pc,
+			unsigned address,
+			bool miss,
+			std::vector<unsigned> &addresses) override;
+};
+
+
+/// Prefetcher detecting constant strides between the addresses accessed by
+/// the same instruction, in a table indexed by instruction address.
+class IpStridePrefetcher : public Prefetcher
+{
+public:
+
+	/// Number of entries in the table
+	static const int NumEntries = 256;
+
+	/// Confidence needed to prefetch
+	static const int ConfidenceThreshold = 2;
+
+	/// Maximum confidence
+	static const int MaxConfidence = 3;
+
+	/// Maximum number of strides to walk looking for blocks other than
+	/// the one accessed, for strides smaller than a block.
+	static const int MaxSteps = 64;
+
+private:
+
+	// Entry of the table
+	struct Entry
+	{
+		// Instruction address
+		unsigned pc = 0;
+
+		// Last address accessed
+		unsigned address = 0;
+
+		// Last stride observed
+		int stride = 0;
+
+		// Number of consecutive times that the stride repeated
+		int confidence = 0;
+
+		// Entry in use
+		bool valid = false;
+	};
+
+	// Table
+	Entry entries[NumEntries];
+
+public:
+
+	/// Constructor
+	IpStridePrefetcher(int log_block_size, int degree) :
+			Prefetcher(log_block_size, degree)
+	{
+	}
+
+	/// Observe an access
+	void Access(unsigned pc,
+			unsigned address,
+			bool miss,
+			std::vector<unsigned> &addresses) override;
+};
+
+
+/// Prefetcher following streams of misses to consecutive blocks, in either
+/// direction. A stream is allocated on a miss, confirmed once further misses
+/// move away from its first block in the same direction, and then prefetches
+/// the blocks ahead of each miss.
+class StreamPrefetcher : public Prefetcher
+{
+public:
+
+	/// Number of streams tracked
+	static const int NumStreams = 16;
+
+	/// Maximum distance in blocks between a miss and the last block of a
+	/// stream for the miss to belong to it
+	static const int Window = 8;
+
+	/// Number of misses in the same direction needed to prefetch
+	static const int ConfidenceThreshold = 2;
+
+private:
+
+	// Stream
+	struct Stream
+	{
+		// Last block accessed
+		unsigned block = 0;
+
+		// Direction (+1 or -1), or 0 if not known yet
+		int direction = 0;
+
+		// Number of misses in the direction of the stream
+		int confidence = 0;
+
+		// Time of the last miss, for replacement
+		long long time = 0;
+
+		// Stream in use
+		bool valid = false;
+	};
+
+	// Streams
+	Stream streams[NumStreams];
+
+	// Number of misses observed, used as a time stamp
+	long long time = 0;
+
+public:
+
+	/// Constructor
+	StreamPrefetcher(int log_block_size, int degree) :
+			Prefetcher(log_block_size, degree)
+	{
+	}
+
+	/// Observe an access
+	void Access(unsigned pc,
+			unsigned address,
+			bool miss,
+			std::vector<unsigned> &addresses) override;
+};
+
+
+/// Delta-correlating prefetcher based on a global history buffer (GHB),
+/// localized by instruction address (PC/DC). Misses are recorded in a
+/// circular buffer, where the entries of each instruction are linked
+/// together from an index table. On a miss, the last two deltas between the
+/// blocks missed by the instruction are looked up in its older history, and
+/// the deltas that followed them are replayed from the current block.
+class GhbPrefetcher : public Prefetcher
+{
+public:
+
+	/// Number of entries in the index table
+	static const int IndexTableSize = 256;
+
+	/// Number of entries in the global history buffer
+	static const int HistorySize = 256;
+
+	/// Maximum number of misses of an instruction considered
+	static const int MaxHistory = 16;
+
+private:
+
+	// Entry of the index table
+	struct IndexEntry
+	{
+		// Instruction address
+		unsigned pc = 0;
+
+		// Sequence number of the last miss of the instruction, or -1
+		long long head = -1;
+
+		// Entry in use
+		bool valid = false;
+	};
+
+	// Entry of the global history buffer
+	struct HistoryEntry
+	{
+		// Block missed
+		unsigned block = 0;
+
+		// Sequence number of the previous miss of the same
+		// instruction, or -1
+		long long link = -1;
+
+		// Sequence number of this miss
+		long long sequence = -1;
+	};
+
+	// Index table
+	IndexEntry index_table[IndexTableSize];
+
+	// Global history buffer, where the miss with sequence number 's' is
+	// stored at position 's % HistorySize' until it is overwritten
+	HistoryEntry history[HistorySize];
+
+	// Number of misses recorded
+	long long num_misses = 0;
+
+	// Deltas between the misses of the current instruction, from the
+	// most recent one
+	std::vector<int> deltas;
+
+	// Return the entry of the global history buffer with the given
+	// sequence number, or nullptr if it was overwritten
+	HistoryEntry *getHistoryEntry(long long sequence);
+
+public:
+
+	/// Constructor
+	GhbPrefetcher(int log_block_size, int degree) :
+			Prefetcher(log_block_size, degree)
+	{
+	}
+
+	/// Observe an access
+	void Access(unsigned pc,
+			unsigned address,
+			bool miss,
+			std::vector<unsigned> &addresses) override;
+};
+
+
+}  // namespace mem
+
+#endif
@@ -109,6 +109,7 @@ class System
 	static void EventLoadHandler(esim::Event *, esim::Frame *);
 	static void EventStoreHandler(esim::Event *, esim::Frame *);
 	static void EventNCStoreHandler(esim::Event *, esim::Frame *);
+	static void EventPrefetchHandler(esim::Event *, esim::Frame *);
 	static void EventFindAndLockHandler(esim::Event *, esim::Frame *);
 	static void EventEvictHandler(esim::Event *, esim::Frame *);
 	static void EventWriteRequestHandler(esim::Event *, esim::Frame *);
@@ -318,6 +319,13 @@ public:
 	static esim::Event *event_nc_store_unlock;
 	static esim::Event *event_nc_store_finish;
 
+	static esim::Event *event_prefetch;
+	static esim::Event *event_prefetch_lock;
+	static esim::Event *event_prefetch_action;
+	static esim::Event *event_prefetch_miss;
+	static esim::Event *event_prefetch_unlock;
+	static esim::Event *event_prefetch_finish;
+
 	static esim::Event *event_find_and_lock;
 	static esim::Event *event_find_and_lock_port;
 	static esim::Event *event_find_and_lock_action;
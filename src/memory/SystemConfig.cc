@@ -170,6 +170,16 @@ const std::string System::help_message =
 	"      it is resolved, but releases the cache port.\n"
 	"  DirectoryLatency = <cycles> (Default = 1)\n"
 	"      Latency for a directory access in number of cycles.\n"
+	"  Prefetcher = {None|NextLine|IpStride|Stream|Ghb} (Default = None)\n"
+	"      Hardware prefetcher attached to the cache. 'NextLine' brings the\n"
+	"      blocks following a miss. 'IpStride' detects constant strides between\n"
+	"      the accesses of each instruction. 'Stream' follows streams of misses\n"
+	"      to consecutive blocks. 'Ghb' replays repeating sequences of deltas\n"
+	"      between the misses of each instruction, recorded in a global history\n"
+	"      buffer. Prefetches only use free MSHR entries, and do not cross 4KB\n"
+	"      page boundaries.\n"
+	"  PrefetchDegree = <num> (Default = 2)\n"
+	"      Maximum number of blocks prefetched after each access.\n"
 	"\n"
 	"Section [Network <net>] defines an internal default interconnect, formed of\n"
 	"a single switch connecting all modules pointing to the network. For every\n"
@@ -276,6 +286,14 @@ void System::ConfigReadGeneral(misc::IniFile *ini_file)
 
 void System::ConfigReadNetworks(misc::IniFile *ini_file)
 {
+	// Modules send and receive messages within a cycle, so the memory and
+	// network frequency domains share a partition of the parallel
+	// event-driven engine
+	net::System *net_system = net::System::getInstance();
+	esim::Engine *esim_engine = esim::Engine::getInstance();
+	esim_engine->CoupleFrequencyDomains(frequency_domain,
+			net_system->getFrequencyDomain());
+
 	// Create networks
 	debug << "Creating internal networks:\n";
 	for (auto it = ini_file->sections_begin(),
@@ -500,6 +518,10 @@ Module *System::ConfigReadCache(misc::IniFile *ini_file,
 			"WritePolicy", "WriteBack");
 	int mshr_size = ini_file->ReadInt(geometry_section, "MSHR", 16);
 	int num_ports = ini_file->ReadInt(geometry_section, "Ports", 2);
+	std::string prefetcher_str = ini_file->ReadString(geometry_section,
+			"Prefetcher", "None");
+	int prefetch_degree = ini_file->ReadInt(geometry_section,
+			"PrefetchDegree", 2);
 
 	// Check replacement policy
 	Cache::ReplacementPolicy replacement_policy =
@@ -532,6 +554,18 @@ Module *System::ConfigReadCache(misc::IniFile *ini_file,
 				ini_file->getPath().c_str(),
 				module_name.c_str(),
 				write_policy_str.c_str());
+
+	// Check prefetcher
+	bool error;
+	Prefetcher::Type prefetcher_type = (Prefetcher::Type)
+			Prefetcher::TypeMap.MapString(prefetcher_str, error);
+	if (error)
+		throw Error(misc::fmt("%s: Cache %s: %s: "
+				"Invalid prefetcher.\n%s",
+				ini_file->getPath().c_str(),
+				module_name.c_str(),
+				prefetcher_str.c_str(),
+				err_config_note));
 	
 	// Other checks
 	if (num_sets < 1 || (num_sets & (num_sets - 1)))
@@ -576,6 +610,12 @@ Module *System::ConfigReadCache(misc::IniFile *ini_file,
 				ini_file->getPath().c_str(),
 				module_name.c_str(),
 				err_config_note));
+	if (prefetch_degree < 1)
+		throw Error(misc::fmt("%s: cache %s: invalid value for "
+				"variable 'PrefetchDegree'.\n%s",
+				ini_file->getPath().c_str(),
+				module_name.c_str(),
+				err_config_note));
 
 	// Create module
 	Module *module = addModule(module_name,
@@ -587,6 +627,7 @@ Module *System::ConfigReadCache(misc::IniFile *ini_file,
 	// Initialize module
 	module->setDirectoryProperties(num_sets, num_ways, directory_latency);
 	module->setMSHRSize(mshr_size);
+	module->setPrefetcher(prefetcher_type, prefetch_degree);
 
 	// High network
 	std::string network_name = ini_file->ReadString(section, "HighNetwork");
@@ -1107,6 +1148,11 @@ void System::ConfigReadEntries(misc::IniFile *ini_file)
 		// its own ways to process entries to the memory hierarchy.
 		comm::Timing *timing = arch->getTiming();
 		timing->ParseMemoryConfigurationEntry(ini_file, section);
+
+		// The architecture accesses the memory system within a cycle
+		esim::Engine *esim_engine = esim::Engine::getInstance();
+		esim_engine->CoupleFrequencyDomains(frequency_domain,
+				timing->getFrequencyDomain());
 	}
 
 	// After processing all [Entry <name>] sections, check that all
@@ -47,6 +47,13 @@ esim::Event *System::event_nc_store_miss;
 esim::Event *System::event_nc_store_unlock;
 esim::Event *System::event_nc_store_finish;
 
+esim::Event *System::event_prefetch;
+esim::Event *System::event_prefetch_lock;
+esim::Event *System::event_prefetch_action;
+esim::Event *System::event_prefetch_miss;
+esim::Event *System::event_prefetch_unlock;
+esim::Event *System::event_prefetch_finish;
+
 esim::Event *System::event_find_and_lock;
 esim::Event *System::event_find_and_lock_port;
 esim::Event *System::event_find_and_lock_action;
@@ -145,14 +152,14 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.new_access "
-				"name=\"A-%lld\" "
-				"type=\"load\" "
-				"state=\"%s:load\" "
-				"addr=0x%x\n",
-				frame->getId(),
-				module->getName().c_str(),
-				frame->getAddress());
+		trace.Line("mem.new_access")
+				.Name("name", "A-", frame->getId())
+				.String("type", "load")
+				.String("state", module->getName(), ":load")
+				.Hex("addr", frame->getAddress());
+
+		// Train prefetcher
+		module->UpdatePrefetcher(frame->pc, frame->getAddress());
 
 		// Record access
 		module->StartAccess(frame, Module::AccessLoad);
@@ -183,11 +190,10 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:load_lock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":load_lock");
 
 		// If there is any older write, wait for it
 		Frame *older_frame = module->getInFlightWrite(frame);
@@ -215,7 +221,7 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 		}
 
 		// Call "find_and_lock" event chain
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				frame->getAddress());
@@ -239,10 +245,10 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access name=\"A-%lld\" "
-				"state=\"%s:load_action\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":load_action");
 
 		// Error locking
 		if (frame->error)
@@ -270,12 +276,15 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 		}
 
 		// Miss
-		auto new_frame = misc::new_shared<Frame>(
+		if (frame->miss)
+			*frame->miss = true;
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				frame->tag);
 		new_frame->target_module = module->getLowModuleServingAddress(frame->tag);
 		new_frame->request_direction = Frame::RequestDirectionUpDown;
+		new_frame->pc = frame->pc;
 		esim_engine->Call(event_read_request,
 				new_frame,
 				event_load_miss);
@@ -294,11 +303,10 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:load_miss\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":load_miss");
 
 		// Error on read request. Unlock block and retry load.
 		if (frame->error)
@@ -344,11 +352,10 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:load_unlock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":load_unlock");
 
 		// Unlock directory entry
 		directory->UnlockEntry(frame->set,
@@ -374,14 +381,12 @@ void System::EventLoadHandler(esim::Event *event, esim::Frame *esim_frame)
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:load_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
-		trace << misc::fmt("mem.end_access "
-				"name=\"A-%lld\"\n",
-				frame->getId());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":load_finish");
+		trace.Line("mem.end_access")
+				.Name("name", "A-", frame->getId());
 
 		// Increment witness variable
 		if (frame->witness)
@@ -430,13 +435,14 @@ void System::EventStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.new_access "
-				"name=\"A-%lld\" "
-				"type=\"store\" "
-				"state=\"%s:store\" addr=0x%x\n",
-				frame->getId(),
-				module->getName().c_str(),
-				frame->getAddress());
+		trace.Line("mem.new_access")
+				.Name("name", "A-", frame->getId())
+				.String("type", "store")
+				.String("state", module->getName(), ":store")
+				.Hex("addr", frame->getAddress());
+
+		// Train prefetcher
+		module->UpdatePrefetcher(frame->pc, frame->getAddress());
 
 		// Record access
 		module->StartAccess(frame, Module::AccessStore);
@@ -475,11 +481,10 @@ void System::EventStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:store_lock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":store_lock");
 
 		// If there is any older access, wait for it
 		auto it = frame->accesses_iterator;
@@ -501,7 +506,7 @@ void System::EventStoreHandler(esim::Event *event,
 		}
 
 		// Call 'find-and-lock'
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				frame->getAddress());
@@ -525,11 +530,10 @@ void System::EventStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:store_action\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":store_action");
 
 		// Error locking
 		if (frame->error)
@@ -559,13 +563,16 @@ void System::EventStoreHandler(esim::Event *event,
 
 		// Miss - state=O/S/I/N
 		// Call 'write-request'
-		auto new_frame = misc::new_shared<Frame>(
+		if (frame->miss)
+			*frame->miss = true;
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				frame->getAddress());
 		new_frame->target_module = module->getLowModuleServingAddress(frame->tag);
 		new_frame->request_direction = Frame::RequestDirectionUpDown;
 		new_frame->witness = frame->witness;
+		new_frame->pc = frame->pc;
 
 		// Set the expected reply size. This might change during the
 		// down up write process, and invalidation
@@ -595,11 +602,10 @@ void System::EventStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:store_unlock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":store_unlock");
 
 		// Error in write request, unlock block and retry store.
 		if (frame->error)
@@ -647,14 +653,12 @@ void System::EventStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:store_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
-		trace << misc::fmt("mem.end_access "
-				"name=\"A-%lld\"\n",
-				frame->getId());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":store_finish");
+		trace.Line("mem.end_access")
+				.Name("name", "A-", frame->getId());
 
 		// Finish access
 		module->FinishAccess(frame);
@@ -701,14 +705,14 @@ void System::EventNCStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.new_access "
-				"name=\"A-%lld\" "
-				"type=\"nc_store\" "
-				"state=\"%s:nc store\" "
-				"addr=0x%x\n",
-				frame->getId(),
-				module->getName().c_str(),
-				frame->getAddress());
+		trace.Line("mem.new_access")
+				.Name("name", "A-", frame->getId())
+				.String("type", "nc_store")
+				.String("state", module->getName(), ":nc store")
+				.Hex("addr", frame->getAddress());
+
+		// Train prefetcher
+		module->UpdatePrefetcher(frame->pc, frame->getAddress());
 
 		// Record access
 		module->StartAccess(frame, Module::AccessNCStore);
@@ -740,11 +744,10 @@ void System::EventNCStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:nc_store_lock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":nc_store_lock");
 
 		// If there is any older write, wait for it
 		Frame *older_frame = module->getInFlightWrite(frame);
@@ -777,7 +780,7 @@ void System::EventNCStoreHandler(esim::Event *event,
 		}
 
 		// Call find and lock
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				frame->getAddress());
@@ -800,11 +803,10 @@ void System::EventNCStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:nc_store_writeback\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":nc_store_writeback");
 
 		// Error locking
 		if (frame->error)
@@ -831,7 +833,7 @@ void System::EventNCStoreHandler(esim::Event *event,
 			frame->eviction = true;
 
 			// Call 'evict'
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					module,
 					0);
@@ -857,11 +859,10 @@ void System::EventNCStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:nc_store_action\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":nc_store_action");
 
 		// Error locking
 		if (frame->error)
@@ -907,7 +908,7 @@ void System::EventNCStoreHandler(esim::Event *event,
 		{
 			// E state must tell the lower-level module to remove
 			// this module as an owner. Call 'message'.
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					module,
 					frame->tag);
@@ -927,13 +928,14 @@ void System::EventNCStoreHandler(esim::Event *event,
 			// because we've already evicted the block so that the
 			// lower-level cache will have the latest value before
 			// it becomes non-coherent. Call 'read-request'.
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					module,
 					frame->tag);
 			new_frame->nc_write = true;
 			new_frame->target_module = module->getLowModuleServingAddress(frame->tag);
 			new_frame->request_direction = Frame::RequestDirectionUpDown;
+			new_frame->pc = frame->pc;
 			esim_engine->Call(event_read_request,
 					new_frame,
 					event_nc_store_miss);
@@ -958,11 +960,10 @@ void System::EventNCStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:nc_store_miss\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":nc_store_miss");
 
 		// Error on read request. Unlock block and retry nc store.
 		if (frame->error)
@@ -1000,11 +1001,10 @@ void System::EventNCStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:nc_store_unlock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":nc_store_unlock");
 
 		// Set block state to E/S depending on return var 'shared'.
 		// Also set the tag of the block.
@@ -1034,13 +1034,12 @@ void System::EventNCStoreHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:nc_store_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
-		trace << misc::fmt("mem.end_access name=\"A-%lld\"\n",
-				frame->getId());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":nc_store_finish");
+		trace.Line("mem.end_access")
+				.Name("name", "A-", frame->getId());
 
 		// Increment witness variable
 		if (frame->witness)
@@ -1059,6 +1058,226 @@ void System::EventNCStoreHandler(esim::Event *event,
 }
 
 
+void System::EventPrefetchHandler(esim::Event *event,
+		esim::Frame *esim_frame)
+{
+	// Get engine, frame, and module
+	esim::Engine *esim_engine = esim::Engine::getInstance();
+	Frame *frame = misc::cast<Frame *>(esim_frame);
+	Module *module = frame->getModule();
+	Cache *cache = module->getCache();
+	Directory *directory = module->getDirectory();
+
+	// Event "prefetch"
+	if (event == event_prefetch)
+	{
+		// Several prefetches may have been issued in the same cycle, so
+		// the free MSHR entries are checked again when they start.
+		if (!module->canAccess(frame->getAddress()))
+		{
+			module->incDroppedPrefetches();
+			esim_engine->Return();
+			return;
+		}
+
+		debug << misc::fmt("%lld A-%lld 0x%x %s prefetch\n",
+				esim_engine->getTime(),
+				frame->getId(),
+				frame->getAddress(),
+				module->getName().c_str());
+		trace.Line("mem.new_access")
+				.Name("name", "A-", frame->getId())
+				.String("type", "prefetch")
+				.String("state", module->getName(), ":prefetch")
+				.Hex("addr", frame->getAddress());
+
+		// Record access
+		module->StartAccess(frame, Module::AccessPrefetch);
+
+		// Next event
+		esim_engine->Next(event_prefetch_lock);
+		return;
+	}
+
+	// Event "prefetch_lock"
+	if (event == event_prefetch_lock)
+	{
+		debug << misc::fmt("  %lld A-%lld 0x%x %s prefetch lock\n",
+				esim_engine->getTime(),
+				frame->getId(),
+				frame->getAddress(),
+				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":prefetch_lock");
+
+		// A prefetch never waits. If there is any older access to the
+		// same block, the prefetch is dropped.
+		if (module->getInFlightAddress(frame->getAddress(), frame))
+		{
+			debug << misc::fmt("    A-%lld block in flight, "
+					"dropping prefetch\n",
+					frame->getId());
+			module->incDroppedPrefetches();
+			esim_engine->Next(event_prefetch_finish);
+			return;
+		}
+
+		// Call "find_and_lock" event chain. It is non-blocking, so
+		// that a locked block drops the prefetch instead of delaying
+		// it.
+		auto new_frame = esim::new_frame<Frame>(
+				frame->getId(),
+				module,
+				frame->getAddress());
+		new_frame->request_direction = Frame::RequestDirectionUpDown;
+		new_frame->blocking = false;
+		new_frame->read = true;
+		new_frame->prefetch = true;
+		esim_engine->Call(event_find_and_lock,
+				new_frame,
+				event_prefetch_action);
+		return;
+	}
+
+	// Event "prefetch_action"
+	if (event == event_prefetch_action)
+	{
+		// Debug and trace
+		debug << misc::fmt("  %lld A-%lld 0x%x %s prefetch_action\n",
+				esim_engine->getTime(),
+				frame->getId(),
+				frame->getAddress(),
+				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":prefetch_action");
+
+		// Error locking, drop prefetch
+		if (frame->error)
+		{
+			debug << misc::fmt("    lock error, dropping prefetch\n");
+			module->incDroppedPrefetches();
+			esim_engine->Next(event_prefetch_finish);
+			return;
+		}
+
+		// Hit, nothing to bring
+		if (frame->state)
+		{
+			module->incDroppedPrefetches();
+			esim_engine->Next(event_prefetch_unlock);
+			return;
+		}
+
+		// Miss
+		auto new_frame = esim::new_frame<Frame>(
+				frame->getId(),
+				module,
+				frame->tag);
+		new_frame->target_module = module->getLowModuleServingAddress(frame->tag);
+		new_frame->request_direction = Frame::RequestDirectionUpDown;
+		new_frame->prefetch = true;
+		esim_engine->Call(event_read_request,
+				new_frame,
+				event_prefetch_miss);
+		return;
+	}
+
+	// Event "prefetch_miss"
+	if (event == event_prefetch_miss)
+	{
+		// Debug and trace
+		debug << misc::fmt("  %lld A-%lld 0x%x %s prefetch_miss\n",
+				esim_engine->getTime(),
+				frame->getId(),
+				frame->getAddress(),
+				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":prefetch_miss");
+
+		// Error on read request, drop prefetch
+		if (frame->error)
+		{
+			debug << misc::fmt("    lock error, dropping prefetch\n");
+			module->incDroppedPrefetches();
+			esim_engine->Next(event_prefetch_unlock);
+			return;
+		}
+
+		// Set block state to E/S depending on return var 'shared'.
+		// The block is marked as prefetched, unless a demand access
+		// already claimed it while it was in flight.
+		cache->setBlock(frame->set,
+				frame->way,
+				frame->tag,
+				frame->shared ? Cache::BlockShared : Cache::BlockExclusive);
+		if (!frame->prefetch_late)
+			cache->setPrefetched(frame->set, frame->way, true);
+
+		// Continue
+		esim_engine->Next(event_prefetch_unlock);
+		return;
+	}
+
+	// Event "prefetch_unlock"
+	if (event == event_prefetch_unlock)
+	{
+		// Debug and trace
+		debug << misc::fmt("  %lld A-%lld 0x%x %s "
+				"prefetch unlock\n",
+				esim_engine->getTime(),
+				frame->getId(),
+				frame->getAddress(),
+				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":prefetch_unlock");
+
+		// Unlock directory entry
+		directory->UnlockEntry(frame->set,
+				frame->way,
+				frame->getId());
+
+		// Continue with 'prefetch-finish'
+		esim_engine->Next(event_prefetch_finish);
+		return;
+	}
+
+	// Event "prefetch_finish"
+	if (event == event_prefetch_finish)
+	{
+		// Debug and trace
+		debug << misc::fmt("%lld A-%lld 0x%x %s prefetch_finish\n",
+				esim_engine->getTime(),
+				frame->getId(),
+				frame->getAddress(),
+				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":prefetch_finish");
+		trace.Line("mem.end_access")
+				.Name("name", "A-", frame->getId());
+
+		// Finish access
+		module->FinishAccess(frame);
+
+		// Return
+		esim_engine->Return();
+		return;
+	}
+
+	// Invalid event
+	throw misc::Panic("Invalid event");
+}
+
+
 void System::EventFindAndLockHandler(esim::Event *event,
 		esim::Frame *esim_frame)
 {
@@ -1080,11 +1299,10 @@ void System::EventFindAndLockHandler(esim::Event *event,
 				frame->getAddress(),
 				module->getName().c_str(),
 				frame->blocking);
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:find_and_lock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock");
 
 		// Default return values
 		parent_frame->error = false;
@@ -1110,16 +1328,18 @@ void System::EventFindAndLockHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:find_and_lock_port\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock_port");
 
-		// Statistics
-		module->incAccesses();
-		if (frame->retry)
-			module->incRetryAccesses();
+		// Statistics, only for demand accesses
+		if (!frame->prefetch)
+		{
+			module->incAccesses();
+			if (frame->retry)
+				module->incRetryAccesses();
+		}
 
 		// Set parent frame flag expressing that port has already been 
 		// locked. This flag is checked by new writes to find out if 
@@ -1273,7 +1493,20 @@ void System::EventFindAndLockHandler(esim::Event *event,
 		}
 
 		// Statistics
-		module->UpdateStats(frame);
+		if (!frame->prefetch)
+			module->UpdateStats(frame);
+
+		// The first demand access to a prefetched block makes the
+		// prefetch useful
+		if (frame->hit && !frame->prefetch &&
+				frame->request_direction ==
+				Frame::RequestDirectionUpDown &&
+				cache->getBlock(frame->set, frame->way)->
+				isPrefetched())
+		{
+			cache->setPrefetched(frame->set, frame->way, false);
+			module->incUsefulPrefetches();
+		}
 
 		// Entry is locked. Record the transient tag so that a 
 		// subsequent lookup detects that the block is being brought.
@@ -1303,11 +1536,10 @@ void System::EventFindAndLockHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:find_and_lock_action\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock_action");
 
 		// Release port
 		module->UnlockPort(port, frame);
@@ -1321,7 +1553,7 @@ void System::EventFindAndLockHandler(esim::Event *event,
 			module->incConflictInvalidations();
 
 			// Call 'evict'
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					module,
 					0);
@@ -1353,10 +1585,10 @@ void System::EventFindAndLockHandler(esim::Event *event,
 				frame->tag,
 				module->getName().c_str(),
 				frame->error);
-		trace << misc::fmt("mem.access name=\"A-%lld\" "
-				"state=\"%s:find_and_lock_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock_finish");
 
 		// If evict produced error, return this error
 		if (frame->error)
@@ -1458,10 +1690,9 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->set,
 				frame->way,
 				Cache::BlockStateMap[frame->state]);
-		trace << misc::fmt("mem.access name=\"A-%lld\" "
-				"state=\"%s:evict\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(), ":evict");
 
 		// Save some data
 		frame->src_set = frame->set;
@@ -1470,7 +1701,7 @@ void System::EventEvictHandler(esim::Event *event,
 		frame->target_module = module->getLowModuleServingAddress(frame->tag);
 
 		// Send write request to all sharers
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				0);
@@ -1493,11 +1724,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_invalid\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":evict_invalid");
 
 		// Update the cache state since it may have changed after its 
 		// higher-level modules were invalidated.
@@ -1532,11 +1762,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_action\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":evict_action");
 
 		// Get low node
 		Module *low_module = frame->target_module;
@@ -1579,13 +1808,10 @@ void System::EventEvictHandler(esim::Event *event,
 				event_evict_receive,
 				event);
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 		return;
 	}
 
@@ -1598,11 +1824,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_receive\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":evict_receive");
 
 		// Receive message
 		net::Network *network = target_module->getHighNetwork();
@@ -1610,7 +1835,7 @@ void System::EventEvictHandler(esim::Event *event,
 		network->Receive(node, frame->message);
 
 		// Call find-and-lock
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				target_module,
 				frame->src_tag);
@@ -1638,11 +1863,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_process\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":evict_process");
 
 		// Error locking block
 		if (frame->error)
@@ -1734,11 +1958,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_process_noncoherent\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":evict_process_noncoherent");
 
 		// Error locking block
 		if (frame->error)
@@ -1842,11 +2065,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_reply\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":evict_reply");
 
 		// Send message
 		net::Network *network = target_module->getHighNetwork();
@@ -1858,13 +2080,10 @@ void System::EventEvictHandler(esim::Event *event,
 				event_evict_reply_receive,
 				event);
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 		return;
 	}
 
@@ -1878,11 +2097,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_reply_receive\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":evict_reply_receive");
 
 		// Receive message
 		net::Network *network = module->getLowNetwork();
@@ -1913,11 +2131,10 @@ void System::EventEvictHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:evict_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":evict_finish");
 
 		// Return
 		esim_engine->Return();
@@ -1950,11 +2167,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":write_request");
 
 		// Default return values
 		parent_frame->error = false;
@@ -1990,13 +2206,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				event_write_request_receive,
 				event);
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 		return;
 	}
 
@@ -2010,11 +2223,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_receive\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_receive");
 
 		// Receive message
 		net::Network *network;
@@ -2030,9 +2242,15 @@ void System::EventWriteRequestHandler(esim::Event *event,
 			node = target_module->getLowNetworkNode();
 		}
 		network->Receive(node, frame->message);
+
+		// Train prefetcher with demand requests from higher-level
+		// modules
+		if (frame->request_direction == Frame::RequestDirectionUpDown)
+			target_module->UpdatePrefetcher(frame->pc,
+					frame->getAddress());
 		
 		// Call 'find-and-lock'
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				target_module,
 				frame->getAddress());
@@ -2056,11 +2274,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_action\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_action");
 
 		// Check lock error. If write request is down-up, there should
 		// have been no error.
@@ -2100,7 +2317,7 @@ void System::EventWriteRequestHandler(esim::Event *event,
 
 		// Invalidate the rest of higher-level sharers.
 		// Call 'invalidate' event chain.
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				target_module,
 				frame->getAddress());
@@ -2128,11 +2345,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_exclusive\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_exclusive");
 
 		// Continue with 'write-request-updown' or
 		// 'write-request-downup', depending on direction.
@@ -2152,11 +2368,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_updown\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_updown");
 
 		// Check state
 		switch (frame->state)
@@ -2176,13 +2391,14 @@ void System::EventWriteRequestHandler(esim::Event *event,
 		case Cache::BlockInvalid:
 		case Cache::BlockNonCoherent:
 		{
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					target_module,
 					frame->tag);
 			new_frame->target_module = target_module->
 					getLowModuleServingAddress(frame->tag);
 			new_frame->request_direction = Frame::RequestDirectionUpDown;
+			new_frame->pc = frame->pc;
 			if (frame->state == Cache::BlockInvalid)
 			{
 				new_frame->reply_size = target_module->getBlockSize() 
@@ -2218,11 +2434,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_updown_finish\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_updown_finish");
 
 		// Ensure that a reply was received
 		assert(frame->reply);
@@ -2318,11 +2533,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_downup\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_downup");
 
 		// Sanity
 		assert(frame->state != Cache::BlockInvalid);
@@ -2371,11 +2585,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_downup_finish\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_downup_finish");
 
 		// Set state to I
 		target_cache->setBlock(frame->set, frame->way, 0,
@@ -2427,11 +2640,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->tag,
 				target_module->getName().c_str(),
 				frame->reply_size);
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_reply\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":write_request_reply");
 
 		// Sanity
 		assert(frame->reply_size);
@@ -2462,13 +2674,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				event_write_request_finish,
 				event);
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 		return;
 	}
 
@@ -2482,11 +2691,10 @@ void System::EventWriteRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:write_request_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":write_request_finish");
 
 		// Receive message
 		net::Network *network;
@@ -2542,11 +2750,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":read_request");
 
 		// Default return values
 		parent_frame->shared = false;
@@ -2587,13 +2794,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				event_read_request_receive,
 				event);
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 		return;
 	}
 
@@ -2606,11 +2810,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_receive\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_receive");
 
 		// Receive message
 		if (frame->request_direction == Frame::RequestDirectionUpDown)
@@ -2625,6 +2828,13 @@ void System::EventReadRequestHandler(esim::Event *event,
 			net::EndNode *node = target_module->getLowNetworkNode();
 			network->Receive(node, frame->message);
 		}
+
+		// Train prefetcher with demand requests from higher-level
+		// modules
+		if (frame->request_direction == Frame::RequestDirectionUpDown &&
+				!frame->prefetch)
+			target_module->UpdatePrefetcher(frame->pc,
+					frame->getAddress());
 		
 		// Call 'find-and-lock'
 		// TODO Read requests should always be able to be blocking.  
@@ -2632,7 +2842,7 @@ void System::EventReadRequestHandler(esim::Event *event,
 		// only need to hit and not have ownership.  We would never 
 		// cross paths with a request coming down-up because we would
 		// hit before that.
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				target_module,
 				frame->getAddress());
@@ -2640,6 +2850,7 @@ void System::EventReadRequestHandler(esim::Event *event,
 		new_frame->blocking = frame->request_direction ==
 				Frame::RequestDirectionDownUp;
 		new_frame->read = true;
+		new_frame->prefetch = frame->prefetch;
 		new_frame->retry = false;
 		esim_engine->Call(event_find_and_lock,
 				new_frame,
@@ -2656,11 +2867,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_action\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_action");
 
 		// Check block locking error. If read request is down-up, 
 		// there should not have been any error while locking.
@@ -2710,11 +2920,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_updown\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_updown");
 
 		// One pending request initially
 		frame->pending = 1;
@@ -2769,7 +2978,7 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->pending++;
 
 				// Call 'read-request'
-				auto new_frame = misc::new_shared<Frame>(
+				auto new_frame = esim::new_frame<Frame>(
 						frame->getId(),
 						target_module,
 						directory_entry_tag);
@@ -2790,12 +2999,14 @@ void System::EventReadRequestHandler(esim::Event *event,
 			assert(!directory->isBlockSharedOrOwned(frame->set, frame->way));
 
 			// Call 'read-request'
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					target_module,
 					frame->tag);
 			new_frame->target_module = target_module->getLowModuleServingAddress(frame->tag);
 			new_frame->request_direction = Frame::RequestDirectionUpDown;
+			new_frame->prefetch = frame->prefetch;
+			new_frame->pc = frame->pc;
 			esim_engine->Call(event_read_request,
 					new_frame,
 					event_read_request_updown_miss);
@@ -2813,11 +3024,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_updown_miss\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_updown_miss");
 
 		// Check error
 		if (frame->error)
@@ -2871,11 +3081,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_updown_finish\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_updown_finish");
 
 		// If blocks were sent directly to the peer, the reply size
 		// would have been decreased.  Based on the final size, we can
@@ -2992,11 +3201,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_downup\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_downup");
 
 		// Check: state must not be invalid or shared. By default, only
 		// one pending request. Response depends on state.
@@ -3035,7 +3243,7 @@ void System::EventReadRequestHandler(esim::Event *event,
 			frame->pending++;
 
 			// Call 'read-request'
-			auto new_frame = misc::new_shared<Frame>(
+			auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					target_module,
 					directory_entry_tag);
@@ -3067,11 +3275,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				target_module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_downup_finish\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_downup_finish");
 
 		// Check reply type
 		switch (frame->reply)
@@ -3190,11 +3397,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->tag,
 				target_module->getName().c_str(),
 				frame->reply_size);
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_reply\"\n",
-				frame->getId(),
-				target_module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", target_module->getName(),
+						":read_request_reply");
 
 		// Checks
 		assert(frame->reply_size);
@@ -3229,13 +3435,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				event_read_request_finish,
 				event);
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 		return;
 	}
 
@@ -3249,11 +3452,10 @@ void System::EventReadRequestHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:read_request_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":read_request_finish");
 
 		// Receive message
 		net::Network *network;
@@ -3308,10 +3510,10 @@ void System::EventInvalidateHandler(esim::Event *event,
 				frame->set,
 				frame->way,
 				Cache::BlockStateMap[frame->state]);
-		trace << misc::fmt("mem.access name=\"A-%lld\" "
-				"state=\"%s:invalidate\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":invalidate");
 
 		// At least one pending reply
 		frame->pending = 1;
@@ -3374,7 +3576,7 @@ void System::EventInvalidateHandler(esim::Event *event,
 				frame->pending++;
 
 				// Send write request upwards if beginning of block
-				auto new_frame = misc::new_shared<Frame>(
+				auto new_frame = esim::new_frame<Frame>(
 						frame->getId(),
 						module,
 						directory_entry_tag);
@@ -3400,11 +3602,10 @@ void System::EventInvalidateHandler(esim::Event *event,
 				frame->getId(),
 				frame->tag,
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:invalidate_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":invalidate_finish");
 
 		// TODO The following line updates the block state.  We must
 		// be sure that the directory entry is always locked if we
@@ -3502,13 +3703,10 @@ void System::EventMessageHandler(esim::Event *event,
 
 		// Trace
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 
 		return;
 	}
@@ -3530,7 +3728,7 @@ void System::EventMessageHandler(esim::Event *event,
 		network->Receive(node, frame->message);
 
 		// Find and lock
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 					frame->getId(),
 					target_module,
 					frame->getAddress());
@@ -3634,13 +3832,10 @@ void System::EventMessageHandler(esim::Event *event,
 
 		// Trace
 		if (frame->message)
-			net::System::trace << misc::fmt("net.msg_access "
-					"net=\"%s\" "
-					"name=\"M-%lld\" "
-					"access=\"A-%lld\"\n",
-					network->getName().c_str(),
-					frame->message->getId(),
-					frame->getId());
+			net::System::trace.Line("net.msg_access")
+					.String("net", network->getName())
+					.Name("name", "M-", frame->message->getId())
+					.Name("access", "A-", frame->getId());
 		return;
 	}
 
@@ -3690,14 +3885,11 @@ void System::EventFlushHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.new_access "
-				"name=\"A-%lld\" "
-				"type=\"flush\" "
-				"state=\"%s:flush\" "
-				"addr=0x%x\n",
-				frame->getId(),
-				module->getName().c_str(),
-				frame->getAddress());
+		trace.Line("mem.new_access")
+				.Name("name", "A-", frame->getId())
+				.String("type", "flush")
+				.String("state", module->getName(), ":flush")
+				.Hex("addr", frame->getAddress());
 
 		// Set pending replies to 1
 		frame->pending = 1;
@@ -3722,8 +3914,8 @@ void System::EventFlushHandler(esim::Event *event,
 			return;
 
 		// Trace
-		trace << misc::fmt("mem.end_access name=\"A-%lld\"\n",
-				frame->getId());
+		trace.Line("mem.end_access")
+				.Name("name", "A-", frame->getId());
 
 		// Increment the witness pointer if one was provided
 		if (frame->witness)
@@ -3756,13 +3948,11 @@ void System::EventLocalLoadHandler(esim::Event *event,
 				frame->getAddress(),
 				module->getName().c_str());
 		// Trace
-		trace << misc::fmt("mem.new_access "
-				"name=\"A-%lld\" "
-				"type=\"store\" "
-				"state=\"%s:store\" addr=0x%x\n",
-				frame->getId(),
-				module->getName().c_str(),
-				frame->getAddress());
+		trace.Line("mem.new_access")
+				.Name("name", "A-", frame->getId())
+				.String("type", "store")
+				.String("state", module->getName(), ":store")
+				.Hex("addr", frame->getAddress());
 
 		// Record access
 		module->StartAccess(frame, Module::AccessLoad);
@@ -3796,11 +3986,10 @@ void System::EventLocalLoadHandler(esim::Event *event,
 				frame->getId(),
 				frame->getAddress(),
 				module->getName().c_str());
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:load_lock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":load_lock");
 
 		// If there is any older write, wait for it
 		Frame *older_frame = module->getInFlightWrite(frame);
@@ -3828,7 +4017,7 @@ void System::EventLocalLoadHandler(esim::Event *event,
 		}
 
 		// Call "find_and_lock" event chain
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				frame->getAddress());
@@ -3853,16 +4042,14 @@ void System::EventLocalLoadHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:load_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":load_finish");
 
 		// Trace
-		trace << misc::fmt("mem.end_access "
-				"name=\"A-%lld\"\n",
-				frame->getId());
+		trace.Line("mem.end_access")
+				.Name("name", "A-", frame->getId());
 
 		// Increment witness variable
 		if (frame->witness)
@@ -3900,13 +4087,11 @@ void System::EventLocalStoreHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.new_access "
-				"name=\"A-%lld\" "
-				"type=\"store\" "
-				"state=\"%s:store\" addr=0x%x\n",
-				frame->getId(),
-				module->getName().c_str(),
-				frame->getAddress());
+		trace.Line("mem.new_access")
+				.Name("name", "A-", frame->getId())
+				.String("type", "store")
+				.String("state", module->getName(), ":store")
+				.Hex("addr", frame->getAddress());
 
 		// Record access
 		module->StartAccess(frame, Module::AccessStore);
@@ -3947,11 +4132,10 @@ void System::EventLocalStoreHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:store_lock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":store_lock");
 
 		// If there is any older access, wait for it
 		auto it = frame->accesses_iterator;
@@ -3973,7 +4157,7 @@ void System::EventLocalStoreHandler(esim::Event *event,
 		}
 
 		// Call 'find-and-lock'
-		auto new_frame = misc::new_shared<Frame>(
+		auto new_frame = esim::new_frame<Frame>(
 				frame->getId(),
 				module,
 				frame->getAddress());
@@ -4003,16 +4187,14 @@ void System::EventLocalStoreHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:store_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":store_finish");
 
 		// Trace
-		trace << misc::fmt("mem.end_access "
-				"name=\"A-%lld\"\n",
-				frame->getId());
+		trace.Line("mem.end_access")
+				.Name("name", "A-", frame->getId());
 
 		// Finish access
 		module->FinishAccess(frame);
@@ -4046,11 +4228,10 @@ void System::EventLocalFindAndLockHandler(esim::Event *event,
 				frame->getAddress(),
 				module->getName().c_str(),
 				frame->blocking);
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:find_and_lock\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock");
 
 		// Default return values
 		parent_frame->error = false;
@@ -4079,11 +4260,10 @@ void System::EventLocalFindAndLockHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:find_and_lock_port\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock_port");
 
 		// Set parent frame flag expressing that port has already been
 		// locked. This flag is checked by new writes to find out if
@@ -4136,11 +4316,10 @@ void System::EventLocalFindAndLockHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:find_and_lock_action\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock_action");
 
 		// Release port
 		module->UnlockPort(port, frame);
@@ -4163,11 +4342,10 @@ void System::EventLocalFindAndLockHandler(esim::Event *event,
 				module->getName().c_str());
 
 		// Trace
-		trace << misc::fmt("mem.access "
-				"name=\"A-%lld\" "
-				"state=\"%s:find_and_lock_finish\"\n",
-				frame->getId(),
-				module->getName().c_str());
+		trace.Line("mem.access")
+				.Name("name", "A-", frame->getId())
+				.String("state", module->getName(),
+						":find_and_lock_finish");
 		
 		// Return esim engine
 		esim_engine->Return();
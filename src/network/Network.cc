@@ -953,7 +953,7 @@ Message *Network::Send(EndNode *source_node,
 				packet->getId(), message->getId());
 		
 		// Create event frame
-		auto frame = misc::new_shared<Frame>(packet);
+		auto frame = esim::new_frame<Frame>(packet);
 
 		// The packet will be received automatically if the user didn't
 		// pass any receive event
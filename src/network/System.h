@@ -217,6 +217,12 @@ public:
 		return it == network_map.end() ? nullptr : it->second;
 	}
 
+	/// Return the network frequency domain
+	esim::FrequencyDomain *getFrequencyDomain() const
+	{
+		return frequency_domain;
+	}
+
 	/// Return the current cycle in the network frequency domain.
 	long long getCycle() const
 	{
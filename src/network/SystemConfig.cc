@@ -179,6 +179,12 @@ void System::ParseConfiguration(misc::IniFile *ini_file)
 	frequency_domain = esim->RegisterFrequencyDomain("network", 
 			frequency);
 
+	// Network events run in the domain registered by the constructor,
+	// which must share a partition of the parallel event-driven engine
+	// with the configured domain
+	esim->CoupleFrequencyDomains(frequency_domain,
+			event_send->getFrequencyDomain());
+
 	// First configuration look-up is for networks
 	for (int i = 0; i < ini_file->getNumSections(); i++)
 	{
@@ -0,0 +1,118 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <gtest/gtest.h>
+
+#include <arch/southern-islands/emulator/NDRange.h>
+#include <arch/southern-islands/emulator/Wavefront.h>
+#include <arch/southern-islands/emulator/WorkGroup.h>
+#include <arch/southern-islands/timing/ComputeUnit.h>
+#include <arch/southern-islands/timing/Gpu.h>
+#include <arch/southern-islands/timing/Timing.h>
+#include <lib/cpp/IniFile.h>
+#include <lib/cpp/Misc.h>
+#include <lib/esim/Engine.h>
+
+namespace SI
+{
+
+static void Cleanup()
+{
+	esim::Engine::Destroy();
+	Timing::Destroy();
+	comm::ArchPool::Destroy();
+}
+
+
+// This test checks that a compute unit whose only wavefront waits for an
+// outstanding memory access is quiescent, while the same compute unit with
+// a wavefront ready to fetch is not.
+TEST(TestComputeUnit, is_quiescent)
+{
+	// Cleanup singleton instances
+	Cleanup();
+
+	// Default configuration. The frequency is given explicitly, since
+	// other tests leave an invalid value in the static configuration.
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(
+			"[ Device ]\n"
+			"Frequency = 1000");
+	try
+	{
+		Timing::ParseConfiguration(&ini_file);
+	}
+	catch (misc::Error &error)
+	{
+		FAIL() << error.getMessage();
+	}
+	Timing *timing = Timing::getInstance();
+	Gpu *gpu = timing->getGpu();
+	ComputeUnit *compute_unit = gpu->getComputeUnit(0);
+
+	// Compute units without work groups are quiescent until the stall
+	// check fires
+	EXPECT_TRUE(compute_unit->isQuiescent());
+	EXPECT_TRUE(gpu->isQuiescent());
+	EXPECT_EQ(gpu->last_complete_cycle + comm::Timing::MaxStallCycles + 1,
+			timing->getQuiescentUntil());
+
+	// Map a work group with one wavefront
+	auto ndrange = misc::new_unique<NDRange>();
+	unsigned global_size[1] = { 64 };
+	unsigned local_size[1] = { 64 };
+	ndrange->SetupSize(global_size, local_size, 1);
+	gpu->MapNDRange(ndrange.get());
+	auto work_group = misc::new_unique<WorkGroup>(ndrange.get(), 0);
+	ASSERT_EQ(1u, work_group->getWavefrontsInWorkgroup());
+	compute_unit->MapWorkGroup(work_group.get());
+	Wavefront *wavefront = work_group->getWavefront(0);
+	WavefrontPoolEntry *entry = wavefront->getWavefrontPoolEntry();
+	ASSERT_TRUE(entry);
+
+	// The wavefront is ready to fetch
+	EXPECT_TRUE(entry->ready);
+	EXPECT_FALSE(compute_unit->isQuiescent());
+	EXPECT_FALSE(gpu->isQuiescent());
+	EXPECT_EQ(0, timing->getQuiescentUntil());
+
+	// The wavefront waits for a vector memory access
+	entry->mem_wait = true;
+	entry->vm_cnt = 1;
+	EXPECT_TRUE(compute_unit->isQuiescent());
+	EXPECT_TRUE(gpu->isQuiescent());
+
+	// The access completed, so the wavefront resumes in the next cycle
+	entry->vm_cnt = 0;
+	EXPECT_FALSE(compute_unit->isQuiescent());
+
+	// The wavefront waits at a barrier
+	entry->mem_wait = false;
+	entry->wait_for_barrier = true;
+	EXPECT_TRUE(compute_unit->isQuiescent());
+
+	// The wavefront becomes ready in the next cycle
+	entry->ready_next_cycle = true;
+	EXPECT_FALSE(compute_unit->isQuiescent());
+
+	// Release the compute unit before the work group
+	Cleanup();
+}
+
+} // namespace SI
@@ -0,0 +1,109 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+#include <arch/x86/emulator/Bbv.h>
+#include <lib/cpp/Error.h>
+
+
+namespace x86
+{
+
+// Execute a loop with a basic block of 'size' instructions at 'address'
+static void ExecuteLoop(Bbv &bbv, unsigned address, int size, int iterations)
+{
+	for (int i = 0; i < iterations; i++)
+		for (int j = 0; j < size; j++)
+			bbv.Execute(address + j * 4, j == size - 1);
+}
+
+
+// Read all lines of a file
+static std::vector<std::string> ReadLines(const std::string &path)
+{
+	std::vector<std::string> lines;
+	std::ifstream f(path);
+	std::string line;
+	while (std::getline(f, line))
+		lines.push_back(line);
+	return lines;
+}
+
+
+// Tests that basic block vectors are dumped in SimPoint format, and that two
+// program phases produce two simulation points.
+TEST(TestBbv, test_phases)
+{
+	// Temporary file prefix
+	char path[] = "/tmp/m2s.XXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_NE(-1, fd);
+	close(fd);
+	std::string prefix = path;
+
+	// Two phases alternating, with intervals of 100 instructions
+	{
+		Bbv bbv(prefix, 100);
+		for (int phase = 0; phase < 6; phase++)
+		{
+			if (phase % 2)
+				ExecuteLoop(bbv, 0x2000, 10, 40);
+			else
+				ExecuteLoop(bbv, 0x1000, 4, 100);
+		}
+		EXPECT_EQ(2, bbv.getNumBlocks());
+		EXPECT_EQ(24, bbv.getNumIntervals());
+	}
+
+	// Basic block vectors
+	std::vector<std::string> lines = ReadLines(prefix + ".bb");
+	ASSERT_EQ(24u, lines.size());
+	EXPECT_EQ("T:1:100 ", lines[0]);
+	EXPECT_EQ("T:2:100 ", lines[4]);
+
+	// One simulation point in each phase, with the same weight
+	lines = ReadLines(prefix + ".simpoints");
+	ASSERT_EQ(2u, lines.size());
+	lines = ReadLines(prefix + ".weights");
+	ASSERT_EQ(2u, lines.size());
+	EXPECT_EQ("0.500000 0", lines[0]);
+	EXPECT_EQ("0.500000 1", lines[1]);
+
+	// Clean up
+	remove(path);
+	remove((prefix + ".bb").c_str());
+	remove((prefix + ".simpoints").c_str());
+	remove((prefix + ".weights").c_str());
+}
+
+
+// Tests that the profile cannot be created in an invalid path
+TEST(TestBbv, test_invalid_path)
+{
+	EXPECT_THROW(Bbv bbv("/nonexistent/m2s", 100), misc::Error);
+}
+
+
+}  // namespace x86
+
@@ -0,0 +1,272 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <sstream>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <arch/common/Arch.h>
+#include <arch/x86/emulator/Context.h>
+#include <arch/x86/emulator/Emulator.h>
+#include <arch/x86/emulator/Reactor.h>
+#include <lib/cpp/Error.h>
+#include <lib/esim/Engine.h>
+
+
+namespace x86
+{
+
+// Entry point and data of the static binary created by WriteBinary()
+static const unsigned binary_entry = 0x08048080;
+static const unsigned binary_data = 0x08049000;
+
+
+// Write a 32-bit static executable in a temporary file and return its path.
+// The program forks with clone(), and both processes sum a sequence of 20000
+// numbers that depends on whether they are the parent or the child, storing
+// the sum in memory at each step. The child exits with its sum as the exit
+// code, and the parent waits for it and writes its own sum followed by the
+// exit status of the child to the standard output.
+static std::string WriteBinary()
+{
+	std::vector<char> buffer(0x1200);
+
+	// ELF header
+	Elf32_Ehdr *ehdr = (Elf32_Ehdr *) buffer.data();
+	memcpy(ehdr->e_ident, ELFMAG, SELFMAG);
+	ehdr->e_ident[EI_CLASS] = ELFCLASS32;
+	ehdr->e_ident[EI_DATA] = ELFDATA2LSB;
+	ehdr->e_ident[EI_VERSION] = EV_CURRENT;
+	ehdr->e_type = ET_EXEC;
+	ehdr->e_machine = EM_386;
+	ehdr->e_version = EV_CURRENT;
+	ehdr->e_entry = binary_entry;
+	ehdr->e_phoff = sizeof(Elf32_Ehdr);
+	ehdr->e_ehsize = sizeof(Elf32_Ehdr);
+	ehdr->e_phentsize = sizeof(Elf32_Phdr);
+	ehdr->e_phnum = 2;
+	ehdr->e_shoff = 0x1100;
+	ehdr->e_shentsize = sizeof(Elf32_Shdr);
+	ehdr->e_shnum = 2;
+	ehdr->e_shstrndx = 1;
+
+	// Code and data segments
+	Elf32_Phdr *phdr = (Elf32_Phdr *) (buffer.data() + ehdr->e_phoff);
+	const unsigned segments[2][4] = {
+		{ 0, 0x08048000, 0x100, PF_R | PF_X },
+		{ 0x1000, binary_data, 0x100, PF_R | PF_W }
+	};
+	for (int i = 0; i < 2; i++)
+	{
+		phdr[i].p_type = PT_LOAD;
+		phdr[i].p_offset = segments[i][0];
+		phdr[i].p_vaddr = segments[i][1];
+		phdr[i].p_paddr = segments[i][1];
+		phdr[i].p_filesz = segments[i][2];
+		phdr[i].p_memsz = segments[i][2];
+		phdr[i].p_flags = segments[i][3];
+		phdr[i].p_align = 0x1000;
+	}
+
+	// Code
+	const unsigned char code[] = {
+		0xb8, 0x78, 0x00, 0x00, 0x00,		// mov eax, 120 (clone)
+		0xbb, 0x11, 0x00, 0x00, 0x00,		// mov ebx, SIGCHLD
+		0x31, 0xc9,				// xor ecx, ecx
+		0x31, 0xd2,				// xor edx, edx
+		0x31, 0xf6,				// xor esi, esi
+		0x31, 0xff,				// xor edi, edi
+		0xcd, 0x80,				// int 0x80
+		0x31, 0xdb,				// xor ebx, ebx
+		0x85, 0xc0,				// test eax, eax
+		0x0f, 0x95, 0xc3,			// setnz bl
+		0x31, 0xc9,				// xor ecx, ecx
+		0xba, 0x20, 0x4e, 0x00, 0x00,		// mov edx, 20000
+		0x01, 0xd1,				// loop: add ecx, edx
+		0x01, 0xd9,				// add ecx, ebx
+		0x89, 0x0d, 0x00, 0x90, 0x04, 0x08,	// mov [data], ecx
+		0x4a,					// dec edx
+		0x75, 0xf3,				// jnz loop
+		0x85, 0xdb,				// test ebx, ebx
+		0x74, 0x2d,				// jz child
+		0xb8, 0x07, 0x00, 0x00, 0x00,		// mov eax, 7 (waitpid)
+		0xbb, 0xff, 0xff, 0xff, 0xff,		// mov ebx, -1
+		0xb9, 0x04, 0x90, 0x04, 0x08,		// mov ecx, data + 4
+		0x31, 0xd2,				// xor edx, edx
+		0xcd, 0x80,				// int 0x80
+		0xb8, 0x04, 0x00, 0x00, 0x00,		// mov eax, 4 (write)
+		0xbb, 0x01, 0x00, 0x00, 0x00,		// mov ebx, 1
+		0xb9, 0x00, 0x90, 0x04, 0x08,		// mov ecx, data
+		0xba, 0x08, 0x00, 0x00, 0x00,		// mov edx, 8
+		0xcd, 0x80,				// int 0x80
+		0x31, 0xdb,				// xor ebx, ebx
+		0xeb, 0x02,				// jmp exit
+		0x89, 0xcb,				// child: mov ebx, ecx
+		0xb8, 0x01, 0x00, 0x00, 0x00,		// exit: mov eax, 1
+		0xcd, 0x80				// int 0x80
+	};
+	memcpy(buffer.data() + 0x80, code, sizeof code);
+
+	// Section header string table, the only section
+	const char shstrtab[] = "\0.shstrtab";
+	Elf32_Shdr *shdr = (Elf32_Shdr *) (buffer.data() + ehdr->e_shoff);
+	shdr[1].sh_name = 1;
+	shdr[1].sh_type = SHT_STRTAB;
+	shdr[1].sh_offset = 0x1180;
+	shdr[1].sh_size = sizeof shstrtab;
+	memcpy(buffer.data() + 0x1180, shstrtab, sizeof shstrtab);
+
+	// Write file
+	char path[] = "/tmp/m2s.XXXXXX";
+	int fd = mkstemp(path);
+	EXPECT_NE(-1, fd);
+	EXPECT_EQ((ssize_t) buffer.size(), write(fd, buffer.data(),
+			buffer.size()));
+	close(fd);
+	return path;
+}
+
+
+// Run the binary in 'path' until all contexts finish, with the given number
+// of host threads and quantum. Return the standard output of the program,
+// and the number of emulated instructions in 'num_instructions'.
+static std::string RunBinary(const std::string &path, int num_threads,
+		long long &num_instructions)
+{
+	// Temporary file for the standard output
+	char output_path[] = "/tmp/m2s.XXXXXX";
+	int fd = mkstemp(output_path);
+	EXPECT_NE(-1, fd);
+	close(fd);
+
+	// Emulator with the given number of threads
+	Emulator::Destroy();
+	esim::Engine::Destroy();
+	comm::ArchPool::Destroy();
+	Emulator::setNumThreads(num_threads);
+	Emulator *emulator = Emulator::getInstance();
+	try
+	{
+		Context *context = emulator->newContext();
+		context->Load({ path }, { }, "", "", output_path);
+		while (emulator->Run())
+			;
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		ADD_FAILURE();
+	}
+	num_instructions = emulator->getNumInstructions();
+
+	// Release the emulator, closing the output file
+	Emulator::Destroy();
+	Emulator::setNumThreads(1);
+	std::ifstream f(output_path);
+	std::ostringstream output;
+	output << f.rdbuf();
+	unlink(output_path);
+	return output.str();
+}
+
+
+// Tests that a guest made of two processes produces the same output and runs
+// the same number of instructions with one and with several host threads
+TEST(TestEmulator, test_parallel_processes)
+{
+	std::string path = WriteBinary();
+
+	// Sequential emulator
+	long long num_instructions;
+	std::string output = RunBinary(path, 1, num_instructions);
+	ASSERT_EQ(8u, output.size());
+
+	// Sums of the parent and the child
+	unsigned sums[2];
+	memcpy(sums, output.data(), sizeof sums);
+	EXPECT_EQ(20000u * 20001u / 2 + 20000u, sums[0]);
+	EXPECT_EQ(20000u * 20001u / 2, sums[1]);
+	EXPECT_GT(num_instructions, 2 * 5 * 20000);
+
+	// Parallel emulator
+	for (int num_threads : { 2, 4 })
+	{
+		long long parallel_num_instructions;
+		EXPECT_EQ(output, RunBinary(path, num_threads,
+				parallel_num_instructions));
+		EXPECT_EQ(num_instructions, parallel_num_instructions);
+	}
+	unlink(path.c_str());
+}
+
+
+// Tests that the emulator only blocks waiting for host events if all
+// suspended contexts wait for them, and not while a context waits for
+// another architecture, as in a driver call waiting for a GPU kernel
+TEST(TestEmulator, test_wait_for_host_events)
+{
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	Emulator::Destroy();
+	esim::Engine::Destroy();
+	comm::ArchPool::Destroy();
+	Emulator *emulator = Emulator::getInstance();
+	Reactor *reactor = emulator->getReactor();
+
+	// Context waiting for input in a pipe
+	Context *reader = emulator->newContext();
+	reactor->Wait(reader, fds[0], EPOLLIN, 0);
+	reader->Suspend();
+
+	// Context waiting to be woken up by another architecture
+	Context *driver_context = emulator->newContext();
+	driver_context->Suspend();
+
+	// No context can be woken up after checking all suspended contexts,
+	// but the emulator does not block, since the other architecture
+	// would not run
+	emulator->ProcessEvents();
+	EXPECT_FALSE(emulator->isProcessEventsScheduled());
+	EXPECT_FALSE(emulator->WaitForHostEvents());
+	EXPECT_TRUE(reactor->isWaiting(reader));
+
+	// The context woken up by the other architecture runs
+	driver_context->Wakeup();
+	EXPECT_FALSE(emulator->WaitForHostEvents());
+	emulator->FreeContext(driver_context);
+
+	// Only the reader is left, and the emulator blocks until the pipe
+	// has data
+	ASSERT_EQ(1, write(fds[1], "x", 1));
+	EXPECT_TRUE(emulator->WaitForHostEvents());
+	EXPECT_FALSE(reactor->isWaiting(reader));
+
+	// Release the emulator before closing the pipe
+	Emulator::Destroy();
+	close(fds[0]);
+	close(fds[1]);
+}
+
+}  // namespace x86
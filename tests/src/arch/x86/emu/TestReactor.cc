@@ -0,0 +1,101 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <gtest/gtest.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <arch/x86/emulator/Reactor.h>
+#include <lib/esim/Engine.h>
+
+
+namespace x86
+{
+
+// The reactor does not access contexts, so fake pointers identify them
+static Context *const context_a = reinterpret_cast<Context *>(0x10);
+static Context *const context_b = reinterpret_cast<Context *>(0x20);
+static Context *const context_c = reinterpret_cast<Context *>(0x30);
+
+
+// Tests that only contexts whose file descriptor is ready are woken up
+TEST(TestReactor, test_wait_fd)
+{
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	Reactor reactor;
+	std::vector<Context *> woken;
+	std::vector<std::pair<Context *, int>> expired;
+
+	// Two contexts read from the pipe, one writes to it
+	reactor.Wait(context_a, fds[0], EPOLLIN, 0);
+	reactor.Wait(context_b, fds[0], EPOLLIN, 0);
+	reactor.Wait(context_c, fds[1], EPOLLOUT, 0);
+	reactor.Poll(false, woken, expired);
+	ASSERT_EQ(1u, woken.size());
+	EXPECT_EQ(context_c, woken[0]);
+	EXPECT_FALSE(reactor.isWaiting(context_c));
+
+	// Data written to the pipe wakes up both readers
+	woken.clear();
+	ASSERT_EQ(1, write(fds[1], "x", 1));
+	reactor.Poll(true, woken, expired);
+	EXPECT_EQ(2u, woken.size());
+	EXPECT_TRUE(reactor.isEmpty());
+	close(fds[0]);
+	close(fds[1]);
+}
+
+
+// Tests that waits and timers expire in time order
+TEST(TestReactor, test_timers)
+{
+	esim::Engine *esim = esim::Engine::getInstance();
+	long long now = esim->getRealTime();
+	Reactor reactor;
+	std::vector<Context *> woken;
+	std::vector<std::pair<Context *, int>> expired;
+
+	// A canceled wait does not expire
+	reactor.Wait(context_a, -1, 0, now + 20000);
+	reactor.Wait(context_b, -1, 0, now + 1000);
+	reactor.setTimer(context_c, 1, now + 10000);
+	reactor.setTimer(context_c, 2, now + 30000);
+	EXPECT_TRUE(reactor.CancelWait(context_a));
+	EXPECT_FALSE(reactor.CancelWait(context_a));
+
+	// Blocking polls return events in order
+	reactor.Poll(true, woken, expired);
+	ASSERT_EQ(1u, woken.size());
+	EXPECT_EQ(context_b, woken[0]);
+	EXPECT_GE(esim->getRealTime(), now + 1000);
+	while (expired.empty())
+		reactor.Poll(true, woken, expired);
+	EXPECT_EQ(1u, woken.size());
+	ASSERT_EQ(1u, expired.size());
+	EXPECT_EQ(context_c, expired[0].first);
+	EXPECT_EQ(1, expired[0].second);
+	EXPECT_GE(esim->getRealTime(), now + 10000);
+
+	// Removing a context removes its timers
+	reactor.Remove(context_c);
+	EXPECT_TRUE(reactor.isEmpty());
+}
+
+}  // namespace x86
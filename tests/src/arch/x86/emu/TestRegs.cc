@@ -0,0 +1,173 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <gtest/gtest.h>
+
+#include <arch/x86/emulator/Regs.h>
+#include <lib/cpp/String.h>
+
+
+namespace x86
+{
+
+// Arithmetic flags
+static const unsigned FlagsMask =
+		1 << Instruction::FlagCF |
+		1 << Instruction::FlagPF |
+		1 << Instruction::FlagAF |
+		1 << Instruction::FlagZF |
+		1 << Instruction::FlagSF |
+		1 << Instruction::FlagOF;
+
+// Operand values covering carries, overflows, and auxiliary carries
+static const unsigned Values[] =
+{
+	0, 1, 0xf, 0x10, 0x7f, 0x80, 0xff, 0x7fff, 0x8000, 0xffff,
+	0x7fffffff, 0x80000000, 0xfffffffe, 0xffffffff, 0x12345678
+};
+
+// Run an 8-bit or 32-bit instruction on the host, with the given flags
+// as input, and return the output flags
+#define HOST_OP(op, reg, type) \
+static unsigned long Host_##op##_##type(unsigned long flags, type op1, \
+		type op2) \
+{ \
+	asm volatile ( \
+		"push %3\n\t" \
+		"popf\n\t" \
+		"mov %1, %%" #reg "\n\t" \
+		#op " %2, %%" #reg "\n\t" \
+		"pushf\n\t" \
+		"pop %0\n\t" \
+		: "=g" (flags) \
+		: "m" (op1), "m" (op2), "g" (flags) \
+		: #reg, "cc" \
+	); \
+	return flags; \
+}
+
+#define HOST_UNARY_OP(op, reg, type) \
+static unsigned long Host_##op##_##type(unsigned long flags, type op1, \
+		type) \
+{ \
+	asm volatile ( \
+		"push %2\n\t" \
+		"popf\n\t" \
+		"mov %1, %%" #reg "\n\t" \
+		#op " %%" #reg "\n\t" \
+		"pushf\n\t" \
+		"pop %0\n\t" \
+		: "=g" (flags) \
+		: "m" (op1), "g" (flags) \
+		: #reg, "cc" \
+	); \
+	return flags; \
+}
+
+#define HOST_OPS(type, reg) \
+	HOST_OP(add, reg, type) \
+	HOST_OP(adc, reg, type) \
+	HOST_OP(sub, reg, type) \
+	HOST_OP(sbb, reg, type) \
+	HOST_OP(and, reg, type) \
+	HOST_OP(or, reg, type) \
+	HOST_OP(xor, reg, type) \
+	HOST_UNARY_OP(inc, reg, type) \
+	HOST_UNARY_OP(dec, reg, type)
+
+typedef unsigned char uchar;
+HOST_OPS(uchar, al)
+HOST_OPS(unsigned, eax)
+
+// Compare the flags computed lazily for an operation with those computed
+// by the host, for all pairs of operand values and both values of CF.
+// Argument 'src2' is the second operand recorded for the lazy evaluation.
+#define CHECK_OP(op, lazy_op, expr, src2, type) \
+	for (unsigned v1 : Values) \
+	for (unsigned v2 : Values) \
+	for (unsigned cf = 0; cf < 2; cf++) \
+	{ \
+		type op1 = v1; \
+		type op2 = v2; \
+		unsigned flags = cf; \
+		Regs regs; \
+		regs.setEflags(flags); \
+		unsigned result = (expr); \
+		regs.setLazyFlags(lazy_op, sizeof(type), op1, src2, result); \
+		EXPECT_EQ(Host_##op##_##type(flags, op1, op2) & FlagsMask, \
+				regs.getEflags() & FlagsMask) \
+				<< misc::fmt(#op " %x, %x (cf=%d)", \
+				op1, op2, cf); \
+		EXPECT_EQ((bool) (Host_##op##_##type(flags, op1, op2) & \
+				1 << Instruction::FlagOF), \
+				regs.getFlag(Instruction::FlagOF)); \
+	}
+
+#define CHECK_OPS(type) \
+	CHECK_OP(add, Regs::LazyAdd, op1 + op2, op2, type) \
+	CHECK_OP(adc, cf ? Regs::LazyAdc : Regs::LazyAdd, \
+			op1 + op2 + cf, op2, type) \
+	CHECK_OP(sub, Regs::LazySub, op1 - op2, op2, type) \
+	CHECK_OP(sbb, cf ? Regs::LazySbb : Regs::LazySub, \
+			op1 - op2 - cf, op2, type) \
+	CHECK_OP(and, Regs::LazyLogic, op1 & op2, op2, type) \
+	CHECK_OP(or, Regs::LazyLogic, op1 | op2, op2, type) \
+	CHECK_OP(xor, Regs::LazyLogic, op1 ^ op2, op2, type) \
+	CHECK_OP(inc, Regs::LazyInc, op1 + 1, 1, type) \
+	CHECK_OP(dec, Regs::LazyDec, op1 - 1, 1, type)
+
+
+// Tests that flags evaluated lazily match those computed by the host
+TEST(TestRegs, test_lazy_flags)
+{
+	CHECK_OPS(uchar)
+	CHECK_OPS(unsigned)
+}
+
+
+// Tests that writing a flag or the whole register ends lazy evaluation
+TEST(TestRegs, test_lazy_flags_write)
+{
+	Regs regs;
+
+	// Setting a flag keeps the other lazily evaluated flags
+	regs.setLazyFlags(Regs::LazySub, 4, 1, 2, (unsigned) -1);
+	regs.setFlag(Instruction::FlagDF);
+	EXPECT_TRUE(regs.getFlag(Instruction::FlagCF));
+	EXPECT_TRUE(regs.getFlag(Instruction::FlagSF));
+	EXPECT_TRUE(regs.getFlag(Instruction::FlagDF));
+	regs.clearFlag(Instruction::FlagCF);
+	EXPECT_FALSE(regs.getFlag(Instruction::FlagCF));
+	EXPECT_TRUE(regs.getFlag(Instruction::FlagSF));
+
+	// Increments keep CF
+	regs.setFlag(Instruction::FlagCF);
+	regs.setLazyFlags(Regs::LazyInc, 4, 0xffffffff, 1, 0);
+	EXPECT_TRUE(regs.getFlag(Instruction::FlagCF));
+	EXPECT_TRUE(regs.getFlag(Instruction::FlagZF));
+	regs.setLazyFlags(Regs::LazyAdd, 4, 1, 1, 2);
+	regs.setLazyFlags(Regs::LazyDec, 4, 2, 1, 1);
+	EXPECT_FALSE(regs.getFlag(Instruction::FlagCF));
+
+	// Writing the register replaces all flags
+	regs.setEflags(1 << Instruction::FlagZF);
+	EXPECT_EQ(1u << Instruction::FlagZF, regs.getEflags());
+}
+
+}  // namespace x86
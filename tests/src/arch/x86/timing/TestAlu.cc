@@ -249,7 +249,7 @@ TEST(TestAlu, reserve_functional_unit_int_add)
 		uops.emplace_back(misc::new_unique<Uop>(
 			object_pool->getThread(),
 			object_pool->getContext(),
-			uinst));
+			*uinst));
 	}
 
 	// Start simulation----->timing by cycle
@@ -103,7 +103,7 @@ TEST(TestBranchPredictor, test_bimodal_branch_predictor_1)
 	uops.emplace_back(misc::new_unique<Uop>(
 			object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_1));
+			*uinst_1));
 	Uop *uop = uops.back().get();
 	uop->eip = branch_addr;
 	uop->neip = branch_addr + branch_target_distance;
@@ -114,7 +114,7 @@ TEST(TestBranchPredictor, test_bimodal_branch_predictor_1)
 	uops.emplace_back(misc::new_unique<Uop>(
 			object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_2));
+			*uinst_2));
 	uop = uops.back().get();
 	uop->eip = branch_addr;
 	uop->neip = branch_addr + branch_inst_size;
@@ -125,7 +125,7 @@ TEST(TestBranchPredictor, test_bimodal_branch_predictor_1)
 	uops.emplace_back(misc::new_unique<Uop>(
 			object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_2));
+			*uinst_2));
 	uop = uops.back().get();
 	uop->eip = branch_addr;
 	uop->neip = branch_addr + branch_inst_size;
@@ -223,7 +223,7 @@ TEST(TestBranchPredictor, test_two_level_branch_predictor_1)
 		uops.emplace_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst));
+				*uinst));
 		uop = uops.back().get();
 		uop->eip = branch_addr;
 		uop->neip = branch_addr + branch_target_distance;
@@ -234,7 +234,7 @@ TEST(TestBranchPredictor, test_two_level_branch_predictor_1)
 		uops.emplace_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst));
+				*uinst));
 		uop = uops.back().get();
 		uop->eip = branch_addr;
 		uop->neip = branch_addr + branch_inst_size;
@@ -245,7 +245,7 @@ TEST(TestBranchPredictor, test_two_level_branch_predictor_1)
 		uops.emplace_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst));
+				*uinst));
 		uop = uops.back().get();
 		uop->eip = branch_addr;
 		uop->neip = branch_addr + branch_inst_size;
@@ -403,7 +403,7 @@ TEST(TestBranchPredictor, test_combined_branch_predictor_1)
 		uops.emplace_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst));
+				*uinst));
 		uop = uops.back().get();
 		uop->eip = branch_addr;
 		uop->neip = branch_addr + branch_target_distance;
@@ -414,7 +414,7 @@ TEST(TestBranchPredictor, test_combined_branch_predictor_1)
 		uops.emplace_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst));
+				*uinst));
 		uop = uops.back().get();
 
 
@@ -427,7 +427,7 @@ TEST(TestBranchPredictor, test_combined_branch_predictor_1)
 		uops.emplace_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst));
+				*uinst));
 		uop = uops.back().get();
 
 
@@ -593,8 +593,205 @@ TEST(TestBranchPredictor, test_combined_branch_predictor_1)
 }
 
 
+TEST(TestBranchPredictor, read_ini_configuration_file_tage)
+{
+	// Setup configuration file
+	std::string config =
+		"[ BranchPredictor ]\n"
+		"Kind = Tage\n"
+		"Tage.NumTables = 9\n"
+		"Tage.BaseSize = 2048\n"
+		"Tage.TableSize = 512\n"
+		"Tage.TagBits = 12\n"
+		"Tage.MinHistory = 5\n"
+		"Tage.MaxHistory = 300\n"
+		"Tage.LoopSize = 0\n"
+		"Tage.StatisticalCorrector = False\n"
+		"Perceptron.NumTables = 12\n"
+		"Perceptron.TableSize = 256\n"
+		"Perceptron.HistorySize = 100\n"
+		"Indirect = Ittage\n"
+		"Ittage.NumTables = 6\n"
+		"Ittage.BaseSize = 128\n"
+		"Ittage.TableSize = 512\n"
+		"Ittage.TagBits = 11\n"
+		"Ittage.MinHistory = 3\n"
+		"Ittage.MaxHistory = 80";
+
+	// Set up INI file
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(config);
+
+	// Find target section
+	BranchPredictor::ParseConfiguration(&ini_file);
+
+	// Assertions
+	EXPECT_EQ(BranchPredictor::KindTage, BranchPredictor::getKind());
+	EXPECT_EQ(9, BranchPredictor::getTageNumTables());
+	EXPECT_EQ(2048, BranchPredictor::getTageBaseSize());
+	EXPECT_EQ(512, BranchPredictor::getTageTableSize());
+	EXPECT_EQ(12, BranchPredictor::getTageTagBits());
+	EXPECT_EQ(5, BranchPredictor::getTageMinHistory());
+	EXPECT_EQ(300, BranchPredictor::getTageMaxHistory());
+	EXPECT_EQ(0, BranchPredictor::getTageLoopSize());
+	EXPECT_FALSE(BranchPredictor::getTageStatisticalCorrector());
+	EXPECT_EQ(12, BranchPredictor::getPerceptronNumTables());
+	EXPECT_EQ(256, BranchPredictor::getPerceptronTableSize());
+	EXPECT_EQ(100, BranchPredictor::getPerceptronHistorySize());
+	EXPECT_EQ(BranchPredictor::IndirectKindIttage,
+			BranchPredictor::getIndirectKind());
+	EXPECT_EQ(6, BranchPredictor::getIttageNumTables());
+	EXPECT_EQ(128, BranchPredictor::getIttageBaseSize());
+	EXPECT_EQ(512, BranchPredictor::getIttageTableSize());
+	EXPECT_EQ(11, BranchPredictor::getIttageTagBits());
+	EXPECT_EQ(3, BranchPredictor::getIttageMinHistory());
+	EXPECT_EQ(80, BranchPredictor::getIttageMaxHistory());
+
+	// Invalid number of tables
+	misc::IniFile invalid_ini_file;
+	invalid_ini_file.LoadFromString("[ BranchPredictor ]\n"
+			"Tage.NumTables = 13");
+	EXPECT_THROW(BranchPredictor::ParseConfiguration(&invalid_ini_file),
+			BranchPredictor::Error);
+}
+
+
+// Look up and update the branch predictor as done in the fetch and commit
+// stages for a conditional branch at address 'eip', returning whether it was
+// mispredicted.
+static bool RunConditionalBranch(BranchPredictor &branch_predictor,
+		unsigned eip, bool taken)
+{
+	ObjectPool *object_pool = ObjectPool::getInstance();
+	auto uinst = misc::new_shared<Uinst>(Uinst::OpcodeBranch);
+	Uop uop(object_pool->getThread(), object_pool->getContext(), *uinst);
+	uop.eip = eip;
+	uop.mop_size = 4;
+	uop.neip = taken ? eip + 64 : eip + 4;
+	BranchPredictor::Prediction prediction = branch_predictor.Lookup(&uop);
+	branch_predictor.Update(&uop);
+	return (prediction == BranchPredictor::PredictionTaken) != taken;
+}
+
+
+TEST(TestBranchPredictor, test_tage_branch_predictor_pattern)
+{
+	// Setup configuration file for branch predictor
+	std::string config =
+			"[ BranchPredictor ]\n"
+			"Kind = Tage";
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(config);
+	BranchPredictor::ParseConfiguration(&ini_file);
+	BranchPredictor branch_predictor;
+
+	// Branch following the pattern taken, taken, not taken. After some
+	// training, the global history identifies each position.
+	int mispredictions = 0;
+	for (int i = 0; i < 600; i++)
+	{
+		bool mispredicted = RunConditionalBranch(branch_predictor,
+				0x8000, i % 3 != 2);
+		if (i >= 300 && mispredicted)
+			mispredictions++;
+	}
+	EXPECT_EQ(0, mispredictions);
+}
+
+
+TEST(TestBranchPredictor, test_tage_branch_predictor_loop)
+{
+	// Global history too short to see the exit of the loop
+	std::string config =
+			"[ BranchPredictor ]\n"
+			"Kind = Tage\n"
+			"Tage.MaxHistory = 16";
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(config);
+	BranchPredictor::ParseConfiguration(&ini_file);
+	BranchPredictor branch_predictor;
+
+	// Loop branch taken 39 times and not taken once. The exit is only
+	// predicted by the loop predictor.
+	int mispredictions = 0;
+	for (int i = 0; i < 20; i++)
+	{
+		for (int j = 0; j < 40; j++)
+		{
+			bool mispredicted = RunConditionalBranch(branch_predictor,
+					0x8000, j < 39);
+			if (i >= 10 && mispredicted)
+				mispredictions++;
+		}
+	}
+	EXPECT_EQ(0, mispredictions);
 }
 
 
+TEST(TestBranchPredictor, test_perceptron_branch_predictor)
+{
+	// Setup configuration file for branch predictor
+	std::string config =
+			"[ BranchPredictor ]\n"
+			"Kind = Perceptron";
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(config);
+	BranchPredictor::ParseConfiguration(&ini_file);
+	BranchPredictor branch_predictor;
 
+	// First branch with a pseudo-random direction, and second branch
+	// with the same direction
+	unsigned seed = 1;
+	int mispredictions = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		bool taken = (seed >> 16) & 1;
+		RunConditionalBranch(branch_predictor, 0x8000, taken);
+		bool mispredicted = RunConditionalBranch(branch_predictor,
+				0x8100, taken);
+		if (i >= 1000 && mispredicted)
+			mispredictions++;
+	}
+	EXPECT_LT(mispredictions, 20);
+}
+
+
+TEST(TestBranchPredictor, test_ittage_indirect_predictor)
+{
+	// Setup configuration file for branch predictor
+	std::string config =
+			"[ BranchPredictor ]\n"
+			"Indirect = Ittage";
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(config);
+	BranchPredictor::ParseConfiguration(&ini_file);
+	BranchPredictor branch_predictor;
 
+	// Indirect jump through a register, cycling among three targets.
+	// Each target is predicted from the history bits inserted by the
+	// previous one, while the BTB only keeps the last target.
+	ObjectPool *object_pool = ObjectPool::getInstance();
+	auto uinst = misc::new_shared<Uinst>(Uinst::OpcodeJump);
+	uinst->setIDep(0, Uinst::DepEax);
+	unsigned targets[3] = { 0x1004, 0x1018, 0x1030 };
+	int mispredictions = 0;
+	for (int i = 0; i < 300; i++)
+	{
+		Uop uop(object_pool->getThread(), object_pool->getContext(),
+				*uinst);
+		uop.eip = 0x8000;
+		uop.mop_size = 2;
+		uop.neip = targets[i % 3];
+		unsigned target = branch_predictor.LookupBtb(&uop);
+		branch_predictor.Lookup(&uop);
+		branch_predictor.Update(&uop);
+		branch_predictor.UpdateBtb(&uop);
+		if (i >= 150 && target != uop.neip)
+			mispredictions++;
+	}
+	EXPECT_EQ(0, mispredictions);
+}
+
+
+}
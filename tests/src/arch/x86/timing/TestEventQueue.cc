@@ -0,0 +1,126 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <arch/x86/emulator/Uinst.h>
+#include <arch/x86/timing/EventQueue.h>
+#include <arch/x86/timing/Uop.h>
+
+#include "ObjectPool.h"
+
+namespace x86
+{
+
+// Tests that uops are extracted in order of completion cycle and identifier,
+// including uops completing beyond the cycles covered by the wheel
+TEST(TestEventQueue, order)
+{
+	// Setup the timing simulator related object pool
+	ObjectPool::Destroy();
+	ObjectPool *object_pool = ObjectPool::getInstance();
+
+	// Create uops, with identifiers assigned in order of creation
+	Uinst uinst(Uinst::OpcodeAdd);
+	std::vector<std::shared_ptr<Uop>> uops;
+	for (int i = 0; i < 5; i++)
+		uops.push_back(std::make_shared<Uop>(object_pool->getThread(),
+				object_pool->getContext(),
+				uinst));
+
+	// Insert uops out of order. The wheel covers 16 cycles.
+	EventQueue event_queue(4);
+	uops[0]->complete_when = 20;
+	uops[1]->complete_when = 3;
+	uops[2]->complete_when = 3;
+	uops[3]->complete_when = 1;
+	uops[4]->complete_when = 17;
+	for (int i = 4; i >= 0; i--)
+		event_queue.Insert(uops[i]);
+	EXPECT_EQ(5, event_queue.size());
+
+	// Extract uops as the writeback stage would
+	std::vector<std::shared_ptr<Uop>> order;
+	for (long long cycle = 0; cycle < 30; cycle++)
+	{
+		while (!event_queue.empty() &&
+				event_queue.front()->complete_when <= cycle)
+		{
+			std::shared_ptr<Uop> uop = event_queue.front();
+			EXPECT_EQ(cycle, uop->complete_when);
+			event_queue.Remove(uop.get());
+			order.push_back(uop);
+		}
+		event_queue.Advance(cycle);
+	}
+	ASSERT_EQ(5, (int) order.size());
+	EXPECT_EQ(uops[3], order[0]);
+	EXPECT_EQ(uops[1], order[1]);
+	EXPECT_EQ(uops[2], order[2]);
+	EXPECT_EQ(uops[4], order[3]);
+	EXPECT_EQ(uops[0], order[4]);
+	EXPECT_TRUE(event_queue.empty());
+}
+
+// Tests removal of uops in any position while traversing the queue
+TEST(TestEventQueue, remove)
+{
+	// Setup the timing simulator related object pool
+	ObjectPool::Destroy();
+	ObjectPool *object_pool = ObjectPool::getInstance();
+
+	// Create uops completing in the wheel and in the overflow heap
+	Uinst uinst(Uinst::OpcodeAdd);
+	std::vector<std::shared_ptr<Uop>> uops;
+	EventQueue event_queue(4);
+	for (int i = 0; i < 6; i++)
+	{
+		uops.push_back(std::make_shared<Uop>(object_pool->getThread(),
+				object_pool->getContext(),
+				uinst));
+		uops[i]->complete_when = i * 10;
+		event_queue.Insert(uops[i]);
+	}
+
+	// All uops are traversed
+	int count = 0;
+	for (auto it = event_queue.begin(), e = event_queue.end(); it != e;
+			++it)
+		count++;
+	EXPECT_EQ(6, count);
+
+	// Remove uops with odd indexes
+	for (int i = 1; i < 6; i += 2)
+		event_queue.Remove(uops[i].get());
+	EXPECT_EQ(3, event_queue.size());
+	EXPECT_EQ(1, uops[5].use_count());
+
+	// Remaining uops come out in order
+	for (int i = 0; i < 6; i += 2)
+	{
+		EXPECT_EQ(uops[i], event_queue.front());
+		event_queue.Remove(uops[i].get());
+		event_queue.Advance(i * 10);
+	}
+	EXPECT_TRUE(event_queue.empty());
+}
+
+}  // namespace x86
@@ -0,0 +1,170 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <lib/cpp/Bitmap.h>
+#include <lib/cpp/Error.h>
+#include <lib/cpp/IniFile.h>
+#include <arch/x86/emulator/Uinst.h>
+#include <arch/x86/timing/Uop.h>
+
+#include "ObjectPool.h"
+
+namespace x86
+{
+
+// Create a move uop, which does not need a functional unit to issue
+static std::shared_ptr<Uop> NewUop(ObjectPool *object_pool,
+		int idep = Uinst::DepNone,
+		int odep = Uinst::DepNone)
+{
+	Uinst uinst(Uinst::OpcodeMove);
+	uinst.setIDep(0, idep);
+	uinst.setODep(0, odep);
+	return std::make_shared<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			uinst);
+}
+
+
+// Dispatch uops into the reorder buffer and the instruction queue
+static void Dispatch(Thread *thread,
+		const std::vector<std::shared_ptr<Uop>> &uops)
+{
+	for (auto &uop : uops)
+		thread->InsertInUopQueue(uop);
+	EXPECT_EQ(0, thread->Dispatch(uops.size()));
+}
+
+
+// Tests the search of the bits set in a bitmap, across blocks
+TEST(TestIssue, bitmap_find_next)
+{
+	misc::Bitmap bitmap(130);
+	EXPECT_EQ(130u, bitmap.FindNext(0));
+	bitmap.Set(3);
+	bitmap.Set(64);
+	bitmap.Set(129);
+	EXPECT_EQ(3u, bitmap.FindNext(0));
+	EXPECT_EQ(3u, bitmap.FindNext(3));
+	EXPECT_EQ(64u, bitmap.FindNext(4));
+	EXPECT_EQ(64u, bitmap.FindNext(64));
+	EXPECT_EQ(129u, bitmap.FindNext(65));
+	EXPECT_EQ(130u, bitmap.FindNext(130));
+	bitmap.Reset(129);
+	EXPECT_EQ(130u, bitmap.FindNext(65));
+}
+
+
+// Tests that ready uops are visited and issued in the order of the reorder
+// buffer after it wraps around, skipping uops waiting for their inputs
+// until they are woken up.
+TEST(TestIssue, issue_order)
+{
+	// Reorder buffer with 8 slots
+	ObjectPool::Destroy();
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(
+			"[ Queues ]\n"
+			"RobSize = 8");
+	try
+	{
+		Timing::ParseConfiguration(&ini_file);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+	ObjectPool *object_pool = ObjectPool::getInstance();
+	Thread *thread = object_pool->getThread();
+
+	// Allocate the context to the thread, as required by the commit stage
+	Context *context = object_pool->getContext();
+	context->Initialize();
+	context->setState(Context::StateRunning);
+	thread->MapContext(context);
+	thread->Schedule();
+
+	// Take the first 5 slots, and commit their uops
+	std::vector<std::shared_ptr<Uop>> uops;
+	for (int i = 0; i < 5; i++)
+		uops.push_back(NewUop(object_pool));
+	Dispatch(thread, uops);
+	EXPECT_EQ(0, thread->IssueInstructionQueue(5));
+	for (auto &uop : uops)
+	{
+		EXPECT_TRUE(uop->issued);
+		uop->completed = true;
+	}
+	thread->Commit(5);
+
+	// Fill the reorder buffer, wrapping around. Uop 9 reads the register
+	// written by uop 5.
+	uops.clear();
+	for (int i = 5; i < 12; i++)
+		uops.push_back(NewUop(object_pool,
+				i == 9 ? Uinst::DepEax : Uinst::DepNone,
+				i == 5 ? Uinst::DepEax : Uinst::DepNone));
+	Dispatch(thread, uops);
+	std::vector<int> slots = { 5, 6, 7, 0, 1, 2, 3 };
+	for (int i = 0; i < 7; i++)
+		EXPECT_EQ(slots[i], uops[i]->reorder_buffer_slot);
+	EXPECT_FALSE(uops[4]->ready);
+
+	// Ready slots are visited starting at the head of the reorder buffer
+	misc::Bitmap ready(8);
+	ready.Set(1);
+	ready.Set(3);
+	ready.Set(5);
+	ready.Set(6);
+	std::vector<int> order;
+	for (int slot = thread->getNextReadySlot(ready, -1); slot >= 0;
+			slot = thread->getNextReadySlot(ready, slot))
+		order.push_back(slot);
+	EXPECT_EQ(std::vector<int>({ 5, 6, 1, 3 }), order);
+	ready.Reset(5);
+	ready.Reset(6);
+	ready.Set(7);
+	EXPECT_EQ(7, thread->getNextReadySlot(ready, -1));
+	EXPECT_EQ(1, thread->getNextReadySlot(ready, 7));
+	EXPECT_EQ(-1, thread->getNextReadySlot(ready, 3));
+
+	// The oldest uops issue first
+	EXPECT_EQ(0, thread->IssueInstructionQueue(3));
+	for (int i = 0; i < 7; i++)
+		EXPECT_EQ(i < 3, uops[i]->issued);
+
+	// The uop waiting for its input is skipped
+	EXPECT_EQ(0, thread->IssueInstructionQueue(3));
+	for (int i = 0; i < 7; i++)
+		EXPECT_EQ(i != 4, uops[i]->issued);
+	EXPECT_EQ(1, thread->IssueInstructionQueue(1));
+
+	// Writing the input lets it issue
+	thread->getRegisterFile()->WriteUop(uops[0].get());
+	EXPECT_TRUE(uops[4]->ready);
+	EXPECT_EQ(0, thread->IssueInstructionQueue(1));
+	EXPECT_TRUE(uops[4]->issued);
+}
+
+}
@@ -0,0 +1,373 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <lib/cpp/Error.h>
+#include <lib/cpp/IniFile.h>
+#include <lib/esim/Engine.h>
+#include <memory/System.h>
+#include <arch/x86/emulator/Uinst.h>
+#include <arch/x86/timing/Uop.h>
+
+#include "ObjectPool.h"
+
+namespace x86
+{
+
+// Configure the timing simulator with the given memory dependence kind,
+// and return the object pool
+static ObjectPool *Configure(const std::string &kind)
+{
+	ObjectPool::Destroy();
+	misc::IniFile ini_file;
+	ini_file.LoadFromString(
+			"[ Queues ]\n"
+			"RobSize = 64\n"
+			"LsqSize = 64\n"
+			"MemDepKind = " + kind);
+	try
+	{
+		Timing::ParseConfiguration(&ini_file);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		ADD_FAILURE();
+	}
+	return ObjectPool::getInstance();
+}
+
+
+// Create a move writing register eax, whose value is pending until the
+// register file writes the uop
+static std::shared_ptr<Uop> NewProducer(ObjectPool *object_pool)
+{
+	Uinst uinst(Uinst::OpcodeMove);
+	uinst.setODep(0, Uinst::DepEax);
+	return std::make_shared<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			uinst);
+}
+
+
+// Create a move writing register ebx
+static std::shared_ptr<Uop> NewMove(ObjectPool *object_pool)
+{
+	Uinst uinst(Uinst::OpcodeMove);
+	uinst.setODep(0, Uinst::DepEbx);
+	return std::make_shared<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			uinst);
+}
+
+
+// Create a 4-byte store at instruction address \a eip, whose address is
+// computed from register eax
+static std::shared_ptr<Uop> NewStore(ObjectPool *object_pool,
+		unsigned eip, unsigned address)
+{
+	Uinst uinst(Uinst::OpcodeStore);
+	uinst.setIDep(0, Uinst::DepEax);
+	uinst.setMemoryAccess(address, 4);
+	auto uop = std::make_shared<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			uinst);
+	uop->eip = eip;
+	uop->physical_address = address;
+	return uop;
+}
+
+
+// Create a 4-byte load at instruction address \a eip, with no register
+// inputs
+static std::shared_ptr<Uop> NewLoad(ObjectPool *object_pool,
+		unsigned eip, unsigned address)
+{
+	Uinst uinst(Uinst::OpcodeLoad);
+	uinst.setMemoryAccess(address, 4);
+	auto uop = std::make_shared<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			uinst);
+	uop->eip = eip;
+	uop->physical_address = address;
+	return uop;
+}
+
+
+// Dispatch uops into the reorder buffer and the queues
+static void Dispatch(Thread *thread,
+		const std::vector<std::shared_ptr<Uop>> &uops)
+{
+	for (auto &uop : uops)
+		thread->InsertInUopQueue(uop);
+	EXPECT_EQ(0, thread->Dispatch(uops.size()));
+}
+
+
+// Produce a violation between a store at \a store_eip and a younger load at
+// \a load_eip, recover from it, and dispatch the load again. The store set
+// predicted for the load is returned.
+static int Violate(ObjectPool *object_pool, unsigned store_eip,
+		unsigned load_eip)
+{
+	Thread *thread = object_pool->getThread();
+	auto producer = NewProducer(object_pool);
+	auto store = NewStore(object_pool, store_eip, 0x2000);
+	auto load = NewLoad(object_pool, load_eip, 0x2000);
+	Dispatch(thread, { producer, store, load });
+	load->issued = true;
+	thread->getRegisterFile()->WriteUop(producer.get());
+	thread->RecoverMemoryViolation();
+	EXPECT_EQ(1, load->num_replays);
+	EXPECT_EQ(0, thread->Dispatch(1));
+	return load->store_set;
+}
+
+
+// Return the store set predicted for a memory access at \a eip
+static int getStoreSet(ObjectPool *object_pool, unsigned eip)
+{
+	auto load = NewLoad(object_pool, eip, 0x8000);
+	Dispatch(object_pool->getThread(), { load });
+	return load->store_set;
+}
+
+
+// Tests that a store finds the oldest younger load that issued to an
+// overlapping address when its address is resolved, and that the load and
+// the uops following it are replayed. The load is then predicted to depend
+// on the next instance of the store.
+TEST(TestMemoryDependence, resolve_store)
+{
+	ObjectPool *object_pool = Configure("StoreSet");
+	Thread *thread = object_pool->getThread();
+	RegisterFile *register_file = thread->getRegisterFile();
+
+	// Store waiting for its address, followed by a move, a load to the
+	// next word, two loads overlapping with the store, and another move
+	auto producer = NewProducer(object_pool);
+	auto store = NewStore(object_pool, 0x100, 0x2000);
+	auto move_0 = NewMove(object_pool);
+	auto load_far = NewLoad(object_pool, 0x200, 0x2004);
+	auto load_0 = NewLoad(object_pool, 0x300, 0x2002);
+	auto move_1 = NewMove(object_pool);
+	auto load_1 = NewLoad(object_pool, 0x400, 0x1ffe);
+	Dispatch(thread, { producer, store, move_0, load_far, load_0, move_1,
+			load_1 });
+	EXPECT_FALSE(store->ready);
+	EXPECT_TRUE(load_0->ready);
+
+	// Nothing is predicted yet, so the loads issue
+	EXPECT_EQ(-1, load_0->store_set);
+	EXPECT_TRUE(thread->canIssueLoad(load_0.get()));
+	load_far->issued = true;
+	load_0->issued = true;
+	load_1->issued = true;
+	int move_1_register = move_1->getOutput(0);
+	EXPECT_FALSE(register_file->isIntegerRegisterFree(move_1_register));
+
+	// Resolving the store address finds the violation, which is recovered
+	// from the oldest overlapping load
+	register_file->WriteUop(producer.get());
+	EXPECT_TRUE(store->ready);
+	thread->RecoverMemoryViolation();
+	EXPECT_EQ(1, thread->getNumMemoryViolations());
+	EXPECT_EQ(3, thread->getNumReplayedUinsts());
+
+	// Older uops stay in the reorder buffer and their queues
+	EXPECT_TRUE(store->in_reorder_buffer);
+	EXPECT_TRUE(store->in_store_queue);
+	EXPECT_TRUE(move_0->in_reorder_buffer);
+	EXPECT_TRUE(load_far->in_reorder_buffer);
+	EXPECT_TRUE(load_far->issued);
+	EXPECT_EQ(0, load_far->num_replays);
+
+	// Replayed uops leave the reorder buffer and the queues, and the
+	// registers they renamed are freed
+	for (auto &uop : { load_0, move_1, load_1 })
+	{
+		EXPECT_FALSE(uop->in_reorder_buffer);
+		EXPECT_FALSE(uop->in_load_queue);
+		EXPECT_FALSE(uop->in_instruction_queue);
+		EXPECT_TRUE(uop->in_uop_queue);
+		EXPECT_FALSE(uop->issued);
+		EXPECT_EQ(1, uop->num_replays);
+	}
+	EXPECT_TRUE(register_file->isIntegerRegisterFree(move_1_register));
+
+	// A second recovery has nothing to do
+	thread->RecoverMemoryViolation();
+	EXPECT_EQ(1, thread->getNumMemoryViolations());
+
+	// Replayed uops are dispatched again in program order. The load is
+	// now in the store set of the store.
+	EXPECT_EQ(3, thread->getUopQueueSize());
+	for (auto &uop : { load_0, move_1, load_1 })
+	{
+		EXPECT_EQ(0, thread->Dispatch(1));
+		EXPECT_TRUE(uop->dispatched);
+	}
+	EXPECT_NE(-1, load_0->store_set);
+	EXPECT_EQ(-1, load_1->store_set);
+	EXPECT_EQ(load_0->store_set, getStoreSet(object_pool, 0x100));
+
+	// The next instance of the load waits for the next instance of the
+	// store, while other loads don't
+	auto producer_2 = NewProducer(object_pool);
+	auto store_2 = NewStore(object_pool, 0x100, 0x3000);
+	auto load_2 = NewLoad(object_pool, 0x300, 0x3000);
+	auto load_3 = NewLoad(object_pool, 0x400, 0x3000);
+	Dispatch(thread, { producer_2, store_2, load_2, load_3 });
+	EXPECT_EQ(store_2, load_2->store_dependence);
+	EXPECT_FALSE(thread->canIssueLoad(load_2.get()));
+	EXPECT_TRUE(thread->canIssueLoad(load_3.get()));
+
+	// The load issues once the store address is known, and there is no
+	// violation since it did not issue before
+	register_file->WriteUop(producer_2.get());
+	EXPECT_TRUE(thread->canIssueLoad(load_2.get()));
+	thread->RecoverMemoryViolation();
+	EXPECT_EQ(1, thread->getNumMemoryViolations());
+	EXPECT_TRUE(load_2->in_reorder_buffer);
+}
+
+
+// Tests the rules to merge the store sets of a load and a store found to
+// violate a memory dependence
+TEST(TestMemoryDependence, store_set_merge)
+{
+	ObjectPool *object_pool = Configure("StoreSet");
+
+	// Neither has a set, and a new one is allocated for each pair
+	EXPECT_EQ(0, Violate(object_pool, 0x10, 0x20));
+	EXPECT_EQ(0, getStoreSet(object_pool, 0x10));
+	EXPECT_EQ(1, Violate(object_pool, 0x30, 0x40));
+	EXPECT_EQ(1, getStoreSet(object_pool, 0x30));
+
+	// Only the store has a set, which the load takes
+	EXPECT_EQ(0, Violate(object_pool, 0x10, 0x50));
+
+	// Only the load has a set, which the store takes
+	Violate(object_pool, 0x60, 0x40);
+	EXPECT_EQ(1, getStoreSet(object_pool, 0x60));
+
+	// Both have a set, and the lowest one is kept, whether it is the one
+	// of the load or the one of the store
+	EXPECT_EQ(0, Violate(object_pool, 0x30, 0x20));
+	EXPECT_EQ(0, getStoreSet(object_pool, 0x30));
+	EXPECT_EQ(1, getStoreSet(object_pool, 0x40));
+	EXPECT_EQ(0, Violate(object_pool, 0x10, 0x40));
+	EXPECT_EQ(0, getStoreSet(object_pool, 0x40));
+	EXPECT_EQ(1, getStoreSet(object_pool, 0x60));
+}
+
+
+// Tests that loads wait for the address of all older stores with the
+// conservative policy, and ignore them with no policy
+TEST(TestMemoryDependence, can_issue_load)
+{
+	for (const std::string kind : { "Conservative", "None" })
+	{
+		ObjectPool *object_pool = Configure(kind);
+		Thread *thread = object_pool->getThread();
+
+		// A load before and after a store waiting for its address
+		auto producer = NewProducer(object_pool);
+		auto load_0 = NewLoad(object_pool, 0x100, 0x2000);
+		auto store = NewStore(object_pool, 0x200, 0x3000);
+		auto load_1 = NewLoad(object_pool, 0x300, 0x4000);
+		Dispatch(thread, { producer, load_0, store, load_1 });
+		EXPECT_TRUE(thread->canIssueLoad(load_0.get()));
+		EXPECT_EQ(kind == "None", thread->canIssueLoad(load_1.get()));
+
+		// Store address is known
+		thread->getRegisterFile()->WriteUop(producer.get());
+		EXPECT_TRUE(thread->canIssueLoad(load_1.get()));
+	}
+}
+
+
+// Tests that the memory access of a replayed load is ignored when it
+// finishes, while the access of a load that was not replayed completes
+TEST(TestMemoryDependence, replayed_access)
+{
+	// Memory system with a data module for the thread
+	mem::System::Destroy();
+	ObjectPool *object_pool = Configure("StoreSet");
+	misc::IniFile mem_ini_file;
+	mem_ini_file.LoadFromString(
+			"[ General ]\n"
+			"[ Module mod-mm ]\n"
+			"Type = MainMemory\n"
+			"Latency = 10\n"
+			"BlockSize = 64\n"
+			"[ Entry core-1 ]\n"
+			"Arch = x86\n"
+			"Core = 0\n"
+			"Thread = 0\n"
+			"Module = mod-mm\n");
+	try
+	{
+		mem::System::getInstance()->ReadConfiguration(&mem_ini_file);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+
+	// Both loads issue before the store address is known
+	Thread *thread = object_pool->getThread();
+	auto producer = NewProducer(object_pool);
+	auto load_0 = NewLoad(object_pool, 0x100, 0x3000);
+	auto store = NewStore(object_pool, 0x200, 0x2000);
+	auto load_1 = NewLoad(object_pool, 0x300, 0x2000);
+	Dispatch(thread, { producer, load_0, store, load_1 });
+	EXPECT_EQ(0, thread->IssueLoadQueue(2));
+	EXPECT_TRUE(load_0->issued);
+	EXPECT_TRUE(load_1->issued);
+
+	// The younger load is replayed while its access is in flight
+	thread->getRegisterFile()->WriteUop(producer.get());
+	thread->RecoverMemoryViolation();
+	EXPECT_EQ(1, load_1->num_replays);
+
+	// Only the access of the load that was not replayed completes
+	esim::Engine *esim_engine = esim::Engine::getInstance();
+	for (int i = 0; i < 100; i++)
+		esim_engine->ProcessEvents();
+	Core *core = thread->getCore();
+	std::vector<std::shared_ptr<Uop>> completed;
+	for (auto it = core->getEventQueueBegin();
+			it != core->getEventQueueEnd();
+			++it)
+		completed.push_back(*it);
+	ASSERT_EQ(1u, completed.size());
+	EXPECT_EQ(load_0, completed[0]);
+	EXPECT_FALSE(load_1->in_event_queue);
+
+	// Cleanup
+	ObjectPool::Destroy();
+	mem::System::Destroy();
+}
+
+}
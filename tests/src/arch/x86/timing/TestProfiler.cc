@@ -0,0 +1,412 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+
+#include <arch/common/CallStack.h>
+#include <arch/x86/emulator/Uinst.h>
+#include <arch/x86/timing/Profiler.h>
+#include <arch/x86/timing/Uop.h>
+#include <lib/cpp/Error.h>
+
+#include "ObjectPool.h"
+
+namespace x86
+{
+
+// Functions and data of the static binary created by WriteBinary(). Function
+// 'main' calls 'helper'. Both are in the first code segment, which starts
+// at file offset 0. Function 'compute' is in a second code segment, loaded
+// at a different distance from its file offset. Object 'data' is in a
+// data segment.
+static const unsigned binary_main = 0x08048100;
+static const unsigned binary_helper = 0x08048120;
+static const unsigned binary_compute = 0x0804a000;
+static const unsigned binary_data = 0x0804c100;
+
+
+// Append a string to a string table and return its offset
+static unsigned AddString(std::vector<char> &table, const char *s)
+{
+	unsigned offset = table.size();
+	table.insert(table.end(), s, s + strlen(s) + 1);
+	return offset;
+}
+
+
+// Write a 32-bit static executable in a temporary file and return its path
+static std::string WriteBinary()
+{
+	std::vector<char> buffer(0x1400);
+
+	// ELF header
+	Elf32_Ehdr *ehdr = (Elf32_Ehdr *) buffer.data();
+	memcpy(ehdr->e_ident, ELFMAG, SELFMAG);
+	ehdr->e_ident[EI_CLASS] = ELFCLASS32;
+	ehdr->e_ident[EI_DATA] = ELFDATA2LSB;
+	ehdr->e_ident[EI_VERSION] = EV_CURRENT;
+	ehdr->e_type = ET_EXEC;
+	ehdr->e_machine = EM_386;
+	ehdr->e_version = EV_CURRENT;
+	ehdr->e_entry = binary_main;
+	ehdr->e_phoff = sizeof(Elf32_Ehdr);
+	ehdr->e_shoff = 0x1200;
+	ehdr->e_ehsize = sizeof(Elf32_Ehdr);
+	ehdr->e_phentsize = sizeof(Elf32_Phdr);
+	ehdr->e_phnum = 3;
+	ehdr->e_shentsize = sizeof(Elf32_Shdr);
+	ehdr->e_shnum = 5;
+	ehdr->e_shstrndx = 4;
+
+	// Loadable segments
+	Elf32_Phdr *phdr = (Elf32_Phdr *) (buffer.data() + ehdr->e_phoff);
+	const unsigned segments[3][4] = {
+		{ 0, 0x08048000, 0x200, PF_R | PF_X },
+		{ 0x1000, binary_compute, 0x100, PF_R | PF_X },
+		{ 0x1100, binary_data, 0x100, PF_R | PF_W }
+	};
+	for (int i = 0; i < 3; i++)
+	{
+		phdr[i].p_type = PT_LOAD;
+		phdr[i].p_offset = segments[i][0];
+		phdr[i].p_vaddr = segments[i][1];
+		phdr[i].p_paddr = segments[i][1];
+		phdr[i].p_filesz = segments[i][2];
+		phdr[i].p_memsz = segments[i][2];
+		phdr[i].p_flags = segments[i][3];
+		phdr[i].p_align = 0x1000;
+	}
+
+	// Code: 'main' calls 'helper', which returns
+	memset(buffer.data() + 0x100, 0x90, 0x40);
+	memset(buffer.data() + 0x1000, 0x90, 0x100);
+	const unsigned char call[] = { 0xe8, 0x1b, 0x00, 0x00, 0x00 };
+	memcpy(buffer.data() + 0x100, call, sizeof call);
+	buffer[0x120] = (char) 0xc3;
+
+	// Symbols and their names
+	std::vector<char> strtab(1);
+	Elf32_Sym *sym = (Elf32_Sym *) (buffer.data() + 0x1300);
+	const char *names[4] = { "main", "helper", "compute", "data" };
+	const unsigned values[4] = { binary_main, binary_helper,
+			binary_compute, binary_data };
+	const unsigned sizes[4] = { 0x20, 0x20, 0x100, 0x100 };
+	for (int i = 0; i < 4; i++)
+	{
+		sym[i + 1].st_name = AddString(strtab, names[i]);
+		sym[i + 1].st_value = values[i];
+		sym[i + 1].st_size = sizes[i];
+		sym[i + 1].st_info = ELF32_ST_INFO(STB_GLOBAL,
+				i < 3 ? STT_FUNC : STT_OBJECT);
+		sym[i + 1].st_shndx = 1;
+	}
+	std::copy(strtab.begin(), strtab.end(), buffer.begin() + 0x1380);
+
+	// Sections
+	std::vector<char> shstrtab(1);
+	Elf32_Shdr *shdr = (Elf32_Shdr *) (buffer.data() + ehdr->e_shoff);
+	shdr[1].sh_name = AddString(shstrtab, ".text");
+	shdr[1].sh_type = SHT_PROGBITS;
+	shdr[1].sh_addr = binary_main;
+	shdr[1].sh_offset = 0x100;
+	shdr[1].sh_size = 0x40;
+	shdr[2].sh_name = AddString(shstrtab, ".symtab");
+	shdr[2].sh_type = SHT_SYMTAB;
+	shdr[2].sh_offset = 0x1300;
+	shdr[2].sh_size = 5 * sizeof(Elf32_Sym);
+	shdr[2].sh_link = 3;
+	shdr[2].sh_entsize = sizeof(Elf32_Sym);
+	shdr[3].sh_name = AddString(shstrtab, ".strtab");
+	shdr[3].sh_type = SHT_STRTAB;
+	shdr[3].sh_offset = 0x1380;
+	shdr[3].sh_size = strtab.size();
+	shdr[4].sh_name = AddString(shstrtab, ".shstrtab");
+	shdr[4].sh_type = SHT_STRTAB;
+	shdr[4].sh_offset = 0x13c0;
+	shdr[4].sh_size = shstrtab.size();
+	std::copy(shstrtab.begin(), shstrtab.end(), buffer.begin() + 0x13c0);
+
+	// Write file
+	char path[] = "/tmp/m2s.XXXXXX";
+	int fd = mkstemp(path);
+	EXPECT_NE(-1, fd);
+	EXPECT_EQ((ssize_t) buffer.size(), write(fd, buffer.data(),
+			buffer.size()));
+	close(fd);
+	return path;
+}
+
+
+// Read all lines of a file
+static std::vector<std::string> ReadLines(const std::string &path)
+{
+	std::vector<std::string> lines;
+	std::ifstream f(path);
+	std::string line;
+	while (std::getline(f, line))
+		lines.push_back(line);
+	return lines;
+}
+
+
+// Tests that the call stack of a context running a static executable finds
+// the symbols of its code segments, translating the position of an address
+// in the file into the virtual address of its segment.
+TEST(TestProfiler, test_call_stack_symbols)
+{
+	// Load binary
+	ObjectPool::Destroy();
+	std::string path = WriteBinary();
+	Context *context = Emulator::getInstance()->newContext();
+	try
+	{
+		context->Load({ path });
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+	comm::CallStack *call_stack = context->getCallStack();
+	ASSERT_TRUE(call_stack != nullptr);
+
+	// First code segment
+	std::string name;
+	unsigned offset;
+	EXPECT_TRUE(call_stack->getSymbol(binary_main, name, offset));
+	EXPECT_EQ("main", name);
+	EXPECT_EQ(0u, offset);
+	EXPECT_TRUE(call_stack->getSymbol(binary_helper + 4, name, offset));
+	EXPECT_EQ("helper", name);
+	EXPECT_EQ(4u, offset);
+
+	// Second code segment, at a different distance from its file offset
+	EXPECT_TRUE(call_stack->getSymbol(binary_compute + 0x10, name,
+			offset));
+	EXPECT_EQ("compute", name);
+	EXPECT_EQ(0x10u, offset);
+
+	// Data segments and unmapped addresses have no symbols
+	EXPECT_FALSE(call_stack->getSymbol(binary_data, name, offset));
+	EXPECT_FALSE(call_stack->getSymbol(0x10000000, name, offset));
+	unlink(path.c_str());
+}
+
+
+// Tests that calls and returns change the call stack, unless they are
+// emulated in speculative mode
+TEST(TestProfiler, test_call_stack_spec_mode)
+{
+	// Load binary
+	ObjectPool::Destroy();
+	std::string path = WriteBinary();
+	Context *context = Emulator::getInstance()->newContext();
+	try
+	{
+		context->Load({ path });
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+	comm::CallStack *call_stack = context->getCallStack();
+	ASSERT_TRUE(call_stack != nullptr);
+	long long version = call_stack->getVersion();
+
+	// Call in speculative mode
+	context->setState(Context::StateSpecMode);
+	context->Execute();
+	EXPECT_EQ(binary_helper, context->getRegs().getEip());
+	EXPECT_EQ(0u, call_stack->getFrames().size());
+	EXPECT_EQ(version, call_stack->getVersion());
+
+	// Same call out of speculative mode
+	context->clearState(Context::StateSpecMode);
+	context->getRegs().setEip(binary_main);
+	context->Execute();
+	ASSERT_EQ(1u, call_stack->getFrames().size());
+	EXPECT_EQ(binary_helper, call_stack->getFrames()[0].getIp());
+	EXPECT_NE(version, call_stack->getVersion());
+
+	// Return
+	context->Execute();
+	EXPECT_EQ(binary_main + 5, context->getRegs().getEip());
+	EXPECT_EQ(0u, call_stack->getFrames().size());
+	unlink(path.c_str());
+}
+
+
+// Tests the attribution of committed uops to instructions, functions, and
+// call stacks, and the profile dumped for them
+TEST(TestProfiler, test_commit)
+{
+	// Load binary
+	ObjectPool::Destroy();
+	ObjectPool *object_pool = ObjectPool::getInstance();
+	std::string path = WriteBinary();
+	Context *context = Emulator::getInstance()->newContext();
+	try
+	{
+		context->Load({ path });
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+	comm::CallStack *call_stack = context->getCallStack();
+	ASSERT_TRUE(call_stack != nullptr);
+
+	// Nodes of the call stacks main and main;compute. The node of a call
+	// stack is kept after returning to it.
+	Profiler profiler(path + ".profile");
+	EXPECT_EQ(0, profiler.getNode(context));
+	call_stack->Call(binary_main, 0x1000);
+	int node_main = profiler.getNode(context);
+	EXPECT_NE(0, node_main);
+	EXPECT_EQ(node_main, profiler.getNode(context));
+	call_stack->Call(binary_compute, 0xff0);
+	int node_compute = profiler.getNode(context);
+	EXPECT_NE(node_main, node_compute);
+	call_stack->Return(binary_main, 0x1000);
+	EXPECT_EQ(node_main, profiler.getNode(context));
+
+	// Commit uops
+	struct
+	{
+		Uinst::Opcode opcode;
+		int node;
+		unsigned eip;
+		int mop_index;
+		bool memory_miss;
+		unsigned predicted_neip;
+		long long cycles;
+	} commits[] = {
+		// Instruction with two uops in 'main'
+		{ Uinst::OpcodeLoad, node_main, binary_main + 4, 0, false, 0, 10 },
+		{ Uinst::OpcodeAdd, node_main, binary_main + 4, 1, false, 0, 5 },
+
+		// Load missing in the cache in 'compute'
+		{ Uinst::OpcodeLoad, node_compute, binary_compute + 0x10, 0,
+				true, 0, 7 },
+
+		// 'compute' seen from 'main' is merged with the call stack
+		// main;compute in the folded profile
+		{ Uinst::OpcodeAdd, node_main, binary_compute + 0x20, 0,
+				false, 0, 4 },
+
+		// Mispredicted and correctly predicted branches in 'helper'
+		{ Uinst::OpcodeBranch, node_main, binary_helper, 0, false,
+				binary_helper + 8, 3 },
+		{ Uinst::OpcodeBranch, node_main, binary_helper + 2, 0, false,
+				binary_helper + 6, 1 },
+
+		// No cycles
+		{ Uinst::OpcodeAdd, node_compute, binary_helper + 4, 0,
+				false, 0, 0 },
+
+		// Instruction without a symbol, out of any call
+		{ Uinst::OpcodeAdd, 0, binary_data, 0, false, 0, 2 }
+	};
+	for (auto &commit : commits)
+	{
+		Uinst uinst(commit.opcode);
+		Uop uop(object_pool->getThread(), context, uinst);
+		uop.profile_node = commit.node;
+		uop.eip = commit.eip;
+		uop.mop_index = commit.mop_index;
+		uop.memory_miss = commit.memory_miss;
+		uop.neip = commit.eip + 4;
+		uop.predicted_neip = commit.predicted_neip ?
+				commit.predicted_neip : uop.neip;
+		profiler.Commit(&uop, commit.cycles);
+	}
+
+	// Dump profile
+	try
+	{
+		profiler.Dump();
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+
+	// Call stacks, with the cycles of the functions within them
+	std::vector<std::string> folded = ReadLines(path + ".profile.folded");
+	ASSERT_EQ(4u, folded.size());
+	EXPECT_EQ("0x804c100 2", folded[0]);
+	EXPECT_EQ("main 15", folded[1]);
+	EXPECT_EQ("main;compute 11", folded[2]);
+	EXPECT_EQ("main;helper 4", folded[3]);
+
+	// Counters of functions in the flat profile
+	std::vector<std::string> flat = ReadLines(path + ".profile");
+	std::map<std::string, std::vector<long long>> functions;
+	bool found = false;
+	for (auto &line : flat)
+	{
+		if (line == "; Instructions")
+			break;
+		if (line == "; Functions")
+			found = true;
+		if (!found || line.empty() || line[0] == ';' ||
+				line.find("%Cycles") != std::string::npos)
+			continue;
+		std::istringstream is(line);
+		double percent;
+		std::vector<long long> counters(5);
+		std::string name;
+		is >> percent >> counters[0] >> counters[1] >> counters[2]
+				>> counters[3] >> counters[4] >> name;
+		functions[name] = counters;
+	}
+	ASSERT_EQ(4u, functions.size());
+	std::vector<long long> counters_main = { 15, 1, 2, 0, 0 };
+	std::vector<long long> counters_compute = { 11, 2, 2, 1, 0 };
+	std::vector<long long> counters_helper = { 4, 3, 3, 0, 1 };
+	std::vector<long long> counters_unknown = { 2, 1, 1, 0, 0 };
+	EXPECT_EQ(counters_main, functions["main"]);
+	EXPECT_EQ(counters_compute, functions["compute"]);
+	EXPECT_EQ(counters_helper, functions["helper"]);
+	EXPECT_EQ(counters_unknown, functions["0x804c100"]);
+
+	// Instructions are located within their functions
+	bool found_main = false;
+	for (auto &line : flat)
+		if (line.find("0x08048104 main+0x4") != std::string::npos)
+			found_main = true;
+	EXPECT_TRUE(found_main);
+
+	unlink(path.c_str());
+	unlink((path + ".profile").c_str());
+	unlink((path + ".profile.folded").c_str());
+}
+
+}
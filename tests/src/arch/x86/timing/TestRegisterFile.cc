@@ -96,10 +96,10 @@ TEST(TestRegisterFile, can_rename_private_register_0)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 					 object_pool->getContext(),
-					 uinst_0);
+					 *uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 					object_pool->getContext(),
-					uinst_1);
+					*uinst_1);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -161,10 +161,10 @@ TEST(TestRegisterFile, can_rename_private_register_1)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 					 object_pool->getContext(),
-					 uinst_0);
+					 *uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 					object_pool->getContext(),
-					uinst_1);
+					*uinst_1);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -225,10 +225,10 @@ TEST(TestRegisterFile, can_rename_private_register_2)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 					 object_pool->getContext(),
-					 uinst_0);
+					 *uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 					object_pool->getContext(),
-					uinst_1);
+					*uinst_1);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -290,10 +290,10 @@ TEST(TestRegisterFile, can_rename_shared_register_0)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 					 object_pool->getContext(),
-					 uinst_0);
+					 *uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 					object_pool->getContext(),
-					uinst_1);
+					*uinst_1);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -356,10 +356,10 @@ TEST(TestRegisterFile, can_rename_shared_register_1)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 					 object_pool->getContext(),
-					 uinst_0);
+					 *uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 					object_pool->getContext(),
-					uinst_1);
+					*uinst_1);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -421,10 +421,10 @@ TEST(TestRegisterFile, can_rename_shared_register_2)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 					 object_pool->getContext(),
-					 uinst_0);
+					 *uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 					object_pool->getContext(),
-					uinst_1);
+					*uinst_1);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -480,7 +480,7 @@ TEST(TestRegisterFile, rename_0)
 	// Create uop with one uinst
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -529,7 +529,7 @@ TEST(TestRegisterFile, rename_1)
 	// Create uop with one uinst
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -575,7 +575,7 @@ TEST(TestRegisterFile, rename_2)
 	// Create uop with one uinst
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -624,7 +624,7 @@ TEST(TestRegisterFile, rename_3)
 	// Create uop with one uinst
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	// Set up register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -672,10 +672,10 @@ TEST(TestRegisterFile, is_uop_ready_0)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_1);
+			*uinst_1);
 
 	// Get register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -708,7 +708,7 @@ TEST(TestRegisterFile, is_uop_ready_1)
 	// Create uop
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	// Get register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -742,7 +742,7 @@ TEST(TestRegisterFile, is_uop_ready_2)
 	// Create uop
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	// This should be false by default.  We just created the uop.
 	EXPECT_FALSE(uop_0->ready);
@@ -797,10 +797,10 @@ TEST(TestRegisterFile, write_uop_0)
 	// Create uops
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_1);
+			*uinst_1);
 
 	// Get register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
@@ -821,6 +821,76 @@ TEST(TestRegisterFile, write_uop_0)
 	EXPECT_TRUE(register_file->isUopReady(uop_0.get()));
 }
 
+// Tests that WriteUop() wakes up the consumers of its outputs. A consumer
+// counts the inputs that were pending when it was renamed, and is made
+// ready when the last of them is written. Uops renamed after the write do
+// not wait for it.
+TEST(TestRegisterFile, write_uop_1)
+{
+	// Cleanup singleton instances
+	ObjectPool::Destroy();
+
+	// Get object pool instance
+	ObjectPool *object_pool = ObjectPool::getInstance();
+
+	// Create uinsts. Producers write eax and ebx, and the consumer reads
+	// both of them.
+	auto uinst_0 = misc::new_shared<Uinst>(Uinst::OpcodeAdd);
+	auto uinst_1 = misc::new_shared<Uinst>(Uinst::OpcodeAdd);
+	auto uinst_2 = misc::new_shared<Uinst>(Uinst::OpcodeAdd);
+	uinst_0->setODep(0, Uinst::DepEax);
+	uinst_1->setODep(0, Uinst::DepEbx);
+	uinst_2->setIDep(0, Uinst::DepEax);
+	uinst_2->setIDep(1, Uinst::DepEbx);
+	uinst_2->setODep(0, Uinst::DepEcx);
+
+	// Create uops
+	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			*uinst_0);
+	auto uop_1 = misc::new_unique<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			*uinst_1);
+	auto uop_2 = misc::new_unique<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			*uinst_2);
+	auto uop_3 = misc::new_unique<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			*uinst_2);
+
+	// Get register file
+	auto register_file = object_pool->getThread()->getRegisterFile();
+
+	// Producers have no pending inputs
+	register_file->Rename(uop_0.get());
+	register_file->Rename(uop_1.get());
+	EXPECT_EQ(0, uop_0->num_pending_inputs);
+	EXPECT_TRUE(uop_0->ready);
+
+	// The consumer waits for both producers
+	register_file->Rename(uop_2.get());
+	EXPECT_EQ(2, uop_2->num_pending_inputs);
+	EXPECT_FALSE(uop_2->ready);
+
+	// Writing one input is not enough
+	register_file->WriteUop(uop_1.get());
+	EXPECT_EQ(1, uop_2->num_pending_inputs);
+	EXPECT_FALSE(uop_2->ready);
+
+	// A uop renamed now only waits for the other one
+	register_file->Rename(uop_3.get());
+	EXPECT_EQ(1, uop_3->num_pending_inputs);
+	EXPECT_FALSE(uop_3->ready);
+
+	// Writing the last input wakes up both consumers
+	register_file->WriteUop(uop_0.get());
+	EXPECT_EQ(0, uop_2->num_pending_inputs);
+	EXPECT_TRUE(uop_2->ready);
+	EXPECT_EQ(0, uop_3->num_pending_inputs);
+	EXPECT_TRUE(uop_3->ready);
+	EXPECT_TRUE(register_file->isUopReady(uop_2.get()));
+}
+
 
 
 
@@ -853,7 +923,7 @@ TEST(TestRegisterFile, undo_uop_0)
 	// Create uop
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	uop_0->speculative_mode = true;
 
@@ -905,7 +975,7 @@ TEST(TestRegisterFile, undo_uop_1)
 	// Create uop
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	uop_0->speculative_mode = true;
 
@@ -957,7 +1027,7 @@ TEST(TestRegisterFile, undo_uop_2)
 	// Create uop
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	uop_0->speculative_mode = true;
 
@@ -989,6 +1059,62 @@ TEST(TestRegisterFile, undo_uop_2)
 	EXPECT_TRUE(register_file->isXmmRegisterFree(new_physical_register_2));
 }
 
+// Tests that UndoUop() stops a squashed uop from waiting for its pending
+// inputs. Consumers are squashed from the youngest, and the remaining
+// ones are still woken up when the input is written.
+TEST(TestRegisterFile, undo_uop_3)
+{
+	// Cleanup singleton instances
+	ObjectPool::Destroy();
+
+	// Get object pool instance
+	ObjectPool *object_pool = ObjectPool::getInstance();
+
+	// Create uinsts. The producer writes eax, and three consumers read
+	// it.
+	auto uinst_0 = misc::new_shared<Uinst>(Uinst::OpcodeAdd);
+	auto uinst_1 = misc::new_shared<Uinst>(Uinst::OpcodeAdd);
+	uinst_0->setODep(0, Uinst::DepEax);
+	uinst_1->setIDep(0, Uinst::DepEax);
+
+	// Create uops
+	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
+			object_pool->getContext(),
+			*uinst_0);
+	std::unique_ptr<Uop> consumers[3];
+	for (auto &consumer : consumers)
+	{
+		consumer = misc::new_unique<Uop>(object_pool->getThread(),
+				object_pool->getContext(),
+				*uinst_1);
+		consumer->speculative_mode = true;
+	}
+
+	// Get register file
+	auto register_file = object_pool->getThread()->getRegisterFile();
+
+	// Rename all uops
+	register_file->Rename(uop_0.get());
+	for (auto &consumer : consumers)
+	{
+		register_file->Rename(consumer.get());
+		EXPECT_EQ(1, consumer->num_pending_inputs);
+	}
+
+	// Squash the two youngest consumers
+	register_file->UndoUop(consumers[2].get());
+	register_file->UndoUop(consumers[1].get());
+	EXPECT_EQ(0, consumers[2]->num_pending_inputs);
+	EXPECT_EQ(0, consumers[1]->num_pending_inputs);
+
+	// Only the remaining consumer is woken up
+	register_file->WriteUop(uop_0.get());
+	EXPECT_TRUE(consumers[0]->ready);
+	EXPECT_EQ(0, consumers[0]->num_pending_inputs);
+	EXPECT_FALSE(consumers[1]->ready);
+	EXPECT_FALSE(consumers[2]->ready);
+}
+
 
 
 
@@ -1019,7 +1145,7 @@ TEST(TestRegisterFile, commit_uop_0)
 	// Create uop
 	auto uop_0 = misc::new_unique<Uop>(object_pool->getThread(),
 			object_pool->getContext(),
-			uinst_0);
+			*uinst_0);
 
 	// Get register file
 	auto register_file = object_pool->getThread()->getRegisterFile();
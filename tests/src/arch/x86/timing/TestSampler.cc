@@ -0,0 +1,62 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+#include <arch/x86/timing/Sampler.h>
+
+namespace x86
+{
+
+// Tests the mean CPI and its confidence interval computed from the samples
+// taken in detailed intervals
+TEST(TestSampler, test_cpi_confidence)
+{
+	// The sampler does not access the CPU when adding samples
+	Sampler sampler(nullptr);
+	EXPECT_EQ(0, sampler.getNumSamples());
+	EXPECT_DOUBLE_EQ(0.0, sampler.getCpi());
+	EXPECT_DOUBLE_EQ(0.0, sampler.getCpiConfidence());
+
+	// A single sample has no confidence interval
+	sampler.AddSample(3000, 1000);
+	EXPECT_EQ(1, sampler.getNumSamples());
+	EXPECT_DOUBLE_EQ(3.0, sampler.getCpi());
+	EXPECT_DOUBLE_EQ(0.0, sampler.getCpiConfidence());
+
+	// CPIs 3, 1, and 2 have a mean of 2 and a sample standard deviation
+	// of 1. The samples do not need to have the same length.
+	sampler.AddSample(500, 500);
+	sampler.AddSample(4000, 2000);
+	EXPECT_EQ(3, sampler.getNumSamples());
+	EXPECT_DOUBLE_EQ(2.0, sampler.getCpi());
+	EXPECT_NEAR(1.96 / sqrt(3.0), sampler.getCpiConfidence(), 1e-12);
+
+	// Identical samples narrow the interval
+	for (int i = 0; i < 97; i++)
+		sampler.AddSample(2000, 1000);
+	EXPECT_EQ(100, sampler.getNumSamples());
+	EXPECT_DOUBLE_EQ(2.0, sampler.getCpi());
+	EXPECT_NEAR(1.96 * sqrt(2.0 / 99) / 10, sampler.getCpiConfidence(),
+			1e-12);
+}
+
+}
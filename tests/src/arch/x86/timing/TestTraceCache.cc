@@ -67,7 +67,7 @@ void ParseUopInstance(UopInstanceType instance_type, int address,
 		uop_list.push_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst_branch));
+				*uinst_branch));
 		uop = uop_list.back().get();
 		uop->eip = address;
 		if (taken)
@@ -82,7 +82,7 @@ void ParseUopInstance(UopInstanceType instance_type, int address,
 		uop_list.push_back(misc::new_unique<Uop>(
 				object_pool->getThread(),
 				object_pool->getContext(),
-				uinst_move));
+				*uinst_move));
 		uop = uop_list.back().get();
 		uop->eip = address;
 		uop->mop_size = instruction_size;
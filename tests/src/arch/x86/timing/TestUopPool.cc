@@ -0,0 +1,70 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <arch/x86/emulator/Uinst.h>
+#include <arch/x86/timing/Uop.h>
+#include <arch/x86/timing/UopPool.h>
+
+#include "ObjectPool.h"
+
+namespace x86
+{
+
+// Tests that released uops are recycled without allocating from the heap
+TEST(TestUopPool, recycle_uops)
+{
+	// Setup the timing simulator related object pool
+	ObjectPool::Destroy();
+	ObjectPool *object_pool = ObjectPool::getInstance();
+	UopPool *uop_pool = UopPool::getInstance();
+
+	// Create uops
+	Uinst uinst(Uinst::OpcodeAdd);
+	uinst.setIDep(0, Uinst::DepEax);
+	uinst.setODep(0, Uinst::DepEbx);
+	std::vector<std::shared_ptr<Uop>> uops;
+	long long num_in_use = uop_pool->getNumInUse();
+	for (int i = 0; i < 1000; i++)
+		uops.push_back(uop_pool->newUop(object_pool->getThread(),
+				object_pool->getContext(),
+				uinst));
+	EXPECT_EQ(num_in_use + 1000, uop_pool->getNumInUse());
+
+	// Uops keep a copy of the micro-instruction
+	uinst.setODep(0, Uinst::DepEcx);
+	EXPECT_EQ(Uinst::DepEbx, uops[0]->getUinst()->getODep(0));
+	EXPECT_EQ(1, uops[999]->getNumIntegerInputs());
+
+	// Release and create them again
+	long long num_heap_allocations = uop_pool->getNumHeapAllocations();
+	uops.clear();
+	EXPECT_EQ(num_in_use, uop_pool->getNumInUse());
+	for (int i = 0; i < 1000; i++)
+		uops.push_back(uop_pool->newUop(object_pool->getThread(),
+				object_pool->getContext(),
+				uinst));
+	EXPECT_EQ(num_heap_allocations, uop_pool->getNumHeapAllocations());
+	EXPECT_EQ(Uinst::DepEcx, uops[0]->getUinst()->getODep(0));
+}
+
+}  // namespace x86
@@ -0,0 +1,146 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <arch/x86/emulator/Uinst.h>
+#include <arch/x86/timing/Uop.h>
+#include <arch/x86/timing/UopRing.h>
+
+#include "ObjectPool.h"
+
+namespace x86
+{
+
+// Tests insertion and extraction at both ends of the queue, wrapping around
+// the end of the buffer
+TEST(TestUopRing, push_pop)
+{
+	// Setup the timing simulator related object pool
+	ObjectPool::Destroy();
+	ObjectPool *object_pool = ObjectPool::getInstance();
+
+	// Create uops
+	Uinst uinst(Uinst::OpcodeAdd);
+	std::vector<std::shared_ptr<Uop>> uops;
+	for (int i = 0; i < 6; i++)
+		uops.push_back(std::make_shared<Uop>(object_pool->getThread(),
+				object_pool->getContext(),
+				uinst));
+
+	// Fill the queue and extract two uops from the head
+	UopRing ring(4);
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(i, ring.push_back(uops[i]));
+	ring.pop_front();
+	ring.pop_front();
+	EXPECT_EQ(2, ring.size());
+	EXPECT_EQ(2, ring.getHead());
+
+	// New uops take the positions released at the beginning
+	EXPECT_EQ(0, ring.push_back(uops[4]));
+	EXPECT_EQ(1, ring.push_back(uops[5]));
+	EXPECT_EQ(4, ring.getCapacity());
+	EXPECT_EQ(uops[2], ring.front());
+	EXPECT_EQ(uops[5], ring.back());
+	EXPECT_EQ(uops[4], ring.getEntry(0));
+
+	// Squash from the tail
+	ring.pop_back();
+	EXPECT_EQ(uops[4], ring.back());
+	EXPECT_EQ(1, ring.push_back(uops[5]));
+
+	// Traverse from the head
+	int index = 2;
+	for (auto &uop : ring)
+		EXPECT_EQ(uops[index++], uop);
+	EXPECT_EQ(6, index);
+
+	// The queue keeps uops alive until they are extracted
+	EXPECT_EQ(2, uops[5].use_count());
+	ring.pop_back();
+	EXPECT_EQ(1, uops[5].use_count());
+}
+
+// Tests that a full queue grows keeping its uops in order
+TEST(TestUopRing, grow)
+{
+	// Setup the timing simulator related object pool
+	ObjectPool::Destroy();
+	ObjectPool *object_pool = ObjectPool::getInstance();
+
+	// Create uops
+	Uinst uinst(Uinst::OpcodeAdd);
+	std::vector<std::shared_ptr<Uop>> uops;
+	for (int i = 0; i < 10; i++)
+		uops.push_back(std::make_shared<Uop>(object_pool->getThread(),
+				object_pool->getContext(),
+				uinst));
+
+	// Insert uops wrapping around the end of the buffer
+	UopRing ring(4);
+	ring.push_back(uops[0]);
+	ring.pop_front();
+	for (int i = 1; i < 10; i++)
+		ring.push_back(uops[i]);
+	EXPECT_EQ(9, ring.size());
+	EXPECT_EQ(16, ring.getCapacity());
+
+	// Uops are kept in order
+	for (int i = 0; i < 9; i++)
+		EXPECT_EQ(uops[i + 1], ring[i]);
+}
+
+// Tests that uops inserted at the head go before the current ones
+TEST(TestUopRing, push_front)
+{
+	// Setup the timing simulator related object pool
+	ObjectPool::Destroy();
+	ObjectPool *object_pool = ObjectPool::getInstance();
+
+	// Create uops
+	Uinst uinst(Uinst::OpcodeAdd);
+	std::vector<std::shared_ptr<Uop>> uops;
+	for (int i = 0; i < 6; i++)
+		uops.push_back(std::make_shared<Uop>(object_pool->getThread(),
+				object_pool->getContext(),
+				uinst));
+
+	// Insert at the head, wrapping around the beginning of the buffer
+	UopRing ring(4);
+	EXPECT_EQ(0, ring.push_back(uops[3]));
+	EXPECT_EQ(3, ring.push_front(uops[2]));
+	EXPECT_EQ(2, ring.push_front(uops[1]));
+	EXPECT_EQ(1, ring.push_front(uops[0]));
+	EXPECT_EQ(4, ring.getCapacity());
+
+	// Insert in a full queue, which grows
+	ring.push_front(uops[4]);
+	ring.push_back(uops[5]);
+	EXPECT_EQ(8, ring.getCapacity());
+	ASSERT_EQ(6, ring.size());
+	EXPECT_EQ(uops[4], ring[0]);
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(uops[i], ring[i + 1]);
+	EXPECT_EQ(uops[5], ring.back());
+}
+
+}  // namespace x86
@@ -19,6 +19,8 @@
 
 #include "gtest/gtest.h"
 
+#include <sstream>
+
 #include <lib/cpp/Misc.h>
 #include <lib/cpp/Error.h>
 #include <lib/esim/Engine.h>
@@ -135,7 +137,7 @@ TEST(TestEngine, test_event_frame)
 		Cleanup();
 
 		// Set frame
-		auto frame = misc::new_shared<DummyFrame_1>();
+		auto frame = new_frame<DummyFrame_1>();
 
 		// Set up esim engine
 		Engine *engine = Engine::getInstance();
@@ -348,10 +350,10 @@ TEST(TestEngine, test_event_queue)
 		Event *event2 = engine->RegisterEvent("event 2", testHandler_3_2, domain);
 
 		// Set frame
-		auto frame_3_0 = misc::new_shared<DummyFrame_3_0>();
+		auto frame_3_0 = new_frame<DummyFrame_3_0>();
 
 		// Set frame
-		auto frame_3_1 = misc::new_shared<DummyFrame_3_1>();
+		auto frame_3_1 = new_frame<DummyFrame_3_1>();
 
 		// Schedule event for 5 cycles from now
 		engine->Call(event1, frame_3_0, nullptr, 5, 0);
@@ -477,10 +479,10 @@ TEST(TestEngine, test_event_queue_priority)
 		Event *event2 = engine->RegisterEvent("event 2", testHandler_4_2, domain);
 
 		// Set frame
-		auto frame_4_0 = misc::new_shared<DummyFrame_4_0>();
+		auto frame_4_0 = new_frame<DummyFrame_4_0>();
 
 		// Set frame
-		auto frame_4_1 = misc::new_shared<DummyFrame_4_1>();
+		auto frame_4_1 = new_frame<DummyFrame_4_1>();
 
 		// Schedule event for 5 cycles from now
 		engine->Call(event1, frame_4_0, nullptr, 5, 0);
@@ -516,9 +518,669 @@ TEST(TestEngine, test_event_queue_priority)
 	}
 }
 
+
+
+//
+// Test 5
+//
+
+// Event frame carrying an identifier and a hop counter
+class DummyFrame_5 : public Frame
+{
+public:
+	int id;
+	int hops = 0;
+
+	DummyFrame_5(int id) : id(id) { }
+};
+
+// Latencies in cycles, taken from the cache and main memory latencies in
+// samples/memory, plus one that exceeds the horizon of the timing wheel.
+const int latencies_5[] = { 0, 1, 2, 20, 100, 200, 5000 };
+
+// Event types, one per frequency domain, plus the return event
+Event *events_5[3];
+Event *return_event_5;
+
+// Queue where event chains suspend
+std::unique_ptr<Queue> queue_5;
+
+// Record of triggered events
+std::vector<std::string> trace_5;
+
+// Deterministic pseudo-random sequence
+unsigned seed_5;
+int id_counter_5;
+
+int Random_5(int max)
+{
+	seed_5 = seed_5 * 1103515245 + 12345;
+	return (seed_5 >> 16) % max;
+}
+
+int RandomLatency_5()
+{
+	return latencies_5[Random_5(sizeof latencies_5 /
+			sizeof latencies_5[0])];
+}
+
+// Event chain body, continuing the chain in a random way
+void testHandler_5(Event *event, Frame *frame)
+{
+	Engine *engine = Engine::getInstance();
+	DummyFrame_5 *data = dynamic_cast<DummyFrame_5 *>(frame);
+	trace_5.push_back(misc::fmt("%lld %s %d", engine->getTime(),
+			event->getName().c_str(), data->id));
+
+	// End of chain
+	data->hops++;
+	if (data->hops > 12)
+	{
+		engine->Return(RandomLatency_5());
+		return;
+	}
+
+	// Continue chain
+	Event *next_event = events_5[Random_5(3)];
+	switch (Random_5(4))
+	{
+	case 0:
+	case 1:
+
+		engine->Next(next_event, RandomLatency_5());
+		break;
+
+	case 2:
+
+		engine->Call(next_event,
+				new_frame<DummyFrame_5>(id_counter_5++),
+				return_event_5,
+				RandomLatency_5());
+		break;
+
+	case 3:
+
+		queue_5->Wait(next_event, Random_5(2));
+		break;
+	}
+}
+
+// Periodic event creating new event chains and waking up suspended ones
+void testHandlerSpawn_5(Event *event, Frame *frame)
+{
+	Engine *engine = Engine::getInstance();
+	if (Random_5(2))
+		queue_5->WakeupAll();
+	if (id_counter_5 < 3000)
+		engine->Call(events_5[Random_5(3)],
+				new_frame<DummyFrame_5>(id_counter_5++),
+				nullptr,
+				RandomLatency_5());
+}
+
+// Run the event-driven simulation with the given scheduler
+std::vector<std::string> RunScheduler_5(Engine::SchedulerKind kind)
+{
+	// Reset state
+	Cleanup();
+	Engine::setSchedulerKind(kind);
+	queue_5 = misc::new_unique<Queue>();
+	trace_5.clear();
+	seed_5 = 1;
+	id_counter_5 = 0;
+
+	// Frequency domains of the x86 pipeline, SI compute units, and a
+	// slower memory domain
+	Engine *engine = Engine::getInstance();
+	FrequencyDomain *domains[3] =
+	{
+		engine->RegisterFrequencyDomain("x86", 1000),
+		engine->RegisterFrequencyDomain("SI", 925),
+		engine->RegisterFrequencyDomain("mem", 600)
+	};
+
+	// Events
+	for (int i = 0; i < 3; i++)
+		events_5[i] = engine->RegisterEvent(misc::fmt("event %d", i),
+				testHandler_5, domains[i]);
+	return_event_5 = engine->RegisterEvent("return", testHandler_5,
+			domains[2]);
+	Event *spawn_event = engine->RegisterEvent("spawn",
+			testHandlerSpawn_5, domains[0]);
+
+	// Run simulation
+	engine->Next(spawn_event, 1, 3);
+	for (int i = 0; i < 30000; i++)
+		engine->ProcessEvents();
+	EXPECT_EQ(kind, engine->getSchedulerKind());
+
+	// Restore default scheduler
+	Cleanup();
+	Engine::setSchedulerKind(Engine::SchedulerHeap);
+	queue_5 = nullptr;
+	return trace_5;
+}
+
+// Tests that the timing wheel triggers events in exactly the same order as
+// the event heap
+TEST(TestEngine, test_scheduler_event_order)
+{
+	try
+	{
+		std::vector<std::string> heap_trace =
+				RunScheduler_5(Engine::SchedulerHeap);
+		std::vector<std::string> wheel_trace =
+				RunScheduler_5(Engine::SchedulerWheel);
+
+		// Check that a significant number of events ran
+		EXPECT_GT(heap_trace.size(), 10000u);
+
+		// Check identical order
+		ASSERT_EQ(heap_trace.size(), wheel_trace.size());
+		for (unsigned i = 0; i < heap_trace.size(); i++)
+			ASSERT_EQ(heap_trace[i], wheel_trace[i]);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+
+//
+// Test 6
+//
+
+// Dummy frame
+class DummyFrame_6 : public Frame
+{
+public:
+	int *destroyed;
+
+	DummyFrame_6(int *destroyed) : destroyed(destroyed) { }
+
+	~DummyFrame_6() { (*destroyed)++; }
+};
+
+// Empty handler
+void testHandler_6(Event *event, Frame *frame)
+{
+}
+
+// Tests that event frames are released when their event chain finishes and
+// that their memory is recycled by the frame arena
+TEST(TestEngine, test_frame_arena)
+{
+	try
+	{
+		// Cleanup pointers to singleton instances
+		Cleanup();
+
+		// Set up esim engine
+		Engine *engine = Engine::getInstance();
+		FrequencyDomain *domain = engine->RegisterFrequencyDomain(
+				"frequency domain", 1000);
+		Event *event = engine->RegisterEvent("event", testHandler_6,
+				domain);
+		FrameArena *arena = FrameArena::getInstance<DummyFrame_6>();
+
+		// Schedule an event chain
+		int destroyed = 0;
+		auto frame = new_frame<DummyFrame_6>(&destroyed);
+		DummyFrame_6 *first_frame = frame.get();
+		engine->Call(event, frame, nullptr, 1);
+		EXPECT_EQ(2, frame->getNumReferences());
+		EXPECT_EQ(1, arena->getNumInUse());
+
+		// Run event, the engine drops its reference
+		frame = nullptr;
+		engine->ProcessEvents();
+		engine->ProcessEvents();
+		EXPECT_EQ(1, destroyed);
+		EXPECT_EQ(0, arena->getNumInUse());
+
+		// A new frame reuses the released memory
+		long long num_hits = arena->getNumHits();
+		frame = new_frame<DummyFrame_6>(&destroyed);
+		EXPECT_EQ(first_frame, frame.get());
+		EXPECT_EQ(num_hits + 1, arena->getNumHits());
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+
+//
+// Test 7
+//
+
+// Cycle in which the event handler ran
+long long cycle_7 = 0;
+
+// Record the current cycle
+void testHandler_7(Event *event, Frame *frame)
+{
+	cycle_7 = Engine::getInstance()->getCycle();
+}
+
+// Tests that skipping the cycles before the next pending event runs the
+// event in the same cycle, and counts the skipped cycles
+TEST(TestEngine, test_skip_time)
+{
+	try
+	{
+		// Cleanup pointers to singleton instances
+		Cleanup();
+
+		// Set up esim engine
+		Engine *engine = Engine::getInstance();
+		FrequencyDomain *domain = engine->RegisterFrequencyDomain(
+				"frequency domain", 1000);
+		Event *event = engine->RegisterEvent("event", testHandler_7,
+				domain);
+
+		// No pending event
+		EXPECT_EQ(-1, engine->getNextEventTime());
+
+		// Schedule an event 100 cycles ahead
+		engine->Call(event, nullptr, nullptr, 100);
+		engine->ProcessEvents();
+		EXPECT_EQ(100000, engine->getNextEventTime());
+
+		// Skip straight to the event
+		engine->SkipTime(engine->getNextEventTime());
+		EXPECT_EQ(99, engine->getNumSkippedCycles());
+		EXPECT_EQ(0, cycle_7);
+		engine->ProcessEvents();
+		EXPECT_EQ(101, cycle_7);
+		EXPECT_EQ(-1, engine->getNextEventTime());
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+//
+// Test 8
+//
+
+// Event frame carrying an identifier and a hop counter
+class DummyFrame_8 : public Frame
+{
+public:
+	int id;
+	int hops = 0;
+
+	DummyFrame_8(int id) : id(id) { }
+};
+
+// Number of frequency domains, each one running in its own partition
+const int num_domains_8 = 4;
+
+// Event types of each frequency domain
+Event *events_8[num_domains_8];
+Event *return_events_8[num_domains_8];
+
+// Queues where event chains of each domain suspend
+std::unique_ptr<Queue> queues_8[num_domains_8];
+
+// Record of triggered events of each domain. Each record is only accessed
+// by the thread running the domain's partition.
+std::vector<std::string> traces_8[num_domains_8];
+
+// Deterministic pseudo-random sequence and frame identifiers of each domain
+unsigned seeds_8[num_domains_8];
+int id_counters_8[num_domains_8];
+
+int Random_8(int domain, int max)
+{
+	seeds_8[domain] = seeds_8[domain] * 1103515245 + 12345;
+	return (seeds_8[domain] >> 16) % max;
+}
+
+int RandomLatency_8(int domain)
+{
+	return latencies_5[Random_8(domain, sizeof latencies_5 /
+			sizeof latencies_5[0])];
+}
+
+int NewId_8(int domain)
+{
+	return domain * 1000000 + id_counters_8[domain]++;
+}
+
+int Domain_8(Event *event)
+{
+	for (int i = 0; i < num_domains_8; i++)
+		if (event == events_8[i] || event == return_events_8[i])
+			return i;
+	return event->getFrequencyDomain()->getPartition();
+}
+
+// Event chain body. Chains continue in their own domain for any cycle, and
+// call chains of other domains for future cycles.
+void testHandler_8(Event *event, Frame *frame)
+{
+	Engine *engine = Engine::getInstance();
+	int domain = Domain_8(event);
+	DummyFrame_8 *data = dynamic_cast<DummyFrame_8 *>(frame);
+	traces_8[domain].push_back(misc::fmt("%lld %s %d",
+			engine->getTime(), event->getName().c_str(),
+			data->id));
+	EXPECT_EQ(event, engine->getCurrentEvent());
+
+	// End of chain, returning to the caller in a future cycle
+	data->hops++;
+	if (data->hops > 12)
+	{
+		engine->Return(1 + RandomLatency_8(domain));
+		return;
+	}
+
+	// Continue chain
+	switch (Random_8(domain, 5))
+	{
+	case 0:
+	case 1:
+
+		engine->Next(events_8[domain], RandomLatency_8(domain));
+		break;
+
+	case 2:
+
+		engine->Call(events_8[domain],
+				new_frame<DummyFrame_8>(NewId_8(domain)),
+				return_events_8[domain],
+				RandomLatency_8(domain));
+		break;
+
+	case 3:
+
+		engine->Call(events_8[Random_8(domain, num_domains_8)],
+				new_frame<DummyFrame_8>(NewId_8(domain)),
+				return_events_8[domain],
+				1 + RandomLatency_8(domain));
+		break;
+
+	case 4:
+
+		queues_8[domain]->Wait(events_8[domain],
+				Random_8(domain, 2));
+		break;
+	}
+}
+
+// Periodic event of each domain creating new event chains and waking up
+// suspended ones
+void testHandlerSpawn_8(Event *event, Frame *frame)
+{
+	Engine *engine = Engine::getInstance();
+	int domain = event->getFrequencyDomain()->getPartition();
+	if (Random_8(domain, 2))
+		queues_8[domain]->WakeupAll();
+	if (id_counters_8[domain] < 1000)
+		engine->Call(events_8[domain],
+				new_frame<DummyFrame_8>(NewId_8(domain)),
+				nullptr,
+				RandomLatency_8(domain));
+}
+
+// Run the event-driven simulation with the given number of threads, and
+// return the report of the engine up to its thread statistics
+std::string RunThreads_8(int num_threads)
+{
+	// Reset state
+	Cleanup();
+	Engine::setNumThreads(num_threads);
+	for (int i = 0; i < num_domains_8; i++)
+	{
+		queues_8[i] = misc::new_unique<Queue>();
+		traces_8[i].clear();
+		seeds_8[i] = i + 1;
+		id_counters_8[i] = 0;
+	}
+
+	// Frequency domains, one partition each
+	Engine *engine = Engine::getInstance();
+	const int frequencies[num_domains_8] = { 1000, 925, 600, 1000 };
+	for (int i = 0; i < num_domains_8; i++)
+	{
+		FrequencyDomain *domain = engine->RegisterFrequencyDomain(
+				misc::fmt("domain %d", i), frequencies[i]);
+		events_8[i] = engine->RegisterEvent(misc::fmt("event %d", i),
+				testHandler_8, domain);
+		return_events_8[i] = engine->RegisterEvent(
+				misc::fmt("return %d", i),
+				testHandler_8, domain);
+		Event *spawn_event = engine->RegisterEvent(
+				misc::fmt("spawn %d", i),
+				testHandlerSpawn_8, domain);
+		engine->Next(spawn_event, 1, 2 + i);
+	}
+	EXPECT_EQ(num_domains_8, engine->getNumPartitions());
+
+	// Run simulation
+	for (int i = 0; i < 30000; i++)
+		engine->ProcessEvents();
+	if (num_threads > 1)
+		EXPECT_GT(engine->getNumParallelWindows(), 1000);
+	std::ostringstream report;
+	engine->DumpReport(report);
+
+	// Restore sequential engine
+	Cleanup();
+	Engine::setNumThreads(1);
+	for (int i = 0; i < num_domains_8; i++)
+		queues_8[i] = nullptr;
+
+	// Discard thread statistics and frame arenas
+	std::string result = report.str();
+	return result.substr(0, result.find("Threads ="));
+}
+
+// Tests that the parallel engine runs the same events at the same time and
+// in the same order within each partition as the sequential engine, with
+// identical statistics
+TEST(TestEngine, test_parallel_engine)
+{
+	try
+	{
+		std::string sequential_report = RunThreads_8(1);
+		std::vector<std::string> sequential_traces[num_domains_8];
+		for (int i = 0; i < num_domains_8; i++)
+			sequential_traces[i] = traces_8[i];
+		std::string parallel_report = RunThreads_8(4);
+
+		// Compare traces
+		for (int i = 0; i < num_domains_8; i++)
+		{
+			EXPECT_GT(sequential_traces[i].size(), 1000u);
+			ASSERT_EQ(sequential_traces[i].size(),
+					traces_8[i].size());
+			for (unsigned j = 0; j < traces_8[i].size(); j++)
+				ASSERT_EQ(sequential_traces[i][j],
+						traces_8[i][j]);
+		}
+
+		// Compare statistics
+		EXPECT_EQ(sequential_report, parallel_report);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+
+//
+// Test 9
+//
+
+// Event of the second partition
+Event *remote_event_9;
+
+// Number of times the event of the second partition ran, and cycle of the
+// last time
+int remote_count_9;
+long long remote_cycle_9;
+
+// Schedule an event of the second partition for the current cycle
+void testHandler_9(Event *event, Frame *frame)
+{
+	Engine::getInstance()->Call(remote_event_9);
+}
+
+// Event of the second partition
+void testHandlerRemote_9(Event *event, Frame *frame)
+{
+	remote_count_9++;
+	remote_cycle_9 = Engine::getInstance()->getCycle();
+}
+
+// Tests that the parallel engine stops with an error when an event schedules
+// an event of another partition for the current cycle, and runs the event in
+// the same cycle when both frequency domains are coupled
+TEST(TestEngine, test_parallel_engine_lookahead)
+{
+	// Cleanup pointers to singleton instances
+	Cleanup();
+	Engine::setNumThreads(2);
+	remote_count_9 = 0;
+	remote_cycle_9 = 0;
+
+	// Set up esim engine
+	Engine *engine = Engine::getInstance();
+	FrequencyDomain *domain_0 = engine->RegisterFrequencyDomain(
+			"domain 0", 1000);
+	FrequencyDomain *domain_1 = engine->RegisterFrequencyDomain(
+			"domain 1", 1000);
+	Event *event = engine->RegisterEvent("event", testHandler_9,
+			domain_0);
+	remote_event_9 = engine->RegisterEvent("remote event",
+			testHandlerRemote_9, domain_1);
+	EXPECT_EQ(2, engine->getNumPartitions());
+
+	// The handler violates the lookahead of the parallel engine in
+	// cycle 2
+	std::string message;
+	try
+	{
+		engine->Call(event, nullptr, nullptr, 1);
+		engine->ProcessEvents();
+		engine->ProcessEvents();
+	}
+	catch (Error &e)
+	{
+		message = e.getMessage();
+	}
+	EXPECT_NE(std::string::npos, message.find("Event 'domain 1/remote "
+			"event' scheduled for the current cycle by event "
+			"'domain 0/event'"));
+	EXPECT_EQ(0, remote_count_9);
+
+	// Same simulation with both domains in the same partition
+	Cleanup();
+	try
+	{
+		engine = Engine::getInstance();
+		domain_0 = engine->RegisterFrequencyDomain("domain 0", 1000);
+		domain_1 = engine->RegisterFrequencyDomain("domain 1", 1000);
+		event = engine->RegisterEvent("event", testHandler_9,
+				domain_0);
+		remote_event_9 = engine->RegisterEvent("remote event",
+				testHandlerRemote_9, domain_1);
+		engine->CoupleFrequencyDomains(domain_0, domain_1);
+		EXPECT_EQ(1, engine->getNumPartitions());
+		engine->Call(event, nullptr, nullptr, 1);
+		engine->ProcessEvents();
+		engine->ProcessEvents();
+		EXPECT_EQ(1, remote_count_9);
+		EXPECT_EQ(2, remote_cycle_9);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+
+	// Restore sequential engine
+	Cleanup();
+	Engine::setNumThreads(1);
 }
 
 
 
+//
+// Test 10
+//
+
+// Tests that the profiler counts invocations and scheduling distances of each
+// event type, and the occupancy of the event heap
+TEST(TestEngine, test_profile)
+{
+	try
+	{
+		// Cleanup pointers to singleton instances
+		Cleanup();
+		Engine::setProfile(true);
+
+		// Set up esim engine
+		Engine *engine = Engine::getInstance();
+		FrequencyDomain *domain = engine->RegisterFrequencyDomain(
+				"frequency domain", 1000);
+		Event *event = engine->RegisterEvent("event", testHandler_6,
+				domain);
+
+		// Schedule events 0, 1, 5, and 5 cycles ahead
+		engine->Call(event);
+		engine->Call(event, nullptr, nullptr, 1);
+		engine->Call(event, nullptr, nullptr, 5);
+		engine->Call(event, nullptr, nullptr, 5);
+		for (int i = 0; i < 10; i++)
+			engine->ProcessEvents();
 
+		// Check counters
+		EXPECT_EQ(4, event->getNumInvocations());
+		EXPECT_EQ(4, event->getNumSchedules());
+		const std::vector<long long> &histogram =
+				event->getDistanceHistogram();
+		ASSERT_EQ(4u, histogram.size());
+		EXPECT_EQ(1, histogram[0]);
+		EXPECT_EQ(1, histogram[1]);
+		EXPECT_EQ(0, histogram[2]);
+		EXPECT_EQ(2, histogram[3]);
+
+		// Check report
+		std::ostringstream profile;
+		engine->DumpProfile(profile);
+		EXPECT_NE(std::string::npos, profile.str().find(
+				"[ Event frequency domain/event ]\n"
+				"Invocations = 4\n"));
+		EXPECT_NE(std::string::npos, profile.str().find(
+				"Distance[4-7] = 2\n"));
+		EXPECT_NE(std::string::npos, profile.str().find(
+				"Occupancy[2-3] = 2\n"));
+
+		// Restore default
+		Cleanup();
+		Engine::setProfile(false);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
 
+}
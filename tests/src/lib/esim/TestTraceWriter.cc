@@ -0,0 +1,200 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
+
+#include <lib/cpp/Error.h>
+#include <lib/cpp/String.h>
+#include <lib/esim/TraceWriter.h>
+
+
+namespace esim
+{
+
+// Create a temporary file and return its path
+static std::string CreateTemporaryFile()
+{
+	char path[] = "/tmp/m2s.XXXXXX";
+	int fd = mkstemp(path);
+	EXPECT_NE(-1, fd);
+	close(fd);
+	return path;
+}
+
+
+// Tests that a binary trace is converted back into exactly the same text,
+// including lines that do not follow the usual format of a trace line
+TEST(TestTraceWriter, test_round_trip)
+{
+	try
+	{
+		// Messages, and the cycle before each of them (0 for none)
+		const std::pair<long long, std::string> messages[] =
+		{
+			{ 0, "x86.init version=\"1.671\" num_cores=1\n" },
+			{ 1, "x86.new_inst id=0 core=0 stg=\"fe\"\n" },
+			{ 1, "x86.inst id=0 asm=\"mov eax, ebx\" "
+					"addr=0x8048000\n" },
+			{ 2, "mem.access name=\"A-1\" state=\"l1:S\" x=-12 "
+					"y=007 z=-0 w=- v= =5\n" },
+			{ 2, "two  spaces\n" },
+			{ 2, " leading space\n\ntrailing space \n" },
+			{ 5, "line 1\nline 2\n" },
+			{ 5, "x=123456789012345678901234567890\n" },
+			{ 1000000000000ll, "no newline" }
+		};
+
+		// Write trace
+		std::string path = CreateTemporaryFile();
+		std::ostringstream expected;
+		{
+			BinaryTraceWriter writer(path);
+			long long last_cycle = 0;
+			for (auto &message : messages)
+			{
+				if (message.first > last_cycle)
+				{
+					writer.WriteCycle(message.first);
+					expected << "c clk=" << message.first
+							<< '\n';
+					last_cycle = message.first;
+				}
+				writer.Write(message.second);
+				expected << message.second;
+			}
+		}
+
+		// Convert it
+		EXPECT_TRUE(BinaryTraceReader::isBinaryTrace(path));
+		std::ostringstream text;
+		BinaryTraceReader reader(path);
+		reader.Convert(text);
+		EXPECT_EQ(expected.str(), text.str());
+		remove(path.c_str());
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+// Tests that lines written with typed values are converted into the same
+// text that the formatted messages produce
+TEST(TestTraceWriter, test_typed_lines)
+{
+	try
+	{
+		// Write trace
+		std::string path = CreateTemporaryFile();
+		std::ostringstream expected;
+		{
+			BinaryTraceWriter writer(path);
+			for (int i = 0; i < 1000; i++)
+			{
+				writer.WriteCycle(i + 1);
+				writer.BeginLine("mem.new_access");
+				writer.AddName("name", "A-", i);
+				writer.AddQuoted("type", "load", 4, "");
+				writer.AddQuoted("state", "mod-l1-0", 8,
+						":load");
+				writer.AddHex("addr", -i);
+				writer.EndLine();
+				writer.BeginLine("x86.inst");
+				writer.AddNumber("id", 1000000000000ll * i);
+				writer.AddNumber("core", -i);
+				writer.AddQuoted("asm", "mov eax, ebx", 12,
+						"");
+				writer.EndLine();
+				writer.Write("x86.end_inst\n");
+				writer.BeginLine("x86.end_inst");
+				writer.EndLine();
+				expected << "c clk=" << i + 1 << '\n'
+						<< misc::fmt("mem.new_access "
+						"name=\"A-%d\" type=\"load\" "
+						"state=\"mod-l1-0:load\" "
+						"addr=0x%x\n", i, -i)
+						<< misc::fmt("x86.inst "
+						"id=%lld core=%d "
+						"asm=\"mov eax, ebx\"\n",
+						1000000000000ll * i, -i)
+						<< "x86.end_inst\n"
+						<< "x86.end_inst\n";
+			}
+		}
+
+		// Convert it
+		std::ostringstream text;
+		BinaryTraceReader reader(path);
+		reader.Convert(text);
+		EXPECT_EQ(expected.str(), text.str());
+		remove(path.c_str());
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+// Tests a trace larger than the ring buffer between the simulation and the
+// compressor thread
+TEST(TestTraceWriter, test_large_trace)
+{
+	try
+	{
+		// Write trace
+		std::string path = CreateTemporaryFile();
+		std::ostringstream expected;
+		{
+			BinaryTraceWriter writer(path);
+			for (int i = 0; i < 500000; i++)
+			{
+				writer.WriteCycle(i + 1);
+				std::string message = misc::fmt("x86.inst "
+						"id=%d core=%d name=\"%08x\"\n",
+						i, i % 4, i * 2654435761u);
+				writer.Write(message);
+				expected << "c clk=" << i + 1 << '\n' <<
+						message;
+			}
+		}
+
+		// Convert it
+		std::ostringstream text;
+		BinaryTraceReader reader(path);
+		reader.Convert(text);
+		EXPECT_TRUE(expected.str() == text.str());
+		remove(path.c_str());
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+}
+
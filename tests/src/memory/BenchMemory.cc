@@ -0,0 +1,136 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Microbenchmark measuring the cost of guest memory accesses. Each access
+// pattern touches 64 pages, either consecutive ones, which stay cached in
+// the software TLB of the memory object, or pages 1MB apart, which conflict
+// in the TLB and force every access through the page table. The cost of
+// mapping, finding free space in, and cloning a large heap is measured too.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <lib/cpp/Timer.h>
+#include <memory/Memory.h>
+
+
+namespace
+{
+
+// Number of pages touched by each access pattern
+const unsigned NumPages = 64;
+
+// Number of accesses per pattern
+const unsigned NumAccesses = 20000000;
+
+// Run the access pattern and print the average cost of an access
+void Run(const char *name, unsigned stride, mem::Memory::AccessType access)
+{
+	// Map pages
+	mem::Memory memory;
+	unsigned base = 0x10000000;
+	for (unsigned i = 0; i < NumPages; i++)
+		memory.Map(base + i * stride, mem::Memory::PageSize,
+				mem::Memory::AccessRead |
+				mem::Memory::AccessWrite);
+
+	// Write pages once, so that they have data
+	unsigned value = 0;
+	for (unsigned i = 0; i < NumPages; i++)
+		memory.Write(base + i * stride, 4, (char *) &value);
+
+	// Access pages
+	misc::Timer timer("bench");
+	timer.Start();
+	unsigned sum = 0;
+	for (unsigned i = 0; i < NumAccesses; i++)
+	{
+		unsigned page = i % NumPages;
+		unsigned offset = (i * 4) & (mem::Memory::PageSize - 4);
+		memory.Access(base + page * stride + offset, 4,
+				(char *) &value, access);
+		sum += value;
+	}
+	timer.Stop();
+
+	// Report
+	printf("%-16s %8.2f ns/access  (checksum %x)\n", name,
+			timer.getValue() * 1000.0 / NumAccesses, sum);
+}
+
+
+// Map and touch a large heap, find free space after it, and clone it,
+// printing the cost per page of each operation
+void RunHeap(unsigned size)
+{
+	unsigned num_pages = size / mem::Memory::PageSize;
+	unsigned base = 0x10000000;
+	mem::Memory memory;
+	misc::Timer timer("bench");
+
+	// Map
+	timer.Start();
+	memory.Map(base, size, mem::Memory::AccessRead |
+			mem::Memory::AccessWrite);
+	for (unsigned i = 0; i < num_pages; i++)
+		memory.Zero(base + i * mem::Memory::PageSize, 1);
+	timer.Stop();
+	printf("%-16s %8.2f ns/page\n", "heap-map",
+			timer.getValue() * 1000.0 / num_pages);
+
+	// Find free space
+	timer.Reset();
+	timer.Start();
+	unsigned address = memory.MapSpace(base, size);
+	timer.Stop();
+	printf("%-16s %8.2f ns/page  (found 0x%x)\n", "heap-mapspace",
+			timer.getValue() * 1000.0 / num_pages, address);
+
+	// Clone
+	timer.Reset();
+	timer.Start();
+	mem::Memory clone;
+	clone.Clone(memory);
+	timer.Stop();
+	printf("%-16s %8.2f ns/page\n", "heap-clone",
+			timer.getValue() * 1000.0 / num_pages);
+}
+
+}  // namespace
+
+
+int main()
+{
+	try
+	{
+		Run("read-hit", mem::Memory::PageSize,
+				mem::Memory::AccessRead);
+		Run("read-conflict", 1 << 20, mem::Memory::AccessRead);
+		Run("write-hit", mem::Memory::PageSize,
+				mem::Memory::AccessWrite);
+		Run("write-conflict", 1 << 20, mem::Memory::AccessWrite);
+		RunHeap(1u << 30);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		return 1;
+	}
+	return 0;
+}
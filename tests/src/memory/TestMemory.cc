@@ -0,0 +1,500 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2014  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+#include <lib/cpp/Checkpoint.h>
+#include <lib/cpp/Error.h>
+#include <memory/Manager.h>
+#include <memory/Memory.h>
+#include <memory/PageArena.h>
+
+
+namespace mem
+{
+
+// Create a temporary file and return its path
+static std::string CreateTemporaryFile()
+{
+	char path[] = "/tmp/m2s.XXXXXX";
+	int fd = mkstemp(path);
+	EXPECT_NE(-1, fd);
+	close(fd);
+	return path;
+}
+
+
+// Tests that a memory image and the chunks of a memory manager are restored
+// exactly from a checkpoint
+TEST(TestMemory, test_checkpoint)
+{
+	std::string path = CreateTemporaryFile();
+	try
+	{
+		// Memory with a page with data, a page with zeros, and a page
+		// without data
+		Memory memory;
+		memory.Map(0x10000, 3 * Memory::PageSize,
+				Memory::AccessRead | Memory::AccessWrite);
+		memory.WriteString(0x10ffe, "checkpoint");
+		memory.Zero(0x12000, 16);
+		memory.setHeapBreak(0x20000);
+
+		// Manager with allocated and free chunks
+		Memory managed_memory;
+		managed_memory.setSafe(false);
+		Manager manager(&managed_memory);
+		unsigned first = manager.Allocate(100);
+		unsigned second = manager.Allocate(3 * Memory::PageSize);
+		manager.Allocate(200);
+		manager.Free(first);
+
+		// Save checkpoint
+		{
+			misc::CheckpointWriter writer(path);
+			memory.SaveCheckpoint(writer);
+			manager.SaveCheckpoint(writer);
+		}
+
+		// Load checkpoint into objects with different content
+		Memory restored_memory;
+		restored_memory.Map(0x40000, Memory::PageSize,
+				Memory::AccessRead);
+		Manager restored_manager(&managed_memory);
+		restored_manager.Allocate(1000);
+		{
+			misc::CheckpointReader reader(path);
+			restored_memory.LoadCheckpoint(reader);
+			restored_manager.LoadCheckpoint(reader);
+		}
+
+		// Check memory
+		EXPECT_EQ(nullptr, restored_memory.getPage(0x40000));
+		EXPECT_EQ(0x20000u, restored_memory.getHeapBreak());
+		EXPECT_EQ("checkpoint", restored_memory.ReadString(0x10ffe));
+		for (unsigned address = 0x10000; address < 0x13000;
+				address += Memory::PageSize)
+		{
+			Memory::Page *page = memory.getPage(address);
+			Memory::Page *restored_page =
+					restored_memory.getPage(address);
+			ASSERT_NE(nullptr, restored_page);
+			EXPECT_EQ(page->getPerm(), restored_page->getPerm());
+		}
+		EXPECT_EQ(nullptr, restored_memory.getPage(0x12000)->getData());
+
+		// Check manager
+		EXPECT_EQ(manager.getAllocatedSize(),
+				restored_manager.getAllocatedSize());
+		EXPECT_EQ(manager.getOccupiedSize(),
+				restored_manager.getOccupiedSize());
+		EXPECT_FALSE(restored_manager.isValidAddress(first));
+		EXPECT_TRUE(restored_manager.isValidAddress(second));
+		restored_manager.Free(second);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+	remove(path.c_str());
+}
+
+
+// Tests that sections are checked when a checkpoint is read
+TEST(TestMemory, test_checkpoint_corrupt)
+{
+	std::string path = CreateTemporaryFile();
+
+	// A file that is not a checkpoint
+	EXPECT_THROW(misc::CheckpointReader reader(path), misc::Error);
+
+	// A checkpoint with a different section
+	{
+		misc::CheckpointWriter writer(path);
+		writer.WriteSection("Other");
+	}
+	Memory memory;
+	misc::CheckpointReader reader(path);
+	EXPECT_THROW(memory.LoadCheckpoint(reader), misc::Error);
+	remove(path.c_str());
+}
+
+
+// Tests that changes to watched code pages increment the code version
+TEST(TestMemory, test_watch_code)
+{
+	Memory memory;
+	memory.Map(0x10000, 2 * Memory::PageSize,
+			Memory::AccessRead | Memory::AccessWrite |
+			Memory::AccessExec);
+
+	// Pages not allocated cannot be watched
+	EXPECT_FALSE(memory.WatchCode(0x20000, 4));
+
+	// Writes to pages not watched are ignored
+	EXPECT_TRUE(memory.WatchCode(0x11000, 4));
+	long long version = memory.getCodeVersion();
+	memory.WriteString(0x10100, "data");
+	EXPECT_EQ(version, memory.getCodeVersion());
+
+	// A write to a watched page increments the version once, and stops
+	// watching the page
+	memory.WriteString(0x11000, "code");
+	EXPECT_EQ(version + 1, memory.getCodeVersion());
+	memory.WriteString(0x11004, "code");
+	EXPECT_EQ(version + 1, memory.getCodeVersion());
+
+	// Permission changes and unmapping increment the version
+	EXPECT_TRUE(memory.WatchCode(0x10000, 1));
+	memory.Protect(0x10000, Memory::PageSize, Memory::AccessRead);
+	EXPECT_EQ(version + 2, memory.getCodeVersion());
+	EXPECT_TRUE(memory.WatchCode(0x11000, 1));
+	memory.Unmap(0x11000, Memory::PageSize);
+	EXPECT_EQ(version + 3, memory.getCodeVersion());
+}
+
+
+// Tests that accesses to pages cached in the software TLB still observe
+// permission changes and unmapping
+TEST(TestMemory, test_tlb)
+{
+	Memory memory;
+	memory.Map(0x10000, Memory::PageSize,
+			Memory::AccessRead | Memory::AccessWrite);
+
+	// Cache the page for reads and writes
+	unsigned value = 0x1234;
+	memory.Write(0x10010, 4, (char *) &value);
+	memory.Write(0x10010, 4, (char *) &value);
+	value = 0;
+	memory.Read(0x10010, 4, (char *) &value);
+	EXPECT_EQ(0x1234u, value);
+
+	// A page conflicting in the TLB does not corrupt the cached one
+	memory.Map(0x10010000, Memory::PageSize,
+			Memory::AccessRead | Memory::AccessWrite);
+	value = 0x5678;
+	memory.Write(0x10010010, 4, (char *) &value);
+	memory.Read(0x10010, 4, (char *) &value);
+	EXPECT_EQ(0x1234u, value);
+
+	// Writes are denied after the page becomes read-only
+	memory.Protect(0x10000, Memory::PageSize, Memory::AccessRead);
+	EXPECT_THROW(memory.Write(0x10010, 4, (char *) &value), Memory::Error);
+	memory.Read(0x10010, 4, (char *) &value);
+	EXPECT_EQ(0x1234u, value);
+
+	// Accesses fail after the page is unmapped
+	memory.Unmap(0x10000, Memory::PageSize);
+	EXPECT_THROW(memory.Read(0x10010, 4, (char *) &value), Memory::Error);
+	EXPECT_EQ(nullptr, memory.getBuffer(0x10010, 4, Memory::AccessRead));
+
+	// Accesses fail after the memory is cleared
+	memory.Clear();
+	EXPECT_THROW(memory.Read(0x10010010, 4, (char *) &value),
+			Memory::Error);
+}
+
+
+// Tests page lookups across directories of the page table
+TEST(TestMemory, test_page_table)
+{
+	Memory memory;
+	unsigned perm = Memory::AccessRead | Memory::AccessWrite;
+
+	// Next page skips empty directories, and is null after the last
+	// page
+	memory.Map(0x10000, Memory::PageSize, perm);
+	memory.Map(0x80000000, Memory::PageSize, perm);
+	memory.Map(0xffffe000, Memory::PageSize, perm);
+	EXPECT_EQ(0x10000u, memory.getNextPage(0)->getTag());
+	EXPECT_EQ(0x80000000u, memory.getNextPage(0x10000)->getTag());
+	EXPECT_EQ(0xffffe000u, memory.getNextPage(0x80000000)->getTag());
+	EXPECT_EQ(nullptr, memory.getNextPage(0xffffe000));
+
+	// Unmapped pages are not found, and their data is reused zeroed
+	memory.WriteString(0x80000000, "data");
+	memory.Unmap(0x80000000, Memory::PageSize);
+	EXPECT_EQ(nullptr, memory.getPage(0x80000000));
+	EXPECT_EQ(0xffffe000u, memory.getNextPage(0x10000)->getTag());
+	memory.Map(0x80000000, Memory::PageSize, perm);
+	memory.Zero(0x80000010, 1);
+	EXPECT_EQ("", memory.ReadString(0x80000000));
+
+	// Free space is found across large regions, skipping the mapped
+	// pages
+	unsigned size = 0x10000000;
+	EXPECT_EQ(0x80001000u, memory.MapSpace(0x7ffff000, size));
+	EXPECT_EQ(0x80000000u - size, memory.MapSpaceDown(0x7ffff000, size));
+	EXPECT_EQ(0x11000u, memory.MapSpace(0x10000, Memory::PageSize));
+	EXPECT_EQ(0xefffe000u, memory.MapSpaceDown(0xffffe000, size));
+	EXPECT_EQ((unsigned) -1, memory.MapSpace(0xf0000000, size));
+
+	// Clear releases all pages
+	memory.Clear();
+	EXPECT_EQ(nullptr, memory.getNextPage(0));
+}
+
+
+// Tests that cloned memories share page data until either one writes it
+TEST(TestMemory, test_clone_copy_on_write)
+{
+	Memory memory;
+	memory.Map(0x10000, 3 * Memory::PageSize,
+			Memory::AccessRead | Memory::AccessWrite);
+	memory.WriteString(0x10000, "parent");
+	memory.WriteString(0x11000, "shared");
+
+	// Cache the first page for writes in the TLB of the parent
+	memory.WriteString(0x10000, "parent");
+
+	// Pages with data are shared, the page without data is not
+	long long num_shared_pages = Memory::getNumSharedPages();
+	long long num_copied_pages = Memory::getNumCopiedPages();
+	Memory clone;
+	clone.Clone(memory);
+	EXPECT_EQ(num_shared_pages + 2, Memory::getNumSharedPages());
+	EXPECT_EQ(memory.getPage(0x11000)->getData(),
+			clone.getPage(0x11000)->getData());
+	EXPECT_EQ(nullptr, clone.getPage(0x12000)->getData());
+
+	// A write by the parent through its TLB copies the page
+	memory.WriteString(0x10000, "modified");
+	EXPECT_EQ("modified", memory.ReadString(0x10000));
+	EXPECT_EQ("parent", clone.ReadString(0x10000));
+	EXPECT_EQ(num_copied_pages + 1, Memory::getNumCopiedPages());
+
+	// The clone is the only owner of its page now, so it writes it in
+	// place
+	char *data = clone.getPage(0x10000)->getData();
+	clone.WriteString(0x10000, "child");
+	EXPECT_EQ(data, clone.getPage(0x10000)->getData());
+	EXPECT_EQ(num_copied_pages + 1, Memory::getNumCopiedPages());
+
+	// Writes through a buffer copy the page too
+	char *buffer = clone.getBuffer(0x11000, 6, Memory::AccessWrite);
+	memcpy(buffer, "CHILD", 6);
+	EXPECT_EQ("shared", memory.ReadString(0x11000));
+	EXPECT_EQ("CHILD", clone.ReadString(0x11000));
+	EXPECT_EQ(num_copied_pages + 2, Memory::getNumCopiedPages());
+
+	// Permissions are checked before copying
+	clone.Protect(0x10000, Memory::PageSize, Memory::AccessRead);
+	EXPECT_THROW(clone.WriteString(0x10000, "x"), Memory::Error);
+	EXPECT_EQ(num_copied_pages + 2, Memory::getNumCopiedPages());
+}
+
+
+// Tests that clones sharing page data can be written from several host
+// threads at the same time
+TEST(TestMemory, test_clone_concurrent)
+{
+	const unsigned num_pages = 64;
+	Memory memory;
+	memory.Map(0x10000, num_pages * Memory::PageSize,
+			Memory::AccessRead | Memory::AccessWrite);
+	for (unsigned i = 0; i < num_pages; i++)
+		memory.Write(0x10000 + i * Memory::PageSize, 4, (char *) &i);
+
+	// Each thread writes all pages of its own clone
+	Memory clones[4];
+	for (Memory &clone : clones)
+		clone.Clone(memory);
+	PageArena::setConcurrent(true);
+	std::thread threads[4];
+	for (unsigned t = 0; t < 4; t++)
+		threads[t] = std::thread([&clones, t]()
+		{
+			for (unsigned i = 0; i < num_pages; i++)
+			{
+				unsigned value = t * 1000 + i;
+				clones[t].Write(0x10000 + i * Memory::PageSize,
+						4, (char *) &value);
+			}
+		});
+	for (std::thread &thread : threads)
+		thread.join();
+	PageArena::setConcurrent(false);
+
+	// Every memory keeps its own values
+	for (unsigned i = 0; i < num_pages; i++)
+	{
+		unsigned address = 0x10000 + i * Memory::PageSize;
+		unsigned value;
+		memory.Read(address, 4, (char *) &value);
+		EXPECT_EQ(i, value);
+		for (unsigned t = 0; t < 4; t++)
+		{
+			clones[t].Read(address, 4, (char *) &value);
+			EXPECT_EQ(t * 1000 + i, value);
+		}
+	}
+}
+
+
+
+// Concatenate the content of host buffers
+static std::string ReadIovecs(const std::vector<struct iovec> &iovecs)
+{
+	std::string content;
+	for (const struct iovec &iovec : iovecs)
+		content.append((char *) iovec.iov_base, iovec.iov_len);
+	return content;
+}
+
+
+// Tests host buffers obtained for memory regions spanning several pages
+TEST(TestMemory, test_iovecs)
+{
+	Memory memory;
+	memory.Map(0x10000, 3 * Memory::PageSize,
+			Memory::AccessRead | Memory::AccessWrite);
+	memory.WriteString(0x10ffc, "abcdefgh");
+
+	// Reads over pages without data see zeros
+	std::vector<struct iovec> iovecs;
+	ASSERT_TRUE(memory.getIovecs(0x10ffc, 0x1008, Memory::AccessRead,
+			iovecs));
+	std::string content = ReadIovecs(iovecs);
+	ASSERT_EQ(0x1008u, content.size());
+	EXPECT_EQ(0, memcmp(content.data(), "abcdefgh", 9));
+	EXPECT_EQ(std::string::npos, content.find_first_not_of('\0', 8));
+	EXPECT_EQ(nullptr, memory.getPage(0x12000)->getData());
+
+	// Writes through the buffers of a clone copy the shared pages
+	Memory clone;
+	clone.Clone(memory);
+	iovecs.clear();
+	ASSERT_TRUE(clone.getIovecs(0x10ffe, 4, Memory::AccessWrite, iovecs));
+	const char *data = "XYZW";
+	for (const struct iovec &iovec : iovecs)
+	{
+		memcpy(iovec.iov_base, data, iovec.iov_len);
+		data += iovec.iov_len;
+	}
+	EXPECT_EQ("abcdefgh", memory.ReadString(0x10ffc));
+	EXPECT_EQ("abXYZWgh", clone.ReadString(0x10ffc));
+
+	// Regions with unmapped pages or denied permissions fail without
+	// adding buffers
+	iovecs.clear();
+	EXPECT_FALSE(memory.getIovecs(0x12ff0, 0x20, Memory::AccessRead,
+			iovecs));
+	memory.setSafe(true);
+	memory.Protect(0x11000, Memory::PageSize, Memory::AccessRead);
+	EXPECT_FALSE(memory.getIovecs(0x10ff0, 0x20, Memory::AccessWrite,
+			iovecs));
+	EXPECT_TRUE(iovecs.empty());
+}
+
+
+// Tests pages using a host file as their content
+TEST(TestMemory, test_map_file)
+{
+	// Create a file of one page and a half
+	char path[] = "/tmp/m2s-test-map-file-XXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_NE(-1, fd);
+	unlink(path);
+	std::string content(Memory::PageSize + Memory::PageSize / 2, 'a');
+	content[Memory::PageSize] = 'b';
+	ASSERT_EQ((ssize_t) content.size(),
+			write(fd, content.data(), content.size()));
+
+	// Map the file
+	long long num_in_use = PageArena::getInstance(Memory::PageSize)
+			->getNumInUse();
+	{
+		Memory memory;
+		memory.Map(0x10000, 2 * Memory::PageSize,
+				Memory::AccessRead | Memory::AccessWrite);
+		ASSERT_TRUE(memory.MapFile(0x10000, 2 * Memory::PageSize, fd, 0));
+		EXPECT_FALSE(memory.MapFile(0x10000, Memory::PageSize, fd, 0));
+		char data[4];
+		memory.Read(0x10ffe, 4, data);
+		EXPECT_EQ(0, memcmp(data, "aaba", 4));
+		EXPECT_EQ("", memory.ReadString(0x11ffe));
+
+		// Writes are private to the memory and its clones
+		Memory clone;
+		clone.Clone(memory);
+		clone.Write(0x11000, 1, "c");
+		memory.Write(0x10000, 1, "d");
+		memory.Read(0x11000, 1, data);
+		clone.Read(0x11000, 1, data + 1);
+		clone.Read(0x10000, 1, data + 2);
+		ASSERT_EQ(1, pread(fd, data + 3, 1, 0));
+		EXPECT_EQ(0, memcmp(data, "bcaa", 4));
+	}
+
+	// Frames mapped from the file are not taken from the arena
+	EXPECT_EQ(num_in_use, PageArena::getInstance(Memory::PageSize)
+			->getNumInUse());
+	close(fd);
+}
+
+
+// Tests that pages mapped from a host file keep their content after the file
+// is truncated, once they are detached from it
+TEST(TestMemory, test_map_file_truncate)
+{
+	// Create a file of two pages
+	char path[] = "/tmp/m2s-test-map-file-XXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_NE(-1, fd);
+	unlink(path);
+	std::string content(2 * Memory::PageSize, 'a');
+	content[Memory::PageSize] = 'b';
+	ASSERT_EQ((ssize_t) content.size(),
+			write(fd, content.data(), content.size()));
+
+	// Map the file, and write one page
+	Memory memory;
+	memory.Map(0x10000, 2 * Memory::PageSize,
+			Memory::AccessRead | Memory::AccessWrite);
+	ASSERT_TRUE(memory.MapFile(0x10000, 2 * Memory::PageSize, fd, 0));
+	memory.Write(0x10001, 1, "c");
+
+	// Truncate the file. Reading the second page would raise SIGBUS
+	// without detaching it first.
+	Memory::DetachFile(fd);
+	ASSERT_EQ(0, ftruncate(fd, 0));
+	char data[4];
+	memory.Read(0x10000, 2, data);
+	memory.Read(0x10fff, 2, data + 2);
+	EXPECT_EQ(0, memcmp(data, "acab", 4));
+
+	// Detached pages are still private
+	memory.Write(0x11000, 1, "d");
+	memory.Read(0x11000, 1, data);
+	EXPECT_EQ('d', data[0]);
+	EXPECT_EQ(0, lseek(fd, 0, SEEK_END));
+	close(fd);
+}
+
+
+} // namespace mem
+
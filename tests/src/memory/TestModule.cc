@@ -85,11 +85,85 @@ const std::string mem_config_1 =
                 "DefaultBandwidth = 256"; 
 
 
+const std::string mem_config_2 =
+		"; 2 l1, 1 l2, 1 mm\n"
+		"\n"
+		"[CacheGeometry geo-l1]\n"
+		"Sets = 16\n"
+		"Assoc = 2\n"
+		"BlockSize = 64\n"
+		"Latency = 2\n"
+		"Policy = LRU\n"
+		"Ports = 2\n"
+		"\n"
+		"[CacheGeometry geo-l2]\n"
+		"Sets = 16\n"
+		"Assoc = 2\n"
+		"BlockSize = 128\n"
+		"Latency = 20\n"
+		"Policy = LRU\n"
+		"Ports = 4\n"
+		"\n"
+		"[Module mod-l1-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = l1-l2\n"
+		"LowModules = mod-l2\n"
+		"\n"
+		"[Module mod-l1-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = l1-l2\n"
+		"LowModules = mod-l2\n"
+		"\n"
+		"[Module mod-l2]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l2\n"
+		"HighNetwork = l1-l2\n"
+		"LowNetwork = l2-mm\n"
+		"LowModules = mod-mm\n"
+		"\n"
+		"[Module mod-mm]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 128\n"
+		"Latency = 200\n"
+		"HighNetwork = l2-mm\n"
+		"\n"
+		"[Entry core-0]\n"
+		"Arch = x86\n"
+		"Core = 0\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-0\n"
+		"InstModule = mod-l1-0\n"
+		"\n"
+		"[Entry core-1]\n"
+		"Arch = x86\n"
+		"Core = 1\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-1\n"
+		"InstModule = mod-l1-1\n"
+		"\n"
+		"[Network l1-l2]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"[Network l2-mm]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256";
+
+
 const std::string x86_config_0 =
 		"[ General ]\n"
 		"Cores = 1\n"
 		"Threads = 1\n";
 
+const std::string x86_config_1 =
+		"[ General ]\n"
+		"Cores = 2\n"
+		"Threads = 1\n";
+
 static void Cleanup()
 {
 	esim::Engine::Destroy();
@@ -103,6 +177,17 @@ static void Cleanup()
 	comm::ArchPool::Destroy();
 }
 
+// Return the state of the block containing the given address in a module,
+// and its set and way if present.
+static Cache::BlockState getBlockState(Module *module, unsigned address,
+		unsigned &set_id, unsigned &way_id)
+{
+	Cache::BlockState state;
+	if (!module->getCache()->FindBlock(address, set_id, way_id, state))
+		return Cache::BlockInvalid;
+	return state;
+}
+
 // This test checks the isInFlightAddress() function.
 // The test schedules an access and then checks that the function
 // returns true until the access has completed
@@ -419,5 +504,202 @@ TEST(TestModule, can_access_2)
 }
 
 
-} // Namespace mem
+// This test checks the states, sharers, and owners left by functional
+// warm-up loads and stores from two L1 caches sharing an L2 cache. Blocks
+// are always brought with exclusive permissions, so each access invalidates
+// the copy in the other L1 cache, and the data of a dirty copy is written
+// back into the L2 cache.
+TEST(TestModule, warm_up_load_store)
+{
+	try
+	{
+		// Cleanup singleton instances
+		Cleanup();
+
+		// Load configuration file
+		misc::IniFile ini_file_mem;
+		misc::IniFile ini_file_x86;
+		ini_file_mem.LoadFromString(mem_config_2);
+		ini_file_x86.LoadFromString(x86_config_1);
+
+		// Set up x86 timing simulator
+		x86::Timing::ParseConfiguration(&ini_file_x86);
+		x86::Timing::getInstance();
+
+		// Set up memory system
+		System *memory_system = System::getInstance();
+		memory_system->ReadConfiguration(&ini_file_mem);
+
+		// Get modules
+		Module *module_l1_0 = memory_system->getModule("mod-l1-0");
+		Module *module_l1_1 = memory_system->getModule("mod-l1-1");
+		Module *module_l2 = memory_system->getModule("mod-l2");
+		Module *module_mm = memory_system->getModule("mod-mm");
+		ASSERT_NE(module_l1_0, nullptr);
+		ASSERT_NE(module_l1_1, nullptr);
+		ASSERT_NE(module_l2, nullptr);
+		ASSERT_NE(module_mm, nullptr);
+
+		// Address 0x40 is sub-block 1 of L2 block 0x0
+		unsigned set_id;
+		unsigned way_id;
+		unsigned l2_set_id;
+		unsigned l2_way_id;
+		unsigned mm_set_id;
+		unsigned mm_way_id;
+
+		// Load from L1-0
+		module_l1_0->WarmUp(Module::AccessLoad, 0x40);
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l1_0,
+				0x40, set_id, way_id));
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l2,
+				0x40, l2_set_id, l2_way_id));
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_mm,
+				0x40, mm_set_id, mm_way_id));
+		EXPECT_EQ(module_l1_0, module_l2->getOwner(l2_set_id,
+				l2_way_id, 1));
+		EXPECT_EQ(1, module_l2->getNumSharers(l2_set_id, l2_way_id, 1));
+		EXPECT_TRUE(module_l2->isSharer(l2_set_id, l2_way_id, 1,
+				module_l1_0));
+		EXPECT_EQ(0, module_l2->getNumSharers(l2_set_id, l2_way_id, 0));
+		EXPECT_EQ(module_l2, module_mm->getOwner(mm_set_id,
+				mm_way_id, 0));
+
+		// Store from L1-1 invalidates the copy in L1-0
+		module_l1_1->WarmUp(Module::AccessStore, 0x40);
+		EXPECT_EQ(Cache::BlockInvalid, getBlockState(module_l1_0,
+				0x40, set_id, way_id));
+		EXPECT_EQ(Cache::BlockModified, getBlockState(module_l1_1,
+				0x40, set_id, way_id));
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l2,
+				0x40, l2_set_id, l2_way_id));
+		EXPECT_EQ(module_l1_1, module_l2->getOwner(l2_set_id,
+				l2_way_id, 1));
+		EXPECT_EQ(1, module_l2->getNumSharers(l2_set_id, l2_way_id, 1));
+		EXPECT_TRUE(module_l2->isSharer(l2_set_id, l2_way_id, 1,
+				module_l1_1));
+
+		// Load from L1-0 invalidates the dirty copy in L1-1, whose data
+		// is written back into L2
+		module_l1_0->WarmUp(Module::AccessLoad, 0x40);
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l1_0,
+				0x40, set_id, way_id));
+		EXPECT_EQ(Cache::BlockInvalid, getBlockState(module_l1_1,
+				0x40, set_id, way_id));
+		EXPECT_EQ(Cache::BlockModified, getBlockState(module_l2,
+				0x40, l2_set_id, l2_way_id));
+		EXPECT_EQ(module_l1_0, module_l2->getOwner(l2_set_id,
+				l2_way_id, 1));
+		EXPECT_EQ(1, module_l2->getNumSharers(l2_set_id, l2_way_id, 1));
+
+		// Store from L1-0 hits with exclusive permissions
+		module_l1_0->WarmUp(Module::AccessStore, 0x40);
+		EXPECT_EQ(Cache::BlockModified, getBlockState(module_l1_0,
+				0x40, set_id, way_id));
+		EXPECT_EQ(module_l1_0, module_l2->getOwner(l2_set_id,
+				l2_way_id, 1));
+
+		// Two more blocks in the same L1-0 set, but in a different L2
+		// set. The dirty block 0x40 is evicted from L1-0, removing
+		// L1-0 from the L2 directory.
+		module_l1_0->WarmUp(Module::AccessLoad, 0x440);
+		module_l1_0->WarmUp(Module::AccessLoad, 0xc40);
+		EXPECT_EQ(Cache::BlockInvalid, getBlockState(module_l1_0,
+				0x40, set_id, way_id));
+		EXPECT_EQ(Cache::BlockModified, getBlockState(module_l2,
+				0x40, l2_set_id, l2_way_id));
+		EXPECT_EQ(nullptr, module_l2->getOwner(l2_set_id,
+				l2_way_id, 1));
+		EXPECT_EQ(0, module_l2->getNumSharers(l2_set_id, l2_way_id, 1));
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+// This test checks that evicting a block from the L2 cache during warm-up
+// invalidates the copies of the block in the L1 caches, as required for
+// inclusion, and removes the L2 cache from the directory of main memory.
+TEST(TestModule, warm_up_inclusion)
+{
+	try
+	{
+		// Cleanup singleton instances
+		Cleanup();
+
+		// Load configuration file
+		misc::IniFile ini_file_mem;
+		misc::IniFile ini_file_x86;
+		ini_file_mem.LoadFromString(mem_config_2);
+		ini_file_x86.LoadFromString(x86_config_1);
+
+		// Set up x86 timing simulator
+		x86::Timing::ParseConfiguration(&ini_file_x86);
+		x86::Timing::getInstance();
+
+		// Set up memory system
+		System *memory_system = System::getInstance();
+		memory_system->ReadConfiguration(&ini_file_mem);
+
+		// Get modules
+		Module *module_l1_0 = memory_system->getModule("mod-l1-0");
+		Module *module_l1_1 = memory_system->getModule("mod-l1-1");
+		Module *module_l2 = memory_system->getModule("mod-l2");
+		Module *module_mm = memory_system->getModule("mod-mm");
+		ASSERT_NE(module_l1_0, nullptr);
+		ASSERT_NE(module_l1_1, nullptr);
+		ASSERT_NE(module_l2, nullptr);
+		ASSERT_NE(module_mm, nullptr);
+
+		// Blocks 0x0, 0x800, and 0x1000 map to L2 set 0, and to
+		// different sets in the L1 caches.
+		unsigned set_id;
+		unsigned way_id;
+		module_l1_0->WarmUp(Module::AccessStore, 0x0);
+		module_l1_1->WarmUp(Module::AccessLoad, 0x840);
+		EXPECT_EQ(Cache::BlockModified, getBlockState(module_l1_0,
+				0x0, set_id, way_id));
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l1_1,
+				0x840, set_id, way_id));
+
+		// The third block evicts the least recently used block 0x0
+		// from L2, and its copy in L1-0
+		module_l1_1->WarmUp(Module::AccessLoad, 0x1000);
+		EXPECT_EQ(Cache::BlockInvalid, getBlockState(module_l2,
+				0x0, set_id, way_id));
+		EXPECT_EQ(Cache::BlockInvalid, getBlockState(module_l1_0,
+				0x0, set_id, way_id));
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l1_1,
+				0x840, set_id, way_id));
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l1_1,
+				0x1000, set_id, way_id));
+
+		// Main memory keeps the block, with no sharer or owner left
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_mm,
+				0x0, set_id, way_id));
+		EXPECT_EQ(0, module_mm->getNumSharers(set_id, way_id, 0));
+		EXPECT_EQ(nullptr, module_mm->getOwner(set_id, way_id, 0));
+
+		// The remaining blocks are still tracked by the directories
+		unsigned l2_set_id;
+		unsigned l2_way_id;
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_l2,
+				0x800, l2_set_id, l2_way_id));
+		EXPECT_EQ(module_l1_1, module_l2->getOwner(l2_set_id,
+				l2_way_id, 1));
+		EXPECT_EQ(Cache::BlockExclusive, getBlockState(module_mm,
+				0x800, set_id, way_id));
+		EXPECT_EQ(module_l2, module_mm->getOwner(set_id, way_id, 0));
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
 
+} // Namespace mem
@@ -0,0 +1,241 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <arch/x86/timing/Timing.h>
+#include <arch/common/Arch.h>
+#include <lib/cpp/IniFile.h>
+#include <lib/cpp/Error.h>
+#include <lib/esim/Engine.h>
+#include <memory/Module.h>
+#include <memory/Prefetcher.h>
+#include <memory/System.h>
+#include <network/System.h>
+
+namespace mem
+{
+
+const std::string mem_config_prefetch =
+		"[CacheGeometry geo-l1]\n"
+		"Sets = 16\n"
+		"Assoc = 2\n"
+		"BlockSize = 256\n"
+		"Latency = 2\n"
+		"MSHR = 4\n"
+		"Prefetcher = NextLine\n"
+		"PrefetchDegree = 1\n"
+		"\n"
+		"[Module mod-l1-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = l1-mm\n"
+		"LowModules = mod-mm\n"
+		"\n"
+		"[Module mod-mm]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 256\n"
+		"Latency = 100\n"
+		"HighNetwork = l1-mm\n"
+		"\n"
+		"[Entry core-0]\n"
+		"Arch = x86\n"
+		"Core = 0\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-0\n"
+		"InstModule = mod-l1-0\n"
+		"\n"
+		"[Network l1-mm]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256";
+
+const std::string x86_config_prefetch =
+		"[ General ]\n"
+		"Cores = 1\n"
+		"Threads = 1\n";
+
+static void Cleanup()
+{
+	esim::Engine::Destroy();
+
+	net::System::Destroy();
+
+	System::Destroy();
+
+	x86::Timing::Destroy();
+
+	comm::ArchPool::Destroy();
+}
+
+
+// Tests that the next-line prefetcher brings the blocks after a miss
+TEST(TestPrefetcher, next_line)
+{
+	auto prefetcher = Prefetcher::Create(Prefetcher::TypeNextLine, 64, 2);
+	std::vector<unsigned> addresses;
+
+	// Hits do not prefetch
+	prefetcher->Access(0x400, 0x1000, false, addresses);
+	EXPECT_TRUE(addresses.empty());
+
+	// Misses do
+	prefetcher->Access(0x400, 0x1010, true, addresses);
+	EXPECT_EQ(addresses, std::vector<unsigned>({ 0x1040, 0x1080 }));
+}
+
+
+// Tests that the IP-stride prefetcher follows the stride of an instruction
+// once it repeated, and ignores accesses of other instructions
+TEST(TestPrefetcher, ip_stride)
+{
+	auto prefetcher = Prefetcher::Create(Prefetcher::TypeIpStride, 64, 2);
+	std::vector<unsigned> addresses;
+
+	// Train stride
+	for (unsigned address = 0x1000; address < 0x1300; address += 0x100)
+	{
+		prefetcher->Access(0x400, address, true, addresses);
+		prefetcher->Access(0x500, 0x8000 - address, true, addresses);
+		EXPECT_TRUE(addresses.empty());
+	}
+
+	// Prefetch along the stride
+	prefetcher->Access(0x400, 0x1300, false, addresses);
+	EXPECT_EQ(addresses, std::vector<unsigned>({ 0x1400, 0x1500 }));
+
+	// Strides smaller than a block skip the block accessed
+	addresses.clear();
+	for (unsigned address = 0x2000; address < 0x2040; address += 8)
+		prefetcher->Access(0x600, address, false, addresses);
+	EXPECT_EQ(addresses.back(), 0x2080u);
+}
+
+
+// Tests that the stream prefetcher detects ascending and descending streams
+TEST(TestPrefetcher, stream)
+{
+	auto prefetcher = Prefetcher::Create(Prefetcher::TypeStream, 64, 2);
+	std::vector<unsigned> addresses;
+
+	// Ascending stream
+	prefetcher->Access(0, 0x1000, true, addresses);
+	prefetcher->Access(0, 0x1040, true, addresses);
+	EXPECT_TRUE(addresses.empty());
+	prefetcher->Access(0, 0x1080, true, addresses);
+	EXPECT_EQ(addresses, std::vector<unsigned>({ 0x10c0, 0x1100 }));
+
+	// Descending stream, far from the first one
+	addresses.clear();
+	prefetcher->Access(0, 0x8000, true, addresses);
+	prefetcher->Access(0, 0x7fc0, true, addresses);
+	EXPECT_TRUE(addresses.empty());
+	prefetcher->Access(0, 0x7f80, true, addresses);
+	EXPECT_EQ(addresses, std::vector<unsigned>({ 0x7f40, 0x7f00 }));
+}
+
+
+// Tests that the GHB prefetcher replays a repeating sequence of deltas
+TEST(TestPrefetcher, ghb)
+{
+	auto prefetcher = Prefetcher::Create(Prefetcher::TypeGhb, 64, 2);
+	std::vector<unsigned> addresses;
+
+	// Misses to blocks 0x40, 0x41, 0x43, 0x44, with deltas +1, +2, +1
+	for (unsigned block : { 0x40, 0x41, 0x43, 0x44 })
+	{
+		prefetcher->Access(0x400, block << 6, true, addresses);
+		EXPECT_TRUE(addresses.empty());
+	}
+
+	// Miss to block 0x46 completes the pattern +1, +2, which predicts
+	// blocks 0x47 and 0x49
+	prefetcher->Access(0x400, 0x46 << 6, true, addresses);
+	EXPECT_EQ(addresses, std::vector<unsigned>({ 0x47 << 6, 0x49 << 6 }));
+}
+
+
+// Tests a next-line prefetcher in an L1 cache. A miss prefetches the next
+// block, and a later load to it hits and counts the prefetch as useful.
+TEST(TestPrefetcher, module)
+{
+	try
+	{
+		// Cleanup singleton instances
+		Cleanup();
+
+		// Load configuration file
+		misc::IniFile ini_file_mem;
+		misc::IniFile ini_file_x86;
+		ini_file_mem.LoadFromString(mem_config_prefetch);
+		ini_file_x86.LoadFromString(x86_config_prefetch);
+
+		// Set up x86 timing simulator
+		x86::Timing::ParseConfiguration(&ini_file_x86);
+		x86::Timing::getInstance();
+
+		// Set up memory system
+		System *memory_system = System::getInstance();
+		memory_system->ReadConfiguration(&ini_file_mem);
+
+		// Get module
+		Module *module_l1_0 = memory_system->getModule("mod-l1-0");
+		ASSERT_NE(module_l1_0, nullptr);
+		ASSERT_NE(module_l1_0->getPrefetcher(), nullptr);
+
+		// Miss on block 0x0, prefetching block 0x100
+		int witness = -1;
+		module_l1_0->Access(Module::AccessLoad, 0x0, &witness);
+		esim::Engine *esim_engine = esim::Engine::getInstance();
+		while (witness < 0 || module_l1_0->isInFlightAddress(0x100))
+			esim_engine->ProcessEvents();
+		EXPECT_EQ(module_l1_0->getNumPrefetches(), 1);
+
+		// Check prefetched block
+		int set;
+		int way;
+		int tag;
+		Cache::BlockState state;
+		ASSERT_TRUE(module_l1_0->FindBlock(0x100, set, way, tag, state));
+		EXPECT_EQ(state, Cache::BlockExclusive);
+		EXPECT_TRUE(module_l1_0->getCache()->getBlock(set, way)->
+				isPrefetched());
+
+		// Load prefetched block
+		witness = -1;
+		bool miss = false;
+		module_l1_0->Access(Module::AccessLoad, 0x100, &witness,
+				nullptr, &miss);
+		while (witness < 0)
+			esim_engine->ProcessEvents();
+		EXPECT_FALSE(miss);
+		EXPECT_EQ(module_l1_0->getNumUsefulPrefetches(), 1);
+		EXPECT_FALSE(module_l1_0->getCache()->getBlock(set, way)->
+				isPrefetched());
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+}  // namespace mem
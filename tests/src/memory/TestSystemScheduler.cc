@@ -0,0 +1,886 @@
+/*
+ *  Multi2Sim
+ *  Copyright (C) 2015  Rafael Ubal (ubal@ece.neu.edu)
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "gtest/gtest.h"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include <arch/x86/timing/Timing.h>
+#include <arch/common/Arch.h>
+#include <lib/cpp/IniFile.h>
+#include <lib/cpp/Error.h>
+#include <lib/esim/Engine.h>
+#include <memory/System.h>
+#include <memory/Module.h>
+#include <network/System.h>
+
+namespace mem
+{
+
+// Configurations in samples/memory/example-1, example-2 and example-3
+
+const std::string sample_mem_config_1 =
+		"[CacheGeometry geo-l1]\n"
+		"Sets = 128\n"
+		"Assoc = 2\n"
+		"BlockSize = 256\n"
+		"Latency = 2\n"
+		"Policy = LRU\n"
+		"Ports = 2\n"
+		"\n"
+		"[CacheGeometry geo-l2]\n"
+		"Sets = 512\n"
+		"Assoc = 4\n"
+		"BlockSize = 256\n"
+		"Latency = 20\n"
+		"Policy = LRU\n"
+		"Ports = 4\n"
+		"\n"
+		"[Module mod-l1-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = net-l1-l2\n"
+		"LowModules = mod-l2-0 mod-l2-1\n"
+		"\n"
+		"[Module mod-l1-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = net-l1-l2\n"
+		"LowModules = mod-l2-0 mod-l2-1\n"
+		"\n"
+		"[Module mod-l1-2]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = net-l1-l2\n"
+		"LowModules = mod-l2-0 mod-l2-1\n"
+		"\n"
+		"[Module mod-l2-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l2\n"
+		"HighNetwork = net-l1-l2\n"
+		"LowNetwork = net-l2-mm\n"
+		"LowModules = mod-mm\n"
+		"AddressRange = BOUNDS 0x00000000 0x7FFFFFFF\n"
+		"\n"
+		"[Module mod-l2-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l2\n"
+		"HighNetwork = net-l1-l2\n"
+		"LowNetwork = net-l2-mm\n"
+		"LowModules = mod-mm\n"
+		"AddressRange = BOUNDS 0x80000000 0xFFFFFFFF\n"
+		"\n"
+		"[Module mod-mm]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 256\n"
+		"Latency = 200\n"
+		"HighNetwork = net-l2-mm\n"
+		"\n"
+		"[Network net-l2-mm]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"[Network net-l1-l2]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"[Entry core-0]\n"
+		"Arch = x86\n"
+		"Core = 0\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-0\n"
+		"InstModule = mod-l1-0\n"
+		"\n"
+		"[Entry core-1]\n"
+		"Arch = x86\n"
+		"Core = 1\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-1\n"
+		"InstModule = mod-l1-1\n"
+		"\n"
+		"[Entry core-2]\n"
+		"Arch = x86\n"
+		"Core = 2\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-2\n"
+		"InstModule = mod-l1-2\n";
+
+const std::string sample_mem_config_2 =
+		"[CacheGeometry geo-l1]\n"
+		"Sets = 128\n"
+		"Assoc = 2\n"
+		"BlockSize = 256\n"
+		"Latency = 2\n"
+		"Policy = LRU\n"
+		"Ports = 2\n"
+		"\n"
+		"[CacheGeometry geo-l2]\n"
+		"Sets = 512\n"
+		"Assoc = 4\n"
+		"BlockSize = 256\n"
+		"Latency = 20\n"
+		"Policy = LRU\n"
+		"Ports = 4\n"
+		"\n"
+		"[Module mod-l1-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = net0\n"
+		"LowNetworkNode = n0\n"
+		"LowModules = mod-l2-0 mod-l2-1\n"
+		"\n"
+		"[Module mod-l1-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = net0\n"
+		"LowNetworkNode = n1\n"
+		"LowModules = mod-l2-0 mod-l2-1\n"
+		"\n"
+		"[Module mod-l1-2]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l1\n"
+		"LowNetwork = net0\n"
+		"LowNetworkNode = n2\n"
+		"LowModules = mod-l2-0 mod-l2-1\n"
+		"\n"
+		"[Module mod-l2-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l2\n"
+		"HighNetwork = net0\n"
+		"HighNetworkNode = n3\n"
+		"LowNetwork = net-l2-mm\n"
+		"AddressRange = BOUNDS 0x00000000 0x7FFFFFFF\n"
+		"LowModules = mod-mm\n"
+		"\n"
+		"[Module mod-l2-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l2\n"
+		"HighNetwork = net0\n"
+		"HighNetworkNode = n4\n"
+		"LowNetwork = net-l2-mm\n"
+		"AddressRange = BOUNDS 0x80000000 0xFFFFFFFF\n"
+		"LowModules = mod-mm\n"
+		"\n"
+		"[Module mod-mm]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 256\n"
+		"Latency = 200\n"
+		"HighNetwork = net-l2-mm\n"
+		"\n"
+		"[Network net-l2-mm]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"[Entry core-0]\n"
+		"Arch = x86\n"
+		"Core = 0\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-0\n"
+		"InstModule = mod-l1-0\n"
+		"\n"
+		"[Entry core-1]\n"
+		"Arch = x86\n"
+		"Core = 1\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-1\n"
+		"InstModule = mod-l1-1\n"
+		"\n"
+		"[Entry core-2]\n"
+		"Arch = x86\n"
+		"Core = 2\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-2\n"
+		"InstModule = mod-l1-2\n";
+
+const std::string sample_net_config_2 =
+		"[Network.net0]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"; Three nodes of switch 0, connected to 3 L1s\n"
+		"\n"
+		"[Network.net0.Node.sw0]\n"
+		"Type = Switch\n"
+		"\n"
+		"[Network.net0.Node.n0]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Node.n1]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Node.n2]\n"
+		"Type = EndNode\n"
+		"\n"
+		"; 2nd switch, with 2 L2s\n"
+		"\n"
+		"[Network.net0.Node.sw1]\n"
+		"Type = Switch\n"
+		"\n"
+		"[Network.net0.Node.n3]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Node.n4]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Link.sw0-sw1]\n"
+		"Source = sw0\n"
+		"Dest = sw1\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw0-n0]\n"
+		"Source = sw0\n"
+		"Dest = n0\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw0-n1]\n"
+		"Source = sw0\n"
+		"Dest = n1\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw0-n2]\n"
+		"Source = sw0\n"
+		"Dest = n2\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw1-n3]\n"
+		"Source = sw1\n"
+		"Dest = n3\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw1-n4]\n"
+		"Source = sw1\n"
+		"Dest = n4\n"
+		"Type = Bidirectional\n";
+
+const std::string sample_mem_config_3 =
+		"[CacheGeometry geo-d-l1]\n"
+		"Sets = 128\n"
+		"Assoc = 2\n"
+		"BlockSize = 256\n"
+		"Latency = 2\n"
+		"Policy = LRU\n"
+		"Ports = 2\n"
+		"\n"
+		"[CacheGeometry geo-i-l1]\n"
+		"Sets = 128\n"
+		"Assoc = 2\n"
+		"BlockSize = 256\n"
+		"Latency = 2\n"
+		"Policy = LRU\n"
+		"Ports = 2\n"
+		"\n"
+		"[CacheGeometry geo-l2]\n"
+		"Sets = 512\n"
+		"Assoc = 4\n"
+		"BlockSize = 256\n"
+		"Latency = 20\n"
+		"Policy = LRU\n"
+		"Ports = 4\n"
+		"\n"
+		"; 4 Data caches\n"
+		"\n"
+		"[Module mod-l1-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-d-l1\n"
+		"LowNetwork = net-l1-l2-0\n"
+		"LowModules = mod-l2-0\n"
+		"\n"
+		"[Module mod-l1-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-d-l1\n"
+		"LowNetwork = net-l1-l2-0\n"
+		"LowModules = mod-l2-0\n"
+		"\n"
+		"[Module mod-l1-2]\n"
+		"Type = Cache\n"
+		"Geometry = geo-d-l1\n"
+		"LowNetwork = net-l1-l2-1\n"
+		"LowModules = mod-l2-1\n"
+		"\n"
+		"[Module mod-l1-3]\n"
+		"Type = Cache\n"
+		"Geometry = geo-d-l1\n"
+		"LowNetwork = net-l1-l2-1\n"
+		"LowModules = mod-l2-1\n"
+		"\n"
+		"; 2 I caches shares between 2 cores\n"
+		"\n"
+		"[Module mod-il1-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-i-l1\n"
+		"LowNetwork = net-l1-l2-0\n"
+		"LowModules = mod-l2-0\n"
+		"\n"
+		"[Module mod-il1-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-i-l1\n"
+		"LowNetwork = net-l1-l2-1\n"
+		"LowModules = mod-l2-1\n"
+		"\n"
+		"; Both L2s caches share the full address range\n"
+		"\n"
+		"[Module mod-l2-0]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l2\n"
+		"HighNetwork = net-l1-l2-0\n"
+		"LowNetwork = net0\n"
+		"LowNetworkNode = n0\n"
+		"LowModules = mod-mm-0 mod-mm-1 mod-mm-2 mod-mm-3\n"
+		"\n"
+		"[Module mod-l2-1]\n"
+		"Type = Cache\n"
+		"Geometry = geo-l2\n"
+		"HighNetwork = net-l1-l2-1\n"
+		"LowNetwork = net0\n"
+		"LowNetworkNode = n1\n"
+		"LowModules = mod-mm-0 mod-mm-1 mod-mm-2 mod-mm-3\n"
+		"\n"
+		"; 4 Memory banks share the entire address space\n"
+		"\n"
+		"[Module mod-mm-0]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 256\n"
+		"Latency = 200\n"
+		"HighNetwork = net0\n"
+		"HighNetworkNode = n2\n"
+		"AddressRange = ADDR DIV 256 MOD 4 EQ 0\n"
+		"\n"
+		"[Module mod-mm-1]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 256\n"
+		"Latency = 200\n"
+		"HighNetwork = net0\n"
+		"HighNetworkNode = n3\n"
+		"AddressRange = ADDR DIV 256 MOD 4 EQ 1\n"
+		"\n"
+		"[Module mod-mm-2]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 256\n"
+		"Latency = 200\n"
+		"HighNetwork = net0\n"
+		"HighNetworkNode = n4\n"
+		"AddressRange = ADDR DIV 256 MOD 4 EQ 2\n"
+		"\n"
+		"[Module mod-mm-3]\n"
+		"Type = MainMemory\n"
+		"BlockSize = 256\n"
+		"Latency = 200\n"
+		"HighNetwork = net0\n"
+		"HighNetworkNode = n5\n"
+		"AddressRange = ADDR DIV 256 MOD 4 EQ 3\n"
+		"\n"
+		"; Two networks between 2 sets of cores\n"
+		"\n"
+		"[Network net-l1-l2-0]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"[Network net-l1-l2-1]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"[Entry core-0]\n"
+		"Arch = x86\n"
+		"Core = 0\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-0\n"
+		"InstModule = mod-il1-0\n"
+		"\n"
+		"[Entry core-1]\n"
+		"Arch = x86\n"
+		"Core = 1\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-1\n"
+		"InstModule = mod-il1-0\n"
+		"\n"
+		"[Entry core-2]\n"
+		"Arch = x86\n"
+		"Core = 2\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-2\n"
+		"InstModule = mod-il1-1\n"
+		"\n"
+		"[Entry core-3]\n"
+		"Arch = x86\n"
+		"Core = 3\n"
+		"Thread = 0\n"
+		"DataModule = mod-l1-3\n"
+		"InstModule = mod-il1-1\n";
+
+const std::string sample_net_config_3 =
+		"[Network.net0]\n"
+		"DefaultInputBufferSize = 1024\n"
+		"DefaultOutputBufferSize = 1024\n"
+		"DefaultBandwidth = 256\n"
+		"\n"
+		"; 4 switches\n"
+		"[Network.net0.Node.sw0]\n"
+		"Type = Switch\n"
+		"\n"
+		"[Network.net0.Node.sw1]\n"
+		"Type = Switch\n"
+		"\n"
+		"[Network.net0.Node.sw2]\n"
+		"Type = Switch\n"
+		"\n"
+		"[Network.net0.Node.sw3]\n"
+		"Type = Switch\n"
+		"\n"
+		"; 2 L2s\n"
+		"\n"
+		"[Network.net0.Node.n0]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Node.n1]\n"
+		"Type = EndNode\n"
+		"\n"
+		"; 4 Main Memory access points\n"
+		"\n"
+		"[Network.net0.Node.n2]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Node.n3]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Node.n4]\n"
+		"Type = EndNode\n"
+		"\n"
+		"[Network.net0.Node.n5]\n"
+		"Type = EndNode\n"
+		"\n"
+		"; Making a ring with 4 switches\n"
+		"\n"
+		"[Network.net0.Link.sw0-sw1]\n"
+		"Source = sw0\n"
+		"Dest = sw1\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw1-sw2]\n"
+		"Source = sw1\n"
+		"Dest = sw2\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw2-sw3]\n"
+		"Source = sw2\n"
+		"Dest = sw3\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw3-sw0]\n"
+		"Source = sw3\n"
+		"Dest = sw0\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"; Links from Switches to Main Memory\n"
+		"\n"
+		"[Network.net0.Link.sw0-n2]\n"
+		"Source = sw0\n"
+		"Dest = n2\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw1-n3]\n"
+		"Source = sw1\n"
+		"Dest = n3\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw2-n4]\n"
+		"Source = sw2\n"
+		"Dest = n4\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw3-n5]\n"
+		"Source = sw3\n"
+		"Dest = n5\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"; Links from Switches to L2 caches\n"
+		"\n"
+		"[Network.net0.Link.sw1-n0]\n"
+		"Source = sw1\n"
+		"Dest = n0\n"
+		"Type = Bidirectional\n"
+		"\n"
+		"[Network.net0.Link.sw2-n1]\n"
+		"Source = sw2\n"
+		"Dest = n1\n"
+		"Type = Bidirectional\n";
+
+// Cleanup instances of singletons
+static void Cleanup()
+{
+	esim::Engine::Destroy();
+
+	net::System::Destroy();
+
+	System::Destroy();
+
+	x86::Timing::Destroy();
+
+	comm::ArchPool::Destroy();
+}
+
+
+// Read all lines of a file. Memory access identifiers, given as 'A-<id>',
+// are replaced by their distance to the first identifier of the run, since
+// the identifier counter is not reset between runs.
+static std::vector<std::string> ReadTrace(const std::string &path,
+		long long first_id)
+{
+	std::vector<std::string> lines;
+	std::ifstream f(path);
+	std::string line;
+	while (std::getline(f, line))
+	{
+		std::string normalized;
+		size_t pos = 0;
+		size_t next;
+		while ((next = line.find("A-", pos)) != std::string::npos)
+		{
+			size_t end = next + 2;
+			while (end < line.size() && isdigit(line[end]))
+				end++;
+			normalized += line.substr(pos, next + 2 - pos);
+			if (end > next + 2)
+				normalized += std::to_string(std::stoll(
+						line.substr(next + 2,
+						end - next - 2)) - first_id);
+			pos = end;
+		}
+		normalized += line.substr(pos);
+		lines.push_back(normalized);
+	}
+	return lines;
+}
+
+
+// Sequence of events run by the engine and of memory accesses processed by
+// each of them
+struct EventTrace
+{
+	// Time and name of every event triggered, from the engine debug
+	std::vector<std::string> events;
+
+	// Memory events with their access identifiers, from the memory debug
+	std::vector<std::string> accesses;
+};
+
+
+// Simulate a deterministic pseudo-random stream of loads and stores from the
+// given modules, with the given scheduler, and return the sequence of events
+static EventTrace RunScheduler(esim::Engine::SchedulerKind kind,
+		const std::string &mem_config,
+		const std::string &net_config,
+		int num_cores,
+		const std::vector<std::string> &module_names)
+{
+	// Cleanup singleton instances
+	Cleanup();
+	esim::Engine::setSchedulerKind(kind);
+
+	// Temporary files for the debug information
+	char esim_path[] = "/tmp/m2s.XXXXXX";
+	char mem_path[] = "/tmp/m2s.XXXXXX";
+	int esim_fd = mkstemp(esim_path);
+	int mem_fd = mkstemp(mem_path);
+	EXPECT_NE(-1, esim_fd);
+	EXPECT_NE(-1, mem_fd);
+	close(esim_fd);
+	close(mem_fd);
+	esim::Engine::setDebugPath(esim_path);
+	System::debug.setPath(mem_path);
+
+	// Load configuration files
+	misc::IniFile ini_file_mem;
+	misc::IniFile ini_file_x86;
+	misc::IniFile ini_file_net;
+	ini_file_mem.LoadFromString(mem_config);
+	ini_file_x86.LoadFromString(misc::fmt("[ General ]\n"
+			"Cores = %d\n"
+			"Threads = 1\n", num_cores));
+	ini_file_net.LoadFromString(net_config);
+
+	// Set up x86 timing simulator
+	x86::Timing::ParseConfiguration(&ini_file_x86);
+	x86::Timing::getInstance();
+
+	// Set up network system
+	net::System *network_system = net::System::getInstance();
+	network_system->ParseConfiguration(&ini_file_net);
+
+	// Set up memory system
+	System *memory_system = System::getInstance();
+	memory_system->ReadConfiguration(&ini_file_mem);
+	std::vector<Module *> modules;
+	for (auto &name : module_names)
+	{
+		Module *module = memory_system->getModule(name);
+		EXPECT_NE(nullptr, module);
+		modules.push_back(module);
+	}
+
+	// Issue accesses during 10000 cycles, to 1024 blocks spread over both
+	// halves of the address space, so that they reach every lower-level
+	// module and cause evictions and coherence traffic.
+	esim::Engine *esim_engine = esim::Engine::getInstance();
+	unsigned seed = 1;
+	int witness = 0;
+	long long first_id = -1;
+	for (int cycle = 0; cycle < 10000; cycle++)
+	{
+		seed = seed * 1103515245 + 12345;
+		unsigned value = seed >> 8;
+		Module *module = modules[value % modules.size()];
+		unsigned address = (value & 0x80000) << 12 |
+				(value >> 4 & 0x3ff) << 8 |
+				(value >> 14 & 0x1c);
+		Module::AccessType access_type = value & 0x100000 ?
+				Module::AccessStore : Module::AccessLoad;
+		if (value & 0x200000 && module->canAccess(address))
+		{
+			witness--;
+			long long id = module->Access(access_type, address,
+					&witness);
+			if (first_id < 0)
+				first_id = id;
+		}
+		esim_engine->ProcessEvents();
+	}
+
+	// Finish all accesses
+	for (int cycle = 0; witness < 0 && cycle < 100000; cycle++)
+		esim_engine->ProcessEvents();
+	EXPECT_EQ(0, witness);
+	EXPECT_EQ(kind, esim_engine->getSchedulerKind());
+
+	// Read debug information
+	esim::Engine::setDebugPath("");
+	System::debug.setPath("");
+	EventTrace trace;
+	trace.events = ReadTrace(esim_path, first_id);
+	trace.accesses = ReadTrace(mem_path, first_id);
+	unlink(esim_path);
+	unlink(mem_path);
+
+	// Restore default scheduler
+	Cleanup();
+	esim::Engine::setSchedulerKind(esim::Engine::SchedulerHeap);
+	return trace;
+}
+
+
+// Check that the timing wheel runs the same events with the same frames in
+// the same order as the event heap on a memory configuration
+static void CheckSchedulerEventOrder(const std::string &mem_config,
+		const std::string &net_config,
+		int num_cores,
+		const std::vector<std::string> &module_names)
+{
+	try
+	{
+		EventTrace heap_trace = RunScheduler(
+				esim::Engine::SchedulerHeap,
+				mem_config, net_config,
+				num_cores, module_names);
+		EventTrace wheel_trace = RunScheduler(
+				esim::Engine::SchedulerWheel,
+				mem_config, net_config,
+				num_cores, module_names);
+
+		// Check that a significant number of events ran
+		EXPECT_GT(heap_trace.events.size(), 10000u);
+		EXPECT_GT(heap_trace.accesses.size(), 10000u);
+
+		// Check identical order
+		ASSERT_EQ(heap_trace.events.size(), wheel_trace.events.size());
+		for (unsigned i = 0; i < heap_trace.events.size(); i++)
+			ASSERT_EQ(heap_trace.events[i], wheel_trace.events[i]);
+		ASSERT_EQ(heap_trace.accesses.size(),
+				wheel_trace.accesses.size());
+		for (unsigned i = 0; i < heap_trace.accesses.size(); i++)
+			ASSERT_EQ(heap_trace.accesses[i],
+					wheel_trace.accesses[i]);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+
+TEST(TestSystemScheduler, example_1_event_order)
+{
+	CheckSchedulerEventOrder(sample_mem_config_1, "", 3,
+			{ "mod-l1-0", "mod-l1-1", "mod-l1-2" });
+}
+
+
+TEST(TestSystemScheduler, example_2_event_order)
+{
+	CheckSchedulerEventOrder(sample_mem_config_2, sample_net_config_2, 3,
+			{ "mod-l1-0", "mod-l1-1", "mod-l1-2" });
+}
+
+
+TEST(TestSystemScheduler, example_3_event_order)
+{
+	CheckSchedulerEventOrder(sample_mem_config_3, sample_net_config_3, 4,
+			{ "mod-l1-0", "mod-l1-1", "mod-l1-2", "mod-l1-3",
+			"mod-il1-0", "mod-il1-1" });
+}
+
+
+
+// Number of times the event of an independent frequency domain ran
+static int independent_count;
+
+// Event handler of an independent frequency domain
+static void IndependentHandler(esim::Event *event, esim::Frame *frame)
+{
+	independent_count++;
+}
+
+
+// Simulate the same stream of accesses as RunScheduler() on the memory
+// system of samples/memory/example-2 with the given number of host threads,
+// together with an independent frequency domain, and return the memory
+// report and the cycle in which all accesses completed
+static std::string RunThreads(int num_threads, long long &cycle,
+		long long &num_parallel_windows)
+{
+	// Cleanup singleton instances
+	Cleanup();
+	esim::Engine::setNumThreads(num_threads);
+	independent_count = 0;
+
+	// Load configuration files
+	misc::IniFile ini_file_mem;
+	misc::IniFile ini_file_x86;
+	misc::IniFile ini_file_net;
+	ini_file_mem.LoadFromString(sample_mem_config_2);
+	ini_file_x86.LoadFromString("[ General ]\n"
+			"Cores = 3\n"
+			"Threads = 1\n");
+	ini_file_net.LoadFromString(sample_net_config_2);
+
+	// Set up x86 timing simulator
+	x86::Timing::ParseConfiguration(&ini_file_x86);
+	x86::Timing::getInstance();
+
+	// Set up network system
+	net::System *network_system = net::System::getInstance();
+	network_system->ParseConfiguration(&ini_file_net);
+
+	// Set up memory system
+	System *memory_system = System::getInstance();
+	memory_system->ReadConfiguration(&ini_file_mem);
+	std::vector<Module *> modules;
+	for (auto &name : { "mod-l1-0", "mod-l1-1", "mod-l1-2" })
+		modules.push_back(memory_system->getModule(name));
+
+	// The x86, memory and network domains share one partition, and an
+	// independent domain with a periodic event gets another
+	esim::Engine *esim_engine = esim::Engine::getInstance();
+	esim::FrequencyDomain *domain = esim_engine->RegisterFrequencyDomain(
+			"independent", 1000);
+	esim::Event *event = esim_engine->RegisterEvent("independent",
+			IndependentHandler, domain);
+	esim_engine->Next(event, 1, 1);
+	EXPECT_EQ(2, esim_engine->getNumPartitions());
+
+	// Issue accesses
+	unsigned seed = 1;
+	int witness = 0;
+	for (int cycle = 0; cycle < 10000; cycle++)
+	{
+		seed = seed * 1103515245 + 12345;
+		unsigned value = seed >> 8;
+		Module *module = modules[value % modules.size()];
+		unsigned address = (value & 0x80000) << 12 |
+				(value >> 4 & 0x3ff) << 8 |
+				(value >> 14 & 0x1c);
+		Module::AccessType access_type = value & 0x100000 ?
+				Module::AccessStore : Module::AccessLoad;
+		if (value & 0x200000 && module->canAccess(address))
+		{
+			witness--;
+			module->Access(access_type, address, &witness);
+		}
+		esim_engine->ProcessEvents();
+	}
+
+	// Finish all accesses
+	while (witness < 0 && esim_engine->getCycle() < 100000)
+		esim_engine->ProcessEvents();
+	EXPECT_EQ(0, witness);
+	cycle = esim_engine->getCycle();
+	num_parallel_windows = esim_engine->getNumParallelWindows();
+	EXPECT_EQ(cycle - 2, independent_count);
+
+	// Memory report
+	std::ostringstream report;
+	memory_system->DumpReport(report);
+
+	// Restore sequential engine
+	Cleanup();
+	esim::Engine::setNumThreads(1);
+	return report.str();
+}
+
+
+// Tests that the parallel engine runs a real memory and network system with
+// more than one thread, keeping the domains that interact within a cycle in
+// one partition, with results identical to a single thread
+TEST(TestSystemScheduler, example_2_parallel_engine)
+{
+	try
+	{
+		long long sequential_cycle;
+		long long parallel_cycle;
+		long long sequential_windows;
+		long long parallel_windows;
+		std::string sequential_report = RunThreads(1,
+				sequential_cycle, sequential_windows);
+		std::string parallel_report = RunThreads(2,
+				parallel_cycle, parallel_windows);
+
+		// Memory events ran in parallel with the independent domain
+		EXPECT_EQ(0, sequential_windows);
+		EXPECT_GT(parallel_windows, 1000);
+
+		// Identical results
+		EXPECT_EQ(sequential_cycle, parallel_cycle);
+		EXPECT_EQ(sequential_report, parallel_report);
+	}
+	catch (misc::Exception &e)
+	{
+		e.Dump();
+		FAIL();
+	}
+}
+
+}  // namespace mem